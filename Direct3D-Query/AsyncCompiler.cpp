@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "AsyncCompiler.h"
+
+namespace Query {
+	namespace Pipelines
+	{
+		namespace
+		{
+			typedef chrono::steady_clock Clock;
+
+			double MillisecondsSince(Clock::time_point start)
+			{
+				return chrono::duration<double, milli>(Clock::now() - start).count();
+			}
+
+			// Frames before the running average is trusted; the first frames include startup work.
+			const uint32_t WarmupFrames = 8;
+		}
+
+		AsyncCompiler::~AsyncCompiler()
+		{
+			// Queued jobs point back at this object.
+			WaitIdle();
+		}
+
+		void AsyncCompiler::Initialize(Threading::ThreadPool* pool, IPipelineFactory* factory, double spikeFactor)
+		{
+			m_pool = pool;
+			m_factory = factory;
+			m_spikeFactor = spikeFactor;
+		}
+
+		AsyncCompiler::Job& AsyncCompiler::RequestLocked(uint64_t key)
+		{
+			Job& job = m_jobs[key];
+			if (!job.future.valid())
+			{
+				m_stats.requested++;
+				m_inFlight++;
+				m_frameHadCompileWork = true;
+				job.future = m_pool->Submit([this, key]() { return Compile(key); }).share();
+			}
+			return job;
+		}
+
+		PipelineHandle AsyncCompiler::Compile(uint64_t key)
+		{
+			Clock::time_point start = Clock::now();
+			PipelineHandle pipeline;
+			try
+			{
+				pipeline = m_factory->Create(key);
+			}
+			catch (...)
+			{
+				// The job still has to finish, or Wait and WaitIdle would wait for it forever.
+				pipeline = nullptr;
+			}
+			double elapsed = MillisecondsSince(start);
+
+			lock_guard<mutex> lock(m_mutex);
+			Job& job = m_jobs[key];
+			job.pipeline = pipeline;
+			job.done = true;
+
+			pipeline ? m_stats.compiled++ : m_stats.failed++;
+			m_stats.totalCompileMilliseconds += elapsed;
+			if (elapsed > m_stats.maxCompileMilliseconds)
+			{
+				m_stats.maxCompileMilliseconds = elapsed;
+			}
+			m_inFlight--;
+			m_frameHadCompileWork = true;
+			return pipeline;
+		}
+
+		shared_future<PipelineHandle> AsyncCompiler::Request(uint64_t key)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			return RequestLocked(key).future;
+		}
+
+		void AsyncCompiler::SetFallback(uint64_t key, PipelineHandle fallback)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_jobs[key].fallback = move(fallback);
+		}
+
+		PipelineHandle AsyncCompiler::Resolve(uint64_t key)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			Job& job = RequestLocked(key);
+			if (job.pipeline)
+			{
+				return job.pipeline;
+			}
+			// A failed compilation keeps answering with the fallback.
+			job.fallback ? m_stats.fallbackResolves++ : m_stats.missingResolves++;
+			return job.fallback;
+		}
+
+		PipelineHandle AsyncCompiler::Wait(uint64_t key)
+		{
+			shared_future<PipelineHandle> future = Request(key);
+
+			Clock::time_point start = Clock::now();
+			future.wait();
+			double elapsed = MillisecondsSince(start);
+
+			lock_guard<mutex> lock(m_mutex);
+			m_stats.blockingMilliseconds += elapsed;
+			m_frameHadCompileWork = true;
+			return future.get();
+		}
+
+		bool AsyncCompiler::IsReady(uint64_t key) const
+		{
+			lock_guard<mutex> lock(m_mutex);
+			auto job = m_jobs.find(key);
+			return job != m_jobs.end() && job->second.done;
+		}
+
+		void AsyncCompiler::WaitIdle()
+		{
+			vector<shared_future<PipelineHandle>> pending;
+			{
+				lock_guard<mutex> lock(m_mutex);
+				for (auto& job : m_jobs)
+				{
+					if (job.second.future.valid() && !job.second.done)
+					{
+						pending.push_back(job.second.future);
+					}
+				}
+			}
+			for (auto& future : pending)
+			{
+				future.wait();
+			}
+		}
+
+		bool AsyncCompiler::RecordFrame(double frameMilliseconds)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			Stats& stats = m_stats;
+			stats.frames++;
+
+			bool spike = stats.frames > WarmupFrames && frameMilliseconds > stats.averageFrameMilliseconds * m_spikeFactor;
+			if (spike)
+			{
+				stats.spikes++;
+				if (m_frameHadCompileWork)
+				{
+					stats.spikesDuringCompiles++;
+				}
+			}
+			else
+			{
+				// Spikes stay out of the average so that one long frame does not hide the next.
+				const double weight = stats.frames <= WarmupFrames ? 1.0 / stats.frames : 1.0 / 16;
+				stats.averageFrameMilliseconds += (frameMilliseconds - stats.averageFrameMilliseconds) * weight;
+			}
+
+			m_frameHadCompileWork = m_inFlight != 0;
+			return spike;
+		}
+
+		AsyncCompiler::Stats AsyncCompiler::GetStats() const
+		{
+			lock_guard<mutex> lock(m_mutex);
+			return m_stats;
+		}
+	}
+}
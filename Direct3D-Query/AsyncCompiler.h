@@ -0,0 +1,91 @@
+#pragma once
+#include "ThreadPool.h"
+
+namespace Query {
+	namespace Pipelines
+	{
+		// A compiled pipeline as seen by the scheduler. The factory decides what it points to and
+		// how it is released, which keeps the scheduling independent of D3D12.
+		typedef shared_ptr<void> PipelineHandle;
+
+		class IPipelineFactory
+		{
+		public:
+			virtual ~IPipelineFactory() {}
+			// Called on a worker thread, possibly for several keys at once. Returns null on failure;
+			// an exception counts as a failure too.
+			virtual PipelineHandle Create(uint64_t key) = 0;
+		};
+
+		// Compiles pipelines on a thread pool so that the render thread never waits for the driver.
+		// Each key is compiled once. Until it is ready, Resolve hands out the fallback registered for
+		// the key, or null, in which case the caller has to skip the draw.
+		class AsyncCompiler
+		{
+		public:
+			struct Stats
+			{
+				uint32_t requested = 0;
+				uint32_t compiled = 0;
+				uint32_t failed = 0;
+				uint32_t fallbackResolves = 0;	//Resolve returned the fallback
+				uint32_t missingResolves = 0;	//Resolve returned null
+				double totalCompileMilliseconds = 0;
+				double maxCompileMilliseconds = 0;
+				double blockingMilliseconds = 0;	//render thread time spent in Wait
+
+				uint32_t frames = 0;
+				uint32_t spikes = 0;
+				uint32_t spikesDuringCompiles = 0;	//spikes in frames that compiled or waited for a pipeline
+				double averageFrameMilliseconds = 0;
+			};
+
+		private:
+			struct Job
+			{
+				shared_future<PipelineHandle> future;
+				PipelineHandle pipeline;
+				PipelineHandle fallback;
+				bool done = false;
+			};
+
+			Threading::ThreadPool* m_pool = nullptr;
+			IPipelineFactory* m_factory = nullptr;
+			unordered_map<uint64_t, Job> m_jobs;
+			mutable mutex m_mutex;
+
+			Stats m_stats;
+			double m_spikeFactor = 2.0;
+			uint32_t m_inFlight = 0;
+			bool m_frameHadCompileWork = false;
+
+		private:
+			Job& RequestLocked(uint64_t key);
+			PipelineHandle Compile(uint64_t key);
+
+		public:
+			~AsyncCompiler();
+
+			// A frame counts as a spike when it takes spikeFactor times the running average.
+			void Initialize(Threading::ThreadPool* pool, IPipelineFactory* factory, double spikeFactor = 2.0);
+
+			// Queues the compilation unless the key was requested before.
+			shared_future<PipelineHandle> Request(uint64_t key);
+			void SetFallback(uint64_t key, PipelineHandle fallback);
+
+			// Never blocks: the compiled pipeline, else the fallback, else null.
+			PipelineHandle Resolve(uint64_t key);
+			// Blocks until the pipeline is compiled. Must not be called from a pool worker.
+			PipelineHandle Wait(uint64_t key);
+			bool IsReady(uint64_t key) const;
+
+			// Blocks until every requested pipeline is compiled.
+			void WaitIdle();
+
+			// Feeds the CPU time of the last frame into the spike tracking; returns true for a spike.
+			bool RecordFrame(double frameMilliseconds);
+
+			Stats GetStats() const;
+		};
+	}
+}
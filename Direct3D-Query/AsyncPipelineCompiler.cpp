@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "AsyncPipelineCompiler.h"
+
+namespace Query {
+	namespace Pipelines
+	{
+		void AsyncPipelineCompiler::Initialize(Threading::ThreadPool* pool, PipelineCache* cache)
+		{
+			m_cache = cache;
+			m_compiler.Initialize(pool, this);
+		}
+
+		unique_ptr<AsyncPipelineCompiler::OwnedDesc> AsyncPipelineCompiler::Copy(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey)
+		{
+			unique_ptr<OwnedDesc> owned(new OwnedDesc());
+			owned->desc = desc;
+			owned->desc.CachedPSO = {};
+			owned->rootSignature = desc.pRootSignature;
+			owned->rootSignatureKey = rootSignatureKey;
+			PipelineKey::Canonicalize(desc, rootSignatureKey, owned->canonical);
+
+			D3D12_SHADER_BYTECODE* stages[] = { &owned->desc.VS, &owned->desc.PS, &owned->desc.DS, &owned->desc.HS, &owned->desc.GS };
+			for (UINT i = 0; i < _countof(stages); i++)
+			{
+				auto bytes = static_cast<const uint8_t*>(stages[i]->pShaderBytecode);
+				owned->shaders[i].assign(bytes, bytes + (bytes ? stages[i]->BytecodeLength : 0));
+				*stages[i] = { owned->shaders[i].data(), owned->shaders[i].size() };
+			}
+
+			// Names are copied first, the element arrays only point at them once no reallocation can happen.
+			const D3D12_INPUT_LAYOUT_DESC& layout = desc.InputLayout;
+			const D3D12_STREAM_OUTPUT_DESC& so = desc.StreamOutput;
+			owned->semanticNames.reserve(layout.NumElements + so.NumEntries);
+			owned->inputElements.assign(layout.pInputElementDescs, layout.pInputElementDescs + layout.NumElements);
+			for (auto& element : owned->inputElements)
+			{
+				owned->semanticNames.push_back(element.SemanticName);
+				element.SemanticName = owned->semanticNames.back().c_str();
+			}
+			owned->desc.InputLayout = { owned->inputElements.data(), layout.NumElements };
+
+			owned->streamOutEntries.assign(so.pSODeclaration, so.pSODeclaration + so.NumEntries);
+			for (auto& entry : owned->streamOutEntries)
+			{
+				owned->semanticNames.push_back(entry.SemanticName ? entry.SemanticName : "");
+				entry.SemanticName = entry.SemanticName ? owned->semanticNames.back().c_str() : nullptr;
+			}
+			owned->streamOutStrides.assign(so.pBufferStrides, so.pBufferStrides + so.NumStrides);
+			owned->desc.StreamOutput.pSODeclaration = owned->streamOutEntries.data();
+			owned->desc.StreamOutput.pBufferStrides = owned->streamOutStrides.data();
+			return owned;
+		}
+
+		PipelineHandle AsyncPipelineCompiler::Wrap(ID3D12PipelineState* pipeline)
+		{
+			if (!pipeline)
+			{
+				return nullptr;
+			}
+			pipeline->AddRef();
+			return PipelineHandle(pipeline, [](void* p) { static_cast<ID3D12PipelineState*>(p)->Release(); });
+		}
+
+		uint64_t AsyncPipelineCompiler::Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey)
+		{
+			unique_ptr<OwnedDesc> owned = Copy(desc, rootSignatureKey);
+			uint64_t key = PipelineKey::Hash(owned->canonical);
+			{
+				lock_guard<mutex> lock(m_mutex);
+				// Keys only have to be unique within this compiler, so a hash collision moves to the next free key.
+				for (;; key++)
+				{
+					auto existing = m_descs.find(key);
+					if (existing == m_descs.end())
+					{
+						m_descs.emplace(key, move(owned));
+						break;
+					}
+					if (existing->second->canonical == owned->canonical)
+					{
+						break;
+					}
+				}
+			}
+			m_compiler.Request(key);
+			return key;
+		}
+
+		void AsyncPipelineCompiler::SetFallback(uint64_t key, ID3D12PipelineState* fallback)
+		{
+			m_compiler.SetFallback(key, Wrap(fallback));
+		}
+
+		ID3D12PipelineState* AsyncPipelineCompiler::Resolve(uint64_t key)
+		{
+			// The compiler keeps its own reference, so the raw pointer outlives the handle.
+			return static_cast<ID3D12PipelineState*>(m_compiler.Resolve(key).get());
+		}
+
+		ID3D12PipelineState* AsyncPipelineCompiler::Wait(uint64_t key)
+		{
+			return static_cast<ID3D12PipelineState*>(m_compiler.Wait(key).get());
+		}
+
+		PipelineHandle AsyncPipelineCompiler::Create(uint64_t key)
+		{
+			OwnedDesc* owned;
+			{
+				lock_guard<mutex> lock(m_mutex);
+				auto existing = m_descs.find(key);
+				if (existing == m_descs.end())
+				{
+					return nullptr;
+				}
+				owned = existing->second.get();
+			}
+
+			ComPtr<ID3D12PipelineState> pipeline;
+			if (FAILED(m_cache->GetGraphicsPipeline(owned->desc, owned->rootSignatureKey, &pipeline)))
+			{
+				return nullptr;
+			}
+			return Wrap(pipeline.Get());
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "AsyncCompiler.h"
+#include "PipelineCache.h"
+
+namespace Query {
+	namespace Pipelines
+	{
+		using Microsoft::WRL::ComPtr;
+
+		// Creates graphics pipelines through a PipelineCache on worker threads. Descriptions are
+		// deep-copied on Request, so shader bytecode and input layouts may go away right after it.
+		class AsyncPipelineCompiler : private IPipelineFactory
+		{
+		private:
+			struct OwnedDesc
+			{
+				D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+				ComPtr<ID3D12RootSignature> rootSignature;
+				uint64_t rootSignatureKey;
+				vector<uint8_t> canonical;
+				vector<uint8_t> shaders[5];
+				vector<string> semanticNames;
+				vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+				vector<D3D12_SO_DECLARATION_ENTRY> streamOutEntries;
+				vector<UINT> streamOutStrides;
+			};
+
+			PipelineCache* m_cache = nullptr;
+			unordered_map<uint64_t, unique_ptr<OwnedDesc>> m_descs;
+			mutex m_mutex;
+			AsyncCompiler m_compiler;	//declared last, so pending jobs finish before m_descs goes away
+
+		private:
+			static unique_ptr<OwnedDesc> Copy(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey);
+			static PipelineHandle Wrap(ID3D12PipelineState* pipeline);
+
+			PipelineHandle Create(uint64_t key) override;
+
+		public:
+			void Initialize(Threading::ThreadPool* pool, PipelineCache* cache);
+
+			// Starts compiling the pipeline and returns the key to resolve it with.
+			uint64_t Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey);
+			void SetFallback(uint64_t key, ID3D12PipelineState* fallback);
+
+			// The compiled pipeline, else the fallback, else null. Never blocks.
+			ID3D12PipelineState* Resolve(uint64_t key);
+			ID3D12PipelineState* Wait(uint64_t key);
+			bool IsReady(uint64_t key) const { return m_compiler.IsReady(key); }
+
+			void WaitIdle() { m_compiler.WaitIdle(); }
+			bool RecordFrame(double frameMilliseconds) { return m_compiler.RecordFrame(frameMilliseconds); }
+			AsyncCompiler::Stats GetStats() const { return m_compiler.GetStats(); }
+		};
+	}
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include "RenderGraph.h"
+
+namespace Query {
+	namespace Backend
+	{
+		using Rendering::ResourceState;
+
+		// API-neutral rendering interfaces. The frame logic records through these, so it runs the same
+		// on D3D12 and on the headless null backend. Calls mirror D3D12 closely; anything a backend
+		// needs beyond them (descriptors, root signatures, heaps) stays inside its implementation.
+
+		enum class HeapKind : uint8_t
+		{
+			Default,
+			Upload,
+			Readback
+		};
+
+		enum class ResourceKind : uint8_t
+		{
+			Buffer,
+			RenderTarget,
+			DepthStencil
+		};
+
+		enum class Format : uint8_t
+		{
+			Unknown,
+			R8G8B8A8Unorm,
+			D32Float
+		};
+
+		struct ResourceDesc
+		{
+			ResourceKind kind = ResourceKind::Buffer;
+			HeapKind heap = HeapKind::Default;
+			uint64_t size = 0;	//buffers
+			uint32_t width = 0, height = 0;	//render targets and depth stencils
+			Format format = Format::Unknown;
+
+			static ResourceDesc Buffer(uint64_t size, HeapKind heap = HeapKind::Default)
+			{
+				ResourceDesc desc;
+				desc.size = size;
+				desc.heap = heap;
+				return desc;
+			}
+
+			static ResourceDesc Texture(ResourceKind kind, uint32_t width, uint32_t height, Format format)
+			{
+				ResourceDesc desc;
+				desc.kind = kind;
+				desc.width = width;
+				desc.height = height;
+				desc.format = format;
+				return desc;
+			}
+		};
+
+		enum class QueryType : uint8_t
+		{
+			Occlusion,
+			BinaryOcclusion
+		};
+
+		class IResource
+		{
+		public:
+			virtual ~IResource() {}
+			virtual const ResourceDesc& GetDesc() const = 0;
+			// Upload and readback buffers only. The pointer stays valid until Unmap.
+			virtual void* Map() = 0;
+			virtual void Unmap() = 0;
+		};
+
+		// Created by each backend from its own description type; the frame logic only binds them.
+		class IPipeline
+		{
+		public:
+			virtual ~IPipeline() {}
+		};
+
+		class IFence
+		{
+		public:
+			virtual ~IFence() {}
+			virtual uint64_t GetCompletedValue() const = 0;
+			// Blocks until the fence reaches value.
+			virtual void Wait(uint64_t value) = 0;
+		};
+
+		class IQueryHeap
+		{
+		public:
+			virtual ~IQueryHeap() {}
+			virtual QueryType GetType() const = 0;
+			virtual uint32_t GetCount() const = 0;
+		};
+
+		class ICommandList
+		{
+		public:
+			struct Transition
+			{
+				IResource* resource;
+				ResourceState before;
+				ResourceState after;
+			};
+
+			virtual ~ICommandList() {}
+
+			// Each frame in flight records into its own command memory.
+			virtual void Reset(uint32_t frame) = 0;
+			virtual void Close() = 0;
+
+			// Pass boundaries of a render graph step, for backends that attach work to them.
+			virtual void BeginPass(uint32_t step, const char* name) = 0;
+			virtual void EndPass(uint32_t step) = 0;
+
+			virtual void Barriers(const Transition* transitions, uint32_t count) = 0;
+
+			virtual void ClearRenderTarget(IResource* target, const float color[4]) = 0;
+			virtual void ClearDepth(IResource* target, float depth) = 0;
+			virtual void SetRenderTargets(IResource* color, IResource* depth) = 0;
+			virtual void SetViewport(uint32_t width, uint32_t height) = 0;
+
+			virtual void SetPipeline(IPipeline* pipeline) = 0;
+			virtual void SetVertexBuffer(IResource* buffer, uint32_t stride, uint32_t size) = 0;
+			virtual void SetConstantBuffer(uint32_t slot, IResource* buffer, uint64_t offset) = 0;
+			// Triangle strips, the only topology the frame logic draws.
+			virtual void Draw(uint32_t vertexCount, uint32_t firstVertex) = 0;
+
+			virtual void BeginQuery(IQueryHeap* heap, uint32_t index) = 0;
+			virtual void EndQuery(IQueryHeap* heap, uint32_t index) = 0;
+			virtual void ResolveQuery(IQueryHeap* heap, uint32_t index, uint32_t count, IResource* destination, uint64_t offset) = 0;
+			// Following draws are skipped while the 64-bit value at offset is zero. Null disables predication.
+			virtual void SetPredication(IResource* buffer, uint64_t offset) = 0;
+
+			virtual void CopyBuffer(IResource* destination, uint64_t destinationOffset, IResource* source, uint64_t sourceOffset, uint64_t size) = 0;
+		};
+
+		class IQueue
+		{
+		public:
+			virtual ~IQueue() {}
+			virtual void Submit(ICommandList* commandList) = 0;
+			virtual void Signal(IFence* fence, uint64_t value) = 0;
+		};
+
+		class ISwapChain
+		{
+		public:
+			virtual ~ISwapChain() {}
+			virtual uint32_t GetBufferCount() const = 0;
+			virtual uint32_t GetCurrentIndex() const = 0;
+			virtual IResource* GetBuffer(uint32_t index) = 0;
+			virtual void Present() = 0;
+		};
+
+		class IDevice
+		{
+		public:
+			virtual ~IDevice() {}
+
+			// Null when the resource cannot be created.
+			virtual unique_ptr<IResource> CreateResource(const ResourceDesc& desc, ResourceState initialState) = 0;
+			// A render target or depth stencil used only by render graph steps [firstStep, lastStep].
+			// Backends may share its memory with transients of disjoint lifetimes; it becomes usable
+			// after CompileTransients.
+			virtual unique_ptr<IResource> CreateTransient(const ResourceDesc& desc, ResourceState initialState, uint32_t firstStep, uint32_t lastStep) = 0;
+			virtual void CompileTransients() = 0;
+
+			virtual unique_ptr<IFence> CreateFence(uint64_t initialValue) = 0;
+			virtual unique_ptr<IQueryHeap> CreateQueryHeap(QueryType type, uint32_t count) = 0;
+			virtual unique_ptr<ICommandList> CreateCommandList(uint32_t frameCount) = 0;
+			virtual IQueue* GetQueue() = 0;
+		};
+	}
+}
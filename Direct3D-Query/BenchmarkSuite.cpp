@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "BenchmarkSuite.h"
+#include "BoundingVolumeHierarchyBenchmark.h"
+#include "DepthPyramidBenchmark.h"
+#include "DepthReprojectionBenchmark.h"
+#include "HeadlessRunner.h"
+#include "MeshletsBenchmark.h"
+#include "OccluderSelectionBenchmark.h"
+#include "OccluderSimplifierBenchmark.h"
+#include "QueryResolutionBenchmark.h"
+#include "SceneBenchmark.h"
+#include "SceneStoreBenchmark.h"
+#include "MappedFile.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		namespace
+		{
+			void Write(const wstring& file, const string& json, const function<void(const wstring&, const string&)>& written)
+			{
+				IO::MappedFile::WriteAtomically(file, json.data(), json.size());
+				written(file, json);
+			}
+		}
+
+		void RunAll(const function<void(const wstring& file, const string& json)>& written)
+		{
+			Options options;
+			vector<Result> results = RunScaling(1000000, SceneDesc(), options);
+			options.backend = BackendKind::Software;
+			vector<Result> software = RunScaling(10000, SceneDesc(), options);
+			results.insert(results.end(), software.begin(), software.end());
+			Write(L"SceneBenchmark.json", ToJson(results), written);
+
+			// Writing an instance buffer (16 bytes) or constant buffer slots (256 bytes), on one
+			// thread and on the pool; then scheduled by visibility, with objects hidden for 4 frames
+			// asleep and caught up every 8, the second time with nine in ten reported occluded.
+			vector<UpdateResult> updates;
+			for (uint32_t stride : { 16u, 256u })
+			{
+				for (bool parallel : { false, true })
+				{
+					UpdateOptions updateOptions;
+					updateOptions.stride = stride;
+					updateOptions.parallel = parallel;
+					updates.push_back(RunUpdate(updateOptions));
+				}
+			}
+			for (float occluded : { 0.0f, 0.9f })
+			{
+				UpdateOptions updateOptions;
+				updateOptions.stride = 256;
+				updateOptions.hiddenFrames = 4;
+				updateOptions.occluded = occluded;
+				updates.push_back(RunUpdate(updateOptions));
+			}
+			Write(L"SceneUpdateBenchmark.json", ToJson(updates), written);
+
+			Write(L"HierarchyBenchmark.json", ToJson(vector<HierarchyResult>{ RunHierarchy(HierarchyOptions()) }), written);
+			Write(L"DepthPyramidBenchmark.json", ToJson(vector<PyramidResult>{ RunPyramid(PyramidOptions()) }), written);
+			Write(L"DepthReprojectionBenchmark.json", ToJson(vector<ReprojectionResult>{ RunReprojection(ReprojectionOptions()) }), written);
+			Write(L"QueryResolutionBenchmark.json", ToJson(RunQueryResolution(QueryResolutionOptions())), written);
+
+			// The default budget, without fusing, and without a budget, which selects every occluder.
+			vector<OccluderSelectionResult> selections;
+			OccluderSelectionOptions selectionOptions;
+			selections.push_back(RunOccluderSelection(selectionOptions));
+			selectionOptions.settings.fuseArea = 0;
+			selections.push_back(RunOccluderSelection(selectionOptions));
+			selectionOptions.settings = Culling::OccluderSelector::Settings();
+			selectionOptions.settings.maxOccluders = ~0u;
+			selectionOptions.settings.maxTriangles = ~0u;
+			selections.push_back(RunOccluderSelection(selectionOptions));
+			Write(L"OccluderSelectionBenchmark.json", ToJson(selections), written);
+
+			vector<OccluderSimplificationResult> simplifications;
+			for (uint32_t resolution : { 32u, 64u, 128u })
+			{
+				OccluderSimplificationOptions simplificationOptions;
+				simplificationOptions.settings.resolution = resolution;
+				simplifications.push_back(RunOccluderSimplification(simplificationOptions));
+			}
+			Write(L"OccluderSimplificationBenchmark.json", ToJson(simplifications), written);
+
+			// The default meshlet size, without occluders, and meshlets of 128 vertices and 252 triangles.
+			vector<MeshletResult> meshlets;
+			MeshletOptions meshletOptions;
+			meshlets.push_back(RunMeshlets(meshletOptions));
+			meshletOptions.occluders = 0;
+			meshlets.push_back(RunMeshlets(meshletOptions));
+			meshletOptions = MeshletOptions();
+			meshletOptions.maxVertices = 128;
+			meshletOptions.maxTriangles = 252;
+			meshlets.push_back(RunMeshlets(meshletOptions));
+			Write(L"MeshletBenchmark.json", ToJson(meshlets), written);
+
+			// The sample's own frame loop, as the --headless and --software flags run it.
+			vector<Headless::RunResult> runs;
+			runs.push_back(Headless::Run(100000));
+			runs.push_back(Headless::RunSoftware(300, 1280, 720));
+			runs.push_back(Headless::RunSoftware(60, 3840, 2160));
+			// The null run captured, as --capture does, and replayed on both backends. Fewer frames than
+			// --capture, since the software replay rasterizes every one of them at 720p.
+			runs.push_back(Headless::RunCaptured(L"Query.trace", 1000));
+			runs.push_back(Headless::Replay(L"Query.trace", false));
+			runs.push_back(Headless::Replay(L"Query.trace", true));
+			Write(L"HeadlessBenchmark.json", Headless::ToJson(runs), written);
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+namespace Query {
+	namespace Benchmark
+	{
+		// Everything the --benchmark flag of the sample measures, each benchmark written to its own
+		// JSON file in the working directory as soon as it is done:
+		//  - SceneBenchmark.json: scenes of 10 to 1M objects on the null backend, up to 10k on the
+		//    software backend, CPU time of each step of the frame
+		//  - SceneUpdateBenchmark.json: SceneStore updates of 1M objects, with and without a schedule
+		//  - HierarchyBenchmark.json, DepthPyramidBenchmark.json, DepthReprojectionBenchmark.json,
+		//    QueryResolutionBenchmark.json, OccluderSelectionBenchmark.json,
+		//    OccluderSimplificationBenchmark.json, MeshletBenchmark.json
+		//  - HeadlessBenchmark.json: the sample's frame loop on the null backend, and on the software
+		//    backend at 720p and 4K; then the null run captured into Query.trace and replayed on both
+		// written is called with each file name and its contents, for the caller to show progress.
+		void RunAll(const function<void(const wstring& file, const string& json)>& written);
+	}
+}
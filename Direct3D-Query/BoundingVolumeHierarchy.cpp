@@ -0,0 +1,329 @@
+#include "pch.h"
+#include "BoundingVolumeHierarchy.h"
+
+namespace Query {
+	namespace Culling
+	{
+		namespace
+		{
+			typedef BoundingVolumeHierarchy Hierarchy;
+
+			struct BuildTask
+			{
+				uint32_t node, slot;
+				uint32_t begin, end;
+				uint32_t depth;
+			};
+
+			// What the build reads of an object, moved along with it when a range is split, so that
+			// every level of the build scans memory in order.
+			struct BuildObject
+			{
+				Bounds bounds;
+				float centroid[3];	//twice the center
+				uint32_t object;
+			};
+
+			struct Bin
+			{
+				Bounds bounds = Bounds::Empty();
+				uint32_t count = 0;
+			};
+
+			// Reorders objects[begin, end) and returns where the second child starts.
+			uint32_t Split(BuildObject* objects, uint32_t begin, uint32_t end, uint32_t depth)
+			{
+				float centroidMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, centroidMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				for (uint32_t i = begin; i < end; i++)
+				{
+					const float* centroid = objects[i].centroid;
+					for (int axis = 0; axis < 3; axis++)
+					{
+						centroidMin[axis] = centroid[axis] < centroidMin[axis] ? centroid[axis] : centroidMin[axis];
+						centroidMax[axis] = centroid[axis] > centroidMax[axis] ? centroid[axis] : centroidMax[axis];
+					}
+				}
+				int widest = 0;
+				for (int axis = 1; axis < 3; axis++)
+				{
+					widest = centroidMax[axis] - centroidMin[axis] > centroidMax[widest] - centroidMin[widest] ? axis : widest;
+				}
+
+				// Deep in the tree, or when every centroid is the same, halve the range instead, which
+				// bounds the depth (and so the traversal stack) whatever the objects look like.
+				if (depth >= Hierarchy::MaxDepth / 2 || !(centroidMax[widest] > centroidMin[widest]))
+				{
+					const uint32_t middle = begin + (end - begin) / 2;
+					nth_element(objects + begin, objects + middle, objects + end, [widest](const BuildObject& a, const BuildObject& b)
+					{
+						return a.centroid[widest] < b.centroid[widest];
+					});
+					return middle;
+				}
+
+				float scale[3];
+				for (int axis = 0; axis < 3; axis++)
+				{
+					const float extent = centroidMax[axis] - centroidMin[axis];
+					scale[axis] = extent > 0 ? Hierarchy::BinCount / extent : 0;
+				}
+				auto binOf = [&](const float* centroid, int axis)
+				{
+					const uint32_t bin = static_cast<uint32_t>((centroid[axis] - centroidMin[axis]) * scale[axis]);
+					return bin < Hierarchy::BinCount ? bin : Hierarchy::BinCount - 1;
+				};
+
+				Bin bins[3][Hierarchy::BinCount];
+				for (uint32_t i = begin; i < end; i++)
+				{
+					const BuildObject& object = objects[i];
+					for (int axis = 0; axis < 3; axis++)
+					{
+						Bin& bin = bins[axis][binOf(object.centroid, axis)];
+						bin.bounds.Grow(object.bounds);
+						bin.count++;
+					}
+				}
+
+				// The split after bin b puts bins [0, b] on the left; its cost is each side's area times its objects.
+				float bestCost = FLT_MAX;
+				int bestAxis = widest;
+				uint32_t bestBin = Hierarchy::BinCount / 2 - 1;
+				for (int axis = 0; axis < 3; axis++)
+				{
+					if (scale[axis] <= 0)
+					{
+						continue;
+					}
+					float rightArea[Hierarchy::BinCount];
+					uint32_t rightCount[Hierarchy::BinCount];
+					Bounds right = Bounds::Empty();
+					uint32_t count = 0;
+					for (uint32_t b = Hierarchy::BinCount - 1; b > 0; b--)
+					{
+						right.Grow(bins[axis][b].bounds);
+						count += bins[axis][b].count;
+						rightArea[b] = right.HalfArea();
+						rightCount[b] = count;
+					}
+					Bounds left = Bounds::Empty();
+					count = 0;
+					for (uint32_t b = 0; b + 1 < Hierarchy::BinCount; b++)
+					{
+						left.Grow(bins[axis][b].bounds);
+						count += bins[axis][b].count;
+						if (!count || !rightCount[b + 1])
+						{
+							continue;
+						}
+						const float cost = left.HalfArea() * count + rightArea[b + 1] * rightCount[b + 1];
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							bestAxis = axis;
+							bestBin = b;
+						}
+					}
+				}
+
+				return static_cast<uint32_t>(partition(objects + begin, objects + end, [&](const BuildObject& object)
+				{
+					return binOf(object.centroid, bestAxis) <= bestBin;
+				}) - objects);
+			}
+		}
+
+		static_assert(sizeof(BoundingVolumeHierarchy::Node) == 64, "a node must fill one cache line");
+
+		void BoundingVolumeHierarchy::Build(const Bounds* bounds, uint32_t count)
+		{
+			m_objects.resize(count);
+			m_leafBounds.resize(count);
+			m_nodeCount = 0;
+			m_buildCost = m_cost = 0;
+			if (!count)
+			{
+				return;
+			}
+
+			vector<BuildObject> objects(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				BuildObject& object = objects[i];
+				object.bounds = bounds[i];
+				for (int axis = 0; axis < 3; axis++)
+				{
+					object.centroid[axis] = bounds[i].min[axis] + bounds[i].max[axis];
+				}
+				object.object = i;
+			}
+
+			// Every inner node splits its objects in two, so there are fewer inner nodes than objects.
+			const uint32_t capacity = count > 1 ? count - 1 : 1;
+			m_nodeMemory.reset(new uint8_t[static_cast<size_t>(capacity) * sizeof(Node) + 63]);
+			m_nodes = reinterpret_cast<Node*>((reinterpret_cast<uintptr_t>(m_nodeMemory.get()) + 63) & ~static_cast<uintptr_t>(63));
+			memset(m_nodes, 0, sizeof(Node));
+			m_nodeCount = 1;
+
+			vector<BuildTask> tasks;
+			if (count <= MaxLeafSize)
+			{
+				m_nodes[0].count[0] = count;
+			}
+			else
+			{
+				const uint32_t middle = Split(objects.data(), 0, count, 0);
+				tasks.push_back({ 0, 1, middle, count, 1 });
+				tasks.push_back({ 0, 0, 0, middle, 1 });
+			}
+			while (!tasks.empty())
+			{
+				const BuildTask task = tasks.back();
+				tasks.pop_back();
+				Node& parent = m_nodes[task.node];
+				if (task.end - task.begin <= MaxLeafSize)
+				{
+					parent.child[task.slot] = task.begin;
+					parent.count[task.slot] = task.end - task.begin;
+					continue;
+				}
+
+				// The first child is taken next, so it lands right after its parent.
+				const uint32_t node = m_nodeCount++;
+				memset(&m_nodes[node], 0, sizeof(Node));
+				parent.child[task.slot] = node;
+				const uint32_t middle = Split(objects.data(), task.begin, task.end, task.depth);
+				tasks.push_back({ node, 1, middle, task.end, task.depth + 1 });
+				tasks.push_back({ node, 0, task.begin, middle, task.depth + 1 });
+			}
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				m_objects[i] = objects[i].object;
+			}
+			Refit(bounds);
+			m_buildCost = m_cost;
+		}
+
+		void BoundingVolumeHierarchy::Refit(const Bounds* bounds)
+		{
+			// One pass gathers the bounds in leaf order, so that the node pass reads them in order too.
+			const uint32_t count = static_cast<uint32_t>(m_objects.size());
+			for (uint32_t i = 0; i < count; i++)
+			{
+				m_leafBounds[i] = bounds[m_objects[i]];
+			}
+
+			// Children come after their parents, so walking backwards finishes every child first.
+			float weightedArea = 0;
+			for (uint32_t i = m_nodeCount; i-- > 0;)
+			{
+				Node& node = m_nodes[i];
+				for (uint32_t c = 0; c < 2; c++)
+				{
+					Bounds childBounds = Bounds::Empty();
+					if (node.count[c])
+					{
+						for (uint32_t k = node.child[c], end = k + node.count[c]; k < end; k++)
+						{
+							childBounds.Grow(m_leafBounds[k]);
+						}
+					}
+					else if (node.child[c])
+					{
+						const Node& child = m_nodes[node.child[c]];
+						childBounds.Grow(child.childMin[0], child.childMax[0]);
+						childBounds.Grow(child.childMin[1], child.childMax[1]);
+					}
+					memcpy(node.childMin[c], childBounds.min, sizeof(childBounds.min));
+					memcpy(node.childMax[c], childBounds.max, sizeof(childBounds.max));
+
+					const float area = childBounds.HalfArea();
+					weightedArea += area > 0 ? area * (node.count[c] ? node.count[c] : 1) : 0;
+				}
+			}
+
+			m_cost = 0;
+			if (m_nodeCount)
+			{
+				Bounds root = Bounds::Empty();
+				root.Grow(m_nodes[0].childMin[0], m_nodes[0].childMax[0]);
+				root.Grow(m_nodes[0].childMin[1], m_nodes[0].childMax[1]);
+				const float rootArea = root.HalfArea();
+				m_cost = 1 + (rootArea > 0 ? weightedArea / rootArea : 0);
+			}
+		}
+
+		void BoundingVolumeHierarchy::Query(const Bounds& region, const Bounds* bounds, vector<uint32_t>& results) const
+		{
+			Traverse([&region](const float* min, const float* max)
+			{
+				return region.Overlaps(min, max);
+			}, [&](uint32_t object)
+			{
+				if (region.Overlaps(bounds[object]))
+				{
+					results.push_back(object);
+				}
+			});
+		}
+
+		DynamicHierarchy::~DynamicHierarchy()
+		{
+			if (m_pending.valid())
+			{
+				m_pending.wait();
+			}
+		}
+
+		void DynamicHierarchy::Initialize(Threading::ThreadPool* pool, float rebuildCostRatio, uint32_t rebuildInterval)
+		{
+			m_pool = pool;
+			m_rebuildCostRatio = rebuildCostRatio;
+			m_rebuildInterval = rebuildInterval;
+		}
+
+		void DynamicHierarchy::Update(const Bounds* bounds, uint32_t count)
+		{
+			if (count != m_current.GetObjectCount() || (count && !m_current.GetNodeCount()))
+			{
+				if (m_pending.valid())
+				{
+					m_pending.wait();
+					m_pending = future<BoundingVolumeHierarchy>();
+				}
+				m_current.Build(bounds, count);
+				m_refits = 0;
+				return;
+			}
+
+			if (m_pending.valid() && m_pending.wait_for(chrono::seconds(0)) == future_status::ready)
+			{
+				m_current = m_pending.get();
+				m_refits = 0;
+				m_rebuilds++;
+			}
+			m_current.Refit(bounds);
+			m_refits++;
+
+			if (m_pending.valid() || (m_current.GetCost() <= m_current.GetBuildCost() * m_rebuildCostRatio && m_refits < m_rebuildInterval))
+			{
+				return;
+			}
+			if (!m_pool)
+			{
+				m_current.Build(bounds, count);
+				m_refits = 0;
+				m_rebuilds++;
+				return;
+			}
+			auto snapshot = make_shared<vector<Bounds>>(bounds, bounds + count);
+			m_pending = m_pool->Submit([snapshot]()
+			{
+				BoundingVolumeHierarchy hierarchy;
+				hierarchy.Build(snapshot->data(), static_cast<uint32_t>(snapshot->size()));
+				return hierarchy;
+			});
+		}
+	}
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include "ThreadPool.h"
+
+namespace Query {
+	namespace Culling
+	{
+		// Axis-aligned bounds. Screen-space culling uses x and y in normalized device coordinates
+		// and depth as z.
+		struct Bounds
+		{
+			float min[3];
+			float max[3];
+
+			static Bounds Empty()
+			{
+				return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+			}
+
+			void Grow(const float otherMin[3], const float otherMax[3])
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					const float low = otherMin[axis], high = otherMax[axis];
+					min[axis] = low < min[axis] ? low : min[axis];
+					max[axis] = high > max[axis] ? high : max[axis];
+				}
+			}
+
+			void Grow(const Bounds& other) { Grow(other.min, other.max); }
+
+			bool Overlaps(const float otherMin[3], const float otherMax[3]) const
+			{
+				return min[0] <= otherMax[0] && max[0] >= otherMin[0] &&
+					min[1] <= otherMax[1] && max[1] >= otherMin[1] &&
+					min[2] <= otherMax[2] && max[2] >= otherMin[2];
+			}
+
+			bool Overlaps(const Bounds& other) const { return Overlaps(other.min, other.max); }
+
+			// Half the surface area, which is what the surface area heuristic weighs. Negative when empty.
+			float HalfArea() const
+			{
+				const float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+				return x < 0 ? -1.0f : x * y + y * z + z * x;
+			}
+		};
+
+		// A binary bounding volume hierarchy over the bounds of a fixed set of objects, built top down
+		// with binned SAH and refitted bottom up as the objects move. Every node holds the bounds of
+		// both its children, so that each traversal step reads one 64-byte line and tests two boxes.
+		// Nodes are stored parents first, children in depth-first order, which is also what lets
+		// Refit walk them backwards in one pass.
+		class BoundingVolumeHierarchy
+		{
+		public:
+			// Child c is a leaf when count[c] is nonzero: the objects GetObjects()[child[c], child[c] + count[c]).
+			// Otherwise child[c] is an inner node, or 0 for no child, which only a root can have.
+			struct Node
+			{
+				float childMin[2][3];
+				float childMax[2][3];
+				uint32_t child[2];
+				uint32_t count[2];
+			};
+
+			static const uint32_t MaxLeafSize = 4;
+			static const uint32_t BinCount = 16;
+			static const uint32_t MaxDepth = 64;
+
+		private:
+			unique_ptr<uint8_t[]> m_nodeMemory;
+			Node* m_nodes = nullptr;	//64-byte aligned into m_nodeMemory
+			uint32_t m_nodeCount = 0;
+			vector<uint32_t> m_objects;	//object indices in leaf order
+			vector<Bounds> m_leafBounds;	//Refit's copy of the bounds, in leaf order
+			float m_buildCost = 0;
+			float m_cost = 0;
+
+		public:
+			void Build(const Bounds* bounds, uint32_t count);
+			// Recomputes the bounds of every node from bounds, which must hold the objects of the build
+			// at their current place. O(N); the tree keeps its shape, so its cost grows as objects move.
+			void Refit(const Bounds* bounds);
+
+			uint32_t GetObjectCount() const { return static_cast<uint32_t>(m_objects.size()); }
+			const uint32_t* GetObjects() const { return m_objects.data(); }
+			uint32_t GetNodeCount() const { return m_nodeCount; }
+			const Node* GetNodes() const { return m_nodes; }
+			// SAH cost: expected nodes plus objects tested per query, for queries spread evenly over
+			// the root's bounds. After the build and after the last Refit.
+			float GetBuildCost() const { return m_buildCost; }
+			float GetCost() const { return m_cost; }
+
+			// Walks the children that test(childMin, childMax) accepts, depth first, and calls
+			// visit(object) for every object of the accepted leaves.
+			template<typename Test, typename Visit>
+			void Traverse(Test test, Visit visit) const
+			{
+				uint32_t stack[MaxDepth];
+				uint32_t size = 0;
+				for (uint32_t node = m_nodeCount ? 0 : UINT32_MAX; node != UINT32_MAX;)
+				{
+					const Node& current = m_nodes[node];
+					node = UINT32_MAX;
+					for (uint32_t c = 0; c < 2; c++)
+					{
+						if ((current.count[c] || current.child[c]) && test(current.childMin[c], current.childMax[c]))
+						{
+							if (current.count[c])
+							{
+								for (uint32_t i = current.child[c], end = i + current.count[c]; i < end; i++)
+								{
+									visit(m_objects[i]);
+								}
+							}
+							else if (node == UINT32_MAX)
+							{
+								node = current.child[c];
+							}
+							else
+							{
+								stack[size++] = current.child[c];
+							}
+						}
+					}
+					if (node == UINT32_MAX && size)
+					{
+						node = stack[--size];
+					}
+				}
+			}
+
+			// Appends the objects whose bounds overlap region.
+			void Query(const Bounds& region, const Bounds* bounds, vector<uint32_t>& results) const;
+		};
+
+		// A hierarchy that follows moving objects: Update refits it every frame and, once its cost
+		// has grown by rebuildCostRatio or it has been refitted rebuildInterval times, rebuilds it
+		// from a snapshot of the bounds on the thread pool. The finished tree is refitted to the
+		// bounds of the frame it is adopted in, so Get always matches the last Update.
+		class DynamicHierarchy
+		{
+		private:
+			Threading::ThreadPool* m_pool = nullptr;
+			float m_rebuildCostRatio = 1.3f;
+			uint32_t m_rebuildInterval = 600;
+
+			BoundingVolumeHierarchy m_current;
+			future<BoundingVolumeHierarchy> m_pending;
+			uint32_t m_refits = 0;
+			uint32_t m_rebuilds = 0;
+
+		public:
+			~DynamicHierarchy();
+
+			// Without a pool, rebuilds happen inside Update.
+			void Initialize(Threading::ThreadPool* pool, float rebuildCostRatio = 1.3f, uint32_t rebuildInterval = 600);
+			// Builds at once when the number of objects changes.
+			void Update(const Bounds* bounds, uint32_t count);
+
+			const BoundingVolumeHierarchy& Get() const { return m_current; }
+			bool IsRebuilding() const { return m_pending.valid(); }
+			uint32_t GetRebuildCount() const { return m_rebuilds; }
+		};
+	}
+}
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "BoundingVolumeHierarchyBenchmark.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Scene;
+
+		HierarchyResult RunHierarchy(const HierarchyOptions& options, uint32_t seed)
+		{
+			SceneDesc desc;
+			desc.occluders = options.objects;
+			desc.occludees = 0;
+			desc.animation = Rendering::Animation::Drift;
+			desc.seed = seed;
+			const Scene scene = GenerateScene(desc);
+
+			Rendering::SceneStore store;
+			Rendering::SceneRenderer::AddDrift(scene.occluders, store);
+			vector<float> offsets(static_cast<size_t>(options.objects) * 4);
+			Rendering::SceneStore::Output output;
+			output.destination = reinterpret_cast<uint8_t*>(offsets.data());
+			output.stride = 4 * sizeof(float);
+
+			vector<Culling::Bounds> bounds;
+			GetBounds(scene, store, bounds);
+
+			HierarchyResult result;
+			result.options = options;
+			Culling::BoundingVolumeHierarchy refitted;
+			auto start = chrono::steady_clock::now();
+			refitted.Build(bounds.data(), options.objects);
+			result.buildMilliseconds = MillisecondsSince(start);
+			result.nodes = refitted.GetNodeCount();
+			result.buildCost = refitted.GetBuildCost();
+
+			Threading::ThreadPool threadPool;
+			threadPool.Initialize(options.threadCount);
+			Culling::DynamicHierarchy dynamic;
+			dynamic.Initialize(&threadPool);
+			dynamic.Update(bounds.data(), options.objects);
+
+			double refitMilliseconds = 0, updateMilliseconds = 0;
+			for (uint32_t frame = 0; frame < options.frames; frame++)
+			{
+				store.Update(output);
+				GetBounds(scene, store, bounds);
+
+				start = chrono::steady_clock::now();
+				refitted.Refit(bounds.data());
+				refitMilliseconds += MillisecondsSince(start);
+
+				start = chrono::steady_clock::now();
+				dynamic.Update(bounds.data(), options.objects);
+				updateMilliseconds += MillisecondsSince(start);
+			}
+			const double frames = options.frames ? options.frames : 1;
+			result.refitMilliseconds = refitMilliseconds / frames;
+			result.refitCost = refitted.GetCost();
+			result.updateMilliseconds = updateMilliseconds / frames;
+			result.rebuilds = dynamic.GetRebuildCount();
+			result.dynamicCost = dynamic.Get().GetCost();
+
+			Random random(seed);
+			vector<Culling::Bounds> regions(options.queries);
+			for (Culling::Bounds& region : regions)
+			{
+				const float x = random.Uniform(-1.0f, 1.0f - options.querySize), y = random.Uniform(-1.0f, 1.0f - options.querySize);
+				region = { { x, y, 0.0f }, { x + options.querySize, y + options.querySize, 1.0f } };
+			}
+
+			vector<uint32_t> objects;
+			uint64_t found = 0;
+			auto runQueries = [&](const Culling::BoundingVolumeHierarchy& hierarchy)
+			{
+				found = 0;
+				const auto queryStart = chrono::steady_clock::now();
+				for (const Culling::Bounds& region : regions)
+				{
+					objects.clear();
+					hierarchy.Query(region, bounds.data(), objects);
+					found += objects.size();
+				}
+				return options.queries ? MillisecondsSince(queryStart) * 1000 / options.queries : 0;
+			};
+			result.refitQueryMicroseconds = runQueries(refitted);
+			result.queryMicroseconds = runQueries(dynamic.Get());
+			result.objectsPerQuery = options.queries ? static_cast<double>(found) / options.queries : 0;
+
+			const uint32_t linearQueries = (options.queries + 99) / 100;
+			vector<uint32_t> expected;
+			double linearMilliseconds = 0;
+			for (uint32_t q = 0; q < linearQueries; q++)
+			{
+				const Culling::Bounds& region = regions[q];
+				expected.clear();
+				start = chrono::steady_clock::now();
+				for (uint32_t i = 0; i < options.objects; i++)
+				{
+					if (region.Overlaps(bounds[i]))
+					{
+						expected.push_back(i);
+					}
+				}
+				linearMilliseconds += MillisecondsSince(start);
+			}
+			result.linearQueryMicroseconds = linearQueries ? linearMilliseconds * 1000 / linearQueries : 0;
+			return result;
+		}
+
+		string ToJson(const vector<HierarchyResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"bvh\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const HierarchyResult& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"objects\": %u, \"frames\": %u, \"queries\": %u, \"querySize\": %.3f, \"nodes\": %u, "
+					"\"buildMs\": %.2f, \"refitMs\": %.3f, \"buildCost\": %.1f, \"refitCost\": %.1f, "
+					"\"updateMs\": %.3f, \"rebuilds\": %u, \"dynamicCost\": %.1f, "
+					"\"queryUs\": %.3f, \"refitQueryUs\": %.3f, \"linearQueryUs\": %.1f, \"objectsPerQuery\": %.1f }",
+					i ? "," : "",
+					result.options.objects, result.options.frames, result.options.queries, result.options.querySize, result.nodes,
+					result.buildMilliseconds, result.refitMilliseconds, result.buildCost, result.refitCost,
+					result.updateMilliseconds, result.rebuilds, result.dynamicCost,
+					result.queryMicroseconds, result.refitQueryMicroseconds, result.linearQueryMicroseconds, result.objectsPerQuery);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
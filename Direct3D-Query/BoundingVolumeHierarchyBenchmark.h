@@ -0,0 +1,39 @@
+#pragma once
+#include "SceneGenerator.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct HierarchyOptions
+		{
+			uint32_t objects = 1000000;
+			uint32_t frames = 100;	//of drifting, each followed by a refit
+			uint32_t queries = 10000;
+			float querySize = 0.1f;	//side of the square query regions, in normalized device coordinates
+			uint32_t threadCount = 0;	//pool workers for background rebuilds, 0 for one per hardware thread
+		};
+
+		struct HierarchyResult
+		{
+			HierarchyOptions options;
+			uint32_t nodes = 0;
+			double buildMilliseconds = 0;
+			double refitMilliseconds = 0;	//per frame
+			float buildCost = 0;	//SAH cost after the build
+			float refitCost = 0;	//and after the last refit
+			double updateMilliseconds = 0;	//DynamicHierarchy::Update per frame, rebuilds on the pool
+			uint32_t rebuilds = 0;
+			float dynamicCost = 0;
+			double queryMicroseconds = 0;	//on the dynamic hierarchy after the last frame
+			double refitQueryMicroseconds = 0;	//on the tree that was only refitted
+			double linearQueryMicroseconds = 0;	//testing every object, over a hundredth of the queries
+			double objectsPerQuery = 0;
+		};
+
+		// Builds a hierarchy over the occluders of a generated scene, drifts them (see
+		// Rendering::SceneStore) and refits it every frame, then runs random region queries.
+		HierarchyResult RunHierarchy(const HierarchyOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<HierarchyResult>& results);
+	}
+}
@@ -0,0 +1,967 @@
+#include "pch.h"
+#include "CommandTrace.h"
+#include "Hash.h"
+
+namespace Query {
+	namespace Capture
+	{
+		using Trace::Op;
+		using Backend::ResourceDesc;
+
+		namespace
+		{
+			// Limits on what a trace may create, so that a damaged one cannot exhaust memory.
+			const uint64_t MaxBufferSize = 1ull << 31;
+			const uint32_t MaxTextureSize = 16384;
+			const uint32_t MaxQueryCount = 1u << 16;
+			const uint32_t MaxFrameCount = 16;
+
+			// Bounds-checked decoding; past the end every read yields zero and Failed turns true.
+			class Reader
+			{
+			private:
+				const uint8_t* m_data;
+				const uint8_t* m_end;
+				bool m_failed = false;
+
+			public:
+				Reader(const uint8_t* data, const uint8_t* end) : m_data(data), m_end(end) {}
+
+				bool AtEnd() const { return m_data >= m_end; }
+				bool Failed() const { return m_failed; }
+				const uint8_t* GetPosition() const { return m_data; }
+
+				template<typename T>
+				T Get()
+				{
+					T value = {};
+					if (static_cast<size_t>(m_end - m_data) < sizeof(T))
+					{
+						m_failed = true;
+						m_data = m_end;
+						return value;
+					}
+					memcpy(&value, m_data, sizeof(T));
+					m_data += sizeof(T);
+					return value;
+				}
+
+				const uint8_t* Skip(uint64_t size)
+				{
+					if (static_cast<uint64_t>(m_end - m_data) < size)
+					{
+						m_failed = true;
+						m_data = m_end;
+						return nullptr;
+					}
+					const uint8_t* data = m_data;
+					m_data += size;
+					return data;
+				}
+
+				// Null-terminated string stored inline.
+				const char* GetString()
+				{
+					auto terminator = static_cast<const uint8_t*>(memchr(m_data, 0, m_end - m_data));
+					if (!terminator)
+					{
+						m_failed = true;
+						m_data = m_end;
+						return "";
+					}
+					const char* text = reinterpret_cast<const char*>(m_data);
+					m_data = terminator + 1;
+					return text;
+				}
+			};
+
+			// Load decodes every submission into this once, so that Run never meets malformed data.
+			class DiscardCommandList : public ICommandList
+			{
+			public:
+				void Reset(uint32_t) override {}
+				void Close() override {}
+				void BeginPass(uint32_t, const char*) override {}
+				void EndPass(uint32_t) override {}
+				void Barriers(const Transition*, uint32_t) override {}
+				void ClearRenderTarget(IResource*, const float[4]) override {}
+				void ClearDepth(IResource*, float) override {}
+				void SetRenderTargets(IResource*, IResource*) override {}
+				void SetViewport(uint32_t, uint32_t) override {}
+				void SetPipeline(IPipeline*) override {}
+				void SetVertexBuffer(IResource*, uint32_t, uint32_t) override {}
+				void SetConstantBuffer(uint32_t, IResource*, uint64_t) override {}
+				void Draw(uint32_t, uint32_t) override {}
+				void BeginQuery(IQueryHeap*, uint32_t) override {}
+				void EndQuery(IQueryHeap*, uint32_t) override {}
+				void ResolveQuery(IQueryHeap*, uint32_t, uint32_t, IResource*, uint64_t) override {}
+				void SetPredication(IResource*, uint64_t) override {}
+				void CopyBuffer(IResource*, uint64_t, IResource*, uint64_t, uint64_t) override {}
+			};
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// TraceWriter
+
+		TraceWriter::TraceWriter()
+		{
+			Trace::Header header = { Trace::Magic, Trace::Version, 0 };
+			Put(header);
+		}
+
+		void TraceWriter::Append(const void* data, size_t size)
+		{
+			auto bytes = static_cast<const uint8_t*>(data);
+			while (size > 0)
+			{
+				if (m_chunks.empty() || m_chunks.back().size() == ChunkSize)
+				{
+					m_chunks.emplace_back();
+					m_chunks.back().reserve(ChunkSize);
+				}
+				auto& chunk = m_chunks.back();
+				const size_t count = ChunkSize - chunk.size() < size ? ChunkSize - chunk.size() : size;
+				chunk.insert(chunk.end(), bytes, bytes + count);
+				bytes += count;
+				size -= count;
+				m_size += count;
+			}
+		}
+
+		uint32_t TraceWriter::NewId(const void* object)
+		{
+			const uint32_t id = m_nextId++;
+			auto inserted = m_ids.emplace(object, id);
+			if (!inserted.second)
+			{
+				inserted.first->second = id;
+				m_generation.fetch_add(1, memory_order_release);
+			}
+			return id;
+		}
+
+		void TraceWriter::PutResourceDesc(const ResourceDesc& desc, ResourceState initialState)
+		{
+			Put(static_cast<uint8_t>(desc.kind));
+			Put(static_cast<uint8_t>(desc.heap));
+			Put(static_cast<uint8_t>(desc.format));
+			Put(desc.size);
+			Put(desc.width);
+			Put(desc.height);
+			Put(static_cast<uint32_t>(initialState));
+		}
+
+		void TraceWriter::DeclareResource(const IResource* resource, ResourceState initialState)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_uploadContents.erase(resource);
+			Put(Op::DeclareResource);
+			Put(NewId(resource));
+			PutResourceDesc(resource->GetDesc(), initialState);
+		}
+
+		void TraceWriter::DeclareTransient(const IResource* resource, ResourceState initialState, uint32_t firstStep, uint32_t lastStep)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			Put(Op::DeclareTransient);
+			Put(NewId(resource));
+			PutResourceDesc(resource->GetDesc(), initialState);
+			Put(firstStep);
+			Put(lastStep);
+		}
+
+		void TraceWriter::CompileTransients()
+		{
+			lock_guard<mutex> lock(m_mutex);
+			Put(Op::CompileTransients);
+		}
+
+		void TraceWriter::DeclareQueryHeap(const IQueryHeap* heap)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			Put(Op::DeclareQueryHeap);
+			Put(NewId(heap));
+			Put(static_cast<uint8_t>(heap->GetType()));
+			Put(heap->GetCount());
+		}
+
+		void TraceWriter::DeclarePipeline(const IPipeline* pipeline, uint32_t index)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			Put(Op::DeclarePipeline);
+			Put(NewId(pipeline));
+			Put(index);
+			m_nextPipeline = index + 1 > m_nextPipeline ? index + 1 : m_nextPipeline;
+		}
+
+		uint32_t TraceWriter::DeclareCommandList(const ICommandList* commandList, uint32_t frameCount)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			const uint32_t id = NewId(commandList);
+			Put(Op::DeclareCommandList);
+			Put(id);
+			Put(frameCount);
+			return id;
+		}
+
+		uint32_t TraceWriter::GetId(const IResource* resource)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			auto found = m_ids.find(resource);
+			if (found != m_ids.end())
+			{
+				return found->second;
+			}
+
+			// Not created through the capture device: a swap chain buffer, which starts out presented.
+			const ResourceDesc& desc = resource->GetDesc();
+			Put(Op::DeclareResource);
+			const uint32_t id = NewId(resource);
+			Put(id);
+			PutResourceDesc(desc, desc.kind == Backend::ResourceKind::RenderTarget ? Rendering::StatePresent : Rendering::StateCommon);
+			return id;
+		}
+
+		uint32_t TraceWriter::GetId(const IPipeline* pipeline)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			auto found = m_ids.find(pipeline);
+			if (found != m_ids.end())
+			{
+				return found->second;
+			}
+
+			const uint32_t id = NewId(pipeline);
+			Put(Op::DeclarePipeline);
+			Put(id);
+			Put(m_nextPipeline++);
+			return id;
+		}
+
+		uint32_t TraceWriter::GetId(const IQueryHeap* heap)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			auto found = m_ids.find(heap);
+			return found != m_ids.end() ? found->second : Trace::NoObject;
+		}
+
+		void TraceWriter::PutBufferData(uint32_t id, const uint8_t* data, uint64_t offset, uint64_t size)
+		{
+			Put(Op::BufferData);
+			Put(id);
+			Put(offset);
+			Put(size);
+			Append(data, static_cast<size_t>(size));
+		}
+
+		void TraceWriter::Submit(uint32_t commandList, const vector<UploadRange>& uploads, const vector<uint8_t>& recording)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			for (const UploadRange& range : uploads)
+			{
+				auto id = m_ids.find(range.buffer);
+				if (id == m_ids.end())
+				{
+					continue;
+				}
+
+				// The first time a buffer is read all of it is captured; after that only the ranges
+				// read, when they differ from what was captured last.
+				auto data = static_cast<const uint8_t*>(range.buffer->Map());
+				auto contents = m_uploadContents.find(range.buffer);
+				if (contents == m_uploadContents.end())
+				{
+					const uint64_t size = range.buffer->GetDesc().size;
+					m_uploadContents.emplace(range.buffer, vector<uint8_t>(data, data + size));
+					PutBufferData(id->second, data, 0, size);
+				}
+				else if (memcmp(contents->second.data() + range.offset, data + range.offset, static_cast<size_t>(range.size)) != 0)
+				{
+					memcpy(contents->second.data() + range.offset, data + range.offset, static_cast<size_t>(range.size));
+					PutBufferData(id->second, data + range.offset, range.offset, range.size);
+				}
+				range.buffer->Unmap();
+			}
+
+			Put(Op::Submit);
+			Put(commandList);
+			Put(static_cast<uint64_t>(recording.size()));
+			Append(recording.data(), recording.size());
+			m_submits++;
+		}
+
+		bool TraceWriter::Save(const wstring& path)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			vector<uint8_t> contents;
+			contents.reserve(m_size);
+			for (const auto& chunk : m_chunks)
+			{
+				contents.insert(contents.end(), chunk.begin(), chunk.end());
+			}
+
+			Trace::Header header;
+			memcpy(&header, contents.data(), sizeof(header));
+			header.checksum = Hash::Compute(contents.data() + sizeof(header), contents.size() - sizeof(header));
+			memcpy(contents.data(), &header, sizeof(header));
+			return IO::MappedFile::WriteAtomically(path, contents.data(), contents.size());
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// CaptureCommandList
+
+		CaptureCommandList::CaptureCommandList(unique_ptr<ICommandList> inner, TraceWriter* writer, uint32_t frameCount) :
+			m_inner(move(inner)), m_writer(writer)
+		{
+			m_id = writer->DeclareCommandList(this, frameCount);
+		}
+
+		void CaptureCommandList::ReadsUpload(IResource* resource, uint64_t offset, uint64_t size)
+		{
+			const uint64_t bufferSize = resource->GetDesc().size;
+			if (resource->GetDesc().heap != Backend::HeapKind::Upload || offset >= bufferSize)
+			{
+				return;
+			}
+			size = size < bufferSize - offset ? size : bufferSize - offset;
+			for (const auto& range : m_uploads)
+			{
+				if (range.buffer == resource && range.offset == offset && range.size == size)
+				{
+					return;
+				}
+			}
+			m_uploads.push_back({ resource, offset, size });
+		}
+
+		void CaptureCommandList::Reset(uint32_t frame)
+		{
+			m_inner->Reset(frame);
+			m_recording.clear();
+			m_uploads.clear();
+			const uint32_t generation = m_writer->GetGeneration();
+			if (generation != m_generation)
+			{
+				m_ids.clear();
+				m_generation = generation;
+			}
+			Put(Op::Reset);
+			Put(frame);
+		}
+
+		void CaptureCommandList::Close()
+		{
+			m_inner->Close();
+			Put(Op::Close);
+		}
+
+		void CaptureCommandList::BeginPass(uint32_t step, const char* name)
+		{
+			m_inner->BeginPass(step, name);
+			Put(Op::BeginPass);
+			Put(step);
+			const char* text = name ? name : "";
+			m_recording.insert(m_recording.end(), text, text + strlen(text) + 1);
+		}
+
+		void CaptureCommandList::EndPass(uint32_t step)
+		{
+			m_inner->EndPass(step);
+			Put(Op::EndPass);
+			Put(step);
+		}
+
+		void CaptureCommandList::Barriers(const Transition* transitions, uint32_t count)
+		{
+			m_inner->Barriers(transitions, count);
+			Put(Op::Barriers);
+			Put(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				PutId(transitions[i].resource);
+				Put(static_cast<uint32_t>(transitions[i].before));
+				Put(static_cast<uint32_t>(transitions[i].after));
+			}
+		}
+
+		void CaptureCommandList::ClearRenderTarget(IResource* target, const float color[4])
+		{
+			m_inner->ClearRenderTarget(target, color);
+			Put(Op::ClearRenderTarget);
+			PutId(target);
+			for (int i = 0; i < 4; i++)
+			{
+				Put(color[i]);
+			}
+		}
+
+		void CaptureCommandList::ClearDepth(IResource* target, float depth)
+		{
+			m_inner->ClearDepth(target, depth);
+			Put(Op::ClearDepth);
+			PutId(target);
+			Put(depth);
+		}
+
+		void CaptureCommandList::SetRenderTargets(IResource* color, IResource* depth)
+		{
+			m_inner->SetRenderTargets(color, depth);
+			Put(Op::SetRenderTargets);
+			PutId(color);
+			PutId(depth);
+		}
+
+		void CaptureCommandList::SetViewport(uint32_t width, uint32_t height)
+		{
+			m_inner->SetViewport(width, height);
+			Put(Op::SetViewport);
+			Put(width);
+			Put(height);
+		}
+
+		void CaptureCommandList::SetPipeline(IPipeline* pipeline)
+		{
+			m_inner->SetPipeline(pipeline);
+			Put(Op::SetPipeline);
+			PutId(pipeline);
+		}
+
+		void CaptureCommandList::SetVertexBuffer(IResource* buffer, uint32_t stride, uint32_t size)
+		{
+			m_inner->SetVertexBuffer(buffer, stride, size);
+			ReadsUpload(buffer, 0, size);
+			Put(Op::SetVertexBuffer);
+			PutId(buffer);
+			Put(stride);
+			Put(size);
+		}
+
+		void CaptureCommandList::SetConstantBuffer(uint32_t slot, IResource* buffer, uint64_t offset)
+		{
+			m_inner->SetConstantBuffer(slot, buffer, offset);
+			ReadsUpload(buffer, offset, Trace::ConstantBufferSize);
+			Put(Op::SetConstantBuffer);
+			Put(slot);
+			PutId(buffer);
+			Put(offset);
+		}
+
+		void CaptureCommandList::Draw(uint32_t vertexCount, uint32_t firstVertex)
+		{
+			m_inner->Draw(vertexCount, firstVertex);
+			Put(Op::Draw);
+			Put(vertexCount);
+			Put(firstVertex);
+		}
+
+		void CaptureCommandList::BeginQuery(IQueryHeap* heap, uint32_t index)
+		{
+			m_inner->BeginQuery(heap, index);
+			Put(Op::BeginQuery);
+			PutId(heap);
+			Put(index);
+		}
+
+		void CaptureCommandList::EndQuery(IQueryHeap* heap, uint32_t index)
+		{
+			m_inner->EndQuery(heap, index);
+			Put(Op::EndQuery);
+			PutId(heap);
+			Put(index);
+		}
+
+		void CaptureCommandList::ResolveQuery(IQueryHeap* heap, uint32_t index, uint32_t count, IResource* destination, uint64_t offset)
+		{
+			m_inner->ResolveQuery(heap, index, count, destination, offset);
+			Put(Op::ResolveQuery);
+			PutId(heap);
+			Put(index);
+			Put(count);
+			PutId(destination);
+			Put(offset);
+		}
+
+		void CaptureCommandList::SetPredication(IResource* buffer, uint64_t offset)
+		{
+			m_inner->SetPredication(buffer, offset);
+			Put(Op::SetPredication);
+			PutId(buffer);
+			Put(offset);
+		}
+
+		void CaptureCommandList::CopyBuffer(IResource* destination, uint64_t destinationOffset, IResource* source, uint64_t sourceOffset, uint64_t size)
+		{
+			m_inner->CopyBuffer(destination, destinationOffset, source, sourceOffset, size);
+			ReadsUpload(source, sourceOffset, size);
+			Put(Op::CopyBuffer);
+			PutId(destination);
+			Put(destinationOffset);
+			PutId(source);
+			Put(sourceOffset);
+			Put(size);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// CaptureQueue, CaptureDevice
+
+		void CaptureQueue::Submit(ICommandList* commandList)
+		{
+			auto capture = static_cast<CaptureCommandList*>(commandList);
+			m_writer->Submit(capture->GetId(), capture->GetUploads(), capture->GetRecording());
+			m_inner->Submit(capture->GetInner());
+		}
+
+		CaptureDevice::CaptureDevice(Backend::IDevice* inner, TraceWriter* writer) :
+			m_inner(inner), m_writer(writer)
+		{
+			m_queue.Initialize(inner->GetQueue(), writer);
+		}
+
+		unique_ptr<IResource> CaptureDevice::CreateResource(const ResourceDesc& desc, ResourceState initialState)
+		{
+			auto resource = m_inner->CreateResource(desc, initialState);
+			m_writer->DeclareResource(resource.get(), initialState);
+			return resource;
+		}
+
+		unique_ptr<IResource> CaptureDevice::CreateTransient(const ResourceDesc& desc, ResourceState initialState, uint32_t firstStep, uint32_t lastStep)
+		{
+			auto resource = m_inner->CreateTransient(desc, initialState, firstStep, lastStep);
+			m_writer->DeclareTransient(resource.get(), initialState, firstStep, lastStep);
+			return resource;
+		}
+
+		void CaptureDevice::CompileTransients()
+		{
+			m_inner->CompileTransients();
+			m_writer->CompileTransients();
+		}
+
+		unique_ptr<IQueryHeap> CaptureDevice::CreateQueryHeap(Backend::QueryType type, uint32_t count)
+		{
+			auto heap = m_inner->CreateQueryHeap(type, count);
+			m_writer->DeclareQueryHeap(heap.get());
+			return heap;
+		}
+
+		unique_ptr<ICommandList> CaptureDevice::CreateCommandList(uint32_t frameCount)
+		{
+			return make_unique<CaptureCommandList>(m_inner->CreateCommandList(frameCount), m_writer, frameCount);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// TraceReplayer
+
+		bool TraceReplayer::Open(const wstring& path)
+		{
+			if (!m_file.Open(path))
+			{
+				return false;
+			}
+			return Open(m_file.GetData(), m_file.GetSize());
+		}
+
+		bool TraceReplayer::Open(const void* data, size_t size)
+		{
+			m_begin = static_cast<const uint8_t*>(data);
+			m_end = m_begin + size;
+
+			Reader reader(m_begin, m_end);
+			auto header = reader.Get<Trace::Header>();
+			if (reader.Failed() || header.magic != Trace::Magic || header.version != Trace::Version ||
+				header.checksum != Hash::Compute(reader.GetPosition(), m_end - reader.GetPosition()))
+			{
+				m_begin = m_end = nullptr;
+				return false;
+			}
+			return true;
+		}
+
+		template<typename T>
+		T* TraceReplayer::Resolve(uint32_t id, ObjectKind kind, bool& valid) const
+		{
+			if (id == Trace::NoObject)
+			{
+				return nullptr;
+			}
+			if (id >= m_objects.size() || m_objects[id].kind != kind)
+			{
+				valid = false;
+				return nullptr;
+			}
+			return static_cast<T*>(m_objects[id].object);
+		}
+
+		bool TraceReplayer::Execute(CommandListSlot& slot, const uint8_t* data, const uint8_t* end, ICommandList* commandList, uint64_t& commands)
+		{
+			Reader reader(data, end);
+			bool valid = true;
+			auto resource = [&]() { return Resolve<IResource>(reader.Get<uint32_t>(), ObjectKind::Resource, valid); };
+			auto queryHeap = [&]() -> IQueryHeap*
+			{
+				IQueryHeap* heap = Resolve<IQueryHeap>(reader.Get<uint32_t>(), ObjectKind::QueryHeap, valid);
+				valid &= heap != nullptr;
+				return heap;
+			};
+
+			while (valid && !reader.AtEnd())
+			{
+				switch (static_cast<Op>(reader.Get<uint8_t>()))
+				{
+				case Op::Reset:
+				{
+					const uint32_t frame = reader.Get<uint32_t>();
+					if (frame >= slot.frameFences.size())
+					{
+						return false;
+					}
+					// The frame's command memory must be idle, as in the captured frame loop.
+					if (m_fence->GetCompletedValue() < slot.frameFences[frame])
+					{
+						m_fence->Wait(slot.frameFences[frame]);
+					}
+					slot.frame = frame;
+					commandList->Reset(frame);
+					break;
+				}
+				case Op::Close:
+					commandList->Close();
+					break;
+				case Op::BeginPass:
+				{
+					const uint32_t step = reader.Get<uint32_t>();
+					commandList->BeginPass(step, reader.GetString());
+					break;
+				}
+				case Op::EndPass:
+					commandList->EndPass(reader.Get<uint32_t>());
+					break;
+				case Op::Barriers:
+				{
+					const uint32_t count = reader.Get<uint32_t>();
+					if (count > static_cast<uint64_t>(end - reader.GetPosition()) / 12)
+					{
+						return false;
+					}
+					m_transitions.resize(count);
+					for (auto& transition : m_transitions)
+					{
+						transition.resource = resource();
+						transition.before = static_cast<ResourceState>(reader.Get<uint32_t>());
+						transition.after = static_cast<ResourceState>(reader.Get<uint32_t>());
+						valid &= transition.resource != nullptr;
+					}
+					commandList->Barriers(m_transitions.data(), count);
+					break;
+				}
+				case Op::ClearRenderTarget:
+				{
+					IResource* target = resource();
+					float color[4];
+					for (float& channel : color)
+					{
+						channel = reader.Get<float>();
+					}
+					valid &= target != nullptr;
+					commandList->ClearRenderTarget(target, color);
+					break;
+				}
+				case Op::ClearDepth:
+				{
+					IResource* target = resource();
+					const float depth = reader.Get<float>();
+					valid &= target != nullptr;
+					commandList->ClearDepth(target, depth);
+					break;
+				}
+				case Op::SetRenderTargets:
+				{
+					IResource* color = resource();
+					IResource* depth = resource();
+					commandList->SetRenderTargets(color, depth);
+					break;
+				}
+				case Op::SetViewport:
+				{
+					const uint32_t width = reader.Get<uint32_t>();
+					commandList->SetViewport(width, reader.Get<uint32_t>());
+					break;
+				}
+				case Op::SetPipeline:
+				{
+					IPipeline* pipeline = Resolve<IPipeline>(reader.Get<uint32_t>(), ObjectKind::Pipeline, valid);
+					valid &= pipeline != nullptr;
+					commandList->SetPipeline(pipeline);
+					break;
+				}
+				case Op::SetVertexBuffer:
+				{
+					IResource* buffer = resource();
+					const uint32_t stride = reader.Get<uint32_t>();
+					const uint32_t size = reader.Get<uint32_t>();
+					valid &= buffer && size <= buffer->GetDesc().size;
+					commandList->SetVertexBuffer(buffer, stride, size);
+					break;
+				}
+				case Op::SetConstantBuffer:
+				{
+					const uint32_t slotIndex = reader.Get<uint32_t>();
+					IResource* buffer = resource();
+					const uint64_t offset = reader.Get<uint64_t>();
+					valid &= buffer && buffer->GetDesc().size >= Trace::ConstantBufferSize &&
+						offset <= buffer->GetDesc().size - Trace::ConstantBufferSize;
+					commandList->SetConstantBuffer(slotIndex, buffer, offset);
+					break;
+				}
+				case Op::Draw:
+				{
+					const uint32_t vertexCount = reader.Get<uint32_t>();
+					const uint32_t firstVertex = reader.Get<uint32_t>();
+					valid &= vertexCount <= 0xFFFFFFFFu - firstVertex;
+					commandList->Draw(vertexCount, firstVertex);
+					break;
+				}
+				case Op::BeginQuery:
+				{
+					IQueryHeap* heap = queryHeap();
+					const uint32_t index = reader.Get<uint32_t>();
+					valid &= heap && index < heap->GetCount();
+					commandList->BeginQuery(heap, index);
+					break;
+				}
+				case Op::EndQuery:
+				{
+					IQueryHeap* heap = queryHeap();
+					const uint32_t index = reader.Get<uint32_t>();
+					valid &= heap && index < heap->GetCount();
+					commandList->EndQuery(heap, index);
+					break;
+				}
+				case Op::ResolveQuery:
+				{
+					IQueryHeap* heap = queryHeap();
+					const uint32_t index = reader.Get<uint32_t>();
+					const uint32_t count = reader.Get<uint32_t>();
+					IResource* destination = resource();
+					const uint64_t offset = reader.Get<uint64_t>();
+					valid &= heap && destination && static_cast<uint64_t>(index) + count <= heap->GetCount() &&
+						offset + count * sizeof(uint64_t) <= destination->GetDesc().size;
+					commandList->ResolveQuery(heap, index, count, destination, offset);
+					break;
+				}
+				case Op::SetPredication:
+				{
+					IResource* buffer = resource();
+					const uint64_t offset = reader.Get<uint64_t>();
+					valid &= !buffer || offset + sizeof(uint64_t) <= buffer->GetDesc().size;
+					commandList->SetPredication(buffer, offset);
+					break;
+				}
+				case Op::CopyBuffer:
+				{
+					IResource* destination = resource();
+					const uint64_t destinationOffset = reader.Get<uint64_t>();
+					IResource* source = resource();
+					const uint64_t sourceOffset = reader.Get<uint64_t>();
+					const uint64_t size = reader.Get<uint64_t>();
+					valid &= destination && source &&
+						destinationOffset + size <= destination->GetDesc().size && sourceOffset + size <= source->GetDesc().size;
+					commandList->CopyBuffer(destination, destinationOffset, source, sourceOffset, size);
+					break;
+				}
+				default:
+					return false;
+				}
+				valid &= !reader.Failed();
+				commands++;
+			}
+			return valid;
+		}
+
+		bool TraceReplayer::Load(Backend::IDevice* device, const vector<IPipeline*>& pipelines)
+		{
+			if (!m_begin)
+			{
+				return false;
+			}
+			m_device = device;
+			m_fence = device->CreateFence(0);
+			m_fenceValue = 0;
+
+			DiscardCommandList discard;
+			uint64_t commands = 0;
+			Reader reader(m_begin + sizeof(Trace::Header), m_end);
+			auto declare = [&](uint32_t id, ObjectKind kind, void* object)
+			{
+				// The writer hands out ids in declaration order.
+				if (id != m_objects.size())
+				{
+					return false;
+				}
+				m_objects.push_back({ kind, object });
+				return true;
+			};
+			auto readDesc = [&](ResourceState& initialState)
+			{
+				ResourceDesc desc;
+				desc.kind = static_cast<Backend::ResourceKind>(reader.Get<uint8_t>());
+				desc.heap = static_cast<Backend::HeapKind>(reader.Get<uint8_t>());
+				desc.format = static_cast<Backend::Format>(reader.Get<uint8_t>());
+				desc.size = reader.Get<uint64_t>();
+				desc.width = reader.Get<uint32_t>();
+				desc.height = reader.Get<uint32_t>();
+				initialState = static_cast<ResourceState>(reader.Get<uint32_t>());
+				return desc;
+			};
+			// D3D12's texture dimension and resource size limits.
+			auto descValid = [](const ResourceDesc& desc)
+			{
+				if (desc.kind == Backend::ResourceKind::Buffer)
+				{
+					return desc.heap <= Backend::HeapKind::Readback && desc.size <= MaxBufferSize;
+				}
+				return desc.kind <= Backend::ResourceKind::DepthStencil && desc.format <= Backend::Format::D32Float &&
+					desc.width <= MaxTextureSize && desc.height <= MaxTextureSize;
+			};
+
+			while (!reader.AtEnd())
+			{
+				const uint8_t* record = reader.GetPosition();
+				bool valid = true;
+				switch (static_cast<Op>(reader.Get<uint8_t>()))
+				{
+				case Op::DeclareResource:
+				{
+					const uint32_t id = reader.Get<uint32_t>();
+					ResourceState initialState;
+					const ResourceDesc desc = readDesc(initialState);
+					if (reader.Failed() || !descValid(desc))
+					{
+						return false;
+					}
+					m_resources.push_back(device->CreateResource(desc, initialState));
+					valid = declare(id, ObjectKind::Resource, m_resources.back().get());
+					break;
+				}
+				case Op::DeclareTransient:
+				{
+					const uint32_t id = reader.Get<uint32_t>();
+					ResourceState initialState;
+					const ResourceDesc desc = readDesc(initialState);
+					const uint32_t firstStep = reader.Get<uint32_t>();
+					const uint32_t lastStep = reader.Get<uint32_t>();
+					if (reader.Failed() || !descValid(desc) || desc.kind == Backend::ResourceKind::Buffer)
+					{
+						return false;
+					}
+					m_resources.push_back(device->CreateTransient(desc, initialState, firstStep, lastStep));
+					valid = declare(id, ObjectKind::Resource, m_resources.back().get());
+					break;
+				}
+				case Op::CompileTransients:
+					device->CompileTransients();
+					break;
+				case Op::DeclarePipeline:
+				{
+					const uint32_t id = reader.Get<uint32_t>();
+					const uint32_t index = reader.Get<uint32_t>();
+					valid = index < pipelines.size() && pipelines[index] && declare(id, ObjectKind::Pipeline, pipelines[index]);
+					break;
+				}
+				case Op::DeclareQueryHeap:
+				{
+					const uint32_t id = reader.Get<uint32_t>();
+					const auto type = static_cast<Backend::QueryType>(reader.Get<uint8_t>());
+					const uint32_t count = reader.Get<uint32_t>();
+					if (reader.Failed() || type > Backend::QueryType::BinaryOcclusion || count > MaxQueryCount)
+					{
+						return false;
+					}
+					m_queryHeaps.push_back(device->CreateQueryHeap(type, count));
+					valid = declare(id, ObjectKind::QueryHeap, m_queryHeaps.back().get());
+					break;
+				}
+				case Op::DeclareCommandList:
+				{
+					const uint32_t id = reader.Get<uint32_t>();
+					const uint32_t frameCount = reader.Get<uint32_t>();
+					if (reader.Failed() || frameCount == 0 || frameCount > MaxFrameCount)
+					{
+						return false;
+					}
+					auto slot = make_unique<CommandListSlot>();
+					slot->commandList = device->CreateCommandList(frameCount);
+					slot->frameFences.assign(frameCount, 0);
+					valid = declare(id, ObjectKind::CommandList, slot.get());
+					m_commandLists.push_back(move(slot));
+					break;
+				}
+				case Op::BufferData:
+				{
+					const uint32_t id = reader.Get<uint32_t>();
+					const uint64_t offset = reader.Get<uint64_t>();
+					const uint64_t size = reader.Get<uint64_t>();
+					reader.Skip(size);
+					IResource* buffer = Resolve<IResource>(id, ObjectKind::Resource, valid);
+					valid &= buffer && buffer->GetDesc().heap == Backend::HeapKind::Upload &&
+						offset <= buffer->GetDesc().size && size <= buffer->GetDesc().size - offset;
+					m_work.push_back(record);
+					break;
+				}
+				case Op::Submit:
+				{
+					auto slot = Resolve<CommandListSlot>(reader.Get<uint32_t>(), ObjectKind::CommandList, valid);
+					const uint64_t size = reader.Get<uint64_t>();
+					const uint8_t* data = reader.Skip(size);
+					valid &= slot && data && Execute(*slot, data, data + size, &discard, commands);
+					m_work.push_back(record);
+					break;
+				}
+				default:
+					return false;
+				}
+				if (!valid || reader.Failed())
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		TraceReplayer::Stats TraceReplayer::Run()
+		{
+			Stats stats;
+			Backend::IQueue* queue = m_device->GetQueue();
+			auto start = chrono::steady_clock::now();
+			for (const uint8_t* record : m_work)
+			{
+				// Load checked every record, so these reads stay in bounds.
+				Reader reader(record, m_end);
+				const auto op = static_cast<Op>(reader.Get<uint8_t>());
+				const uint32_t id = reader.Get<uint32_t>();
+				if (op == Op::BufferData)
+				{
+					const uint64_t offset = reader.Get<uint64_t>();
+					const uint64_t size = reader.Get<uint64_t>();
+					auto buffer = static_cast<IResource*>(m_objects[id].object);
+					memcpy(static_cast<uint8_t*>(buffer->Map()) + offset, reader.Skip(size), static_cast<size_t>(size));
+					buffer->Unmap();
+					continue;
+				}
+
+				const uint64_t size = reader.Get<uint64_t>();
+				const uint8_t* data = reader.Skip(size);
+
+				auto& slot = *static_cast<CommandListSlot*>(m_objects[id].object);
+				Execute(slot, data, data + size, slot.commandList.get(), stats.commands);
+				queue->Submit(slot.commandList.get());
+				queue->Signal(m_fence.get(), ++m_fenceValue);
+				slot.frameFences[slot.frame] = m_fenceValue;
+				stats.submits++;
+			}
+			m_fence->Wait(m_fenceValue);
+			stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			return stats;
+		}
+	}
+}
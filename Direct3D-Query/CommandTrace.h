@@ -0,0 +1,296 @@
+#pragma once
+#include "Backend.h"
+#include "MappedFile.h"
+
+namespace Query {
+	namespace Capture
+	{
+		using Rendering::ResourceState;
+		using Backend::IResource;
+		using Backend::IPipeline;
+		using Backend::IQueryHeap;
+		using Backend::ICommandList;
+
+		// Binary trace of everything recorded through the backend interfaces. The file is a header
+		// followed by records of one opcode byte and a fixed little-endian payload. Objects are
+		// referred to by ids that are declared before their first use. A Submit record carries the
+		// whole command list recording inline. BufferData records hold the upload buffer ranges a
+		// submission reads, written only when they changed since they were last captured.
+		namespace Trace
+		{
+			static const uint32_t Magic = 0x444D4351;	//"QCMD"
+			static const uint32_t Version = 1;
+			static const uint32_t NoObject = 0xFFFFFFFFu;
+			// Bytes a root CBV is assumed to read; every constant buffer of the sample is one 256-byte
+			// aligned SceneConstantBuffer.
+			static const uint64_t ConstantBufferSize = 256;
+
+			struct Header
+			{
+				uint32_t magic;
+				uint32_t version;
+				uint64_t checksum;	//Hash::Compute of everything after the header
+			};
+
+			enum class Op : uint8_t
+			{
+				// Stream records.
+				DeclareResource, DeclareTransient, CompileTransients, DeclarePipeline, DeclareQueryHeap, DeclareCommandList,
+				BufferData, Submit,
+
+				// Command list records, only inside a Submit.
+				Reset, Close, BeginPass, EndPass, Barriers,
+				ClearRenderTarget, ClearDepth, SetRenderTargets, SetViewport,
+				SetPipeline, SetVertexBuffer, SetConstantBuffer, Draw,
+				BeginQuery, EndQuery, ResolveQuery, SetPredication, CopyBuffer
+			};
+		}
+
+		// Collects the trace. Ids are assigned on first sight of an object; resources and query
+		// heaps created through the CaptureDevice are declared with their creation parameters,
+		// others (swap chain buffers) from their description when first referenced.
+		class TraceWriter
+		{
+		private:
+			mutex m_mutex;
+			// The stream is kept in fixed-size chunks, so that growing it never copies what was captured.
+			static const size_t ChunkSize = 1 << 20;
+			vector<vector<uint8_t>> m_chunks;
+			size_t m_size = 0;
+			unordered_map<const void*, uint32_t> m_ids;
+			unordered_map<const IResource*, vector<uint8_t>> m_uploadContents;	//as last captured
+			atomic<uint32_t> m_generation{ 0 };
+			uint32_t m_nextId = 0;
+			uint32_t m_nextPipeline = 0;
+			uint32_t m_submits = 0;
+
+		private:
+			template<typename T>
+			void Put(T value)
+			{
+				Append(&value, sizeof(T));
+			}
+			void Put(Trace::Op op) { Put(static_cast<uint8_t>(op)); }
+			void Append(const void* data, size_t size);
+			void PutBufferData(uint32_t id, const uint8_t* data, uint64_t offset, uint64_t size);
+			// Gives the object a new id, replacing any earlier object at the same address.
+			uint32_t NewId(const void* object);
+			void PutResourceDesc(const Backend::ResourceDesc& desc, ResourceState initialState);
+
+		public:
+			TraceWriter();
+
+			void DeclareResource(const IResource* resource, ResourceState initialState);
+			void DeclareTransient(const IResource* resource, ResourceState initialState, uint32_t firstStep, uint32_t lastStep);
+			void CompileTransients();
+			void DeclareQueryHeap(const IQueryHeap* heap);
+			// Gives a pipeline a fixed slot in the replayer's pipeline list. Pipelines bound without
+			// being declared take the next free slot.
+			void DeclarePipeline(const IPipeline* pipeline, uint32_t index);
+			uint32_t DeclareCommandList(const ICommandList* commandList, uint32_t frameCount);
+
+			uint32_t GetId(const IResource* resource);
+			uint32_t GetId(const IPipeline* pipeline);
+			uint32_t GetId(const IQueryHeap* heap);
+
+			struct UploadRange
+			{
+				IResource* buffer;
+				uint64_t offset;
+				uint64_t size;
+			};
+
+			// Changes whenever an id is reassigned because an object was created at the address of a
+			// destroyed one, so that callers caching ids know to drop them.
+			uint32_t GetGeneration() const { return m_generation.load(memory_order_acquire); }
+
+			// Appends the upload ranges that changed, then the recording.
+			void Submit(uint32_t commandList, const vector<UploadRange>& uploads, const vector<uint8_t>& recording);
+
+			size_t GetSize() const { return m_size; }
+			uint32_t GetSubmitCount() const { return m_submits; }
+			bool Save(const wstring& path);
+		};
+
+		// Forwards every call to the wrapped command list and appends it to a local recording,
+		// which the CaptureQueue hands to the writer at submission.
+		class CaptureCommandList : public ICommandList
+		{
+		private:
+			unique_ptr<ICommandList> m_inner;
+			TraceWriter* m_writer;
+			uint32_t m_id;
+			vector<uint8_t> m_recording;
+			vector<TraceWriter::UploadRange> m_uploads;	//read by the commands, snapshot at submission
+			// Ids seen by this list, so that recording rarely takes the writer's lock. A frame references
+			// a handful of objects, so a linear search beats hashing.
+			vector<pair<const void*, uint32_t>> m_ids;
+			uint32_t m_generation = 0;
+
+		private:
+			template<typename T>
+			void Put(T value)
+			{
+				const size_t offset = m_recording.size();
+				m_recording.resize(offset + sizeof(T));
+				memcpy(m_recording.data() + offset, &value, sizeof(T));
+			}
+			void Put(Trace::Op op) { m_recording.push_back(static_cast<uint8_t>(op)); }
+			template<typename T>
+			void PutId(T* object)
+			{
+				if (!object)
+				{
+					Put(Trace::NoObject);
+					return;
+				}
+				for (const auto& known : m_ids)
+				{
+					if (known.first == object)
+					{
+						Put(known.second);
+						return;
+					}
+				}
+				const uint32_t id = m_writer->GetId(object);
+				m_ids.emplace_back(object, id);
+				Put(id);
+			}
+			void ReadsUpload(IResource* resource, uint64_t offset, uint64_t size);
+
+		public:
+			CaptureCommandList(unique_ptr<ICommandList> inner, TraceWriter* writer, uint32_t frameCount);
+
+			ICommandList* GetInner() const { return m_inner.get(); }
+			uint32_t GetId() const { return m_id; }
+			const vector<uint8_t>& GetRecording() const { return m_recording; }
+			const vector<TraceWriter::UploadRange>& GetUploads() const { return m_uploads; }
+
+			void Reset(uint32_t frame) override;
+			void Close() override;
+
+			void BeginPass(uint32_t step, const char* name) override;
+			void EndPass(uint32_t step) override;
+			void Barriers(const Transition* transitions, uint32_t count) override;
+
+			void ClearRenderTarget(IResource* target, const float color[4]) override;
+			void ClearDepth(IResource* target, float depth) override;
+			void SetRenderTargets(IResource* color, IResource* depth) override;
+			void SetViewport(uint32_t width, uint32_t height) override;
+
+			void SetPipeline(IPipeline* pipeline) override;
+			void SetVertexBuffer(IResource* buffer, uint32_t stride, uint32_t size) override;
+			void SetConstantBuffer(uint32_t slot, IResource* buffer, uint64_t offset) override;
+			void Draw(uint32_t vertexCount, uint32_t firstVertex) override;
+
+			void BeginQuery(IQueryHeap* heap, uint32_t index) override;
+			void EndQuery(IQueryHeap* heap, uint32_t index) override;
+			void ResolveQuery(IQueryHeap* heap, uint32_t index, uint32_t count, IResource* destination, uint64_t offset) override;
+			void SetPredication(IResource* buffer, uint64_t offset) override;
+
+			void CopyBuffer(IResource* destination, uint64_t destinationOffset, IResource* source, uint64_t sourceOffset, uint64_t size) override;
+		};
+
+		class CaptureQueue : public Backend::IQueue
+		{
+		private:
+			Backend::IQueue* m_inner = nullptr;
+			TraceWriter* m_writer = nullptr;
+
+		public:
+			void Initialize(Backend::IQueue* inner, TraceWriter* writer) { m_inner = inner; m_writer = writer; }
+			void Submit(ICommandList* commandList) override;
+			void Signal(Backend::IFence* fence, uint64_t value) override { m_inner->Signal(fence, value); }
+		};
+
+		// Wraps a device so that everything recorded on it is captured. Resources, fences and query
+		// heaps are the wrapped device's own objects, so they can be used with either device.
+		class CaptureDevice : public Backend::IDevice
+		{
+		private:
+			Backend::IDevice* m_inner;
+			TraceWriter* m_writer;
+			CaptureQueue m_queue;
+
+		public:
+			CaptureDevice(Backend::IDevice* inner, TraceWriter* writer);
+
+			unique_ptr<IResource> CreateResource(const Backend::ResourceDesc& desc, ResourceState initialState) override;
+			unique_ptr<IResource> CreateTransient(const Backend::ResourceDesc& desc, ResourceState initialState, uint32_t firstStep, uint32_t lastStep) override;
+			void CompileTransients() override;
+
+			unique_ptr<Backend::IFence> CreateFence(uint64_t initialValue) override { return m_inner->CreateFence(initialValue); }
+			unique_ptr<IQueryHeap> CreateQueryHeap(Backend::QueryType type, uint32_t count) override;
+			unique_ptr<ICommandList> CreateCommandList(uint32_t frameCount) override;
+			Backend::IQueue* GetQueue() override { return &m_queue; }
+		};
+
+		// Replays a trace against any device. Load walks the trace once and creates its objects;
+		// Run then replays the submissions, writing upload buffer contents in trace order and
+		// keeping as many frames in flight as the captured command lists had.
+		class TraceReplayer
+		{
+		public:
+			struct Stats
+			{
+				uint32_t submits = 0;
+				uint64_t commands = 0;
+				double seconds = 0;
+			};
+
+		private:
+			enum class ObjectKind : uint8_t
+			{
+				Resource,
+				Pipeline,
+				QueryHeap,
+				CommandList
+			};
+
+			struct Object
+			{
+				ObjectKind kind;
+				void* object;
+			};
+
+			struct CommandListSlot
+			{
+				unique_ptr<ICommandList> commandList;
+				vector<uint64_t> frameFences;	//replay fence value that frees each frame's command memory
+				uint32_t frame = 0;	//of the last Reset
+			};
+
+			IO::MappedFile m_file;
+			const uint8_t* m_begin = nullptr;
+			const uint8_t* m_end = nullptr;
+
+			Backend::IDevice* m_device = nullptr;
+			vector<unique_ptr<IResource>> m_resources;
+			vector<unique_ptr<IQueryHeap>> m_queryHeaps;
+			vector<unique_ptr<CommandListSlot>> m_commandLists;
+			vector<Object> m_objects;	//indexed by trace id
+			vector<const uint8_t*> m_work;	//BufferData and Submit records in trace order
+			vector<ICommandList::Transition> m_transitions;
+			unique_ptr<Backend::IFence> m_fence;
+			uint64_t m_fenceValue = 0;
+
+		private:
+			// Null for NoObject; clears valid on an unknown id or one of another kind.
+			template<typename T>
+			T* Resolve(uint32_t id, ObjectKind kind, bool& valid) const;
+			// Decodes one recording onto commandList. Returns false on malformed data.
+			bool Execute(CommandListSlot& slot, const uint8_t* data, const uint8_t* end, ICommandList* commandList, uint64_t& commands);
+
+		public:
+			// The trace stays mapped while the replayer lives.
+			bool Open(const wstring& path);
+			// The data must outlive the replayer.
+			bool Open(const void* data, size_t size);
+
+			// Creates the trace's objects on the device and checks every record. pipelines is indexed by
+			// the slots given at capture; they must stay alive.
+			bool Load(Backend::IDevice* device, const vector<IPipeline*>& pipelines);
+			Stats Run();
+		};
+	}
+}
@@ -0,0 +1,464 @@
+#include "pch.h"
+#include "D3D12Backend.h"
+
+namespace Query {
+	namespace Backend
+	{
+		namespace D3D12
+		{
+			D3D12_RESOURCE_STATES ToD3D12(ResourceState state)
+			{
+				using namespace Rendering;
+				D3D12_RESOURCE_STATES result = D3D12_RESOURCE_STATE_COMMON;
+				if (state & StateVertexAndConstantBuffer) result |= D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+				if (state & StateIndexBuffer) result |= D3D12_RESOURCE_STATE_INDEX_BUFFER;
+				if (state & StateRenderTarget) result |= D3D12_RESOURCE_STATE_RENDER_TARGET;
+				if (state & StateUnorderedAccess) result |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+				if (state & StateDepthWrite) result |= D3D12_RESOURCE_STATE_DEPTH_WRITE;
+				if (state & StateDepthRead) result |= D3D12_RESOURCE_STATE_DEPTH_READ;
+				if (state & StateShaderResource) result |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+				if (state & StateCopyDest) result |= D3D12_RESOURCE_STATE_COPY_DEST;
+				if (state & StateCopySource) result |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+				if (state & StatePredication) result |= D3D12_RESOURCE_STATE_PREDICATION;
+				if (state & StatePresent) result |= D3D12_RESOURCE_STATE_PRESENT;
+				return result;
+			}
+
+			DXGI_FORMAT ToDxgi(Format format)
+			{
+				switch (format)
+				{
+				case Format::R8G8B8A8Unorm: return DXGI_FORMAT_R8G8B8A8_UNORM;
+				case Format::D32Float: return DXGI_FORMAT_D32_FLOAT;
+				default: return DXGI_FORMAT_UNKNOWN;
+				}
+			}
+
+			namespace
+			{
+				D3D12_RESOURCE_DESC ToResourceDesc(const ResourceDesc& desc)
+				{
+					switch (desc.kind)
+					{
+					case ResourceKind::RenderTarget:
+						return CD3DX12_RESOURCE_DESC::Tex2D(ToDxgi(desc.format), desc.width, desc.height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+					case ResourceKind::DepthStencil:
+						return CD3DX12_RESOURCE_DESC::Tex2D(ToDxgi(desc.format), desc.width, desc.height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+					default:
+						return CD3DX12_RESOURCE_DESC::Buffer(desc.size);
+					}
+				}
+
+				// Depth is always cleared to the far plane, so that is the optimized clear value.
+				bool GetClearValue(const ResourceDesc& desc, D3D12_CLEAR_VALUE& clearValue)
+				{
+					if (desc.kind != ResourceKind::DepthStencil)
+					{
+						return false;
+					}
+					clearValue = {};
+					clearValue.Format = ToDxgi(desc.format);
+					clearValue.DepthStencil.Depth = 1.0f;
+					return true;
+				}
+
+				Resource* Cast(IResource* resource)
+				{
+					return static_cast<Resource*>(resource);
+				}
+			}
+
+			Resource::~Resource()
+			{
+				if (m_viewOwner)
+				{
+					m_viewOwner->FreeView(m_desc.kind, m_viewIndex);
+				}
+				m_resource.Reset();
+				if (m_heapManager)
+				{
+					m_heapManager->Free(m_allocation);
+				}
+			}
+
+			void* Resource::Map()
+			{
+				// Nothing is read back through Map except readback buffers.
+				CD3DX12_RANGE readRange(0, 0);
+				void* data = nullptr;
+				m_resource->Map(0, m_desc.heap == HeapKind::Readback ? nullptr : &readRange, &data);
+				return data;
+			}
+
+			void Resource::Unmap()
+			{
+				m_resource->Unmap(0, nullptr);
+			}
+
+			Fence::Fence(ID3D12Device* device, uint64_t initialValue)
+			{
+				device->CreateFence(initialValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
+				m_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+			}
+
+			Fence::~Fence()
+			{
+				CloseHandle(m_event);
+			}
+
+			void Fence::Wait(uint64_t value)
+			{
+				if (m_fence->GetCompletedValue() < value)
+				{
+					m_fence->SetEventOnCompletion(value, m_event);
+					WaitForSingleObjectEx(m_event, INFINITE, FALSE);
+				}
+			}
+
+			QueryHeap::QueryHeap(ID3D12Device* device, QueryType type, uint32_t count) :
+				m_type(type), m_count(count)
+			{
+				D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+				queryHeapDesc.Count = count;
+				queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_OCCLUSION;
+				device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_heap));
+			}
+
+			D3D12_QUERY_TYPE QueryHeap::GetQueryType() const
+			{
+				return m_type == QueryType::BinaryOcclusion ? D3D12_QUERY_TYPE_BINARY_OCCLUSION : D3D12_QUERY_TYPE_OCCLUSION;
+			}
+
+			CommandList::CommandList(ID3D12Device* device, uint32_t frameCount, const Memory::TransientResourcePool* transientResources) :
+				m_transientResources(transientResources)
+			{
+				m_allocators.resize(frameCount);
+				for (auto& allocator : m_allocators)
+				{
+					device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator));
+				}
+				device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_allocators[0].Get(), nullptr, IID_PPV_ARGS(&m_commandList));
+				m_commandList->Close();
+			}
+
+			void CommandList::Reset(uint32_t frame)
+			{
+				m_allocators[frame]->Reset();
+				m_commandList->Reset(m_allocators[frame].Get(), nullptr);
+				m_rootSignature = nullptr;
+				m_topologySet = false;
+			}
+
+			void CommandList::Close()
+			{
+				m_commandList->Close();
+			}
+
+			void CommandList::BeginPass(uint32_t step, const char*)
+			{
+				if (m_transientResources)
+				{
+					m_transientResources->AliasingBarriers(m_commandList.Get(), step);
+				}
+			}
+
+			void CommandList::Barriers(const Transition* transitions, uint32_t count)
+			{
+				m_barriers.clear();
+				for (uint32_t i = 0; i < count; i++)
+				{
+					m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+						Cast(transitions[i].resource)->Get(), ToD3D12(transitions[i].before), ToD3D12(transitions[i].after)));
+				}
+				m_commandList->ResourceBarrier(static_cast<UINT>(m_barriers.size()), m_barriers.data());
+			}
+
+			void CommandList::ClearRenderTarget(IResource* target, const float color[4])
+			{
+				m_commandList->ClearRenderTargetView(Cast(target)->GetView(), color, 0, nullptr);
+			}
+
+			void CommandList::ClearDepth(IResource* target, float depth)
+			{
+				m_commandList->ClearDepthStencilView(Cast(target)->GetView(), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+			}
+
+			void CommandList::SetRenderTargets(IResource* color, IResource* depth)
+			{
+				D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = color ? Cast(color)->GetView() : D3D12_CPU_DESCRIPTOR_HANDLE{};
+				D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = depth ? Cast(depth)->GetView() : D3D12_CPU_DESCRIPTOR_HANDLE{};
+				m_commandList->OMSetRenderTargets(color ? 1 : 0, color ? &rtvHandle : nullptr, FALSE, depth ? &dsvHandle : nullptr);
+			}
+
+			void CommandList::SetViewport(uint32_t width, uint32_t height)
+			{
+				D3D12_VIEWPORT viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.f, 1.f };
+				D3D12_RECT scissorRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+				m_commandList->RSSetViewports(1, &viewport);
+				m_commandList->RSSetScissorRects(1, &scissorRect);
+			}
+
+			void CommandList::SetPipeline(IPipeline* pipeline)
+			{
+				auto d3d12Pipeline = static_cast<Pipeline*>(pipeline);
+				if (d3d12Pipeline->GetRootSignature() != m_rootSignature)
+				{
+					m_rootSignature = d3d12Pipeline->GetRootSignature();
+					m_commandList->SetGraphicsRootSignature(m_rootSignature);
+				}
+				m_commandList->SetPipelineState(d3d12Pipeline->GetPipelineState());
+			}
+
+			void CommandList::SetVertexBuffer(IResource* buffer, uint32_t stride, uint32_t size)
+			{
+				D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+				vertexBufferView.BufferLocation = Cast(buffer)->Get()->GetGPUVirtualAddress();
+				vertexBufferView.SizeInBytes = size;
+				vertexBufferView.StrideInBytes = stride;
+				m_commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+			}
+
+			void CommandList::SetConstantBuffer(uint32_t slot, IResource* buffer, uint64_t offset)
+			{
+				m_commandList->SetGraphicsRootConstantBufferView(slot, Cast(buffer)->Get()->GetGPUVirtualAddress() + offset);
+			}
+
+			void CommandList::Draw(uint32_t vertexCount, uint32_t firstVertex)
+			{
+				if (!m_topologySet)
+				{
+					m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+					m_topologySet = true;
+				}
+				m_commandList->DrawInstanced(vertexCount, 1, firstVertex, 0);
+			}
+
+			void CommandList::BeginQuery(IQueryHeap* heap, uint32_t index)
+			{
+				auto queryHeap = static_cast<QueryHeap*>(heap);
+				m_commandList->BeginQuery(queryHeap->Get(), queryHeap->GetQueryType(), index);
+			}
+
+			void CommandList::EndQuery(IQueryHeap* heap, uint32_t index)
+			{
+				auto queryHeap = static_cast<QueryHeap*>(heap);
+				m_commandList->EndQuery(queryHeap->Get(), queryHeap->GetQueryType(), index);
+			}
+
+			void CommandList::ResolveQuery(IQueryHeap* heap, uint32_t index, uint32_t count, IResource* destination, uint64_t offset)
+			{
+				auto queryHeap = static_cast<QueryHeap*>(heap);
+				m_commandList->ResolveQueryData(queryHeap->Get(), queryHeap->GetQueryType(), index, count, Cast(destination)->Get(), offset);
+			}
+
+			void CommandList::SetPredication(IResource* buffer, uint64_t offset)
+			{
+				m_commandList->SetPredication(buffer ? Cast(buffer)->Get() : nullptr, offset, D3D12_PREDICATION_OP_EQUAL_ZERO);
+			}
+
+			void CommandList::CopyBuffer(IResource* destination, uint64_t destinationOffset, IResource* source, uint64_t sourceOffset, uint64_t size)
+			{
+				m_commandList->CopyBufferRegion(Cast(destination)->Get(), destinationOffset, Cast(source)->Get(), sourceOffset, size);
+			}
+
+			void Queue::Submit(ICommandList* commandList)
+			{
+				ID3D12CommandList* ppCommandLists[] = { static_cast<CommandList*>(commandList)->Get() };
+				m_queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+			}
+
+			void Queue::Signal(IFence* fence, uint64_t value)
+			{
+				m_queue->Signal(static_cast<Fence*>(fence)->Get(), value);
+			}
+
+			void Device::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, Memory::HeapManager* heapManager, Memory::TransientResourcePool* transientResources)
+			{
+				m_device = device;
+				m_queue.Initialize(queue);
+				m_heapManager = heapManager;
+				m_transientResources = transientResources;
+
+				//RTV
+				D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+				rtvHeapDesc.NumDescriptors = MaxViews;
+				rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+				rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+				m_device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap));
+
+				//DSV
+				D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
+				dsvHeapDesc.NumDescriptors = MaxViews;
+				dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+				dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+				m_device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_dsvHeap));
+
+				m_rtvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+				m_dsvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+			}
+
+			bool Device::CreateView(Resource* resource)
+			{
+				const ResourceKind kind = resource->GetDesc().kind;
+				if (kind != ResourceKind::RenderTarget && kind != ResourceKind::DepthStencil)
+				{
+					return true;
+				}
+
+				lock_guard<mutex> lock(m_mutex);
+				const bool renderTarget = kind == ResourceKind::RenderTarget;
+				vector<UINT>& freeViews = renderTarget ? m_freeRtvs : m_freeDsvs;
+				UINT& count = renderTarget ? m_rtvCount : m_dsvCount;
+				UINT index;
+				if (!freeViews.empty())
+				{
+					index = freeViews.back();
+					freeViews.pop_back();
+				}
+				else if (count < MaxViews)
+				{
+					index = count++;
+				}
+				else
+				{
+					return false;
+				}
+
+				if (renderTarget)
+				{
+					CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), index, m_rtvDescriptorSize);
+					m_device->CreateRenderTargetView(resource->Get(), nullptr, rtvHandle);
+					resource->SetView(rtvHandle, this, index);
+				}
+				else
+				{
+					D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
+					depthStencilDesc.Format = ToDxgi(resource->GetDesc().format);
+					depthStencilDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+					depthStencilDesc.Flags = D3D12_DSV_FLAG_NONE;
+
+					CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart(), index, m_dsvDescriptorSize);
+					m_device->CreateDepthStencilView(resource->Get(), &depthStencilDesc, dsvHandle);
+					resource->SetView(dsvHandle, this, index);
+				}
+				return true;
+			}
+
+			void Device::FreeView(ResourceKind kind, UINT index)
+			{
+				// Views are copied into command lists when recorded, so a slot can be reused at once.
+				lock_guard<mutex> lock(m_mutex);
+				(kind == ResourceKind::RenderTarget ? m_freeRtvs : m_freeDsvs).push_back(index);
+			}
+
+			unique_ptr<SwapChain> Device::WrapSwapChain(IDXGISwapChain3* swapChain, uint32_t width, uint32_t height)
+			{
+				DXGI_SWAP_CHAIN_DESC1 swapChainDesc;
+				swapChain->GetDesc1(&swapChainDesc);
+
+				vector<unique_ptr<Resource>> buffers;
+				for (UINT i = 0; i < swapChainDesc.BufferCount; i++)
+				{
+					unique_ptr<Resource> buffer(new Resource(ResourceDesc::Texture(ResourceKind::RenderTarget, width, height, Format::R8G8B8A8Unorm)));
+					if (FAILED(swapChain->GetBuffer(i, IID_PPV_ARGS(buffer->GetAddressOf()))) || !CreateView(buffer.get()))
+					{
+						return nullptr;
+					}
+					buffers.push_back(move(buffer));
+				}
+				return unique_ptr<SwapChain>(new SwapChain(swapChain, move(buffers)));
+			}
+
+			unique_ptr<IResource> Device::CreateResource(const ResourceDesc& desc, ResourceState initialState)
+			{
+				D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_DEFAULT;
+				D3D12_RESOURCE_STATES state = ToD3D12(initialState);
+				if (desc.heap == HeapKind::Upload)
+				{
+					heapType = D3D12_HEAP_TYPE_UPLOAD;
+					state = D3D12_RESOURCE_STATE_GENERIC_READ;
+				}
+				else if (desc.heap == HeapKind::Readback)
+				{
+					heapType = D3D12_HEAP_TYPE_READBACK;
+					state = D3D12_RESOURCE_STATE_COPY_DEST;
+				}
+
+				D3D12_RESOURCE_DESC resourceDesc = ToResourceDesc(desc);
+				D3D12_CLEAR_VALUE clearValue;
+				bool hasClearValue = GetClearValue(desc, clearValue);
+
+				unique_ptr<Resource> resource(new Resource(desc, m_heapManager));
+				HRESULT hr = m_heapManager->CreateResource(
+					heapType,
+					&resourceDesc,
+					state,
+					hasClearValue ? &clearValue : nullptr,
+					resource->GetAllocation(),
+					IID_PPV_ARGS(resource->GetAddressOf()));
+				if (FAILED(hr))
+				{
+					// The allocation stays empty, so destroying the resource frees nothing.
+					return nullptr;
+				}
+				if (!CreateView(resource.get()))
+				{
+					return nullptr;
+				}
+				return move(resource);
+			}
+
+			unique_ptr<IResource> Device::CreateTransient(const ResourceDesc& desc, ResourceState initialState, uint32_t firstStep, uint32_t lastStep)
+			{
+				D3D12_RESOURCE_DESC resourceDesc = ToResourceDesc(desc);
+				D3D12_CLEAR_VALUE clearValue;
+				bool hasClearValue = GetClearValue(desc, clearValue);
+
+				unique_ptr<Resource> resource(new Resource(desc));
+				UINT id = m_transientResources->Declare(
+					resourceDesc,
+					ToD3D12(initialState),
+					hasClearValue ? &clearValue : nullptr,
+					firstStep, lastStep);
+
+				lock_guard<mutex> lock(m_mutex);
+				m_pendingTransients.push_back({ resource.get(), id });
+				return move(resource);
+			}
+
+			void Device::CompileTransients()
+			{
+				m_transientResources->Compile();
+
+				vector<pair<Resource*, UINT>> pending;
+				{
+					lock_guard<mutex> lock(m_mutex);
+					pending.swap(m_pendingTransients);
+				}
+				for (auto& transient : pending)
+				{
+					transient.first->SetResource(m_transientResources->GetResource(transient.second));
+					if (!CreateView(transient.first))
+					{
+						OutputDebugStringA("D3D12 backend: no view slot left for a transient target\n");
+					}
+				}
+			}
+
+			unique_ptr<IFence> Device::CreateFence(uint64_t initialValue)
+			{
+				return unique_ptr<IFence>(new Fence(m_device.Get(), initialValue));
+			}
+
+			unique_ptr<IQueryHeap> Device::CreateQueryHeap(QueryType type, uint32_t count)
+			{
+				return unique_ptr<IQueryHeap>(new QueryHeap(m_device.Get(), type, count));
+			}
+
+			unique_ptr<ICommandList> Device::CreateCommandList(uint32_t frameCount)
+			{
+				return unique_ptr<ICommandList>(new CommandList(m_device.Get(), frameCount, m_transientResources));
+			}
+		}
+	}
+}
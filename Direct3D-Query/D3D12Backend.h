@@ -0,0 +1,202 @@
+#pragma once
+#include "Backend.h"
+#include "HeapManager.h"
+#include "TransientResourcePool.h"
+
+namespace Query {
+	namespace Backend
+	{
+		// The backend interfaces over D3D12. Resources are placed through the HeapManager, transients
+		// through the TransientResourcePool; render target and depth views come from small CPU-only
+		// descriptor heaps owned by the device. Constant buffers are bound as root CBVs, so pipelines
+		// carry the root signature they were created with.
+		namespace D3D12
+		{
+			using Microsoft::WRL::ComPtr;
+
+			D3D12_RESOURCE_STATES ToD3D12(ResourceState state);
+			DXGI_FORMAT ToDxgi(Format format);
+
+			class Device;
+
+			class Resource : public IResource
+			{
+			private:
+				ResourceDesc m_desc;
+				ComPtr<ID3D12Resource> m_resource;
+				Memory::HeapManager* m_heapManager = nullptr;	//null for transients and swap chain buffers
+				Memory::HeapManager::Allocation m_allocation;
+				D3D12_CPU_DESCRIPTOR_HANDLE m_view = {};	//RTV or DSV
+				Device* m_viewOwner = nullptr;	//returns the view slot when the resource goes away
+				UINT m_viewIndex = 0;
+
+			public:
+				Resource(const ResourceDesc& desc, Memory::HeapManager* heapManager = nullptr) : m_desc(desc), m_heapManager(heapManager) {}
+				~Resource();
+
+				const ResourceDesc& GetDesc() const override { return m_desc; }
+				void* Map() override;
+				void Unmap() override;
+
+				ID3D12Resource* Get() const { return m_resource.Get(); }
+				ID3D12Resource** GetAddressOf() { return m_resource.ReleaseAndGetAddressOf(); }
+				void SetResource(ID3D12Resource* resource) { m_resource = resource; }
+				Memory::HeapManager::Allocation* GetAllocation() { return &m_allocation; }
+				D3D12_CPU_DESCRIPTOR_HANDLE GetView() const { return m_view; }
+				void SetView(D3D12_CPU_DESCRIPTOR_HANDLE view, Device* owner, UINT index) { m_view = view; m_viewOwner = owner; m_viewIndex = index; }
+			};
+
+			class Pipeline : public IPipeline
+			{
+			private:
+				ComPtr<ID3D12PipelineState> m_pipelineState;
+				ComPtr<ID3D12RootSignature> m_rootSignature;
+
+			public:
+				Pipeline(ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature) :
+					m_pipelineState(pipelineState), m_rootSignature(rootSignature) {}
+
+				ID3D12PipelineState* GetPipelineState() const { return m_pipelineState.Get(); }
+				ID3D12RootSignature* GetRootSignature() const { return m_rootSignature.Get(); }
+			};
+
+			class Fence : public IFence
+			{
+			private:
+				ComPtr<ID3D12Fence> m_fence;
+				HANDLE m_event;
+
+			public:
+				Fence(ID3D12Device* device, uint64_t initialValue);
+				~Fence();
+
+				uint64_t GetCompletedValue() const override { return m_fence->GetCompletedValue(); }
+				void Wait(uint64_t value) override;
+				ID3D12Fence* Get() const { return m_fence.Get(); }
+			};
+
+			class QueryHeap : public IQueryHeap
+			{
+			private:
+				ComPtr<ID3D12QueryHeap> m_heap;
+				QueryType m_type;
+				uint32_t m_count;
+
+			public:
+				QueryHeap(ID3D12Device* device, QueryType type, uint32_t count);
+
+				QueryType GetType() const override { return m_type; }
+				uint32_t GetCount() const override { return m_count; }
+				ID3D12QueryHeap* Get() const { return m_heap.Get(); }
+				D3D12_QUERY_TYPE GetQueryType() const;
+			};
+
+			class CommandList : public ICommandList
+			{
+			private:
+				vector<ComPtr<ID3D12CommandAllocator>> m_allocators;
+				ComPtr<ID3D12GraphicsCommandList> m_commandList;
+				const Memory::TransientResourcePool* m_transientResources;
+				ID3D12RootSignature* m_rootSignature = nullptr;
+				bool m_topologySet = false;
+				vector<D3D12_RESOURCE_BARRIER> m_barriers;
+
+			public:
+				// Graph step indices are used as pass indices of the transient pool.
+				CommandList(ID3D12Device* device, uint32_t frameCount, const Memory::TransientResourcePool* transientResources);
+
+				ID3D12GraphicsCommandList* Get() const { return m_commandList.Get(); }
+
+				void Reset(uint32_t frame) override;
+				void Close() override;
+
+				void BeginPass(uint32_t step, const char* name) override;
+				void EndPass(uint32_t step) override {}
+				void Barriers(const Transition* transitions, uint32_t count) override;
+
+				void ClearRenderTarget(IResource* target, const float color[4]) override;
+				void ClearDepth(IResource* target, float depth) override;
+				void SetRenderTargets(IResource* color, IResource* depth) override;
+				void SetViewport(uint32_t width, uint32_t height) override;
+
+				void SetPipeline(IPipeline* pipeline) override;
+				void SetVertexBuffer(IResource* buffer, uint32_t stride, uint32_t size) override;
+				void SetConstantBuffer(uint32_t slot, IResource* buffer, uint64_t offset) override;
+				void Draw(uint32_t vertexCount, uint32_t firstVertex) override;
+
+				void BeginQuery(IQueryHeap* heap, uint32_t index) override;
+				void EndQuery(IQueryHeap* heap, uint32_t index) override;
+				void ResolveQuery(IQueryHeap* heap, uint32_t index, uint32_t count, IResource* destination, uint64_t offset) override;
+				void SetPredication(IResource* buffer, uint64_t offset) override;
+
+				void CopyBuffer(IResource* destination, uint64_t destinationOffset, IResource* source, uint64_t sourceOffset, uint64_t size) override;
+			};
+
+			class Queue : public IQueue
+			{
+			private:
+				ComPtr<ID3D12CommandQueue> m_queue;
+
+			public:
+				void Initialize(ID3D12CommandQueue* queue) { m_queue = queue; }
+				void Submit(ICommandList* commandList) override;
+				void Signal(IFence* fence, uint64_t value) override;
+			};
+
+			class SwapChain : public ISwapChain
+			{
+			private:
+				ComPtr<IDXGISwapChain3> m_swapChain;
+				vector<unique_ptr<Resource>> m_buffers;
+
+			public:
+				SwapChain(IDXGISwapChain3* swapChain, vector<unique_ptr<Resource>> buffers) :
+					m_swapChain(swapChain), m_buffers(move(buffers)) {}
+
+				uint32_t GetBufferCount() const override { return static_cast<uint32_t>(m_buffers.size()); }
+				uint32_t GetCurrentIndex() const override { return m_swapChain->GetCurrentBackBufferIndex(); }
+				IResource* GetBuffer(uint32_t index) override { return m_buffers[index].get(); }
+				void Present() override { m_swapChain->Present(1, 0); }
+			};
+
+			class Device : public IDevice
+			{
+			private:
+				// Slots of destroyed targets are reused, so only the targets alive at once count.
+				static const UINT MaxViews = 16;
+
+				ComPtr<ID3D12Device> m_device;
+				Memory::HeapManager* m_heapManager = nullptr;
+				Memory::TransientResourcePool* m_transientResources = nullptr;
+				Queue m_queue;
+
+				ComPtr<ID3D12DescriptorHeap> m_rtvHeap, m_dsvHeap;
+				UINT m_rtvCount = 0, m_dsvCount = 0;
+				vector<UINT> m_freeRtvs, m_freeDsvs;
+				UINT m_rtvDescriptorSize = 0, m_dsvDescriptorSize = 0;
+
+				vector<pair<Resource*, UINT>> m_pendingTransients;
+				mutex m_mutex;
+
+			private:
+				// False when every view slot of the resource's kind is taken.
+				bool CreateView(Resource* resource);
+
+			public:
+				void Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, Memory::HeapManager* heapManager, Memory::TransientResourcePool* transientResources);
+				void FreeView(ResourceKind kind, UINT index);
+				// Null when a buffer or its view cannot be obtained.
+				unique_ptr<SwapChain> WrapSwapChain(IDXGISwapChain3* swapChain, uint32_t width, uint32_t height);
+
+				unique_ptr<IResource> CreateResource(const ResourceDesc& desc, ResourceState initialState) override;
+				unique_ptr<IResource> CreateTransient(const ResourceDesc& desc, ResourceState initialState, uint32_t firstStep, uint32_t lastStep) override;
+				void CompileTransients() override;
+
+				unique_ptr<IFence> CreateFence(uint64_t initialValue) override;
+				unique_ptr<IQueryHeap> CreateQueryHeap(QueryType type, uint32_t count) override;
+				unique_ptr<ICommandList> CreateCommandList(uint32_t frameCount) override;
+				IQueue* GetQueue() override { return &m_queue; }
+			};
+		}
+	}
+}
@@ -1,52 +1,108 @@
 #include "pch.h"
 #include "D3D12Query.h"
+#include "Hash.h"
+#include "RootSignatureLayout.h"
 
 namespace Query {
 	namespace D3D12Query
 	{
-		D3D12Query::D3D12Query():
-			m_frameIndex(0),
-			m_rtvDescriptorSize(0),
-			m_cbvSrvDescriptorSize(0),
-			m_constantBufferData{},
-			m_fenceValues{}
+		namespace
+		{
+			namespace Layout = Pipelines::RootSignatureLayout;
+
+			//ֱԸ󶨣ҪCBV
+			constexpr Layout::Desc<1, 0> SceneRootSignature =
+			{
+				Layout::AllowInputAssemblerInputLayout |
+				Layout::DenyHullShaderRootAccess |
+				Layout::DenyDomainShaderRootAccess |
+				Layout::DenyGeometryShaderRootAccess |
+				Layout::DenyPixelShaderRootAccess,
+				{ Layout::Cbv(0, 0, Layout::DataStatic, Layout::Visibility::Vertex) },
+				{}
+			};
+			static_assert(Layout::IsValid(SceneRootSignature), "descriptor table outside the ranges");
+
+			//汾лǱڳ
+			constexpr auto SceneRootSignature_1_1 = Layout::Serialize<Layout::SerializedSize(SceneRootSignature, Layout::Version::V1_1)>(SceneRootSignature, Layout::Version::V1_1);
+			constexpr auto SceneRootSignature_1_0 = Layout::Serialize<Layout::SerializedSize(SceneRootSignature, Layout::Version::V1_0)>(SceneRootSignature, Layout::Version::V1_0);
+
+			//d3dx12ʱлͬһݲֻ֣ԤɵĶƱܾʱʹ
+			template<typename Desc>
+			ComPtr<ID3DBlob> SerializeRootSignature(const Desc& desc, D3D_ROOT_SIGNATURE_VERSION version)
+			{
+				const Layout::D3D12Desc<Desc> rootSignatureDesc(desc);
+				ComPtr<ID3DBlob> signature;
+				ComPtr<ID3DBlob> error;
+				D3DX12SerializeVersionedRootSignature(&rootSignatureDesc.desc, version, &signature, &error);
+				return signature;
+			}
+		}
+
+		D3D12Query::D3D12Query()
 		{
 		}
 
 		void D3D12Query::Initialize(HWND hWnd, UINT width, UINT height)
 		{
 			m_hWnd = hWnd; m_width = width; m_height = height;
-			m_aspectRatio = static_cast<float>(m_width) / static_cast<float>(m_height);
 
-			m_viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height) ,0.f, 1.f};
-			m_scissorRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
-
-			LoadPipeline();
-			LoadAssets();
+			m_threadPool.Initialize();
+
+			//ϵִУɫ롢ǩԴȴ
+			using Threading::TaskGraph;
+			TaskGraph startup;
+			UINT device = startup.AddTask("Device", [this]() { CreateDevice(); });
+			UINT shaders = startup.AddTask("Shaders", [this]() { LoadShaders(); });
+			//򴰿ڷϢڴ߳ϴ
+			UINT swapChain = startup.AddTask("SwapChain", [this]() { CreateSwapChain(); }, TaskGraph::Affinity::Caller);
+			UINT rootSignature = startup.AddTask("RootSignature", [this]() { CreateRootSignature(); });
+			UINT pipelines = startup.AddTask("PipelineStates", [this]() { CreatePipelineStates(); });
+			UINT renderer = startup.AddTask("Renderer", [this]() { CreateRenderer(); });
+
+			startup.DependsOn(swapChain, device);
+			startup.DependsOn(rootSignature, device);
+			startup.DependsOn(pipelines, rootSignature);
+			startup.DependsOn(pipelines, shaders);
+			startup.DependsOn(renderer, swapChain);
+
+			startup.Run(m_threadPool);
+			OutputDebugStringA(startup.Report().c_str());
+
+			m_scenePipeline.reset(new Backend::D3D12::Pipeline(m_pipelineState.Get(), m_rootSignature.Get()));
+			m_renderer.SetPipelines(m_scenePipeline.get(), nullptr);
 		}
 
-		void D3D12Query::LoadPipeline()
+		void D3D12Query::CreateDevice()
 		{
-			UINT dxgiFlag = 0;
 #if defined(_DEBUG)
 			ComPtr<ID3D12Debug> debugController;
 			D3D12GetDebugInterface(IID_PPV_ARGS(&debugController));
 			debugController->EnableDebugLayer();
-			dxgiFlag = DXGI_CREATE_FACTORY_DEBUG;
 #endif
 
 			D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&m_device));
+			m_heapManager.Initialize(m_device.Get());
+			m_transientResources.Initialize(m_device.Get(), &m_heapManager);
+
 			D3D12_COMMAND_QUEUE_DESC queueDesc = {};
 			queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 			m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue));
+		}
 
+		void D3D12Query::CreateSwapChain()
+		{
+			UINT dxgiFlag = 0;
+#if defined(_DEBUG)
+			dxgiFlag = DXGI_CREATE_FACTORY_DEBUG;
+#endif
 			ComPtr<IDXGIFactory6> dxgiFactory;
 			CreateDXGIFactory2(dxgiFlag, IID_PPV_ARGS(&dxgiFactory));
 
 			DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
 			swapChainDesc.Width = m_width;
 			swapChainDesc.Height = m_height;
-			swapChainDesc.BufferCount = FrameCount;
+			swapChainDesc.BufferCount = Rendering::QueryRenderer::FrameCount;
 			swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 			swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 			swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
@@ -56,442 +112,160 @@ namespace Query {
 			ComPtr<IDXGISwapChain1> swapChain;
 			dxgiFactory->CreateSwapChainForHwnd(m_commandQueue.Get(), m_hWnd, &swapChainDesc, nullptr, nullptr, &swapChain);
 			swapChain.As(&m_swapChain);
-			m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
 			dxgiFactory->MakeWindowAssociation(m_hWnd, DXGI_MWA_NO_ALT_ENTER);
-
-			//
-			{
-				//RTV
-				D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-				rtvHeapDesc.NumDescriptors = FrameCount;
-				rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-				rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-				m_device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap));
-
-				//DSV
-				D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
-				dsvHeapDesc.NumDescriptors = 1;
-				dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-				dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-				m_device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_dsvHeap));
-
-				//CBV
-				D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
-				cbvHeapDesc.NumDescriptors = CbvCountPerFrame * FrameCount;
-				cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-				cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-				m_device->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&m_cbvHeap));
-
-				//ѯ(Query Heap)
-				D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
-				queryHeapDesc.Count = 1;
-				queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_OCCLUSION;
-				m_device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_queryHeap));
-
-				m_rtvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-				m_cbvSrvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-			}
-
-			//֡Դ
-			{
-				CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart());
-
-				//ÿһ֡ҪһRTVһCommand Allocator
-				for (UINT i = 0; i < FrameCount; i++)
-				{
-					m_swapChain->GetBuffer(i, IID_PPV_ARGS(&m_renderTargets[i]));
-					m_device->CreateRenderTargetView(m_renderTargets[i].Get(), nullptr, rtvHandle);
-
-					rtvHandle.Offset(1, m_rtvDescriptorSize);
-					m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocators[i]));
-				}
-			}
 		}
-		void D3D12Query::LoadAssets()
-		{
-			//ǩ
-			{
-				D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
-				
-				// This is the highest version the sample supports. If CheckFeatureSupport succeeds, the HighestVersion returned will not be greater than this.
-				featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
-
-				if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
-				{
-					featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
-				}
 
-				CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
-				CD3DX12_ROOT_PARAMETER1 rootParameters[1];
-
-				ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-				rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
-
-				D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
-					D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
-					D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
-					D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-					D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
-					D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
-
-				CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-				rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, rootSignatureFlags);
-
-				ComPtr<ID3DBlob> signature;
-				ComPtr<ID3DBlob> error;
-				D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, &error);
+		//ǩڱɣʱл
+		void D3D12Query::CreateRootSignature()
+		{
+			D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
 
-				m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature));
-			}
+			// This is the highest version the sample supports. If CheckFeatureSupport succeeds, the HighestVersion returned will not be greater than this.
+			featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
 
-			//ˮ״̬ͼɫShader
+			if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
 			{
-				ComPtr<ID3DBlob> vertexShader;
-				ComPtr<ID3DBlob> pixelShader;
-
-#if defined(_DEBUG)
-				// Enable better shader debugging with the graphics debugging tools.
-				UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-				UINT compileFlags = 0;
-#endif
-				auto filename = Utility::GetModulePath().append(L"Shaders.hlsl");
-				D3DCompileFromFile(filename.c_str(), nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, nullptr);
-				D3DCompileFromFile(filename.c_str(), nullptr, nullptr, "PSMain", "ps_5_0", compileFlags, 0, &pixelShader, nullptr);
-
-				//벼
-				D3D12_INPUT_ELEMENT_DESC inputElementDescs[]=
-				{
-					{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-					{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-				};
-
-				CD3DX12_BLEND_DESC blendDesc(D3D12_DEFAULT);
-				blendDesc.RenderTarget[0] =
-				{
-					TRUE, FALSE,
-					D3D12_BLEND_SRC_ALPHA, D3D12_BLEND_INV_SRC_ALPHA, D3D12_BLEND_OP_ADD,
-					D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
-					D3D12_LOGIC_OP_NOOP,
-					D3D12_COLOR_WRITE_ENABLE_ALL,
-				};
-
-				//PSO
-				D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
-				psoDesc.InputLayout = { inputElementDescs,_countof(inputElementDescs) };
-				psoDesc.pRootSignature = m_rootSignature.Get();
-				psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
-				psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
-				psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-				psoDesc.BlendState = blendDesc;
-				psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-				psoDesc.SampleMask = UINT_MAX;
-				psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-				psoDesc.NumRenderTargets = 1;
-				psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-				psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-				psoDesc.SampleDesc.Count = 1;
-
-				m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState));
-
-				//ֹɫдд
-				psoDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0;
-				psoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
-				m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_queryState));
+				featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
 			}
 
-			//Command List
-			m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[m_frameIndex].Get(), m_pipelineState.Get(), IID_PPV_ARGS(&m_commandList));
-
-			ComPtr<ID3D12Resource> vertexBufferUpload;
-			{
-				Vertex quadVertices[] =
-				{
-					// Far quad - in practice this would be a complex geometry.
-					{ { -0.25f, -0.25f * m_aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
-					{ { -0.25f, 0.25f * m_aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
-					{ { 0.25f, -0.25f * m_aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
-					{ { 0.25f, 0.25f * m_aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
-
-					// Near quad.
-					{ { -0.5f, -0.35f * m_aspectRatio, 0.0f }, { 1.0f, 0.0f, 0.0f, 0.65f } },
-					{ { -0.5f, 0.35f * m_aspectRatio, 0.0f }, { 1.0f, 0.0f, 0.0f, 0.65f } },
-					{ { 0.5f, -0.35f * m_aspectRatio, 0.0f }, { 1.0f, 1.0f, 0.0f, 0.65f } },
-					{ { 0.5f, 0.35f * m_aspectRatio, 0.0f }, { 1.0f, 1.0f, 0.0f, 0.65f } },
-
-					// Far quad bounding box used for occlusion query (offset slightly to avoid z-fighting).
-					{ { -0.25f, -0.25f * m_aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
-					{ { -0.25f, 0.25f * m_aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
-					{ { 0.25f, -0.25f * m_aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
-					{ { 0.25f, 0.25f * m_aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
-				};
-
-				const UINT vertexBufferSize = sizeof(quadVertices);
-
-				m_device->CreateCommittedResource(
-					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-					D3D12_HEAP_FLAG_NONE,
-					&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-					D3D12_RESOURCE_STATE_COPY_DEST,
-					nullptr,
-					IID_PPV_ARGS(&m_vertexBuffer));
-
-				m_device->CreateCommittedResource(
-					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-					D3D12_HEAP_FLAG_NONE,
-					&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-					D3D12_RESOURCE_STATE_GENERIC_READ,
-					nullptr,
-					IID_PPV_ARGS(&vertexBufferUpload));
-
-				D3D12_SUBRESOURCE_DATA vertexData = {};
-				vertexData.pData = reinterpret_cast<UINT8*>(quadVertices);
-				vertexData.RowPitch = vertexBufferSize;
-				vertexData.SlicePitch = vertexData.RowPitch;
-
-				UpdateSubresources<1>(
-					m_commandList.Get(), 
-					m_vertexBuffer.Get(), 
-					vertexBufferUpload.Get(), 
-					0, 0, 1, 
-					&vertexData);
-
-				m_commandList->ResourceBarrier(1, 
-					&CD3DX12_RESOURCE_BARRIER::Transition(
-						m_vertexBuffer.Get(), 
-						D3D12_RESOURCE_STATE_COPY_DEST, 
-						D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER)
-				);
-
-				m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-				m_vertexBufferView.SizeInBytes = sizeof(quadVertices);
-				m_vertexBufferView.StrideInBytes = sizeof(Vertex);
-			}
+			const bool version_1_1 = featureData.HighestVersion >= D3D_ROOT_SIGNATURE_VERSION_1_1;
+			const void* blob = version_1_1 ? SceneRootSignature_1_1.data() : SceneRootSignature_1_0.data();
+			size_t blobSize = version_1_1 ? SceneRootSignature_1_1.size() : SceneRootSignature_1_0.size();
 
-			//Constant Buffer
+			//ʱܾԤɵĶʱ˻صd3dx12лͬһݲ
+			ComPtr<ID3DBlob> signature;
+			if (FAILED(m_device->CreateRootSignature(0, blob, blobSize, IID_PPV_ARGS(&m_rootSignature))))
 			{
-				m_device->CreateCommittedResource(
-					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-					D3D12_HEAP_FLAG_NONE,
-					&CD3DX12_RESOURCE_DESC::Buffer(FrameCount * sizeof(m_constantBufferData)),
-					D3D12_RESOURCE_STATE_GENERIC_READ,
-					nullptr,
-					IID_PPV_ARGS(&m_constantBuffer));
-				
-				CD3DX12_RANGE readRange(0, 0);
-				m_constantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pCbvDataBegin));
-				ZeroMemory(m_pCbvDataBegin, FrameCount * sizeof(m_constantBufferData));
-
-				CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(m_cbvHeap->GetCPUDescriptorHandleForHeapStart());
-				D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = m_constantBuffer->GetGPUVirtualAddress();
-
-				D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-				cbvDesc.SizeInBytes = sizeof(SceneConstantBuffer);
-
-				for (UINT n = 0; n < FrameCount; n++)
-				{
-					cbvDesc.BufferLocation = gpuAddress;
-					m_device->CreateConstantBufferView(&cbvDesc, cpuHandle);
-
-					cpuHandle.Offset(m_cbvSrvDescriptorSize);
-					gpuAddress += cbvDesc.SizeInBytes;
-					cbvDesc.BufferLocation = gpuAddress;
-
-					m_device->CreateConstantBufferView(&cbvDesc, cpuHandle);
-
-					cpuHandle.Offset(m_cbvSrvDescriptorSize);
-					gpuAddress += cbvDesc.SizeInBytes;
-				}
+				//ԤɵĶʱлĽӦֽͬTests/RootSignatureLayoutTest.cppܾ˵ֻУд
+				OutputDebugStringA("Prebuilt root signature rejected, serializing at runtime\n");
+				assert(!"prebuilt root signature rejected");
+				signature = SerializeRootSignature(SceneRootSignature, featureData.HighestVersion);
+				blob = signature->GetBufferPointer();
+				blobSize = signature->GetBufferSize();
+				m_device->CreateRootSignature(0, blob, blobSize, IID_PPV_ARGS(&m_rootSignature));
 			}
+			//лĸǩݾPSOĲ
+			m_rootSignatureKey = Hash::Compute(blob, blobSize);
+		}
 
-			//depth stencil view(DSV)
-			{
-				D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
-				depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
-				depthStencilDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-				depthStencilDesc.Flags = D3D12_DSV_FLAG_NONE;
-
-				D3D12_CLEAR_VALUE depthOptimizedClearValue = {};
-				depthOptimizedClearValue.Format = DXGI_FORMAT_D32_FLOAT;
-				depthOptimizedClearValue.DepthStencil.Depth = 1.0f;
-				depthOptimizedClearValue.DepthStencil.Stencil = 0;
-
-				m_device->CreateCommittedResource(
-					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-					D3D12_HEAP_FLAG_NONE,
-					&CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, m_width, m_height, 1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL),
-					D3D12_RESOURCE_STATE_DEPTH_WRITE,
-					&depthOptimizedClearValue,
-					IID_PPV_ARGS(&m_depthStencil)
-				);
-
-				m_device->CreateDepthStencilView(m_depthStencil.Get(), &depthStencilDesc, m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-			}
+		//ͼɫShaderҪ豸
+		void D3D12Query::LoadShaders()
+		{
+#if defined(_DEBUG)
+			// Enable better shader debugging with the graphics debugging tools.
+			UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+			UINT compileFlags = 0;
+#endif
+			//ֻлδʱű
+			auto filename = Utility::GetModulePath().append(L"Shaders.hlsl");
+			m_shaderCache.Open(Utility::GetModulePath().append(L"Shaders.cache"));
+			m_shaderCache.GetShader(filename, nullptr, "VSMain", "vs_5_0", compileFlags, &m_vertexShader);
+			m_shaderCache.GetShader(filename, nullptr, "PSMain", "ps_5_0", compileFlags, &m_pixelShader);
+		}
 
-			//Query Result Buffer
+		//ˮ״̬
+		void D3D12Query::CreatePipelineStates()
+		{
+			//벼
+			D3D12_INPUT_ELEMENT_DESC inputElementDescs[]=
 			{
-				m_device->CreateCommittedResource(
-					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-					D3D12_HEAP_FLAG_NONE,
-					&CD3DX12_RESOURCE_DESC::Buffer(8),
-					D3D12_RESOURCE_STATE_PREDICATION,
-					nullptr,
-					IID_PPV_ARGS(&m_queryResult)
-				);
-			}
+				{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+				{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+			};
 
-			//رCommand ListִУ㻺帴ƵĬ϶
-			m_commandList->Close();
-			ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-			m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-
-			//ͬ
+			CD3DX12_BLEND_DESC blendDesc(D3D12_DEFAULT);
+			blendDesc.RenderTarget[0] =
 			{
-				m_device->CreateFence(m_fenceValues[m_frameIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
-				m_fenceValues[m_frameIndex]++;
-				m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-				
-				WaitForGpu();
-			}
+				TRUE, FALSE,
+				D3D12_BLEND_SRC_ALPHA, D3D12_BLEND_INV_SRC_ALPHA, D3D12_BLEND_OP_ADD,
+				D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
+				D3D12_LOGIC_OP_NOOP,
+				D3D12_COLOR_WRITE_ENABLE_ALL,
+			};
+
+			//PSO
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+			psoDesc.InputLayout = { inputElementDescs,_countof(inputElementDescs) };
+			psoDesc.pRootSignature = m_rootSignature.Get();
+			psoDesc.VS = m_vertexShader;
+			psoDesc.PS = m_pixelShader;
+			psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+			psoDesc.BlendState = blendDesc;
+			psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+			psoDesc.SampleMask = UINT_MAX;
+			psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			psoDesc.NumRenderTargets = 1;
+			psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+			psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+			psoDesc.SampleDesc.Count = 1;
+
+			//ͬPSOֻһΣˮ߿
+			m_pipelineCache.Open(m_device.Get(), Utility::GetModulePath().append(L"Pipelines.cache"));
+			m_pipelineCache.GetGraphicsPipeline(psoDesc, m_rootSignatureKey, &m_pipelineState);
+
+			//ѯPSOں̨룬֮ǰѯԶıβڵ޳
+			m_pipelineCompiler.Initialize(&m_threadPool, &m_pipelineCache);
+
+			//ֹɫдд
+			psoDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0;
+			psoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+			m_queryStateKey = m_pipelineCompiler.Request(psoDesc, m_rootSignatureKey);
+
+			//ֽѾ꣬±ɫPSOдػļ
+			m_shaderCache.Save();
+			m_vertexShader = {};
+			m_pixelShader = {};
+			m_pipelineCache.Save();
 		}
 
-		void D3D12Query::OnUpdate()
+		//豸кͽװɺ˶Ⱦ塢ȺͲѯԴ
+		void D3D12Query::CreateRenderer()
 		{
-			const float translationSpeed = 0.01f;
-			const float offsetBounds = 1.5f;
-
-			// Animate the near quad.
-			m_constantBufferData[1].offset.x += translationSpeed;
-			if (m_constantBufferData[1].offset.x > offsetBounds)
-			{
-				m_constantBufferData[1].offset.x = -offsetBounds;
-			}
-
-			UINT cbvIndex = m_frameIndex * CbvCountPerFrame + 1;
-			UINT8* destination = m_pCbvDataBegin + (cbvIndex * sizeof(SceneConstantBuffer));
-			memcpy(destination, &m_constantBufferData[1], sizeof(SceneConstantBuffer));
+			m_backend.Initialize(m_device.Get(), m_commandQueue.Get(), &m_heapManager, &m_transientResources);
+			m_backendSwapChain = m_backend.WrapSwapChain(m_swapChain.Get(), m_width, m_height);
+			m_renderer.Initialize(&m_backend, m_backendSwapChain.get(), m_width, m_height);
 		}
 
-		void D3D12Query::OnRender()
+		void D3D12Query::OnUpdate()
 		{
-			// Record all the commands we need to render the scene into the command list.
-			PopulateCommandList();
-
-			// Execute the command list.
-			ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-			m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-			m_swapChain->Present(1, 0);
-
-			MoveToNextFrame();
+			m_renderer.Update();
 		}
 
-		void D3D12Query::PopulateCommandList()
+		void D3D12Query::OnRender()
 		{
-			m_commandAllocators[m_frameIndex]->Reset();
-			m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), m_pipelineState.Get());
-
-			m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
-
-			ID3D12DescriptorHeap* ppHeaps[] = { m_cbvHeap.Get() };
-			m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-
-			m_commandList->RSSetViewports(1, &m_viewport);
-			m_commandList->RSSetScissorRects(1, &m_scissorRect);
-
-			// Indicate that the back buffer will be used as a render target.
-			m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
-			CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
-			CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-			m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
-
-			// Record commands.
-			const float clearColor[] = { 0.5f, 0.7f, 0.8f, 1.0f };
-			m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-			m_commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+			//¼ÿ֡CPUʱͳPSOɵĿ
+			auto now = chrono::steady_clock::now();
+			if (m_frameStart.time_since_epoch().count() != 0)
+			{
+				m_pipelineCompiler.RecordFrame(chrono::duration<double, milli>(now - m_frameStart).count());
+			}
+			m_frameStart = now;
 
-			// Draw the quads and perform the occlusion query.
+			//ѯPSOɺſʼʹ
+			if (!m_renderer.HasQueryPipeline())
 			{
-				CD3DX12_GPU_DESCRIPTOR_HANDLE cbvFarQuad(m_cbvHeap->GetGPUDescriptorHandleForHeapStart(), m_frameIndex * CbvCountPerFrame, m_cbvSrvDescriptorSize);
-				CD3DX12_GPU_DESCRIPTOR_HANDLE cbvNearQuad(cbvFarQuad, m_cbvSrvDescriptorSize);
-
-				m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-				m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-
-				// Draw the far quad conditionally based on the result of the occlusion query
-				// from the previous frame.
-				m_commandList->SetGraphicsRootDescriptorTable(0, cbvFarQuad);
-				m_commandList->SetPredication(m_queryResult.Get(), 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
-				m_commandList->DrawInstanced(4, 1, 0, 0);
-
-				// Disable predication and always draw the near quad.
-				m_commandList->SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
-				m_commandList->SetGraphicsRootDescriptorTable(0, cbvNearQuad);
-				m_commandList->DrawInstanced(4, 1, 4, 0);
-
-				// Run the occlusion query with the bounding box quad.
-				m_commandList->SetGraphicsRootDescriptorTable(0, cbvFarQuad);
-				m_commandList->SetPipelineState(m_queryState.Get());
-				m_commandList->BeginQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_BINARY_OCCLUSION, 0);
-				m_commandList->DrawInstanced(4, 1, 8, 0);
-				m_commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_BINARY_OCCLUSION, 0);
-
-				// Resolve the occlusion query and store the results in the query result buffer
-				// to be used on the subsequent frame.
-				m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_queryResult.Get(), D3D12_RESOURCE_STATE_PREDICATION, D3D12_RESOURCE_STATE_COPY_DEST));
-				m_commandList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_BINARY_OCCLUSION, 0, 1, m_queryResult.Get(), 0);
-				m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_queryResult.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PREDICATION));
+				ID3D12PipelineState* queryState = m_pipelineCompiler.Resolve(m_queryStateKey);
+				if (queryState)
+				{
+					m_queryPipeline.reset(new Backend::D3D12::Pipeline(queryState, m_rootSignature.Get()));
+					m_renderer.SetPipelines(m_scenePipeline.get(), m_queryPipeline.get());
+				}
 			}
-			m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
 
-			m_commandList->Close();
+			m_renderer.Render();
 		}
 
 		void D3D12Query::OnDestroy()
 		{
 			// Ensure that the GPU is no longer referencing resources that are about to be
 			// cleaned up by the destructor.
-			WaitForGpu();
-
-			CloseHandle(m_fenceEvent);
-		}
+			m_renderer.WaitForGpu();
 
-
-		// Wait for pending GPU work to complete.
-		void D3D12Query::WaitForGpu()
-		{
-			// Schedule a Signal command in the queue.
-			m_commandQueue->Signal(m_fence.Get(), m_fenceValues[m_frameIndex]);
-
-			// Wait until the fence has been processed.
-			m_fence->SetEventOnCompletion(m_fenceValues[m_frameIndex], m_fenceEvent);
-			WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
-
-			// Increment the fence value for the current frame.
-			m_fenceValues[m_frameIndex]++;
+			//̨PSOҲдˮ߿
+			m_pipelineCompiler.WaitIdle();
+			m_pipelineCache.Save();
 		}
-
-		// Prepare to render the next frame.
-		void D3D12Query::MoveToNextFrame()
-		{
-			// Schedule a Signal command in the queue.
-			const UINT64 currentFenceValue = m_fenceValues[m_frameIndex];
-			m_commandQueue->Signal(m_fence.Get(), currentFenceValue);
-
-			// Update the frame index.
-			m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
-
-			// If the next frame is not ready to be rendered yet, wait until it is ready.
-			if (m_fence->GetCompletedValue() < m_fenceValues[m_frameIndex])
-			{
-				m_fence->SetEventOnCompletion(m_fenceValues[m_frameIndex], m_fenceEvent);
-				WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
-			}
-
-			// Set the fence value for the next frame.
-			m_fenceValues[m_frameIndex] = currentFenceValue + 1;
-		}
-
 	}
-}
+}
\ No newline at end of file
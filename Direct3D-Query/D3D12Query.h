@@ -1,4 +1,12 @@
 #pragma once
+#include "HeapManager.h"
+#include "TransientResourcePool.h"
+#include "ShaderCache.h"
+#include "PipelineCache.h"
+#include "AsyncPipelineCompiler.h"
+#include "TaskGraph.h"
+#include "D3D12Backend.h"
+#include "QueryRenderer.h"
 
 namespace Query {
 	namespace D3D12Query
@@ -6,74 +14,42 @@ namespace Query {
 		using Microsoft::WRL::ComPtr;
 		using namespace DirectX;
 
-		// Vertex definition.
-		struct Vertex
-		{
-			XMFLOAT3 position;
-			XMFLOAT4 color;
-		};
-
-		// Constant buffer definition.
-		struct SceneConstantBuffer
-		{
-			XMFLOAT4 offset;
-
-			// Constant buffers are 256-byte aligned. Add padding in the struct to allow multiple buffers
-			// to be array-indexed.
-			FLOAT padding[60];
-		};
-
 		class D3D12Query
 		{
 		private:
 			HWND m_hWnd;
 			UINT m_width, m_height;
-			float m_aspectRatio;
-
-			static const UINT FrameCount = 2;
-			static const UINT CbvCountPerFrame = 2;
-
-			UINT m_frameIndex = 0;
-			UINT m_rtvDescriptorSize; 
-			UINT m_cbvSrvDescriptorSize;
 
 			ComPtr<ID3D12Device> m_device;
+			Memory::HeapManager m_heapManager;//ԴڴID3D12Heap
+			Memory::TransientResourcePool m_transientResources;//ÿ֡ʱԴڲصĹڴ
 			ComPtr<ID3D12CommandQueue> m_commandQueue;
-			ComPtr<ID3D12DescriptorHeap> m_rtvHeap;//RTV
-			ComPtr<ID3D12DescriptorHeap> m_dsvHeap;//DSV
-			ComPtr<ID3D12DescriptorHeap> m_cbvHeap;//CBV
-			ComPtr<ID3D12QueryHeap> m_queryHeap;
-			ComPtr<ID3D12Resource> m_renderTargets[FrameCount];
-			ComPtr<ID3D12CommandAllocator> m_commandAllocators[FrameCount];
-			ComPtr<ID3D12GraphicsCommandList> m_commandList;
 			ComPtr<ID3D12RootSignature> m_rootSignature;
-			ComPtr<ID3D12PipelineState> m_pipelineState, m_queryState;
-
-			ComPtr<ID3D12Resource> m_vertexBuffer;
-			D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
-
-			SceneConstantBuffer m_constantBufferData[CbvCountPerFrame];
-			ComPtr<ID3D12Resource> m_constantBuffer;
-			UINT8* m_pCbvDataBegin;
-
-			ComPtr<ID3D12Resource> m_depthStencil;
-			ComPtr<ID3D12Resource> m_queryResult;
-
-			UINT64 m_fenceValues[FrameCount];
-			ComPtr<ID3D12Fence> m_fence;
-			HANDLE m_fenceEvent;
-
-			D3D12_VIEWPORT m_viewport;
-			D3D12_RECT m_scissorRect;
+			ComPtr<ID3D12PipelineState> m_pipelineState;
+			Shaders::ShaderCache m_shaderCache;//ݹϣõɫ
+			D3D12_SHADER_BYTECODE m_vertexShader = {}, m_pixelShader = {};//ֻڼЧ
+			Pipelines::PipelineCache m_pipelineCache;//淶PSO
+			uint64_t m_rootSignatureKey = 0;
+			Threading::ThreadPool m_threadPool;
+			Pipelines::AsyncPipelineCompiler m_pipelineCompiler;//ڹ߳ϴPSO
+			uint64_t m_queryStateKey = 0;
+			chrono::steady_clock::time_point m_frameStart;
 
 			ComPtr<IDXGISwapChain4> m_swapChain;
-		private:
-			void LoadPipeline();
-			void LoadAssets();
 
-			void PopulateCommandList();
-			void WaitForGpu();
-			void MoveToNextFrame();
+			//Ⱦֻͨ˽ӿ¼˶ڶѹ
+			Backend::D3D12::Device m_backend;
+			unique_ptr<Backend::D3D12::SwapChain> m_backendSwapChain;
+			unique_ptr<Backend::D3D12::Pipeline> m_scenePipeline, m_queryPipeline;
+			Rendering::QueryRenderer m_renderer;
+		private:
+			//Initializeϵ
+			void CreateDevice();
+			void CreateSwapChain();
+			void CreateRootSignature();
+			void LoadShaders();
+			void CreatePipelineStates();
+			void CreateRenderer();
 
 		public:
 			D3D12Query();
@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "DepthPyramid.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define QUERY_DEPTH_PYRAMID_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Query {
+	namespace Culling
+	{
+		namespace
+		{
+			// Rows of a level that one thread reduces at a time.
+			const uint32_t BandRows = 32;
+
+			// Same operand order as _mm_max_ps, so that the paths agree even on NaNs.
+			inline float Max(float a, float b)
+			{
+				return a > b ? a : b;
+			}
+
+			// Destination rows [firstRow, endRow) of DepthPyramid::Reduce.
+			void ReduceRows(const float* source, uint32_t width, uint32_t height, uint32_t sourcePitch,
+				float* destination, uint32_t destinationPitch, uint32_t firstRow, uint32_t endRow, bool simd)
+			{
+				const uint32_t destinationWidth = (width + 1) / 2;
+				for (uint32_t y = firstRow; y < endRow; y++)
+				{
+					const float* row0 = source + static_cast<size_t>(2 * y) * sourcePitch;
+					const float* row1 = 2 * y + 1 < height ? row0 + sourcePitch : row0;
+					float* output = destination + static_cast<size_t>(y) * destinationPitch;
+
+					uint32_t x = 0;
+#if QUERY_DEPTH_PYRAMID_SSE2
+					// Four texels from eight pixels of each row: the rows first, then the even and odd columns.
+					for (; simd && 2 * x + 8 <= width; x += 4)
+					{
+						const __m128 low = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x), _mm_loadu_ps(row1 + 2 * x));
+						const __m128 high = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x + 4), _mm_loadu_ps(row1 + 2 * x + 4));
+						_mm_storeu_ps(output + x, _mm_max_ps(
+							_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)),
+							_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1))));
+					}
+#endif
+					for (; x < destinationWidth; x++)
+					{
+						const uint32_t x0 = 2 * x, x1 = 2 * x + 1 < width ? 2 * x + 1 : 2 * x;
+						output[x] = Max(Max(row0[x0], row1[x0]), Max(row0[x1], row1[x1]));
+					}
+				}
+			}
+
+			// Destination rows of DepthPyramid::Downsample for blocks of four or more pixels each way.
+			void DownsampleRows(const float* source, uint32_t width, uint32_t height, uint32_t sourcePitch, uint32_t shift,
+				float* destination, uint32_t destinationPitch, bool simd)
+			{
+				const uint32_t block = 1u << shift;
+				const uint32_t destinationWidth = (width + block - 1) >> shift, destinationHeight = (height + block - 1) >> shift;
+				for (uint32_t y = 0; y < destinationHeight; y++)
+				{
+					const float* rows = source + (static_cast<size_t>(y) << shift) * sourcePitch;
+					const uint32_t rowCount = (y << shift) + block <= height ? block : height - (y << shift);
+					float* output = destination + static_cast<size_t>(y) * destinationPitch;
+
+					uint32_t x = 0;
+#if QUERY_DEPTH_PYRAMID_SSE2
+					// Four texels at a time: one vector per texel holds the max of its block's columns
+					// in groups of four, and a transpose brings the four partial maxima together.
+					for (; simd && ((x + 4) << shift) <= width; x += 4)
+					{
+						__m128 columns[4];
+						for (uint32_t texel = 0; texel < 4; texel++)
+						{
+							const float* first = rows + ((x + texel) << shift);
+							__m128 farthest = _mm_loadu_ps(first);
+							for (uint32_t row = 0; row < rowCount; row++)
+							{
+								const float* pixels = first + static_cast<size_t>(row) * sourcePitch;
+								for (uint32_t column = 0; column < block; column += 4)
+								{
+									farthest = _mm_max_ps(farthest, _mm_loadu_ps(pixels + column));
+								}
+							}
+							columns[texel] = farthest;
+						}
+						_MM_TRANSPOSE4_PS(columns[0], columns[1], columns[2], columns[3]);
+						_mm_storeu_ps(output + x, _mm_max_ps(_mm_max_ps(columns[0], columns[1]), _mm_max_ps(columns[2], columns[3])));
+					}
+#endif
+					for (; x < destinationWidth; x++)
+					{
+						const uint32_t x0 = x << shift, x1 = x0 + block < width ? x0 + block : width;
+						float farthest = rows[x0];
+						for (uint32_t row = 0; row < rowCount; row++)
+						{
+							const float* pixels = rows + static_cast<size_t>(row) * sourcePitch;
+							for (uint32_t column = x0; column < x1; column++)
+							{
+								farthest = Max(farthest, pixels[column]);
+							}
+						}
+						output[x] = farthest;
+					}
+				}
+			}
+		}
+
+		void DepthPyramid::Downsample(const float* source, uint32_t width, uint32_t height, uint32_t sourcePitch, uint32_t shift,
+			float* destination, uint32_t destinationPitch, bool simd)
+		{
+			if (shift == 0)
+			{
+				for (uint32_t y = 0; y < height; y++)
+				{
+					memcpy(destination + static_cast<size_t>(y) * destinationPitch, source + static_cast<size_t>(y) * sourcePitch, width * sizeof(float));
+				}
+				return;
+			}
+			if (shift == 1)
+			{
+				ReduceRows(source, width, height, sourcePitch, destination, destinationPitch, 0, (height + 1) / 2, simd);
+				return;
+			}
+			DownsampleRows(source, width, height, sourcePitch, shift, destination, destinationPitch, simd);
+		}
+
+		void DepthPyramid::Reduce(const float* source, uint32_t width, uint32_t height, uint32_t sourcePitch,
+			float* destination, uint32_t destinationPitch, bool simd)
+		{
+			ReduceRows(source, width, height, sourcePitch, destination, destinationPitch, 0, (height + 1) / 2, simd);
+		}
+
+		void DepthPyramid::Build(const float* depth, uint32_t width, uint32_t height, uint32_t pitch,
+			Threading::ThreadPool* pool, bool simd)
+		{
+			if (width != m_width || height != m_height)
+			{
+				m_width = width;
+				m_height = height;
+				m_levels.clear();
+				size_t size = 0;
+				for (uint32_t levelWidth = width, levelHeight = height; width && height && (m_levels.empty() || levelWidth > 1 || levelHeight > 1);)
+				{
+					levelWidth = (levelWidth + 1) / 2;
+					levelHeight = (levelHeight + 1) / 2;
+					const Level level = { levelWidth, levelHeight, (levelWidth + 3) & ~3u, size };
+					m_levels.push_back(level);
+					size += static_cast<size_t>(level.pitch) * levelHeight;
+				}
+				m_texels.assign(size, 0.0f);
+			}
+
+			const float* source = depth;
+			uint32_t sourceWidth = width, sourceHeight = height, sourcePitch = pitch;
+			for (const Level& level : m_levels)
+			{
+				float* destination = m_texels.data() + level.offset;
+				const uint32_t bands = (level.height + BandRows - 1) / BandRows;
+				if (pool && bands > 1)
+				{
+					pool->ParallelFor(bands, [&](uint32_t band)
+					{
+						const uint32_t firstRow = band * BandRows;
+						const uint32_t endRow = firstRow + BandRows < level.height ? firstRow + BandRows : level.height;
+						ReduceRows(source, sourceWidth, sourceHeight, sourcePitch, destination, level.pitch, firstRow, endRow, simd);
+					});
+				}
+				else
+				{
+					ReduceRows(source, sourceWidth, sourceHeight, sourcePitch, destination, level.pitch, 0, level.height, simd);
+				}
+				source = destination;
+				sourceWidth = level.width;
+				sourceHeight = level.height;
+				sourcePitch = level.pitch;
+			}
+		}
+
+		bool DepthPyramid::IsOccluded(const Bounds& bounds) const
+		{
+			if (m_levels.empty())
+			{
+				return false;
+			}
+
+			// Every pixel the rectangle touches, not only those whose centers it covers.
+			const float width = static_cast<float>(m_width), height = static_cast<float>(m_height);
+			const float left = (bounds.min[0] * 0.5f + 0.5f) * width, right = (bounds.max[0] * 0.5f + 0.5f) * width;
+			const float top = (0.5f - bounds.max[1] * 0.5f) * height, bottom = (0.5f - bounds.min[1] * 0.5f) * height;
+			if (!(right >= 0 && left < width && bottom >= 0 && top < height))
+			{
+				return false;
+			}
+			const uint32_t x0 = left > 0 ? static_cast<uint32_t>(left) : 0;
+			const uint32_t x1 = right < width ? static_cast<uint32_t>(right) : m_width - 1;
+			const uint32_t y0 = top > 0 ? static_cast<uint32_t>(top) : 0;
+			const uint32_t y1 = bottom < height ? static_cast<uint32_t>(bottom) : m_height - 1;
+
+			uint32_t level = 0;
+			while (level + 1 < m_levels.size() &&
+				((x1 >> (level + 1)) - (x0 >> (level + 1)) > 1 || (y1 >> (level + 1)) - (y0 >> (level + 1)) > 1))
+			{
+				level++;
+			}
+
+			const float* texels = GetTexels(level);
+			const uint32_t pitch = m_levels[level].pitch, shift = level + 1;
+			const float* row0 = texels + static_cast<size_t>(y0 >> shift) * pitch;
+			const float* row1 = texels + static_cast<size_t>(y1 >> shift) * pitch;
+			const float farthest = Max(Max(row0[x0 >> shift], row0[x1 >> shift]), Max(row1[x0 >> shift], row1[x1 >> shift]));
+			return bounds.min[2] >= farthest;
+		}
+	}
+}
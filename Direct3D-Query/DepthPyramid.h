@@ -0,0 +1,64 @@
+#pragma once
+#include "BoundingVolumeHierarchy.h"
+
+namespace Query {
+	namespace Culling
+	{
+		// A hierarchical max-depth pyramid (HiZ) over a D32 depth buffer drawn with LESS and cleared
+		// to 1. Every texel holds the farthest depth of the pixels it covers, so an object whose
+		// nearest depth is not in front of any texel under its screen rectangle fails the depth test
+		// everywhere and can be skipped without a query.
+		//
+		// Level 0 is half the depth buffer in each direction, rounded up, and every further level
+		// halves the one before, down to 1x1: texel (x, y) of level l covers the pixels
+		// [x, x + 1) * 2^(l+1) by [y, y + 1) * 2^(l+1), cut at the buffer's edges. Each texel is the
+		// max of four texels of the level below, the last column or row counting twice when that
+		// level is odd. The pyramid is built on the CPU; max is exact, so the SSE path and the scalar
+		// path give the same bits.
+		class DepthPyramid
+		{
+		public:
+			struct Level
+			{
+				uint32_t width, height;
+				uint32_t pitch;	//texels per row, a multiple of 4
+				size_t offset;	//of the first texel in the pyramid
+			};
+
+		private:
+			uint32_t m_width = 0, m_height = 0;
+			vector<Level> m_levels;
+			vector<float> m_texels;
+
+		public:
+			// Writes the max of every 2x2 block of source to destination, which is
+			// (width + 1) / 2 by (height + 1) / 2. simd false runs the scalar reference.
+			static void Reduce(const float* source, uint32_t width, uint32_t height, uint32_t sourcePitch,
+				float* destination, uint32_t destinationPitch, bool simd = true);
+
+			// Writes the max of every 2^shift x 2^shift block of source, cut at its edges, to
+			// destination, which is width and height divided by 2^shift, rounded up: a 1/4 (shift 1)
+			// or 1/16 (shift 2) resolution depth that no pixel of source is behind. simd false runs
+			// the scalar reference.
+			static void Downsample(const float* source, uint32_t width, uint32_t height, uint32_t sourcePitch, uint32_t shift,
+				float* destination, uint32_t destinationPitch, bool simd = true);
+
+			// Builds every level from depth, pitch floats per row. With a pool, the rows of the large
+			// levels are split among its threads.
+			void Build(const float* depth, uint32_t width, uint32_t height, uint32_t pitch,
+				Threading::ThreadPool* pool = nullptr, bool simd = true);
+
+			// True when bounds, with x and y in normalized device coordinates and depth as z, lies
+			// behind the depth under all of its screen rectangle. Reads at most four texels, of the
+			// finest level where the rectangle spans no more than two texels each way. Objects that
+			// are off the screen are never occluded.
+			bool IsOccluded(const Bounds& bounds) const;
+
+			uint32_t GetWidth() const { return m_width; }
+			uint32_t GetHeight() const { return m_height; }
+			uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_levels.size()); }
+			const Level& GetLevel(uint32_t level) const { return m_levels[level]; }
+			const float* GetTexels(uint32_t level) const { return m_texels.data() + m_levels[level].offset; }
+		};
+	}
+}
@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "DepthPyramidBenchmark.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Quad;
+		using Rendering::Scene;
+
+		PyramidResult RunPyramid(const PyramidOptions& options, uint32_t seed)
+		{
+			SceneDesc desc;
+			desc.occluders = options.occluders;
+			desc.occludees = options.objects;
+			desc.sizes = SizeDistribution::PowerLaw;
+			desc.animation = Rendering::Animation::None;
+			desc.seed = seed;
+			const Scene scene = GenerateScene(desc);
+			const uint32_t width = options.width, height = options.height;
+			vector<float> depth;
+			DrawDepth(scene.occluders, width, height, depth);
+
+			PyramidResult result;
+			result.options = options;
+			const double builds = options.builds ? options.builds : 1;
+			auto timeBuilds = [&](Culling::DepthPyramid& pyramid, Threading::ThreadPool* pool, bool simd)
+			{
+				pyramid.Build(depth.data(), width, height, width, pool, simd);
+				const auto start = chrono::steady_clock::now();
+				for (uint32_t i = 0; i < options.builds; i++)
+				{
+					pyramid.Build(depth.data(), width, height, width, pool, simd);
+				}
+				return MillisecondsSince(start) / builds;
+			};
+
+			Culling::DepthPyramid scalar, simd, parallel;
+			result.scalarMilliseconds = timeBuilds(scalar, nullptr, false);
+			result.simdMilliseconds = timeBuilds(simd, nullptr, true);
+			Threading::ThreadPool threadPool;
+			threadPool.Initialize(options.threadCount);
+			result.threads = threadPool.GetThreadCount() + 1;
+			result.parallelMilliseconds = timeBuilds(parallel, &threadPool, true);
+			result.levels = scalar.GetLevelCount();
+
+			vector<Culling::Bounds> bounds(options.objects);
+			for (uint32_t i = 0; i < options.objects; i++)
+			{
+				const Quad& quad = scene.occludees[i];
+				bounds[i] = { { quad.left, quad.bottom, quad.depth }, { quad.right, quad.top, quad.depth } };
+			}
+			vector<uint8_t> occluded(options.objects);
+			const auto start = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < options.objects; i++)
+			{
+				occluded[i] = simd.IsOccluded(bounds[i]);
+			}
+			result.testNanoseconds = options.objects ? MillisecondsSince(start) * 1e6 / options.objects : 0;
+
+			uint32_t rejected = 0, exact = 0;
+			for (uint32_t i = 0; i < options.objects; i++)
+			{
+				rejected += occluded[i];
+				exact += IsHidden(bounds[i], depth, width, height);
+			}
+			result.occluded = options.objects ? static_cast<double>(rejected) / options.objects : 0;
+			result.exactOccluded = options.objects ? static_cast<double>(exact) / options.objects : 0;
+			return result;
+		}
+
+		string ToJson(const vector<PyramidResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"hiz\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const PyramidResult& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"width\": %u, \"height\": %u, \"occluders\": %u, \"objects\": %u, \"levels\": %u, \"threads\": %u, "
+					"\"scalarMs\": %.3f, \"simdMs\": %.3f, \"parallelMs\": %.3f, \"testNs\": %.1f, "
+					"\"occluded\": %.4f, \"exactOccluded\": %.4f }",
+					i ? "," : "",
+					result.options.width, result.options.height, result.options.occluders, result.options.objects, result.levels, result.threads,
+					result.scalarMilliseconds, result.simdMilliseconds, result.parallelMilliseconds, result.testNanoseconds,
+					result.occluded, result.exactOccluded);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
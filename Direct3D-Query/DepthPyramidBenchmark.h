@@ -0,0 +1,36 @@
+#pragma once
+#include "SceneGenerator.h"
+#include "DepthPyramid.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct PyramidOptions
+		{
+			uint32_t width = 3840, height = 2160;
+			uint32_t occluders = 256;	//power-law sized, drawn into the depth buffer
+			uint32_t objects = 20000;	//occludees tested against the pyramid
+			uint32_t builds = 20;
+			uint32_t threadCount = 0;	//pool workers for the parallel build, 0 for one per hardware thread
+		};
+
+		struct PyramidResult
+		{
+			PyramidOptions options;
+			uint32_t levels = 0;
+			uint32_t threads = 1;	//threads of the parallel build, the calling one included
+			double scalarMilliseconds = 0;	//per build, one thread
+			double simdMilliseconds = 0;
+			double parallelMilliseconds = 0;
+			double testNanoseconds = 0;	//per DepthPyramid::IsOccluded
+			double occluded = 0;	//fraction of the objects the pyramid rejects
+			double exactOccluded = 0;	//and that testing every pixel under them rejects
+		};
+
+		// Draws the occluders of a generated scene into a depth buffer, builds its pyramid with each
+		// path and tests the occludees against it.
+		PyramidResult RunPyramid(const PyramidOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<PyramidResult>& results);
+	}
+}
@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "DepthReprojection.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define QUERY_DEPTH_REPROJECTION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Query {
+	namespace Culling
+	{
+		namespace
+		{
+			// Beyond every depth, so that any sample that lands wins; the 3x3 max keeps it and is then
+			// clamped to 1, so holes and the pixels next to them end up far.
+			const float Uncovered = 2.0f;
+
+			// Same operand order as _mm_max_ps.
+			inline float Max(float a, float b)
+			{
+				return a > b ? a : b;
+			}
+
+			// Same operand order as _mm_min_ps.
+			inline float Min(float a, float b)
+			{
+				return a < b ? a : b;
+			}
+
+			// output[x] is the max of row[x, x + 3). Returns how many of row[1, width + 1) are uncovered.
+			uint32_t MaxOfThree(const float* row, float* output, uint32_t width, bool simd)
+			{
+				uint32_t holes = 0, x = 0;
+#if QUERY_DEPTH_REPROJECTION_SSE2
+				static const uint8_t BitCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+				const __m128 farDepth = _mm_set1_ps(1.0f);
+				for (; simd && x + 4 <= width; x += 4)
+				{
+					const __m128 center = _mm_loadu_ps(row + x + 1);
+					holes += BitCounts[_mm_movemask_ps(_mm_cmpgt_ps(center, farDepth))];
+					_mm_storeu_ps(output + x, _mm_max_ps(_mm_max_ps(_mm_loadu_ps(row + x), center), _mm_loadu_ps(row + x + 2)));
+				}
+#endif
+				for (; x < width; x++)
+				{
+					holes += row[x + 1] > 1.0f;
+					output[x] = Max(Max(row[x], row[x + 1]), row[x + 2]);
+				}
+				return holes;
+			}
+		}
+
+		void DepthReprojection::ScatterObjects(const float* previous, uint32_t pitch, const ReprojectionMotion& motion)
+		{
+			const uint32_t width = m_width, height = m_height;
+			const float scaleX = 0.5f * width, scaleY = -0.5f * height;
+			auto motionRow = [&motion](uint32_t y) { return motion.objects + static_cast<size_t>(y) * motion.objectPitch * 2; };
+
+			// Where two neighbors move apart, a gap narrower than a pixel can open that both their
+			// samples would land in, so a sample is dropped when a pixel of its 3x3 neighborhood, cut
+			// at the screen's edges, moves away from it. Neighbors that move toward each other need
+			// nothing: the nearer sample wins where both land, and the 3x3 max covers the half pixel
+			// it may overshoot.
+			auto separates = [&](uint32_t x, uint32_t y)
+			{
+				const float* center = motionRow(y) + 2 * x;
+				for (int32_t ny = y > 0 ? -1 : 0; ny <= (y + 1 < height ? 1 : 0); ny++)
+				{
+					for (int32_t nx = x > 0 ? -1 : 0; nx <= (x + 1 < width ? 1 : 0); nx++)
+					{
+						const float* neighbor = center + (static_cast<ptrdiff_t>(ny) * motion.objectPitch + nx) * 2;
+						if ((neighbor[0] - center[0]) * scaleX * nx + (neighbor[1] - center[1]) * scaleY * ny > 0)
+						{
+							return true;
+						}
+					}
+				}
+				return false;
+			};
+
+			// Per row, which pixels move like their whole 3x3 neighborhood, from byte flags: whether
+			// each pixel moves like the one below it (for the rows above and below), and like the one
+			// to its right. A run of such pixels moves as one and lands as one.
+			m_flags.resize(static_cast<size_t>(width) * 4);
+			uint8_t* below[2] = { m_flags.data(), m_flags.data() + width };
+			uint8_t* vertical = m_flags.data() + 2 * width;
+			uint8_t* uniform = m_flags.data() + 3 * width;
+			auto sameAsBelow = [&](uint32_t y, uint8_t* flags)
+			{
+				const float* row = motionRow(y);
+				const float* next = motionRow(y + 1 < height ? y + 1 : y);
+				for (uint32_t x = 0; x < width; x++)
+				{
+					flags[x] = (row[2 * x] == next[2 * x]) & (row[2 * x + 1] == next[2 * x + 1]);
+				}
+			};
+			fill(below[1], below[1] + width, 1);
+			for (uint32_t y = 0; y < height; y++)
+			{
+				swap(below[0], below[1]);
+				sameAsBelow(y, below[1]);
+				const float* row = motionRow(y);
+				for (uint32_t x = 0; x < width; x++)
+				{
+					vertical[x] = below[0][x] & below[1][x];
+				}
+				for (uint32_t x = 0; x < width; x++)
+				{
+					const uint32_t left = x > 0 ? x - 1 : x, right = x + 1 < width ? x + 1 : x;
+					const uint8_t sameRight = (row[2 * x] == row[2 * right]) & (row[2 * x + 1] == row[2 * right + 1]);
+					const uint8_t sameLeft = (row[2 * x] == row[2 * left]) & (row[2 * x + 1] == row[2 * left + 1]);
+					uniform[x] = vertical[left] & vertical[x] & vertical[right] & sameLeft & sameRight;
+				}
+
+				const float* depth = previous + static_cast<size_t>(y) * pitch;
+				for (uint32_t x = 0; x < width;)
+				{
+					uint32_t end = x + 1;
+					if (uniform[x])
+					{
+						while (end < width && uniform[end])
+						{
+							end++;
+						}
+					}
+					else if (separates(x, y))
+					{
+						x = end;
+						continue;
+					}
+
+					// Pixels [x, end) all move by the motion of x.
+					const float shiftX = ceilf((motion.cameraX + row[2 * x]) * scaleX - 0.5f);
+					const float shiftY = ceilf((motion.cameraY + row[2 * x + 1]) * scaleY - 0.5f);
+					const uint32_t ty = y + static_cast<int32_t>(shiftY);
+					if (fabsf(shiftX) < width && fabsf(shiftY) < height && ty < height)
+					{
+						const int32_t dx = static_cast<int32_t>(shiftX);
+						const uint32_t first = dx < 0 && x < static_cast<uint32_t>(-dx) ? -dx : x;
+						const uint32_t last = dx > 0 && end > width - dx ? width - dx : end;
+						float* target = GetScattered(ty) + (first + dx);
+						for (uint32_t i = first; i < last; i++, target++)
+						{
+							*target = depth[i] < *target ? depth[i] : *target;
+						}
+					}
+					x = end;
+				}
+			}
+		}
+
+		void DepthReprojection::Reproject(const float* previous, uint32_t width, uint32_t height, uint32_t pitch,
+			const ReprojectionMotion& motion, float* current, uint32_t currentPitch, bool simd)
+		{
+			if (width != m_width || height != m_height)
+			{
+				m_width = width;
+				m_height = height;
+				m_pitch = (width + 2 + 3) & ~3u;
+				m_scattered.assign(static_cast<size_t>(m_pitch) * (height + 2), 1.0f);
+			}
+			m_holes = 0;
+			if (!width || !height)
+			{
+				return;
+			}
+			if (motion.objects)
+			{
+				for (uint32_t y = 0; y < height; y++)
+				{
+					fill(GetScattered(y), GetScattered(y) + width, Uncovered);
+				}
+			}
+
+			// A footprint [x, x + 1) moved by d pixels covers the center of pixel ceil(x + d - 0.5).
+			const float scaleX = 0.5f * width, scaleY = -0.5f * height;
+			if (!motion.objects)
+			{
+				// The camera alone moves every pixel by the same whole number of pixels, so only the
+				// strips it uncovers at the screen's edges need marking.
+				const float shiftX = ceilf(motion.cameraX * scaleX - 0.5f), shiftY = ceilf(motion.cameraY * scaleY - 0.5f);
+				const bool inRange = fabsf(shiftX) < width && fabsf(shiftY) < height;
+				const int32_t dx = inRange ? static_cast<int32_t>(shiftX) : 0, dy = inRange ? static_cast<int32_t>(shiftY) : 0;
+				const uint32_t x0 = dx < 0 ? -dx : 0, x1 = dx > 0 ? width - dx : width;
+				const uint32_t y0 = dy < 0 ? -dy : 0, y1 = dy > 0 ? height - dy : height;
+				for (uint32_t y = 0; y < height; y++)
+				{
+					float* row = GetScattered(y);
+					const uint32_t source = y - dy;
+					if (!inRange || source < y0 || source >= y1)
+					{
+						fill(row, row + width, Uncovered);
+						continue;
+					}
+					fill(row, row + x0 + dx, Uncovered);
+					memcpy(row + x0 + dx, previous + static_cast<size_t>(source) * pitch + x0, (x1 - x0) * sizeof(float));
+					fill(row + x1 + dx, row + width, Uncovered);
+				}
+			}
+			else
+			{
+				ScatterObjects(previous, pitch, motion);
+			}
+
+			// The 3x3 max, separably: three rows of horizontal maxima in a ring, the far border included.
+			const uint32_t rowPitch = (width + 3) & ~3u;
+			m_rows.resize(static_cast<size_t>(rowPitch) * 3);
+			float* ring = m_rows.data();
+			for (uint32_t row = 0; row < height + 2; row++)
+			{
+				const float* padded = m_scattered.data() + static_cast<size_t>(row) * m_pitch;	//row - 1 of the screen, border included
+				m_holes += MaxOfThree(padded, ring + (row % 3) * rowPitch, width, simd);
+				if (row < 2)
+				{
+					continue;
+				}
+
+				const float* above = ring + ((row - 2) % 3) * rowPitch;
+				const float* middle = ring + ((row - 1) % 3) * rowPitch;
+				const float* below = ring + (row % 3) * rowPitch;
+				float* output = current + static_cast<size_t>(row - 2) * currentPitch;
+				uint32_t x = 0;
+#if QUERY_DEPTH_REPROJECTION_SSE2
+				const __m128 farDepth = _mm_set1_ps(1.0f);
+				for (; simd && x + 4 <= width; x += 4)
+				{
+					const __m128 farthest = _mm_max_ps(_mm_max_ps(_mm_loadu_ps(above + x), _mm_loadu_ps(middle + x)), _mm_loadu_ps(below + x));
+					_mm_storeu_ps(output + x, _mm_min_ps(farthest, farDepth));
+				}
+#endif
+				for (; x < width; x++)
+				{
+					output[x] = Min(Max(Max(above[x], middle[x]), below[x]), 1.0f);
+				}
+			}
+		}
+	}
+}
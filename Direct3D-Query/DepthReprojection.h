@@ -0,0 +1,55 @@
+#pragma once
+#include "DepthPyramid.h"
+
+namespace Query {
+	namespace Culling
+	{
+		// Screen-space motion from the previous frame to this one, in normalized device coordinates.
+		struct ReprojectionMotion
+		{
+			float cameraX = 0, cameraY = 0;	//of every pixel
+			const float* objects = nullptr;	//x and y of each pixel's own motion, added to the camera's; none when null
+			uint32_t objectPitch = 0;	//float pairs per row
+		};
+
+		// Turns the previous frame's depth (D32, LESS, cleared to 1) into a conservative depth for
+		// this frame, so that occlusion can be decided before this frame's queries are issued: no
+		// pixel of the result is in front of what this frame's pixel center will hold, provided the
+		// motion is right and nothing new enters the screen in front of the old depth. A gap
+		// narrower than a pixel between two surfaces may cover no pixel center in one frame and one
+		// in the next; the result does not see it open.
+		//
+		// Every previous pixel is moved by its motion and lands on the pixel whose center its moved
+		// footprint covers; pixels several land on keep the nearest depth, as the depth test would.
+		// A sample is dropped where a neighbor moves away from it, since both could otherwise land
+		// in a gap that opens between them. Pixels nothing lands on, the holes that moving
+		// occluders uncover, are marked beyond the far plane. A pixel a surface lands on may lie up
+		// to half a pixel beyond that surface's edge, so the result is the max over each pixel's
+		// 3x3 neighborhood, clamped to the far plane, the screen's border counting as far: it gives
+		// up a pixel around every occluder and hole rather than cull through an edge.
+		//
+		// With the camera's motion alone every pixel moves alike, which is a copy of the rows.
+		class DepthReprojection
+		{
+		private:
+			uint32_t m_width = 0, m_height = 0;
+			uint32_t m_pitch = 0;	//of m_scattered, which has a one-texel border of far depth
+			vector<float> m_scattered;
+			vector<float> m_rows;	//three rows of horizontal maxima
+			vector<uint8_t> m_flags;	//which pixels move like their neighbors, a few rows of them
+			uint32_t m_holes = 0;
+
+		private:
+			float* GetScattered(uint32_t y) { return m_scattered.data() + static_cast<size_t>(y + 1) * m_pitch + 1; }
+			void ScatterObjects(const float* previous, uint32_t pitch, const ReprojectionMotion& motion);
+
+		public:
+			// current has the size of previous; its pitch is in floats.
+			void Reproject(const float* previous, uint32_t width, uint32_t height, uint32_t pitch,
+				const ReprojectionMotion& motion, float* current, uint32_t currentPitch, bool simd = true);
+
+			// Pixels of the last Reproject that nothing landed on.
+			uint32_t GetHoleCount() const { return m_holes; }
+		};
+	}
+}
@@ -0,0 +1,145 @@
+#include "pch.h"
+#include "DepthReprojectionBenchmark.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Quad;
+		using Rendering::Scene;
+
+		ReprojectionResult RunReprojection(const ReprojectionOptions& options, uint32_t seed)
+		{
+			SceneDesc desc;
+			desc.occluders = options.occluders;
+			desc.occludees = options.objects;
+			desc.sizes = SizeDistribution::PowerLaw;
+			desc.animation = Rendering::Animation::Drift;
+			desc.seed = seed;
+			const Scene scene = GenerateScene(desc);
+			const uint32_t width = options.width, height = options.height;
+
+			Rendering::SceneStore store;
+			Rendering::SceneRenderer::AddDrift(scene.occluders, store);
+			vector<float> offsets(static_cast<size_t>(options.occluders) * 4);
+			Rendering::SceneStore::Output output;
+			output.destination = reinterpret_cast<uint8_t*>(offsets.data());
+			output.stride = 4 * sizeof(float);
+
+			// The occluders where the camera at frame sees them.
+			vector<Quad> quads = scene.occluders;
+			auto place = [&](uint32_t frame)
+			{
+				const float camera = options.cameraSpeed * frame;
+				for (uint32_t i = 0; i < options.occluders; i++)
+				{
+					const Quad& quad = scene.occluders[i];
+					const float x = store.GetOffsetX(i) - camera, y = store.GetOffsetY(i);
+					quads[i].left = quad.left + x;
+					quads[i].right = quad.right + x;
+					quads[i].bottom = quad.bottom + y;
+					quads[i].top = quad.top + y;
+				}
+			};
+
+			ReprojectionResult result;
+			result.options = options;
+			vector<float> previous, motions, current, reprojected(static_cast<size_t>(width) * height);
+			vector<float> quadMotions(static_cast<size_t>(options.occluders) * 2);
+			vector<Culling::Bounds> bounds(options.objects);
+			vector<uint8_t> hidden(options.objects);
+			Culling::DepthReprojection reprojection;
+			Culling::DepthPyramid pyramid;
+			uint64_t holes = 0, stale = 0, reprojectedCount = 0, currentCount = 0;
+			for (uint32_t frame = 1; frame <= options.frames; frame++)
+			{
+				place(frame - 1);
+				for (uint32_t i = 0; i < options.occluders; i++)
+				{
+					quadMotions[2 * i] = store.GetOffsetX(i);
+					quadMotions[2 * i + 1] = store.GetOffsetY(i);
+				}
+				store.Update(output);
+				for (uint32_t i = 0; i < options.occluders; i++)
+				{
+					quadMotions[2 * i] = store.GetOffsetX(i) - quadMotions[2 * i];
+					quadMotions[2 * i + 1] = store.GetOffsetY(i) - quadMotions[2 * i + 1];
+				}
+				DrawDepth(quads, width, height, previous, quadMotions.data(), &motions);
+				place(frame);
+				DrawDepth(quads, width, height, current);
+
+				Culling::ReprojectionMotion motion;
+				motion.cameraX = -options.cameraSpeed;
+				auto start = chrono::steady_clock::now();
+				reprojection.Reproject(previous.data(), width, height, width, motion, reprojected.data(), width);
+				result.cameraMilliseconds += MillisecondsSince(start);
+				motion.objects = motions.data();
+				motion.objectPitch = width;
+				start = chrono::steady_clock::now();
+				reprojection.Reproject(previous.data(), width, height, width, motion, reprojected.data(), width);
+				result.reprojectMilliseconds += MillisecondsSince(start);
+				holes += reprojection.GetHoleCount();
+
+				const float camera = options.cameraSpeed * frame;
+				for (uint32_t i = 0; i < options.objects; i++)
+				{
+					const Quad& quad = scene.occludees[i];
+					bounds[i] = { { quad.left - camera, quad.bottom, quad.depth }, { quad.right - camera, quad.top, quad.depth } };
+				}
+				for (uint32_t i = 0; i < options.objects; i++)
+				{
+					hidden[i] = IsHidden(bounds[i], current, width, height);
+				}
+				auto test = [&](const vector<float>& depth, uint64_t& occluded, uint32_t* popping)
+				{
+					pyramid.Build(depth.data(), width, height, width);
+					for (uint32_t i = 0; i < options.objects; i++)
+					{
+						const bool rejected = pyramid.IsOccluded(bounds[i]);
+						occluded += rejected;
+						if (popping)
+						{
+							*popping += rejected && !hidden[i];
+						}
+					}
+				};
+				test(previous, stale, &result.stalePopping);
+				test(reprojected, reprojectedCount, nullptr);
+				test(current, currentCount, nullptr);
+			}
+
+			const double frames = options.frames ? options.frames : 1;
+			const double tests = frames * (options.objects ? options.objects : 1);
+			result.reprojectMilliseconds /= frames;
+			result.cameraMilliseconds /= frames;
+			result.holes = holes / (frames * width * height);
+			result.staleOccluded = stale / tests;
+			result.reprojectedOccluded = reprojectedCount / tests;
+			result.currentOccluded = currentCount / tests;
+			return result;
+		}
+
+		string ToJson(const vector<ReprojectionResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"reprojection\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const ReprojectionResult& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"width\": %u, \"height\": %u, \"occluders\": %u, \"objects\": %u, \"frames\": %u, \"cameraSpeed\": %.4f, "
+					"\"reprojectMs\": %.3f, \"cameraMs\": %.3f, \"holes\": %.4f, "
+					"\"staleOccluded\": %.4f, \"reprojectedOccluded\": %.4f, \"currentOccluded\": %.4f, "
+					"\"stalePopping\": %u }",
+					i ? "," : "",
+					result.options.width, result.options.height, result.options.occluders, result.options.objects, result.options.frames, result.options.cameraSpeed,
+					result.reprojectMilliseconds, result.cameraMilliseconds, result.holes,
+					result.staleOccluded, result.reprojectedOccluded, result.currentOccluded,
+					result.stalePopping);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "SceneGenerator.h"
+#include "DepthReprojection.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct ReprojectionOptions
+		{
+			uint32_t width = 3840, height = 2160;
+			uint32_t occluders = 256;	//power-law sized and drifting
+			uint32_t objects = 20000;	//static occludees tested against the pyramid of each depth
+			uint32_t frames = 20;
+			float cameraSpeed = 0.005f;	//normalized device coordinates per frame the camera pans along x
+		};
+
+		struct ReprojectionResult
+		{
+			ReprojectionOptions options;
+			double reprojectMilliseconds = 0;	//per frame, camera and object motion
+			double cameraMilliseconds = 0;	//camera motion only
+			double holes = 0;	//fraction of the pixels nothing landed on
+			// Fractions of the objects rejected by the pyramid of the previous frame's depth as it is,
+			// of that depth reprojected, and of this frame's own depth, which is the best any can do.
+			double staleOccluded = 0;
+			double reprojectedOccluded = 0;
+			double currentOccluded = 0;
+			// Rejections by the stale depth of objects that this frame's depth does not hide, over all
+			// frames: the popping that a frame-late result would show.
+			uint32_t stalePopping = 0;
+		};
+
+		// Pans over a generated scene whose occluders drift (see Rendering::SceneStore) and, every
+		// frame, reprojects the previous frame's depth and tests the occludees against it.
+		ReprojectionResult RunReprojection(const ReprojectionOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<ReprojectionResult>& results);
+	}
+}
@@ -0,0 +1,39 @@
+#include "pch.h"
+#include "FrameArena.h"
+
+namespace Query {
+	namespace Memory
+	{
+		void* FrameArena::Allocate(size_t size, size_t alignment)
+		{
+			// Later blocks that are too small are skipped for this frame rather than searched.
+			for (; m_block < m_blocks.size(); m_block++, m_offset = 0)
+			{
+				Block& block = m_blocks[m_block];
+				uint8_t* begin = block.data.get() + m_offset;
+				uint8_t* aligned = AlignUp(begin, alignment);
+				if (static_cast<size_t>(aligned - block.data.get()) + size <= block.size)
+				{
+					m_offset = static_cast<size_t>(aligned - block.data.get()) + size;
+					m_usedSize += size;
+					return aligned;
+				}
+			}
+
+			// Out of blocks. The new one is appended, so blocks skipped this frame stay in use for
+			// the next, and it has room for the request at any alignment.
+			const size_t blockSize = size + alignment > m_blockSize ? size + alignment : m_blockSize;
+			Block block;
+			block.data.reset(new uint8_t[blockSize]);
+			block.size = blockSize;
+			m_blocks.push_back(move(block));
+			m_capacity += blockSize;
+
+			m_block = m_blocks.size() - 1;
+			uint8_t* aligned = AlignUp(m_blocks.back().data.get(), alignment);
+			m_offset = static_cast<size_t>(aligned - m_blocks.back().data.get()) + size;
+			m_usedSize += size;
+			return aligned;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+namespace Query {
+	namespace Memory
+	{
+		// Bump allocator for scratch memory that lives until the end of a frame. Allocate moves a
+		// pointer; Reset rewinds to the first block in O(1) and keeps every block, so a steady
+		// workload stops allocating from the heap after its first frames. Not thread-safe.
+		class FrameArena
+		{
+		private:
+			struct Block
+			{
+				unique_ptr<uint8_t[]> data;
+				size_t size;
+			};
+
+			size_t m_blockSize;
+			vector<Block> m_blocks;
+			size_t m_block = 0;	//block being filled
+			size_t m_offset = 0;	//in that block
+			size_t m_usedSize = 0;
+			size_t m_capacity = 0;
+
+		private:
+			static uint8_t* AlignUp(uint8_t* pointer, size_t alignment)
+			{
+				const uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+				return pointer + ((alignment - address % alignment) % alignment);
+			}
+
+		public:
+			explicit FrameArena(size_t blockSize = 64 * 1024) : m_blockSize(blockSize) {}
+			FrameArena(const FrameArena&) = delete;
+			FrameArena& operator=(const FrameArena&) = delete;
+
+			// alignment must be a power of two. Never returns nullptr; sizes larger than the block
+			// size get a block of their own.
+			void* Allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+			template<typename T>
+			T* Allocate(size_t count) { return static_cast<T*>(Allocate(count * sizeof(T), alignof(T))); }
+
+			// Invalidates everything allocated since the last Reset.
+			void Reset()
+			{
+				m_block = 0;
+				m_offset = 0;
+				m_usedSize = 0;
+			}
+
+			size_t GetUsedSize() const { return m_usedSize; }
+			size_t GetCapacity() const { return m_capacity; }
+			size_t GetBlockCount() const { return m_blocks.size(); }
+		};
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+namespace Query {
+	namespace Hash
+	{
+		// Streaming 64-bit FNV-1a. The value only depends on the bytes fed in, so hashes are stable
+		// across runs and platforms and can be persisted as cache keys.
+		class Hasher
+		{
+		private:
+			static const uint64_t OffsetBasis = 14695981039346656037ull;
+			static const uint64_t Prime = 1099511628211ull;
+
+			uint64_t m_state = OffsetBasis;
+
+		public:
+			Hasher() = default;
+			// Another starting state gives a different hash of the same bytes.
+			explicit Hasher(uint64_t basis) : m_state(basis) {}
+
+			void Add(const void* data, size_t size)
+			{
+				auto bytes = static_cast<const uint8_t*>(data);
+				uint64_t state = m_state;
+				for (size_t i = 0; i < size; i++)
+				{
+					state = (state ^ bytes[i]) * Prime;
+				}
+				m_state = state;
+			}
+
+			// Only for types without padding or pointers.
+			template<typename T>
+			void AddValue(const T& value)
+			{
+				Add(&value, sizeof(T));
+			}
+
+			// Includes the terminator so that ("ab", "c") and ("a", "bc") hash differently.
+			// A null string hashes differently from an empty one.
+			void AddString(const char* text)
+			{
+				if (!text)
+				{
+					AddValue<uint8_t>(0xFF);
+					return;
+				}
+				Add(text, strlen(text) + 1);
+			}
+
+			uint64_t Get() const { return m_state; }
+		};
+
+		inline uint64_t Compute(const void* data, size_t size)
+		{
+			Hasher hasher;
+			hasher.Add(data, size);
+			return hasher.Get();
+		}
+	}
+}
@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "HeadlessRunner.h"
+#include "NullBackend.h"
+#include "SoftwareBackend.h"
+#include "QueryRenderer.h"
+#include "CommandTrace.h"
+
+namespace Query {
+	namespace Headless
+	{
+		namespace
+		{
+			// The pipeline slots of captured traces.
+			enum PipelineSlot : uint32_t
+			{
+				ScenePipeline,
+				QueryPipeline
+			};
+
+			// Startup submissions are not part of the measurement.
+			template<typename Queue>
+			RunResult Measure(Rendering::QueryRenderer& renderer, const Queue& queue, uint32_t frames)
+			{
+				const auto before = queue.GetStats();
+				auto start = chrono::steady_clock::now();
+				for (uint32_t i = 0; i < frames; i++)
+				{
+					renderer.Update();
+					renderer.Render();
+				}
+				renderer.WaitForGpu();
+				auto end = chrono::steady_clock::now();
+				const auto& after = queue.GetStats();
+
+				RunResult result;
+				result.frames = frames;
+				result.seconds = chrono::duration<double>(end - start).count();
+				result.framesPerSecond = result.seconds > 0 ? frames / result.seconds : 0;
+				result.microsecondsPerFrame = frames ? result.seconds * 1e6 / frames : 0;
+				result.commands = after.commands - before.commands;
+				result.draws = after.draws - before.draws;
+				result.predicatedDraws = after.predicatedDraws - before.predicatedDraws;
+				return result;
+			}
+		}
+
+		RunResult Run(uint32_t frames, uint32_t width, uint32_t height, uint32_t occlusionPeriod)
+		{
+			Backend::Null::Device device;
+			Backend::Null::SwapChain swapChain(Rendering::QueryRenderer::FrameCount, width, height);
+			Backend::Null::Pipeline scenePipeline("Scene");
+			Backend::Null::Pipeline queryPipeline("Query");
+			device.GetNullQueue().SetOcclusionPeriod(occlusionPeriod);
+
+			Rendering::QueryRenderer renderer;
+			renderer.Initialize(&device, &swapChain, width, height);
+			renderer.SetPipelines(&scenePipeline, &queryPipeline);
+			RunResult result = Measure(renderer, device.GetNullQueue(), frames);
+			result.backend = "null";
+			result.width = width;
+			result.height = height;
+			return result;
+		}
+
+		RunResult RunSoftware(uint32_t frames, uint32_t width, uint32_t height, uint32_t threadCount)
+		{
+			Threading::ThreadPool threadPool;
+			threadPool.Initialize(threadCount);
+
+			Backend::Software::Device device(&threadPool);
+			Backend::Software::SwapChain swapChain(Rendering::QueryRenderer::FrameCount, width, height);
+			// Same as D3D12Query's PSOs: the query PSO writes neither color nor depth.
+			Backend::Software::PipelineDesc queryDesc;
+			queryDesc.colorWrite = false;
+			queryDesc.depthWrite = false;
+			Backend::Software::Pipeline scenePipeline("Scene", Backend::Software::PipelineDesc());
+			Backend::Software::Pipeline queryPipeline("Query", queryDesc);
+
+			Rendering::QueryRenderer renderer;
+			renderer.Initialize(&device, &swapChain, width, height);
+			renderer.SetPipelines(&scenePipeline, &queryPipeline);
+
+			const uint64_t samplesBefore = device.GetSoftwareQueue().GetStats().samplesPassed;
+			RunResult result = Measure(renderer, device.GetSoftwareQueue(), frames);
+			result.backend = "software";
+			result.width = width;
+			result.height = height;
+			result.samplesPassed = device.GetSoftwareQueue().GetStats().samplesPassed - samplesBefore;
+			return result;
+		}
+
+		RunResult RunCaptured(const wstring& path, uint32_t frames, uint32_t width, uint32_t height, uint32_t occlusionPeriod)
+		{
+			Backend::Null::Device device;
+			Backend::Null::SwapChain swapChain(Rendering::QueryRenderer::FrameCount, width, height);
+			Backend::Null::Pipeline scenePipeline("Scene");
+			Backend::Null::Pipeline queryPipeline("Query");
+			device.GetNullQueue().SetOcclusionPeriod(occlusionPeriod);
+
+			Capture::TraceWriter writer;
+			Capture::CaptureDevice captureDevice(&device, &writer);
+			writer.DeclarePipeline(&scenePipeline, ScenePipeline);
+			writer.DeclarePipeline(&queryPipeline, QueryPipeline);
+
+			Rendering::QueryRenderer renderer;
+			renderer.Initialize(&captureDevice, &swapChain, width, height);
+			renderer.SetPipelines(&scenePipeline, &queryPipeline);
+			RunResult result = Measure(renderer, device.GetNullQueue(), frames);
+			result.backend = "null, captured";
+			result.width = width;
+			result.height = height;
+			writer.Save(path);
+			return result;
+		}
+
+		RunResult Replay(const wstring& path, bool software, uint32_t threadCount)
+		{
+			Capture::TraceReplayer replayer;
+			if (!replayer.Open(path))
+			{
+				return RunResult();
+			}
+
+			Threading::ThreadPool threadPool;
+			unique_ptr<Backend::IDevice> device;
+			vector<unique_ptr<Backend::IPipeline>> pipelines;
+			if (software)
+			{
+				threadPool.Initialize(threadCount);
+				device = make_unique<Backend::Software::Device>(&threadPool);
+				Backend::Software::PipelineDesc queryDesc;
+				queryDesc.colorWrite = false;
+				queryDesc.depthWrite = false;
+				pipelines.push_back(make_unique<Backend::Software::Pipeline>("Scene", Backend::Software::PipelineDesc()));
+				pipelines.push_back(make_unique<Backend::Software::Pipeline>("Query", queryDesc));
+			}
+			else
+			{
+				auto nullDevice = make_unique<Backend::Null::Device>();
+				nullDevice->GetNullQueue().SetOcclusionPeriod(3);	//Run's default
+				device = move(nullDevice);
+				pipelines.push_back(make_unique<Backend::Null::Pipeline>("Scene"));
+				pipelines.push_back(make_unique<Backend::Null::Pipeline>("Query"));
+			}
+
+			if (!replayer.Load(device.get(), { pipelines[ScenePipeline].get(), pipelines[QueryPipeline].get() }))
+			{
+				return RunResult();
+			}
+			const auto stats = replayer.Run();
+
+			RunResult result;
+			result.backend = software ? "software replay" : "null replay";
+			result.frames = stats.submits;
+			result.seconds = stats.seconds;
+			result.framesPerSecond = result.seconds > 0 ? stats.submits / result.seconds : 0;
+			result.microsecondsPerFrame = stats.submits ? result.seconds * 1e6 / stats.submits : 0;
+			result.commands = stats.commands;
+			if (software)
+			{
+				const auto& queueStats = static_cast<Backend::Software::Device*>(device.get())->GetSoftwareQueue().GetStats();
+				result.draws = queueStats.draws;
+				result.predicatedDraws = queueStats.predicatedDraws;
+				result.samplesPassed = queueStats.samplesPassed;
+			}
+			else
+			{
+				const auto& queueStats = static_cast<Backend::Null::Device*>(device.get())->GetNullQueue().GetStats();
+				result.draws = queueStats.draws;
+				result.predicatedDraws = queueStats.predicatedDraws;
+			}
+			return result;
+		}
+
+		string Report(const RunResult& result)
+		{
+			char text[256];
+			snprintf(text, sizeof(text),
+				"%s: %u frames in %.3f s, %.0f frames/s, %.2f us/frame, %.1f commands/frame, %llu draws, %llu predicated\n",
+				result.backend, result.frames, result.seconds, result.framesPerSecond, result.microsecondsPerFrame,
+				result.frames ? static_cast<double>(result.commands) / result.frames : 0.0,
+				static_cast<unsigned long long>(result.draws), static_cast<unsigned long long>(result.predicatedDraws));
+			string report = text;
+			if (result.samplesPassed && result.frames)
+			{
+				snprintf(text, sizeof(text), "  %.0f samples/frame passed the depth test\n",
+					static_cast<double>(result.samplesPassed) / result.frames);
+				report += text;
+			}
+			return report;
+		}
+
+		string ToJson(const vector<RunResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"headless\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const RunResult& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"backend\": \"%s\", \"width\": %u, \"height\": %u, \"frames\": %u, \"seconds\": %.3f, "
+					"\"framesPerSecond\": %.0f, \"usPerFrame\": %.2f, \"commands\": %llu, \"draws\": %llu, "
+					"\"predicatedDraws\": %llu, \"samplesPassed\": %llu }",
+					i ? "," : "",
+					result.backend, result.width, result.height, result.frames, result.seconds,
+					result.framesPerSecond, result.microsecondsPerFrame, static_cast<unsigned long long>(result.commands),
+					static_cast<unsigned long long>(result.draws), static_cast<unsigned long long>(result.predicatedDraws),
+					static_cast<unsigned long long>(result.samplesPassed));
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+namespace Query {
+	namespace Headless
+	{
+		struct RunResult
+		{
+			const char* backend = "none";	//what ran the frames, for the report
+			uint32_t width = 0, height = 0;	//0 for replays, which take the trace's
+			uint32_t frames = 0;
+			double seconds = 0;
+			double framesPerSecond = 0;
+			double microsecondsPerFrame = 0;
+			uint64_t commands = 0;
+			uint64_t draws = 0;
+			uint64_t predicatedDraws = 0;
+			uint64_t samplesPassed = 0;	//software backend only
+		};
+
+		// Runs the frame loop on the null backend, so the result is the CPU cost of our own code:
+		// render graph execution, command recording and frame pacing, without driver or GPU time.
+		// occlusionPeriod is forwarded to the null queue to exercise both predication outcomes.
+		RunResult Run(uint32_t frames, uint32_t width = 1280, uint32_t height = 720, uint32_t occlusionPeriod = 3);
+
+		// The same loop on the software rasterizer, which runs the shaders and the occlusion queries
+		// for real. threadCount is the size of the tile worker pool, 0 for one per hardware thread.
+		RunResult RunSoftware(uint32_t frames, uint32_t width = 1280, uint32_t height = 720, uint32_t threadCount = 0);
+
+		// Run with every command captured into a trace saved at path, to measure the capture overhead
+		// and produce traces for Replay.
+		RunResult RunCaptured(const wstring& path, uint32_t frames, uint32_t width = 1280, uint32_t height = 720, uint32_t occlusionPeriod = 3);
+
+		// Replays a trace on the null or the software backend. Object creation is not timed; frames
+		// counts the submissions, startup included, and commands the decoded trace records.
+		RunResult Replay(const wstring& path, bool software, uint32_t threadCount = 0);
+
+		string Report(const RunResult& result);
+		string ToJson(const vector<RunResult>& results);
+	}
+}
@@ -0,0 +1,313 @@
+#include "pch.h"
+#include "HeapAllocator.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Query {
+	namespace Memory
+	{
+		static uint32_t HighestBit(uint64_t value)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return index;
+#else
+			return 63 - __builtin_clzll(value);
+#endif
+		}
+
+		static uint32_t LowestBit(uint64_t value)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, value);
+			return index;
+#else
+			return __builtin_ctzll(value);
+#endif
+		}
+
+		static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		TlsfAllocator::TlsfAllocator(uint64_t capacity, uint64_t granularity) :
+			m_capacity(capacity / granularity * granularity),
+			m_granularity(granularity)
+		{
+			for (auto& heads : m_freeHeads)
+			{
+				for (auto& head : heads) head = InvalidNode;
+			}
+
+			// The whole range starts as one free block. Node 0 always stays the lowest block
+			// because splits keep the front part in the original node.
+			Block block = {};
+			block.offset = 0;
+			block.size = m_capacity;
+			block.prevPhysical = block.nextPhysical = InvalidNode;
+			block.free = true;
+			m_blocks.push_back(block);
+			if (m_capacity > 0) InsertFree(0);
+		}
+
+		// Sizes are expressed in granularity units. Below SecondLevelCount units every size gets its
+		// own class; above that, each power of two is split into SecondLevelCount classes.
+		void TlsfAllocator::Mapping(uint64_t units, uint32_t& fl, uint32_t& sl)
+		{
+			if (units < SecondLevelCount)
+			{
+				fl = 0;
+				sl = static_cast<uint32_t>(units);
+			}
+			else
+			{
+				uint32_t bit = HighestBit(units);
+				sl = static_cast<uint32_t>(units >> (bit - SecondLevelLog2)) ^ SecondLevelCount;
+				fl = bit - SecondLevelLog2 + 1;
+			}
+		}
+
+		uint32_t TlsfAllocator::FindFreeBlock(uint64_t units) const
+		{
+			// Round up to the next class boundary so that any block in the found list is big enough.
+			if (units >= SecondLevelCount)
+			{
+				units += (1ull << (HighestBit(units) - SecondLevelLog2)) - 1;
+			}
+
+			uint32_t fl, sl;
+			Mapping(units, fl, sl);
+			if (fl >= FirstLevelCount) return InvalidNode;
+
+			uint32_t slMap = sl < SecondLevelCount ? m_secondLevelBitmap[fl] & (~0u << sl) : 0;
+			if (!slMap)
+			{
+				uint64_t flMap = fl + 1 < 64 ? m_firstLevelBitmap & (~0ull << (fl + 1)) : 0;
+				if (!flMap) return InvalidNode;
+
+				fl = LowestBit(flMap);
+				slMap = m_secondLevelBitmap[fl];
+			}
+			sl = LowestBit(slMap);
+			return m_freeHeads[fl][sl];
+		}
+
+		uint32_t TlsfAllocator::FindFittingBlock(uint64_t size, uint64_t alignment) const
+		{
+			// FindFreeBlock came back empty, so no class from the rounded-up request on holds a block,
+			// and the fitting ones can only be in the classes from the size itself up to it.
+			uint32_t fl, sl;
+			Mapping(size / m_granularity, fl, sl);
+			for (; fl < FirstLevelCount; fl++, sl = 0)
+			{
+				for (uint32_t slMap = m_secondLevelBitmap[fl] & (~0u << sl); slMap; slMap &= slMap - 1)
+				{
+					for (uint32_t node = m_freeHeads[fl][LowestBit(slMap)]; node != InvalidNode; node = m_blocks[node].nextFree)
+					{
+						const Block& block = m_blocks[node];
+						if (AlignUp(block.offset, alignment) - block.offset + size <= block.size) return node;
+					}
+				}
+			}
+			return InvalidNode;
+		}
+
+		void TlsfAllocator::InsertFree(uint32_t node)
+		{
+			Block& block = m_blocks[node];
+			uint32_t fl, sl;
+			Mapping(block.size / m_granularity, fl, sl);
+
+			uint32_t head = m_freeHeads[fl][sl];
+			block.free = true;
+			block.prevFree = InvalidNode;
+			block.nextFree = head;
+			if (head != InvalidNode) m_blocks[head].prevFree = node;
+
+			m_freeHeads[fl][sl] = node;
+			m_firstLevelBitmap |= 1ull << fl;
+			m_secondLevelBitmap[fl] |= 1u << sl;
+		}
+
+		void TlsfAllocator::RemoveFree(uint32_t node)
+		{
+			Block& block = m_blocks[node];
+			uint32_t fl, sl;
+			Mapping(block.size / m_granularity, fl, sl);
+
+			if (block.prevFree != InvalidNode) m_blocks[block.prevFree].nextFree = block.nextFree;
+			if (block.nextFree != InvalidNode) m_blocks[block.nextFree].prevFree = block.prevFree;
+
+			if (m_freeHeads[fl][sl] == node)
+			{
+				m_freeHeads[fl][sl] = block.nextFree;
+				if (block.nextFree == InvalidNode)
+				{
+					m_secondLevelBitmap[fl] &= ~(1u << sl);
+					if (!m_secondLevelBitmap[fl]) m_firstLevelBitmap &= ~(1ull << fl);
+				}
+			}
+			block.free = false;
+			block.prevFree = block.nextFree = InvalidNode;
+		}
+
+		uint32_t TlsfAllocator::NewNode()
+		{
+			if (!m_unusedNodes.empty())
+			{
+				uint32_t node = m_unusedNodes.back();
+				m_unusedNodes.pop_back();
+				return node;
+			}
+			m_blocks.push_back({});
+			return static_cast<uint32_t>(m_blocks.size() - 1);
+		}
+
+		// Splits a block that is not in any free list. The original node keeps the front part and the
+		// returned node holds the rest.
+		uint32_t TlsfAllocator::Split(uint32_t node, uint64_t frontSize)
+		{
+			uint32_t back = NewNode();
+			Block& front = m_blocks[node];
+			Block& rest = m_blocks[back];
+
+			rest.offset = front.offset + frontSize;
+			rest.size = front.size - frontSize;
+			rest.prevPhysical = node;
+			rest.nextPhysical = front.nextPhysical;
+			rest.prevFree = rest.nextFree = InvalidNode;
+			rest.free = false;
+			if (front.nextPhysical != InvalidNode) m_blocks[front.nextPhysical].prevPhysical = back;
+
+			front.size = frontSize;
+			front.nextPhysical = back;
+			return back;
+		}
+
+		void TlsfAllocator::Merge(uint32_t front, uint32_t back)
+		{
+			Block& a = m_blocks[front];
+			Block& b = m_blocks[back];
+
+			a.size += b.size;
+			a.nextPhysical = b.nextPhysical;
+			if (b.nextPhysical != InvalidNode) m_blocks[b.nextPhysical].prevPhysical = front;
+
+			b = {};
+			m_unusedNodes.push_back(back);
+		}
+
+		bool TlsfAllocator::Allocate(uint64_t size, uint64_t alignment, Allocation& allocation)
+		{
+			allocation = {};
+			if (size == 0) return false;
+
+			size = AlignUp(size, m_granularity);
+			alignment = alignment > m_granularity ? alignment : m_granularity;
+			if (size > m_capacity) return false;
+
+			// Ask for enough room to absorb the worst-case front padding.
+			uint64_t request = size + (alignment - m_granularity);
+			uint32_t node = FindFreeBlock(request / m_granularity);
+			if (node == InvalidNode) node = FindFittingBlock(size, alignment);
+			if (node == InvalidNode) return false;
+			RemoveFree(node);
+
+			uint64_t padding = AlignUp(m_blocks[node].offset, alignment) - m_blocks[node].offset;
+			if (padding > 0)
+			{
+				uint32_t aligned = Split(node, padding);
+				InsertFree(node);
+				node = aligned;
+			}
+			if (m_blocks[node].size > size)
+			{
+				InsertFree(Split(node, size));
+			}
+
+			allocation.offset = m_blocks[node].offset;
+			allocation.size = m_blocks[node].size;
+			allocation.node = node;
+
+			m_usedSize += allocation.size;
+			m_allocationCount++;
+			return true;
+		}
+
+		void TlsfAllocator::Free(const Allocation& allocation)
+		{
+			if (!allocation.IsValid()) return;
+
+			uint32_t node = allocation.node;
+			m_usedSize -= m_blocks[node].size;
+			m_allocationCount--;
+
+			uint32_t next = m_blocks[node].nextPhysical;
+			if (next != InvalidNode && m_blocks[next].free)
+			{
+				RemoveFree(next);
+				Merge(node, next);
+			}
+			uint32_t prev = m_blocks[node].prevPhysical;
+			if (prev != InvalidNode && m_blocks[prev].free)
+			{
+				RemoveFree(prev);
+				Merge(prev, node);
+				node = prev;
+			}
+			InsertFree(node);
+		}
+
+		bool TlsfAllocator::Validate() const
+		{
+			uint64_t offset = 0, used = 0;
+			uint32_t allocations = 0, freeBlocks = 0;
+			bool previousFree = false;
+
+			uint32_t prev = InvalidNode;
+			for (uint32_t node = m_capacity > 0 ? 0 : InvalidNode; node != InvalidNode; node = m_blocks[node].nextPhysical)
+			{
+				const Block& block = m_blocks[node];
+				if (block.offset != offset || block.size == 0 || block.size % m_granularity) return false;
+				if (block.prevPhysical != prev) return false;
+				// Two adjacent free blocks mean a missed merge.
+				if (block.free && previousFree) return false;
+
+				if (block.free) freeBlocks++;
+				else { used += block.size; allocations++; }
+
+				previousFree = block.free;
+				offset += block.size;
+				prev = node;
+			}
+			if (offset != m_capacity || used != m_usedSize || allocations != m_allocationCount) return false;
+
+			uint32_t listed = 0;
+			for (uint32_t fl = 0; fl < FirstLevelCount; fl++)
+			{
+				bool flBit = (m_firstLevelBitmap >> fl) & 1;
+				if (flBit != (m_secondLevelBitmap[fl] != 0)) return false;
+
+				for (uint32_t sl = 0; sl < SecondLevelCount; sl++)
+				{
+					uint32_t head = m_freeHeads[fl][sl];
+					if (((m_secondLevelBitmap[fl] >> sl) & 1) != (head != InvalidNode)) return false;
+
+					for (uint32_t node = head; node != InvalidNode; node = m_blocks[node].nextFree)
+					{
+						uint32_t blockFl, blockSl;
+						Mapping(m_blocks[node].size / m_granularity, blockFl, blockSl);
+						if (!m_blocks[node].free || blockFl != fl || blockSl != sl) return false;
+						listed++;
+					}
+				}
+			}
+			return listed == freeBlocks;
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+namespace Query {
+	namespace Memory
+	{
+		// Two-level segregated fit (TLSF) allocator over an abstract [0, capacity) address range.
+		// It only hands out offsets, so the same code manages ID3D12Heap blocks and can be exercised
+		// without a device. Allocate and Free are O(1): the first level splits sizes by power of two,
+		// the second level splits each power of two into SecondLevelCount linear classes. Only when
+		// no class is large enough throughout does Allocate search the smaller classes block by block,
+		// so that a block that fits with little room to spare, such as a dedicated heap of exactly
+		// the resource's size, is still used.
+		class TlsfAllocator
+		{
+		public:
+			static const uint32_t InvalidNode = ~0u;
+
+			struct Allocation
+			{
+				uint64_t offset = 0;
+				uint64_t size = 0;
+				uint32_t node = InvalidNode;
+
+				bool IsValid() const { return node != InvalidNode; }
+			};
+
+		private:
+			static const uint32_t SecondLevelLog2 = 4;
+			static const uint32_t SecondLevelCount = 1u << SecondLevelLog2;
+			static const uint32_t FirstLevelCount = 64 - SecondLevelLog2 + 1;
+
+			struct Block
+			{
+				uint64_t offset;
+				uint64_t size;
+				uint32_t prevPhysical, nextPhysical;
+				uint32_t prevFree, nextFree;
+				bool free;
+			};
+
+			uint64_t m_capacity;
+			uint64_t m_granularity;
+			uint64_t m_usedSize = 0;
+			uint32_t m_allocationCount = 0;
+
+			vector<Block> m_blocks;
+			vector<uint32_t> m_unusedNodes;
+
+			uint64_t m_firstLevelBitmap = 0;
+			uint32_t m_secondLevelBitmap[FirstLevelCount] = {};
+			uint32_t m_freeHeads[FirstLevelCount][SecondLevelCount];
+
+		private:
+			static void Mapping(uint64_t units, uint32_t& fl, uint32_t& sl);
+			uint32_t FindFreeBlock(uint64_t units) const;
+			uint32_t FindFittingBlock(uint64_t size, uint64_t alignment) const;
+			void InsertFree(uint32_t node);
+			void RemoveFree(uint32_t node);
+			uint32_t NewNode();
+			uint32_t Split(uint32_t node, uint64_t frontSize);
+			void Merge(uint32_t front, uint32_t back);
+
+		public:
+			// granularity is the smallest unit handed out; every size and alignment is rounded up to it.
+			TlsfAllocator(uint64_t capacity, uint64_t granularity = 4096);
+
+			bool Allocate(uint64_t size, uint64_t alignment, Allocation& allocation);
+			void Free(const Allocation& allocation);
+
+			uint64_t GetCapacity() const { return m_capacity; }
+			uint64_t GetUsedSize() const { return m_usedSize; }
+			uint32_t GetAllocationCount() const { return m_allocationCount; }
+			bool IsEmpty() const { return m_allocationCount == 0; }
+
+			// Walks the physical block chain and the free lists and checks every invariant.
+			// Cheap enough to call after each operation when fuzzing the allocator.
+			bool Validate() const;
+		};
+	}
+}
@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "HeapManager.h"
+
+namespace Query {
+	namespace Memory
+	{
+		void HeapManager::Initialize(ID3D12Device* device, UINT64 blockSize)
+		{
+			m_device = device;
+			m_blockSize = blockSize;
+
+			const D3D12_HEAP_TYPE heapTypes[HeapTypeCount] = { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_TYPE_UPLOAD, D3D12_HEAP_TYPE_READBACK };
+			const D3D12_HEAP_FLAGS heapFlags[CategoryCount] =
+			{
+				D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+				D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+				D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+			};
+
+			for (UINT type = 0; type < HeapTypeCount; type++)
+			{
+				for (UINT category = 0; category < CategoryCount; category++)
+				{
+					Pool& pool = m_pools[type * CategoryCount + category];
+					pool.heapType = heapTypes[type];
+					pool.heapFlags = heapFlags[category];
+					// Only render targets and depth buffers can be multisampled, and those need 4MB placement.
+					pool.heapAlignment = category == TargetTextures ?
+						D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT :
+						D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+					pool.blocks.clear();
+				}
+			}
+		}
+
+		HeapManager::ResourceCategory HeapManager::GetCategory(const D3D12_RESOURCE_DESC& desc)
+		{
+			if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			{
+				return Buffers;
+			}
+			if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+			{
+				return TargetTextures;
+			}
+			return NonTargetTextures;
+		}
+
+		UINT HeapManager::AddBlock(Pool& pool, UINT64 minSize)
+		{
+			// Resources larger than a block get a dedicated heap of their own size.
+			UINT64 size = (minSize + pool.heapAlignment - 1) / pool.heapAlignment * pool.heapAlignment;
+			if (size < m_blockSize) size = m_blockSize;
+
+			CD3DX12_HEAP_DESC heapDesc(size, pool.heapType, pool.heapAlignment, pool.heapFlags);
+			ComPtr<ID3D12Heap> heap;
+			if (FAILED(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap))))
+			{
+				return UINT_MAX;
+			}
+
+			unique_ptr<Block> block(new Block{ heap, TlsfAllocator(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT) });
+
+			// Reuse a slot released by Free so that the indices held by live allocations stay valid.
+			for (UINT i = 0; i < pool.blocks.size(); i++)
+			{
+				if (!pool.blocks[i])
+				{
+					pool.blocks[i] = move(block);
+					return i;
+				}
+			}
+			pool.blocks.push_back(move(block));
+			return static_cast<UINT>(pool.blocks.size() - 1);
+		}
+
+		bool HeapManager::Allocate(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc, UINT64 size, UINT64 alignment, Allocation& allocation)
+		{
+			allocation = {};
+			if (heapType < D3D12_HEAP_TYPE_DEFAULT || heapType > D3D12_HEAP_TYPE_READBACK)
+			{
+				return false;
+			}
+
+			lock_guard<mutex> lock(m_mutex);
+
+			UINT poolIndex = (heapType - D3D12_HEAP_TYPE_DEFAULT) * CategoryCount + GetCategory(desc);
+			Pool& pool = m_pools[poolIndex];
+			if (alignment < D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT) alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+			for (UINT i = 0; i < pool.blocks.size(); i++)
+			{
+				if (pool.blocks[i] && pool.blocks[i]->allocator.Allocate(size, alignment, allocation.range))
+				{
+					allocation.pool = poolIndex;
+					allocation.block = i;
+					return true;
+				}
+			}
+
+			UINT blockIndex = AddBlock(pool, size);
+			if (blockIndex == UINT_MAX)
+			{
+				return false;
+			}
+			if (!pool.blocks[blockIndex]->allocator.Allocate(size, alignment, allocation.range))
+			{
+				pool.blocks[blockIndex].reset();
+				return false;
+			}
+			allocation.pool = poolIndex;
+			allocation.block = blockIndex;
+			return true;
+		}
+
+		ID3D12Heap* HeapManager::GetHeap(const Allocation& allocation) const
+		{
+			lock_guard<mutex> lock(m_mutex);
+			return m_pools[allocation.pool].blocks[allocation.block]->heap.Get();
+		}
+
+		HRESULT HeapManager::CreateResource(
+			D3D12_HEAP_TYPE heapType,
+			const D3D12_RESOURCE_DESC* pDesc,
+			D3D12_RESOURCE_STATES initialState,
+			const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+			Allocation* pAllocation,
+			REFIID riid, void** ppResource)
+		{
+			D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, pDesc);
+			if (info.SizeInBytes == UINT64_MAX)
+			{
+				return E_INVALIDARG;
+			}
+
+			Allocation allocation;
+			if (!Allocate(heapType, *pDesc, info.SizeInBytes, info.Alignment, allocation))
+			{
+				return E_OUTOFMEMORY;
+			}
+
+			HRESULT hr = m_device->CreatePlacedResource(
+				GetHeap(allocation), allocation.range.offset,
+				pDesc, initialState, pOptimizedClearValue, riid, ppResource);
+			if (FAILED(hr))
+			{
+				Free(allocation);
+				return hr;
+			}
+
+			*pAllocation = allocation;
+			return hr;
+		}
+
+		void HeapManager::Free(Allocation& allocation)
+		{
+			if (!allocation.IsValid())
+			{
+				return;
+			}
+
+			lock_guard<mutex> lock(m_mutex);
+
+			Pool& pool = m_pools[allocation.pool];
+			auto& block = pool.blocks[allocation.block];
+			block->allocator.Free(allocation.range);
+
+			// Keep the first block of every pool around so that streaming a single object in and out
+			// does not create and destroy a heap each time, unless it is a dedicated one.
+			if (block->allocator.IsEmpty() && (allocation.block != 0 || block->allocator.GetCapacity() != m_blockSize))
+			{
+				block.reset();
+			}
+			allocation = {};
+		}
+
+		UINT64 HeapManager::GetReservedSize() const
+		{
+			lock_guard<mutex> lock(m_mutex);
+
+			UINT64 size = 0;
+			for (auto& pool : m_pools)
+			{
+				for (auto& block : pool.blocks)
+				{
+					if (block) size += block->allocator.GetCapacity();
+				}
+			}
+			return size;
+		}
+
+		UINT64 HeapManager::GetUsedSize() const
+		{
+			lock_guard<mutex> lock(m_mutex);
+
+			UINT64 size = 0;
+			for (auto& pool : m_pools)
+			{
+				for (auto& block : pool.blocks)
+				{
+					if (block) size += block->allocator.GetUsedSize();
+				}
+			}
+			return size;
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "HeapAllocator.h"
+
+namespace Query {
+	namespace Memory
+	{
+		using Microsoft::WRL::ComPtr;
+
+		// Places resources into large ID3D12Heap blocks instead of giving every resource its own
+		// implicit heap. Blocks are reserved per heap type and per resource category so that the
+		// manager also works on resource heap tier 1 hardware.
+		class HeapManager
+		{
+		public:
+			// Resource heap tier 1 hardware cannot mix these in one heap.
+			enum ResourceCategory
+			{
+				Buffers,
+				NonTargetTextures,
+				TargetTextures,
+				CategoryCount
+			};
+
+			struct Allocation
+			{
+				UINT pool = 0;
+				UINT block = 0;
+				TlsfAllocator::Allocation range;
+
+				bool IsValid() const { return range.IsValid(); }
+			};
+
+		private:
+			static const UINT HeapTypeCount = 3;	//DEFAULT, UPLOAD, READBACK
+
+			struct Block
+			{
+				ComPtr<ID3D12Heap> heap;
+				TlsfAllocator allocator;
+			};
+
+			struct Pool
+			{
+				D3D12_HEAP_TYPE heapType;
+				D3D12_HEAP_FLAGS heapFlags;
+				UINT64 heapAlignment;
+				vector<unique_ptr<Block>> blocks;
+			};
+
+			ComPtr<ID3D12Device> m_device;
+			UINT64 m_blockSize = 0;
+			Pool m_pools[HeapTypeCount * CategoryCount];
+			mutable mutex m_mutex;
+
+		private:
+			UINT AddBlock(Pool& pool, UINT64 minSize);
+
+		public:
+			static const UINT64 DefaultBlockSize = 64ull * 1024 * 1024;
+
+			static ResourceCategory GetCategory(const D3D12_RESOURCE_DESC& desc);
+
+			void Initialize(ID3D12Device* device, UINT64 blockSize = DefaultBlockSize);
+
+			// Same contract as ID3D12Device::CreateCommittedResource, plus the allocation handle
+			// that has to be given back to Free once the resource has been released.
+			HRESULT CreateResource(
+				D3D12_HEAP_TYPE heapType,
+				const D3D12_RESOURCE_DESC* pDesc,
+				D3D12_RESOURCE_STATES initialState,
+				const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+				Allocation* pAllocation,
+				REFIID riid, void** ppResource);
+
+			// Reserves heap memory without creating a resource, e.g. for aliased placement.
+			bool Allocate(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc, UINT64 size, UINT64 alignment, Allocation& allocation);
+			ID3D12Heap* GetHeap(const Allocation& allocation) const;
+			UINT64 GetOffset(const Allocation& allocation) const { return allocation.range.offset; }
+
+			void Free(Allocation& allocation);
+
+			// Total size of the reserved ID3D12Heap blocks and of the live allocations in them.
+			UINT64 GetReservedSize() const;
+			UINT64 GetUsedSize() const;
+		};
+	}
+}
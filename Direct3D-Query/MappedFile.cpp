@@ -0,0 +1,171 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#endif
+
+namespace Query {
+	namespace IO
+	{
+#if defined(_WIN32)
+		bool MappedFile::Open(const wstring& path)
+		{
+			Close();
+
+			m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+			{
+				Close();
+				return false;
+			}
+
+			m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!m_mapping)
+			{
+				Close();
+				return false;
+			}
+
+			m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			m_size = m_data ? static_cast<size_t>(size.QuadPart) : 0;
+			if (!m_data)
+			{
+				Close();
+				return false;
+			}
+			return true;
+		}
+
+		void MappedFile::Close()
+		{
+			if (m_data) UnmapViewOfFile(m_data);
+			if (m_mapping) CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+
+			m_data = nullptr;
+			m_size = 0;
+			m_mapping = nullptr;
+			m_file = INVALID_HANDLE_VALUE;
+		}
+
+		bool MappedFile::WriteAtomically(const wstring& path, const void* data, size_t size)
+		{
+			wstring temporary = path + L".tmp";
+			HANDLE file = CreateFileW(temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			auto bytes = static_cast<const uint8_t*>(data);
+			bool ok = true;
+			while (ok && size > 0)
+			{
+				DWORD chunk = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+				DWORD written = 0;
+				ok = WriteFile(file, bytes, chunk, &written, nullptr) && written == chunk;
+				bytes += chunk;
+				size -= chunk;
+			}
+			CloseHandle(file);
+
+			if (!ok || !MoveFileExW(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+			{
+				DeleteFileW(temporary.c_str());
+				return false;
+			}
+			return true;
+		}
+#else
+		static string NarrowPath(const wstring& path)
+		{
+			string result(path.size() * MB_CUR_MAX + 1, '\0');
+			size_t length = wcstombs(&result[0], path.c_str(), result.size());
+			result.resize(length == static_cast<size_t>(-1) ? 0 : length);
+			return result;
+		}
+
+		bool MappedFile::Open(const wstring& path)
+		{
+			Close();
+
+			m_file = open(NarrowPath(path).c_str(), O_RDONLY);
+			if (m_file < 0)
+			{
+				return false;
+			}
+
+			struct stat info;
+			if (fstat(m_file, &info) != 0 || info.st_size == 0)
+			{
+				Close();
+				return false;
+			}
+
+			void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (view == MAP_FAILED)
+			{
+				Close();
+				return false;
+			}
+			m_data = static_cast<const uint8_t*>(view);
+			m_size = static_cast<size_t>(info.st_size);
+			return true;
+		}
+
+		void MappedFile::Close()
+		{
+			if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+			if (m_file >= 0) close(m_file);
+
+			m_data = nullptr;
+			m_size = 0;
+			m_file = -1;
+		}
+
+		bool MappedFile::WriteAtomically(const wstring& path, const void* data, size_t size)
+		{
+			string target = NarrowPath(path);
+			string temporary = target + ".tmp";
+			FILE* file = fopen(temporary.c_str(), "wb");
+			if (!file)
+			{
+				return false;
+			}
+
+			bool ok = fwrite(data, 1, size, file) == size;
+			ok = fclose(file) == 0 && ok;
+			if (!ok || rename(temporary.c_str(), target.c_str()) != 0)
+			{
+				remove(temporary.c_str());
+				return false;
+			}
+			return true;
+		}
+#endif
+
+		bool MappedFile::ReadAll(const wstring& path, vector<uint8_t>& contents)
+		{
+			MappedFile file;
+			contents.clear();
+			if (!file.Open(path))
+			{
+				return false;
+			}
+			contents.assign(file.GetData(), file.GetData() + file.GetSize());
+			return true;
+		}
+	}
+}
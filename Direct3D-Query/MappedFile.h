@@ -0,0 +1,38 @@
+#pragma once
+
+namespace Query {
+	namespace IO
+	{
+		// Read-only memory mapping of a whole file. The view stays valid until Close or destruction.
+		class MappedFile
+		{
+		private:
+			const uint8_t* m_data = nullptr;
+			size_t m_size = 0;
+#if defined(_WIN32)
+			HANDLE m_file = INVALID_HANDLE_VALUE;
+			HANDLE m_mapping = nullptr;
+#else
+			int m_file = -1;
+#endif
+
+		public:
+			MappedFile() = default;
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			~MappedFile() { Close(); }
+
+			bool Open(const wstring& path);
+			void Close();
+
+			bool IsOpen() const { return m_data != nullptr; }
+			const uint8_t* GetData() const { return m_data; }
+			size_t GetSize() const { return m_size; }
+
+			// Writes a whole file next to the destination and moves it into place, so that readers never
+			// see a partially written file. The destination must not be mapped at the time.
+			static bool WriteAtomically(const wstring& path, const void* data, size_t size);
+			static bool ReadAll(const wstring& path, vector<uint8_t>& contents);
+		};
+	}
+}
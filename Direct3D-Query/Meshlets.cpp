@@ -0,0 +1,273 @@
+#include "pch.h"
+#include "Meshlets.h"
+
+namespace Query {
+	namespace Culling
+	{
+		namespace
+		{
+			const uint32_t Absent = ~0u;	//of a vertex outside the meshlet being built, or of no triangle
+		}
+
+		void MeshletBuilder::Build(const void* vertices, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+			uint32_t maxVertices, uint32_t maxTriangles)
+		{
+			m_meshlets.clear();
+			m_vertices.clear();
+			m_triangles.clear();
+			maxVertices = maxVertices < 3 ? 3 : maxVertices < 256 ? maxVertices : 256;
+			maxTriangles = maxTriangles ? maxTriangles : 1;
+			const uint32_t triangleCount = indexCount / 3;
+			auto position = [=](uint32_t vertex)
+			{
+				return reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + static_cast<size_t>(vertex) * stride);
+			};
+
+			// Centroids, unit normals and the triangles around each vertex.
+			m_centroids.resize(static_cast<size_t>(triangleCount) * 3);
+			m_normals.resize(static_cast<size_t>(triangleCount) * 3);
+			m_adjacencyOffsets.assign(static_cast<size_t>(vertexCount) + 1, 0);
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+			{
+				const uint32_t* corners = indices + static_cast<size_t>(triangle) * 3;
+				const float* a = position(corners[0]);
+				const float* b = position(corners[1]);
+				const float* c = position(corners[2]);
+				float normal[3] = {
+					(b[1] - a[1]) * (c[2] - a[2]) - (b[2] - a[2]) * (c[1] - a[1]),
+					(b[2] - a[2]) * (c[0] - a[0]) - (b[0] - a[0]) * (c[2] - a[2]),
+					(b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]) };
+				const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				const float scale = length > 0 ? 1 / length : 0;
+				for (uint32_t axis = 0; axis < 3; axis++)
+				{
+					m_centroids[triangle * 3 + axis] = (a[axis] + b[axis] + c[axis]) / 3;
+					m_normals[triangle * 3 + axis] = normal[axis] * scale;
+				}
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					m_adjacencyOffsets[corners[corner] + 1]++;
+				}
+			}
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			{
+				m_adjacencyOffsets[vertex + 1] += m_adjacencyOffsets[vertex];
+			}
+			m_adjacency.resize(static_cast<size_t>(triangleCount) * 3);
+			m_local.assign(vertexCount, 0);	//the next free slot of each vertex's triangles, for now
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const uint32_t vertex = indices[triangle * 3 + corner];
+					m_adjacency[m_adjacencyOffsets[vertex] + m_local[vertex]++] = triangle;
+				}
+			}
+			m_live.swap(m_local);	//which now counts each vertex's triangles, all unused
+			m_local.assign(vertexCount, Absent);
+			m_used.assign(triangleCount, 0);
+			m_candidates.clear();
+
+			Meshlet meshlet = {};
+			float sum[3] = {};	//of the meshlet's centroids
+			auto add = [&](uint32_t triangle)
+			{
+				m_used[triangle] = 1;
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const uint32_t vertex = indices[triangle * 3 + corner];
+					m_live[vertex]--;
+					if (m_local[vertex] == Absent)
+					{
+						m_local[vertex] = meshlet.vertexCount++;
+						m_vertices.push_back(vertex);
+						for (uint32_t i = m_adjacencyOffsets[vertex]; i < m_adjacencyOffsets[vertex + 1]; i++)
+						{
+							if (!m_used[m_adjacency[i]])
+							{
+								m_candidates.push_back(m_adjacency[i]);
+							}
+						}
+					}
+					m_triangles.push_back(static_cast<uint8_t>(m_local[vertex]));
+				}
+				m_members.push_back(triangle);
+				meshlet.triangleCount++;
+				for (uint32_t axis = 0; axis < 3; axis++)
+				{
+					sum[axis] += m_centroids[triangle * 3 + axis];
+				}
+			};
+			auto distance = [&](uint32_t triangle, const float* point)
+			{
+				const float* centroid = m_centroids.data() + static_cast<size_t>(triangle) * 3;
+				return (centroid[0] - point[0]) * (centroid[0] - point[0]) + (centroid[1] - point[1]) * (centroid[1] - point[1]) +
+					(centroid[2] - point[2]) * (centroid[2] - point[2]);
+			};
+
+			uint32_t cursor = 0;
+			float last[3] = {};	//center of the last meshlet
+			for (;;)
+			{
+				// The seed: the previous meshlet's nearest unused neighbor, or the first unused triangle.
+				uint32_t seed = Absent;
+				float nearest = FLT_MAX;
+				for (uint32_t candidate : m_candidates)
+				{
+					const float current = m_used[candidate] ? FLT_MAX : distance(candidate, last);
+					if (current < nearest)
+					{
+						nearest = current;
+						seed = candidate;
+					}
+				}
+				if (seed == Absent)
+				{
+					for (; cursor < triangleCount && m_used[cursor]; cursor++);
+					if (cursor == triangleCount)
+					{
+						break;
+					}
+					seed = cursor;
+				}
+				m_candidates.clear();
+				m_members.clear();
+				meshlet = {};
+				meshlet.vertexOffset = static_cast<uint32_t>(m_vertices.size());
+				meshlet.triangleOffset = static_cast<uint32_t>(m_triangles.size());
+				sum[0] = sum[1] = sum[2] = 0;
+				add(seed);
+
+				while (meshlet.triangleCount < maxTriangles)
+				{
+					// Fewest new vertices first, then the fewest unused triangles left around its vertices,
+					// which takes pieces that would otherwise be stranded, then nearest the centroid. Used
+					// candidates are dropped on the way.
+					const float center[3] = { sum[0] / meshlet.triangleCount, sum[1] / meshlet.triangleCount, sum[2] / meshlet.triangleCount };
+					uint32_t best = Absent, bestNew = 4, bestLive = Absent;
+					float bestDistance = FLT_MAX;
+					size_t kept = 0;
+					for (size_t i = 0; i < m_candidates.size(); i++)
+					{
+						const uint32_t candidate = m_candidates[i];
+						if (m_used[candidate])
+						{
+							continue;
+						}
+						m_candidates[kept++] = candidate;
+						const uint32_t* corners = indices + static_cast<size_t>(candidate) * 3;
+						const uint32_t added = (m_local[corners[0]] == Absent) + (m_local[corners[1]] == Absent) + (m_local[corners[2]] == Absent);
+						const uint32_t live = m_live[corners[0]] + m_live[corners[1]] + m_live[corners[2]];
+						if (meshlet.vertexCount + added > maxVertices || added > bestNew || (added == bestNew && live > bestLive))
+						{
+							continue;
+						}
+						const float current = distance(candidate, center);
+						if (added < bestNew || live < bestLive || (live == bestLive && current < bestDistance))
+						{
+							best = candidate;
+							bestNew = added;
+							bestLive = live;
+							bestDistance = current;
+						}
+					}
+					m_candidates.resize(kept);
+					if (best == Absent)
+					{
+						break;
+					}
+					add(best);
+				}
+
+				// Bounds: a sphere about the center of the vertices' box.
+				float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+				{
+					const float* point = position(m_vertices[meshlet.vertexOffset + i]);
+					for (uint32_t axis = 0; axis < 3; axis++)
+					{
+						minimum[axis] = point[axis] < minimum[axis] ? point[axis] : minimum[axis];
+						maximum[axis] = point[axis] > maximum[axis] ? point[axis] : maximum[axis];
+					}
+				}
+				float radius = 0;
+				for (uint32_t axis = 0; axis < 3; axis++)
+				{
+					meshlet.center[axis] = (minimum[axis] + maximum[axis]) / 2;
+				}
+				for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+				{
+					const uint32_t vertex = m_vertices[meshlet.vertexOffset + i];
+					const float* point = position(vertex);
+					const float current = (point[0] - meshlet.center[0]) * (point[0] - meshlet.center[0]) +
+						(point[1] - meshlet.center[1]) * (point[1] - meshlet.center[1]) + (point[2] - meshlet.center[2]) * (point[2] - meshlet.center[2]);
+					radius = current > radius ? current : radius;
+					m_local[vertex] = Absent;
+				}
+				meshlet.radius = sqrtf(radius);
+
+				// Cone: about the mean normal, as wide as the normal farthest from it. Without a mean, or
+				// with a normal a right angle or more away, no view direction has them all facing away.
+				float axis[3] = {};
+				for (uint32_t triangle : m_members)
+				{
+					for (uint32_t i = 0; i < 3; i++)
+					{
+						axis[i] += m_normals[triangle * 3 + i];
+					}
+				}
+				const float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+				const float scale = length > 0 ? 1 / length : 0;
+				float spread = length > 0 ? 1.0f : -1.0f;	//the least cosine between the axis and a normal
+				for (uint32_t triangle : m_members)
+				{
+					const float* normal = m_normals.data() + static_cast<size_t>(triangle) * 3;
+					const float cosine = (normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2]) * scale;
+					const bool degenerate = normal[0] == 0 && normal[1] == 0 && normal[2] == 0;
+					spread = degenerate || cosine >= spread ? spread : cosine;
+				}
+				for (uint32_t i = 0; i < 3; i++)
+				{
+					meshlet.axis[i] = axis[i] * scale;
+				}
+				meshlet.cutoff = spread > 0 ? sqrtf(1 - spread * spread) : 1.0f;
+				m_meshlets.push_back(meshlet);
+				last[0] = meshlet.center[0];
+				last[1] = meshlet.center[1];
+				last[2] = meshlet.center[2];
+			}
+		}
+
+		void MeshletCuller::Cull(const Meshlet* meshlets, uint32_t count, const View& view, vector<uint32_t>& visible)
+		{
+			visible.clear();
+			m_backfacing = 0;
+			m_occluded = 0;
+			const float* direction = view.direction;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const Meshlet& meshlet = meshlets[i];
+				// Every normal is within the cone, so all face away when its nearest edge to the view
+				// direction does, at less than a right angle: the axis within the complement of its angle.
+				if (meshlet.axis[0] * direction[0] + meshlet.axis[1] * direction[1] + meshlet.axis[2] * direction[2] > meshlet.cutoff)
+				{
+					m_backfacing++;
+					continue;
+				}
+				if (view.pyramid)
+				{
+					const float radius = meshlet.radius;
+					const Bounds bounds = {
+						{ meshlet.center[0] - radius, meshlet.center[1] - radius, meshlet.center[2] - radius },
+						{ meshlet.center[0] + radius, meshlet.center[1] + radius, meshlet.center[2] + radius } };
+					if (view.pyramid->IsOccluded(bounds))
+					{
+						m_occluded++;
+						continue;
+					}
+				}
+				visible.push_back(i);
+			}
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "DepthPyramid.h"
+
+namespace Query {
+	namespace Culling
+	{
+		// A cluster of a mesh's triangles, small enough to be culled as one before its vertices are
+		// processed.
+		struct Meshlet
+		{
+			uint32_t vertexOffset;	//into MeshletBuilder::GetVertices, which holds mesh vertex indices
+			uint32_t triangleOffset;	//into MeshletBuilder::GetTriangles, three local vertex indices per triangle
+			uint32_t vertexCount, triangleCount;
+			float center[3], radius;	//bounding sphere of the vertices
+			// Normal cone: every triangle's normal is within the angle whose sine is cutoff of axis,
+			// and cutoff is 1 when the normals spread over a hemisphere or more.
+			float axis[3], cutoff;
+		};
+
+		// Splits a triangle list into meshlets of at most maxVertices vertices and maxTriangles
+		// triangles, 64 and 124 by default: local indices fit a byte, and 124 triangles are 372
+		// bytes of them, a multiple of four.
+		//
+		// Meshlets grow greedily from a seed triangle through shared vertices, taking next the
+		// triangle that adds the fewest new vertices; among those, the one whose vertices have the
+		// fewest unused triangles left, so that no sliver is left behind to become a meshlet of its
+		// own; and among those, the one whose centroid is nearest the meshlet's, which keeps
+		// meshlets round and their bounds and cones tight. The next seed is the unused neighbor of
+		// the finished meshlet nearest its center, or the first unused triangle when there is none.
+		// On a closed mesh the vertex limit is reached first, at about 90 triangles for 64 vertices.
+		//
+		// Normals follow the right-hand rule, (b - a) x (c - a); triangles without area count
+		// for the bounds only.
+		class MeshletBuilder
+		{
+		public:
+			static const uint32_t DefaultMaxVertices = 64;
+			static const uint32_t DefaultMaxTriangles = 124;
+
+		private:
+			vector<Meshlet> m_meshlets;
+			vector<uint32_t> m_vertices;
+			vector<uint8_t> m_triangles;
+
+			vector<float> m_centroids;	//three per triangle
+			vector<float> m_normals;	//three per triangle, unit length or zero
+			vector<uint32_t> m_adjacencyOffsets;	//per vertex, into m_adjacency, and one past the last
+			vector<uint32_t> m_adjacency;	//triangles using each vertex
+			vector<uint8_t> m_used;
+			vector<uint32_t> m_live;	//per mesh vertex, its unused triangles
+			vector<uint32_t> m_local;	//per mesh vertex, its index in the meshlet being built, or ~0u
+			vector<uint32_t> m_candidates;	//triangles sharing a vertex with the meshlet being built
+			vector<uint32_t> m_members;	//triangles of the meshlet being built
+
+		public:
+			// Positions are the first three floats of each vertex, stride bytes apart.
+			void Build(const void* vertices, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+				uint32_t maxVertices = DefaultMaxVertices, uint32_t maxTriangles = DefaultMaxTriangles);
+
+			const vector<Meshlet>& GetMeshlets() const { return m_meshlets; }
+			const vector<uint32_t>& GetVertices() const { return m_vertices; }
+			const vector<uint8_t>& GetTriangles() const { return m_triangles; }
+		};
+
+		// Rejects the meshlets that cannot contribute a pixel: those whose triangles all face away
+		// along the view direction, by their normal cone, and those whose bounding sphere lies
+		// behind a depth pyramid. Positions are taken as normalized device coordinates with depth
+		// as z, the view looking along direction, (0, 0, 1) for the samples' geometry.
+		class MeshletCuller
+		{
+		public:
+			struct View
+			{
+				float direction[3] = { 0, 0, 1 };	//unit length
+				const DepthPyramid* pyramid = nullptr;	//no occlusion culling when null
+			};
+
+		private:
+			uint32_t m_backfacing = 0;
+			uint32_t m_occluded = 0;
+
+		public:
+			// Replaces visible with the indices of the meshlets that pass.
+			void Cull(const Meshlet* meshlets, uint32_t count, const View& view, vector<uint32_t>& visible);
+
+			// Of the last Cull.
+			uint32_t GetBackfacingCount() const { return m_backfacing; }
+			uint32_t GetOccludedCount() const { return m_occluded; }
+		};
+	}
+}
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "MeshletsBenchmark.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Quad;
+
+		MeshletResult RunMeshlets(const MeshletOptions& options, uint32_t seed)
+		{
+			Random random(seed);
+			vector<vector<float>> positions(options.meshes);
+			vector<vector<uint32_t>> indices(options.meshes);
+			for (uint32_t i = 0; i < options.meshes; i++)
+			{
+				GenerateBlob(random, options.rings, positions[i], indices[i]);
+			}
+			vector<Quad> occluders(options.occluders);
+			for (Quad& quad : occluders)
+			{
+				quad = PlaceQuad(random, options.occluderArea, 0.05f, 0.3f);
+			}
+			const uint32_t width = options.width, height = options.height;
+			vector<float> depth;
+			DrawDepth(occluders, width, height, depth);
+			Culling::DepthPyramid pyramid;
+			pyramid.Build(depth.data(), width, height, width);
+
+			// Every mesh's meshlets in one list, as a frame would cull them; mesh remembers whose each is.
+			MeshletResult result;
+			result.options = options;
+			Culling::MeshletBuilder builder;
+			vector<Culling::Meshlet> meshlets;
+			vector<uint32_t> mesh, meshletVertices;
+			vector<uint8_t> meshletTriangles;
+			uint64_t vertices = 0;
+			const auto buildStart = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < options.meshes; i++)
+			{
+				builder.Build(positions[i].data(), 3 * sizeof(float), static_cast<uint32_t>(positions[i].size() / 3),
+					indices[i].data(), static_cast<uint32_t>(indices[i].size()), options.maxVertices, options.maxTriangles);
+				for (Culling::Meshlet meshlet : builder.GetMeshlets())
+				{
+					meshlet.vertexOffset += static_cast<uint32_t>(meshletVertices.size());
+					meshlet.triangleOffset += static_cast<uint32_t>(meshletTriangles.size());
+					meshlets.push_back(meshlet);
+					mesh.push_back(i);
+					vertices += meshlet.vertexCount;
+					result.triangles += meshlet.triangleCount;
+				}
+				meshletVertices.insert(meshletVertices.end(), builder.GetVertices().begin(), builder.GetVertices().end());
+				meshletTriangles.insert(meshletTriangles.end(), builder.GetTriangles().begin(), builder.GetTriangles().end());
+			}
+			result.buildMilliseconds = MillisecondsSince(buildStart);
+			const uint32_t count = static_cast<uint32_t>(meshlets.size());
+			result.meshlets = count;
+			result.vertices = count ? static_cast<double>(vertices) / count : 0;
+			result.meshletTriangles = count ? static_cast<double>(result.triangles) / count : 0;
+
+			Culling::MeshletCuller culler;
+			Culling::MeshletCuller::View view;
+			view.pyramid = &pyramid;
+			vector<uint32_t> visible;
+			culler.Cull(meshlets.data(), count, view, visible);
+			const auto start = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < options.iterations; i++)
+			{
+				culler.Cull(meshlets.data(), count, view, visible);
+			}
+			const double milliseconds = MillisecondsSince(start);
+			result.cullMicroseconds = options.iterations ? milliseconds * 1000 / options.iterations : 0;
+			result.clustersPerSecond = milliseconds > 0 ? static_cast<double>(count) * options.iterations * 1000 / milliseconds : 0;
+			result.backfacing = count ? static_cast<double>(culler.GetBackfacingCount()) / count : 0;
+			result.occluded = count ? static_cast<double>(culler.GetOccludedCount()) / count : 0;
+			uint64_t submitted = 0;
+			for (uint32_t index : visible)
+			{
+				submitted += meshlets[index].triangleCount;
+			}
+			result.submittedTriangles = result.triangles ? static_cast<double>(submitted) / result.triangles : 0;
+
+			// The triangles that actually face away, by the right-hand rule as the builder takes them.
+			uint64_t backfacingTriangles = 0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const Culling::Meshlet& meshlet = meshlets[i];
+				const float* points = positions[mesh[i]].data();
+				for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+				{
+					const uint8_t* corners = meshletTriangles.data() + meshlet.triangleOffset + triangle * 3;
+					const float* a = points + static_cast<size_t>(meshletVertices[meshlet.vertexOffset + corners[0]]) * 3;
+					const float* b = points + static_cast<size_t>(meshletVertices[meshlet.vertexOffset + corners[1]]) * 3;
+					const float* c = points + static_cast<size_t>(meshletVertices[meshlet.vertexOffset + corners[2]]) * 3;
+					backfacingTriangles += (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]) > 0;
+				}
+			}
+			result.backfacingTriangles = result.triangles ? static_cast<double>(backfacingTriangles) / result.triangles : 0;
+			return result;
+		}
+
+		string ToJson(const vector<MeshletResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"meshlets\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const MeshletResult& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"width\": %u, \"height\": %u, \"meshes\": %u, \"rings\": %u, \"occluders\": %u, \"occluderArea\": %.3f, "
+					"\"maxVertices\": %u, \"maxTriangles\": %u, \"triangles\": %llu, \"meshlets\": %u, \"vertices\": %.1f, \"meshletTriangles\": %.1f, "
+					"\"buildMs\": %.3f, \"cullUs\": %.1f, \"clustersPerSecond\": %.0f, \"backfacing\": %.4f, \"occluded\": %.4f, "
+					"\"submittedTriangles\": %.4f, \"backfacingTriangles\": %.4f }",
+					i ? "," : "",
+					result.options.width, result.options.height, result.options.meshes, result.options.rings, result.options.occluders, result.options.occluderArea,
+					result.options.maxVertices, result.options.maxTriangles, static_cast<unsigned long long>(result.triangles), result.meshlets, result.vertices, result.meshletTriangles,
+					result.buildMilliseconds, result.cullMicroseconds, result.clustersPerSecond, result.backfacing, result.occluded,
+					result.submittedTriangles, result.backfacingTriangles);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
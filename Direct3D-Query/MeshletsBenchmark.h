@@ -0,0 +1,44 @@
+#pragma once
+#include "SceneGenerator.h"
+#include "Meshlets.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct MeshletOptions
+		{
+			uint32_t width = 1920, height = 1080;
+			uint32_t meshes = 16;	//closed, lumpy ellipsoids in depth within (0, 1)
+			uint32_t rings = 96;	//of each mesh, with twice as many segments around, for about 4 * rings^2 triangles
+			uint32_t occluders = 6;	//quads in front of every mesh
+			float occluderArea = 0.4f;	//each, in normalized device coordinates, where the screen is 4
+			uint32_t maxVertices = Culling::MeshletBuilder::DefaultMaxVertices;
+			uint32_t maxTriangles = Culling::MeshletBuilder::DefaultMaxTriangles;
+			uint32_t iterations = 100;	//of the culling pass
+		};
+
+		struct MeshletResult
+		{
+			MeshletOptions options;
+			uint64_t triangles = 0;	//of every mesh
+			uint32_t meshlets = 0;
+			double vertices = 0;	//per meshlet
+			double meshletTriangles = 0;	//per meshlet
+			double buildMilliseconds = 0;	//every mesh
+			double cullMicroseconds = 0;	//per pass over every meshlet
+			double clustersPerSecond = 0;
+			// Fractions of the meshlets rejected as facing away and as occluded, and of the triangles
+			// left to submit, against the fraction that actually face away.
+			double backfacing = 0;
+			double occluded = 0;
+			double submittedTriangles = 0;
+			double backfacingTriangles = 0;
+		};
+
+		// Splits generated meshes into meshlets (see Culling::MeshletBuilder) and culls them against
+		// the view direction and a depth pyramid of occluders in front.
+		MeshletResult RunMeshlets(const MeshletOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<MeshletResult>& results);
+	}
+}
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "NullBackend.h"
+
+namespace Query {
+	namespace Backend
+	{
+		namespace Null
+		{
+			Resource::Resource(const ResourceDesc& desc) : m_desc(desc)
+			{
+				// Textures are never read back, so only buffers get memory.
+				if (desc.kind == ResourceKind::Buffer)
+				{
+					m_memory.resize(static_cast<size_t>(desc.size));
+				}
+			}
+
+			void CommandList::Reset(uint32_t)
+			{
+				m_commands.clear();
+				m_closed = false;
+			}
+
+			void CommandList::Barriers(const Transition* transitions, uint32_t count)
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					Push(Op::Barrier, transitions[i].before, transitions[i].after, transitions[i].resource);
+				}
+			}
+
+			void CommandList::ClearRenderTarget(IResource* target, const float color[4])
+			{
+				uint32_t packed = 0;
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					float channel = color[i] < 0.0f ? 0.0f : (color[i] > 1.0f ? 1.0f : color[i]);
+					packed |= static_cast<uint32_t>(channel * 255.0f + 0.5f) << (i * 8);
+				}
+				Push(Op::ClearRenderTarget, packed, 0, target);
+			}
+
+			void CommandList::ClearDepth(IResource* target, float depth)
+			{
+				uint32_t bits;
+				memcpy(&bits, &depth, sizeof(bits));
+				Push(Op::ClearDepth, bits, 0, target);
+			}
+
+			void Queue::Submit(ICommandList* commandList)
+			{
+				const auto& commands = static_cast<CommandList*>(commandList)->GetCommands();
+				m_stats.submits++;
+				m_stats.commands += commands.size();
+
+				// Predication and queries are the only state whose effect is observable afterwards.
+				const uint64_t* predicate = nullptr;
+				QueryHeap* activeHeap = nullptr;
+				uint32_t activeQuery = 0;
+
+				for (const auto& command : commands)
+				{
+					switch (command.op)
+					{
+					case CommandList::Op::Barrier:
+						m_stats.barriers++;
+						break;
+
+					case CommandList::Op::Draw:
+						if (predicate && *predicate == 0)
+						{
+							m_stats.predicatedDraws++;
+							break;
+						}
+						m_stats.draws++;
+						if (activeHeap)
+						{
+							activeHeap->Samples(activeQuery) += command.a;
+						}
+						break;
+
+					case CommandList::Op::BeginQuery:
+						activeHeap = static_cast<QueryHeap*>(command.first);
+						activeQuery = command.a;
+						activeHeap->Samples(activeQuery) = 0;
+						break;
+
+					case CommandList::Op::EndQuery:
+						activeHeap = nullptr;
+						break;
+
+					case CommandList::Op::ResolveQuery:
+					{
+						auto heap = static_cast<QueryHeap*>(command.first);
+						auto destination = reinterpret_cast<uint64_t*>(static_cast<Resource*>(command.second)->GetMemory() + command.offset);
+						for (uint32_t i = 0; i < command.b; i++)
+						{
+							m_stats.queryResolves++;
+							bool occluded = m_occlusionPeriod != 0 && m_stats.queryResolves % m_occlusionPeriod == 0;
+							uint64_t samples = occluded ? 0 : heap->Samples(command.a + i);
+							destination[i] = heap->GetType() == QueryType::BinaryOcclusion ? (samples != 0 ? 1 : 0) : samples;
+						}
+						break;
+					}
+
+					case CommandList::Op::SetPredication:
+						predicate = command.first
+							? reinterpret_cast<const uint64_t*>(static_cast<Resource*>(command.first)->GetMemory() + command.offset)
+							: nullptr;
+						break;
+
+					case CommandList::Op::CopyBuffer:
+						memcpy(
+							static_cast<Resource*>(command.first)->GetMemory() + command.offset,
+							static_cast<Resource*>(command.second)->GetMemory() + command.sourceOffset,
+							static_cast<size_t>(command.size));
+						break;
+
+					default:
+						break;
+					}
+				}
+			}
+
+			SwapChain::SwapChain(uint32_t bufferCount, uint32_t width, uint32_t height)
+			{
+				for (uint32_t i = 0; i < bufferCount; i++)
+				{
+					m_buffers.emplace_back(new Resource(ResourceDesc::Texture(ResourceKind::RenderTarget, width, height, Format::R8G8B8A8Unorm)));
+				}
+			}
+
+			void SwapChain::Present()
+			{
+				m_presents++;
+				m_current = (m_current + 1) % GetBufferCount();
+			}
+
+			unique_ptr<IResource> Device::CreateResource(const ResourceDesc& desc, ResourceState)
+			{
+				return unique_ptr<IResource>(new Resource(desc));
+			}
+
+			unique_ptr<IResource> Device::CreateTransient(const ResourceDesc& desc, ResourceState, uint32_t, uint32_t)
+			{
+				return unique_ptr<IResource>(new Resource(desc));
+			}
+
+			unique_ptr<IFence> Device::CreateFence(uint64_t initialValue)
+			{
+				return unique_ptr<IFence>(new Fence(initialValue));
+			}
+
+			unique_ptr<IQueryHeap> Device::CreateQueryHeap(QueryType type, uint32_t count)
+			{
+				return unique_ptr<IQueryHeap>(new QueryHeap(type, count));
+			}
+
+			unique_ptr<ICommandList> Device::CreateCommandList(uint32_t)
+			{
+				return unique_ptr<ICommandList>(new CommandList());
+			}
+		}
+	}
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include "Backend.h"
+
+namespace Query {
+	namespace Backend
+	{
+		// Headless backend: command lists only record, and submission replays the recording on the CPU
+		// to keep the observable state consistent. Fences complete as soon as they are signaled, copies
+		// and query resolves write real buffer memory, and predication reads it back, so the frame
+		// logic behaves as on a GPU that finishes instantly. Nothing is rasterized: an occlusion query
+		// counts the vertices drawn inside it. The software backend replays the same recording.
+		namespace Null
+		{
+			class Resource : public IResource
+			{
+			private:
+				ResourceDesc m_desc;
+				vector<uint8_t> m_memory;
+
+			public:
+				explicit Resource(const ResourceDesc& desc);
+				const ResourceDesc& GetDesc() const override { return m_desc; }
+				void* Map() override { return m_memory.data(); }
+				void Unmap() override {}
+
+				uint8_t* GetMemory() { return m_memory.data(); }
+			};
+
+			class Pipeline : public IPipeline
+			{
+			private:
+				string m_name;
+
+			public:
+				explicit Pipeline(const char* name) : m_name(name) {}
+				const string& GetName() const { return m_name; }
+			};
+
+			class Fence : public IFence
+			{
+			private:
+				uint64_t m_value;
+
+			public:
+				explicit Fence(uint64_t value) : m_value(value) {}
+				uint64_t GetCompletedValue() const override { return m_value; }
+				void Wait(uint64_t) override {}
+				void Complete(uint64_t value) { m_value = value > m_value ? value : m_value; }
+			};
+
+			class QueryHeap : public IQueryHeap
+			{
+			private:
+				QueryType m_type;
+				vector<uint64_t> m_samples;
+
+			public:
+				QueryHeap(QueryType type, uint32_t count) : m_type(type), m_samples(count, 0) {}
+				QueryType GetType() const override { return m_type; }
+				uint32_t GetCount() const override { return static_cast<uint32_t>(m_samples.size()); }
+				uint64_t& Samples(uint32_t index) { return m_samples[index]; }
+			};
+
+			class CommandList : public ICommandList
+			{
+			public:
+				enum class Op : uint8_t
+				{
+					BeginPass, EndPass, Barrier,
+					ClearRenderTarget, ClearDepth, SetRenderTargets, SetViewport,
+					SetPipeline, SetVertexBuffer, SetConstantBuffer, Draw,
+					BeginQuery, EndQuery, ResolveQuery, SetPredication, CopyBuffer
+				};
+
+				// One fixed-size record per call; the vector keeps its capacity across frames. Clears keep
+				// their value in a: the color packed as R8G8B8A8, the depth as the bits of the float.
+				struct Command
+				{
+					Op op;
+					uint32_t a, b;
+					uint64_t offset, size;
+					uint64_t sourceOffset;
+					void* first;
+					void* second;
+				};
+
+			private:
+				vector<Command> m_commands;
+				bool m_closed = false;
+
+				void Push(Op op, uint32_t a = 0, uint32_t b = 0, void* first = nullptr, void* second = nullptr, uint64_t offset = 0, uint64_t size = 0)
+				{
+					m_commands.push_back({ op, a, b, offset, size, 0, first, second });
+				}
+
+			public:
+				const vector<Command>& GetCommands() const { return m_commands; }
+				bool IsClosed() const { return m_closed; }
+
+				void Reset(uint32_t frame) override;
+				void Close() override { m_closed = true; }
+
+				void BeginPass(uint32_t step, const char*) override { Push(Op::BeginPass, step); }
+				void EndPass(uint32_t step) override { Push(Op::EndPass, step); }
+				void Barriers(const Transition* transitions, uint32_t count) override;
+
+				void ClearRenderTarget(IResource* target, const float color[4]) override;
+				void ClearDepth(IResource* target, float depth) override;
+				void SetRenderTargets(IResource* color, IResource* depth) override { Push(Op::SetRenderTargets, 0, 0, color, depth); }
+				void SetViewport(uint32_t width, uint32_t height) override { Push(Op::SetViewport, width, height); }
+
+				void SetPipeline(IPipeline* pipeline) override { Push(Op::SetPipeline, 0, 0, pipeline); }
+				void SetVertexBuffer(IResource* buffer, uint32_t stride, uint32_t size) override { Push(Op::SetVertexBuffer, stride, size, buffer); }
+				void SetConstantBuffer(uint32_t slot, IResource* buffer, uint64_t offset) override { Push(Op::SetConstantBuffer, slot, 0, buffer, nullptr, offset); }
+				void Draw(uint32_t vertexCount, uint32_t firstVertex) override { Push(Op::Draw, vertexCount, firstVertex); }
+
+				void BeginQuery(IQueryHeap* heap, uint32_t index) override { Push(Op::BeginQuery, index, 0, heap); }
+				void EndQuery(IQueryHeap* heap, uint32_t index) override { Push(Op::EndQuery, index, 0, heap); }
+				void ResolveQuery(IQueryHeap* heap, uint32_t index, uint32_t count, IResource* destination, uint64_t offset) override
+				{
+					Push(Op::ResolveQuery, index, count, heap, destination, offset);
+				}
+				void SetPredication(IResource* buffer, uint64_t offset) override { Push(Op::SetPredication, 0, 0, buffer, nullptr, offset); }
+
+				void CopyBuffer(IResource* destination, uint64_t destinationOffset, IResource* source, uint64_t sourceOffset, uint64_t size) override
+				{
+					Push(Op::CopyBuffer, 0, 0, destination, source, destinationOffset, size);
+					m_commands.back().sourceOffset = sourceOffset;
+				}
+			};
+
+			class Queue : public IQueue
+			{
+			public:
+				struct Stats
+				{
+					uint64_t submits = 0;
+					uint64_t commands = 0;
+					uint64_t draws = 0;
+					uint64_t predicatedDraws = 0;	//skipped by predication
+					uint64_t barriers = 0;
+					uint64_t queryResolves = 0;
+				};
+
+			private:
+				Stats m_stats;
+				uint32_t m_occlusionPeriod = 0;
+
+			public:
+				// Every period-th resolve reports zero samples, so predicated draws get skipped now and
+				// then. 0 reports every query as visible.
+				void SetOcclusionPeriod(uint32_t period) { m_occlusionPeriod = period; }
+				const Stats& GetStats() const { return m_stats; }
+
+				void Submit(ICommandList* commandList) override;
+				void Signal(IFence* fence, uint64_t value) override { static_cast<Fence*>(fence)->Complete(value); }
+			};
+
+			class SwapChain : public ISwapChain
+			{
+			private:
+				vector<unique_ptr<Resource>> m_buffers;
+				uint32_t m_current = 0;
+				uint64_t m_presents = 0;
+
+			public:
+				SwapChain(uint32_t bufferCount, uint32_t width, uint32_t height);
+				uint32_t GetBufferCount() const override { return static_cast<uint32_t>(m_buffers.size()); }
+				uint32_t GetCurrentIndex() const override { return m_current; }
+				IResource* GetBuffer(uint32_t index) override { return m_buffers[index].get(); }
+				void Present() override;
+				uint64_t GetPresentCount() const { return m_presents; }
+			};
+
+			class Device : public IDevice
+			{
+			private:
+				Queue m_queue;
+
+			public:
+				unique_ptr<IResource> CreateResource(const ResourceDesc& desc, ResourceState initialState) override;
+				unique_ptr<IResource> CreateTransient(const ResourceDesc& desc, ResourceState initialState, uint32_t firstStep, uint32_t lastStep) override;
+				void CompileTransients() override {}
+
+				unique_ptr<IFence> CreateFence(uint64_t initialValue) override;
+				unique_ptr<IQueryHeap> CreateQueryHeap(QueryType type, uint32_t count) override;
+				unique_ptr<ICommandList> CreateCommandList(uint32_t frameCount) override;
+				IQueue* GetQueue() override { return &m_queue; }
+				Queue& GetNullQueue() { return m_queue; }
+			};
+		}
+	}
+}
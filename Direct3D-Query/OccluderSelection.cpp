@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "OccluderSelection.h"
+
+namespace Query {
+	namespace Culling
+	{
+		namespace
+		{
+			float Area(const Bounds& bounds)
+			{
+				return (bounds.max[0] - bounds.min[0]) * (bounds.max[1] - bounds.min[1]);
+			}
+
+			// The larger rectangle inside both a and b's union that spans one's extent along an axis,
+			// or an empty one when neither axis fits: the x ranges must overlap or touch while the y
+			// ranges overlap, or the other way around.
+			Bounds Inside(const Bounds& a, const Bounds& b)
+			{
+				Bounds fused;
+				fused.min[2] = a.min[2] < b.min[2] ? a.min[2] : b.min[2];
+				fused.max[2] = a.max[2] > b.max[2] ? a.max[2] : b.max[2];
+				float best = 0;
+				for (uint32_t axis = 0; axis < 2; axis++)
+				{
+					const uint32_t other = 1 - axis;
+					const float low = a.min[other] > b.min[other] ? a.min[other] : b.min[other];
+					const float high = a.max[other] < b.max[other] ? a.max[other] : b.max[other];
+					if (!(low < high && a.min[axis] <= b.max[axis] && b.min[axis] <= a.max[axis]))
+					{
+						continue;
+					}
+					const float first = a.min[axis] < b.min[axis] ? a.min[axis] : b.min[axis];
+					const float last = a.max[axis] > b.max[axis] ? a.max[axis] : b.max[axis];
+					const float area = (last - first) * (high - low);
+					if (area > best)
+					{
+						best = area;
+						fused.min[axis] = first;
+						fused.max[axis] = last;
+						fused.min[other] = low;
+						fused.max[other] = high;
+					}
+				}
+				if (best == 0)
+				{
+					fused.min[0] = fused.max[0] = 0;
+					fused.min[1] = fused.max[1] = 0;
+				}
+				return fused;
+			}
+		}
+
+		void OccluderSelector::Fuse(const Settings& settings)
+		{
+			// A sweep over the small candidates by left edge: any candidate fusable with i starts
+			// before i ends. Fused rectangles may fuse again, so rounds run until none does; after the
+			// first, only the candidates the last round grew look again, on both sides, since no other
+			// pair has changed. Candidates fused into another are left with no triangles and removed
+			// after the round.
+			auto small = [&settings](const Candidate& candidate) { return Area(candidate.occluder.bounds) < settings.fuseArea; };
+			for (uint32_t round = 1, fusions = 1; fusions; round++)
+			{
+				fusions = 0;
+				const auto end = partition(m_candidates.begin(), m_candidates.end(), small);
+				sort(m_candidates.begin(), end, [](const Candidate& a, const Candidate& b) { return a.occluder.bounds.min[0] < b.occluder.bounds.min[0]; });
+				const size_t count = end - m_candidates.begin();
+				float maxWidth = 0;
+				for (size_t i = 0; i < count; i++)
+				{
+					const Bounds& bounds = m_candidates[i].occluder.bounds;
+					maxWidth = bounds.max[0] - bounds.min[0] > maxWidth ? bounds.max[0] - bounds.min[0] : maxWidth;
+				}
+
+				for (size_t i = 0; i < count; i++)
+				{
+					Candidate& candidate = m_candidates[i];
+					Occluder& occluder = candidate.occluder;
+					if (!occluder.triangles)
+					{
+						continue;
+					}
+					size_t first = i + 1;
+					if (round > 1)
+					{
+						if (candidate.round != round - 1)
+						{
+							continue;
+						}
+						for (first = i; first > 0 && m_candidates[first - 1].occluder.bounds.min[0] >= occluder.bounds.min[0] - maxWidth; first--);
+					}
+
+					for (size_t j = first; j < count; j++)
+					{
+						Occluder& other = m_candidates[j].occluder;
+						if (other.bounds.min[0] > occluder.bounds.max[0])
+						{
+							break;
+						}
+						// Most pairs are apart in y, and unpredictably so.
+						const bool apart = (other.bounds.min[1] > occluder.bounds.max[1]) | (other.bounds.max[1] < occluder.bounds.min[1]) |
+							(fabsf(occluder.bounds.max[2] - other.bounds.max[2]) > settings.fuseDepthRange);
+						if (apart || j == i || !other.triangles)
+						{
+							continue;
+						}
+
+						const Bounds inside = Inside(occluder.bounds, other.bounds);
+						Bounds overlap = occluder.bounds;
+						for (uint32_t axis = 0; axis < 2; axis++)
+						{
+							overlap.min[axis] = other.bounds.min[axis] > overlap.min[axis] ? other.bounds.min[axis] : overlap.min[axis];
+							overlap.max[axis] = other.bounds.max[axis] < overlap.max[axis] ? other.bounds.max[axis] : overlap.max[axis];
+						}
+						const float shared = overlap.min[0] < overlap.max[0] && overlap.min[1] < overlap.max[1] ? Area(overlap) : 0;
+						const float covered = Area(occluder.bounds) + Area(other.bounds) - shared;
+						if (Area(inside) < settings.fuseCoverage * covered)
+						{
+							continue;
+						}
+
+						occluder.bounds = inside;
+						occluder.triangles = QuadTriangles;
+						occluder.source = Fused;
+						candidate.round = round;
+						other.triangles = 0;
+						fusions++;
+						if (!small(candidate))
+						{
+							break;
+						}
+					}
+				}
+				m_fusions += fusions;
+				m_candidates.erase(remove_if(m_candidates.begin(), m_candidates.end(), [](const Candidate& candidate) { return !candidate.occluder.triangles; }), m_candidates.end());
+			}
+		}
+
+		void OccluderSelector::Select(const Bounds* bounds, const uint32_t* triangles, uint32_t count, const Settings& settings)
+		{
+			m_candidates.clear();
+			m_selected.clear();
+			m_fusions = 0;
+			m_selectedTriangles = 0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				Occluder occluder = { bounds[i], triangles ? triangles[i] : QuadTriangles, i };
+				for (uint32_t axis = 0; axis < 2; axis++)
+				{
+					occluder.bounds.min[axis] = occluder.bounds.min[axis] > -1.0f ? occluder.bounds.min[axis] : -1.0f;
+					occluder.bounds.max[axis] = occluder.bounds.max[axis] < 1.0f ? occluder.bounds.max[axis] : 1.0f;
+				}
+				if (occluder.bounds.min[0] < occluder.bounds.max[0] && occluder.bounds.min[1] < occluder.bounds.max[1] &&
+					occluder.bounds.max[2] < 1.0f && Area(occluder.bounds) >= settings.minArea && occluder.triangles)
+				{
+					m_candidates.push_back({ occluder, 0 });
+				}
+			}
+			Fuse(settings);
+
+			// Area per triangle, the depth an occluder buys for what it costs to draw, a draw's own cost included.
+			m_order.resize(m_candidates.size());
+			for (uint32_t i = 0; i < m_candidates.size(); i++)
+			{
+				m_order[i] = i;
+			}
+			const float drawCost = static_cast<float>(settings.drawTriangles);
+			stable_sort(m_order.begin(), m_order.end(), [this, drawCost](uint32_t a, uint32_t b)
+			{
+				const Occluder& first = m_candidates[a].occluder;
+				const Occluder& second = m_candidates[b].occluder;
+				return Area(first.bounds) * (second.triangles + drawCost) > Area(second.bounds) * (first.triangles + drawCost);
+			});
+			for (uint32_t index : m_order)
+			{
+				if (m_selected.size() >= settings.maxOccluders)
+				{
+					break;
+				}
+				const Occluder& occluder = m_candidates[index].occluder;
+				if (m_selectedTriangles + occluder.triangles <= settings.maxTriangles)
+				{
+					m_selected.push_back(occluder);
+					m_selectedTriangles += occluder.triangles;
+				}
+			}
+		}
+	}
+}
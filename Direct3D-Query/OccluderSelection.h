@@ -0,0 +1,70 @@
+#pragma once
+#include "BoundingVolumeHierarchy.h"
+
+namespace Query {
+	namespace Culling
+	{
+		// Picks, every frame, the occluders worth rasterizing into an occlusion depth (a query depth
+		// pre-pass, or the depth a DepthPyramid is built from) instead of every opaque object.
+		//
+		// Candidates are screen rectangles in normalized device coordinates drawn at their farthest
+		// depth, bounds.max[2], with the number of triangles drawing them costs. Those off the screen
+		// or smaller than minArea once clipped to it are dropped. Small candidates are then fused in
+		// pairs: two rectangles whose x ranges overlap or touch and whose y ranges overlap contain the
+		// rectangle spanning both x ranges over the y range they share, and the other way around.
+		// When the larger of these keeps fuseCoverage of the area of the pair, it replaces both, at
+		// the farther of their depths and at the cost of one quad. Being inside the two and no
+		// nearer, a fused occluder never hides anything they do not. Last, the candidates are ranked
+		// by screen area per triangle and taken in that order as long as they fit the budget.
+		class OccluderSelector
+		{
+		public:
+			struct Settings
+			{
+				uint32_t maxOccluders = 256;
+				uint32_t maxTriangles = 65536;
+				uint32_t drawTriangles = 256;	//what a draw costs over its triangles, in triangles
+				float minArea = 0.0005f;	//in normalized device coordinates, where the screen is 4
+				float fuseArea = 0.01f;	//candidates smaller than this are fused, and fused until they are not
+				float fuseCoverage = 0.9f;
+				float fuseDepthRange = 0.05f;	//candidates farther apart in depth are not fused
+			};
+
+			static const uint32_t Fused = ~0u;
+			static const uint32_t QuadTriangles = 2;
+
+			struct Occluder
+			{
+				Bounds bounds;	//clipped to the screen, drawn at max[2]
+				uint32_t triangles;
+				uint32_t source;	//index of the candidate, or Fused
+			};
+
+		private:
+			struct Candidate
+			{
+				Occluder occluder;
+				uint32_t round;	//of the fusion that last grew it, 0 for none
+			};
+
+			vector<Candidate> m_candidates;
+			vector<uint32_t> m_order;
+			vector<Occluder> m_selected;
+			uint32_t m_fusions = 0;
+			uint32_t m_selectedTriangles = 0;
+
+		private:
+			void Fuse(const Settings& settings);
+
+		public:
+			// Replaces the selection of the previous frame. triangles may be null for quads.
+			void Select(const Bounds* bounds, const uint32_t* triangles, uint32_t count, const Settings& settings);
+
+			// In rank order.
+			const vector<Occluder>& GetSelected() const { return m_selected; }
+			uint32_t GetSelectedTriangles() const { return m_selectedTriangles; }
+			// Pairs fused in the last Select, fused occluders included.
+			uint32_t GetFusionCount() const { return m_fusions; }
+		};
+	}
+}
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "OccluderSelectionBenchmark.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Quad;
+		using Rendering::Scene;
+
+		OccluderSelectionResult RunOccluderSelection(const OccluderSelectionOptions& options, uint32_t seed)
+		{
+			SceneDesc desc;
+			desc.occluders = options.occluders;
+			desc.occludees = options.occludees;
+			desc.sizes = SizeDistribution::PowerLaw;
+			desc.animation = Rendering::Animation::None;
+			desc.seed = seed;
+			const Scene scene = GenerateScene(desc);
+			const uint32_t width = options.width, height = options.height;
+
+			// Triangle counts are independent of size, as they are for real meshes.
+			Random random(seed);
+			vector<Culling::Bounds> bounds(options.occluders);
+			vector<uint32_t> triangles(options.occluders);
+			uint64_t allTriangles = 0;
+			for (uint32_t i = 0; i < options.occluders; i++)
+			{
+				const Quad& quad = scene.occluders[i];
+				bounds[i] = { { quad.left, quad.bottom, quad.depth }, { quad.right, quad.top, quad.depth } };
+				triangles[i] = static_cast<uint32_t>(12.0f * powf(4096.0f / 12.0f, random.Uniform()));
+				allTriangles += triangles[i];
+			}
+
+			OccluderSelectionResult result;
+			result.options = options;
+			Culling::OccluderSelector selector;
+			selector.Select(bounds.data(), triangles.data(), options.occluders, options.settings);
+			auto start = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < options.iterations; i++)
+			{
+				selector.Select(bounds.data(), triangles.data(), options.occluders, options.settings);
+			}
+			result.selectMicroseconds = options.iterations ? MillisecondsSince(start) * 1000 / options.iterations : 0;
+			result.fusions = selector.GetFusionCount();
+			result.selected = static_cast<uint32_t>(selector.GetSelected().size());
+			result.triangles = allTriangles ? static_cast<double>(selector.GetSelectedTriangles()) / allTriangles : 0;
+
+			// Selected occluders are drawn at their farthest depth.
+			vector<Quad> selected;
+			for (const Culling::OccluderSelector::Occluder& occluder : selector.GetSelected())
+			{
+				Quad quad;
+				quad.left = occluder.bounds.min[0];
+				quad.bottom = occluder.bounds.min[1];
+				quad.right = occluder.bounds.max[0];
+				quad.top = occluder.bounds.max[1];
+				quad.depth = occluder.bounds.max[2];
+				selected.push_back(quad);
+			}
+			vector<float> all, partial;
+			start = chrono::steady_clock::now();
+			DrawDepth(scene.occluders, width, height, all);
+			result.allMilliseconds = MillisecondsSince(start);
+			start = chrono::steady_clock::now();
+			DrawDepth(selected, width, height, partial);
+			result.selectedMilliseconds = MillisecondsSince(start);
+
+			uint32_t allHidden = 0, selectedHidden = 0;
+			for (uint32_t i = 0; i < options.occludees; i++)
+			{
+				const Quad& quad = scene.occludees[i];
+				const Culling::Bounds occludee = { { quad.left, quad.bottom, quad.depth }, { quad.right, quad.top, quad.depth } };
+				const bool hidden = IsHidden(occludee, all, width, height);
+				const bool selectedHides = IsHidden(occludee, partial, width, height);
+				allHidden += hidden;
+				selectedHidden += selectedHides;
+			}
+			result.allHidden = options.occludees ? static_cast<double>(allHidden) / options.occludees : 0;
+			result.selectedHidden = options.occludees ? static_cast<double>(selectedHidden) / options.occludees : 0;
+			return result;
+		}
+
+		string ToJson(const vector<OccluderSelectionResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"occluder-selection\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const OccluderSelectionResult& result = results[i];
+				const Culling::OccluderSelector::Settings& settings = result.options.settings;
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"width\": %u, \"height\": %u, \"occluders\": %u, \"occludees\": %u, "
+					"\"maxOccluders\": %u, \"maxTriangles\": %u, \"drawTriangles\": %u, \"minArea\": %.4f, \"fuseArea\": %.4f, \"fuseCoverage\": %.2f, \"fuseDepthRange\": %.3f, "
+					"\"selectUs\": %.1f, \"fusions\": %u, \"selected\": %u, \"triangles\": %.4f, "
+					"\"allMs\": %.3f, \"selectedMs\": %.3f, \"allHidden\": %.4f, \"selectedHidden\": %.4f }",
+					i ? "," : "",
+					result.options.width, result.options.height, result.options.occluders, result.options.occludees,
+					settings.maxOccluders, settings.maxTriangles, settings.drawTriangles, settings.minArea, settings.fuseArea, settings.fuseCoverage, settings.fuseDepthRange,
+					result.selectMicroseconds, result.fusions, result.selected, result.triangles,
+					result.allMilliseconds, result.selectedMilliseconds, result.allHidden, result.selectedHidden);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "SceneGenerator.h"
+#include "OccluderSelection.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct OccluderSelectionOptions
+		{
+			uint32_t width = 1920, height = 1080;
+			uint32_t occluders = 4096;	//power-law sized, each drawn with 12 to 4096 triangles, log-uniformly
+			uint32_t occludees = 20000;
+			uint32_t iterations = 20;	//of the selection
+			Culling::OccluderSelector::Settings settings;
+		};
+
+		struct OccluderSelectionResult
+		{
+			OccluderSelectionOptions options;
+			double selectMicroseconds = 0;	//per Culling::OccluderSelector::Select
+			uint32_t fusions = 0;
+			uint32_t selected = 0;
+			double triangles = 0;	//fraction of all occluders' triangles the selected ones cost
+			// Drawing every occluder into a depth buffer and drawing the selected ones.
+			double allMilliseconds = 0;
+			double selectedMilliseconds = 0;
+			// Fractions of the occludees hidden by every occluder and by the selected ones.
+			double allHidden = 0;
+			double selectedHidden = 0;
+		};
+
+		// Selects the occluders of a generated scene within the budget of the settings and compares
+		// the occludees they hide with those every occluder hides.
+		OccluderSelectionResult RunOccluderSelection(const OccluderSelectionOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<OccluderSelectionResult>& results);
+	}
+}
@@ -0,0 +1,276 @@
+#include "pch.h"
+#include "OccluderSimplifier.h"
+
+namespace Query {
+	namespace Culling
+	{
+		namespace
+		{
+			// Cells within this fraction of a cell of a boundary edge count as touched, which keeps the
+			// rectangles clear of the mesh's edges by far more than rounding can move either.
+			const float Margin = 1.0f / 1024;
+
+			const uint8_t CenterCovered = 1, EdgeTouched = 2;
+
+			uint32_t ToCell(float coordinate, uint32_t count)
+			{
+				const float cell = floorf(coordinate);
+				return cell <= 0 ? 0 : cell < count - 1 ? static_cast<uint32_t>(cell) : count - 1;
+			}
+		}
+
+		void OccluderSimplifier::Weld(const void* vertices, uint32_t stride, const uint32_t* indices, uint32_t indexCount)
+		{
+			auto position = [=](uint32_t slot)
+			{
+				const uint32_t vertex = indices ? indices[slot] : slot;
+				return reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + static_cast<size_t>(vertex) * stride);
+			};
+			m_order.resize(indexCount);
+			for (uint32_t i = 0; i < indexCount; i++)
+			{
+				m_order[i] = i;
+			}
+			sort(m_order.begin(), m_order.end(), [&](uint32_t a, uint32_t b)
+			{
+				const float* first = position(a);
+				const float* second = position(b);
+				return first[0] < second[0] || (first[0] == second[0] && first[1] < second[1]);
+			});
+			m_welded.resize(indexCount);
+			m_points.clear();
+			for (uint32_t i = 0; i < indexCount; i++)
+			{
+				const float* current = position(m_order[i]);
+				if (m_points.empty() || m_points.back()[0] != current[0] || m_points.back()[1] != current[1])
+				{
+					m_points.push_back(current);
+				}
+				m_welded[m_order[i]] = static_cast<uint32_t>(m_points.size() - 1);
+			}
+		}
+
+		bool OccluderSimplifier::FindLargest(uint32_t& x0, uint32_t& y0, uint32_t& x1, uint32_t& y1)
+		{
+			// The largest rectangle under the histogram of each row's runs, with a stack of the
+			// columns whose runs are still open.
+			m_heights.assign(m_cellsX, 0);
+			uint32_t best = 0;
+			for (uint32_t y = 0; y < m_cellsY; y++)
+			{
+				const uint8_t* inside = m_inside.data() + static_cast<size_t>(y) * m_cellsX;
+				for (uint32_t x = 0; x < m_cellsX; x++)
+				{
+					m_heights[x] = inside[x] ? m_heights[x] + 1 : 0;
+				}
+				m_stack.clear();
+				for (uint32_t x = 0; x <= m_cellsX; x++)
+				{
+					const uint32_t height = x < m_cellsX ? m_heights[x] : 0;
+					while (!m_stack.empty() && m_heights[m_stack.back()] >= height)
+					{
+						const uint32_t top = m_heights[m_stack.back()];
+						m_stack.pop_back();
+						const uint32_t left = m_stack.empty() ? 0 : m_stack.back() + 1;
+						if (top * (x - left) > best)
+						{
+							best = top * (x - left);
+							x0 = left;
+							x1 = x;
+							y0 = y + 1 - top;
+							y1 = y + 1;
+						}
+					}
+					m_stack.push_back(x);
+				}
+			}
+			return best > 0;
+		}
+
+		void OccluderSimplifier::Simplify(const void* vertices, uint32_t stride, const uint32_t* indices, uint32_t indexCount, const Settings& settings)
+		{
+			m_rectangles.clear();
+			m_edges.clear();
+			m_triangles = 0;
+			indexCount -= indexCount % 3;
+			auto position = [=](uint32_t slot)
+			{
+				const uint32_t vertex = indices ? indices[slot] : slot;
+				return reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + static_cast<size_t>(vertex) * stride);
+			};
+			auto area = [&](uint32_t first)
+			{
+				const float* a = position(first);
+				const float* b = position(first + 1);
+				const float* c = position(first + 2);
+				return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+			};
+
+			// Triangles that cover nothing are left out, edges and all.
+			Weld(vertices, stride, indices, indexCount);
+			Bounds bounds = Bounds::Empty();
+			for (uint32_t first = 0; first < indexCount; first += 3)
+			{
+				const float twiceArea = area(first);
+				if (!(twiceArea != 0))
+				{
+					continue;
+				}
+				m_triangles++;
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const float* point = position(first + corner);
+					bounds.Grow(point, point);
+					// The third vertex is left of u to v when the triangle turns counterclockwise.
+					const uint32_t u = m_welded[first + corner], v = m_welded[first + (corner + 1) % 3];
+					const int32_t side = (twiceArea > 0) == (u < v) ? 1 : -1;
+					m_edges.push_back({ u < v ? u : v, u < v ? v : u, side });
+				}
+			}
+			if (!m_triangles)
+			{
+				return;
+			}
+
+			const float extentX = bounds.max[0] - bounds.min[0], extentY = bounds.max[1] - bounds.min[1];
+			const float longer = extentX > extentY ? extentX : extentY;
+			const uint32_t resolution = settings.resolution ? settings.resolution : 1;
+			m_cellsX = static_cast<uint32_t>(ceilf(resolution * extentX / longer));
+			m_cellsY = static_cast<uint32_t>(ceilf(resolution * extentY / longer));
+			m_cellsX = m_cellsX ? m_cellsX : 1;
+			m_cellsY = m_cellsY ? m_cellsY : 1;
+			const float scaleX = m_cellsX / extentX, scaleY = m_cellsY / extentY;
+			const size_t cells = static_cast<size_t>(m_cellsX) * m_cellsY;
+			m_inside.assign(cells, 0);
+			m_depths.assign(cells, -FLT_MAX);
+
+			// Centers and depths, over each triangle's bounds grown by the margin.
+			for (uint32_t first = 0; first < indexCount; first += 3)
+			{
+				const float twiceArea = area(first);
+				if (!(twiceArea != 0))
+				{
+					continue;
+				}
+				float x[3], y[3], depth = -FLT_MAX;
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const float* point = position(first + corner);
+					x[corner] = (point[0] - bounds.min[0]) * scaleX;
+					y[corner] = (point[1] - bounds.min[1]) * scaleY;
+					depth = point[2] > depth ? point[2] : depth;
+				}
+				const float orientation = twiceArea > 0 ? 1.0f : -1.0f;
+				const float minX = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+				const float maxX = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+				const float minY = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+				const float maxY = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+				const uint32_t cellX0 = ToCell(minX - Margin, m_cellsX), cellX1 = ToCell(maxX + Margin, m_cellsX);
+				const uint32_t cellY0 = ToCell(minY - Margin, m_cellsY), cellY1 = ToCell(maxY + Margin, m_cellsY);
+				for (uint32_t cellY = cellY0; cellY <= cellY1; cellY++)
+				{
+					const float centerY = cellY + 0.5f;
+					for (uint32_t cellX = cellX0; cellX <= cellX1; cellX++)
+					{
+						const size_t cell = static_cast<size_t>(cellY) * m_cellsX + cellX;
+						m_depths[cell] = depth > m_depths[cell] ? depth : m_depths[cell];
+						const float centerX = cellX + 0.5f;
+						bool covered = true;
+						for (uint32_t corner = 0; corner < 3; corner++)
+						{
+							const uint32_t next = (corner + 1) % 3;
+							const float edge = (x[next] - x[corner]) * (centerY - y[corner]) - (y[next] - y[corner]) * (centerX - x[corner]);
+							covered &= edge * orientation >= 0;
+						}
+						m_inside[cell] |= covered ? CenterCovered : 0;
+					}
+				}
+			}
+
+			// Boundary edges: anything but a pair of triangles on opposite sides. Each touches the cells
+			// of the rows it crosses over the span it covers in them, both grown by the margin.
+			sort(m_edges.begin(), m_edges.end(), [](const Edge& a, const Edge& b) { return a.a < b.a || (a.a == b.a && a.b < b.b); });
+			for (size_t i = 0; i < m_edges.size();)
+			{
+				size_t end = i + 1;
+				int32_t sides = m_edges[i].side;
+				while (end < m_edges.size() && m_edges[end].a == m_edges[i].a && m_edges[end].b == m_edges[i].b)
+				{
+					sides += m_edges[end].side;
+					end++;
+				}
+				const bool interior = end - i == 2 && sides == 0;
+				if (!interior)
+				{
+					const float* a = m_points[m_edges[i].a];
+					const float* b = m_points[m_edges[i].b];
+					float ax = (a[0] - bounds.min[0]) * scaleX, ay = (a[1] - bounds.min[1]) * scaleY;
+					float bx = (b[0] - bounds.min[0]) * scaleX, by = (b[1] - bounds.min[1]) * scaleY;
+					if (ay > by)
+					{
+						swap(ax, bx);
+						swap(ay, by);
+					}
+					const uint32_t row0 = ToCell(ay - Margin, m_cellsY), row1 = ToCell(by + Margin, m_cellsY);
+					for (uint32_t row = row0; row <= row1; row++)
+					{
+						float xa = ax, xb = bx;
+						if (by > ay)
+						{
+							const float y0 = row - Margin > ay ? row - Margin : ay;
+							const float y1 = row + 1 + Margin < by ? row + 1 + Margin : by;
+							xa = ax + (bx - ax) * ((y0 - ay) / (by - ay));
+							xb = ax + (bx - ax) * ((y1 - ay) / (by - ay));
+						}
+						if (xa > xb)
+						{
+							swap(xa, xb);
+						}
+						uint8_t* touched = m_inside.data() + static_cast<size_t>(row) * m_cellsX;
+						for (uint32_t cellX = ToCell(xa - Margin, m_cellsX), last = ToCell(xb + Margin, m_cellsX); cellX <= last; cellX++)
+						{
+							touched[cellX] |= EdgeTouched;
+						}
+					}
+				}
+				i = end;
+			}
+			for (uint8_t& cell : m_inside)
+			{
+				cell = cell == CenterCovered;
+			}
+
+			const float cellWidth = extentX / m_cellsX, cellHeight = extentY / m_cellsY;
+			uint32_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+			while (m_rectangles.size() < settings.maxRectangles && FindLargest(x0, y0, x1, y1) && (x1 - x0) * (y1 - y0) >= settings.minCells)
+			{
+				float depth = -FLT_MAX;
+				for (uint32_t y = y0; y < y1; y++)
+				{
+					for (uint32_t x = x0; x < x1; x++)
+					{
+						const size_t cell = static_cast<size_t>(y) * m_cellsX + x;
+						depth = m_depths[cell] > depth ? m_depths[cell] : depth;
+						m_inside[cell] = 0;
+					}
+				}
+				m_rectangles.push_back({
+					{ bounds.min[0] + x0 * cellWidth, bounds.min[1] + y0 * cellHeight, depth },
+					{ bounds.min[0] + x1 * cellWidth, bounds.min[1] + y1 * cellHeight, depth } });
+			}
+		}
+
+		future<vector<Bounds>> OccluderSimplifier::SimplifyAsync(Threading::ThreadPool& pool, vector<float> positions, vector<uint32_t> indices, const Settings& settings)
+		{
+			auto mesh = make_shared<pair<vector<float>, vector<uint32_t>>>(move(positions), move(indices));
+			return pool.Submit([mesh, settings]()
+			{
+				const vector<uint32_t>& indices = mesh->second;
+				OccluderSimplifier simplifier;
+				simplifier.Simplify(mesh->first.data(), 3 * sizeof(float), indices.empty() ? nullptr : indices.data(),
+					static_cast<uint32_t>(indices.empty() ? mesh->first.size() / 3 : indices.size()), settings);
+				return simplifier.GetRectangles();
+			});
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "BoundingVolumeHierarchy.h"
+
+namespace Query {
+	namespace Culling
+	{
+		// Turns a mesh of thousands of triangles into an inner occluder of a few rectangles, two
+		// triangles each, that covers nothing the mesh does not and lies nowhere nearer, seen along z
+		// (the view direction for the samples' geometry, whose positions are in normalized device
+		// coordinates). Drawn into an occlusion depth instead of the mesh, it can only hide less.
+		//
+		// The mesh's bounds are split into a grid of cells, resolution along the longer axis. A cell
+		// is inside when its center is in a triangle and no boundary edge touches it, a boundary edge
+		// being one that is not shared by exactly two triangles lying on its two sides: the boundary
+		// of the mesh's coverage only runs along those, so no part of such a cell is uncovered. The
+		// largest rectangle of inside cells is taken and its cells cleared, and so on, until there
+		// are maxRectangles or the largest has fewer than minCells. Each rectangle is drawn at the
+		// farthest vertex depth of the triangles whose bounds overlap its cells.
+		//
+		// The result depends on the mesh alone, so it can be built offline or, with SimplifyAsync,
+		// in the background as meshes are loaded.
+		class OccluderSimplifier
+		{
+		public:
+			struct Settings
+			{
+				uint32_t resolution = 64;
+				uint32_t maxRectangles = 16;
+				uint32_t minCells = 4;
+			};
+
+		private:
+			struct Edge
+			{
+				uint32_t a, b;	//welded vertices, a < b
+				int32_t side;	//of the triangle's third vertex, 1 left of a to b, -1 right
+			};
+
+			vector<uint32_t> m_welded;	//per index, its vertex numbered by distinct x and y
+			vector<const float*> m_points;	//the position of each welded vertex
+			vector<uint32_t> m_order;
+			vector<Edge> m_edges;
+			uint32_t m_cellsX = 0, m_cellsY = 0;
+			vector<uint8_t> m_inside;
+			vector<float> m_depths;	//per cell, the farthest depth of the triangles overlapping it
+			vector<uint32_t> m_heights;	//of the runs of inside cells ending at each cell of a row
+			vector<uint32_t> m_stack;
+			vector<Bounds> m_rectangles;
+			uint32_t m_triangles = 0;
+
+		private:
+			void Weld(const void* vertices, uint32_t stride, const uint32_t* indices, uint32_t indexCount);
+			bool FindLargest(uint32_t& x0, uint32_t& y0, uint32_t& x1, uint32_t& y1);
+
+		public:
+			// Positions are the first three floats of each vertex, stride bytes apart. indices holds
+			// indexCount / 3 triangles; when null, the vertices themselves are taken in order.
+			void Simplify(const void* vertices, uint32_t stride, const uint32_t* indices, uint32_t indexCount, const Settings& settings);
+
+			// Rectangles drawn at max[2], min[2] holding the same depth.
+			const vector<Bounds>& GetRectangles() const { return m_rectangles; }
+			// Non-degenerate triangles of the last mesh.
+			uint32_t GetTriangleCount() const { return m_triangles; }
+
+			// Simplifies on the pool. positions holds three floats per vertex.
+			static future<vector<Bounds>> SimplifyAsync(Threading::ThreadPool& pool, vector<float> positions, vector<uint32_t> indices, const Settings& settings);
+		};
+	}
+}
@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "OccluderSimplifierBenchmark.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		OccluderSimplificationResult RunOccluderSimplification(const OccluderSimplificationOptions& options, uint32_t seed)
+		{
+			Random random(seed);
+			vector<vector<float>> meshes(options.meshes);
+			for (uint32_t i = 0; i < options.meshes; i++)
+			{
+				GenerateMesh(random, options.segments, i % 2 == 1, meshes[i]);
+			}
+			const uint32_t width = options.width, height = options.height;
+
+			OccluderSimplificationResult result;
+			result.options = options;
+			Culling::OccluderSimplifier simplifier;
+			vector<vector<Culling::Bounds>> inner(options.meshes);
+			uint64_t triangles = 0, innerTriangles = 0;
+			auto start = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < options.meshes; i++)
+			{
+				const vector<float>& mesh = meshes[i];
+				simplifier.Simplify(mesh.data(), 3 * sizeof(float), nullptr, static_cast<uint32_t>(mesh.size() / 3), options.settings);
+				inner[i] = simplifier.GetRectangles();
+				triangles += simplifier.GetTriangleCount();
+				innerTriangles += inner[i].size() * 2;
+			}
+			result.simplifyMilliseconds = options.meshes ? MillisecondsSince(start) / options.meshes : 0;
+			const double meshCount = options.meshes ? options.meshes : 1;
+			result.triangles = triangles / meshCount;
+			result.innerTriangles = innerTriangles / meshCount;
+
+			// The way meshes streaming in would be simplified: one job per mesh.
+			Threading::ThreadPool threadPool;
+			threadPool.Initialize(options.threadCount);
+			result.threads = threadPool.GetThreadCount() + 1;
+			vector<future<vector<Culling::Bounds>>> jobs;
+			start = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < options.meshes; i++)
+			{
+				jobs.push_back(Culling::OccluderSimplifier::SimplifyAsync(threadPool, meshes[i], vector<uint32_t>(), options.settings));
+			}
+			for (future<vector<Culling::Bounds>>& job : jobs)
+			{
+				job.wait();
+			}
+			result.backgroundMilliseconds = MillisecondsSince(start);
+
+			// Each mesh and its inner occluder on their own, over the pixels of the mesh's bounds.
+			vector<float> meshDepth(static_cast<size_t>(width) * height, 1.0f), innerDepth(meshDepth.size(), 1.0f);
+			vector<float> quads;
+			uint64_t meshPixels = 0, innerPixels = 0;
+			for (uint32_t i = 0; i < options.meshes; i++)
+			{
+				const vector<float>& mesh = meshes[i];
+				quads.clear();
+				for (const Culling::Bounds& rectangle : inner[i])
+				{
+					const float corners[6][2] = {
+						{ rectangle.min[0], rectangle.min[1] }, { rectangle.max[0], rectangle.min[1] }, { rectangle.min[0], rectangle.max[1] },
+						{ rectangle.max[0], rectangle.min[1] }, { rectangle.max[0], rectangle.max[1] }, { rectangle.min[0], rectangle.max[1] } };
+					for (const auto& corner : corners)
+					{
+						quads.insert(quads.end(), { corner[0], corner[1], rectangle.max[2] });
+					}
+				}
+				start = chrono::steady_clock::now();
+				DrawTriangles(mesh.data(), static_cast<uint32_t>(mesh.size() / 9), width, height, meshDepth);
+				result.rasterMilliseconds += MillisecondsSince(start);
+				start = chrono::steady_clock::now();
+				DrawTriangles(quads.data(), static_cast<uint32_t>(quads.size() / 9), width, height, innerDepth);
+				result.innerRasterMilliseconds += MillisecondsSince(start);
+
+				Culling::Bounds bounds = Culling::Bounds::Empty();
+				for (size_t vertex = 0; vertex < mesh.size(); vertex += 3)
+				{
+					bounds.Grow(&mesh[vertex], &mesh[vertex]);
+				}
+				auto clamp = [](float value, uint32_t limit) { return value <= 0 ? 0 : value < limit ? static_cast<uint32_t>(value) : limit; };
+				const uint32_t x0 = clamp((bounds.min[0] * 0.5f + 0.5f) * width - 1, width), x1 = clamp((bounds.max[0] * 0.5f + 0.5f) * width + 2, width);
+				const uint32_t y0 = clamp((0.5f - bounds.max[1] * 0.5f) * height - 1, height), y1 = clamp((0.5f - bounds.min[1] * 0.5f) * height + 2, height);
+				for (uint32_t y = y0; y < y1; y++)
+				{
+					float* meshRow = meshDepth.data() + static_cast<size_t>(y) * width;
+					float* innerRow = innerDepth.data() + static_cast<size_t>(y) * width;
+					for (uint32_t x = x0; x < x1; x++)
+					{
+						const bool meshCovered = meshRow[x] < 1.0f, innerCovered = innerRow[x] < 1.0f;
+						meshPixels += meshCovered;
+						innerPixels += innerCovered;
+						meshRow[x] = 1.0f;
+						innerRow[x] = 1.0f;
+					}
+				}
+			}
+			result.coverage = meshPixels ? static_cast<double>(innerPixels) / meshPixels : 0;
+			return result;
+		}
+
+		string ToJson(const vector<OccluderSimplificationResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"occluder-simplification\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const OccluderSimplificationResult& result = results[i];
+				const Culling::OccluderSimplifier::Settings& settings = result.options.settings;
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"width\": %u, \"height\": %u, \"meshes\": %u, \"segments\": %u, "
+					"\"resolution\": %u, \"maxRectangles\": %u, \"minCells\": %u, \"triangles\": %.1f, \"innerTriangles\": %.1f, "
+					"\"simplifyMs\": %.3f, \"threads\": %u, \"backgroundMs\": %.3f, "
+					"\"rasterMs\": %.3f, \"innerRasterMs\": %.3f, \"coverage\": %.4f }",
+					i ? "," : "",
+					result.options.width, result.options.height, result.options.meshes, result.options.segments,
+					settings.resolution, settings.maxRectangles, settings.minCells, result.triangles, result.innerTriangles,
+					result.simplifyMilliseconds, result.threads, result.backgroundMilliseconds,
+					result.rasterMilliseconds, result.innerRasterMilliseconds, result.coverage);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
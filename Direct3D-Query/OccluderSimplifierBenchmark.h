@@ -0,0 +1,38 @@
+#pragma once
+#include "SceneGenerator.h"
+#include "OccluderSimplifier.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct OccluderSimplificationOptions
+		{
+			uint32_t width = 1920, height = 1080;
+			uint32_t meshes = 32;	//star-shaped discs and rings, tilted in depth
+			uint32_t segments = 1024;	//around each mesh, for 3 (discs) or 4 (rings) triangles each
+			uint32_t threadCount = 0;	//pool workers for the background simplification, 0 for one per hardware thread
+			Culling::OccluderSimplifier::Settings settings;
+		};
+
+		struct OccluderSimplificationResult
+		{
+			OccluderSimplificationOptions options;
+			double triangles = 0;	//per mesh
+			double innerTriangles = 0;
+			double simplifyMilliseconds = 0;	//per mesh, on the calling thread
+			uint32_t threads = 1;	//of the background simplification, the calling one included
+			double backgroundMilliseconds = 0;	//every mesh on the pool, until the last is done
+			// Rasterizing every mesh and every inner occluder, pixel centers in and LESS.
+			double rasterMilliseconds = 0;
+			double innerRasterMilliseconds = 0;
+			double coverage = 0;	//fraction of the meshes' pixels their inner occluders cover
+		};
+
+		// Simplifies generated meshes into inner occluders (see Culling::OccluderSimplifier), on the
+		// calling thread and in the background, and rasterizes both to measure how much of each
+		// mesh its inner occluder covers.
+		OccluderSimplificationResult RunOccluderSimplification(const OccluderSimplificationOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<OccluderSimplificationResult>& results);
+	}
+}
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "PipelineCache.h"
+
+namespace Query {
+	namespace Pipelines
+	{
+		void PipelineCache::Open(ID3D12Device* device, const wstring& libraryPath)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_device = device;
+			m_libraryPath = libraryPath;
+			m_libraryDirty = false;
+
+			if (!m_libraryPath.empty() && !IO::MappedFile::ReadAll(m_libraryPath, m_libraryBlob))
+			{
+				m_libraryBlob.clear();
+			}
+			CreateLibrary();
+		}
+
+		void PipelineCache::CreateLibrary()
+		{
+			m_library.Reset();
+			ComPtr<ID3D12Device1> device1;
+			if (m_libraryPath.empty() || FAILED(m_device.As(&device1)))
+			{
+				return;
+			}
+
+			// A blob from another driver or adapter is rejected; start over with an empty library,
+			// which replaces the stale file on the next save.
+			if (!m_libraryBlob.empty() &&
+				SUCCEEDED(device1->CreatePipelineLibrary(m_libraryBlob.data(), m_libraryBlob.size(), IID_PPV_ARGS(&m_library))))
+			{
+				return;
+			}
+			m_libraryBlob.clear();
+			if (SUCCEEDED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_library))))
+			{
+				m_libraryDirty = true;
+			}
+		}
+
+		ID3D12PipelineState* PipelineCache::Find(uint64_t key, const vector<uint8_t>& canonical) const
+		{
+			auto bucket = m_pipelines.find(key);
+			if (bucket == m_pipelines.end())
+			{
+				return nullptr;
+			}
+			for (const Entry& entry : bucket->second)
+			{
+				if (entry.canonical == canonical)
+				{
+					return entry.pipeline.Get();
+				}
+			}
+			return nullptr;
+		}
+
+		HRESULT PipelineCache::GetGraphicsPipeline(
+			const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+			uint64_t rootSignatureKey,
+			ID3D12PipelineState** ppPipeline)
+		{
+			vector<uint8_t> canonical;
+			PipelineKey::Canonicalize(desc, rootSignatureKey, canonical);
+			const uint64_t key = PipelineKey::Hash(canonical);
+
+			{
+				lock_guard<mutex> lock(m_mutex);
+				if (ID3D12PipelineState* cached = Find(key, canonical))
+				{
+					m_memoryHits++;
+					cached->AddRef();
+					*ppPipeline = cached;
+					return S_OK;
+				}
+			}
+
+			// Only the first description with a given key is stored in the library; a colliding one
+			// is still created and deduplicated in memory, just never persisted.
+			const wstring name = PipelineKey::ToName(key);
+			ComPtr<ID3D12PipelineState> pipeline;
+			bool loaded = false;
+			{
+				// The library does not synchronize loads of the same pipeline, so they stay under the lock.
+				lock_guard<mutex> lock(m_mutex);
+				loaded = m_library && m_pipelines.count(key) == 0 &&
+					SUCCEEDED(m_library->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipeline)));
+			}
+
+			// Driver compilation runs outside the lock so that pipelines can be created in parallel.
+			if (!loaded)
+			{
+				HRESULT hr = m_device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipeline));
+				if (FAILED(hr))
+				{
+					return hr;
+				}
+			}
+
+			lock_guard<mutex> lock(m_mutex);
+			if (ID3D12PipelineState* cached = Find(key, canonical))
+			{
+				// Another thread created the same pipeline meanwhile; hand out the one already cached.
+				m_memoryHits++;
+				cached->AddRef();
+				*ppPipeline = cached;
+				return S_OK;
+			}
+
+			if (loaded)
+			{
+				m_libraryHits++;
+			}
+			else
+			{
+				m_creations++;
+				if (m_library && m_pipelines.count(key) == 0 && SUCCEEDED(m_library->StorePipeline(name.c_str(), pipeline.Get())))
+				{
+					m_libraryDirty = true;
+				}
+			}
+
+			m_pipelines[key].push_back({ move(canonical), pipeline });
+			*ppPipeline = pipeline.Detach();
+			return S_OK;
+		}
+
+		HRESULT PipelineCache::Save()
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (!m_library || !m_libraryDirty)
+			{
+				return S_FALSE;
+			}
+
+			vector<uint8_t> contents(m_library->GetSerializedSize());
+			HRESULT hr = m_library->Serialize(contents.data(), contents.size());
+			if (FAILED(hr))
+			{
+				return hr;
+			}
+			// The library keeps reading m_libraryBlob, so the file itself is never mapped and can be replaced.
+			if (!IO::MappedFile::WriteAtomically(m_libraryPath, contents.data(), contents.size()))
+			{
+				return E_FAIL;
+			}
+			m_libraryDirty = false;
+			return S_OK;
+		}
+	}
+}
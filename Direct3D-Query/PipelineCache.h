@@ -0,0 +1,53 @@
+#pragma once
+#include "PipelineKey.h"
+#include "MappedFile.h"
+
+namespace Query {
+	namespace Pipelines
+	{
+		using Microsoft::WRL::ComPtr;
+
+		// Graphics pipelines deduplicated by their canonical description. Pipelines are kept in memory
+		// for the lifetime of the cache and persisted across runs in an ID3D12PipelineLibrary blob.
+		class PipelineCache
+		{
+		private:
+			struct Entry
+			{
+				vector<uint8_t> canonical;
+				ComPtr<ID3D12PipelineState> pipeline;
+			};
+
+			ComPtr<ID3D12Device> m_device;
+			ComPtr<ID3D12PipelineLibrary> m_library;
+			vector<uint8_t> m_libraryBlob;	//the library reads from this memory for its whole lifetime
+			wstring m_libraryPath;
+			bool m_libraryDirty = false;
+
+			unordered_map<uint64_t, vector<Entry>> m_pipelines;
+			mutable mutex m_mutex;
+
+			UINT m_memoryHits = 0, m_libraryHits = 0, m_creations = 0;
+
+		private:
+			void CreateLibrary();
+			ID3D12PipelineState* Find(uint64_t key, const vector<uint8_t>& canonical) const;
+
+		public:
+			// The library is optional: without ID3D12Device1 or a path the cache only dedupes in memory.
+			void Open(ID3D12Device* device, const wstring& libraryPath);
+
+			HRESULT GetGraphicsPipeline(
+				const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+				uint64_t rootSignatureKey,
+				ID3D12PipelineState** ppPipeline);
+
+			// Writes the library back if new pipelines were stored in it.
+			HRESULT Save();
+
+			UINT GetMemoryHitCount() const { return m_memoryHits; }
+			UINT GetLibraryHitCount() const { return m_libraryHits; }
+			UINT GetCreationCount() const { return m_creations; }
+		};
+	}
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+#include "PipelineKey.h"
+#include "Hash.h"
+
+namespace Query {
+	namespace Pipelines
+	{
+		namespace
+		{
+			// Appends fields one by one so that struct padding and pointers never reach the key.
+			class CanonicalWriter
+			{
+			private:
+				vector<uint8_t>& m_output;
+
+			public:
+				explicit CanonicalWriter(vector<uint8_t>& output) : m_output(output) {}
+
+				template<typename T>
+				void Put(T value)
+				{
+					static_assert(is_integral<T>::value || is_enum<T>::value || is_floating_point<T>::value, "scalars only");
+					auto bytes = reinterpret_cast<const uint8_t*>(&value);
+					m_output.insert(m_output.end(), bytes, bytes + sizeof(T));
+				}
+
+				void PutName(const char* name)
+				{
+					if (!name)
+					{
+						Put<uint8_t>(0xFF);
+						return;
+					}
+					for (; *name; name++)
+					{
+						char c = *name;
+						Put<char>(c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c);
+					}
+					Put<char>(0);
+				}
+			};
+
+			void PutBlend(CanonicalWriter& writer, const D3D12_RENDER_TARGET_BLEND_DESC& blend)
+			{
+				writer.Put<uint8_t>(blend.BlendEnable ? 1 : 0);
+				if (blend.BlendEnable)
+				{
+					writer.Put(blend.SrcBlend);
+					writer.Put(blend.DestBlend);
+					writer.Put(blend.BlendOp);
+					writer.Put(blend.SrcBlendAlpha);
+					writer.Put(blend.DestBlendAlpha);
+					writer.Put(blend.BlendOpAlpha);
+				}
+				writer.Put<uint8_t>(blend.LogicOpEnable ? 1 : 0);
+				if (blend.LogicOpEnable)
+				{
+					writer.Put(blend.LogicOp);
+				}
+				writer.Put(blend.RenderTargetWriteMask);
+			}
+
+			void PutStencilOp(CanonicalWriter& writer, const D3D12_DEPTH_STENCILOP_DESC& op)
+			{
+				writer.Put(op.StencilFailOp);
+				writer.Put(op.StencilDepthFailOp);
+				writer.Put(op.StencilPassOp);
+				writer.Put(op.StencilFunc);
+			}
+		}
+
+		uint64_t PipelineKey::HashBytecode(const D3D12_SHADER_BYTECODE& bytecode)
+		{
+			if (!bytecode.pShaderBytecode || bytecode.BytecodeLength == 0)
+			{
+				return 0;
+			}
+			return Query::Hash::Compute(bytecode.pShaderBytecode, bytecode.BytecodeLength);
+		}
+
+		void PipelineKey::Canonicalize(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey, vector<uint8_t>& canonical)
+		{
+			canonical.clear();
+			CanonicalWriter writer(canonical);
+
+			writer.Put<uint32_t>(1);	//layout version of the canonical form
+			writer.Put(rootSignatureKey);
+
+			writer.Put(HashBytecode(desc.VS));
+			writer.Put(HashBytecode(desc.PS));
+			writer.Put(HashBytecode(desc.DS));
+			writer.Put(HashBytecode(desc.HS));
+			writer.Put(HashBytecode(desc.GS));
+
+			const D3D12_STREAM_OUTPUT_DESC& so = desc.StreamOutput;
+			writer.Put(so.NumEntries);
+			for (UINT i = 0; i < so.NumEntries; i++)
+			{
+				const D3D12_SO_DECLARATION_ENTRY& entry = so.pSODeclaration[i];
+				writer.Put(entry.Stream);
+				writer.PutName(entry.SemanticName);
+				writer.Put(entry.SemanticIndex);
+				writer.Put(entry.StartComponent);
+				writer.Put(entry.ComponentCount);
+				writer.Put(entry.OutputSlot);
+			}
+			writer.Put(so.NumStrides);
+			for (UINT i = 0; i < so.NumStrides; i++)
+			{
+				writer.Put(so.pBufferStrides[i]);
+			}
+			if (so.NumEntries)
+			{
+				writer.Put(so.RasterizedStream);
+			}
+
+			const UINT renderTargetCount = desc.NumRenderTargets < 8 ? desc.NumRenderTargets : 8;
+			const D3D12_BLEND_DESC& blend = desc.BlendState;
+			writer.Put<uint8_t>(blend.AlphaToCoverageEnable ? 1 : 0);
+			// Without independent blending only slot 0 is used, so the flag is irrelevant with one target.
+			const bool independent = blend.IndependentBlendEnable && renderTargetCount > 1;
+			writer.Put<uint8_t>(independent ? 1 : 0);
+			for (UINT i = 0; i < (independent ? renderTargetCount : 1); i++)
+			{
+				PutBlend(writer, blend.RenderTarget[i]);
+			}
+
+			writer.Put(desc.SampleMask);
+
+			const D3D12_RASTERIZER_DESC& raster = desc.RasterizerState;
+			writer.Put(raster.FillMode);
+			writer.Put(raster.CullMode);
+			writer.Put<uint8_t>(raster.FrontCounterClockwise ? 1 : 0);
+			writer.Put(raster.DepthBias);
+			writer.Put(raster.DepthBiasClamp);
+			writer.Put(raster.SlopeScaledDepthBias);
+			writer.Put<uint8_t>(raster.DepthClipEnable ? 1 : 0);
+			writer.Put<uint8_t>(raster.MultisampleEnable ? 1 : 0);
+			writer.Put<uint8_t>(raster.AntialiasedLineEnable ? 1 : 0);
+			writer.Put(raster.ForcedSampleCount);
+			writer.Put(raster.ConservativeRaster);
+
+			const D3D12_DEPTH_STENCIL_DESC& depth = desc.DepthStencilState;
+			writer.Put<uint8_t>(depth.DepthEnable ? 1 : 0);
+			if (depth.DepthEnable)
+			{
+				writer.Put(depth.DepthWriteMask);
+				writer.Put(depth.DepthFunc);
+			}
+			writer.Put<uint8_t>(depth.StencilEnable ? 1 : 0);
+			if (depth.StencilEnable)
+			{
+				writer.Put(depth.StencilReadMask);
+				writer.Put(depth.StencilWriteMask);
+				PutStencilOp(writer, depth.FrontFace);
+				PutStencilOp(writer, depth.BackFace);
+			}
+
+			const D3D12_INPUT_LAYOUT_DESC& layout = desc.InputLayout;
+			writer.Put(layout.NumElements);
+			for (UINT i = 0; i < layout.NumElements; i++)
+			{
+				const D3D12_INPUT_ELEMENT_DESC& element = layout.pInputElementDescs[i];
+				writer.PutName(element.SemanticName);
+				writer.Put(element.SemanticIndex);
+				writer.Put(element.Format);
+				writer.Put(element.InputSlot);
+				writer.Put(element.AlignedByteOffset);
+				writer.Put(element.InputSlotClass);
+				// The step rate has no meaning for per-vertex data.
+				writer.Put(element.InputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA ? element.InstanceDataStepRate : 0u);
+			}
+
+			writer.Put(desc.IBStripCutValue);
+			writer.Put(desc.PrimitiveTopologyType);
+			writer.Put(renderTargetCount);
+			for (UINT i = 0; i < renderTargetCount; i++)
+			{
+				writer.Put(desc.RTVFormats[i]);
+			}
+			writer.Put(desc.DSVFormat);
+			writer.Put(desc.SampleDesc.Count);
+			writer.Put(desc.SampleDesc.Quality);
+			writer.Put(desc.NodeMask);
+			writer.Put(desc.Flags);
+		}
+
+		uint64_t PipelineKey::Hash(const vector<uint8_t>& canonical)
+		{
+			return Query::Hash::Compute(canonical.data(), canonical.size());
+		}
+
+		uint64_t PipelineKey::Compute(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey)
+		{
+			vector<uint8_t> canonical;
+			Canonicalize(desc, rootSignatureKey, canonical);
+			return Hash(canonical);
+		}
+
+		wstring PipelineKey::ToName(uint64_t key)
+		{
+			static const wchar_t digits[] = L"0123456789abcdef";
+			wstring name(16, L'0');
+			for (int i = 15; i >= 0; i--, key >>= 4)
+			{
+				name[i] = digits[key & 0xF];
+			}
+			return name;
+		}
+	}
+}
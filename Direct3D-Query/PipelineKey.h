@@ -0,0 +1,28 @@
+#pragma once
+
+namespace Query {
+	namespace Pipelines
+	{
+		// Canonical form of a graphics pipeline description. Fields that cannot affect the pipeline
+		// are normalized before hashing, so equivalent descriptions get the same key:
+		//  - shaders are identified by a hash of their bytecode, the root signature by a caller key
+		//    (for example the hash of its serialized blob), pointers never enter the key
+		//  - render target blend/format slots past NumRenderTargets, slots 1-7 without independent
+		//    blend, blend factors of disabled blending and the logic op of disabled logic ops
+		//  - depth function and write mask when depth is disabled, stencil state when stencil is disabled
+		//  - semantic names are compared case-insensitively, as HLSL does
+		// The canonical bytes are kept next to each cached pipeline, so a 64-bit key collision can never
+		// return the wrong pipeline.
+		class PipelineKey
+		{
+		public:
+			static void Canonicalize(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey, vector<uint8_t>& canonical);
+			static uint64_t Hash(const vector<uint8_t>& canonical);
+			static uint64_t Compute(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey);
+			static uint64_t HashBytecode(const D3D12_SHADER_BYTECODE& bytecode);
+
+			// Fixed-width hex name, used to store pipelines in an ID3D12PipelineLibrary.
+			static wstring ToName(uint64_t key);
+		};
+	}
+}
@@ -0,0 +1,253 @@
+#include "pch.h"
+#include "QueryRenderer.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		using namespace Backend;
+
+		namespace
+		{
+			// The near quad, in normalized device coordinates before its y is scaled by the aspect ratio.
+			const float NearQuadHalfWidth = 0.5f, NearQuadHalfHeight = 0.35f;
+		}
+
+		void QueryRenderer::Initialize(IDevice* device, ISwapChain* swapChain, uint32_t width, uint32_t height)
+		{
+			m_device = device;
+			m_queue = device->GetQueue();
+			m_swapChain = swapChain;
+			m_width = width;
+			m_height = height;
+			m_aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+			m_frameIndex = swapChain->GetCurrentIndex();
+
+			m_commandList = device->CreateCommandList(FrameCount);
+			m_fence = device->CreateFence(m_fenceValues[m_frameIndex]);
+			m_fenceValues[m_frameIndex]++;
+
+			//֡ͼʱԴ
+			BuildRenderGraph();
+			CreateResources();
+
+			m_graphRecorder.Bind(m_depthHandle, m_depthStencil.get());
+			m_graphRecorder.Bind(m_vertexBufferHandle, m_vertexBuffer.get());
+			m_graphRecorder.Bind(m_queryResultHandle, m_queryResult.get());
+		}
+
+		void QueryRenderer::SetPipelines(IPipeline* scene, IPipeline* query)
+		{
+			m_scenePipeline = scene;
+			m_queryPipeline = query;
+		}
+
+		void QueryRenderer::CreateResources()
+		{
+			const float aspectRatio = m_aspectRatio;
+			Vertex quadVertices[] =
+			{
+				// Far quad - in practice this would be a complex geometry.
+				{ { -0.25f, -0.25f * aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+				{ { -0.25f, 0.25f * aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+				{ { 0.25f, -0.25f * aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+				{ { 0.25f, 0.25f * aspectRatio, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+
+				// Near quad.
+				{ { -NearQuadHalfWidth, -NearQuadHalfHeight * aspectRatio, 0.0f }, { 1.0f, 0.0f, 0.0f, 0.65f } },
+				{ { -NearQuadHalfWidth, NearQuadHalfHeight * aspectRatio, 0.0f }, { 1.0f, 0.0f, 0.0f, 0.65f } },
+				{ { NearQuadHalfWidth, -NearQuadHalfHeight * aspectRatio, 0.0f }, { 1.0f, 1.0f, 0.0f, 0.65f } },
+				{ { NearQuadHalfWidth, NearQuadHalfHeight * aspectRatio, 0.0f }, { 1.0f, 1.0f, 0.0f, 0.65f } },
+
+				// Far quad bounding box used for occlusion query (offset slightly to avoid z-fighting).
+				{ { -0.25f, -0.25f * aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
+				{ { -0.25f, 0.25f * aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
+				{ { 0.25f, -0.25f * aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
+				{ { 0.25f, 0.25f * aspectRatio, 0.4999f }, { 0.0f, 0.0f, 0.0f, 1.0f } },
+			};
+			m_vertexBufferSize = sizeof(quadVertices);
+
+			//㻺Ĭ϶ѣͨϴѸƹȥ
+			m_vertexBuffer = m_device->CreateResource(ResourceDesc::Buffer(m_vertexBufferSize), StateCopyDest);
+			unique_ptr<IResource> vertexBufferUpload = m_device->CreateResource(ResourceDesc::Buffer(m_vertexBufferSize, HeapKind::Upload), StateCommon);
+			memcpy(vertexBufferUpload->Map(), quadVertices, m_vertexBufferSize);
+			vertexBufferUpload->Unmap();
+
+			//Constant Bufferӳ
+			m_constantBuffer = m_device->CreateResource(ResourceDesc::Buffer(FrameCount * CbvCountPerFrame * sizeof(SceneConstantBuffer), HeapKind::Upload), StateCommon);
+			m_pCbvDataBegin = static_cast<uint8_t*>(m_constantBuffer->Map());
+			memset(m_pCbvDataBegin, 0, FrameCount * CbvCountPerFrame * sizeof(SceneConstantBuffer));
+
+			//ıÿ֡ƣԽ߽½
+			const float translationSpeed = 0.01f;
+			const float offsetBounds = 1.5f;
+			m_nearQuad.Reset(offsetBounds);
+			m_nearQuad.Add(-NearQuadHalfWidth, -NearQuadHalfHeight * aspectRatio, NearQuadHalfWidth, NearQuadHalfHeight * aspectRatio, translationSpeed, 0);
+
+			//Query HeapQuery Result Buffer
+			m_queryHeap = m_device->CreateQueryHeap(QueryType::BinaryOcclusion, 1);
+			m_queryResult = m_device->CreateResource(ResourceDesc::Buffer(8), StatePredication);
+
+			// The depth buffer is cleared at the start of every frame, so it is a transient that lives
+			// for the graph steps using it and may share memory with other per-pass targets.
+			uint32_t firstStep, lastStep;
+			m_renderGraph.GetLifetime(m_depthHandle, firstStep, lastStep);
+			m_depthStencil = m_device->CreateTransient(
+				ResourceDesc::Texture(ResourceKind::DepthStencil, m_width, m_height, Format::D32Float),
+				StateDepthWrite, firstStep, lastStep);
+			m_device->CompileTransients();
+
+			//¼ƸִУ㻺帴ƵĬ϶
+			m_commandList->Reset(m_frameIndex);
+			m_commandList->CopyBuffer(m_vertexBuffer.get(), 0, vertexBufferUpload.get(), 0, m_vertexBufferSize);
+			ICommandList::Transition transition = { m_vertexBuffer.get(), StateCopyDest, StateVertexAndConstantBuffer };
+			m_commandList->Barriers(&transition, 1);
+			m_commandList->Close();
+			m_queue->Submit(m_commandList.get());
+
+			//ϴɺͷϴ
+			WaitForGpu();
+		}
+
+		void QueryRenderer::BuildRenderGraph()
+		{
+			m_renderGraph.Reset();
+			m_backBufferHandle = m_renderGraph.ImportResource("BackBuffer", StatePresent, StatePresent);
+			m_depthHandle = m_renderGraph.CreateTransient("Depth", StateDepthWrite);
+			m_vertexBufferHandle = m_renderGraph.ImportResource("VertexBuffer", StateVertexAndConstantBuffer, StateVertexAndConstantBuffer, false);
+			m_queryResultHandle = m_renderGraph.ImportResource("QueryResult", StatePredication, StatePredication);
+			m_occlusionHandle = m_renderGraph.CreateVirtual("OcclusionQuery");
+
+			uint32_t clear = m_renderGraph.AddPass("Clear", QueueType::Graphics, [this]()
+			{
+				const float clearColor[] = { 0.5f, 0.7f, 0.8f, 1.0f };
+				m_commandList->ClearRenderTarget(m_swapChain->GetBuffer(m_frameIndex), clearColor);
+				m_commandList->ClearDepth(m_depthStencil.get(), 1.0f);
+			});
+			m_renderGraph.Write(clear, m_backBufferHandle, StateRenderTarget);
+			m_renderGraph.Write(clear, m_depthHandle, StateDepthWrite);
+
+			// Draw the far quad conditionally based on the result of the occlusion query
+			// from the previous frame, then always draw the near quad.
+			uint32_t scene = m_renderGraph.AddPass("Scene", QueueType::Graphics, [this]()
+			{
+				const uint64_t cbvFarQuad = m_frameIndex * CbvCountPerFrame * sizeof(SceneConstantBuffer);
+				const uint64_t cbvNearQuad = cbvFarQuad + sizeof(SceneConstantBuffer);
+
+				m_commandList->SetRenderTargets(m_swapChain->GetBuffer(m_frameIndex), m_depthStencil.get());
+				m_commandList->SetPipeline(m_scenePipeline);
+				m_commandList->SetVertexBuffer(m_vertexBuffer.get(), sizeof(Vertex), m_vertexBufferSize);
+
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), cbvFarQuad);
+				if (m_queryResultValid)
+				{
+					m_commandList->SetPredication(m_queryResult.get(), 0);
+				}
+				m_commandList->Draw(4, 0);
+
+				m_commandList->SetPredication(nullptr, 0);
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), cbvNearQuad);
+				m_commandList->Draw(4, 4);
+			});
+			m_renderGraph.Read(scene, m_queryResultHandle, StatePredication);
+			m_renderGraph.Read(scene, m_vertexBufferHandle, StateVertexAndConstantBuffer);
+			m_renderGraph.Write(scene, m_backBufferHandle, StateRenderTarget);
+			m_renderGraph.Write(scene, m_depthHandle, StateDepthWrite);
+
+			// Run the occlusion query with the bounding box quad.
+			uint32_t query = m_renderGraph.AddPass("OcclusionQuery", QueueType::Graphics, [this]()
+			{
+				m_queryIssued = m_queryPipeline != nullptr;
+				if (!m_queryIssued)
+				{
+					return;
+				}
+
+				const uint64_t cbvFarQuad = m_frameIndex * CbvCountPerFrame * sizeof(SceneConstantBuffer);
+
+				m_commandList->SetRenderTargets(m_swapChain->GetBuffer(m_frameIndex), m_depthStencil.get());
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), cbvFarQuad);
+				m_commandList->SetPipeline(m_queryPipeline);
+				m_commandList->BeginQuery(m_queryHeap.get(), 0);
+				m_commandList->Draw(4, 8);
+				m_commandList->EndQuery(m_queryHeap.get(), 0);
+			});
+			m_renderGraph.Read(query, m_vertexBufferHandle, StateVertexAndConstantBuffer);
+			m_renderGraph.Write(query, m_depthHandle, StateDepthWrite);
+			m_renderGraph.Write(query, m_occlusionHandle, StateCommon);
+
+			// Resolve the occlusion query and store the results in the query result buffer
+			// to be used on the subsequent frame.
+			uint32_t resolve = m_renderGraph.AddPass("ResolveQuery", QueueType::Graphics, [this]()
+			{
+				if (m_queryIssued)
+				{
+					m_commandList->ResolveQuery(m_queryHeap.get(), 0, 1, m_queryResult.get(), 0);
+					m_queryResultValid = true;
+				}
+			});
+			m_renderGraph.Read(resolve, m_occlusionHandle, StateCommon);
+			m_renderGraph.Write(resolve, m_queryResultHandle, StateCopyDest);
+
+			m_renderGraph.Compile();
+		}
+
+		void QueryRenderer::Update()
+		{
+			// Animate the near quad, writing only its offset into this frame's slot.
+			uint32_t cbvIndex = m_frameIndex * CbvCountPerFrame + 1;
+			SceneStore::Output output;
+			output.destination = m_pCbvDataBegin + (cbvIndex * sizeof(SceneConstantBuffer));
+			output.stride = sizeof(SceneConstantBuffer);
+			m_nearQuad.Update(output);
+		}
+
+		void QueryRenderer::Render()
+		{
+			m_commandList->Reset(m_frameIndex);
+			m_commandList->SetViewport(m_width, m_height);
+
+			// The graph derives every transition, including the back buffer's PRESENT <-> RENDER_TARGET.
+			m_graphRecorder.SetCommandList(m_commandList.get());
+			m_graphRecorder.Bind(m_backBufferHandle, m_swapChain->GetBuffer(m_frameIndex));
+			m_renderGraph.Execute(m_graphRecorder);
+
+			m_commandList->Close();
+			m_queue->Submit(m_commandList.get());
+			m_swapChain->Present();
+
+			MoveToNextFrame();
+		}
+
+		void QueryRenderer::WaitForGpu()
+		{
+			// Schedule a Signal command in the queue.
+			m_queue->Signal(m_fence.get(), m_fenceValues[m_frameIndex]);
+
+			// Wait until the fence has been processed.
+			m_fence->Wait(m_fenceValues[m_frameIndex]);
+
+			// Increment the fence value for the current frame.
+			m_fenceValues[m_frameIndex]++;
+		}
+
+		// Prepare to render the next frame.
+		void QueryRenderer::MoveToNextFrame()
+		{
+			// Schedule a Signal command in the queue.
+			const uint64_t currentFenceValue = m_fenceValues[m_frameIndex];
+			m_queue->Signal(m_fence.get(), currentFenceValue);
+
+			// Update the frame index.
+			m_frameIndex = m_swapChain->GetCurrentIndex();
+
+			// If the next frame is not ready to be rendered yet, wait until it is ready.
+			if (m_fence->GetCompletedValue() < m_fenceValues[m_frameIndex])
+			{
+				m_fence->Wait(m_fenceValues[m_frameIndex]);
+			}
+
+			// Set the fence value for the next frame.
+			m_fenceValues[m_frameIndex] = currentFenceValue + 1;
+		}
+	}
+}
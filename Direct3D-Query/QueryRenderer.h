@@ -0,0 +1,87 @@
+#pragma once
+#include "Backend.h"
+#include "RenderGraphRecorder.h"
+#include "SceneStore.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		// Vertex definition.
+		struct Vertex
+		{
+			float position[3];
+			float color[4];
+		};
+
+		// Constant buffer definition.
+		struct SceneConstantBuffer
+		{
+			float offset[4];
+
+			// Constant buffers are 256-byte aligned. Add padding in the struct to allow multiple buffers
+			// to be array-indexed.
+			float padding[60];
+		};
+
+		// The occlusion query sample: a far quad drawn under predication from the previous frame's
+		// query, a moving near quad in front of it, and the query that tests the far quad's bounding
+		// box. Everything goes through the backend interfaces, so the same frame loop drives D3D12
+		// and the headless null backend.
+		class QueryRenderer
+		{
+		public:
+			static const uint32_t FrameCount = 2;
+			static const uint32_t CbvCountPerFrame = 2;
+
+		private:
+			Backend::IDevice* m_device = nullptr;
+			Backend::IQueue* m_queue = nullptr;
+			Backend::ISwapChain* m_swapChain = nullptr;
+			uint32_t m_width = 0, m_height = 0;
+			float m_aspectRatio = 1;
+
+			uint32_t m_frameIndex = 0;
+			unique_ptr<Backend::ICommandList> m_commandList;
+			unique_ptr<Backend::IFence> m_fence;
+			uint64_t m_fenceValues[FrameCount] = {};
+
+			Backend::IPipeline* m_scenePipeline = nullptr;
+			Backend::IPipeline* m_queryPipeline = nullptr;
+
+			unique_ptr<Backend::IResource> m_vertexBuffer;
+			uint32_t m_vertexBufferSize = 0;
+			unique_ptr<Backend::IResource> m_constantBuffer;
+			uint8_t* m_pCbvDataBegin = nullptr;
+			SceneStore m_nearQuad;
+			unique_ptr<Backend::IResource> m_depthStencil;
+			unique_ptr<Backend::IQueryHeap> m_queryHeap;
+			unique_ptr<Backend::IResource> m_queryResult;
+			bool m_queryIssued = false;//֡Ƿ񷢳ڵѯ
+			bool m_queryResultValid = false;//ѯǷѱ
+
+			//֡ͼơڵѯͽΪPass
+			RenderGraph m_renderGraph;
+			RenderGraphRecorder m_graphRecorder;
+			uint32_t m_backBufferHandle = 0, m_depthHandle = 0, m_vertexBufferHandle = 0, m_queryResultHandle = 0, m_occlusionHandle = 0;
+
+		private:
+			void BuildRenderGraph();
+			void CreateResources();
+			void MoveToNextFrame();
+
+		public:
+			// The swap chain needs FrameCount buffers.
+			void Initialize(Backend::IDevice* device, Backend::ISwapChain* swapChain, uint32_t width, uint32_t height);
+			// The query pipeline may be null until it is compiled; the query is skipped meanwhile.
+			void SetPipelines(Backend::IPipeline* scene, Backend::IPipeline* query);
+			bool HasQueryPipeline() const { return m_queryPipeline != nullptr; }
+
+			void Update();
+			void Render();
+			// Wait for pending GPU work to complete.
+			void WaitForGpu();
+
+			const RenderGraph& GetRenderGraph() const { return m_renderGraph; }
+		};
+	}
+}
@@ -0,0 +1,113 @@
+#include "pch.h"
+#include "QueryResolutionBenchmark.h"
+#include "DepthPyramid.h"
+#include "SoftwareBackend.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Scene;
+
+		vector<QueryResolutionResult> RunQueryResolution(const QueryResolutionOptions& options, uint32_t seed)
+		{
+			SceneDesc desc;
+			desc.occluders = options.occluders;
+			desc.occludees = options.occludees;
+			desc.sizes = SizeDistribution::PowerLaw;
+			desc.animation = Rendering::Animation::None;
+			desc.seed = seed;
+			const Scene scene = GenerateScene(desc);
+			const uint32_t width = options.width, height = options.height;
+			vector<float> depth;
+			DrawDepth(scene.occluders, width, height, depth);
+
+			Threading::ThreadPool threadPool;
+			threadPool.Initialize(options.threadCount);
+			Backend::Software::PipelineDesc queryDesc;
+			queryDesc.colorWrite = false;
+			queryDesc.depthWrite = false;
+			Backend::Software::Pipeline scenePipeline("Scene", Backend::Software::PipelineDesc());
+			Backend::Software::Pipeline queryPipeline("Query", queryDesc);
+
+			vector<QueryResolutionResult> results;
+			vector<float> scalar, simd;
+			for (uint32_t shift = 0; shift <= options.maxShift; shift++)
+			{
+				Backend::Software::Device device(&threadPool);
+				Backend::Software::SwapChain swapChain(Rendering::SceneRenderer::FrameCount, width, height);
+				Rendering::SceneRenderer renderer;
+				renderer.Initialize(&device, &swapChain, width, height, &scene, shift);
+				renderer.SetPipelines(&scenePipeline, &queryPipeline);
+
+				QueryResolutionResult result;
+				result.options = options;
+				result.shift = renderer.GetQueryShift();
+				for (uint32_t i = 0; i < Rendering::SceneRenderer::FrameCount + 1; i++)
+				{
+					renderer.Update();
+					renderer.Render();
+				}
+				auto start = chrono::steady_clock::now();
+				for (uint32_t i = 0; i < options.frames; i++)
+				{
+					renderer.Update();
+					renderer.Render();
+				}
+				renderer.WaitForGpu();
+				result.frameMilliseconds = options.frames ? MillisecondsSince(start) / options.frames : 0;
+
+				// The scene is static, so the last results are every frame's.
+				const uint64_t* visible = static_cast<const uint64_t*>(renderer.GetQueryResult()->Map());
+				uint32_t hidden = 0;
+				for (uint32_t i = 0; i < options.occludees; i++)
+				{
+					hidden += visible[i] == 0;
+				}
+				result.hidden = options.occludees ? static_cast<double>(hidden) / options.occludees : 0;
+				if (!result.shift)
+				{
+					results.push_back(result);
+					continue;
+				}
+
+				const uint32_t texelsX = width >> result.shift, texelsY = height >> result.shift;
+				scalar.resize(static_cast<size_t>(texelsX) * texelsY);
+				simd.resize(scalar.size());
+				const double iterations = options.iterations ? options.iterations : 1;
+				auto timeDownsample = [&](vector<float>& destination, bool useSimd)
+				{
+					Culling::DepthPyramid::Downsample(depth.data(), width, height, width, result.shift, destination.data(), texelsX, useSimd);
+					const auto begin = chrono::steady_clock::now();
+					for (uint32_t i = 0; i < options.iterations; i++)
+					{
+						Culling::DepthPyramid::Downsample(depth.data(), width, height, width, result.shift, destination.data(), texelsX, useSimd);
+					}
+					return MillisecondsSince(begin) / iterations;
+				};
+				result.scalarMilliseconds = timeDownsample(scalar, false);
+				result.simdMilliseconds = timeDownsample(simd, true);
+				results.push_back(result);
+			}
+			return results;
+		}
+
+		string ToJson(const vector<QueryResolutionResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"query-resolution\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const QueryResolutionResult& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"width\": %u, \"height\": %u, \"occluders\": %u, \"occludees\": %u, \"shift\": %u, "
+					"\"scalarMs\": %.3f, \"simdMs\": %.3f, \"frameMs\": %.3f, \"hidden\": %.4f }",
+					i ? "," : "",
+					result.options.width, result.options.height, result.options.occluders, result.options.occludees, result.shift,
+					result.scalarMilliseconds, result.simdMilliseconds, result.frameMilliseconds, result.hidden);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "SceneGenerator.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct QueryResolutionOptions
+		{
+			uint32_t width = 3840, height = 2160;
+			uint32_t occluders = 256;	//power-law sized
+			uint32_t occludees = 4096;
+			uint32_t maxShift = 2;	//every query shift from 0, full resolution, up to this is run
+			uint32_t frames = 10;	//software backend frames of each shift
+			uint32_t iterations = 20;	//of each path of the downsampling kernel
+			uint32_t threadCount = 0;	//software backend tile workers, 0 for one per hardware thread
+		};
+
+		struct QueryResolutionResult
+		{
+			QueryResolutionOptions options;
+			uint32_t shift = 0;	//query depth 2^shift times smaller each way
+			// Culling::DepthPyramid::Downsample of the occluders' full resolution depth, per run.
+			double scalarMilliseconds = 0;
+			double simdMilliseconds = 0;
+			double frameMilliseconds = 0;	//software backend, the whole frame
+			double hidden = 0;	//fraction of the occludees their queries find hidden
+		};
+
+		// Renders a static generated scene on the software backend with each query shift (see
+		// Rendering::SceneRenderer), counting the occludees its queries find hidden, and times both
+		// paths of the kernel that max-downsamples the occluders' full resolution depth.
+		vector<QueryResolutionResult> RunQueryResolution(const QueryResolutionOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<QueryResolutionResult>& results);
+	}
+}
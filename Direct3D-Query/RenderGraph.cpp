@@ -0,0 +1,312 @@
+#include "pch.h"
+#include "RenderGraph.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		static const uint32_t QueueCount = static_cast<uint32_t>(QueueType::Count);
+
+		void RenderGraph::Reset()
+		{
+			m_resources.clear();
+			m_passes.clear();
+			m_steps.clear();
+			m_barriers.clear();
+			m_waits.clear();
+			m_finalBarrierOffset = m_finalBarrierCount = 0;
+			m_finalWaitOffset = m_finalWaitCount = 0;
+		}
+
+		uint32_t RenderGraph::AddResource(const char* name, ResourceKind kind, bool exported, ResourceState initialState, ResourceState finalState)
+		{
+			m_resources.push_back({ name, kind, exported, initialState, finalState, Invalid, Invalid });
+			return static_cast<uint32_t>(m_resources.size() - 1);
+		}
+
+		uint32_t RenderGraph::ImportResource(const char* name, ResourceState initialState, ResourceState finalState, bool exported)
+		{
+			return AddResource(name, Imported, exported, initialState, finalState);
+		}
+
+		uint32_t RenderGraph::CreateTransient(const char* name, ResourceState initialState)
+		{
+			// Transients go back to their creation state at the end of the frame so that the next frame
+			// starts from the same known state.
+			return AddResource(name, Transient, false, initialState, initialState);
+		}
+
+		uint32_t RenderGraph::CreateVirtual(const char* name, bool exported)
+		{
+			return AddResource(name, Virtual, exported, StateCommon, StateCommon);
+		}
+
+		uint32_t RenderGraph::AddPass(const char* name, QueueType queue, function<void()> execute)
+		{
+			Pass pass;
+			pass.name = name;
+			pass.queue = queue;
+			pass.sideEffects = false;
+			pass.culled = false;
+			pass.execute = move(execute);
+			m_passes.push_back(move(pass));
+			return static_cast<uint32_t>(m_passes.size() - 1);
+		}
+
+		void RenderGraph::Read(uint32_t pass, uint32_t resource, ResourceState state)
+		{
+			m_passes[pass].accesses.push_back({ resource, state, false });
+		}
+
+		void RenderGraph::Write(uint32_t pass, uint32_t resource, ResourceState state)
+		{
+			m_passes[pass].accesses.push_back({ resource, state, true });
+		}
+
+		void RenderGraph::SetSideEffects(uint32_t pass)
+		{
+			m_passes[pass].sideEffects = true;
+		}
+
+		// Walks the passes backwards and keeps a pass only if it has side effects or writes something
+		// that is exported or read by a pass that is kept. Writes do not end the need for a resource,
+		// because a pass may only update part of it (draws on top of a clear, for example).
+		void RenderGraph::Cull()
+		{
+			vector<bool> needed(m_resources.size());
+			for (size_t i = 0; i < m_resources.size(); i++)
+			{
+				needed[i] = m_resources[i].exported;
+			}
+
+			for (size_t p = m_passes.size(); p-- > 0;)
+			{
+				Pass& pass = m_passes[p];
+				bool alive = pass.sideEffects;
+				for (auto& access : pass.accesses)
+				{
+					if (access.write && needed[access.resource]) alive = true;
+				}
+
+				pass.culled = !alive;
+				if (alive)
+				{
+					for (auto& access : pass.accesses)
+					{
+						if (!access.write) needed[access.resource] = true;
+					}
+				}
+			}
+		}
+
+		void RenderGraph::Compile(const CompileOptions& options)
+		{
+			m_steps.clear();
+			m_barriers.clear();
+			m_waits.clear();
+
+			Cull();
+
+			struct Tracking
+			{
+				ResourceState state;
+				uint32_t lastWriteStep;
+				uint32_t lastReadStep[QueueCount];
+				uint32_t passStamp;
+				ResourceState required;
+				bool written;
+			};
+
+			vector<Tracking> tracking(m_resources.size());
+			for (size_t i = 0; i < m_resources.size(); i++)
+			{
+				Tracking& t = tracking[i];
+				t.state = m_resources[i].initialState;
+				t.lastWriteStep = Invalid;
+				for (auto& step : t.lastReadStep) step = Invalid;
+				t.passStamp = Invalid;
+				m_resources[i].firstStep = m_resources[i].lastStep = Invalid;
+			}
+
+			// Signal values are the position of a step within its queue, so they grow monotonically
+			// even though signals are only emitted for the steps another queue waits on.
+			uint32_t queueStepCount[QueueCount] = {};
+			vector<uint32_t> queueOrdinal;
+			vector<uint32_t> touched;
+
+			for (uint32_t p = 0; p < m_passes.size(); p++)
+			{
+				const Pass& pass = m_passes[p];
+				if (pass.culled) continue;
+
+				QueueType queue = pass.queue;
+				if ((queue == QueueType::Compute && !options.asyncCompute) || (queue == QueueType::Copy && !options.asyncCopy))
+				{
+					queue = QueueType::Graphics;
+				}
+
+				const uint32_t stepIndex = static_cast<uint32_t>(m_steps.size());
+				Step step = {};
+				step.pass = p;
+				step.queue = queue;
+				step.barrierOffset = static_cast<uint32_t>(m_barriers.size());
+				step.waitOffset = static_cast<uint32_t>(m_waits.size());
+				step.signalValue = Invalid;
+				queueOrdinal.push_back(queueStepCount[static_cast<uint32_t>(queue)]++);
+				m_steps.push_back(step);
+
+				// Merge all accesses of this pass per resource: reads combine, a write wins.
+				touched.clear();
+				for (auto& access : pass.accesses)
+				{
+					Tracking& t = tracking[access.resource];
+					if (t.passStamp != p)
+					{
+						t.passStamp = p;
+						t.required = StateCommon;
+						t.written = false;
+						touched.push_back(access.resource);
+					}
+					if (access.write)
+					{
+						t.required = t.written ? t.required | access.state : access.state;
+						t.written = true;
+					}
+					else if (!t.written)
+					{
+						t.required = t.required | access.state;
+					}
+				}
+
+				uint32_t waitFor[QueueCount];
+				for (auto& value : waitFor) value = Invalid;
+				auto dependOn = [&](uint32_t producer)
+				{
+					if (producer == Invalid || m_steps[producer].queue == queue) return;
+
+					uint32_t producerQueue = static_cast<uint32_t>(m_steps[producer].queue);
+					uint32_t value = queueOrdinal[producer] + 1;
+					m_steps[producer].signalValue = value;
+					if (waitFor[producerQueue] == Invalid || value > waitFor[producerQueue]) waitFor[producerQueue] = value;
+				};
+
+				for (uint32_t index : touched)
+				{
+					Resource& resource = m_resources[index];
+					Tracking& t = tracking[index];
+
+					if (resource.firstStep == Invalid) resource.firstStep = stepIndex;
+					resource.lastStep = stepIndex;
+
+					// Read after write, and for writes also write after read on other queues.
+					dependOn(t.lastWriteStep);
+					if (t.written)
+					{
+						for (uint32_t reader : t.lastReadStep) dependOn(reader);
+					}
+
+					if (resource.kind != Virtual)
+					{
+						bool readOnly = (t.state & ~StateReadMask) == 0 && t.state != StateCommon;
+						bool covered = (t.required & ~t.state) == 0;
+						if (!(t.written == false && readOnly && covered) && t.required != t.state)
+						{
+							m_barriers.push_back({ index, t.state, t.required });
+							t.state = t.required;
+						}
+					}
+
+					if (t.written)
+					{
+						t.lastWriteStep = stepIndex;
+						for (auto& reader : t.lastReadStep) reader = Invalid;
+					}
+					else
+					{
+						t.lastReadStep[static_cast<uint32_t>(queue)] = stepIndex;
+					}
+				}
+
+				for (uint32_t q = 0; q < QueueCount; q++)
+				{
+					if (waitFor[q] != Invalid) m_waits.push_back({ static_cast<QueueType>(q), waitFor[q] });
+				}
+
+				Step& current = m_steps.back();
+				current.barrierCount = static_cast<uint32_t>(m_barriers.size()) - current.barrierOffset;
+				current.waitCount = static_cast<uint32_t>(m_waits.size()) - current.waitOffset;
+			}
+
+			// The frame ends on the graphics queue: join the other queues at their last step and put
+			// every resource into its final state.
+			m_finalWaitOffset = static_cast<uint32_t>(m_waits.size());
+			for (uint32_t q = 1; q < QueueCount; q++)
+			{
+				for (size_t s = m_steps.size(); s-- > 0;)
+				{
+					if (static_cast<uint32_t>(m_steps[s].queue) == q)
+					{
+						m_steps[s].signalValue = queueOrdinal[s] + 1;
+						m_waits.push_back({ static_cast<QueueType>(q), m_steps[s].signalValue });
+						break;
+					}
+				}
+			}
+			m_finalWaitCount = static_cast<uint32_t>(m_waits.size()) - m_finalWaitOffset;
+
+			m_finalBarrierOffset = static_cast<uint32_t>(m_barriers.size());
+			for (uint32_t index = 0; index < m_resources.size(); index++)
+			{
+				const Resource& resource = m_resources[index];
+				if (resource.kind != Virtual && tracking[index].state != resource.finalState)
+				{
+					m_barriers.push_back({ index, tracking[index].state, resource.finalState });
+				}
+			}
+			m_finalBarrierCount = static_cast<uint32_t>(m_barriers.size()) - m_finalBarrierOffset;
+		}
+
+		void RenderGraph::Execute(IRecorder& recorder) const
+		{
+			for (uint32_t s = 0; s < m_steps.size(); s++)
+			{
+				const Step& step = m_steps[s];
+				for (uint32_t i = 0; i < step.waitCount; i++)
+				{
+					recorder.Wait(step.queue, m_waits[step.waitOffset + i]);
+				}
+
+				recorder.BeginPass(s, step.queue, m_passes[step.pass].name);
+				if (step.barrierCount)
+				{
+					recorder.Barriers(step.queue, &m_barriers[step.barrierOffset], step.barrierCount);
+				}
+				if (m_passes[step.pass].execute)
+				{
+					m_passes[step.pass].execute();
+				}
+				recorder.EndPass(s, step.queue);
+
+				if (step.signalValue != Invalid)
+				{
+					recorder.Signal(step.queue, step.signalValue);
+				}
+			}
+
+			for (uint32_t i = 0; i < m_finalWaitCount; i++)
+			{
+				recorder.Wait(QueueType::Graphics, m_waits[m_finalWaitOffset + i]);
+			}
+			if (m_finalBarrierCount)
+			{
+				recorder.Barriers(QueueType::Graphics, &m_barriers[m_finalBarrierOffset], m_finalBarrierCount);
+			}
+		}
+
+		bool RenderGraph::GetLifetime(uint32_t resource, uint32_t& firstStep, uint32_t& lastStep) const
+		{
+			firstStep = m_resources[resource].firstStep;
+			lastStep = m_resources[resource].lastStep;
+			return firstStep != Invalid;
+		}
+	}
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+namespace Query {
+	namespace Rendering
+	{
+		// API-neutral resource states. Read states may be combined; a write state is exclusive.
+		enum ResourceState : uint32_t
+		{
+			StateCommon = 0,
+			StateVertexAndConstantBuffer = 1 << 0,
+			StateIndexBuffer = 1 << 1,
+			StateRenderTarget = 1 << 2,
+			StateUnorderedAccess = 1 << 3,
+			StateDepthWrite = 1 << 4,
+			StateDepthRead = 1 << 5,
+			StateShaderResource = 1 << 6,
+			StateCopyDest = 1 << 7,
+			StateCopySource = 1 << 8,
+			StatePredication = 1 << 9,
+			StatePresent = 1 << 10,
+
+			StateReadMask = StateVertexAndConstantBuffer | StateIndexBuffer | StateDepthRead |
+				StateShaderResource | StateCopySource | StatePredication | StatePresent
+		};
+
+		inline ResourceState operator|(ResourceState a, ResourceState b)
+		{
+			return static_cast<ResourceState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+		}
+
+		enum class QueueType : uint8_t
+		{
+			Graphics,
+			Compute,
+			Copy,
+			Count
+		};
+
+		// Frame passes declared with the resources they read and write. Compile culls the passes that
+		// do not contribute to an exported resource or have side effects, derives the state transitions
+		// and batches them per pass, and inserts cross-queue synchronization when passes run on the
+		// compute or copy queue. Compilation is CPU-only and deterministic: passes keep their declaration
+		// order, which is therefore required to be a valid execution order.
+		class RenderGraph
+		{
+		public:
+			static const uint32_t Invalid = ~0u;
+
+			struct Barrier
+			{
+				uint32_t resource;
+				ResourceState before;
+				ResourceState after;
+			};
+
+			struct QueueWait
+			{
+				QueueType queue;	//queue that signaled
+				uint32_t value;		//signal value to wait for on that queue
+			};
+
+			struct Step
+			{
+				uint32_t pass;
+				QueueType queue;
+				uint32_t barrierOffset, barrierCount;
+				uint32_t waitOffset, waitCount;
+				uint32_t signalValue;	//Invalid if nothing on another queue depends on this step
+			};
+
+			struct CompileOptions
+			{
+				bool asyncCompute = false;
+				bool asyncCopy = false;
+			};
+
+			// Receives the compiled work in execution order. Pass callbacks are invoked between
+			// BeginPass and EndPass, so a recorder can route them to the command list of their queue.
+			class IRecorder
+			{
+			public:
+				virtual ~IRecorder() = default;
+				virtual void Wait(QueueType queue, const QueueWait& wait) = 0;
+				virtual void Barriers(QueueType queue, const Barrier* barriers, uint32_t count) = 0;
+				virtual void BeginPass(uint32_t step, QueueType queue, const char* name) = 0;
+				virtual void EndPass(uint32_t step, QueueType queue) = 0;
+				virtual void Signal(QueueType queue, uint32_t value) = 0;
+			};
+
+		private:
+			enum ResourceKind : uint8_t
+			{
+				Imported,
+				Transient,
+				Virtual
+			};
+
+			struct Resource
+			{
+				const char* name;
+				ResourceKind kind;
+				bool exported;
+				ResourceState initialState;
+				ResourceState finalState;
+				uint32_t firstStep, lastStep;
+			};
+
+			struct Access
+			{
+				uint32_t resource;
+				ResourceState state;
+				bool write;
+			};
+
+			struct Pass
+			{
+				const char* name;
+				QueueType queue;
+				bool sideEffects;
+				bool culled;
+				function<void()> execute;
+				vector<Access> accesses;
+			};
+
+			vector<Resource> m_resources;
+			vector<Pass> m_passes;
+
+			vector<Step> m_steps;
+			vector<Barrier> m_barriers;
+			vector<QueueWait> m_waits;
+			uint32_t m_finalBarrierOffset = 0, m_finalBarrierCount = 0;
+			uint32_t m_finalWaitOffset = 0, m_finalWaitCount = 0;
+
+		private:
+			uint32_t AddResource(const char* name, ResourceKind kind, bool exported, ResourceState initialState, ResourceState finalState);
+			void Cull();
+
+		public:
+			void Reset();
+
+			// An externally owned resource, in initialState when the frame starts and put back into
+			// finalState when it ends. Exported resources keep the passes that write them alive.
+			uint32_t ImportResource(const char* name, ResourceState initialState, ResourceState finalState, bool exported = true);
+			// A frame-local resource, typically backed by a TransientResourcePool entry.
+			uint32_t CreateTransient(const char* name, ResourceState initialState);
+			// Pure ordering token with no memory behind it, e.g. query heap slots.
+			uint32_t CreateVirtual(const char* name, bool exported = false);
+
+			uint32_t AddPass(const char* name, QueueType queue, function<void()> execute);
+			void Read(uint32_t pass, uint32_t resource, ResourceState state);
+			void Write(uint32_t pass, uint32_t resource, ResourceState state);
+			void SetSideEffects(uint32_t pass);
+
+			void Compile() { Compile(CompileOptions()); }
+			void Compile(const CompileOptions& options);
+			void Execute(IRecorder& recorder) const;
+
+			uint32_t GetPassCount() const { return static_cast<uint32_t>(m_passes.size()); }
+			bool IsCulled(uint32_t pass) const { return m_passes[pass].culled; }
+			const char* GetPassName(uint32_t pass) const { return m_passes[pass].name; }
+			const char* GetResourceName(uint32_t resource) const { return m_resources[resource].name; }
+
+			const vector<Step>& GetSteps() const { return m_steps; }
+			const Barrier* GetBarriers(const Step& step) const { return m_barriers.data() + step.barrierOffset; }
+			const QueueWait* GetWaits(const Step& step) const { return m_waits.data() + step.waitOffset; }
+			uint32_t GetBarrierCount() const { return static_cast<uint32_t>(m_barriers.size()); }
+
+			// First and last step that use a resource after culling; false if it is not used at all.
+			bool GetLifetime(uint32_t resource, uint32_t& firstStep, uint32_t& lastStep) const;
+		};
+	}
+}
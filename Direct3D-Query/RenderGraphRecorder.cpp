@@ -0,0 +1,45 @@
+#include "pch.h"
+#include "RenderGraphRecorder.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		void RenderGraphRecorder::Bind(uint32_t resource, Backend::IResource* pResource)
+		{
+			if (resource >= m_resources.size())
+			{
+				m_resources.resize(resource + 1, nullptr);
+			}
+			m_resources[resource] = pResource;
+		}
+
+		void RenderGraphRecorder::Wait(QueueType, const RenderGraph::QueueWait&)
+		{
+		}
+
+		void RenderGraphRecorder::Barriers(QueueType, const RenderGraph::Barrier* barriers, uint32_t count)
+		{
+			m_transitions.clear();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const RenderGraph::Barrier& barrier = barriers[i];
+				m_transitions.push_back({ m_resources[barrier.resource], barrier.before, barrier.after });
+			}
+			m_commandList->Barriers(m_transitions.data(), static_cast<uint32_t>(m_transitions.size()));
+		}
+
+		void RenderGraphRecorder::BeginPass(uint32_t step, QueueType, const char* name)
+		{
+			m_commandList->BeginPass(step, name);
+		}
+
+		void RenderGraphRecorder::EndPass(uint32_t step, QueueType)
+		{
+			m_commandList->EndPass(step);
+		}
+
+		void RenderGraphRecorder::Signal(QueueType, uint32_t)
+		{
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Backend.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		// Records a compiled RenderGraph into a backend command list. Graph resources are bound to
+		// backend resources before execution; bindings may change every frame (back buffers).
+		// Everything runs on one queue, so graphs are expected to be compiled without async queues.
+		class RenderGraphRecorder : public RenderGraph::IRecorder
+		{
+		private:
+			Backend::ICommandList* m_commandList = nullptr;
+			vector<Backend::IResource*> m_resources;
+			vector<Backend::ICommandList::Transition> m_transitions;
+
+		public:
+			void SetCommandList(Backend::ICommandList* commandList) { m_commandList = commandList; }
+			void Bind(uint32_t resource, Backend::IResource* pResource);
+
+			void Wait(QueueType queue, const RenderGraph::QueueWait& wait) override;
+			void Barriers(QueueType queue, const RenderGraph::Barrier* barriers, uint32_t count) override;
+			void BeginPass(uint32_t step, QueueType queue, const char* name) override;
+			void EndPass(uint32_t step, QueueType queue) override;
+			void Signal(QueueType queue, uint32_t value) override;
+		};
+	}
+}
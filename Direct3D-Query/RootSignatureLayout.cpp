@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "RootSignatureLayout.h"
+
+// Compile-time checks of the root signature layout; this file has no code.
+namespace Query {
+	namespace Pipelines
+	{
+		namespace RootSignatureLayout
+		{
+			static_assert(static_cast<uint32_t>(Version::V1_0) == D3D_ROOT_SIGNATURE_VERSION_1_0 &&
+				static_cast<uint32_t>(Version::V1_1) == D3D_ROOT_SIGNATURE_VERSION_1_1, "root signature versions");
+			static_assert(static_cast<uint32_t>(ParameterType::DescriptorTable) == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE &&
+				static_cast<uint32_t>(ParameterType::Constants) == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS &&
+				static_cast<uint32_t>(ParameterType::Cbv) == D3D12_ROOT_PARAMETER_TYPE_CBV &&
+				static_cast<uint32_t>(ParameterType::Srv) == D3D12_ROOT_PARAMETER_TYPE_SRV &&
+				static_cast<uint32_t>(ParameterType::Uav) == D3D12_ROOT_PARAMETER_TYPE_UAV, "root parameter types");
+			static_assert(static_cast<uint32_t>(RangeType::Srv) == D3D12_DESCRIPTOR_RANGE_TYPE_SRV &&
+				static_cast<uint32_t>(RangeType::Uav) == D3D12_DESCRIPTOR_RANGE_TYPE_UAV &&
+				static_cast<uint32_t>(RangeType::Cbv) == D3D12_DESCRIPTOR_RANGE_TYPE_CBV &&
+				static_cast<uint32_t>(RangeType::Sampler) == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, "descriptor range types");
+			static_assert(static_cast<uint32_t>(Visibility::All) == D3D12_SHADER_VISIBILITY_ALL &&
+				static_cast<uint32_t>(Visibility::Vertex) == D3D12_SHADER_VISIBILITY_VERTEX &&
+				static_cast<uint32_t>(Visibility::Pixel) == D3D12_SHADER_VISIBILITY_PIXEL, "shader visibilities");
+			static_assert(static_cast<uint32_t>(AllowInputAssemblerInputLayout) == D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT &&
+				static_cast<uint32_t>(DenyVertexShaderRootAccess) == D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS &&
+				static_cast<uint32_t>(DenyPixelShaderRootAccess) == D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS &&
+				static_cast<uint32_t>(AllowStreamOutput) == D3D12_ROOT_SIGNATURE_FLAG_ALLOW_STREAM_OUTPUT, "root signature flags");
+			static_assert(static_cast<uint32_t>(DescriptorsVolatile) == D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE &&
+				static_cast<uint32_t>(DataVolatile) == D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE &&
+				static_cast<uint32_t>(DataStaticWhileSetAtExecute) == D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE &&
+				static_cast<uint32_t>(DataStatic) == D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC &&
+				static_cast<uint32_t>(DataStatic) == D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC, "data flags");
+			static_assert(AppendRange == D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND, "append offset");
+
+			// A signature with every kind of parameter.
+			constexpr Desc<4, 2> Sample =
+			{
+				AllowInputAssemblerInputLayout,
+				{
+					Table(0, 2, Visibility::Pixel),
+					Constants(4, 1),
+					Cbv(0, 0, DataStatic, Visibility::Vertex),
+					Uav(2, 1)
+				},
+				{
+					DescriptorRange(RangeType::Srv, 8, 0, 0, DataStaticWhileSetAtExecute),
+					DescriptorRange(RangeType::Cbv, 1, 1, 0, DataNone, 8)
+				}
+			};
+			static_assert(IsValid(Sample), "valid sample");
+			static_assert(!IsValid(Desc<1, 1>{ 0, { Table(1, 1) }, { DescriptorRange(RangeType::Srv, 1, 0) } }), "table past the ranges");
+
+			static_assert(PartSize(Sample, Version::V1_1) == 24 + 4 * 12 + (8 + 2 * 24) + 12 + 12 + 12, "1.1 part size");
+			static_assert(PartSize(Sample, Version::V1_0) == 24 + 4 * 12 + (8 + 2 * 20) + 12 + 8 + 8, "1.0 part size");
+
+			constexpr auto SampleBlob = Serialize<SerializedSize(Sample, Version::V1_1)>(Sample, Version::V1_1);
+			static_assert(SampleBlob.Read(0) == 0x43425844 && SampleBlob.Read(24) == SampleBlob.size() && SampleBlob.Read(28) == 1, "container header");
+			static_assert(SampleBlob.Read(36) == 0x30535452 && SampleBlob.Read(40) == SampleBlob.size() - 44, "RTS0 part header");
+			static_assert(SampleBlob.Read(44) == 2 && SampleBlob.Read(48) == 4 && SampleBlob.Read(52) == 24 && SampleBlob.Read(56) == 0 &&
+				SampleBlob.Read(60) == SampleBlob.size() - 44 && SampleBlob.Read(64) == AllowInputAssemblerInputLayout, "RTS0 header");
+			// First parameter header, then its table and second range: type, count, base, space, flags, offset.
+			static_assert(SampleBlob.Read(68) == 0 && SampleBlob.Read(72) == 5 && SampleBlob.Read(76) == 72, "table parameter");
+			static_assert(SampleBlob.Read(44 + 72) == 2 && SampleBlob.Read(44 + 76) == 80, "table payload");
+			static_assert(SampleBlob.Read(44 + 104) == 2 && SampleBlob.Read(44 + 108) == 1 && SampleBlob.Read(44 + 112) == 1 &&
+				SampleBlob.Read(44 + 124) == 8, "second range");
+			// Constants follow the table's ranges.
+			static_assert(SampleBlob.Read(80) == 1 && SampleBlob.Read(88) == 128 && SampleBlob.Read(44 + 128) == 1 && SampleBlob.Read(44 + 136) == 4, "constants");
+			// The checksum covers the bytes after it.
+			static_assert(SampleBlob.Read(4) != 0 && SampleBlob.Read(4) != Serialize<SerializedSize(Sample, Version::V1_1)>(
+				Desc<4, 2>{ DenyPixelShaderRootAccess, { Sample.parameters[0], Sample.parameters[1], Sample.parameters[2], Sample.parameters[3] },
+				{ Sample.ranges[0], Sample.ranges[1] } }, Version::V1_1).Read(4), "checksum depends on the content");
+		}
+	}
+}
@@ -0,0 +1,429 @@
+#pragma once
+
+namespace Query {
+	namespace Pipelines
+	{
+		// Root signatures described and serialized at compile time. The enums and flags have the
+		// values of their D3D12 counterparts, so the layout converts to D3D12 structures field by
+		// field, and Serialize produces the same kind of blob D3D12SerializeVersionedRootSignature
+		// does: a DXBC container with one RTS0 part and the container checksum. Static samplers are
+		// not supported.
+		namespace RootSignatureLayout
+		{
+			enum class Version : uint32_t
+			{
+				V1_0 = 1,
+				V1_1 = 2
+			};
+
+			enum class ParameterType : uint32_t
+			{
+				DescriptorTable = 0,
+				Constants = 1,
+				Cbv = 2,
+				Srv = 3,
+				Uav = 4
+			};
+
+			enum class RangeType : uint32_t
+			{
+				Srv = 0,
+				Uav = 1,
+				Cbv = 2,
+				Sampler = 3
+			};
+
+			enum class Visibility : uint32_t
+			{
+				All = 0,
+				Vertex = 1,
+				Hull = 2,
+				Domain = 3,
+				Geometry = 4,
+				Pixel = 5
+			};
+
+			// D3D12_ROOT_SIGNATURE_FLAGS
+			enum RootFlags : uint32_t
+			{
+				AllowInputAssemblerInputLayout = 0x1,
+				DenyVertexShaderRootAccess = 0x2,
+				DenyHullShaderRootAccess = 0x4,
+				DenyDomainShaderRootAccess = 0x8,
+				DenyGeometryShaderRootAccess = 0x10,
+				DenyPixelShaderRootAccess = 0x20,
+				AllowStreamOutput = 0x40
+			};
+
+			// D3D12_ROOT_DESCRIPTOR_FLAGS and D3D12_DESCRIPTOR_RANGE_FLAGS; version 1.0 drops them.
+			enum DataFlags : uint32_t
+			{
+				DataNone = 0,
+				DescriptorsVolatile = 0x1,	//ranges only
+				DataVolatile = 0x2,
+				DataStaticWhileSetAtExecute = 0x4,
+				DataStatic = 0x8
+			};
+
+			const uint32_t AppendRange = 0xFFFFFFFF;	//D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND
+
+			struct Range
+			{
+				RangeType type;
+				uint32_t count;
+				uint32_t baseRegister;
+				uint32_t space;
+				uint32_t flags;
+				uint32_t offset;
+			};
+
+			// Descriptors use shaderRegister, space and value as flags; constants use value as the
+			// number of 32-bit values; tables use firstRange and rangeCount into the ranges array.
+			struct Parameter
+			{
+				ParameterType type;
+				Visibility visibility;
+				uint32_t shaderRegister;
+				uint32_t space;
+				uint32_t value;
+				uint32_t firstRange;
+				uint32_t rangeCount;
+			};
+
+			constexpr Parameter Descriptor(ParameterType type, uint32_t shaderRegister, uint32_t space, uint32_t flags, Visibility visibility)
+			{
+				return Parameter{ type, visibility, shaderRegister, space, flags, 0, 0 };
+			}
+			constexpr Parameter Cbv(uint32_t shaderRegister, uint32_t space = 0, uint32_t flags = DataNone, Visibility visibility = Visibility::All)
+			{
+				return Descriptor(ParameterType::Cbv, shaderRegister, space, flags, visibility);
+			}
+			constexpr Parameter Srv(uint32_t shaderRegister, uint32_t space = 0, uint32_t flags = DataNone, Visibility visibility = Visibility::All)
+			{
+				return Descriptor(ParameterType::Srv, shaderRegister, space, flags, visibility);
+			}
+			constexpr Parameter Uav(uint32_t shaderRegister, uint32_t space = 0, uint32_t flags = DataNone, Visibility visibility = Visibility::All)
+			{
+				return Descriptor(ParameterType::Uav, shaderRegister, space, flags, visibility);
+			}
+			constexpr Parameter Constants(uint32_t count, uint32_t shaderRegister, uint32_t space = 0, Visibility visibility = Visibility::All)
+			{
+				return Parameter{ ParameterType::Constants, visibility, shaderRegister, space, count, 0, 0 };
+			}
+			constexpr Parameter Table(uint32_t firstRange, uint32_t rangeCount, Visibility visibility = Visibility::All)
+			{
+				return Parameter{ ParameterType::DescriptorTable, visibility, 0, 0, 0, firstRange, rangeCount };
+			}
+			constexpr Range DescriptorRange(RangeType type, uint32_t count, uint32_t baseRegister, uint32_t space = 0, uint32_t flags = DataNone, uint32_t offset = AppendRange)
+			{
+				return Range{ type, count, baseRegister, space, flags, offset };
+			}
+
+			// Arrays are sized at least 1 so that signatures without ranges stay valid C++.
+			template<uint32_t ParameterCount, uint32_t RangeCount>
+			struct Desc
+			{
+				static const uint32_t parameterCount = ParameterCount;
+				static const uint32_t rangeCount = RangeCount;
+
+				uint32_t flags;
+				Parameter parameters[ParameterCount ? ParameterCount : 1];
+				Range ranges[RangeCount ? RangeCount : 1];
+			};
+
+			// Layout of the RTS0 part: a header, the parameter headers, then every payload in
+			// parameter order, a table's ranges right after the table.
+			const uint32_t HeaderSize = 24;
+			const uint32_t ParameterHeaderSize = 12;
+			const uint32_t TableSize = 8;
+			const uint32_t ContainerHeaderSize = 32;
+			const uint32_t PartHeaderSize = 8;
+
+			constexpr uint32_t DescriptorSize(Version version) { return version == Version::V1_1 ? 12 : 8; }
+			constexpr uint32_t RangeSize(Version version) { return version == Version::V1_1 ? 24 : 20; }
+
+			template<typename D>
+			constexpr uint32_t PartSize(const D& desc, Version version)
+			{
+				uint32_t size = HeaderSize + ParameterHeaderSize * D::parameterCount;
+				for (uint32_t i = 0; i < D::parameterCount; i++)
+				{
+					const Parameter& parameter = desc.parameters[i];
+					if (parameter.type == ParameterType::DescriptorTable)
+					{
+						size += TableSize + RangeSize(version) * parameter.rangeCount;
+					}
+					else
+					{
+						size += parameter.type == ParameterType::Constants ? 12 : DescriptorSize(version);
+					}
+				}
+				return size;
+			}
+
+			template<typename D>
+			constexpr uint32_t SerializedSize(const D& desc, Version version)
+			{
+				return ContainerHeaderSize + 4 + PartHeaderSize + PartSize(desc, version);
+			}
+
+			template<uint32_t Size>
+			struct Blob
+			{
+				uint8_t bytes[Size];
+
+				constexpr uint32_t Read(uint32_t offset) const
+				{
+					return static_cast<uint32_t>(bytes[offset]) | static_cast<uint32_t>(bytes[offset + 1]) << 8 |
+						static_cast<uint32_t>(bytes[offset + 2]) << 16 | static_cast<uint32_t>(bytes[offset + 3]) << 24;
+				}
+				constexpr void Write(uint32_t offset, uint32_t value)
+				{
+					bytes[offset] = static_cast<uint8_t>(value);
+					bytes[offset + 1] = static_cast<uint8_t>(value >> 8);
+					bytes[offset + 2] = static_cast<uint8_t>(value >> 16);
+					bytes[offset + 3] = static_cast<uint8_t>(value >> 24);
+				}
+
+				const void* data() const { return bytes; }
+				static constexpr size_t size() { return Size; }
+			};
+
+			// MD5 compression of one 64-byte block of little-endian words.
+			struct Md5State
+			{
+				uint32_t a, b, c, d;
+			};
+
+			constexpr uint32_t RotateLeft(uint32_t value, uint32_t count) { return value << count | value >> (32 - count); }
+
+			constexpr Md5State Md5Block(Md5State state, const uint32_t (&block)[16])
+			{
+				const uint32_t shifts[64] =
+				{
+					7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+					5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+					4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+					6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+				};
+				const uint32_t sines[64] =
+				{
+					0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+					0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+					0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+					0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+					0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+					0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+					0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+					0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+				};
+				uint32_t a = state.a, b = state.b, c = state.c, d = state.d;
+				for (uint32_t i = 0; i < 64; i++)
+				{
+					uint32_t f = 0, g = 0;
+					switch (i / 16)
+					{
+					case 0: f = (b & c) | (~b & d); g = i; break;
+					case 1: f = (d & b) | (~d & c); g = (5 * i + 1) % 16; break;
+					case 2: f = b ^ c ^ d; g = (3 * i + 5) % 16; break;
+					default: f = c ^ (b | ~d); g = (7 * i) % 16; break;
+					}
+					const uint32_t rotated = d;
+					d = c;
+					c = b;
+					b = b + RotateLeft(a + f + sines[i] + block[g], shifts[i]);
+					a = rotated;
+				}
+				return Md5State{ state.a + a, state.b + b, state.c + c, state.d + d };
+			}
+
+			// The DXBC container checksum: MD5 over everything after the checksum field, with the bit
+			// count stored in the first word of the last block and (bits >> 2) | 1 in its last word
+			// instead of MD5's trailing 64-bit length.
+			template<uint32_t Size>
+			constexpr Md5State ContainerChecksum(const Blob<Size>& blob)
+			{
+				const uint32_t begin = 20;
+				const uint32_t size = Size - begin;
+				const uint32_t fullSize = size / 64 * 64;
+				const uint32_t leftover = size - fullSize;
+				Md5State state{ 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+				uint32_t block[16] = {};
+				for (uint32_t offset = 0; offset < fullSize; offset += 64)
+				{
+					for (uint32_t i = 0; i < 16; i++)
+					{
+						block[i] = blob.Read(begin + offset + i * 4);
+					}
+					state = Md5Block(state, block);
+				}
+
+				// The tail, shifted one word when the bit count shares its block.
+				uint8_t tail[64] = {};
+				const uint32_t shift = leftover < 56 ? 4 : 0;
+				for (uint32_t i = 0; i < leftover; i++)
+				{
+					tail[shift + i] = blob.bytes[begin + fullSize + i];
+				}
+				tail[shift + leftover] = 0x80;
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					block[i] = static_cast<uint32_t>(tail[i * 4]) | static_cast<uint32_t>(tail[i * 4 + 1]) << 8 |
+						static_cast<uint32_t>(tail[i * 4 + 2]) << 16 | static_cast<uint32_t>(tail[i * 4 + 3]) << 24;
+				}
+				if (shift == 0)
+				{
+					state = Md5Block(state, block);
+					for (uint32_t i = 0; i < 16; i++)
+					{
+						block[i] = 0;
+					}
+				}
+				block[0] = size * 8;
+				block[15] = (size * 8 >> 2) | 1;
+				return Md5Block(state, block);
+			}
+
+			template<uint32_t Size, typename D>
+			constexpr Blob<Size> Serialize(const D& desc, Version version)
+			{
+				Blob<Size> blob{};
+
+				// Container header: magic, checksum (filled last), version 1.0, size, one part.
+				const uint32_t partOffset = ContainerHeaderSize + 4;
+				blob.Write(0, 0x43425844);	//"DXBC"
+				blob.Write(20, 1);
+				blob.Write(24, Size);
+				blob.Write(28, 1);
+				blob.Write(32, partOffset);
+				blob.Write(partOffset, 0x30535452);	//"RTS0"
+				blob.Write(partOffset + 4, Size - partOffset - PartHeaderSize);
+
+				// Offsets in the part are relative to its first byte after the part header.
+				const uint32_t base = partOffset + PartHeaderSize;
+				blob.Write(base, static_cast<uint32_t>(version));
+				blob.Write(base + 4, D::parameterCount);
+				blob.Write(base + 8, HeaderSize);
+				blob.Write(base + 12, 0);
+				blob.Write(base + 16, PartSize(desc, version));
+				blob.Write(base + 20, desc.flags);
+
+				uint32_t payload = HeaderSize + ParameterHeaderSize * D::parameterCount;
+				for (uint32_t i = 0; i < D::parameterCount; i++)
+				{
+					const Parameter& parameter = desc.parameters[i];
+					const uint32_t header = base + HeaderSize + ParameterHeaderSize * i;
+					blob.Write(header, static_cast<uint32_t>(parameter.type));
+					blob.Write(header + 4, static_cast<uint32_t>(parameter.visibility));
+					blob.Write(header + 8, payload);
+
+					if (parameter.type == ParameterType::DescriptorTable)
+					{
+						blob.Write(base + payload, parameter.rangeCount);
+						blob.Write(base + payload + 4, payload + TableSize);
+						payload += TableSize;
+						for (uint32_t r = 0; r < parameter.rangeCount; r++)
+						{
+							const Range& range = desc.ranges[parameter.firstRange + r];
+							blob.Write(base + payload, static_cast<uint32_t>(range.type));
+							blob.Write(base + payload + 4, range.count);
+							blob.Write(base + payload + 8, range.baseRegister);
+							blob.Write(base + payload + 12, range.space);
+							if (version == Version::V1_1)
+							{
+								blob.Write(base + payload + 16, range.flags);
+							}
+							blob.Write(base + payload + RangeSize(version) - 4, range.offset);
+							payload += RangeSize(version);
+						}
+					}
+					else
+					{
+						blob.Write(base + payload, parameter.shaderRegister);
+						blob.Write(base + payload + 4, parameter.space);
+						if (parameter.type == ParameterType::Constants || version == Version::V1_1)
+						{
+							blob.Write(base + payload + 8, parameter.value);
+							payload += 12;
+						}
+						else
+						{
+							payload += 8;
+						}
+					}
+				}
+
+				const Md5State checksum = ContainerChecksum(blob);
+				blob.Write(4, checksum.a);
+				blob.Write(8, checksum.b);
+				blob.Write(12, checksum.c);
+				blob.Write(16, checksum.d);
+				return blob;
+			}
+
+			// The layout as d3dx12 structures, what the runtime serializer takes. The description
+			// points into the arrays, so it is neither copied nor moved.
+			template<typename D>
+			struct D3D12Desc
+			{
+				CD3DX12_DESCRIPTOR_RANGE1 ranges[D::rangeCount ? D::rangeCount : 1];
+				CD3DX12_ROOT_PARAMETER1 parameters[D::parameterCount ? D::parameterCount : 1];
+				CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC desc;
+
+				explicit D3D12Desc(const D& layout)
+				{
+					for (uint32_t i = 0; i < D::rangeCount; i++)
+					{
+						const Range& range = layout.ranges[i];
+						ranges[i].Init(static_cast<D3D12_DESCRIPTOR_RANGE_TYPE>(range.type), range.count, range.baseRegister, range.space,
+							static_cast<D3D12_DESCRIPTOR_RANGE_FLAGS>(range.flags), range.offset);
+					}
+					for (uint32_t i = 0; i < D::parameterCount; i++)
+					{
+						const Parameter& parameter = layout.parameters[i];
+						const auto visibility = static_cast<D3D12_SHADER_VISIBILITY>(parameter.visibility);
+						const auto flags = static_cast<D3D12_ROOT_DESCRIPTOR_FLAGS>(parameter.value);
+						switch (parameter.type)
+						{
+						case ParameterType::DescriptorTable:
+							parameters[i].InitAsDescriptorTable(parameter.rangeCount, &ranges[parameter.firstRange], visibility);
+							break;
+						case ParameterType::Constants:
+							parameters[i].InitAsConstants(parameter.value, parameter.shaderRegister, parameter.space, visibility);
+							break;
+						case ParameterType::Cbv:
+							parameters[i].InitAsConstantBufferView(parameter.shaderRegister, parameter.space, flags, visibility);
+							break;
+						case ParameterType::Srv:
+							parameters[i].InitAsShaderResourceView(parameter.shaderRegister, parameter.space, flags, visibility);
+							break;
+						case ParameterType::Uav:
+							parameters[i].InitAsUnorderedAccessView(parameter.shaderRegister, parameter.space, flags, visibility);
+							break;
+						}
+					}
+					desc.Init_1_1(D::parameterCount, parameters, 0, nullptr, static_cast<D3D12_ROOT_SIGNATURE_FLAGS>(layout.flags));
+				}
+				D3D12Desc(const D3D12Desc&) = delete;
+				D3D12Desc& operator=(const D3D12Desc&) = delete;
+			};
+
+			// Every table's ranges must lie inside the ranges array.
+			template<typename D>
+			constexpr bool IsValid(const D& desc)
+			{
+				for (uint32_t i = 0; i < D::parameterCount; i++)
+				{
+					const Parameter& parameter = desc.parameters[i];
+					if (parameter.type == ParameterType::DescriptorTable &&
+						(parameter.rangeCount == 0 || parameter.firstRange + parameter.rangeCount > D::rangeCount))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+		}
+	}
+}
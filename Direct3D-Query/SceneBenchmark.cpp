@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "SceneBenchmark.h"
+#include "NullBackend.h"
+#include "SoftwareBackend.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Quad;
+		using Rendering::Scene;
+
+		namespace
+		{
+			StageTime Summarize(const vector<double>& samples)
+			{
+				StageTime time;
+				for (double sample : samples)
+				{
+					time.meanMicroseconds += sample;
+					time.maxMicroseconds = sample > time.maxMicroseconds ? sample : time.maxMicroseconds;
+				}
+				time.meanMicroseconds = samples.empty() ? 0 : time.meanMicroseconds / samples.size();
+				return time;
+			}
+
+			template<typename Queue>
+			Result Measure(Rendering::SceneRenderer& renderer, const Scene& scene, const Queue& queue, uint32_t frames)
+			{
+				// Until the first resolve completes nothing is predicated; the loop keeps a frame in flight.
+				for (uint32_t i = 0; i < Rendering::SceneRenderer::FrameCount + 1; i++)
+				{
+					renderer.Update();
+					renderer.Render();
+				}
+				const auto before = queue.GetStats();
+
+				vector<double> stages[4];
+				for (auto& stage : stages)
+				{
+					stage.reserve(frames);
+				}
+				uint64_t queries = 0;
+				auto start = chrono::steady_clock::now();
+				for (uint32_t i = 0; i < frames; i++)
+				{
+					auto t0 = chrono::steady_clock::now();
+					renderer.Update();
+					auto t1 = chrono::steady_clock::now();
+					renderer.Record();
+					auto t2 = chrono::steady_clock::now();
+					renderer.Submit();
+					auto t3 = chrono::steady_clock::now();
+					renderer.Present();
+					auto t4 = chrono::steady_clock::now();
+
+					stages[0].push_back(chrono::duration<double, micro>(t1 - t0).count());
+					stages[1].push_back(chrono::duration<double, micro>(t2 - t1).count());
+					stages[2].push_back(chrono::duration<double, micro>(t3 - t2).count());
+					stages[3].push_back(chrono::duration<double, micro>(t4 - t3).count());
+					queries += renderer.GetQueriesIssued();
+				}
+				renderer.WaitForGpu();
+				auto end = chrono::steady_clock::now();
+				const auto& after = queue.GetStats();
+
+				Result result;
+				result.frames = frames;
+				result.update = Summarize(stages[0]);
+				result.record = Summarize(stages[1]);
+				result.submit = Summarize(stages[2]);
+				result.present = Summarize(stages[3]);
+				result.frameMicroseconds = chrono::duration<double, micro>(end - start).count() / frames;
+
+				const double objects = static_cast<double>(scene.occluders.size() + scene.occludees.size());
+				result.queriesPerFrame = static_cast<double>(queries) / frames;
+				result.drawsPerFrame = static_cast<double>(after.draws - before.draws) / frames;
+				result.culledPerFrame = static_cast<double>(after.predicatedDraws - before.predicatedDraws) / frames;
+				result.commandsPerFrame = static_cast<double>(after.commands - before.commands) / frames;
+				result.deviceBytesPerObject = renderer.GetDeviceBytes() / objects;
+				result.sceneBytesPerObject = sizeof(Quad);
+				result.commandBytesPerObject = result.commandsPerFrame * sizeof(Backend::Null::CommandList::Command) / objects;
+				return result;
+			}
+
+			const char* ToString(BackendKind backend)
+			{
+				return backend == BackendKind::Software ? "software" : "null";
+			}
+
+			const char* ToString(SizeDistribution sizes)
+			{
+				return sizes == SizeDistribution::PowerLaw ? "power-law" : "uniform";
+			}
+
+			const char* ToString(Rendering::Animation animation)
+			{
+				switch (animation)
+				{
+				case Rendering::Animation::Sweep: return "sweep";
+				case Rendering::Animation::Orbit: return "orbit";
+				case Rendering::Animation::Drift: return "drift";
+				default: return "none";
+				}
+			}
+
+			string ToJson(const StageTime& time)
+			{
+				char text[96];
+				snprintf(text, sizeof(text), "{ \"meanUs\": %.3f, \"maxUs\": %.3f }", time.meanMicroseconds, time.maxMicroseconds);
+				return text;
+			}
+		}
+
+		Result Run(const SceneDesc& sceneDesc, const Options& options)
+		{
+			const Scene scene = GenerateScene(sceneDesc);
+			const uint32_t objects = sceneDesc.occluders + sceneDesc.occludees;
+			uint32_t frames = options.frames;
+			if (!frames)
+			{
+				// About two million objects in total, within limits that keep small scenes short on
+				// the software backend and large ones meaningful.
+				const uint32_t maxFrames = options.backend == BackendKind::Software ? 60 : 1000;
+				frames = objects ? 2000000 / objects : maxFrames;
+				frames = frames < 5 ? 5 : (frames > maxFrames ? maxFrames : frames);
+			}
+
+			Result result;
+			if (options.backend == BackendKind::Software)
+			{
+				Threading::ThreadPool threadPool;
+				threadPool.Initialize(options.threadCount);
+				Backend::Software::Device device(&threadPool);
+				Backend::Software::SwapChain swapChain(Rendering::SceneRenderer::FrameCount, options.width, options.height);
+				Backend::Software::PipelineDesc queryDesc;
+				queryDesc.colorWrite = false;
+				queryDesc.depthWrite = false;
+				Backend::Software::Pipeline scenePipeline("Scene", Backend::Software::PipelineDesc());
+				Backend::Software::Pipeline queryPipeline("Query", queryDesc);
+
+				Rendering::SceneRenderer renderer;
+				renderer.Initialize(&device, &swapChain, options.width, options.height, &scene);
+				renderer.SetPipelines(&scenePipeline, &queryPipeline);
+				result = Measure(renderer, scene, device.GetSoftwareQueue(), frames);
+			}
+			else
+			{
+				Backend::Null::Device device;
+				Backend::Null::SwapChain swapChain(Rendering::SceneRenderer::FrameCount, options.width, options.height);
+				Backend::Null::Pipeline scenePipeline("Scene");
+				Backend::Null::Pipeline queryPipeline("Query");
+				device.GetNullQueue().SetOcclusionPeriod(options.occlusionPeriod);
+
+				Rendering::SceneRenderer renderer;
+				renderer.Initialize(&device, &swapChain, options.width, options.height, &scene);
+				renderer.SetPipelines(&scenePipeline, &queryPipeline);
+				result = Measure(renderer, scene, device.GetNullQueue(), frames);
+			}
+			result.scene = sceneDesc;
+			result.options = options;
+			return result;
+		}
+
+		vector<Result> RunScaling(uint32_t maxObjects, const SceneDesc& shape, const Options& options)
+		{
+			vector<Result> results;
+			for (uint64_t objects = 10; objects <= maxObjects; objects *= 10)
+			{
+				SceneDesc desc = shape;
+				desc.occluders = static_cast<uint32_t>(objects / 4);
+				desc.occludees = static_cast<uint32_t>(objects) - desc.occluders;
+				results.push_back(Run(desc, options));
+			}
+			return results;
+		}
+
+		string ToJson(const vector<Result>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"scene-scaling\",\n\t\"runs\": [";
+			char text[1024];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const Result& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{\n"
+					"\t\t\t\"backend\": \"%s\", \"width\": %u, \"height\": %u, \"frames\": %u,\n"
+					"\t\t\t\"occluders\": %u, \"occludees\": %u, \"depthComplexity\": %.3f, \"sizes\": \"%s\", \"animation\": \"%s\", \"seed\": %u,\n",
+					i ? "," : "",
+					ToString(result.options.backend), result.options.width, result.options.height, result.frames,
+					result.scene.occluders, result.scene.occludees, result.scene.depthComplexity,
+					ToString(result.scene.sizes), ToString(result.scene.animation), result.scene.seed);
+				json += text;
+				json += "\t\t\t\"stages\": { \"update\": " + ToJson(result.update) + ", \"record\": " + ToJson(result.record) +
+					", \"submit\": " + ToJson(result.submit) + ", \"present\": " + ToJson(result.present) + " },\n";
+				snprintf(text, sizeof(text),
+					"\t\t\t\"frameUs\": %.3f, \"queriesPerFrame\": %.1f, \"drawsPerFrame\": %.1f, \"culledPerFrame\": %.1f, \"commandsPerFrame\": %.1f,\n"
+					"\t\t\t\"deviceBytesPerObject\": %.1f, \"sceneBytesPerObject\": %.1f, \"commandBytesPerObject\": %.1f\n"
+					"\t\t}",
+					result.frameMicroseconds, result.queriesPerFrame, result.drawsPerFrame, result.culledPerFrame, result.commandsPerFrame,
+					result.deviceBytesPerObject, result.sceneBytesPerObject, result.commandBytesPerObject);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
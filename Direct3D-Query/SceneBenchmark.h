@@ -0,0 +1,56 @@
+#pragma once
+#include "SceneGenerator.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		enum class BackendKind : uint8_t
+		{
+			Null,
+			Software
+		};
+
+		struct Options
+		{
+			BackendKind backend = BackendKind::Null;
+			uint32_t width = 1280, height = 720;
+			uint32_t frames = 0;	//0 scales the frame count down as the scene grows
+			uint32_t threadCount = 0;	//software backend tile workers, 0 for one per hardware thread
+			uint32_t occlusionPeriod = 3;	//null backend, see Null::Queue::SetOcclusionPeriod
+		};
+
+		struct StageTime
+		{
+			double meanMicroseconds = 0;
+			double maxMicroseconds = 0;
+		};
+
+		struct Result
+		{
+			SceneDesc scene;
+			Options options;
+			uint32_t frames = 0;
+
+			// CPU time of each step of the frame, after warm-up frames that fill the query results.
+			// On the software backend Submit includes rasterization.
+			StageTime update, record, submit, present;
+			double frameMicroseconds = 0;
+
+			double queriesPerFrame = 0;
+			double drawsPerFrame = 0;
+			double culledPerFrame = 0;	//occludee draws skipped by predication
+			double commandsPerFrame = 0;
+
+			double deviceBytesPerObject = 0;	//buffers and query slots
+			double sceneBytesPerObject = 0;
+			double commandBytesPerObject = 0;	//a frame's recording in the headless backends
+		};
+
+		Result Run(const SceneDesc& scene, const Options& options);
+
+		// Scenes of 10, 100, ... up to maxObjects objects, a quarter of them occluders.
+		vector<Result> RunScaling(uint32_t maxObjects, const SceneDesc& shape, const Options& options);
+
+		string ToJson(const vector<Result>& results);
+	}
+}
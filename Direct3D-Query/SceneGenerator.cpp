@@ -0,0 +1,278 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Quad;
+		using Rendering::Scene;
+
+		namespace
+		{
+			const float OccludeeCoverage = 0.5f;
+		}
+
+		Scene GenerateScene(const SceneDesc& desc)
+		{
+			Random random(desc.seed);
+			Scene scene;
+			scene.animation = desc.animation;
+
+			// Occluder areas add up to depthComplexity screens.
+			vector<float> weights(desc.occluders, 1.0f);
+			if (desc.sizes == SizeDistribution::PowerLaw)
+			{
+				// Pareto with alpha 1.5, capped so that one occluder cannot take the whole budget.
+				for (float& weight : weights)
+				{
+					const float value = powf(1.0f - random.Uniform(), -1.0f / 1.5f);
+					weight = value < 1000.0f ? value : 1000.0f;
+				}
+			}
+			float weightSum = 0;
+			for (float weight : weights)
+			{
+				weightSum += weight;
+			}
+
+			scene.occluders.reserve(desc.occluders);
+			for (uint32_t i = 0; i < desc.occluders; i++)
+			{
+				Quad quad = PlaceQuad(random, desc.depthComplexity * ScreenArea * weights[i] / weightSum, 0.05f, 0.45f);
+				const float shade = random.Uniform(0.2f, 0.6f);
+				quad.color[0] = shade;
+				quad.color[1] = shade;
+				quad.color[2] = shade;
+				quad.color[3] = 1.0f;
+				scene.occluders.push_back(quad);
+			}
+
+			scene.occludees.reserve(desc.occludees);
+			const float occludeeArea = desc.occludees ? OccludeeCoverage * ScreenArea / desc.occludees : 0;
+			for (uint32_t i = 0; i < desc.occludees; i++)
+			{
+				Quad quad = PlaceQuad(random, occludeeArea, 0.5f, 0.95f);
+				quad.color[0] = random.Uniform();
+				quad.color[1] = random.Uniform();
+				quad.color[2] = random.Uniform();
+				quad.color[3] = 1.0f;
+				scene.occludees.push_back(quad);
+			}
+			return scene;
+		}
+
+		Quad PlaceQuad(Random& random, float area, float nearDepth, float farDepth)
+		{
+			const float aspect = random.Uniform(0.5f, 2.0f);
+			float width = sqrtf(area * aspect), height = sqrtf(area / aspect);
+			width = width < 2.0f ? width : 2.0f;
+			height = height < 2.0f ? height : 2.0f;
+
+			Quad quad;
+			quad.left = random.Uniform(-1.0f, 1.0f - width);
+			quad.bottom = random.Uniform(-1.0f, 1.0f - height);
+			quad.right = quad.left + width;
+			quad.top = quad.bottom + height;
+			quad.depth = random.Uniform(nearDepth, farDepth);
+			return quad;
+		}
+
+		void GetBounds(const Scene& scene, const Rendering::SceneStore& store, vector<Culling::Bounds>& bounds)
+		{
+			const uint32_t count = static_cast<uint32_t>(scene.occluders.size());
+			bounds.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const Quad& quad = scene.occluders[i];
+				const float x = store.GetOffsetX(i), y = store.GetOffsetY(i);
+				bounds[i] = { { quad.left + x, quad.bottom + y, quad.depth }, { quad.right + x, quad.top + y, quad.depth } };
+			}
+		}
+
+		void DrawDepth(const vector<Quad>& quads, uint32_t width, uint32_t height, vector<float>& depth,
+			const float* quadMotions, vector<float>* motions)
+		{
+			depth.assign(static_cast<size_t>(width) * height, 1.0f);
+			if (motions)
+			{
+				motions->assign(static_cast<size_t>(width) * height * 2, 0.0f);
+			}
+			for (size_t i = 0; i < quads.size(); i++)
+			{
+				const Quad& quad = quads[i];
+				const float left = ceilf((quad.left * 0.5f + 0.5f) * width - 0.5f), right = ceilf((quad.right * 0.5f + 0.5f) * width - 0.5f);
+				const float top = ceilf((0.5f - quad.top * 0.5f) * height - 0.5f), bottom = ceilf((0.5f - quad.bottom * 0.5f) * height - 0.5f);
+				auto clamp = [](float value, uint32_t limit) { return value <= 0 ? 0 : value < limit ? static_cast<uint32_t>(value) : limit; };
+				const uint32_t x0 = clamp(left, width), x1 = clamp(right, width);
+				const uint32_t y0 = clamp(top, height), y1 = clamp(bottom, height);
+				for (uint32_t y = y0; y < y1; y++)
+				{
+					float* row = depth.data() + static_cast<size_t>(y) * width;
+					for (uint32_t x = x0; x < x1; x++)
+					{
+						if (quad.depth < row[x])
+						{
+							row[x] = quad.depth;
+							if (motions)
+							{
+								float* motion = motions->data() + (static_cast<size_t>(y) * width + x) * 2;
+								motion[0] = quadMotions[2 * i];
+								motion[1] = quadMotions[2 * i + 1];
+							}
+						}
+					}
+				}
+			}
+		}
+
+		bool IsHidden(const Culling::Bounds& bounds, const vector<float>& depth, uint32_t width, uint32_t height)
+		{
+			const float left = (bounds.min[0] * 0.5f + 0.5f) * width, right = (bounds.max[0] * 0.5f + 0.5f) * width;
+			const float top = (0.5f - bounds.max[1] * 0.5f) * height, bottom = (0.5f - bounds.min[1] * 0.5f) * height;
+			if (!(right >= 0 && left < width && bottom >= 0 && top < height))
+			{
+				return false;
+			}
+			const uint32_t x0 = left > 0 ? static_cast<uint32_t>(left) : 0, x1 = right < width ? static_cast<uint32_t>(right) : width - 1;
+			const uint32_t y0 = top > 0 ? static_cast<uint32_t>(top) : 0, y1 = bottom < height ? static_cast<uint32_t>(bottom) : height - 1;
+			for (uint32_t y = y0; y <= y1; y++)
+			{
+				const float* row = depth.data() + static_cast<size_t>(y) * width;
+				for (uint32_t x = x0; x <= x1; x++)
+				{
+					if (bounds.min[2] < row[x])
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		void GenerateMesh(Random& random, uint32_t segments, bool hole, vector<float>& positions)
+		{
+			const float centerX = random.Uniform(-0.6f, 0.6f), centerY = random.Uniform(-0.6f, 0.6f);
+			const float radius = random.Uniform(0.15f, 0.4f), wobble = random.Uniform(0.1f, 0.3f);
+			const float lobes = static_cast<float>(2 + random.Next() % 6), phase = random.Uniform(0.0f, 6.2831853f);
+			const float depth = random.Uniform(0.3f, 0.7f), slopeX = random.Uniform(-0.3f, 0.3f), slopeY = random.Uniform(-0.3f, 0.3f);
+			const float bands[3] = { hole ? 0.4f : 0.0f, 0.7f, 1.0f };
+
+			// Rims at the band fractions of each sector's radius; the center when there is no hole.
+			vector<float> rims(static_cast<size_t>(segments) * 9);
+			for (uint32_t i = 0; i < segments; i++)
+			{
+				const float angle = 6.2831853f * i / segments;
+				const float outer = radius * (1 + wobble * sinf(lobes * angle + phase)) * random.Uniform(0.97f, 1.0f);
+				for (uint32_t band = 0; band < 3; band++)
+				{
+					float* point = rims.data() + (static_cast<size_t>(i) * 3 + band) * 3;
+					point[0] = centerX + outer * bands[band] * cosf(angle);
+					point[1] = centerY + outer * bands[band] * sinf(angle);
+					point[2] = depth + slopeX * (point[0] - centerX) + slopeY * (point[1] - centerY);
+				}
+			}
+			positions.clear();
+			auto add = [&](uint32_t sector, uint32_t band)
+			{
+				const float* point = rims.data() + (static_cast<size_t>(sector % segments) * 3 + band) * 3;
+				positions.insert(positions.end(), point, point + 3);
+			};
+			for (uint32_t i = 0; i < segments; i++)
+			{
+				for (uint32_t band = 0; band < 2; band++)
+				{
+					if (band || hole)
+					{
+						add(i, band);
+						add(i + 1, band);
+						add(i, band + 1);
+					}
+					add(i + 1, band);
+					add(i + 1, band + 1);
+					add(i, band + 1);
+				}
+			}
+		}
+
+		void DrawTriangles(const float* positions, uint32_t triangleCount, uint32_t width, uint32_t height, vector<float>& depth)
+		{
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+			{
+				float x[3], y[3], z[3];
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const float* point = positions + (static_cast<size_t>(triangle) * 3 + corner) * 3;
+					x[corner] = (point[0] * 0.5f + 0.5f) * width;
+					y[corner] = (0.5f - point[1] * 0.5f) * height;
+					z[corner] = point[2];
+				}
+				const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+				if (!(area != 0))
+				{
+					continue;
+				}
+				const float minX = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+				const float maxX = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+				const float minY = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+				const float maxY = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+				auto clamp = [](float value, uint32_t limit) { return value <= 0 ? 0 : value < limit ? static_cast<uint32_t>(value) : limit; };
+				const uint32_t x0 = clamp(ceilf(minX - 0.5f), width), x1 = clamp(floorf(maxX - 0.5f) + 1, width);
+				const uint32_t y0 = clamp(ceilf(minY - 0.5f), height), y1 = clamp(floorf(maxY - 0.5f) + 1, height);
+				for (uint32_t py = y0; py < y1; py++)
+				{
+					float* row = depth.data() + static_cast<size_t>(py) * width;
+					const float centerY = py + 0.5f;
+					for (uint32_t px = x0; px < x1; px++)
+					{
+						const float centerX = px + 0.5f;
+						const float w0 = ((x[2] - x[1]) * (centerY - y[1]) - (y[2] - y[1]) * (centerX - x[1])) / area;
+						const float w1 = ((x[0] - x[2]) * (centerY - y[2]) - (y[0] - y[2]) * (centerX - x[2])) / area;
+						const float w2 = ((x[1] - x[0]) * (centerY - y[0]) - (y[1] - y[0]) * (centerX - x[0])) / area;
+						if (w0 >= 0 && w1 >= 0 && w2 >= 0)
+						{
+							const float value = w0 * z[0] + w1 * z[1] + w2 * z[2];
+							row[px] = value < row[px] ? value : row[px];
+						}
+					}
+				}
+			}
+		}
+
+		void GenerateBlob(Random& random, uint32_t rings, vector<float>& positions, vector<uint32_t>& indices)
+		{
+			const float centerX = random.Uniform(-0.7f, 0.7f), centerY = random.Uniform(-0.7f, 0.7f), centerZ = random.Uniform(0.45f, 0.85f);
+			const float radius = random.Uniform(0.08f, 0.25f), wobble = random.Uniform(0.05f, 0.2f);
+			const float lobes = static_cast<float>(2 + random.Next() % 6), phase = random.Uniform(0.0f, 6.2831853f);
+			const uint32_t segments = rings * 2;
+			positions.clear();
+			indices.clear();
+			for (uint32_t ring = 0; ring <= rings; ring++)
+			{
+				const float polar = 3.1415927f * ring / rings;
+				for (uint32_t segment = 0; segment <= segments; segment++)
+				{
+					const float azimuth = 6.2831853f * segment / segments;
+					const float distance = radius * (1 + wobble * sinf(lobes * azimuth + phase) * sinf(polar));
+					positions.push_back(centerX + distance * sinf(polar) * cosf(azimuth));
+					positions.push_back(centerY + distance * sinf(polar) * sinf(azimuth));
+					positions.push_back(centerZ + 0.4f * distance * cosf(polar));
+				}
+			}
+			for (uint32_t ring = 0; ring < rings; ring++)
+			{
+				for (uint32_t segment = 0; segment < segments; segment++)
+				{
+					const uint32_t a = ring * (segments + 1) + segment, b = a + segments + 1;
+					if (ring > 0)
+					{
+						indices.insert(indices.end(), { a, b, a + 1 });
+					}
+					if (ring < rings - 1)
+					{
+						indices.insert(indices.end(), { b, b + 1, a + 1 });
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "SceneRenderer.h"
+#include "BoundingVolumeHierarchy.h"
+
+// Generated scenes and reference rasterization on the CPU, shared by the benchmarks and the tests
+// of the culling code: a benchmark measures a feature on a generated scene, and a test checks the
+// feature's answers against these references on a smaller one.
+namespace Query {
+	namespace Benchmark
+	{
+		const float ScreenArea = 4.0f;	//normalized device coordinates span [-1, 1] on both axes
+		// The rasterizers interpolate a quad's constant depth with an error of a few ulps.
+		const float InterpolationTolerance = 1e-6f;
+
+		// PCG32, so that scenes do not depend on the standard library's distributions.
+		class Random
+		{
+		private:
+			uint64_t m_state;
+
+		public:
+			explicit Random(uint32_t seed) : m_state(seed + 0x853C49E6748FEA9Bull) { Next(); }
+
+			uint32_t Next()
+			{
+				const uint64_t state = m_state;
+				m_state = state * 6364136223846793005ull + 1442695040888963407ull;
+				const uint32_t xorShifted = static_cast<uint32_t>(((state >> 18) ^ state) >> 27);
+				const uint32_t rotation = static_cast<uint32_t>(state >> 59);
+				return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+			}
+
+			// [0, 1) with 24 bits of precision.
+			float Uniform() { return static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f); }
+			float Uniform(float low, float high) { return low + (high - low) * Uniform(); }
+		};
+
+		enum class SizeDistribution : uint8_t
+		{
+			Uniform,	//all occluders have the same area
+			PowerLaw	//a few large occluders and many small ones, so depth complexity varies over the screen
+		};
+
+		// A generated scene. The same description always generates the same scene, on any platform.
+		struct SceneDesc
+		{
+			uint32_t occluders = 16;
+			uint32_t occludees = 64;
+			float depthComplexity = 2.0f;	//occluder layers over the average pixel
+			SizeDistribution sizes = SizeDistribution::Uniform;
+			Rendering::Animation animation = Rendering::Animation::Sweep;
+			uint32_t seed = 1;
+		};
+
+		// Occluders lie in front of all occludees; occludees together cover half the screen.
+		Rendering::Scene GenerateScene(const SceneDesc& desc);
+
+		// A quad of the given area and random aspect within the screen, at a depth in [nearDepth, farDepth).
+		Rendering::Quad PlaceQuad(Random& random, float area, float nearDepth, float farDepth);
+
+		// The bounds of the scene's occluders at the offsets of store.
+		void GetBounds(const Rendering::Scene& scene, const Rendering::SceneStore& store, vector<Culling::Bounds>& bounds);
+
+		// Draws quads into a D32 buffer cleared to 1 with LESS, covering the pixels whose centers they
+		// cover. With quadMotions, also writes the x and y motion of each pixel's nearest quad to motions.
+		void DrawDepth(const vector<Rendering::Quad>& quads, uint32_t width, uint32_t height, vector<float>& depth,
+			const float* quadMotions = nullptr, vector<float>* motions = nullptr);
+
+		// Whether bounds is behind depth at every pixel its screen rectangle touches, the pixels
+		// Culling::DepthPyramid::IsOccluded looks at.
+		bool IsHidden(const Culling::Bounds& bounds, const vector<float>& depth, uint32_t width, uint32_t height);
+
+		// A star-shaped disc, or a ring when hole is set, of segments sectors in two bands, as a
+		// triangle list with three floats per vertex, tilted in depth within (0, 1).
+		void GenerateMesh(Random& random, uint32_t segments, bool hole, vector<float>& positions);
+
+		// Draws a triangle list into a D32 buffer with LESS, covering the pixels whose centers lie in
+		// or on a triangle.
+		void DrawTriangles(const float* positions, uint32_t triangleCount, uint32_t width, uint32_t height, vector<float>& depth);
+
+		// A closed, lumpy ellipsoid of rings bands from pole to pole and twice as many segments
+		// around, flattened in depth within (0, 1), with indexed vertices and outward normals by the
+		// right-hand rule. Seam vertices are repeated; the triangles that would be points at the
+		// poles are left out.
+		void GenerateBlob(Random& random, uint32_t rings, vector<float>& positions, vector<uint32_t>& indices);
+
+		inline double MillisecondsSince(chrono::steady_clock::time_point start)
+		{
+			return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		}
+	}
+}
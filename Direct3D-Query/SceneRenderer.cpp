@@ -0,0 +1,557 @@
+#include "pch.h"
+#include "SceneRenderer.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		using namespace Backend;
+
+		namespace
+		{
+			const float SweepSpeed = 0.01f;
+			const float SweepBounds = 1.5f;
+			const float OrbitRadius = 0.05f;
+			const float OrbitSpeed = 0.02f;
+			const float GoldenAngle = 2.39996323f;
+			const float DriftSpeed = 0.01f;
+			// Drifting occluders off screen for this many frames are only moved every DriftRefreshInterval frames.
+			const uint32_t DriftHiddenFrames = 4;
+			const uint32_t DriftRefreshInterval = 8;
+			// Pulls the query quads in front of the occludees they test, as the sample's bounding box.
+			const float BoundsDepthBias = -0.0001f;
+			// How far occluders shrink and query quads grow in the query depth, in its texels: half a
+			// texel, with room for snapping to the rasterizer's grid of 1/256 texel.
+			const float QueryPadding = 0.5f + 1.0f / 128.0f;
+
+			void AppendQuad(vector<Vertex>& vertices, const Quad& quad)
+			{
+				const float x[] = { quad.left, quad.left, quad.right, quad.right };
+				const float y[] = { quad.bottom, quad.top, quad.bottom, quad.top };
+				for (int i = 0; i < 4; i++)
+				{
+					vertices.push_back({ { x[i], y[i], quad.depth }, { quad.color[0], quad.color[1], quad.color[2], quad.color[3] } });
+				}
+			}
+		}
+
+		void SceneRenderer::AddDrift(const vector<Quad>& occluders, SceneStore& store)
+		{
+			const uint32_t count = static_cast<uint32_t>(occluders.size());
+			store.Reserve(store.GetCount() + count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const Quad& quad = occluders[i];
+				const float angle = GoldenAngle * static_cast<float>(i);
+				store.Add(quad.left, quad.bottom, quad.right, quad.top, DriftSpeed * cosf(angle), DriftSpeed * sinf(angle));
+			}
+		}
+
+		void SceneRenderer::Initialize(IDevice* device, ISwapChain* swapChain, uint32_t width, uint32_t height, const Scene* scene,
+			uint32_t queryShift, const Culling::OccluderSelector::Settings* occluderSelection)
+		{
+			m_device = device;
+			m_queue = device->GetQueue();
+			m_swapChain = swapChain;
+			m_width = width;
+			m_height = height;
+			m_scene = scene;
+			while (queryShift && ((width | height) & ((1u << queryShift) - 1)))
+			{
+				queryShift--;
+			}
+			m_queryShift = queryShift;
+			if (occluderSelection && m_queryShift)
+			{
+				m_selection = *occluderSelection;
+				m_occluderBounds.resize(scene->occluders.size());
+			}
+			m_frameIndex = swapChain->GetCurrentIndex();
+
+			m_commandList = device->CreateCommandList(FrameCount);
+			m_fence = device->CreateFence(m_fenceValues[m_frameIndex]);
+			m_fenceValues[m_frameIndex]++;
+
+			BuildRenderGraph();
+			CreateResources();
+
+			m_graphRecorder.Bind(m_depthHandle, m_depthStencil.get());
+			m_graphRecorder.Bind(m_vertexBufferHandle, m_vertexBuffer.get());
+			m_graphRecorder.Bind(m_queryResultHandle, m_queryResult.get());
+			if (m_queryShift)
+			{
+				m_graphRecorder.Bind(m_queryDepthHandle, m_queryDepth.get());
+			}
+		}
+
+		void SceneRenderer::SetPipelines(IPipeline* scene, IPipeline* query)
+		{
+			m_scenePipeline = scene;
+			m_queryPipeline = query;
+		}
+
+		unique_ptr<IResource> SceneRenderer::CreateResource(const ResourceDesc& desc, ResourceState initialState)
+		{
+			m_deviceBytes += desc.size;
+			return m_device->CreateResource(desc, initialState);
+		}
+
+		void SceneRenderer::CreateResources()
+		{
+			const uint32_t occluderCount = static_cast<uint32_t>(m_scene->occluders.size());
+			const uint32_t occludeeCount = static_cast<uint32_t>(m_scene->occludees.size());
+
+			vector<Vertex> vertices;
+			vertices.reserve((static_cast<size_t>(occluderCount) + occludeeCount) * (m_queryShift ? 8 : 4));
+			for (const Quad& quad : m_scene->occluders)
+			{
+				AppendQuad(vertices, quad);
+			}
+			m_firstOccludeeVertex = occluderCount * 4;
+			for (const Quad& quad : m_scene->occludees)
+			{
+				AppendQuad(vertices, quad);
+			}
+			if (m_queryShift)
+			{
+				// A query texel spans 2^shift pixels, 2^(shift + 1) / size in normalized device coordinates.
+				m_queryPadX = QueryPadding * static_cast<float>(2u << m_queryShift) / m_width;
+				m_queryPadY = QueryPadding * static_cast<float>(2u << m_queryShift) / m_height;
+				m_firstQueryOccluderVertex = static_cast<uint32_t>(vertices.size());
+				for (const Quad& quad : m_scene->occluders)
+				{
+					AppendQuad(vertices, ShrinkForQuery(quad));
+				}
+				m_firstQueryVertex = static_cast<uint32_t>(vertices.size());
+				for (Quad quad : m_scene->occludees)
+				{
+					quad.left -= m_queryPadX;
+					quad.right += m_queryPadX;
+					quad.bottom -= m_queryPadY;
+					quad.top += m_queryPadY;
+					AppendQuad(vertices, quad);
+				}
+			}
+			else
+			{
+				m_firstQueryOccluderVertex = 0;
+				m_firstQueryVertex = m_firstOccludeeVertex;
+			}
+			m_vertexBufferSize = static_cast<uint32_t>(vertices.size() * sizeof(Vertex));
+
+			m_vertexBuffer = CreateResource(ResourceDesc::Buffer(m_vertexBufferSize), StateCopyDest);
+			unique_ptr<IResource> vertexBufferUpload = m_device->CreateResource(ResourceDesc::Buffer(m_vertexBufferSize, HeapKind::Upload), StateCommon);
+			memcpy(vertexBufferUpload->Map(), vertices.data(), m_vertexBufferSize);
+			vertexBufferUpload->Unmap();
+
+			// Every frame in flight has its own slots, so Update never writes what the GPU may read.
+			const bool perObject = m_scene->animation == Animation::Orbit || m_scene->animation == Animation::Drift;
+			m_slotsPerFrame = ObjectSlots + (perObject ? occluderCount : 0);
+			const uint64_t constantBufferSize = static_cast<uint64_t>(FrameCount) * m_slotsPerFrame * sizeof(SceneConstantBuffer);
+			m_constantBuffer = CreateResource(ResourceDesc::Buffer(constantBufferSize, HeapKind::Upload), StateCommon);
+			m_pCbvDataBegin = static_cast<uint8_t*>(m_constantBuffer->Map());
+			memset(m_pCbvDataBegin, 0, static_cast<size_t>(constantBufferSize));
+			for (uint32_t frame = 0; frame < FrameCount; frame++)
+			{
+				WriteSlot(frame, BoundsSlot, 0, 0, BoundsDepthBias);
+			}
+
+			// No more occluders are fused than are selected, nor than half the scene's.
+			if (!m_occluderBounds.empty())
+			{
+				for (uint32_t i = 0; i < occluderCount; i++)
+				{
+					MoveBounds(i, 0, 0);
+				}
+				m_fusedCapacity = occluderCount / 2 < m_selection.maxOccluders ? occluderCount / 2 : m_selection.maxOccluders;
+				if (m_fusedCapacity)
+				{
+					const uint64_t fusedSize = static_cast<uint64_t>(FrameCount) * m_fusedCapacity * 4 * sizeof(Vertex);
+					m_fusedVertexBuffer = CreateResource(ResourceDesc::Buffer(fusedSize, HeapKind::Upload), StateCommon);
+					m_fusedVertices = static_cast<Vertex*>(m_fusedVertexBuffer->Map());
+				}
+			}
+
+			m_drift.Reset(SweepBounds);
+			if (m_scene->animation == Animation::Drift)
+			{
+				AddDrift(m_scene->occluders, m_drift);
+				SceneStore::Schedule schedule;
+				schedule.hiddenFrames = DriftHiddenFrames;
+				schedule.refreshInterval = DriftRefreshInterval;
+				m_drift.SetSchedule(schedule);
+			}
+
+			// One query and one 64-bit predicate per occludee.
+			const uint32_t queryCount = occludeeCount ? occludeeCount : 1;
+			m_queryHeap = m_device->CreateQueryHeap(QueryType::BinaryOcclusion, queryCount);
+			m_deviceBytes += static_cast<uint64_t>(queryCount) * sizeof(uint64_t);
+			m_queryResult = CreateResource(ResourceDesc::Buffer(static_cast<uint64_t>(queryCount) * sizeof(uint64_t)), StatePredication);
+
+			uint32_t firstStep, lastStep;
+			m_renderGraph.GetLifetime(m_depthHandle, firstStep, lastStep);
+			m_depthStencil = m_device->CreateTransient(
+				ResourceDesc::Texture(ResourceKind::DepthStencil, m_width, m_height, Format::D32Float),
+				StateDepthWrite, firstStep, lastStep);
+			if (m_queryShift)
+			{
+				m_renderGraph.GetLifetime(m_queryDepthHandle, firstStep, lastStep);
+				m_queryDepth = m_device->CreateTransient(
+					ResourceDesc::Texture(ResourceKind::DepthStencil, m_width >> m_queryShift, m_height >> m_queryShift, Format::D32Float),
+					StateDepthWrite, firstStep, lastStep);
+			}
+			m_device->CompileTransients();
+
+			m_commandList->Reset(m_frameIndex);
+			m_commandList->CopyBuffer(m_vertexBuffer.get(), 0, vertexBufferUpload.get(), 0, m_vertexBufferSize);
+			ICommandList::Transition transition = { m_vertexBuffer.get(), StateCopyDest, StateVertexAndConstantBuffer };
+			m_commandList->Barriers(&transition, 1);
+			m_commandList->Close();
+			m_queue->Submit(m_commandList.get());
+
+			// The upload buffer can only be released once the copy has completed.
+			WaitForGpu();
+		}
+
+		void SceneRenderer::WriteSlot(uint32_t frame, uint32_t slot, float x, float y, float z)
+		{
+			auto destination = reinterpret_cast<float*>(m_pCbvDataBegin + GetSlotOffset(frame, slot));
+			destination[0] = x;
+			destination[1] = y;
+			destination[2] = z;
+			destination[3] = 0;
+		}
+
+		void SceneRenderer::DrawOccluders(uint32_t firstVertex)
+		{
+			const uint32_t count = static_cast<uint32_t>(m_scene->occluders.size());
+			switch (m_scene->animation)
+			{
+			case Animation::Orbit:
+				for (uint32_t i = 0; i < count; i++)
+				{
+					m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, ObjectSlots + i));
+					m_commandList->Draw(4, firstVertex + i * 4);
+				}
+				break;
+
+			case Animation::Drift:
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (m_drift.IsVisible(i))
+					{
+						m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, ObjectSlots + i));
+						m_commandList->Draw(4, firstVertex + i * 4);
+					}
+				}
+				break;
+
+			default:
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, m_scene->animation == Animation::Sweep ? SweepSlot : StaticSlot));
+				for (uint32_t i = 0; i < count; i++)
+				{
+					m_commandList->Draw(4, firstVertex + i * 4);
+				}
+				break;
+			}
+		}
+
+		Quad SceneRenderer::ShrinkForQuery(Quad quad) const
+		{
+			// Occluders narrower than a texel cover none.
+			quad.left += m_queryPadX;
+			quad.right = quad.right - m_queryPadX > quad.left ? quad.right - m_queryPadX : quad.left;
+			quad.bottom += m_queryPadY;
+			quad.top = quad.top - m_queryPadY > quad.bottom ? quad.top - m_queryPadY : quad.bottom;
+			return quad;
+		}
+
+		void SceneRenderer::MoveBounds(uint32_t occluder, float x, float y)
+		{
+			const Quad& quad = m_scene->occluders[occluder];
+			m_occluderBounds[occluder] = { { quad.left + x, quad.bottom + y, quad.depth }, { quad.right + x, quad.top + y, quad.depth } };
+		}
+
+		void SceneRenderer::SelectOccluders()
+		{
+			m_selector.Select(m_occluderBounds.data(), nullptr, static_cast<uint32_t>(m_occluderBounds.size()), m_selection);
+
+			// Fused occluders lie in screen space, so they are drawn without an offset.
+			m_fusedQuads.clear();
+			for (const Culling::OccluderSelector::Occluder& occluder : m_selector.GetSelected())
+			{
+				if (occluder.source == Culling::OccluderSelector::Fused)
+				{
+					Quad quad = {};
+					quad.left = occluder.bounds.min[0];
+					quad.bottom = occluder.bounds.min[1];
+					quad.right = occluder.bounds.max[0];
+					quad.top = occluder.bounds.max[1];
+					quad.depth = occluder.bounds.max[2];
+					AppendQuad(m_fusedQuads, ShrinkForQuery(quad));
+				}
+			}
+			m_fusedCount[m_frameIndex] = static_cast<uint32_t>(m_fusedQuads.size() / 4);
+			if (!m_fusedQuads.empty())
+			{
+				memcpy(m_fusedVertices + static_cast<size_t>(m_frameIndex) * m_fusedCapacity * 4, m_fusedQuads.data(), m_fusedQuads.size() * sizeof(Vertex));
+			}
+		}
+
+		void SceneRenderer::DrawSelectedOccluders()
+		{
+			const uint32_t fused = m_fusedCount[m_frameIndex];
+			if (fused)
+			{
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, StaticSlot));
+				m_commandList->SetVertexBuffer(m_fusedVertexBuffer.get(), sizeof(Vertex), FrameCount * m_fusedCapacity * 4 * static_cast<uint32_t>(sizeof(Vertex)));
+				for (uint32_t i = 0; i < fused; i++)
+				{
+					m_commandList->Draw(4, (m_frameIndex * m_fusedCapacity + i) * 4);
+				}
+				m_commandList->SetVertexBuffer(m_vertexBuffer.get(), sizeof(Vertex), m_vertexBufferSize);
+			}
+
+			const bool perObject = m_scene->animation == Animation::Orbit || m_scene->animation == Animation::Drift;
+			if (!perObject)
+			{
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, m_scene->animation == Animation::Sweep ? SweepSlot : StaticSlot));
+			}
+			for (const Culling::OccluderSelector::Occluder& occluder : m_selector.GetSelected())
+			{
+				const uint32_t i = occluder.source;
+				if (i == Culling::OccluderSelector::Fused || (m_scene->animation == Animation::Drift && !m_drift.IsVisible(i)))
+				{
+					continue;
+				}
+				if (perObject)
+				{
+					m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, ObjectSlots + i));
+				}
+				m_commandList->Draw(4, m_firstQueryOccluderVertex + i * 4);
+			}
+		}
+
+		void SceneRenderer::BuildRenderGraph()
+		{
+			m_renderGraph.Reset();
+			m_backBufferHandle = m_renderGraph.ImportResource("BackBuffer", StatePresent, StatePresent);
+			m_depthHandle = m_renderGraph.CreateTransient("Depth", StateDepthWrite);
+			m_vertexBufferHandle = m_renderGraph.ImportResource("VertexBuffer", StateVertexAndConstantBuffer, StateVertexAndConstantBuffer, false);
+			m_queryResultHandle = m_renderGraph.ImportResource("QueryResult", StatePredication, StatePredication);
+			m_occlusionHandle = m_renderGraph.CreateVirtual("OcclusionQuery");
+			if (m_queryShift)
+			{
+				m_queryDepthHandle = m_renderGraph.CreateTransient("QueryDepth", StateDepthWrite);
+			}
+
+			uint32_t clear = m_renderGraph.AddPass("Clear", QueueType::Graphics, [this]()
+			{
+				const float clearColor[] = { 0.5f, 0.7f, 0.8f, 1.0f };
+				m_commandList->ClearRenderTarget(m_swapChain->GetBuffer(m_frameIndex), clearColor);
+				m_commandList->ClearDepth(m_depthStencil.get(), 1.0f);
+			});
+			m_renderGraph.Write(clear, m_backBufferHandle, StateRenderTarget);
+			m_renderGraph.Write(clear, m_depthHandle, StateDepthWrite);
+
+			uint32_t occluders = m_renderGraph.AddPass("Occluders", QueueType::Graphics, [this]()
+			{
+				m_commandList->SetRenderTargets(m_swapChain->GetBuffer(m_frameIndex), m_depthStencil.get());
+				m_commandList->SetPipeline(m_scenePipeline);
+				m_commandList->SetVertexBuffer(m_vertexBuffer.get(), sizeof(Vertex), m_vertexBufferSize);
+
+				DrawOccluders(0);
+			});
+			m_renderGraph.Read(occluders, m_vertexBufferHandle, StateVertexAndConstantBuffer);
+			m_renderGraph.Write(occluders, m_backBufferHandle, StateRenderTarget);
+			m_renderGraph.Write(occluders, m_depthHandle, StateDepthWrite);
+
+			// Each occludee is skipped when its query found it hidden in the previous frame.
+			uint32_t occludees = m_renderGraph.AddPass("Occludees", QueueType::Graphics, [this]()
+			{
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, StaticSlot));
+				const uint32_t count = static_cast<uint32_t>(m_scene->occludees.size());
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (m_queryResultValid)
+					{
+						m_commandList->SetPredication(m_queryResult.get(), static_cast<uint64_t>(i) * sizeof(uint64_t));
+					}
+					m_commandList->Draw(4, m_firstOccludeeVertex + i * 4);
+				}
+				m_commandList->SetPredication(nullptr, 0);
+			});
+			m_renderGraph.Read(occludees, m_queryResultHandle, StatePredication);
+			m_renderGraph.Read(occludees, m_vertexBufferHandle, StateVertexAndConstantBuffer);
+			m_renderGraph.Write(occludees, m_backBufferHandle, StateRenderTarget);
+			m_renderGraph.Write(occludees, m_depthHandle, StateDepthWrite);
+
+			// The occluders alone, shrunk, into the small depth buffer the queries then test.
+			if (m_queryShift)
+			{
+				uint32_t queryDepth = m_renderGraph.AddPass("QueryDepth", QueueType::Graphics, [this]()
+				{
+					m_commandList->ClearDepth(m_queryDepth.get(), 1.0f);
+					m_commandList->SetRenderTargets(nullptr, m_queryDepth.get());
+					m_commandList->SetViewport(m_width >> m_queryShift, m_height >> m_queryShift);
+					m_commandList->SetPipeline(m_scenePipeline);
+					if (m_occluderBounds.empty())
+					{
+						DrawOccluders(m_firstQueryOccluderVertex);
+					}
+					else
+					{
+						DrawSelectedOccluders();
+					}
+				});
+				m_renderGraph.Read(queryDepth, m_vertexBufferHandle, StateVertexAndConstantBuffer);
+				m_renderGraph.Write(queryDepth, m_queryDepthHandle, StateDepthWrite);
+			}
+
+			uint32_t query = m_renderGraph.AddPass("OcclusionQuery", QueueType::Graphics, [this]()
+			{
+				m_queryIssued = m_queryPipeline != nullptr && !m_scene->occludees.empty();
+				if (!m_queryIssued)
+				{
+					return;
+				}
+
+				m_commandList->SetConstantBuffer(0, m_constantBuffer.get(), GetSlotOffset(m_frameIndex, BoundsSlot));
+				m_commandList->SetPipeline(m_queryPipeline);
+				const uint32_t count = static_cast<uint32_t>(m_scene->occludees.size());
+				for (uint32_t i = 0; i < count; i++)
+				{
+					m_commandList->BeginQuery(m_queryHeap.get(), i);
+					m_commandList->Draw(4, m_firstQueryVertex + i * 4);
+					m_commandList->EndQuery(m_queryHeap.get(), i);
+				}
+			});
+			m_renderGraph.Read(query, m_vertexBufferHandle, StateVertexAndConstantBuffer);
+			if (m_queryShift)
+			{
+				m_renderGraph.Read(query, m_queryDepthHandle, StateDepthRead);
+			}
+			else
+			{
+				m_renderGraph.Write(query, m_depthHandle, StateDepthWrite);
+			}
+			m_renderGraph.Write(query, m_occlusionHandle, StateCommon);
+
+			uint32_t resolve = m_renderGraph.AddPass("ResolveQuery", QueueType::Graphics, [this]()
+			{
+				if (m_queryIssued)
+				{
+					m_commandList->ResolveQuery(m_queryHeap.get(), 0, static_cast<uint32_t>(m_scene->occludees.size()), m_queryResult.get(), 0);
+					m_queryResultValid = true;
+				}
+			});
+			m_renderGraph.Read(resolve, m_occlusionHandle, StateCommon);
+			m_renderGraph.Write(resolve, m_queryResultHandle, StateCopyDest);
+
+			m_renderGraph.Compile();
+		}
+
+		void SceneRenderer::Update()
+		{
+			m_animationFrame++;
+			switch (m_scene->animation)
+			{
+			case Animation::Sweep:
+			{
+				float x = SweepSpeed * static_cast<float>(m_animationFrame % static_cast<uint64_t>(2 * SweepBounds / SweepSpeed));
+				x = x > SweepBounds ? x - 2 * SweepBounds : x;
+				WriteSlot(m_frameIndex, SweepSlot, x, 0, 0);
+				for (uint32_t i = 0; i < m_occluderBounds.size(); i++)
+				{
+					MoveBounds(i, x, 0);
+				}
+				break;
+			}
+
+			case Animation::Orbit:
+			{
+				const float time = OrbitSpeed * static_cast<float>(m_animationFrame);
+				const uint32_t count = static_cast<uint32_t>(m_scene->occluders.size());
+				for (uint32_t i = 0; i < count; i++)
+				{
+					const float angle = time + GoldenAngle * static_cast<float>(i);
+					const float x = OrbitRadius * cosf(angle), y = OrbitRadius * sinf(angle);
+					WriteSlot(m_frameIndex, ObjectSlots + i, x, y, 0);
+					if (!m_occluderBounds.empty())
+					{
+						MoveBounds(i, x, y);
+					}
+				}
+				break;
+			}
+
+			case Animation::Drift:
+			{
+				SceneStore::Output output;
+				output.destination = m_pCbvDataBegin + GetSlotOffset(m_frameIndex, ObjectSlots);
+				output.stride = sizeof(SceneConstantBuffer);
+				m_drift.Update(output);
+				// Sleeping occluders keep the offsets they fell asleep at, off the screen, so they are
+				// not selected.
+				for (uint32_t i = 0; i < m_occluderBounds.size(); i++)
+				{
+					MoveBounds(i, m_drift.GetOffsetX(i), m_drift.GetOffsetY(i));
+				}
+				break;
+			}
+
+			default:
+				break;
+			}
+			if (!m_occluderBounds.empty())
+			{
+				SelectOccluders();
+			}
+		}
+
+		void SceneRenderer::Record()
+		{
+			m_commandList->Reset(m_frameIndex);
+			m_commandList->SetViewport(m_width, m_height);
+
+			m_graphRecorder.SetCommandList(m_commandList.get());
+			m_graphRecorder.Bind(m_backBufferHandle, m_swapChain->GetBuffer(m_frameIndex));
+			m_renderGraph.Execute(m_graphRecorder);
+
+			m_commandList->Close();
+		}
+
+		void SceneRenderer::Submit()
+		{
+			m_queue->Submit(m_commandList.get());
+		}
+
+		void SceneRenderer::Present()
+		{
+			m_swapChain->Present();
+
+			const uint64_t currentFenceValue = m_fenceValues[m_frameIndex];
+			m_queue->Signal(m_fence.get(), currentFenceValue);
+
+			m_frameIndex = m_swapChain->GetCurrentIndex();
+			if (m_fence->GetCompletedValue() < m_fenceValues[m_frameIndex])
+			{
+				m_fence->Wait(m_fenceValues[m_frameIndex]);
+			}
+			m_fenceValues[m_frameIndex] = currentFenceValue + 1;
+		}
+
+		void SceneRenderer::Render()
+		{
+			Record();
+			Submit();
+			Present();
+		}
+
+		void SceneRenderer::WaitForGpu()
+		{
+			m_queue->Signal(m_fence.get(), m_fenceValues[m_frameIndex]);
+			m_fence->Wait(m_fenceValues[m_frameIndex]);
+			m_fenceValues[m_frameIndex]++;
+		}
+	}
+}
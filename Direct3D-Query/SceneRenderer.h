@@ -0,0 +1,161 @@
+#pragma once
+#include "Backend.h"
+#include "RenderGraphRecorder.h"
+#include "QueryRenderer.h"
+#include "SceneStore.h"
+#include "OccluderSelection.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		// A screen-aligned quad in normalized device coordinates.
+		struct Quad
+		{
+			float left, bottom, right, top;
+			float depth;
+			float color[4];
+		};
+
+		enum class Animation : uint8_t
+		{
+			None,
+			Sweep,	//all occluders move together, like the sample's near quad
+			Orbit,	//every occluder circles around its own position
+			Drift	//every occluder moves in its own direction and wraps around, see SceneStore
+		};
+
+		struct Scene
+		{
+			vector<Quad> occluders;
+			vector<Quad> occludees;
+			Animation animation = Animation::None;
+		};
+
+		// The occlusion query sample scaled to a whole scene. Occluders are drawn first; every
+		// occludee is drawn under predication from the previous frame's result of its own query,
+		// which tests the occludee quad itself, pulled slightly toward the viewer, after all
+		// occluders and occludees are drawn. All queries are resolved with one ResolveQuery.
+		//
+		// Static quads are baked into the vertex buffer and share one constant buffer. Animated
+		// occluders use a shared constant buffer (Sweep) or one each (Orbit, Drift), per frame in
+		// flight. Drifting occluders that have left the screen are not drawn, and those that stay
+		// away from it fall asleep and are only moved every few frames (see SceneStore::Schedule).
+		//
+		// With a query shift, the queries test a depth buffer 2^shift times smaller each way that
+		// holds the occluders alone, which saves the fill of large query quads at the cost of
+		// finding fewer occludees hidden. Every occluder is drawn into it shrunk by half a texel
+		// and every query quad grown by half a texel: an occluder then only covers texels that it
+		// covers whole, so each texel is no nearer than the max of the pixels it spans (see
+		// Culling::DepthPyramid::Downsample), and a query covers every texel it touches. An
+		// occludee is thus never found hidden that the full resolution occluders would show.
+		//
+		// With a query shift and occluder selection settings, Update selects the occluders at
+		// their positions of the frame (see Culling::OccluderSelector), and only those are drawn
+		// into the query depth; the fused ones from a vertex buffer written per frame in flight.
+		// The frame itself still shows every occluder.
+		class SceneRenderer
+		{
+		public:
+			static const uint32_t FrameCount = QueryRenderer::FrameCount;
+
+		private:
+			// Constant buffer slots of a frame, followed by the Orbit or Drift occluders' slots.
+			enum ConstantSlot : uint32_t
+			{
+				StaticSlot,
+				BoundsSlot,
+				SweepSlot,
+				ObjectSlots
+			};
+
+			Backend::IDevice* m_device = nullptr;
+			Backend::IQueue* m_queue = nullptr;
+			Backend::ISwapChain* m_swapChain = nullptr;
+			uint32_t m_width = 0, m_height = 0;
+			const Scene* m_scene = nullptr;
+
+			uint32_t m_frameIndex = 0;
+			unique_ptr<Backend::ICommandList> m_commandList;
+			unique_ptr<Backend::IFence> m_fence;
+			uint64_t m_fenceValues[FrameCount] = {};
+
+			Backend::IPipeline* m_scenePipeline = nullptr;
+			Backend::IPipeline* m_queryPipeline = nullptr;
+
+			unique_ptr<Backend::IResource> m_vertexBuffer;
+			uint32_t m_vertexBufferSize = 0;
+			uint32_t m_firstOccludeeVertex = 0;
+			uint32_t m_queryShift = 0;
+			uint32_t m_firstQueryOccluderVertex = 0, m_firstQueryVertex = 0;	//the shrunk occluders and grown query quads
+			unique_ptr<Backend::IResource> m_constantBuffer;
+			uint32_t m_slotsPerFrame = 0;
+			uint8_t* m_pCbvDataBegin = nullptr;
+			unique_ptr<Backend::IResource> m_depthStencil;
+			unique_ptr<Backend::IResource> m_queryDepth;	//with a query shift
+			unique_ptr<Backend::IQueryHeap> m_queryHeap;
+			unique_ptr<Backend::IResource> m_queryResult;
+			bool m_queryIssued = false;
+			bool m_queryResultValid = false;
+			uint64_t m_animationFrame = 0;
+			SceneStore m_drift;
+			uint64_t m_deviceBytes = 0;
+			float m_queryPadX = 0, m_queryPadY = 0;	//how far occluders shrink and query quads grow
+
+			Culling::OccluderSelector::Settings m_selection;
+			Culling::OccluderSelector m_selector;
+			vector<Culling::Bounds> m_occluderBounds;	//at the offsets of the frame, with occluder selection
+			vector<Vertex> m_fusedQuads;
+			unique_ptr<Backend::IResource> m_fusedVertexBuffer;	//upload heap, m_fusedCapacity quads per frame
+			Vertex* m_fusedVertices = nullptr;
+			uint32_t m_fusedCapacity = 0;
+			uint32_t m_fusedCount[FrameCount] = {};
+
+			RenderGraph m_renderGraph;
+			RenderGraphRecorder m_graphRecorder;
+			uint32_t m_backBufferHandle = 0, m_depthHandle = 0, m_vertexBufferHandle = 0, m_queryResultHandle = 0, m_occlusionHandle = 0;
+			uint32_t m_queryDepthHandle = 0;
+
+		private:
+			void BuildRenderGraph();
+			void CreateResources();
+			unique_ptr<Backend::IResource> CreateResource(const Backend::ResourceDesc& desc, ResourceState initialState);
+			uint64_t GetSlotOffset(uint32_t frame, uint32_t slot) const { return (static_cast<uint64_t>(frame) * m_slotsPerFrame + slot) * sizeof(SceneConstantBuffer); }
+			void WriteSlot(uint32_t frame, uint32_t slot, float x, float y, float z);
+			void DrawOccluders(uint32_t firstVertex);
+			Quad ShrinkForQuery(Quad quad) const;
+			void MoveBounds(uint32_t occluder, float x, float y);
+			void SelectOccluders();
+			void DrawSelectedOccluders();
+
+		public:
+			// Adds the occluders to store with the velocities Drift gives them.
+			static void AddDrift(const vector<Quad>& occluders, SceneStore& store);
+
+			// The scene must outlive the renderer and must not change. The swap chain needs FrameCount buffers.
+			// queryShift is lowered until 2^queryShift divides width and height. occluderSelection is
+			// ignored without a query shift.
+			void Initialize(Backend::IDevice* device, Backend::ISwapChain* swapChain, uint32_t width, uint32_t height, const Scene* scene,
+				uint32_t queryShift = 0, const Culling::OccluderSelector::Settings* occluderSelection = nullptr);
+			void SetPipelines(Backend::IPipeline* scene, Backend::IPipeline* query);
+
+			// Render is Record, Submit and Present; they are separate so that each can be timed.
+			void Update();
+			void Record();
+			void Submit();
+			void Present();
+			void Render();
+			void WaitForGpu();
+
+			uint32_t GetQueriesIssued() const { return m_queryIssued ? static_cast<uint32_t>(m_scene->occludees.size()) : 0; }
+			// Memory of the resources the renderer created, transients and the swap chain excluded.
+			uint64_t GetDeviceBytes() const { return m_deviceBytes; }
+			uint32_t GetQueryShift() const { return m_queryShift; }
+			// Empty without occluder selection.
+			const vector<Culling::OccluderSelector::Occluder>& GetSelectedOccluders() const { return m_selector.GetSelected(); }
+			// The depth the queries test with a query shift, and the resolved query results; the
+			// headless backends can read both.
+			Backend::IResource* GetQueryDepth() const { return m_queryDepth.get(); }
+			Backend::IResource* GetQueryResult() const { return m_queryResult.get(); }
+		};
+	}
+}
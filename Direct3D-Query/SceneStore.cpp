@@ -0,0 +1,433 @@
+#include "pch.h"
+#include "SceneStore.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define QUERY_SCENE_STORE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Query {
+	namespace Rendering
+	{
+		namespace
+		{
+			float Wrap(float offset, float bounds)
+			{
+				return offset > bounds ? -bounds : (offset < -bounds ? bounds : offset);
+			}
+
+			bool Overlaps(float low, float high)
+			{
+				return low < 1.0f && high > -1.0f;
+			}
+
+			uint32_t LowestBit(uint64_t value)
+			{
+#if defined(_MSC_VER)
+				unsigned long index;
+				_BitScanForward64(&index, value);
+				return index;
+#else
+				return __builtin_ctzll(value);
+#endif
+			}
+
+			uint32_t CountBits(const vector<uint64_t>& words)
+			{
+				uint32_t count = 0;
+				for (uint64_t word : words)
+				{
+					for (; word; word &= word - 1)
+					{
+						count++;
+					}
+				}
+				return count;
+			}
+
+			// The offset after frames Updates, with the same float operations as Update.
+			float Drift(float offset, float velocity, float bounds, uint32_t frames)
+			{
+				if (velocity == 0 && frames > 1)
+				{
+					frames = 1;	//the first step wraps an offset out of bounds, the others keep it
+				}
+				for (; frames; frames--)
+				{
+					const float moved = offset + velocity;
+					offset = Wrap(moved, bounds);
+					if (moved != offset)
+					{
+						frames--;
+						break;
+					}
+				}
+				// Every later wrap restarts at the bound the first one did, so from here on the
+				// offsets repeat with the number of frames of one lap.
+				uint32_t lap = 0;
+				while (lap < frames)
+				{
+					lap++;
+					const float moved = offset + velocity;
+					offset = Wrap(moved, bounds);
+					if (moved != offset)
+					{
+						break;
+					}
+				}
+				for (frames = lap ? (frames - lap) % lap : 0; frames; frames--)
+				{
+					offset = Wrap(offset + velocity, bounds);
+				}
+				return offset;
+			}
+
+			void Store(uint8_t* destination, float x, float y)
+			{
+				auto offset = reinterpret_cast<float*>(destination);
+				offset[0] = x;
+				offset[1] = y;
+				offset[2] = 0;
+				offset[3] = 0;
+			}
+
+#if QUERY_SCENE_STORE_SSE2
+			__m128 Select(__m128 mask, __m128 a, __m128 b)
+			{
+				return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+			}
+
+			__m128 Wrap(__m128 offset, __m128 upper, __m128 lower)
+			{
+				const __m128 above = _mm_cmpgt_ps(offset, upper);
+				const __m128 below = _mm_cmplt_ps(offset, lower);
+				return Select(above, lower, Select(below, upper, offset));
+			}
+#endif
+		}
+
+		void SceneStore::Reset(float wrapBounds)
+		{
+			m_wrapBounds = wrapBounds;
+			m_count = 0;
+			m_frame = 0;
+			for (auto array : { &m_x, &m_y, &m_velocityX, &m_velocityY, &m_left, &m_bottom, &m_right, &m_top })
+			{
+				array->clear();
+			}
+			for (auto words : { &m_visible, &m_counting, &m_sleeping, &m_occluded, &m_wake })
+			{
+				words->clear();
+			}
+			m_hiddenFrames.clear();
+			m_stepFrame.clear();
+		}
+
+		void SceneStore::Reserve(uint32_t count)
+		{
+			for (auto array : { &m_x, &m_y, &m_velocityX, &m_velocityY, &m_left, &m_bottom, &m_right, &m_top })
+			{
+				array->reserve(count);
+			}
+			for (auto words : { &m_visible, &m_counting, &m_sleeping, &m_occluded, &m_wake })
+			{
+				words->reserve((count + 63) / 64);
+			}
+			m_hiddenFrames.reserve(count);
+			m_stepFrame.reserve(count);
+		}
+
+		uint32_t SceneStore::Add(float left, float bottom, float right, float top, float velocityX, float velocityY)
+		{
+			m_x.push_back(0);
+			m_y.push_back(0);
+			m_velocityX.push_back(velocityX);
+			m_velocityY.push_back(velocityY);
+			m_left.push_back(left);
+			m_bottom.push_back(bottom);
+			m_right.push_back(right);
+			m_top.push_back(top);
+			m_hiddenFrames.push_back(0);
+			m_stepFrame.push_back(0);
+			if ((m_count & 63) == 0)
+			{
+				for (auto words : { &m_visible, &m_counting, &m_sleeping, &m_occluded, &m_wake })
+				{
+					words->push_back(0);
+				}
+			}
+			m_visible.back() |= 1ull << (m_count & 63);
+			return m_count++;
+		}
+
+		void SceneStore::SetOffset(uint32_t index, float x, float y)
+		{
+			m_x[index] = x;
+			m_y[index] = y;
+		}
+
+		void SceneStore::SetSchedule(const Schedule& schedule)
+		{
+			CatchUp();
+			m_schedule = schedule;
+			m_schedule.hiddenFrames = schedule.hiddenFrames < 255 ? schedule.hiddenFrames : 255;
+			m_schedule.refreshInterval = schedule.refreshInterval ? schedule.refreshInterval : 1;
+			for (auto words : { &m_counting, &m_sleeping, &m_wake })
+			{
+				fill(words->begin(), words->end(), 0);
+			}
+			fill(m_hiddenFrames.begin(), m_hiddenFrames.end(), static_cast<uint8_t>(0));
+		}
+
+		void SceneStore::SetOccluded(uint32_t index, bool occluded)
+		{
+			const uint32_t word = index >> 6;
+			const uint64_t bit = 1ull << (index & 63);
+			if (occluded)
+			{
+				m_occluded[word] |= bit;
+				return;
+			}
+			m_wake[word] |= m_occluded[word] & m_sleeping[word] & bit;
+			m_occluded[word] &= ~bit;
+		}
+
+		void SceneStore::Advance(uint32_t index, uint32_t frames)
+		{
+			m_x[index] = Drift(m_x[index], m_velocityX[index], m_wrapBounds, frames);
+			m_y[index] = Drift(m_y[index], m_velocityY[index], m_wrapBounds, frames);
+		}
+
+		bool SceneStore::IsHidden(uint32_t index, bool visible) const
+		{
+			if (m_occluded[index >> 6] >> (index & 63) & 1)
+			{
+				return true;
+			}
+			if (visible)
+			{
+				return false;
+			}
+
+			// Where the object can get to before its next refresh: anywhere up to reach along its
+			// velocity, or anywhere at all once that passes the wrap bounds.
+			const float frames = static_cast<float>(m_schedule.refreshInterval);
+			const float x = m_x[index], y = m_y[index];
+			const float reachX = frames * m_velocityX[index], reachY = frames * m_velocityY[index];
+			if (fabsf(x + reachX) > m_wrapBounds || fabsf(y + reachY) > m_wrapBounds)
+			{
+				return false;
+			}
+			const float marginX = fabsf(reachX), marginY = fabsf(reachY);
+			return !(Overlaps(m_left[index] + x - marginX, m_right[index] + x + marginX) &&
+				Overlaps(m_bottom[index] + y - marginY, m_top[index] + y + marginY));
+		}
+
+		uint64_t SceneStore::MoveWord(uint32_t begin, uint32_t end, uint64_t awake, uint8_t* destination, size_t stride)
+		{
+			const float bounds = m_wrapBounds;
+			uint64_t visible = 0;
+			uint32_t i = begin;
+#if QUERY_SCENE_STORE_SSE2
+			const __m128 upper = _mm_set1_ps(bounds), lower = _mm_set1_ps(-bounds);
+			const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), zero = _mm_setzero_ps();
+			const __m128i laneBits = _mm_set_epi32(8, 4, 2, 1);
+			// Skipping a sleeping object's store only saves anything when the store would take a cache
+			// line of its own; packed offsets are cheaper to rewrite unchanged than to branch around.
+			const bool ownLines = stride >= 64;
+			for (; i + 4 <= end; i += 4)
+			{
+				const uint32_t lanes = static_cast<uint32_t>(awake >> (i - begin)) & 15;
+				if (!lanes)
+				{
+					destination += 4 * stride;
+					continue;
+				}
+
+				__m128 x = Wrap(_mm_add_ps(_mm_loadu_ps(&m_x[i]), _mm_loadu_ps(&m_velocityX[i])), upper, lower);
+				__m128 y = Wrap(_mm_add_ps(_mm_loadu_ps(&m_y[i]), _mm_loadu_ps(&m_velocityY[i])), upper, lower);
+				if (lanes != 15)
+				{
+					// Sleeping objects keep the offsets they will catch up from.
+					const __m128 mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(lanes), laneBits), laneBits));
+					x = Select(mask, x, _mm_loadu_ps(&m_x[i]));
+					y = Select(mask, y, _mm_loadu_ps(&m_y[i]));
+				}
+				_mm_storeu_ps(&m_x[i], x);
+				_mm_storeu_ps(&m_y[i], y);
+
+				const __m128 overlapsX = _mm_and_ps(
+					_mm_cmplt_ps(_mm_add_ps(_mm_loadu_ps(&m_left[i]), x), one),
+					_mm_cmpgt_ps(_mm_add_ps(_mm_loadu_ps(&m_right[i]), x), minusOne));
+				const __m128 overlapsY = _mm_and_ps(
+					_mm_cmplt_ps(_mm_add_ps(_mm_loadu_ps(&m_bottom[i]), y), one),
+					_mm_cmpgt_ps(_mm_add_ps(_mm_loadu_ps(&m_top[i]), y), minusOne));
+				visible |= static_cast<uint64_t>(_mm_movemask_ps(_mm_and_ps(overlapsX, overlapsY)) & lanes) << (i - begin);
+
+				// (x0 y0 x1 y1) and (x2 y2 x3 y3), then one (x, y, 0, 0) per object
+				const __m128 low = _mm_unpacklo_ps(x, y), high = _mm_unpackhi_ps(x, y);
+				const __m128 offsets[] = { _mm_movelh_ps(low, zero), _mm_movehl_ps(zero, low), _mm_movelh_ps(high, zero), _mm_movehl_ps(zero, high) };
+				const uint32_t stores = ownLines ? lanes : 15;
+				for (uint32_t lane = 0; lane < 4; lane++)
+				{
+					if (stores >> lane & 1)
+					{
+						_mm_store_ps(reinterpret_cast<float*>(destination), offsets[lane]);
+					}
+					destination += stride;
+				}
+			}
+#endif
+			for (; i < end; i++, destination += stride)
+			{
+				if (!(awake >> (i - begin) & 1))
+				{
+					continue;
+				}
+				const float x = Wrap(m_x[i] + m_velocityX[i], bounds);
+				const float y = Wrap(m_y[i] + m_velocityY[i], bounds);
+				m_x[i] = x;
+				m_y[i] = y;
+
+				const bool overlaps = Overlaps(m_left[i] + x, m_right[i] + x) && Overlaps(m_bottom[i] + y, m_top[i] + y);
+				visible |= static_cast<uint64_t>(overlaps) << (i - begin);
+				Store(destination, x, y);
+			}
+			return visible;
+		}
+
+		uint64_t SceneStore::Refresh(uint32_t begin, uint8_t* destination, size_t stride)
+		{
+			const uint32_t word = begin >> 6;
+			const uint64_t sleeping = m_sleeping[word];
+			const bool refresh = (m_frame + word) % m_schedule.refreshInterval == 0;
+			const uint64_t due = sleeping & (refresh ? ~0ull : m_wake[word]);
+			uint64_t visible = 0, woken = 0;
+			for (uint64_t bits = due; bits; bits &= bits - 1)
+			{
+				const uint32_t bit = LowestBit(bits);
+				const uint32_t i = begin + bit;
+				Advance(i, m_frame - m_stepFrame[i]);
+				m_stepFrame[i] = m_frame;
+
+				const float x = m_x[i], y = m_y[i];
+				const bool overlaps = Overlaps(m_left[i] + x, m_right[i] + x) && Overlaps(m_bottom[i] + y, m_top[i] + y);
+				visible |= static_cast<uint64_t>(overlaps) << bit;
+				if (!IsHidden(i, overlaps))
+				{
+					woken |= 1ull << bit;
+				}
+				Store(destination + bit * stride, x, y);
+			}
+			m_sleeping[word] = sleeping & ~woken;
+			m_wake[word] &= ~due;
+			return visible;
+		}
+
+		void SceneStore::CountHidden(uint32_t begin, uint32_t end, uint64_t visible)
+		{
+			const uint32_t word = begin >> 6;
+			const uint64_t awake = (end - begin == 64 ? ~0ull : (1ull << (end - begin)) - 1) & ~m_sleeping[word];
+
+			// Only objects off screen or occluded can be hidden, so most visible words test nothing.
+			uint64_t hidden = 0;
+			for (uint64_t candidates = (~visible | m_occluded[word]) & awake; candidates; candidates &= candidates - 1)
+			{
+				const uint32_t bit = LowestBit(candidates);
+				if (IsHidden(begin + bit, (visible >> bit & 1) != 0))
+				{
+					hidden |= 1ull << bit;
+				}
+			}
+
+			for (uint64_t seen = m_counting[word] & awake & ~hidden; seen; seen &= seen - 1)
+			{
+				m_hiddenFrames[begin + LowestBit(seen)] = 0;
+			}
+			uint64_t sleeping = 0;
+			for (uint64_t bits = hidden; bits; bits &= bits - 1)
+			{
+				const uint32_t bit = LowestBit(bits);
+				const uint32_t i = begin + bit;
+				if (++m_hiddenFrames[i] >= m_schedule.hiddenFrames)
+				{
+					m_hiddenFrames[i] = 0;
+					m_stepFrame[i] = m_frame;
+					sleeping |= 1ull << bit;
+				}
+			}
+			m_counting[word] = hidden & ~sleeping;
+			m_sleeping[word] |= sleeping;
+		}
+
+		void SceneStore::UpdateRange(uint32_t begin, uint32_t end, const Output& output)
+		{
+			for (uint32_t base = begin; base < end; base += 64)
+			{
+				const uint32_t wordEnd = end - base > 64 ? base + 64 : end;
+				uint8_t* destination = output.destination + base * output.stride;
+				const uint32_t word = base >> 6;
+				if (!m_schedule.hiddenFrames)
+				{
+					m_visible[word] = MoveWord(base, wordEnd, ~0ull, destination, output.stride);
+					continue;
+				}
+
+				const uint64_t sleeping = m_sleeping[word];
+				uint64_t visible = ~sleeping ? MoveWord(base, wordEnd, ~sleeping, destination, output.stride) : 0;
+				if (sleeping)
+				{
+					visible |= Refresh(base, destination, output.stride);
+				}
+				m_visible[word] = visible;
+				CountHidden(base, wordEnd, visible);
+			}
+		}
+
+		void SceneStore::Update(const Output& output)
+		{
+			m_frame++;
+			UpdateRange(0, m_count, output);
+		}
+
+		void SceneStore::Update(const Output& output, Threading::ThreadPool& threadPool)
+		{
+			m_frame++;
+			const uint32_t blocks = (m_count + BlockSize - 1) / BlockSize;
+			threadPool.ParallelFor(blocks, [this, &output](uint32_t block)
+			{
+				const uint32_t begin = block * BlockSize;
+				const uint32_t end = m_count - begin > BlockSize ? begin + BlockSize : m_count;
+				UpdateRange(begin, end, output);
+			});
+		}
+
+		void SceneStore::CatchUp()
+		{
+			const uint32_t words = static_cast<uint32_t>(m_sleeping.size());
+			for (uint32_t word = 0; word < words; word++)
+			{
+				for (uint64_t bits = m_sleeping[word]; bits; bits &= bits - 1)
+				{
+					const uint32_t i = word * 64 + LowestBit(bits);
+					Advance(i, m_frame - m_stepFrame[i]);
+					m_stepFrame[i] = m_frame;
+				}
+			}
+		}
+
+		uint32_t SceneStore::CountVisible() const
+		{
+			return CountBits(m_visible);
+		}
+
+		uint32_t SceneStore::CountSleeping() const
+		{
+			return CountBits(m_sleeping);
+		}
+	}
+}
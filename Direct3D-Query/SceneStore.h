@@ -0,0 +1,105 @@
+#pragma once
+#include "ThreadPool.h"
+
+namespace Query {
+	namespace Rendering
+	{
+		// Animation state of many objects as structure of arrays, so that Update moves four objects
+		// per SSE instruction. Every object drifts with its own velocity; an offset that leaves
+		// [-wrapBounds, wrapBounds] restarts at the opposite bound, as the sample's near quad does.
+		// Update also tests each object's moved bounds against the screen ([-1, 1] on both axes)
+		// and keeps the result as one visibility bit per object.
+		//
+		// With a Schedule, objects that stay hidden fall asleep: they are only moved every
+		// refreshInterval frames, catching up on the frames they missed in one step, and wake as soon
+		// as they may be seen again. Catching up repeats the same float operations as moving every
+		// frame, so a sleeping object always ends up exactly where it would have been.
+		class SceneStore
+		{
+		public:
+			// Update writes every object's offset as the float4 (x, y, 0, 0) at the start of its
+			// stride, straight into mapped memory: constant buffer slots with a stride of
+			// sizeof(SceneConstantBuffer), or a packed instance buffer with a stride of 16.
+			struct Output
+			{
+				uint8_t* destination = nullptr;	//object 0's float4, 16-byte aligned
+				size_t stride = 0;	//a multiple of 16
+			};
+
+			// An object is hidden in a frame when it is occluded (SetOccluded) or when it cannot reach
+			// the screen within refreshInterval frames, neither by drifting nor by wrapping around.
+			// After hiddenFrames hidden frames in a row it falls asleep: Update does not move it, does
+			// not write its offset where that has a cache line of its own (a stride of 64 or more)
+			// and keeps its visibility bit clear, except every refreshInterval frames, when it
+			// catches up and is tested again. Sleeping objects are staggered by
+			// visibility word, so that the refreshes spread evenly over the frames.
+			struct Schedule
+			{
+				uint32_t hiddenFrames = 0;	//0 moves every object every frame
+				uint32_t refreshInterval = 8;	//at least 1
+			};
+
+			// Objects per ParallelFor index; a multiple of 64 so that no two indices share a visibility word.
+			static const uint32_t BlockSize = 16384;
+
+		private:
+			float m_wrapBounds = 1.5f;
+			uint32_t m_count = 0;
+			vector<float> m_x, m_y;
+			vector<float> m_velocityX, m_velocityY;
+			vector<float> m_left, m_bottom, m_right, m_top;	//bounds at offset zero
+			vector<uint64_t> m_visible;
+
+			Schedule m_schedule;
+			uint32_t m_frame = 0;	//Updates so far
+			vector<uint8_t> m_hiddenFrames;	//hidden frames in a row of the awake objects
+			vector<uint32_t> m_stepFrame;	//the frame a sleeping object has been moved up to
+			vector<uint64_t> m_counting;	//objects with a nonzero m_hiddenFrames
+			vector<uint64_t> m_sleeping;
+			vector<uint64_t> m_occluded;
+			vector<uint64_t> m_wake;	//sleeping objects no longer occluded, caught up by the next Update
+
+		private:
+			// begin is a multiple of 64.
+			void UpdateRange(uint32_t begin, uint32_t end, const Output& output);
+			// Moves the awake objects of one visibility word and returns their visibility bits.
+			uint64_t MoveWord(uint32_t begin, uint32_t end, uint64_t awake, uint8_t* destination, size_t stride);
+			// Catches up the sleeping objects of a word that are due, wakes those no longer hidden
+			// and returns the visibility bits of all that were caught up.
+			uint64_t Refresh(uint32_t begin, uint8_t* destination, size_t stride);
+			// Counts the hidden frames of the awake objects of a word and puts them to sleep.
+			void CountHidden(uint32_t begin, uint32_t end, uint64_t visible);
+			bool IsHidden(uint32_t index, bool visible) const;
+			void Advance(uint32_t index, uint32_t frames);
+
+		public:
+			void Reset(float wrapBounds = 1.5f);
+			void Reserve(uint32_t count);
+			// Returns the new object's index. Objects start at offset zero, visible and awake.
+			uint32_t Add(float left, float bottom, float right, float top, float velocityX, float velocityY);
+			void SetOffset(uint32_t index, float x, float y);
+
+			// Catches every sleeping object up first, so that changing the schedule moves nothing.
+			void SetSchedule(const Schedule& schedule);
+			// Occlusion results of the last frames, from queries the caller has read back. An object
+			// that is no longer occluded wakes in the next Update.
+			void SetOccluded(uint32_t index, bool occluded);
+
+			// Moves every object by its velocity and writes the offsets to output.
+			void Update(const Output& output);
+			// The same, in blocks of BlockSize objects on the pool and the calling thread.
+			void Update(const Output& output, Threading::ThreadPool& threadPool);
+			// Moves the sleeping objects to the current frame, without writing their offsets. They stay asleep.
+			void CatchUp();
+
+			uint32_t GetCount() const { return m_count; }
+			// A sleeping object's offset is that of its last refresh until CatchUp.
+			float GetOffsetX(uint32_t index) const { return m_x[index]; }
+			float GetOffsetY(uint32_t index) const { return m_y[index]; }
+			bool IsVisible(uint32_t index) const { return (m_visible[index >> 6] >> (index & 63) & 1) != 0; }
+			bool IsAsleep(uint32_t index) const { return (m_sleeping[index >> 6] >> (index & 63) & 1) != 0; }
+			uint32_t CountVisible() const;
+			uint32_t CountSleeping() const;
+		};
+	}
+}
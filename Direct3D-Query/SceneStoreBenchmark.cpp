@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "SceneStoreBenchmark.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		using Rendering::Scene;
+
+		UpdateResult RunUpdate(const UpdateOptions& options, uint32_t seed)
+		{
+			SceneDesc desc;
+			desc.occluders = options.objects;
+			desc.occludees = 0;
+			desc.animation = Rendering::Animation::Drift;
+			desc.seed = seed;
+			const Scene scene = GenerateScene(desc);
+
+			Rendering::SceneStore store;
+			Rendering::SceneRenderer::AddDrift(scene.occluders, store);
+			Rendering::SceneStore::Schedule schedule;
+			schedule.hiddenFrames = options.hiddenFrames;
+			schedule.refreshInterval = options.refreshInterval;
+			store.SetSchedule(schedule);
+			// Every hundredth object from the first on, up to the fraction asked for.
+			const uint32_t occludedPercent = static_cast<uint32_t>(options.occluded * 100 + 0.5f);
+			for (uint32_t i = 0; i < options.objects; i++)
+			{
+				store.SetOccluded(i, i % 100 < occludedPercent);
+			}
+			vector<float> offsets(static_cast<size_t>(options.objects) * options.stride / sizeof(float));
+			Rendering::SceneStore::Output output;
+			output.destination = reinterpret_cast<uint8_t*>(offsets.data());
+			output.stride = options.stride;
+
+			Threading::ThreadPool threadPool;
+			if (options.parallel)
+			{
+				threadPool.Initialize(options.threadCount);
+			}
+			auto update = [&]()
+			{
+				if (options.parallel)
+				{
+					store.Update(output, threadPool);
+				}
+				else
+				{
+					store.Update(output);
+				}
+			};
+
+			// One frame to touch the output pages first.
+			update();
+			auto start = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < options.frames; i++)
+			{
+				update();
+			}
+			const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+			UpdateResult result;
+			result.options = options;
+			result.threads = options.parallel ? threadPool.GetThreadCount() + 1 : 1;
+			const double updates = static_cast<double>(options.objects) * options.frames;
+			result.updatesPerSecond = seconds > 0 ? updates / seconds : 0;
+			result.nanosecondsPerObject = updates > 0 ? seconds * 1e9 / updates : 0;
+			result.visible = store.CountVisible();
+			result.sleeping = store.CountSleeping();
+			return result;
+		}
+
+		string ToJson(const vector<UpdateResult>& results)
+		{
+			string json = "{\n\t\"benchmark\": \"scene-update\",\n\t\"runs\": [";
+			char text[512];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const UpdateResult& result = results[i];
+				snprintf(text, sizeof(text),
+					"%s\n\t\t{ \"objects\": %u, \"frames\": %u, \"stride\": %u, \"parallel\": %s, \"threads\": %u, "
+					"\"hiddenFrames\": %u, \"refreshInterval\": %u, \"occluded\": %.2f, "
+					"\"updatesPerSecond\": %.0f, \"nsPerObject\": %.3f, \"visible\": %u, \"sleeping\": %u }",
+					i ? "," : "",
+					result.options.objects, result.options.frames, result.options.stride, result.options.parallel ? "true" : "false", result.threads,
+					result.options.hiddenFrames, result.options.refreshInterval, result.options.occluded,
+					result.updatesPerSecond, result.nanosecondsPerObject, result.visible, result.sleeping);
+				json += text;
+			}
+			json += "\n\t]\n}\n";
+			return json;
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "SceneGenerator.h"
+
+namespace Query {
+	namespace Benchmark
+	{
+		struct UpdateOptions
+		{
+			uint32_t objects = 1000000;
+			uint32_t frames = 100;
+			uint32_t stride = 16;	//bytes between the offsets written: 16 for an instance buffer, 256 for constant buffer slots
+			bool parallel = false;
+			uint32_t threadCount = 0;	//pool workers when parallel, 0 for one per hardware thread
+			uint32_t hiddenFrames = 0;	//SceneStore::Schedule, 0 moves every object every frame
+			uint32_t refreshInterval = 8;
+			float occluded = 0;	//fraction of the objects reported occluded
+		};
+
+		struct UpdateResult
+		{
+			UpdateOptions options;
+			uint32_t threads = 1;	//threads that ran the update, the calling one included
+			double updatesPerSecond = 0;	//objects moved, tested and written per second
+			double nanosecondsPerObject = 0;
+			uint32_t visible = 0;	//objects on screen after the last frame
+			uint32_t sleeping = 0;	//objects asleep after the last frame
+		};
+
+		// Drifts the occluders of a generated scene (see Rendering::SceneStore) without a backend.
+		UpdateResult RunUpdate(const UpdateOptions& options, uint32_t seed = 1);
+
+		string ToJson(const vector<UpdateResult>& results);
+	}
+}
@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "ShaderArchive.h"
+#include "Hash.h"
+
+namespace Query {
+	namespace Shaders
+	{
+		void ShaderArchive::Describe(
+			const wstring& sourcePath,
+			const void* source, size_t sourceSize,
+			const ShaderDefine* defines,
+			const char* entryPoint, const char* target,
+			uint32_t flags, Identity& identity)
+		{
+			vector<uint8_t>& bytes = identity.bytes;
+			bytes.clear();
+			auto add = [&bytes](const void* data, size_t size)
+			{
+				bytes.insert(bytes.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+			};
+			// Length first, so that no two lists of strings give the same bytes; ~0u for null.
+			auto addString = [&add](const char* text)
+			{
+				const uint32_t length = text ? static_cast<uint32_t>(strlen(text)) : ~0u;
+				add(&length, sizeof(length));
+				if (text) add(text, length);
+			};
+
+			const uint32_t pathLength = static_cast<uint32_t>(sourcePath.size());
+			add(&pathLength, sizeof(pathLength));
+			add(sourcePath.data(), sourcePath.size() * sizeof(wchar_t));
+			addString(entryPoint);
+			addString(target);
+			add(&flags, sizeof(flags));
+			for (const ShaderDefine* define = defines; define && define->name; define++)
+			{
+				addString(define->name);
+				addString(define->value);
+			}
+			identity.nameSize = static_cast<uint32_t>(bytes.size());
+
+			Hash::Hasher first, second(0x9E3779B97F4A7C15ull);
+			first.Add(source, sourceSize);
+			second.Add(source, sourceSize);
+			const uint64_t version[3] = { sourceSize, first.Get(), second.Get() };
+			add(version, sizeof(version));
+			identity.key = Hash::Compute(bytes.data(), bytes.size());
+		}
+
+		bool ShaderArchive::Open(const wstring& path, uint64_t salt)
+		{
+			Close();
+			if (!m_file.Open(path))
+			{
+				return false;
+			}
+
+			// Reject anything that would make a lookup read outside the mapping.
+			const size_t fileSize = m_file.GetSize();
+			if (fileSize < sizeof(Header))
+			{
+				Close();
+				return false;
+			}
+
+			const Header* header = reinterpret_cast<const Header*>(m_file.GetData());
+			const uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header->entryCount) * sizeof(Entry);
+			if (header->magic != Magic || header->version != Version || header->salt != salt || tableEnd > fileSize)
+			{
+				Close();
+				return false;
+			}
+
+			const Entry* entries = reinterpret_cast<const Entry*>(m_file.GetData() + sizeof(Header));
+			for (uint32_t i = 0; i < header->entryCount; i++)
+			{
+				const Entry& entry = entries[i];
+				if (entry.offset < tableEnd || entry.offset > fileSize || entry.size > fileSize - entry.offset ||
+					entry.identityOffset < tableEnd || entry.identityOffset > fileSize || entry.identitySize > fileSize - entry.identityOffset ||
+					entry.nameSize > entry.identitySize || (i > 0 && entries[i - 1].key > entry.key))
+				{
+					Close();
+					return false;
+				}
+			}
+
+			m_entries = entries;
+			m_entryCount = header->entryCount;
+			return true;
+		}
+
+		void ShaderArchive::Close()
+		{
+			m_file.Close();
+			m_entries = nullptr;
+			m_entryCount = 0;
+		}
+
+		bool ShaderArchive::Find(const Identity& identity, const void*& data, size_t& size) const
+		{
+			const Entry* end = m_entries + m_entryCount;
+			const Entry* entry = lower_bound(m_entries, end, identity.key, [](const Entry& e, uint64_t k) { return e.key < k; });
+			for (; entry != end && entry->key == identity.key; entry++)
+			{
+				if (entry->identitySize == identity.bytes.size() && memcmp(GetIdentity(*entry), identity.bytes.data(), entry->identitySize) == 0)
+				{
+					data = GetData(*entry);
+					size = static_cast<size_t>(entry->size);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void ShaderArchive::MergeInto(vector<Blob>& blobs) const
+		{
+			const size_t newCount = blobs.size();
+			for (uint32_t i = 0; i < m_entryCount; i++)
+			{
+				const Entry& entry = m_entries[i];
+				const void* identity = GetIdentity(entry);
+				auto sameName = [&](const Blob& blob)
+				{
+					return blob.nameSize == entry.nameSize && memcmp(blob.identity, identity, entry.nameSize) == 0;
+				};
+				if (none_of(blobs.begin(), blobs.begin() + newCount, sameName))
+				{
+					blobs.push_back({ entry.key, identity, entry.identitySize, entry.nameSize, GetData(entry), static_cast<size_t>(entry.size) });
+				}
+			}
+		}
+
+		void ShaderArchive::Serialize(vector<Blob> blobs, uint64_t salt, vector<uint8_t>& output)
+		{
+			// Colliding keys are ordered by identity, so that the same blobs always give the same file.
+			auto compare = [](const Blob& a, const Blob& b)
+			{
+				if (a.key != b.key) return a.key < b.key ? -1 : 1;
+				if (a.identitySize != b.identitySize) return a.identitySize < b.identitySize ? -1 : 1;
+				return memcmp(a.identity, b.identity, a.identitySize);
+			};
+			stable_sort(blobs.begin(), blobs.end(), [&compare](const Blob& a, const Blob& b) { return compare(a, b) < 0; });
+			blobs.erase(unique(blobs.begin(), blobs.end(), [&compare](const Blob& a, const Blob& b) { return compare(a, b) == 0; }), blobs.end());
+
+			Header header = { Magic, Version, static_cast<uint32_t>(blobs.size()), 0, salt };
+			vector<Entry> entries(blobs.size());
+
+			uint64_t offset = sizeof(Header) + entries.size() * sizeof(Entry);
+			for (size_t i = 0; i < blobs.size(); i++)
+			{
+				const uint64_t identityOffset = offset;
+				offset = (offset + blobs[i].identitySize + BlobAlignment - 1) / BlobAlignment * BlobAlignment;
+				entries[i] = { blobs[i].key, offset, blobs[i].size, identityOffset, blobs[i].identitySize, blobs[i].nameSize };
+				offset += blobs[i].size;
+			}
+
+			output.assign(static_cast<size_t>(offset), 0);
+			memcpy(output.data(), &header, sizeof(header));
+			if (!entries.empty())
+			{
+				memcpy(output.data() + sizeof(Header), entries.data(), entries.size() * sizeof(Entry));
+			}
+			for (size_t i = 0; i < blobs.size(); i++)
+			{
+				memcpy(output.data() + entries[i].identityOffset, blobs[i].identity, blobs[i].identitySize);
+				memcpy(output.data() + entries[i].offset, blobs[i].data, blobs[i].size);
+			}
+		}
+	}
+}
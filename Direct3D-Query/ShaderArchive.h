@@ -0,0 +1,100 @@
+#pragma once
+#include "MappedFile.h"
+
+namespace Query {
+	namespace Shaders
+	{
+		// Same layout as D3D_SHADER_MACRO; a list ends with a null name.
+		struct ShaderDefine
+		{
+			const char* name;
+			const char* value;
+		};
+
+		// Compiled shader blobs keyed by a content hash, stored in a file that is used straight from
+		// a memory mapping: a fixed header, an entry table sorted by key, then the identities and
+		// blobs. Opening the archive only validates the header and table bounds; lookups are a binary
+		// search followed by a comparison of the identities, so a key collision can only cost a miss.
+		class ShaderArchive
+		{
+		public:
+			static const uint32_t Magic = 0x41485351;	//"QSHA"
+			static const uint32_t Version = 2;
+			static const uint32_t BlobAlignment = 16;
+
+			struct Header
+			{
+				uint32_t magic;
+				uint32_t version;
+				uint32_t entryCount;
+				uint32_t reserved;
+				// The compiler the blobs were built with. An archive of another compiler does not open,
+				// so the next save starts it over instead of keeping blobs nothing can look up.
+				uint64_t salt;
+			};
+
+			struct Entry
+			{
+				uint64_t key;
+				uint64_t offset;	//from the start of the file
+				uint64_t size;
+				uint64_t identityOffset;
+				uint32_t identitySize;
+				uint32_t nameSize;	//leading bytes of the identity that name the shader, see Identity
+			};
+
+			// Everything a blob was compiled from. The leading nameSize bytes say which shader it is:
+			// source path, entry point, target, flags and defines. The rest says which version of the
+			// source: its size and a 128-bit hash. A new version of a shader replaces the archived
+			// blobs of the same name when the archive is saved, so edits do not pile up.
+			struct Identity
+			{
+				vector<uint8_t> bytes;
+				uint32_t nameSize = 0;
+				uint64_t key = 0;	//hash of the bytes
+			};
+
+			struct Blob
+			{
+				uint64_t key;
+				const void* identity;
+				uint32_t identitySize;
+				uint32_t nameSize;
+				const void* data;
+				size_t size;
+			};
+
+		private:
+			IO::MappedFile m_file;
+			const Entry* m_entries = nullptr;
+			uint32_t m_entryCount = 0;
+
+		public:
+			static void Describe(
+				const wstring& sourcePath,
+				const void* source, size_t sourceSize,
+				const ShaderDefine* defines,
+				const char* entryPoint, const char* target,
+				uint32_t flags, Identity& identity);
+
+			// Fails, leaving the archive empty, unless the file is an archive of this version built
+			// with the same salt.
+			bool Open(const wstring& path, uint64_t salt);
+			void Close();
+
+			bool Find(const Identity& identity, const void*& data, size_t& size) const;
+
+			uint32_t GetEntryCount() const { return m_entryCount; }
+			const Entry* GetEntries() const { return m_entries; }
+			const void* GetData(const Entry& entry) const { return m_file.GetData() + entry.offset; }
+			const void* GetIdentity(const Entry& entry) const { return m_file.GetData() + entry.identityOffset; }
+
+			// Appends the archived blobs to blobs, except those of shaders that blobs already holds a
+			// version of. The appended blobs point into the mapping.
+			void MergeInto(vector<Blob>& blobs) const;
+
+			// Serializes the blobs into the archive format. Blobs of the same identity keep the first.
+			static void Serialize(vector<Blob> blobs, uint64_t salt, vector<uint8_t>& output);
+		};
+	}
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "ShaderCache.h"
+
+namespace Query {
+	namespace Shaders
+	{
+		const ShaderCache::Compiled* ShaderCache::FindCompiled(const ShaderArchive::Identity& identity) const
+		{
+			auto range = m_compiled.equal_range(identity.key);
+			for (auto i = range.first; i != range.second; ++i)
+			{
+				if (i->second.identity.bytes == identity.bytes)
+				{
+					return &i->second;
+				}
+			}
+			return nullptr;
+		}
+
+		void ShaderCache::Open(const wstring& archivePath)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_archivePath = archivePath;
+			m_archive.Open(archivePath, D3D_COMPILER_VERSION);
+		}
+
+		HRESULT ShaderCache::GetShader(
+			const wstring& sourcePath,
+			const D3D_SHADER_MACRO* pDefines,
+			const char* entryPoint, const char* target, UINT flags,
+			D3D12_SHADER_BYTECODE* pBytecode,
+			uint64_t* pKey)
+		{
+			// Reading and hashing the source is far cheaper than compiling it. Includes are not
+			// followed, so shaders using #include must not rely on this cache.
+			vector<uint8_t> source;
+			if (!IO::MappedFile::ReadAll(sourcePath, source))
+			{
+				return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+			}
+
+			ShaderArchive::Identity identity;
+			ShaderArchive::Describe(
+				sourcePath, source.data(), source.size(),
+				reinterpret_cast<const ShaderDefine*>(pDefines),
+				entryPoint, target, flags, identity);
+			if (pKey) *pKey = identity.key;
+
+			{
+				lock_guard<mutex> lock(m_mutex);
+
+				const void* data;
+				size_t size;
+				if (m_archive.Find(identity, data, size))
+				{
+					m_hitCount++;
+					*pBytecode = { data, size };
+					return S_OK;
+				}
+
+				if (const Compiled* compiled = FindCompiled(identity))
+				{
+					m_hitCount++;
+					*pBytecode = CD3DX12_SHADER_BYTECODE(compiled->bytecode.Get());
+					return S_OK;
+				}
+			}
+
+			// Compile outside the lock so that several shaders can be compiled in parallel.
+			ComPtr<ID3DBlob> bytecode;
+			ComPtr<ID3DBlob> errors;
+			HRESULT hr = D3DCompile(
+				source.data(), source.size(), nullptr,
+				pDefines, nullptr, entryPoint, target, flags, 0,
+				&bytecode, &errors);
+			if (FAILED(hr))
+			{
+				if (errors) OutputDebugStringA(static_cast<const char*>(errors->GetBufferPointer()));
+				return hr;
+			}
+
+			lock_guard<mutex> lock(m_mutex);
+			m_missCount++;
+			// Another thread may have compiled the same shader meanwhile; the first result is kept.
+			const Compiled* compiled = FindCompiled(identity);
+			if (!compiled)
+			{
+				const uint64_t key = identity.key;
+				compiled = &m_compiled.emplace(key, Compiled{ move(identity), bytecode })->second;
+			}
+			*pBytecode = CD3DX12_SHADER_BYTECODE(compiled->bytecode.Get());
+			return S_OK;
+		}
+
+		HRESULT ShaderCache::Save()
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (m_compiled.empty() || m_archivePath.empty())
+			{
+				return S_FALSE;
+			}
+
+			// New blobs first, then the archived ones that no new blob is a newer version of.
+			vector<ShaderArchive::Blob> blobs;
+			for (auto& compiled : m_compiled)
+			{
+				const ShaderArchive::Identity& identity = compiled.second.identity;
+				blobs.push_back({ identity.key, identity.bytes.data(), static_cast<uint32_t>(identity.bytes.size()), identity.nameSize,
+					compiled.second.bytecode->GetBufferPointer(), compiled.second.bytecode->GetBufferSize() });
+			}
+			m_archive.MergeInto(blobs);
+
+			vector<uint8_t> contents;
+			ShaderArchive::Serialize(blobs, D3D_COMPILER_VERSION, contents);
+
+			// The mapping has to go before the file can be replaced.
+			m_archive.Close();
+			if (!IO::MappedFile::WriteAtomically(m_archivePath, contents.data(), contents.size()))
+			{
+				m_archive.Open(m_archivePath, D3D_COMPILER_VERSION);
+				return E_FAIL;
+			}
+			m_compiled.clear();
+			m_archive.Open(m_archivePath, D3D_COMPILER_VERSION);
+			return S_OK;
+		}
+	}
+}
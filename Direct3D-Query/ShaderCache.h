@@ -0,0 +1,50 @@
+#pragma once
+#include "ShaderArchive.h"
+
+namespace Query {
+	namespace Shaders
+	{
+		using Microsoft::WRL::ComPtr;
+
+		// Compiled bytecode looked up by source path, source contents, defines, entry point, target and
+		// flags. Hits point straight into the mapped archive; only misses run D3DCompile, and their
+		// results are added to the archive by Save, replacing the blobs of older versions of the same
+		// shader. The archive is tied to the compiler version and starts over when it changes.
+		class ShaderCache
+		{
+		private:
+			struct Compiled
+			{
+				ShaderArchive::Identity identity;
+				ComPtr<ID3DBlob> bytecode;
+			};
+
+			ShaderArchive m_archive;
+			wstring m_archivePath;
+			unordered_multimap<uint64_t, Compiled> m_compiled;
+			mutable mutex m_mutex;
+			UINT m_hitCount = 0, m_missCount = 0;
+
+		private:
+			// Of this run, not yet saved; the caller holds the lock.
+			const Compiled* FindCompiled(const ShaderArchive::Identity& identity) const;
+
+		public:
+			void Open(const wstring& archivePath);
+
+			// The returned bytecode stays valid until the cache is saved or destroyed.
+			HRESULT GetShader(
+				const wstring& sourcePath,
+				const D3D_SHADER_MACRO* pDefines,
+				const char* entryPoint, const char* target, UINT flags,
+				D3D12_SHADER_BYTECODE* pBytecode,
+				uint64_t* pKey = nullptr);
+
+			// Rewrites the archive if anything had to be compiled. Invalidates returned bytecode.
+			HRESULT Save();
+
+			UINT GetHitCount() const { return m_hitCount; }
+			UINT GetMissCount() const { return m_missCount; }
+		};
+	}
+}
@@ -0,0 +1,831 @@
+#include "pch.h"
+#include "SoftwareBackend.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define QUERY_SOFTWARE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Query {
+	namespace Backend
+	{
+		namespace Software
+		{
+			namespace
+			{
+				// VSMain output in screen space.
+				struct ShadedVertex
+				{
+					float x, y, z, inverseW;
+					float color[4];
+				};
+
+				// Matches the input layout: POSITION float3 at 0, COLOR float4 at 12.
+				const uint32_t PositionOffset = 0;
+				const uint32_t ColorOffset = 12;
+
+				// D3D12 rasterizes with 8 bits of subpixel precision.
+				float Snap(float value)
+				{
+					return floorf(value * 256.0f + 0.5f) / 256.0f;
+				}
+
+				float Min3(float a, float b, float c)
+				{
+					float ab = a < b ? a : b;
+					return ab < c ? ab : c;
+				}
+
+				float Max3(float a, float b, float c)
+				{
+					float ab = a > b ? a : b;
+					return ab > c ? ab : c;
+				}
+
+
+				// Fills the edge functions and attribute planes of triangle from three vertices with
+				// positive area, i.e. clockwise on screen.
+				void SetupPlanes(Queue::Triangle& triangle, const ShadedVertex* v[3], float area)
+				{
+					for (uint32_t i = 0; i < 3; i++)
+					{
+						const ShadedVertex& a = *v[(i + 1) % 3];
+						const ShadedVertex& b = *v[(i + 2) % 3];
+						triangle.edgeA[i] = a.y - b.y;
+						triangle.edgeB[i] = b.x - a.x;
+						triangle.edgeC[i] = -(triangle.edgeA[i] * a.x + triangle.edgeB[i] * a.y);
+						// Top edges run left to right, left edges run up.
+						triangle.topLeft[i] = b.y < a.y || (b.y == a.y && b.x > a.x);
+					}
+
+					// An attribute f interpolates as sum(f[i] * edge[i](p)) / area, a plane in x and y.
+					const float inverseArea = 1.0f / area;
+					auto plane = [&](float plane[3], float f0, float f1, float f2)
+					{
+						plane[0] = (f0 * triangle.edgeA[0] + f1 * triangle.edgeA[1] + f2 * triangle.edgeA[2]) * inverseArea;
+						plane[1] = (f0 * triangle.edgeB[0] + f1 * triangle.edgeB[1] + f2 * triangle.edgeB[2]) * inverseArea;
+						plane[2] = (f0 * triangle.edgeC[0] + f1 * triangle.edgeC[1] + f2 * triangle.edgeC[2]) * inverseArea;
+					};
+					plane(triangle.depth, v[0]->z, v[1]->z, v[2]->z);
+					plane(triangle.inverseW, v[0]->inverseW, v[1]->inverseW, v[2]->inverseW);
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						plane(triangle.color[c],
+							v[0]->color[c] * v[0]->inverseW,
+							v[1]->color[c] * v[1]->inverseW,
+							v[2]->color[c] * v[2]->inverseW);
+					}
+				}
+
+#if QUERY_SOFTWARE_SSE2
+				// x0 is a multiple of 4 and the pitch covers whole quads, like for the triangles.
+				void Fill(uint32_t* rows, uint32_t pitch, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t value)
+				{
+					const __m128i quad = _mm_set1_epi32(static_cast<int>(value));
+					for (int32_t y = y0; y <= y1; y++)
+					{
+						uint32_t* row = rows + static_cast<size_t>(y) * pitch;
+						for (int32_t x = x0; x <= x1; x += 4)
+						{
+							_mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), quad);
+						}
+					}
+				}
+
+				const int PopCount4[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+				__m128 Saturate(__m128 value)
+				{
+					return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+				}
+
+				__m128 Select(__m128 mask, __m128 a, __m128 b)
+				{
+					return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+				}
+
+				// Shifts are template arguments because the SSE2 shift intrinsics take immediates.
+				template<int Shift>
+				__m128 Channel(__m128i texels)
+				{
+					__m128i channel = _mm_and_si128(_mm_srli_epi32(texels, Shift), _mm_set1_epi32(0xFF));
+					return _mm_mul_ps(_mm_cvtepi32_ps(channel), _mm_set1_ps(1.0f / 255.0f));
+				}
+
+				template<int Shift>
+				__m128i Unorm8(__m128 value)
+				{
+					__m128i channel = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate(value), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+					return _mm_slli_epi32(channel, Shift);
+				}
+
+				// A plane's x slope and its value at the row's pixel centers, so a quad costs one
+				// multiply-add. Held in registers: the target stores could alias the triangle.
+				struct PlaneRow
+				{
+					__m128 a, b, c, row;
+
+					explicit PlaneRow(const float plane[3]) :
+						a(_mm_set1_ps(plane[0])), b(_mm_set1_ps(plane[1])), c(_mm_set1_ps(plane[2])), row(c) {}
+					void SetRow(__m128 py) { row = _mm_add_ps(_mm_mul_ps(b, py), c); }
+					__m128 At(__m128 px) const { return _mm_add_ps(_mm_mul_ps(a, px), row); }
+				};
+
+				// Covers pixels [x0, x1] x [y0, y1] of one tile four at a time; quads start at multiples
+				// of 4 and the targets' pitch keeps the last quad of a row in bounds. The rectangle is
+				// first classified in 8x8 blocks, so blocks outside the triangle are skipped and blocks
+				// inside it skip the per-pixel edge tests.
+				uint64_t RasterizeTriangle(const Queue::Triangle& t, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+				{
+					const int32_t BlockSize = 8;
+					const int32_t MaxBlocks = Queue::TileSize / BlockSize;
+					enum class Coverage : uint8_t { Outside, Partial, Inside };
+
+					const __m128 zero = _mm_setzero_ps();
+					const __m128 one = _mm_set1_ps(1.0f);
+					const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+					const __m128i laneIndices = _mm_setr_epi32(0, 1, 2, 3);
+					const __m128i first = _mm_set1_epi32(x0 - 1);
+					const __m128i last = _mm_set1_epi32(x1 + 1);
+
+					// A pixel exactly on an edge is covered only when the edge is a top or left edge.
+					const float edgePlanes[3][3] =
+					{
+						{ t.edgeA[0], t.edgeB[0], t.edgeC[0] },
+						{ t.edgeA[1], t.edgeB[1], t.edgeC[1] },
+						{ t.edgeA[2], t.edgeB[2], t.edgeC[2] },
+					};
+					PlaneRow edges[3] = { PlaneRow(edgePlanes[0]), PlaneRow(edgePlanes[1]), PlaneRow(edgePlanes[2]) };
+					__m128 excludeOnEdge[3];
+					for (uint32_t i = 0; i < 3; i++)
+					{
+						excludeOnEdge[i] = t.topLeft[i] ? zero : _mm_cmpeq_ps(zero, zero);
+					}
+					PlaneRow depthPlane(t.depth), inverseW(t.inverseW);
+					PlaneRow colors[4] = { PlaneRow(t.color[0]), PlaneRow(t.color[1]), PlaneRow(t.color[2]), PlaneRow(t.color[3]) };
+
+					uint32_t* texels = t.state.colorWrite && t.renderTarget ? t.renderTarget->GetTexels() : nullptr;
+					float* depths = t.depthStencil ? t.depthStencil->GetDepths() : nullptr;
+					const uint32_t colorPitch = t.renderTarget ? t.renderTarget->GetPitch() : 0;
+					const uint32_t depthPitch = t.depthStencil ? t.depthStencil->GetPitch() : 0;
+					const bool depthTest = t.state.depthEnable && depths;
+					const bool depthWrite = depthTest && t.state.depthWrite;
+					const bool blend = t.state.blendEnable;
+
+					uint64_t passed = 0;
+					const int32_t blockX0 = x0 & ~(BlockSize - 1);
+					const int32_t blockCount = (x1 - blockX0) / BlockSize + 1;
+					for (int32_t blockY = y0 & ~(BlockSize - 1); blockY <= y1; blockY += BlockSize)
+					{
+						// An edge's extremes over a block's pixel centers are at the corners picked by the
+						// signs of its slopes. Pixels within 1/64 of an edge are left to the exact test.
+						Coverage coverage[MaxBlocks];
+						bool any = false;
+						for (int32_t block = 0; block < blockCount; block++)
+						{
+							const float cornerX = blockX0 + block * BlockSize + 0.5f;
+							const float cornerY = blockY + 0.5f;
+							coverage[block] = Coverage::Inside;
+							for (uint32_t i = 0; i < 3 && coverage[block] != Coverage::Outside; i++)
+							{
+								const float a = t.edgeA[i], b = t.edgeB[i];
+								const float origin = a * cornerX + b * cornerY + t.edgeC[i];
+								const float low = origin + (a < 0 ? a : 0.0f) * (BlockSize - 1) + (b < 0 ? b : 0.0f) * (BlockSize - 1);
+								const float high = origin + (a > 0 ? a : 0.0f) * (BlockSize - 1) + (b > 0 ? b : 0.0f) * (BlockSize - 1);
+								const float margin = ((a < 0 ? -a : a) + (b < 0 ? -b : b)) * (1.0f / 64.0f);
+								if (high < -margin)
+								{
+									coverage[block] = Coverage::Outside;
+								}
+								else if (low <= margin)
+								{
+									coverage[block] = Coverage::Partial;
+								}
+							}
+							any |= coverage[block] != Coverage::Outside;
+						}
+						if (!any)
+						{
+							continue;
+						}
+
+						const int32_t rowEnd = blockY + BlockSize - 1 < y1 ? blockY + BlockSize - 1 : y1;
+						for (int32_t y = blockY > y0 ? blockY : y0; y <= rowEnd; y++)
+						{
+							const __m128 py = _mm_set1_ps(y + 0.5f);
+							for (auto& edge : edges)
+							{
+								edge.SetRow(py);
+							}
+							depthPlane.SetRow(py);
+							inverseW.SetRow(py);
+							for (auto& color : colors)
+							{
+								color.SetRow(py);
+							}
+							float* depthRow = depths ? depths + static_cast<size_t>(y) * depthPitch : nullptr;
+							uint32_t* colorRow = texels ? texels + static_cast<size_t>(y) * colorPitch : nullptr;
+
+							for (int32_t block = 0; block < blockCount; block++)
+							{
+								if (coverage[block] == Coverage::Outside)
+								{
+									continue;
+								}
+								const int32_t blockX = blockX0 + block * BlockSize;
+								for (int32_t x = blockX; x < blockX + BlockSize && x <= x1; x += 4)
+								{
+									const __m128i indices = _mm_add_epi32(_mm_set1_epi32(x), laneIndices);
+									__m128 mask = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(indices, first), _mm_cmplt_epi32(indices, last)));
+									const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+									if (coverage[block] == Coverage::Partial)
+									{
+										for (uint32_t i = 0; i < 3; i++)
+										{
+											const __m128 edge = edges[i].At(px);
+											mask = _mm_and_ps(mask, _mm_andnot_ps(_mm_and_ps(_mm_cmpeq_ps(edge, zero), excludeOnEdge[i]), _mm_cmpge_ps(edge, zero)));
+										}
+									}
+									if (_mm_movemask_ps(mask) == 0)
+									{
+										continue;
+									}
+
+									// Depth clip, then the LESS test.
+									const __m128 z = depthPlane.At(px);
+									mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(z, zero), _mm_cmple_ps(z, one)));
+									__m128 depth = zero;
+									if (depthTest)
+									{
+										depth = _mm_loadu_ps(depthRow + x);
+										mask = _mm_and_ps(mask, _mm_cmplt_ps(z, depth));
+									}
+									const int bits = _mm_movemask_ps(mask);
+									if (bits == 0)
+									{
+										continue;
+									}
+									passed += PopCount4[bits];
+
+									if (depthWrite)
+									{
+										_mm_storeu_ps(depthRow + x, Select(mask, z, depth));
+									}
+
+									if (colorRow)
+									{
+										// PSMain returns the interpolated color.
+										const __m128 w = _mm_div_ps(one, inverseW.At(px));
+										__m128 r = _mm_mul_ps(colors[0].At(px), w);
+										__m128 g = _mm_mul_ps(colors[1].At(px), w);
+										__m128 b = _mm_mul_ps(colors[2].At(px), w);
+										__m128 a = _mm_mul_ps(colors[3].At(px), w);
+
+										__m128i* quad = reinterpret_cast<__m128i*>(colorRow + x);
+										const __m128i destination = _mm_loadu_si128(quad);
+										if (blend)
+										{
+											const __m128 sourceAlpha = Saturate(a);
+											const __m128 inverseAlpha = _mm_sub_ps(one, sourceAlpha);
+											r = _mm_add_ps(_mm_mul_ps(r, sourceAlpha), _mm_mul_ps(Channel<0>(destination), inverseAlpha));
+											g = _mm_add_ps(_mm_mul_ps(g, sourceAlpha), _mm_mul_ps(Channel<8>(destination), inverseAlpha));
+											b = _mm_add_ps(_mm_mul_ps(b, sourceAlpha), _mm_mul_ps(Channel<16>(destination), inverseAlpha));
+										}
+										const __m128i color = _mm_or_si128(_mm_or_si128(Unorm8<0>(r), Unorm8<8>(g)), _mm_or_si128(Unorm8<16>(b), Unorm8<24>(a)));
+										const __m128i write = _mm_castps_si128(mask);
+										_mm_storeu_si128(quad, _mm_or_si128(_mm_and_si128(write, color), _mm_andnot_si128(write, destination)));
+									}
+								}
+							}
+						}
+					}
+					return passed;
+				}
+#else
+				void Fill(uint32_t* rows, uint32_t pitch, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t value)
+				{
+					for (int32_t y = y0; y <= y1; y++)
+					{
+						uint32_t* row = rows + static_cast<size_t>(y) * pitch;
+						for (int32_t x = x0; x <= x1; x++)
+						{
+							row[x] = value;
+						}
+					}
+				}
+
+				float Clamp01(float value)
+				{
+					return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+				}
+
+				float Plane(const float plane[3], float px, float py)
+				{
+					return plane[0] * px + plane[1] * py + plane[2];
+				}
+
+				uint32_t Unorm8(float value, int shift)
+				{
+					return static_cast<uint32_t>(Clamp01(value) * 255.0f + 0.5f) << shift;
+				}
+
+				float Channel(uint32_t texel, int shift)
+				{
+					return ((texel >> shift) & 0xFF) * (1.0f / 255.0f);
+				}
+
+				uint64_t RasterizeTriangle(const Queue::Triangle& t, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+				{
+					uint32_t* texels = t.state.colorWrite && t.renderTarget ? t.renderTarget->GetTexels() : nullptr;
+					float* depths = t.depthStencil ? t.depthStencil->GetDepths() : nullptr;
+					const bool depthTest = t.state.depthEnable && depths;
+					const bool depthWrite = depthTest && t.state.depthWrite;
+
+					uint64_t passed = 0;
+					for (int32_t y = y0; y <= y1; y++)
+					{
+						const float py = y + 0.5f;
+						for (int32_t x = x0; x <= x1; x++)
+						{
+							const float px = x + 0.5f;
+							bool inside = true;
+							for (uint32_t i = 0; i < 3 && inside; i++)
+							{
+								const float edge = t.edgeA[i] * px + t.edgeB[i] * py + t.edgeC[i];
+								inside = t.topLeft[i] ? edge >= 0.0f : edge > 0.0f;
+							}
+							if (!inside)
+							{
+								continue;
+							}
+
+							const float z = Plane(t.depth, px, py);
+							if (z < 0.0f || z > 1.0f)
+							{
+								continue;
+							}
+							float* depth = depths ? depths + static_cast<size_t>(y) * t.depthStencil->GetPitch() + x : nullptr;
+							if (depthTest && !(z < *depth))
+							{
+								continue;
+							}
+							passed++;
+
+							if (depthWrite)
+							{
+								*depth = z;
+							}
+
+							if (texels)
+							{
+								const float w = 1.0f / Plane(t.inverseW, px, py);
+								float r = Plane(t.color[0], px, py) * w;
+								float g = Plane(t.color[1], px, py) * w;
+								float b = Plane(t.color[2], px, py) * w;
+								float a = Plane(t.color[3], px, py) * w;
+
+								uint32_t& texel = texels[static_cast<size_t>(y) * t.renderTarget->GetPitch() + x];
+								if (t.state.blendEnable)
+								{
+									const float sourceAlpha = Clamp01(a);
+									r = r * sourceAlpha + Channel(texel, 0) * (1.0f - sourceAlpha);
+									g = g * sourceAlpha + Channel(texel, 8) * (1.0f - sourceAlpha);
+									b = b * sourceAlpha + Channel(texel, 16) * (1.0f - sourceAlpha);
+								}
+								texel = Unorm8(r, 0) | Unorm8(g, 8) | Unorm8(b, 16) | Unorm8(a, 24);
+							}
+						}
+					}
+					return passed;
+				}
+#endif
+			}
+
+			Resource::Resource(const ResourceDesc& desc) : m_desc(desc)
+			{
+				if (desc.kind == ResourceKind::Buffer)
+				{
+					m_memory.resize(static_cast<size_t>(desc.size));
+				}
+				else
+				{
+					m_pitch = (desc.width + 3) & ~3u;
+					m_memory.resize(static_cast<size_t>(m_pitch) * desc.height * sizeof(uint32_t));
+				}
+			}
+
+			QueryHeap::QueryHeap(QueryType type, uint32_t count) :
+				m_type(type), m_count(count), m_samples(new atomic<uint64_t>[count])
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					m_samples[i] = 0;
+				}
+			}
+
+			void Queue::Submit(ICommandList* commandList)
+			{
+				typedef Null::CommandList::Op Op;
+				const auto& commands = static_cast<Null::CommandList*>(commandList)->GetCommands();
+				m_stats.submits++;
+				m_stats.commands += commands.size();
+
+				Resource* renderTarget = nullptr;
+				Resource* depthStencil = nullptr;
+				uint32_t viewportWidth = 0, viewportHeight = 0;
+				const Pipeline* pipeline = nullptr;
+				Resource* vertexBuffer = nullptr;
+				uint32_t vertexStride = 0, vertexBufferSize = 0;
+				Resource* constantBuffer = nullptr;
+				uint64_t constantBufferOffset = 0;
+				const uint64_t* predicate = nullptr;
+				atomic<uint64_t>* activeQuery = nullptr;
+				vector<ShadedVertex> vertices;
+
+				for (const auto& command : commands)
+				{
+					switch (command.op)
+					{
+					case Op::ClearRenderTarget:
+					case Op::ClearDepth:
+						BinClear(static_cast<Resource*>(command.first), command.a);
+						break;
+
+					case Op::SetRenderTargets:
+						renderTarget = static_cast<Resource*>(command.first);
+						depthStencil = static_cast<Resource*>(command.second);
+						break;
+
+					case Op::SetViewport:
+						viewportWidth = command.a;
+						viewportHeight = command.b;
+						break;
+
+					case Op::SetPipeline:
+						pipeline = static_cast<const Pipeline*>(command.first);
+						break;
+
+					case Op::SetVertexBuffer:
+						vertexBuffer = static_cast<Resource*>(command.first);
+						vertexStride = command.a;
+						vertexBufferSize = command.b;
+						break;
+
+					case Op::SetConstantBuffer:
+						// Slot 0 is the only root parameter, the SceneConstantBuffer.
+						if (command.a == 0)
+						{
+							constantBuffer = static_cast<Resource*>(command.first);
+							constantBufferOffset = command.offset;
+						}
+						break;
+
+					case Op::Draw:
+					{
+						if (predicate && *predicate == 0)
+						{
+							m_stats.predicatedDraws++;
+							break;
+						}
+						m_stats.draws++;
+						const uint32_t vertexCount = command.a, firstVertex = command.b;
+						if (!pipeline || !vertexBuffer || vertexCount < 3 ||
+							(static_cast<uint64_t>(firstVertex) + vertexCount) * vertexStride > vertexBufferSize)
+						{
+							break;
+						}
+
+						// VSMain: position + offset, color passed through.
+						static const float noOffset[4] = {};
+						const float* offset = constantBuffer
+							? reinterpret_cast<const float*>(constantBuffer->GetMemory() + constantBufferOffset)
+							: noOffset;
+						vertices.resize(vertexCount);
+						bool behindEye = false;
+						for (uint32_t i = 0; i < vertexCount; i++)
+						{
+							const uint8_t* vertex = vertexBuffer->GetMemory() + static_cast<size_t>(firstVertex + i) * vertexStride;
+							float position[3];
+							memcpy(position, vertex + PositionOffset, sizeof(position));
+
+							ShadedVertex& shaded = vertices[i];
+							const float w = 1.0f + offset[3];
+							behindEye |= w <= 0.0f;
+							shaded.inverseW = 1.0f / w;
+							shaded.x = Snap(((position[0] + offset[0]) * shaded.inverseW * 0.5f + 0.5f) * viewportWidth);
+							shaded.y = Snap((0.5f - (position[1] + offset[1]) * shaded.inverseW * 0.5f) * viewportHeight);
+							shaded.z = (position[2] + offset[2]) * shaded.inverseW;
+							memcpy(shaded.color, vertex + ColorOffset, sizeof(shaded.color));
+						}
+						if (behindEye)
+						{
+							m_stats.culledTriangles += vertexCount - 2;
+							break;
+						}
+
+						// Pixels outside the viewport or either target are never touched.
+						int32_t limitX = static_cast<int32_t>(viewportWidth), limitY = static_cast<int32_t>(viewportHeight);
+						for (Resource* target : { renderTarget, depthStencil })
+						{
+							if (target)
+							{
+								limitX = limitX < static_cast<int32_t>(target->GetDesc().width) ? limitX : static_cast<int32_t>(target->GetDesc().width);
+								limitY = limitY < static_cast<int32_t>(target->GetDesc().height) ? limitY : static_cast<int32_t>(target->GetDesc().height);
+							}
+						}
+
+						// Strip triangle i is (i, i+1, i+2), with the first two swapped on odd i so all
+						// triangles keep the winding of the first.
+						for (uint32_t i = 0; i + 2 < vertexCount; i++)
+						{
+							const ShadedVertex* v[3] = { &vertices[i], &vertices[i + 1], &vertices[i + 2] };
+							if (i & 1)
+							{
+								swap(v[0], v[1]);
+							}
+
+							float area = (v[1]->x - v[0]->x) * (v[2]->y - v[0]->y) - (v[2]->x - v[0]->x) * (v[1]->y - v[0]->y);
+							if (area < 0.0f && !pipeline->GetDesc().cullBack)
+							{
+								swap(v[1], v[2]);
+								area = -area;
+							}
+
+							Triangle triangle;
+							triangle.minX = static_cast<int32_t>(floorf(Min3(v[0]->x, v[1]->x, v[2]->x)));
+							triangle.minY = static_cast<int32_t>(floorf(Min3(v[0]->y, v[1]->y, v[2]->y)));
+							triangle.maxX = static_cast<int32_t>(ceilf(Max3(v[0]->x, v[1]->x, v[2]->x)));
+							triangle.maxY = static_cast<int32_t>(ceilf(Max3(v[0]->y, v[1]->y, v[2]->y)));
+							triangle.minX = triangle.minX < 0 ? 0 : triangle.minX;
+							triangle.minY = triangle.minY < 0 ? 0 : triangle.minY;
+							triangle.maxX = triangle.maxX < limitX ? triangle.maxX : limitX - 1;
+							triangle.maxY = triangle.maxY < limitY ? triangle.maxY : limitY - 1;
+							if (area <= 0.0f || triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+							{
+								m_stats.culledTriangles++;
+								continue;
+							}
+
+							SetupPlanes(triangle, v, area);
+							triangle.state = pipeline->GetDesc();
+							triangle.renderTarget = renderTarget;
+							triangle.depthStencil = depthStencil;
+							triangle.query = activeQuery;
+							BinTriangle(triangle);
+						}
+						break;
+					}
+
+					case Op::BeginQuery:
+					{
+						// Binned triangles may still count into the previous use of this query.
+						if (m_pendingQueries)
+						{
+							Flush();
+						}
+						auto heap = static_cast<QueryHeap*>(command.first);
+						activeQuery = &heap->Samples(command.a);
+						*activeQuery = 0;
+						break;
+					}
+
+					case Op::EndQuery:
+						activeQuery = nullptr;
+						break;
+
+					case Op::ResolveQuery:
+					{
+						Flush();
+						auto heap = static_cast<QueryHeap*>(command.first);
+						auto destination = reinterpret_cast<uint64_t*>(static_cast<Resource*>(command.second)->GetMemory() + command.offset);
+						for (uint32_t i = 0; i < command.b; i++)
+						{
+							uint64_t samples = heap->Samples(command.a + i);
+							destination[i] = heap->GetType() == QueryType::BinaryOcclusion ? (samples != 0 ? 1 : 0) : samples;
+						}
+						break;
+					}
+
+					case Op::SetPredication:
+						predicate = command.first
+							? reinterpret_cast<const uint64_t*>(static_cast<Resource*>(command.first)->GetMemory() + command.offset)
+							: nullptr;
+						break;
+
+					case Op::CopyBuffer:
+						memcpy(
+							static_cast<Resource*>(command.first)->GetMemory() + command.offset,
+							static_cast<Resource*>(command.second)->GetMemory() + command.sourceOffset,
+							static_cast<size_t>(command.size));
+						break;
+
+					default:
+						break;
+					}
+				}
+
+				// Targets are complete when Submit returns, like the null backend's fences.
+				Flush();
+			}
+
+			void Queue::Resize(uint32_t width, uint32_t height)
+			{
+				const uint32_t tilesX = (width + TileSize - 1) / TileSize;
+				const uint32_t tilesY = (height + TileSize - 1) / TileSize;
+				if (tilesX <= m_tilesX && tilesY <= m_tilesY)
+				{
+					return;
+				}
+
+				// Bin indices depend on the grid width, so grow only when nothing is binned.
+				Flush();
+				m_tilesX = tilesX > m_tilesX ? tilesX : m_tilesX;
+				m_tilesY = tilesY > m_tilesY ? tilesY : m_tilesY;
+				m_bins.assign(m_tilesX * m_tilesY, vector<uint32_t>());
+			}
+
+			void Queue::BinClear(Resource* target, uint32_t value)
+			{
+				const ResourceDesc& desc = target->GetDesc();
+				if (desc.width == 0 || desc.height == 0)
+				{
+					return;
+				}
+
+				// With nothing binned yet the clear cannot be reordered with other work, so it runs
+				// now in memory order, which is several times cheaper than tile by tile.
+				if (m_triangles.empty() && m_clears.empty())
+				{
+					Fill(target->GetTexels(), target->GetPitch(), 0, 0, target->GetPitch() - 1, desc.height - 1, value);
+					return;
+				}
+				Resize(desc.width, desc.height);
+
+				const uint32_t index = static_cast<uint32_t>(m_clears.size());
+				m_clears.push_back({ target, value });
+				for (uint32_t y = 0; y <= (desc.height - 1) / TileSize; y++)
+				{
+					for (uint32_t x = 0; x <= (desc.width - 1) / TileSize; x++)
+					{
+						m_bins[y * m_tilesX + x].push_back(ClearBit | index);
+					}
+				}
+			}
+
+			void Queue::BinTriangle(const Triangle& triangle)
+			{
+				Resize(triangle.maxX + 1, triangle.maxY + 1);
+
+				const uint32_t index = static_cast<uint32_t>(m_triangles.size());
+				m_triangles.push_back(triangle);
+				m_stats.triangles++;
+				m_pendingQueries |= triangle.query != nullptr;
+				for (uint32_t y = triangle.minY / TileSize; y <= triangle.maxY / TileSize; y++)
+				{
+					for (uint32_t x = triangle.minX / TileSize; x <= triangle.maxX / TileSize; x++)
+					{
+						m_bins[y * m_tilesX + x].push_back(index);
+						m_stats.binnedTriangles++;
+					}
+				}
+			}
+
+			void Queue::Flush()
+			{
+				if (m_triangles.empty() && m_clears.empty())
+				{
+					return;
+				}
+
+				m_busyTiles.clear();
+				for (uint32_t tile = 0; tile < m_bins.size(); tile++)
+				{
+					if (!m_bins[tile].empty())
+					{
+						m_busyTiles.push_back(tile);
+					}
+				}
+				m_stats.flushes++;
+				m_stats.tiles += m_busyTiles.size();
+
+				// Tiles are handed out one at a time; the submitting thread takes part.
+				atomic<uint32_t> next(0);
+				atomic<uint64_t> passed(0);
+				auto worker = [this, &next, &passed]()
+				{
+					uint64_t local = 0;
+					for (uint32_t i = next++; i < m_busyTiles.size(); i = next++)
+					{
+						local += RasterizeTile(m_busyTiles[i]);
+					}
+					passed += local;
+				};
+
+				vector<future<void>> helpers;
+				if (m_threadPool)
+				{
+					const uint32_t wanted = static_cast<uint32_t>(m_busyTiles.size()) - 1;
+					const uint32_t available = m_threadPool->GetThreadCount();
+					for (uint32_t i = 0; i < (wanted < available ? wanted : available); i++)
+					{
+						helpers.push_back(m_threadPool->Submit(worker));
+					}
+				}
+				worker();
+				for (auto& helper : helpers)
+				{
+					helper.wait();
+				}
+				m_stats.samplesPassed += passed;
+
+				for (uint32_t tile : m_busyTiles)
+				{
+					m_bins[tile].clear();
+				}
+				m_triangles.clear();
+				m_clears.clear();
+				m_pendingQueries = false;
+			}
+
+			uint64_t Queue::RasterizeTile(uint32_t tile)
+			{
+				const int32_t tileX0 = static_cast<int32_t>(tile % m_tilesX * TileSize);
+				const int32_t tileY0 = static_cast<int32_t>(tile / m_tilesX * TileSize);
+				const int32_t tileX1 = tileX0 + TileSize - 1;
+				const int32_t tileY1 = tileY0 + TileSize - 1;
+
+				uint64_t passed = 0;
+				for (uint32_t item : m_bins[tile])
+				{
+					if (item & ClearBit)
+					{
+						const Clear& clear = m_clears[item & ~ClearBit];
+						const ResourceDesc& desc = clear.target->GetDesc();
+						const int32_t x1 = tileX1 < static_cast<int32_t>(desc.width) ? tileX1 : static_cast<int32_t>(desc.width) - 1;
+						const int32_t y1 = tileY1 < static_cast<int32_t>(desc.height) ? tileY1 : static_cast<int32_t>(desc.height) - 1;
+						// Packed colors and depth bits are both one 32-bit word per texel.
+						Fill(clear.target->GetTexels(), clear.target->GetPitch(), tileX0, tileY0, x1, y1, clear.value);
+						continue;
+					}
+
+					const Triangle& triangle = m_triangles[item];
+					const int32_t x0 = triangle.minX > tileX0 ? triangle.minX : tileX0;
+					const int32_t y0 = triangle.minY > tileY0 ? triangle.minY : tileY0;
+					const int32_t x1 = triangle.maxX < tileX1 ? triangle.maxX : tileX1;
+					const int32_t y1 = triangle.maxY < tileY1 ? triangle.maxY : tileY1;
+					if (x0 > x1 || y0 > y1)
+					{
+						continue;
+					}
+
+					const uint64_t count = RasterizeTriangle(triangle, x0, y0, x1, y1);
+					if (triangle.query && count)
+					{
+						*triangle.query += count;
+					}
+					passed += count;
+				}
+				return passed;
+			}
+
+			SwapChain::SwapChain(uint32_t bufferCount, uint32_t width, uint32_t height)
+			{
+				for (uint32_t i = 0; i < bufferCount; i++)
+				{
+					m_buffers.emplace_back(new Resource(ResourceDesc::Texture(ResourceKind::RenderTarget, width, height, Format::R8G8B8A8Unorm)));
+				}
+			}
+
+			void SwapChain::Present()
+			{
+				m_presents++;
+				m_current = (m_current + 1) % GetBufferCount();
+			}
+
+			unique_ptr<IResource> Device::CreateResource(const ResourceDesc& desc, ResourceState)
+			{
+				return unique_ptr<IResource>(new Resource(desc));
+			}
+
+			unique_ptr<IResource> Device::CreateTransient(const ResourceDesc& desc, ResourceState, uint32_t, uint32_t)
+			{
+				return unique_ptr<IResource>(new Resource(desc));
+			}
+
+			unique_ptr<IFence> Device::CreateFence(uint64_t initialValue)
+			{
+				return unique_ptr<IFence>(new Fence(initialValue));
+			}
+
+			unique_ptr<IQueryHeap> Device::CreateQueryHeap(QueryType type, uint32_t count)
+			{
+				return unique_ptr<IQueryHeap>(new QueryHeap(type, count));
+			}
+
+			unique_ptr<ICommandList> Device::CreateCommandList(uint32_t)
+			{
+				return unique_ptr<ICommandList>(new Null::CommandList());
+			}
+		}
+	}
+}
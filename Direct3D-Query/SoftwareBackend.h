@@ -0,0 +1,201 @@
+#pragma once
+#include "NullBackend.h"
+#include "ThreadPool.h"
+
+namespace Query {
+	namespace Backend
+	{
+		// CPU reference backend. Command lists record like the null backend; submission runs the
+		// Shaders.hlsl pipeline natively: VSMain adds the constant buffer offset to the position and
+		// passes the color through, PSMain returns the color, and the output merger does the alpha
+		// blending and D32 LESS depth test of the sample's PSOs. Occlusion queries count the samples
+		// that pass the depth test.
+		//
+		// Triangles are set up and binned into screen tiles in submission order, then the tiles are
+		// rasterized in parallel, each by one thread in primitive order, so the result does not depend
+		// on the thread count. Edge functions and the output merger run on four pixels at a time.
+		// There is no near-plane clipping: triangles with a vertex at w <= 0 are dropped.
+		namespace Software
+		{
+			class Resource : public IResource
+			{
+			private:
+				ResourceDesc m_desc;
+				uint32_t m_pitch = 0;	//texels per row, a multiple of 4 so pixel quads never cross the row end
+				vector<uint8_t> m_memory;
+
+			public:
+				explicit Resource(const ResourceDesc& desc);
+				const ResourceDesc& GetDesc() const override { return m_desc; }
+				void* Map() override { return m_memory.data(); }
+				void Unmap() override {}
+
+				uint8_t* GetMemory() { return m_memory.data(); }
+				uint32_t GetPitch() const { return m_pitch; }
+				// R8G8B8A8 render targets.
+				uint32_t* GetTexels() { return reinterpret_cast<uint32_t*>(m_memory.data()); }
+				// D32 depth stencils.
+				float* GetDepths() { return reinterpret_cast<float*>(m_memory.data()); }
+			};
+
+			// The subset of D3D12_GRAPHICS_PIPELINE_STATE_DESC the sample varies. The defaults are the
+			// scene PSO: SRC_ALPHA/INV_SRC_ALPHA color blend with ONE/ZERO alpha, depth LESS with
+			// writes, back faces culled and clockwise front faces.
+			struct PipelineDesc
+			{
+				bool blendEnable = true;
+				bool colorWrite = true;
+				bool depthEnable = true;
+				bool depthWrite = true;
+				bool cullBack = true;
+			};
+
+			class Pipeline : public IPipeline
+			{
+			private:
+				string m_name;
+				PipelineDesc m_desc;
+
+			public:
+				Pipeline(const char* name, const PipelineDesc& desc) : m_name(name), m_desc(desc) {}
+				const string& GetName() const { return m_name; }
+				const PipelineDesc& GetDesc() const { return m_desc; }
+			};
+
+			class Fence : public IFence
+			{
+			private:
+				uint64_t m_value;
+
+			public:
+				explicit Fence(uint64_t value) : m_value(value) {}
+				uint64_t GetCompletedValue() const override { return m_value; }
+				void Wait(uint64_t) override {}
+				void Complete(uint64_t value) { m_value = value > m_value ? value : m_value; }
+			};
+
+			// Samples are added by the tile workers, one add per triangle and tile.
+			class QueryHeap : public IQueryHeap
+			{
+			private:
+				QueryType m_type;
+				uint32_t m_count;
+				unique_ptr<atomic<uint64_t>[]> m_samples;
+
+			public:
+				QueryHeap(QueryType type, uint32_t count);
+				QueryType GetType() const override { return m_type; }
+				uint32_t GetCount() const override { return m_count; }
+				atomic<uint64_t>& Samples(uint32_t index) { return m_samples[index]; }
+			};
+
+			class Queue : public IQueue
+			{
+			public:
+				static const uint32_t TileSize = 64;
+
+				struct Stats
+				{
+					uint64_t submits = 0;
+					uint64_t commands = 0;
+					uint64_t draws = 0;
+					uint64_t predicatedDraws = 0;	//skipped by predication
+					uint64_t triangles = 0;	//set up after culling
+					uint64_t culledTriangles = 0;
+					uint64_t binnedTriangles = 0;	//triangle and tile pairs
+					uint64_t tiles = 0;	//tiles rasterized, summed over flushes
+					uint64_t flushes = 0;
+					uint64_t samplesPassed = 0;	//depth test passes, whether or not written
+				};
+
+				// A set-up triangle: screen-space edge functions and attribute planes, plus the state
+				// it is drawn with. Planes give the value at a pixel center as a*x + b*y + c.
+				struct Triangle
+				{
+					float edgeA[3], edgeB[3], edgeC[3];
+					bool topLeft[3];
+					float depth[3];	//z/w
+					float inverseW[3];	//1/w
+					float color[4][3];	//color/w, perspective corrected per pixel
+					int32_t minX, minY, maxX, maxY;	//inclusive pixel bounds, clipped to viewport and targets
+					PipelineDesc state;
+					Resource* renderTarget;
+					Resource* depthStencil;
+					atomic<uint64_t>* query;
+				};
+
+			private:
+				// A clear is binned to every tile it touches, so it stays ordered with the triangles.
+				struct Clear
+				{
+					Resource* target;
+					uint32_t value;	//packed color or depth bits, as recorded
+				};
+
+				Threading::ThreadPool* m_threadPool = nullptr;
+				Stats m_stats;
+
+				vector<Triangle> m_triangles;
+				vector<Clear> m_clears;
+				// Per tile, indices into m_triangles, or into m_clears with ClearBit set.
+				static const uint32_t ClearBit = 0x80000000u;
+				vector<vector<uint32_t>> m_bins;
+				uint32_t m_tilesX = 0, m_tilesY = 0;
+				vector<uint32_t> m_busyTiles;
+				bool m_pendingQueries = false;	//a binned triangle counts into a query
+
+			private:
+				void Resize(uint32_t width, uint32_t height);
+				void BinClear(Resource* target, uint32_t value);
+				void BinTriangle(const Triangle& triangle);
+				// Rasterizes everything binned so far and empties the bins.
+				void Flush();
+				uint64_t RasterizeTile(uint32_t tile);
+
+			public:
+				// Without a pool the tiles are rasterized on the submitting thread.
+				void SetThreadPool(Threading::ThreadPool* threadPool) { m_threadPool = threadPool; }
+				const Stats& GetStats() const { return m_stats; }
+
+				void Submit(ICommandList* commandList) override;
+				void Signal(IFence* fence, uint64_t value) override { static_cast<Fence*>(fence)->Complete(value); }
+			};
+
+			class SwapChain : public ISwapChain
+			{
+			private:
+				vector<unique_ptr<Resource>> m_buffers;
+				uint32_t m_current = 0;
+				uint64_t m_presents = 0;
+
+			public:
+				SwapChain(uint32_t bufferCount, uint32_t width, uint32_t height);
+				uint32_t GetBufferCount() const override { return static_cast<uint32_t>(m_buffers.size()); }
+				uint32_t GetCurrentIndex() const override { return m_current; }
+				IResource* GetBuffer(uint32_t index) override { return m_buffers[index].get(); }
+				void Present() override;
+				uint64_t GetPresentCount() const { return m_presents; }
+			};
+
+			class Device : public IDevice
+			{
+			private:
+				Queue m_queue;
+
+			public:
+				explicit Device(Threading::ThreadPool* threadPool = nullptr) { m_queue.SetThreadPool(threadPool); }
+
+				unique_ptr<IResource> CreateResource(const ResourceDesc& desc, ResourceState initialState) override;
+				// Transients get their own memory; aliasing would save nothing on the CPU.
+				unique_ptr<IResource> CreateTransient(const ResourceDesc& desc, ResourceState initialState, uint32_t firstStep, uint32_t lastStep) override;
+				void CompileTransients() override {}
+
+				unique_ptr<IFence> CreateFence(uint64_t initialValue) override;
+				unique_ptr<IQueryHeap> CreateQueryHeap(QueryType type, uint32_t count) override;
+				unique_ptr<ICommandList> CreateCommandList(uint32_t frameCount) override;
+				IQueue* GetQueue() override { return &m_queue; }
+				Queue& GetSoftwareQueue() { return m_queue; }
+			};
+		}
+	}
+}
@@ -0,0 +1,227 @@
+#include "pch.h"
+#include "TaskGraph.h"
+
+namespace Query {
+	namespace Threading
+	{
+		uint32_t TaskGraph::AddTask(const char* name, function<void()> work, Affinity affinity)
+		{
+			Task task;
+			task.name = name;
+			task.work = move(work);
+			task.affinity = affinity;
+			m_tasks.push_back(move(task));
+			return static_cast<uint32_t>(m_tasks.size() - 1);
+		}
+
+		void TaskGraph::DependsOn(uint32_t task, uint32_t dependency)
+		{
+			m_tasks[task].dependencies.push_back(dependency);
+			m_tasks[dependency].dependents.push_back(task);
+		}
+
+		bool TaskGraph::Sort(vector<uint32_t>& order) const
+		{
+			vector<uint32_t> remaining(m_tasks.size());
+			order.clear();
+			for (uint32_t i = 0; i < m_tasks.size(); i++)
+			{
+				remaining[i] = static_cast<uint32_t>(m_tasks[i].dependencies.size());
+				if (remaining[i] == 0)
+				{
+					order.push_back(i);
+				}
+			}
+			for (size_t next = 0; next < order.size(); next++)
+			{
+				for (uint32_t dependent : m_tasks[order[next]].dependents)
+				{
+					if (--remaining[dependent] == 0)
+					{
+						order.push_back(dependent);
+					}
+				}
+			}
+			return order.size() == m_tasks.size();
+		}
+
+		bool TaskGraph::Run(ThreadPool& pool)
+		{
+			vector<uint32_t> order;
+			if (!Sort(order))
+			{
+				return false;
+			}
+
+			m_pool = &pool;
+			m_threads.assign(1, this_thread::get_id());
+			m_pending = static_cast<uint32_t>(m_tasks.size());
+			m_start = chrono::steady_clock::now();
+
+			{
+				lock_guard<mutex> lock(m_mutex);
+				for (auto& task : m_tasks)
+				{
+					task.remaining = static_cast<uint32_t>(task.dependencies.size());
+				}
+				for (uint32_t i = 0; i < m_tasks.size(); i++)
+				{
+					if (m_tasks[i].remaining == 0)
+					{
+						Dispatch(i);
+					}
+				}
+			}
+
+			// The calling thread runs its own tasks until everything has finished.
+			unique_lock<mutex> lock(m_mutex);
+			while (m_pending != 0)
+			{
+				m_callerWake.wait(lock, [this]() { return m_pending == 0 || !m_callerQueue.empty(); });
+				if (!m_callerQueue.empty())
+				{
+					uint32_t task = m_callerQueue.front();
+					m_callerQueue.pop_front();
+					lock.unlock();
+					Execute(task);
+					lock.lock();
+				}
+			}
+			lock.unlock();
+
+			m_wallMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - m_start).count();
+			FindCriticalPath(order);
+			return true;
+		}
+
+		// Called with m_mutex held.
+		void TaskGraph::Dispatch(uint32_t task)
+		{
+			if (m_tasks[task].affinity == Affinity::Caller)
+			{
+				m_callerQueue.push_back(task);
+				m_callerWake.notify_one();
+			}
+			else
+			{
+				m_pool->Enqueue([this, task]() { Execute(task); });
+			}
+		}
+
+		void TaskGraph::Execute(uint32_t task)
+		{
+			auto begin = chrono::steady_clock::now();
+			m_tasks[task].work();
+			auto end = chrono::steady_clock::now();
+
+			lock_guard<mutex> lock(m_mutex);
+			Timing& timing = m_tasks[task].timing;
+			timing.start = chrono::duration<double, milli>(begin - m_start).count();
+			timing.duration = chrono::duration<double, milli>(end - begin).count();
+
+			thread::id id = this_thread::get_id();
+			auto known = find(m_threads.begin(), m_threads.end(), id);
+			timing.thread = static_cast<uint32_t>(known - m_threads.begin());
+			if (known == m_threads.end())
+			{
+				m_threads.push_back(id);
+			}
+
+			for (uint32_t dependent : m_tasks[task].dependents)
+			{
+				if (--m_tasks[dependent].remaining == 0)
+				{
+					Dispatch(dependent);
+				}
+			}
+			if (--m_pending == 0)
+			{
+				m_callerWake.notify_one();
+			}
+		}
+
+		void TaskGraph::FindCriticalPath(const vector<uint32_t>& order)
+		{
+			// Longest chain of measured durations; ties go to the dependency seen first.
+			const uint32_t None = ~0u;
+			vector<double> finish(m_tasks.size(), 0);
+			vector<uint32_t> previous(m_tasks.size(), None);
+			uint32_t last = None;
+			for (uint32_t task : order)
+			{
+				double ready = 0;
+				for (uint32_t dependency : m_tasks[task].dependencies)
+				{
+					if (previous[task] == None || finish[dependency] > ready)
+					{
+						ready = finish[dependency];
+						previous[task] = dependency;
+					}
+				}
+				finish[task] = ready + m_tasks[task].timing.duration;
+				if (last == None || finish[task] > finish[last])
+				{
+					last = task;
+				}
+			}
+
+			m_criticalPath.clear();
+			for (auto& task : m_tasks)
+			{
+				task.timing.critical = false;
+			}
+			for (uint32_t task = last; task != None; task = previous[task])
+			{
+				m_tasks[task].timing.critical = true;
+				m_criticalPath.push_back(task);
+			}
+			reverse(m_criticalPath.begin(), m_criticalPath.end());
+		}
+
+		double TaskGraph::GetTaskMilliseconds() const
+		{
+			double total = 0;
+			for (auto& task : m_tasks)
+			{
+				total += task.timing.duration;
+			}
+			return total;
+		}
+
+		double TaskGraph::GetCriticalPathMilliseconds() const
+		{
+			double total = 0;
+			for (uint32_t task : m_criticalPath)
+			{
+				total += m_tasks[task].timing.duration;
+			}
+			return total;
+		}
+
+		string TaskGraph::Report() const
+		{
+			vector<uint32_t> byStart(m_tasks.size());
+			for (uint32_t i = 0; i < byStart.size(); i++)
+			{
+				byStart[i] = i;
+			}
+			stable_sort(byStart.begin(), byStart.end(), [this](uint32_t a, uint32_t b)
+			{
+				return m_tasks[a].timing.start < m_tasks[b].timing.start;
+			});
+
+			char line[256];
+			snprintf(line, sizeof(line), "%u tasks: wall %.2f ms, task time %.2f ms, critical path %.2f ms\n",
+				GetTaskCount(), m_wallMilliseconds, GetTaskMilliseconds(), GetCriticalPathMilliseconds());
+			string report = line;
+			for (uint32_t task : byStart)
+			{
+				const Timing& timing = m_tasks[task].timing;
+				snprintf(line, sizeof(line), "%c %-24s start %8.2f  time %8.2f  thread %u\n",
+					timing.critical ? '*' : ' ', m_tasks[task].name.c_str(), timing.start, timing.duration, timing.thread);
+				report += line;
+			}
+			return report;
+		}
+	}
+}
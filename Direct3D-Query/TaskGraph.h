@@ -0,0 +1,75 @@
+#pragma once
+#include "ThreadPool.h"
+
+namespace Query {
+	namespace Threading
+	{
+		// One-shot dependency graph of coarse tasks. A task starts on the pool as soon as the tasks it
+		// depends on have finished; Caller tasks run on the thread calling Run instead, for work that
+		// has to stay on that thread (for example swap chain creation, which talks to the window).
+		// Every task is timed, and the critical path through the graph is derived from those timings.
+		class TaskGraph
+		{
+		public:
+			enum class Affinity { Any, Caller };
+
+			struct Timing
+			{
+				double start = 0;	//milliseconds since Run started
+				double duration = 0;
+				uint32_t thread = 0;	//0 is the calling thread, workers are numbered as they show up
+				bool critical = false;
+			};
+
+		private:
+			struct Task
+			{
+				string name;
+				function<void()> work;
+				Affinity affinity;
+				vector<uint32_t> dependencies;
+				vector<uint32_t> dependents;
+				uint32_t remaining = 0;
+				Timing timing;
+			};
+
+			vector<Task> m_tasks;
+			vector<uint32_t> m_criticalPath;
+			double m_wallMilliseconds = 0;
+
+			ThreadPool* m_pool = nullptr;
+			chrono::steady_clock::time_point m_start;
+			deque<uint32_t> m_callerQueue;
+			vector<thread::id> m_threads;
+			uint32_t m_pending = 0;
+			mutex m_mutex;
+			condition_variable m_callerWake;
+
+		private:
+			bool Sort(vector<uint32_t>& order) const;
+			void Dispatch(uint32_t task);
+			void Execute(uint32_t task);
+			void FindCriticalPath(const vector<uint32_t>& order);
+
+		public:
+			uint32_t AddTask(const char* name, function<void()> work, Affinity affinity = Affinity::Any);
+			void DependsOn(uint32_t task, uint32_t dependency);
+
+			// Runs every task once and returns when all have finished. Fails without running anything
+			// if the dependencies contain a cycle.
+			bool Run(ThreadPool& pool);
+
+			uint32_t GetTaskCount() const { return static_cast<uint32_t>(m_tasks.size()); }
+			const string& GetName(uint32_t task) const { return m_tasks[task].name; }
+			const Timing& GetTiming(uint32_t task) const { return m_tasks[task].timing; }
+			const vector<uint32_t>& GetCriticalPath() const { return m_criticalPath; }
+
+			double GetWallMilliseconds() const { return m_wallMilliseconds; }
+			double GetTaskMilliseconds() const;
+			double GetCriticalPathMilliseconds() const;
+
+			// One line per task in start order, critical tasks marked with '*'.
+			string Report() const;
+		};
+	}
+}
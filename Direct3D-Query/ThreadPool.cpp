@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+namespace Query {
+	namespace Threading
+	{
+		ThreadPool::~ThreadPool()
+		{
+			Shutdown();
+		}
+
+		void ThreadPool::Initialize(uint32_t threadCount)
+		{
+			if (threadCount == 0)
+			{
+				uint32_t hardware = thread::hardware_concurrency();
+				threadCount = hardware > 1 ? hardware - 1 : 1;
+			}
+
+			m_stopping = false;
+			m_workers.reserve(threadCount);
+			for (uint32_t i = 0; i < threadCount; i++)
+			{
+				m_workers.emplace_back([this]() { WorkerLoop(); });
+			}
+		}
+
+		void ThreadPool::Shutdown()
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+			m_wake.notify_all();
+			for (auto& worker : m_workers)
+			{
+				worker.join();
+			}
+			m_workers.clear();
+		}
+
+		void ThreadPool::Enqueue(function<void()> task)
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+				m_tasks.push_back(move(task));
+			}
+			m_wake.notify_one();
+		}
+
+		void ThreadPool::ParallelFor(uint32_t count, const function<void(uint32_t)>& body)
+		{
+			// Indices are handed out one at a time, so uneven items balance across the threads.
+			atomic<uint32_t> next(0);
+			auto worker = [&next, count, &body]()
+			{
+				for (uint32_t i = next++; i < count; i = next++)
+				{
+					body(i);
+				}
+			};
+
+			vector<future<void>> helpers;
+			const uint32_t wanted = count ? count - 1 : 0;
+			const uint32_t available = GetThreadCount();
+			for (uint32_t i = 0; i < (wanted < available ? wanted : available); i++)
+			{
+				helpers.push_back(Submit(worker));
+			}
+			worker();
+			for (auto& helper : helpers)
+			{
+				helper.wait();
+			}
+		}
+
+		void ThreadPool::WaitIdle()
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_idle.wait(lock, [this]() { return m_tasks.empty() && m_running == 0; });
+		}
+
+		void ThreadPool::WorkerLoop()
+		{
+			unique_lock<mutex> lock(m_mutex);
+			for (;;)
+			{
+				m_wake.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+				if (m_tasks.empty())
+				{
+					return;	//stopping, and everything queued has run
+				}
+
+				function<void()> task = move(m_tasks.front());
+				m_tasks.pop_front();
+				m_running++;
+
+				lock.unlock();
+				task();
+				lock.lock();
+
+				m_running--;
+				if (m_tasks.empty() && m_running == 0)
+				{
+					m_idle.notify_all();
+				}
+			}
+		}
+	}
+}
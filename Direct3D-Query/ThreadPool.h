@@ -0,0 +1,52 @@
+#pragma once
+
+namespace Query {
+	namespace Threading
+	{
+		// Fixed set of worker threads draining one FIFO queue. Tasks must not block on other tasks
+		// of the same pool, or the pool can run out of workers.
+		class ThreadPool
+		{
+		private:
+			vector<thread> m_workers;
+			deque<function<void()>> m_tasks;
+			mutex m_mutex;
+			condition_variable m_wake;
+			condition_variable m_idle;
+			uint32_t m_running = 0;
+			bool m_stopping = false;
+
+		private:
+			void WorkerLoop();
+
+		public:
+			~ThreadPool();
+
+			// threadCount 0 picks one worker per hardware thread, leaving one for the caller.
+			void Initialize(uint32_t threadCount = 0);
+			// Finishes the queued tasks and joins the workers.
+			void Shutdown();
+
+			void Enqueue(function<void()> task);
+
+			template<typename F>
+			auto Submit(F task) -> future<decltype(task())>
+			{
+				typedef decltype(task()) Result;
+				auto packaged = make_shared<packaged_task<Result()>>(move(task));
+				future<Result> result = packaged->get_future();
+				Enqueue([packaged]() { (*packaged)(); });
+				return result;
+			}
+
+			// Calls body(i) for every i in [0, count) on the workers and the calling thread, and returns
+			// once all calls have returned. Must not be called from a task of this pool.
+			void ParallelFor(uint32_t count, const function<void(uint32_t)>& body);
+
+			// Blocks until the queue is empty and no task is running.
+			void WaitIdle();
+
+			uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+		};
+	}
+}
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "TransientAliaser.h"
+
+namespace Query {
+	namespace Memory
+	{
+		static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		void TransientAliaser::Clear()
+		{
+			m_resources.clear();
+			m_placements.clear();
+			m_barriers.clear();
+			m_heapSize = 0;
+			m_heapAlignment = 1;
+		}
+
+		uint32_t TransientAliaser::Add(const Resource& resource)
+		{
+			Resource r = resource;
+			if (r.alignment == 0) r.alignment = 1;
+			if (r.lastPass < r.firstPass) r.lastPass = r.firstPass;
+
+			m_resources.push_back(r);
+			return static_cast<uint32_t>(m_resources.size() - 1);
+		}
+
+		void TransientAliaser::Compile()
+		{
+			const uint32_t count = GetResourceCount();
+			m_placements.assign(count, Placement{ 0, false });
+			m_barriers.clear();
+			m_heapSize = 0;
+			m_heapAlignment = 1;
+
+			// Placing the big resources first leaves the gaps for the small ones. Ties are broken by
+			// first use and declaration order so that the layout is fully deterministic.
+			vector<uint32_t> order(count);
+			for (uint32_t i = 0; i < count; i++) order[i] = i;
+			sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+			{
+				const Resource& ra = m_resources[a];
+				const Resource& rb = m_resources[b];
+				if (ra.size != rb.size) return ra.size > rb.size;
+				if (ra.firstPass != rb.firstPass) return ra.firstPass < rb.firstPass;
+				return a < b;
+			});
+
+			vector<uint32_t> placed;
+			vector<pair<uint64_t, uint64_t>> occupied;
+			for (uint32_t index : order)
+			{
+				const Resource& resource = m_resources[index];
+
+				// Memory of everything alive at the same time is off limits.
+				occupied.clear();
+				for (uint32_t other : placed)
+				{
+					if (LifetimesOverlap(resource, m_resources[other]))
+					{
+						occupied.emplace_back(m_placements[other].offset, m_placements[other].offset + m_resources[other].size);
+					}
+				}
+				sort(occupied.begin(), occupied.end());
+
+				uint64_t candidate = 0;
+				for (auto& range : occupied)
+				{
+					if (AlignUp(candidate, resource.alignment) + resource.size <= range.first) break;
+					if (range.second > candidate) candidate = range.second;
+				}
+
+				uint64_t offset = AlignUp(candidate, resource.alignment);
+				m_placements[index].offset = offset;
+				placed.push_back(index);
+
+				if (offset + resource.size > m_heapSize) m_heapSize = offset + resource.size;
+				if (resource.alignment > m_heapAlignment) m_heapAlignment = resource.alignment;
+			}
+
+			// Alignment padding can make the first fit need more memory than no aliasing at all, in which
+			// case every resource gets memory of its own, in declaration order.
+			if (m_heapSize > GetUnaliasedSize())
+			{
+				m_heapSize = 0;
+				for (uint32_t index = 0; index < count; index++)
+				{
+					m_placements[index].offset = AlignUp(m_heapSize, m_resources[index].alignment);
+					m_heapSize = m_placements[index].offset + m_resources[index].size;
+				}
+			}
+
+			// Every resource that shares memory with another one needs an aliasing barrier at its first
+			// use. The frame repeats, so a resource used early also takes over from the ones used late
+			// in the previous frame.
+			for (uint32_t index = 0; index < count; index++)
+			{
+				const Resource& resource = m_resources[index];
+				const uint64_t begin = m_placements[index].offset;
+				const uint64_t end = begin + resource.size;
+
+				uint32_t before = None, overlapCount = 0;
+				for (uint32_t other = 0; other < count; other++)
+				{
+					if (other == index) continue;
+
+					const uint64_t otherBegin = m_placements[other].offset;
+					const uint64_t otherEnd = otherBegin + m_resources[other].size;
+					if (otherBegin < end && begin < otherEnd)
+					{
+						before = other;
+						overlapCount++;
+					}
+				}
+
+				if (overlapCount > 0)
+				{
+					m_placements[index].aliased = true;
+					m_barriers.push_back({ resource.firstPass, overlapCount == 1 ? before : None, index });
+				}
+			}
+
+			sort(m_barriers.begin(), m_barriers.end(), [](const AliasingBarrier& a, const AliasingBarrier& b)
+			{
+				return a.pass != b.pass ? a.pass < b.pass : a.after < b.after;
+			});
+		}
+
+		uint64_t TransientAliaser::GetUnaliasedSize() const
+		{
+			uint64_t size = 0;
+			for (auto& resource : m_resources)
+			{
+				size = AlignUp(size, resource.alignment) + resource.size;
+			}
+			return size;
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+namespace Query {
+	namespace Memory
+	{
+		// Lifetime-based memory aliasing for transient resources. Every resource declares the first and
+		// last pass that touches it; resources whose pass ranges do not overlap may share memory.
+		// The result only depends on the declarations, so the same input always gives the same layout.
+		class TransientAliaser
+		{
+		public:
+			static const uint32_t None = ~0u;
+
+			struct Resource
+			{
+				uint64_t size;
+				uint64_t alignment;
+				uint32_t firstPass;
+				uint32_t lastPass;
+			};
+
+			struct Placement
+			{
+				uint64_t offset;
+				// True if the memory was used by an earlier resource, in which case the first use has to
+				// fully initialize the resource (clear, discard or full overwrite).
+				bool aliased;
+			};
+
+			// Before a pass starts using an aliased resource, the previous owners of its memory have to
+			// be retired with an aliasing barrier. before is None when several resources are retired at once.
+			struct AliasingBarrier
+			{
+				uint32_t pass;
+				uint32_t before;
+				uint32_t after;
+			};
+
+		private:
+			vector<Resource> m_resources;
+			vector<Placement> m_placements;
+			vector<AliasingBarrier> m_barriers;
+			uint64_t m_heapSize = 0;
+			uint64_t m_heapAlignment = 1;
+
+		private:
+			static bool LifetimesOverlap(const Resource& a, const Resource& b)
+			{
+				return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+			}
+
+		public:
+			void Clear();
+			uint32_t Add(const Resource& resource);
+
+			// Assigns offsets with a first-fit over the live ranges, largest resources first, and derives
+			// the aliasing barriers ordered by pass. The heap never needs more than GetUnaliasedSize.
+			void Compile();
+
+			uint32_t GetResourceCount() const { return static_cast<uint32_t>(m_resources.size()); }
+			const Resource& GetResource(uint32_t index) const { return m_resources[index]; }
+			const Placement& GetPlacement(uint32_t index) const { return m_placements[index]; }
+			const vector<AliasingBarrier>& GetBarriers() const { return m_barriers; }
+
+			uint64_t GetHeapSize() const { return m_heapSize; }
+			uint64_t GetHeapAlignment() const { return m_heapAlignment; }
+			// Memory the resources would need without aliasing, for comparison.
+			uint64_t GetUnaliasedSize() const;
+		};
+	}
+}
@@ -0,0 +1,136 @@
+#include "pch.h"
+#include "TransientResourcePool.h"
+
+namespace Query {
+	namespace Memory
+	{
+		void TransientResourcePool::Initialize(ID3D12Device* device, HeapManager* heapManager)
+		{
+			Release();
+			m_device = device;
+			m_heapManager = heapManager;
+		}
+
+		UINT TransientResourcePool::Declare(
+			const D3D12_RESOURCE_DESC& desc,
+			D3D12_RESOURCE_STATES initialState,
+			const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+			UINT firstPass, UINT lastPass)
+		{
+			Entry entry = {};
+			entry.desc = desc;
+			entry.initialState = initialState;
+			entry.hasClearValue = pOptimizedClearValue != nullptr;
+			if (entry.hasClearValue) entry.clearValue = *pOptimizedClearValue;
+			entry.firstPass = firstPass;
+			entry.lastPass = lastPass;
+			entry.category = HeapManager::GetCategory(desc);
+
+			m_entries.push_back(entry);
+			return static_cast<UINT>(m_entries.size() - 1);
+		}
+
+		HRESULT TransientResourcePool::Compile()
+		{
+			UINT passCount = 0;
+			for (auto& aliaser : m_aliasers) aliaser.Clear();
+
+			for (auto& entry : m_entries)
+			{
+				D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &entry.desc);
+				entry.aliasIndex = m_aliasers[entry.category].Add({ info.SizeInBytes, info.Alignment, entry.firstPass, entry.lastPass });
+				if (entry.lastPass + 1 > passCount) passCount = entry.lastPass + 1;
+			}
+
+			// Map the aliaser's per-category indices back to pool ids.
+			vector<UINT> ids[HeapManager::CategoryCount];
+			for (UINT id = 0; id < m_entries.size(); id++)
+			{
+				ids[m_entries[id].category].push_back(id);
+			}
+
+			m_passBarriers.assign(passCount, {});
+			for (UINT category = 0; category < HeapManager::CategoryCount; category++)
+			{
+				TransientAliaser& aliaser = m_aliasers[category];
+				if (aliaser.GetResourceCount() == 0)
+				{
+					continue;
+				}
+				aliaser.Compile();
+
+				const Entry& first = m_entries[ids[category][0]];
+				HeapManager::Allocation& allocation = m_allocations[category];
+				m_heapManager->Free(allocation);
+				if (!m_heapManager->Allocate(D3D12_HEAP_TYPE_DEFAULT, first.desc, aliaser.GetHeapSize(), aliaser.GetHeapAlignment(), allocation))
+				{
+					return E_OUTOFMEMORY;
+				}
+
+				ID3D12Heap* heap = m_heapManager->GetHeap(allocation);
+				UINT64 baseOffset = m_heapManager->GetOffset(allocation);
+				for (UINT id : ids[category])
+				{
+					Entry& entry = m_entries[id];
+					entry.resource.Reset();
+					HRESULT hr = m_device->CreatePlacedResource(
+						heap, baseOffset + aliaser.GetPlacement(entry.aliasIndex).offset,
+						&entry.desc, entry.initialState,
+						entry.hasClearValue ? &entry.clearValue : nullptr,
+						IID_PPV_ARGS(&entry.resource));
+					if (FAILED(hr))
+					{
+						return hr;
+					}
+				}
+
+				for (auto& barrier : aliaser.GetBarriers())
+				{
+					ID3D12Resource* before = barrier.before == TransientAliaser::None ? nullptr : m_entries[ids[category][barrier.before]].resource.Get();
+					ID3D12Resource* after = m_entries[ids[category][barrier.after]].resource.Get();
+					m_passBarriers[barrier.pass].push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(before, after));
+				}
+			}
+			return S_OK;
+		}
+
+		bool TransientResourcePool::IsAliased(UINT id) const
+		{
+			const Entry& entry = m_entries[id];
+			return m_aliasers[entry.category].GetPlacement(entry.aliasIndex).aliased;
+		}
+
+		void TransientResourcePool::AliasingBarriers(ID3D12GraphicsCommandList* commandList, UINT pass) const
+		{
+			if (pass < m_passBarriers.size() && !m_passBarriers[pass].empty())
+			{
+				commandList->ResourceBarrier(static_cast<UINT>(m_passBarriers[pass].size()), m_passBarriers[pass].data());
+			}
+		}
+
+		UINT64 TransientResourcePool::GetHeapSize() const
+		{
+			UINT64 size = 0;
+			for (auto& aliaser : m_aliasers) size += aliaser.GetHeapSize();
+			return size;
+		}
+
+		UINT64 TransientResourcePool::GetUnaliasedSize() const
+		{
+			UINT64 size = 0;
+			for (auto& aliaser : m_aliasers) size += aliaser.GetUnaliasedSize();
+			return size;
+		}
+
+		void TransientResourcePool::Release()
+		{
+			m_passBarriers.clear();
+			m_entries.clear();
+			for (auto& aliaser : m_aliasers) aliaser.Clear();
+			if (m_heapManager)
+			{
+				for (auto& allocation : m_allocations) m_heapManager->Free(allocation);
+			}
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "HeapManager.h"
+#include "TransientAliaser.h"
+
+namespace Query {
+	namespace Memory
+	{
+		// Per-frame render targets and depth buffers declared by the passes that use them. Resources
+		// whose pass ranges do not overlap are placed at the same heap offset, and the aliasing
+		// barriers needed to switch between them are recorded at the start of each pass.
+		class TransientResourcePool
+		{
+		private:
+			struct Entry
+			{
+				D3D12_RESOURCE_DESC desc;
+				D3D12_RESOURCE_STATES initialState;
+				D3D12_CLEAR_VALUE clearValue;
+				bool hasClearValue;
+				UINT firstPass, lastPass;
+				HeapManager::ResourceCategory category;
+				UINT aliasIndex;
+				ComPtr<ID3D12Resource> resource;
+			};
+
+			ComPtr<ID3D12Device> m_device;
+			HeapManager* m_heapManager = nullptr;
+
+			vector<Entry> m_entries;
+			TransientAliaser m_aliasers[HeapManager::CategoryCount];
+			HeapManager::Allocation m_allocations[HeapManager::CategoryCount];
+			vector<vector<D3D12_RESOURCE_BARRIER>> m_passBarriers;
+
+		public:
+			~TransientResourcePool() { Release(); }
+
+			void Initialize(ID3D12Device* device, HeapManager* heapManager);
+
+			// Returns the id used with GetResource. Declarations are collected until Compile.
+			UINT Declare(
+				const D3D12_RESOURCE_DESC& desc,
+				D3D12_RESOURCE_STATES initialState,
+				const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+				UINT firstPass, UINT lastPass);
+
+			// Runs the lifetime analysis, reserves one heap range per resource category and places
+			// every declared resource into it.
+			HRESULT Compile();
+
+			ID3D12Resource* GetResource(UINT id) const { return m_entries[id].resource.Get(); }
+			bool IsAliased(UINT id) const;
+
+			// Records the aliasing barriers that have to precede the given pass.
+			void AliasingBarriers(ID3D12GraphicsCommandList* commandList, UINT pass) const;
+
+			// Heap memory actually reserved, and what the same resources would take unaliased.
+			UINT64 GetHeapSize() const;
+			UINT64 GetUnaliasedSize() const;
+
+			// Releases the resources and their heap ranges; the declarations are dropped as well.
+			void Release();
+		};
+	}
+}
@@ -16,6 +16,18 @@
 
 #if defined( __cplusplus )
 
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define D3DX12_STREAMING_STORES 1
+#else
+#define D3DX12_STREAMING_STORES 0
+#endif
+
 struct CD3DX12_DEFAULT {};
 extern const DECLSPEC_SELECTANY CD3DX12_DEFAULT D3D12_DEFAULT;
 
@@ -1849,27 +1861,193 @@ struct CD3DX12_VIEW_INSTANCING_DESC : public D3D12_VIEW_INSTANCING_DESC
 };
 
 //------------------------------------------------------------------------------------------------
-// Row-by-row memcpy
-inline void MemcpySubresource(
+// The rows of subresources of at least this many bytes are copied with streaming stores. Upload
+// heaps are write-combined on most adapters; streaming stores fill them in whole cache lines and do
+// not evict the source data. Smaller copies are left to memcpy, which is faster while the data fits
+// in cache, and so are blocks of this size or more: memcpy streams those itself, and measured faster
+// on whole buffers and packed textures.
+#ifndef D3DX12_STREAMING_COPY_THRESHOLD
+#define D3DX12_STREAMING_COPY_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+// The ParallelFor overloads split subresources of at least D3DX12_PARALLEL_COPY_THRESHOLD bytes
+// into chunks of whole rows, D3DX12_PARALLEL_COPY_CHUNK bytes or more each.
+#ifndef D3DX12_PARALLEL_COPY_THRESHOLD
+#define D3DX12_PARALLEL_COPY_THRESHOLD (16 * 1024 * 1024)
+#endif
+#ifndef D3DX12_PARALLEL_COPY_CHUNK
+#define D3DX12_PARALLEL_COPY_CHUNK (4 * 1024 * 1024)
+#endif
+
+//------------------------------------------------------------------------------------------------
+// memcpy with non-temporal stores. The stores are weakly ordered: call D3DX12StreamingFence on
+// the same thread before the data is handed to the GPU or to another thread.
+inline void D3DX12MemcpyStreaming(
+    _Out_writes_bytes_(Size) void* pDest,
+    _In_reads_bytes_(Size) const void* pSrc,
+    SIZE_T Size)
+{
+#if D3DX12_STREAMING_STORES
+    BYTE* pDestBytes = reinterpret_cast<BYTE*>(pDest);
+    const BYTE* pSrcBytes = reinterpret_cast<const BYTE*>(pSrc);
+    SIZE_T Head = (16 - (reinterpret_cast<UINT_PTR>(pDestBytes) & 15)) & 15;
+    Head = Head < Size ? Head : Size;
+    memcpy(pDestBytes, pSrcBytes, Head);
+    pDestBytes += Head;
+    pSrcBytes += Head;
+    Size -= Head;
+    for (; Size >= 64; Size -= 64, pDestBytes += 64, pSrcBytes += 64)
+    {
+        __m128i Data0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcBytes));
+        __m128i Data1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcBytes + 16));
+        __m128i Data2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcBytes + 32));
+        __m128i Data3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcBytes + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDestBytes), Data0);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDestBytes + 16), Data1);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDestBytes + 32), Data2);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pDestBytes + 48), Data3);
+    }
+    memcpy(pDestBytes, pSrcBytes, Size);
+#else
+    memcpy(pDest, pSrc, Size);
+#endif
+}
+
+//------------------------------------------------------------------------------------------------
+inline void D3DX12StreamingFence()
+{
+#if D3DX12_STREAMING_STORES
+    _mm_sfence();
+#endif
+}
+
+//------------------------------------------------------------------------------------------------
+// Copies rows [FirstRow, FirstRow + RowCount) of a subresource, counting the rows of all slices
+// in order. Rows that follow each other in both source and destination are copied as one block.
+// Streaming applies to blocks smaller than D3DX12_STREAMING_COPY_THRESHOLD only.
+inline void MemcpySubresourceRows(
     _In_ const D3D12_MEMCPY_DEST* pDest,
     _In_ const D3D12_SUBRESOURCE_DATA* pSrc,
     SIZE_T RowSizeInBytes,
     UINT NumRows,
-    UINT NumSlices)
+    UINT64 FirstRow,
+    UINT64 RowCount,
+    bool Streaming)
 {
-    for (UINT z = 0; z < NumSlices; ++z)
+    if (NumRows == 0 || RowCount == 0)
+    {
+        return;
+    }
+    auto Copy = [Streaming](void* pTo, const void* pFrom, SIZE_T Size)
+    {
+        if (Streaming && Size < D3DX12_STREAMING_COPY_THRESHOLD)
+        {
+            D3DX12MemcpyStreaming(pTo, pFrom, Size);
+        }
+        else
+        {
+            memcpy(pTo, pFrom, Size);
+        }
+    };
+    const bool PackedRows = pDest->RowPitch == RowSizeInBytes && pSrc->RowPitch == LONG_PTR(RowSizeInBytes);
+    const SIZE_T SliceSize = RowSizeInBytes * NumRows;
+    if (PackedRows && pDest->SlicePitch == SliceSize && pSrc->SlicePitch == LONG_PTR(SliceSize))
+    {
+        Copy(reinterpret_cast<BYTE*>(pDest->pData) + RowSizeInBytes * FirstRow,
+             reinterpret_cast<const BYTE*>(pSrc->pData) + LONG_PTR(RowSizeInBytes * FirstRow),
+             SIZE_T(RowSizeInBytes * RowCount));
+        return;
+    }
+
+    const UINT64 EndRow = FirstRow + RowCount;
+    for (UINT64 Row = FirstRow; Row < EndRow;)
     {
+        const UINT z = UINT(Row / NumRows);
+        const UINT y = UINT(Row % NumRows);
+        const UINT64 SliceEnd = UINT64(z + 1) * NumRows;
+        const UINT Rows = UINT((EndRow < SliceEnd ? EndRow : SliceEnd) - Row);
         BYTE* pDestSlice = reinterpret_cast<BYTE*>(pDest->pData) + pDest->SlicePitch * z;
         const BYTE* pSrcSlice = reinterpret_cast<const BYTE*>(pSrc->pData) + pSrc->SlicePitch * z;
-        for (UINT y = 0; y < NumRows; ++y)
+        if (PackedRows)
         {
-            memcpy(pDestSlice + pDest->RowPitch * y,
-                   pSrcSlice + pSrc->RowPitch * y,
-                   RowSizeInBytes);
+            Copy(pDestSlice + RowSizeInBytes * y, pSrcSlice + LONG_PTR(RowSizeInBytes * y), RowSizeInBytes * Rows);
         }
+        else
+        {
+            for (UINT i = y; i < y + Rows; ++i)
+            {
+                Copy(pDestSlice + pDest->RowPitch * i,
+                     pSrcSlice + pSrc->RowPitch * i,
+                     RowSizeInBytes);
+            }
+        }
+        Row += Rows;
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Row-by-row memcpy, one block when the rows are packed, streaming stores for the rows of large
+// pitched subresources
+inline void MemcpySubresource(
+    _In_ const D3D12_MEMCPY_DEST* pDest,
+    _In_ const D3D12_SUBRESOURCE_DATA* pSrc,
+    SIZE_T RowSizeInBytes,
+    UINT NumRows,
+    UINT NumSlices)
+{
+    const UINT64 TotalRows = UINT64(NumRows) * NumSlices;
+    const bool Streaming = RowSizeInBytes * TotalRows >= D3DX12_STREAMING_COPY_THRESHOLD;
+    MemcpySubresourceRows(pDest, pSrc, RowSizeInBytes, NumRows, 0, TotalRows, Streaming);
+    if (Streaming)
+    {
+        D3DX12StreamingFence();
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// ParallelFor(Count, Body) must call Body(i) once for every i in [0, Count), on any threads, and
+// return after all calls have returned.
+template <typename TParallelFor>
+inline void MemcpySubresource(
+    _In_ const D3D12_MEMCPY_DEST* pDest,
+    _In_ const D3D12_SUBRESOURCE_DATA* pSrc,
+    SIZE_T RowSizeInBytes,
+    UINT NumRows,
+    UINT NumSlices,
+    TParallelFor&& ParallelFor)
+{
+    const UINT64 TotalRows = UINT64(NumRows) * NumSlices;
+    if (RowSizeInBytes == 0 || RowSizeInBytes * TotalRows < D3DX12_PARALLEL_COPY_THRESHOLD)
+    {
+        MemcpySubresource(pDest, pSrc, RowSizeInBytes, NumRows, NumSlices);
+        return;
     }
+
+    const UINT64 RowsPerChunk = (D3DX12_PARALLEL_COPY_CHUNK + RowSizeInBytes - 1) / RowSizeInBytes;
+    const UINT ChunkCount = UINT((TotalRows + RowsPerChunk - 1) / RowsPerChunk);
+    ParallelFor(ChunkCount, [&](UINT Chunk)
+    {
+        const UINT64 FirstRow = RowsPerChunk * Chunk;
+        const UINT64 RowCount = TotalRows - FirstRow < RowsPerChunk ? TotalRows - FirstRow : RowsPerChunk;
+        MemcpySubresourceRows(pDest, pSrc, RowSizeInBytes, NumRows, FirstRow, RowCount, true);
+        D3DX12StreamingFence();
+    });
 }
 
+//------------------------------------------------------------------------------------------------
+// ParallelFor for the UpdateSubresources overloads that take none
+struct CD3DX12_SERIAL_FOR
+{
+    template <typename TBody>
+    void operator()(UINT Count, TBody&& Body) const
+    {
+        for (UINT i = 0; i < Count; ++i)
+        {
+            Body(i);
+        }
+    }
+};
+
 //------------------------------------------------------------------------------------------------
 // Returns required size of a buffer to be used for data upload
 inline UINT64 GetRequiredIntermediateSize(
@@ -1889,7 +2067,9 @@ inline UINT64 GetRequiredIntermediateSize(
 }
 
 //------------------------------------------------------------------------------------------------
-// All arrays must be populated (e.g. by calling GetCopyableFootprints)
+// All arrays must be populated (e.g. by calling GetCopyableFootprints). Large subresources are
+// copied through ParallelFor, see MemcpySubresource.
+template <typename TParallelFor>
 inline UINT64 UpdateSubresources(
     _In_ ID3D12GraphicsCommandList* pCmdList,
     _In_ ID3D12Resource* pDestinationResource,
@@ -1900,7 +2080,8 @@ inline UINT64 UpdateSubresources(
     _In_reads_(NumSubresources) const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts,
     _In_reads_(NumSubresources) const UINT* pNumRows,
     _In_reads_(NumSubresources) const UINT64* pRowSizesInBytes,
-    _In_reads_(NumSubresources) const D3D12_SUBRESOURCE_DATA* pSrcData)
+    _In_reads_(NumSubresources) const D3D12_SUBRESOURCE_DATA* pSrcData,
+    TParallelFor&& ParallelFor)
 {
     // Minor validation
     auto IntermediateDesc = pIntermediate->GetDesc();
@@ -1925,7 +2106,7 @@ inline UINT64 UpdateSubresources(
     {
         if (pRowSizesInBytes[i] > SIZE_T(-1)) return 0;
         D3D12_MEMCPY_DEST DestData = { pData + pLayouts[i].Offset, pLayouts[i].Footprint.RowPitch, SIZE_T(pLayouts[i].Footprint.RowPitch) * SIZE_T(pNumRows[i]) };
-        MemcpySubresource(&DestData, &pSrcData[i], static_cast<SIZE_T>(pRowSizesInBytes[i]), pNumRows[i], pLayouts[i].Footprint.Depth);
+        MemcpySubresource(&DestData, &pSrcData[i], static_cast<SIZE_T>(pRowSizesInBytes[i]), pNumRows[i], pLayouts[i].Footprint.Depth, ParallelFor);
     }
     pIntermediate->Unmap(0, nullptr);
     
@@ -1946,8 +2127,49 @@ inline UINT64 UpdateSubresources(
     return RequiredSize;
 }
 
+//------------------------------------------------------------------------------------------------
+// All arrays must be populated (e.g. by calling GetCopyableFootprints)
+inline UINT64 UpdateSubresources(
+    _In_ ID3D12GraphicsCommandList* pCmdList,
+    _In_ ID3D12Resource* pDestinationResource,
+    _In_ ID3D12Resource* pIntermediate,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES) UINT FirstSubresource,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES-FirstSubresource) UINT NumSubresources,
+    UINT64 RequiredSize,
+    _In_reads_(NumSubresources) const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts,
+    _In_reads_(NumSubresources) const UINT* pNumRows,
+    _In_reads_(NumSubresources) const UINT64* pRowSizesInBytes,
+    _In_reads_(NumSubresources) const D3D12_SUBRESOURCE_DATA* pSrcData)
+{
+    return UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, FirstSubresource, NumSubresources, RequiredSize, pLayouts, pNumRows, pRowSizesInBytes, pSrcData, CD3DX12_SERIAL_FOR());
+}
+
+//------------------------------------------------------------------------------------------------
+// Scratch memory for the UpdateSubresources overloads that take an arena. Allocate returns nullptr
+// when out of memory; the arena reclaims the memory on its own schedule, e.g. once per frame.
+struct ID3DX12ScratchArena
+{
+    virtual void* Allocate(SIZE_T Size, SIZE_T Alignment) = 0;
+
+protected:
+    ~ID3DX12ScratchArena() = default;
+};
+
+//------------------------------------------------------------------------------------------------
+// Exposes any arena with a void* Allocate(size, alignment) member as an ID3DX12ScratchArena
+template <typename TArena>
+struct CD3DX12_SCRATCH_ARENA : public ID3DX12ScratchArena
+{
+    TArena& Arena;
+
+    explicit CD3DX12_SCRATCH_ARENA(TArena& InArena) : Arena(InArena) {}
+    void* Allocate(SIZE_T Size, SIZE_T Alignment) override { return Arena.Allocate(Size, Alignment); }
+};
+
 //------------------------------------------------------------------------------------------------
 // Heap-allocating UpdateSubresources implementation
+template <typename TParallelFor,
+    typename = typename std::enable_if<!std::is_convertible<TParallelFor, ID3DX12ScratchArena*>::value>::type>
 inline UINT64 UpdateSubresources( 
     _In_ ID3D12GraphicsCommandList* pCmdList,
     _In_ ID3D12Resource* pDestinationResource,
@@ -1955,7 +2177,8 @@ inline UINT64 UpdateSubresources(
     UINT64 IntermediateOffset,
     _In_range_(0,D3D12_REQ_SUBRESOURCES) UINT FirstSubresource,
     _In_range_(0,D3D12_REQ_SUBRESOURCES-FirstSubresource) UINT NumSubresources,
-    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData)
+    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData,
+    TParallelFor&& ParallelFor)
 {
     UINT64 RequiredSize = 0;
     UINT64 MemToAlloc = static_cast<UINT64>(sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) + sizeof(UINT) + sizeof(UINT64)) * NumSubresources;
@@ -1978,14 +2201,82 @@ inline UINT64 UpdateSubresources(
     pDevice->GetCopyableFootprints(&Desc, FirstSubresource, NumSubresources, IntermediateOffset, pLayouts, pNumRows, pRowSizesInBytes, &RequiredSize);
     pDevice->Release();
     
-    UINT64 Result = UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, FirstSubresource, NumSubresources, RequiredSize, pLayouts, pNumRows, pRowSizesInBytes, pSrcData);
+    UINT64 Result = UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, FirstSubresource, NumSubresources, RequiredSize, pLayouts, pNumRows, pRowSizesInBytes, pSrcData, ParallelFor);
     HeapFree(GetProcessHeap(), 0, pMem);
     return Result;
 }
 
+//------------------------------------------------------------------------------------------------
+// Heap-allocating UpdateSubresources implementation
+inline UINT64 UpdateSubresources( 
+    _In_ ID3D12GraphicsCommandList* pCmdList,
+    _In_ ID3D12Resource* pDestinationResource,
+    _In_ ID3D12Resource* pIntermediate,
+    UINT64 IntermediateOffset,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES) UINT FirstSubresource,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES-FirstSubresource) UINT NumSubresources,
+    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData)
+{
+    return UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, IntermediateOffset, FirstSubresource, NumSubresources, pSrcData, CD3DX12_SERIAL_FOR());
+}
+
+//------------------------------------------------------------------------------------------------
+// Arena-allocating UpdateSubresources implementation, for subresource counts too large for the
+// stack without a heap allocation per call
+template <typename TParallelFor>
+inline UINT64 UpdateSubresources( 
+    _In_ ID3D12GraphicsCommandList* pCmdList,
+    _In_ ID3D12Resource* pDestinationResource,
+    _In_ ID3D12Resource* pIntermediate,
+    UINT64 IntermediateOffset,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES) UINT FirstSubresource,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES-FirstSubresource) UINT NumSubresources,
+    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData,
+    _In_ ID3DX12ScratchArena* pArena,
+    TParallelFor&& ParallelFor)
+{
+    UINT64 RequiredSize = 0;
+    UINT64 MemToAlloc = static_cast<UINT64>(sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) + sizeof(UINT) + sizeof(UINT64)) * NumSubresources;
+    if (MemToAlloc > SIZE_MAX)
+    {
+       return 0;
+    }
+    void* pMem = pArena->Allocate(static_cast<SIZE_T>(MemToAlloc), alignof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT));
+    if (pMem == nullptr)
+    {
+       return 0;
+    }
+    auto pLayouts = reinterpret_cast<D3D12_PLACED_SUBRESOURCE_FOOTPRINT*>(pMem);
+    UINT64* pRowSizesInBytes = reinterpret_cast<UINT64*>(pLayouts + NumSubresources);
+    UINT* pNumRows = reinterpret_cast<UINT*>(pRowSizesInBytes + NumSubresources);
+    
+    auto Desc = pDestinationResource->GetDesc();
+    ID3D12Device* pDevice = nullptr;
+    pDestinationResource->GetDevice(__uuidof(*pDevice), reinterpret_cast<void**>(&pDevice));
+    pDevice->GetCopyableFootprints(&Desc, FirstSubresource, NumSubresources, IntermediateOffset, pLayouts, pNumRows, pRowSizesInBytes, &RequiredSize);
+    pDevice->Release();
+    
+    return UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, FirstSubresource, NumSubresources, RequiredSize, pLayouts, pNumRows, pRowSizesInBytes, pSrcData, ParallelFor);
+}
+
+//------------------------------------------------------------------------------------------------
+// Arena-allocating UpdateSubresources implementation
+inline UINT64 UpdateSubresources( 
+    _In_ ID3D12GraphicsCommandList* pCmdList,
+    _In_ ID3D12Resource* pDestinationResource,
+    _In_ ID3D12Resource* pIntermediate,
+    UINT64 IntermediateOffset,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES) UINT FirstSubresource,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES-FirstSubresource) UINT NumSubresources,
+    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData,
+    _In_ ID3DX12ScratchArena* pArena)
+{
+    return UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, IntermediateOffset, FirstSubresource, NumSubresources, pSrcData, pArena, CD3DX12_SERIAL_FOR());
+}
+
 //------------------------------------------------------------------------------------------------
 // Stack-allocating UpdateSubresources implementation
-template <UINT MaxSubresources>
+template <UINT MaxSubresources, typename TParallelFor>
 inline UINT64 UpdateSubresources( 
     _In_ ID3D12GraphicsCommandList* pCmdList,
     _In_ ID3D12Resource* pDestinationResource,
@@ -1993,7 +2284,8 @@ inline UINT64 UpdateSubresources(
     UINT64 IntermediateOffset,
     _In_range_(0, MaxSubresources) UINT FirstSubresource,
     _In_range_(1, MaxSubresources - FirstSubresource) UINT NumSubresources,
-    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData)
+    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData,
+    TParallelFor&& ParallelFor)
 {
     UINT64 RequiredSize = 0;
     D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layouts[MaxSubresources];
@@ -2006,7 +2298,22 @@ inline UINT64 UpdateSubresources(
     pDevice->GetCopyableFootprints(&Desc, FirstSubresource, NumSubresources, IntermediateOffset, Layouts, NumRows, RowSizesInBytes, &RequiredSize);
     pDevice->Release();
     
-    return UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, FirstSubresource, NumSubresources, RequiredSize, Layouts, NumRows, RowSizesInBytes, pSrcData);
+    return UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, FirstSubresource, NumSubresources, RequiredSize, Layouts, NumRows, RowSizesInBytes, pSrcData, ParallelFor);
+}
+
+//------------------------------------------------------------------------------------------------
+// Stack-allocating UpdateSubresources implementation
+template <UINT MaxSubresources>
+inline UINT64 UpdateSubresources( 
+    _In_ ID3D12GraphicsCommandList* pCmdList,
+    _In_ ID3D12Resource* pDestinationResource,
+    _In_ ID3D12Resource* pIntermediate,
+    UINT64 IntermediateOffset,
+    _In_range_(0, MaxSubresources) UINT FirstSubresource,
+    _In_range_(1, MaxSubresources - FirstSubresource) UINT NumSubresources,
+    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData)
+{
+    return UpdateSubresources<MaxSubresources>(pCmdList, pDestinationResource, pIntermediate, IntermediateOffset, FirstSubresource, NumSubresources, pSrcData, CD3DX12_SERIAL_FOR());
 }
 
 //------------------------------------------------------------------------------------------------
@@ -2144,6 +2451,251 @@ inline HRESULT D3DX12SerializeVersionedRootSignature(
     return E_INVALIDARG;
 }
 
+//------------------------------------------------------------------------------------------------
+// Calls Visit(UINT) for every field of a versioned root signature description that affects its
+// serialization, pointers excluded, in a fixed order.
+template <typename TVisit>
+inline void D3DX12VisitRootSignatureDesc(
+    _In_ const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc,
+    TVisit&& Visit)
+{
+    auto VisitFloat = [&Visit](FLOAT Value)
+    {
+        UINT Bits;
+        memcpy(&Bits, &Value, sizeof(Bits));
+        Visit(Bits);
+    };
+    auto VisitSamplers = [&](UINT NumStaticSamplers, const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers)
+    {
+        Visit(NumStaticSamplers);
+        for (UINT n = 0; n < NumStaticSamplers; n++)
+        {
+            const D3D12_STATIC_SAMPLER_DESC& Sampler = pStaticSamplers[n];
+            Visit(Sampler.Filter);
+            Visit(Sampler.AddressU);
+            Visit(Sampler.AddressV);
+            Visit(Sampler.AddressW);
+            VisitFloat(Sampler.MipLODBias);
+            Visit(Sampler.MaxAnisotropy);
+            Visit(Sampler.ComparisonFunc);
+            Visit(Sampler.BorderColor);
+            VisitFloat(Sampler.MinLOD);
+            VisitFloat(Sampler.MaxLOD);
+            Visit(Sampler.ShaderRegister);
+            Visit(Sampler.RegisterSpace);
+            Visit(Sampler.ShaderVisibility);
+        }
+    };
+
+    Visit(pRootSignatureDesc->Version);
+    if (pRootSignatureDesc->Version == D3D_ROOT_SIGNATURE_VERSION_1_0)
+    {
+        const D3D12_ROOT_SIGNATURE_DESC& Desc = pRootSignatureDesc->Desc_1_0;
+        Visit(Desc.Flags);
+        Visit(Desc.NumParameters);
+        for (UINT n = 0; n < Desc.NumParameters; n++)
+        {
+            const D3D12_ROOT_PARAMETER& Parameter = Desc.pParameters[n];
+            Visit(Parameter.ParameterType);
+            Visit(Parameter.ShaderVisibility);
+            switch (Parameter.ParameterType)
+            {
+            case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+                Visit(Parameter.DescriptorTable.NumDescriptorRanges);
+                for (UINT x = 0; x < Parameter.DescriptorTable.NumDescriptorRanges; x++)
+                {
+                    const D3D12_DESCRIPTOR_RANGE& Range = Parameter.DescriptorTable.pDescriptorRanges[x];
+                    Visit(Range.RangeType);
+                    Visit(Range.NumDescriptors);
+                    Visit(Range.BaseShaderRegister);
+                    Visit(Range.RegisterSpace);
+                    Visit(Range.OffsetInDescriptorsFromTableStart);
+                }
+                break;
+            case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+                Visit(Parameter.Constants.ShaderRegister);
+                Visit(Parameter.Constants.RegisterSpace);
+                Visit(Parameter.Constants.Num32BitValues);
+                break;
+            default:
+                Visit(Parameter.Descriptor.ShaderRegister);
+                Visit(Parameter.Descriptor.RegisterSpace);
+                break;
+            }
+        }
+        VisitSamplers(Desc.NumStaticSamplers, Desc.pStaticSamplers);
+    }
+    else
+    {
+        const D3D12_ROOT_SIGNATURE_DESC1& Desc = pRootSignatureDesc->Desc_1_1;
+        Visit(Desc.Flags);
+        Visit(Desc.NumParameters);
+        for (UINT n = 0; n < Desc.NumParameters; n++)
+        {
+            const D3D12_ROOT_PARAMETER1& Parameter = Desc.pParameters[n];
+            Visit(Parameter.ParameterType);
+            Visit(Parameter.ShaderVisibility);
+            switch (Parameter.ParameterType)
+            {
+            case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+                Visit(Parameter.DescriptorTable.NumDescriptorRanges);
+                for (UINT x = 0; x < Parameter.DescriptorTable.NumDescriptorRanges; x++)
+                {
+                    const D3D12_DESCRIPTOR_RANGE1& Range = Parameter.DescriptorTable.pDescriptorRanges[x];
+                    Visit(Range.RangeType);
+                    Visit(Range.NumDescriptors);
+                    Visit(Range.BaseShaderRegister);
+                    Visit(Range.RegisterSpace);
+                    Visit(Range.Flags);
+                    Visit(Range.OffsetInDescriptorsFromTableStart);
+                }
+                break;
+            case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+                Visit(Parameter.Constants.ShaderRegister);
+                Visit(Parameter.Constants.RegisterSpace);
+                Visit(Parameter.Constants.Num32BitValues);
+                break;
+            default:
+                Visit(Parameter.Descriptor.ShaderRegister);
+                Visit(Parameter.Descriptor.RegisterSpace);
+                Visit(Parameter.Descriptor.Flags);
+                break;
+            }
+        }
+        VisitSamplers(Desc.NumStaticSamplers, Desc.pStaticSamplers);
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Serialized root signatures keyed by a hash of the description's content and the target version,
+// so that the 1.1 to 1.0 conversion and the serialization run once per distinct signature for the
+// life of the cache. Lookups compare the whole description, so a hash collision cannot return
+// another signature's blob, and do not allocate. Thread-safe. The cache keeps a reference to every
+// blob until it is destroyed; failed serializations are not cached.
+class CD3DX12_ROOT_SIGNATURE_CACHE
+{
+private:
+    struct Entry
+    {
+        std::vector<UINT> Key;
+        ID3DBlob* pBlob;
+    };
+
+    std::mutex m_Mutex;
+    std::unordered_multimap<UINT64, Entry> m_Entries;
+
+    static UINT64 Hash(_In_ const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION MaxVersion)
+    {
+        // FNV-1a, one word at a time; Matches settles collisions
+        UINT64 State = 14695981039346656037ull;
+        auto Add = [&State](UINT Value)
+        {
+            State = (State ^ Value) * 1099511628211ull;
+        };
+        Add(MaxVersion);
+        D3DX12VisitRootSignatureDesc(pRootSignatureDesc, Add);
+        return State;
+    }
+
+    static bool Matches(const Entry& Cached, _In_ const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION MaxVersion)
+    {
+        SIZE_T Index = 0;
+        bool Equal = !Cached.Key.empty() && Cached.Key[Index++] == UINT(MaxVersion);
+        D3DX12VisitRootSignatureDesc(pRootSignatureDesc, [&](UINT Value)
+        {
+            Equal = Equal && Index < Cached.Key.size() && Cached.Key[Index++] == Value;
+        });
+        return Equal && Index == Cached.Key.size();
+    }
+
+public:
+    CD3DX12_ROOT_SIGNATURE_CACHE() = default;
+    CD3DX12_ROOT_SIGNATURE_CACHE(const CD3DX12_ROOT_SIGNATURE_CACHE&) = delete;
+    CD3DX12_ROOT_SIGNATURE_CACHE& operator=(const CD3DX12_ROOT_SIGNATURE_CACHE&) = delete;
+    ~CD3DX12_ROOT_SIGNATURE_CACHE() { Clear(); }
+
+    // Same contract as D3DX12SerializeVersionedRootSignature; the returned blob is AddRef'd.
+    HRESULT Serialize(
+        _In_ const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc,
+        D3D_ROOT_SIGNATURE_VERSION MaxVersion,
+        _Outptr_ ID3DBlob** ppBlob,
+        _Always_(_Outptr_opt_result_maybenull_) ID3DBlob** ppErrorBlob)
+    {
+        if (ppErrorBlob != nullptr)
+        {
+            *ppErrorBlob = nullptr;
+        }
+
+        const UINT64 Key = Hash(pRootSignatureDesc, MaxVersion);
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            auto Range = m_Entries.equal_range(Key);
+            for (auto it = Range.first; it != Range.second; ++it)
+            {
+                if (Matches(it->second, pRootSignatureDesc, MaxVersion))
+                {
+                    it->second.pBlob->AddRef();
+                    *ppBlob = it->second.pBlob;
+                    return S_OK;
+                }
+            }
+        }
+
+        // Serialized outside the lock; a thread that loses the race keeps its own blob uncached.
+        HRESULT hr = D3DX12SerializeVersionedRootSignature(pRootSignatureDesc, MaxVersion, ppBlob, ppErrorBlob);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        Entry Cached;
+        Cached.Key.push_back(MaxVersion);
+        D3DX12VisitRootSignatureDesc(pRootSignatureDesc, [&Cached](UINT Value) { Cached.Key.push_back(Value); });
+        Cached.pBlob = *ppBlob;
+
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        auto Range = m_Entries.equal_range(Key);
+        for (auto it = Range.first; it != Range.second; ++it)
+        {
+            if (it->second.Key == Cached.Key)
+            {
+                return hr;
+            }
+        }
+        Cached.pBlob->AddRef();
+        m_Entries.emplace(Key, std::move(Cached));
+        return hr;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        for (auto& Cached : m_Entries)
+        {
+            Cached.second.pBlob->Release();
+        }
+        m_Entries.clear();
+    }
+
+    SIZE_T GetSize()
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        return m_Entries.size();
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// D3DX12SerializeVersionedRootSignature through a conversion cache
+inline HRESULT D3DX12SerializeVersionedRootSignature(
+    _In_ const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc,
+    D3D_ROOT_SIGNATURE_VERSION MaxVersion,
+    _Outptr_ ID3DBlob** ppBlob,
+    _Always_(_Outptr_opt_result_maybenull_) ID3DBlob** ppErrorBlob,
+    _In_ CD3DX12_ROOT_SIGNATURE_CACHE* pCache)
+{
+    return pCache->Serialize(pRootSignatureDesc, MaxVersion, ppBlob, ppErrorBlob);
+}
+
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_RT_FORMAT_ARRAY : public D3D12_RT_FORMAT_ARRAY
 {
@@ -2176,11 +2728,15 @@ private:
     D3D12_PIPELINE_STATE_SUBOBJECT_TYPE _Type;
     InnerStructType _Inner;
 public:
+    typedef InnerStructType InnerType;
+    static const D3D12_PIPELINE_STATE_SUBOBJECT_TYPE SubobjectType = Type;
+
     CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT() noexcept : _Type(Type), _Inner(DefaultArg()) {}
     CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT(InnerStructType const& i) : _Type(Type), _Inner(i) {}
     CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT& operator=(InnerStructType const& i) { _Inner = i; return *this; }
     operator InnerStructType() const { return _Inner; }
     operator InnerStructType&() { return _Inner; }
+    const InnerStructType& Inner() const noexcept { return _Inner; }
 };
 typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< D3D12_PIPELINE_STATE_FLAGS,         D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS>                             CD3DX12_PIPELINE_STATE_STREAM_FLAGS;
 typedef CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT< UINT,                               D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK>                         CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK;
@@ -2636,6 +3192,417 @@ inline HRESULT D3DX12ParsePipelineStream(const D3D12_PIPELINE_STATE_STREAM_DESC&
     return S_OK;
 }
 
+//------------------------------------------------------------------------------------------------
+// Flat Stream Parsing
+//
+// D3DX12ParsePipelineStreamLayout walks a stream once and records where each subobject starts,
+// without callbacks; subobjects are then read in place through CD3DX12_PIPELINE_STATE_STREAM_LAYOUT.
+
+static_assert(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID <= 64, "subobject types must fit in a 64-bit mask");
+
+// Stream size of each subobject type, 0 for types this header does not know.
+struct CD3DX12_PIPELINE_STATE_SUBOBJECT_SIZES
+{
+    SIZE_T Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID];
+
+    constexpr CD3DX12_PIPELINE_STATE_SUBOBJECT_SIZES() noexcept
+        : Sizes()
+    {
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_VS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_PS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_DS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_HS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_GS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_CS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_FLAGS);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1);
+        Sizes[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING] = sizeof(CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING);
+    }
+};
+
+struct CD3DX12_PIPELINE_STATE_STREAM_LAYOUT
+{
+    UINT64 SubobjectMask; // bit n is set when the stream holds a subobject of type n
+    UINT Offsets[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID]; // byte offsets, valid for the types in SubobjectMask
+
+    bool HasSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE SubobjectType) const noexcept
+    {
+        return (SubobjectMask & (1ull << SubobjectType)) != 0;
+    }
+
+    // The subobject's contents in the parsed stream, or nullptr when the stream does not hold it.
+    // TSubobject is one of the CD3DX12_PIPELINE_STATE_STREAM_* subobject types.
+    template <typename TSubobject>
+    const typename TSubobject::InnerType* Find(_In_ const void* pStream) const noexcept
+    {
+        if (!HasSubobject(TSubobject::SubobjectType))
+        {
+            return nullptr;
+        }
+        const BYTE* pSubobject = static_cast<const BYTE*>(pStream) + Offsets[TSubobject::SubobjectType];
+        return &reinterpret_cast<const TSubobject*>(pSubobject)->Inner();
+    }
+};
+
+// Accepts the same streams as D3DX12ParsePipelineStream, and also rejects a stream whose last
+// subobject runs past SizeInBytes.
+inline HRESULT D3DX12ParsePipelineStreamLayout(const D3D12_PIPELINE_STATE_STREAM_DESC& Desc, _Out_ CD3DX12_PIPELINE_STATE_STREAM_LAYOUT* pLayout)
+{
+    if (pLayout == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+    pLayout->SubobjectMask = 0;
+
+    if (Desc.SizeInBytes == 0 || Desc.SizeInBytes > UINT_MAX || Desc.pPipelineStateSubobjectStream == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    static constexpr CD3DX12_PIPELINE_STATE_SUBOBJECT_SIZES Table;
+    const BYTE* pStream = static_cast<const BYTE*>(Desc.pPipelineStateSubobjectStream);
+    UINT64 BaseTypesSeen = 0; // DEPTH_STENCIL and DEPTH_STENCIL1 exclude each other
+    for (SIZE_T CurOffset = 0; CurOffset < Desc.SizeInBytes; )
+    {
+        if (Desc.SizeInBytes - CurOffset < sizeof(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE))
+        {
+            return E_INVALIDARG;
+        }
+        const UINT SubobjectType = *reinterpret_cast<const UINT*>(pStream + CurOffset);
+        const SIZE_T SizeOfSubobject = SubobjectType < D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID ? Table.Sizes[SubobjectType] : 0;
+        if (SizeOfSubobject == 0 || SizeOfSubobject > Desc.SizeInBytes - CurOffset)
+        {
+            return E_INVALIDARG;
+        }
+        const UINT64 BaseType = 1ull << D3DX12GetBaseSubobjectType(static_cast<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE>(SubobjectType));
+        if (BaseTypesSeen & BaseType)
+        {
+            return E_INVALIDARG; // disallow subobject duplicates in a stream
+        }
+        BaseTypesSeen |= BaseType;
+        pLayout->SubobjectMask |= 1ull << SubobjectType;
+        pLayout->Offsets[SubobjectType] = UINT(CurOffset);
+        CurOffset += SizeOfSubobject;
+    }
+
+    return S_OK;
+}
+
+//------------------------------------------------------------------------------------------------
+// Calls Visit(UINT) for every field of a parsed stream that affects the pipeline, subobjects in
+// type order whatever their order in the stream, so two streams describe the same pipeline state
+// exactly when they visit the same words. Input layouts, stream output declarations and view
+// instance locations are visited by content, semantic names in upper case as HLSL compares them.
+// Shaders are visited by the MD5 a signed DXBC container carries, otherwise by their bytes.
+// The root signature and the cached blob are visited by address.
+template <typename TVisit>
+inline void D3DX12VisitPipelineStream(
+    _In_ const void* pStream,
+    const CD3DX12_PIPELINE_STATE_STREAM_LAYOUT& Layout,
+    TVisit&& Visit)
+{
+    auto VisitFloat = [&Visit](FLOAT Value)
+    {
+        UINT Bits;
+        memcpy(&Bits, &Value, sizeof(Bits));
+        Visit(Bits);
+    };
+    auto VisitSize = [&Visit](UINT64 Value)
+    {
+        Visit(UINT(Value));
+        Visit(UINT(Value >> 32));
+    };
+    auto VisitBytes = [&Visit](const BYTE* pBytes, SIZE_T Size)
+    {
+        SIZE_T n = 0;
+        for (; n + sizeof(UINT) <= Size; n += sizeof(UINT))
+        {
+            UINT Word;
+            memcpy(&Word, pBytes + n, sizeof(Word));
+            Visit(Word);
+        }
+        if (n < Size)
+        {
+            UINT Word = 0;
+            memcpy(&Word, pBytes + n, Size - n);
+            Visit(Word);
+        }
+    };
+    auto VisitName = [&Visit](LPCSTR pName)
+    {
+        if (pName == nullptr)
+        {
+            Visit(UINT_MAX);
+            return;
+        }
+        // Four characters to a word, the terminator included
+        UINT Word = 0, Shift = 0;
+        for (;; pName++)
+        {
+            UINT c = static_cast<BYTE>(*pName);
+            Word |= (c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c) << Shift;
+            Shift += 8;
+            if (c == 0 || Shift == 32)
+            {
+                Visit(Word);
+                Word = 0;
+                Shift = 0;
+            }
+            if (c == 0)
+            {
+                break;
+            }
+        }
+    };
+    auto VisitShader = [&](D3D12_PIPELINE_STATE_SUBOBJECT_TYPE SubobjectType, const D3D12_SHADER_BYTECODE* pShader)
+    {
+        if (pShader == nullptr)
+        {
+            return;
+        }
+        Visit(SubobjectType);
+        VisitSize(pShader->BytecodeLength);
+        const BYTE* pBytes = static_cast<const BYTE*>(pShader->pShaderBytecode);
+        if (pBytes == nullptr)
+        {
+            return;
+        }
+        // The digest follows the "DXBC" fourcc; it stays zero until the container is signed.
+        static const BYTE Unsigned[16] = {};
+        if (pShader->BytecodeLength >= 20 && memcmp(pBytes, "DXBC", 4) == 0 && memcmp(pBytes + 4, Unsigned, 16) != 0)
+        {
+            VisitBytes(pBytes + 4, 16);
+        }
+        else
+        {
+            VisitBytes(pBytes, pShader->BytecodeLength);
+        }
+    };
+    auto VisitRenderTargetBlend = [&Visit](const D3D12_RENDER_TARGET_BLEND_DESC& Blend)
+    {
+        Visit(Blend.BlendEnable);
+        Visit(Blend.LogicOpEnable);
+        Visit(Blend.SrcBlend);
+        Visit(Blend.DestBlend);
+        Visit(Blend.BlendOp);
+        Visit(Blend.SrcBlendAlpha);
+        Visit(Blend.DestBlendAlpha);
+        Visit(Blend.BlendOpAlpha);
+        Visit(Blend.LogicOp);
+        Visit(Blend.RenderTargetWriteMask);
+    };
+    auto VisitStencilOp = [&Visit](const D3D12_DEPTH_STENCILOP_DESC& StencilOp)
+    {
+        Visit(StencilOp.StencilFailOp);
+        Visit(StencilOp.StencilDepthFailOp);
+        Visit(StencilOp.StencilPassOp);
+        Visit(StencilOp.StencilFunc);
+    };
+    auto VisitDepthStencil = [&](const auto& DepthStencil) // D3D12_DEPTH_STENCIL_DESC or D3D12_DEPTH_STENCIL_DESC1
+    {
+        Visit(DepthStencil.DepthEnable);
+        Visit(DepthStencil.DepthWriteMask);
+        Visit(DepthStencil.DepthFunc);
+        Visit(DepthStencil.StencilEnable);
+        Visit(DepthStencil.StencilReadMask);
+        Visit(DepthStencil.StencilWriteMask);
+        VisitStencilOp(DepthStencil.FrontFace);
+        VisitStencilOp(DepthStencil.BackFace);
+    };
+
+    if (auto pRootSignature = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE);
+        VisitSize(reinterpret_cast<UINT_PTR>(*pRootSignature));
+    }
+    VisitShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_VS>(pStream));
+    VisitShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_PS>(pStream));
+    VisitShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS, Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_DS>(pStream));
+    VisitShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS, Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_HS>(pStream));
+    VisitShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS, Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_GS>(pStream));
+    VisitShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS, Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_CS>(pStream));
+    if (auto pStreamOutput = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT);
+        Visit(pStreamOutput->NumEntries);
+        for (UINT n = 0; n < pStreamOutput->NumEntries; n++)
+        {
+            const D3D12_SO_DECLARATION_ENTRY& Entry = pStreamOutput->pSODeclaration[n];
+            Visit(Entry.Stream);
+            VisitName(Entry.SemanticName);
+            Visit(Entry.SemanticIndex);
+            Visit(Entry.StartComponent);
+            Visit(Entry.ComponentCount);
+            Visit(Entry.OutputSlot);
+        }
+        Visit(pStreamOutput->NumStrides);
+        for (UINT n = 0; n < pStreamOutput->NumStrides; n++)
+        {
+            Visit(pStreamOutput->pBufferStrides[n]);
+        }
+        Visit(pStreamOutput->RasterizedStream);
+    }
+    if (auto pBlend = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND);
+        Visit(pBlend->AlphaToCoverageEnable);
+        Visit(pBlend->IndependentBlendEnable);
+        for (UINT n = 0; n < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; n++)
+        {
+            VisitRenderTargetBlend(pBlend->RenderTarget[n]);
+        }
+    }
+    if (auto pSampleMask = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK);
+        Visit(*pSampleMask);
+    }
+    if (auto pRasterizer = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER);
+        Visit(pRasterizer->FillMode);
+        Visit(pRasterizer->CullMode);
+        Visit(pRasterizer->FrontCounterClockwise);
+        Visit(UINT(pRasterizer->DepthBias));
+        VisitFloat(pRasterizer->DepthBiasClamp);
+        VisitFloat(pRasterizer->SlopeScaledDepthBias);
+        Visit(pRasterizer->DepthClipEnable);
+        Visit(pRasterizer->MultisampleEnable);
+        Visit(pRasterizer->AntialiasedLineEnable);
+        Visit(pRasterizer->ForcedSampleCount);
+        Visit(pRasterizer->ConservativeRaster);
+    }
+    if (auto pDepthStencil = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL);
+        VisitDepthStencil(*pDepthStencil);
+    }
+    if (auto pInputLayout = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT);
+        Visit(pInputLayout->NumElements);
+        for (UINT n = 0; n < pInputLayout->NumElements; n++)
+        {
+            const D3D12_INPUT_ELEMENT_DESC& Element = pInputLayout->pInputElementDescs[n];
+            VisitName(Element.SemanticName);
+            Visit(Element.SemanticIndex);
+            Visit(Element.Format);
+            Visit(Element.InputSlot);
+            Visit(Element.AlignedByteOffset);
+            Visit(Element.InputSlotClass);
+            Visit(Element.InstanceDataStepRate);
+        }
+    }
+    if (auto pIBStripCutValue = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE);
+        Visit(*pIBStripCutValue);
+    }
+    if (auto pPrimitiveTopologyType = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY);
+        Visit(*pPrimitiveTopologyType);
+    }
+    if (auto pRTVFormats = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS);
+        const UINT NumRenderTargets = pRTVFormats->NumRenderTargets < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT ?
+            pRTVFormats->NumRenderTargets : D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT;
+        Visit(pRTVFormats->NumRenderTargets);
+        for (UINT n = 0; n < NumRenderTargets; n++)
+        {
+            Visit(pRTVFormats->RTFormats[n]);
+        }
+    }
+    if (auto pDSVFormat = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT);
+        Visit(*pDSVFormat);
+    }
+    if (auto pSampleDesc = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC);
+        Visit(pSampleDesc->Count);
+        Visit(pSampleDesc->Quality);
+    }
+    if (auto pNodeMask = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK);
+        Visit(*pNodeMask);
+    }
+    if (auto pCachedPSO = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO);
+        VisitSize(reinterpret_cast<UINT_PTR>(pCachedPSO->pCachedBlob));
+        VisitSize(pCachedPSO->CachedBlobSizeInBytes);
+    }
+    if (auto pFlags = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_FLAGS>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS);
+        Visit(*pFlags);
+    }
+    if (auto pDepthStencil1 = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1);
+        VisitDepthStencil(*pDepthStencil1);
+        Visit(pDepthStencil1->DepthBoundsTestEnable);
+    }
+    if (auto pViewInstancing = Layout.Find<CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING>(pStream))
+    {
+        Visit(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING);
+        Visit(pViewInstancing->ViewInstanceCount);
+        for (UINT n = 0; n < pViewInstancing->ViewInstanceCount; n++)
+        {
+            Visit(pViewInstancing->pViewInstanceLocations[n].ViewportArrayIndex);
+            Visit(pViewInstancing->pViewInstanceLocations[n].RenderTargetArrayIndex);
+        }
+        Visit(pViewInstancing->Flags);
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Content hash of a parsed stream, for deduplicating pipeline state streams; see
+// D3DX12VisitPipelineStream for what takes part. Equal hashes still need an equality check
+// before two streams are treated as the same pipeline.
+inline UINT64 D3DX12HashPipelineStream(_In_ const void* pStream, const CD3DX12_PIPELINE_STATE_STREAM_LAYOUT& Layout)
+{
+    // FNV-1a, one word at a time, as CD3DX12_ROOT_SIGNATURE_CACHE
+    UINT64 State = 14695981039346656037ull;
+    D3DX12VisitPipelineStream(pStream, Layout, [&State](UINT Value)
+    {
+        State = (State ^ Value) * 1099511628211ull;
+    });
+    return State;
+}
+
+inline HRESULT D3DX12HashPipelineStream(const D3D12_PIPELINE_STATE_STREAM_DESC& Desc, _Out_ UINT64* pHash)
+{
+    if (pHash == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+    CD3DX12_PIPELINE_STATE_STREAM_LAYOUT Layout;
+    HRESULT hr = D3DX12ParsePipelineStreamLayout(Desc, &Layout);
+    if (SUCCEEDED(hr))
+    {
+        *pHash = D3DX12HashPipelineStream(Desc.pPipelineStateSubobjectStream, Layout);
+    }
+    return hr;
+}
 
 #endif // defined( __cplusplus )
 
@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "AsyncCompiler.h"
+
+using namespace Query;
+using Pipelines::AsyncCompiler;
+using Pipelines::PipelineHandle;
+
+namespace
+{
+	// A driver that takes a fixed time per pipeline.
+	class SlowFactory : public Pipelines::IPipelineFactory
+	{
+	private:
+		chrono::microseconds m_delay;
+
+	public:
+		explicit SlowFactory(chrono::microseconds delay) : m_delay(delay) {}
+
+		PipelineHandle Create(uint64_t key) override
+		{
+			this_thread::sleep_for(m_delay);
+			return make_shared<uint64_t>(key);
+		}
+	};
+
+	struct Result
+	{
+		uint32_t pipelines;
+		uint32_t compileMicroseconds;
+		bool blocking;
+		double maxFrameMilliseconds = 0;
+		double averageFrameMilliseconds = 0;
+		uint32_t spikes = 0;
+		uint32_t fallbackResolves = 0;
+	};
+
+	// Frames of a fixed CPU time; at frame 10 the scene needs new pipelines. Blocking frames wait
+	// for each one, the way creating them on the render thread would; the others draw with the
+	// fallback until they are ready.
+	Result Run(Threading::ThreadPool& pool, uint32_t pipelines, uint32_t compileMicroseconds, bool blocking)
+	{
+		Result result = { pipelines, compileMicroseconds, blocking };
+		const chrono::microseconds frameWork(2000);
+		const uint32_t frames = 60;
+		SlowFactory factory((chrono::microseconds(compileMicroseconds)));
+		AsyncCompiler compiler;
+		compiler.Initialize(&pool, &factory);
+		const PipelineHandle fallback = make_shared<uint64_t>(0);
+		double total = 0;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			const auto start = chrono::steady_clock::now();
+			for (uint32_t i = 0; frame >= 10 && i < pipelines; i++)
+			{
+				if (blocking)
+				{
+					compiler.Wait(i);
+				}
+				else
+				{
+					compiler.SetFallback(i, fallback);
+					compiler.Resolve(i);
+				}
+			}
+			this_thread::sleep_for(frameWork);
+			const double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			compiler.RecordFrame(milliseconds);
+			total += milliseconds;
+			result.maxFrameMilliseconds = milliseconds > result.maxFrameMilliseconds ? milliseconds : result.maxFrameMilliseconds;
+		}
+		compiler.WaitIdle();
+		result.averageFrameMilliseconds = total / frames;
+		result.spikes = compiler.GetStats().spikes;
+		result.fallbackResolves = compiler.GetStats().fallbackResolves;
+		return result;
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize();
+	const Result results[] = {
+		Run(pool, 4, 5000, true),
+		Run(pool, 4, 5000, false),
+		Run(pool, 32, 5000, true),
+		Run(pool, 32, 5000, false),
+		Run(pool, 8, 50000, true),
+		Run(pool, 8, 50000, false) };
+
+	printf("{\n\t\"benchmark\": \"asyncCompiler\",\n\t\"threads\": %u,\n\t\"runs\": [", pool.GetThreadCount());
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"pipelines\": %u, \"compileUs\": %u, \"blocking\": %s, \"maxFrameMs\": %.2f, \"averageFrameMs\": %.2f, "
+			"\"spikes\": %u, \"fallbackResolves\": %u }",
+			i ? "," : "", r.pipelines, r.compileMicroseconds, r.blocking ? "true" : "false", r.maxFrameMilliseconds,
+			r.averageFrameMilliseconds, r.spikes, r.fallbackResolves);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "AsyncCompiler.h"
+#include "Check.h"
+
+using namespace Query;
+using Pipelines::AsyncCompiler;
+using Pipelines::PipelineHandle;
+
+namespace
+{
+	const uint64_t FailingKey = 99;
+	const uint64_t ThrowingKey = 666;
+
+	// Stands in for the driver: every pipeline takes a while, one key fails and one throws.
+	class SlowFactory : public Pipelines::IPipelineFactory
+	{
+	private:
+		chrono::milliseconds m_delay;
+
+	public:
+		atomic<uint32_t> calls;
+		atomic<uint32_t> concurrent;
+		atomic<uint32_t> maxConcurrent;
+
+		explicit SlowFactory(chrono::milliseconds delay) : m_delay(delay), calls(0), concurrent(0), maxConcurrent(0) {}
+
+		PipelineHandle Create(uint64_t key) override
+		{
+			calls++;
+			const uint32_t running = ++concurrent;
+			for (uint32_t seen = maxConcurrent; running > seen && !maxConcurrent.compare_exchange_weak(seen, running);)
+			{
+			}
+			this_thread::sleep_for(m_delay);
+			concurrent--;
+			if (key == ThrowingKey)
+			{
+				throw runtime_error("driver error");
+			}
+			return key == FailingKey ? nullptr : make_shared<uint64_t>(key);
+		}
+	};
+
+	uint64_t KeyOf(const PipelineHandle& pipeline)
+	{
+		return *static_cast<const uint64_t*>(pipeline.get());
+	}
+
+	double MillisecondsSince(chrono::steady_clock::time_point start)
+	{
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	}
+
+	// The render thread never waits: while a pipeline compiles, Resolve answers with its fallback
+	// or null, and once it is done, with the pipeline.
+	void TestResolve(Threading::ThreadPool& pool)
+	{
+		SlowFactory factory(chrono::milliseconds(100));
+		AsyncCompiler compiler;
+		compiler.Initialize(&pool, &factory);
+		const PipelineHandle fallback = make_shared<uint64_t>(0);
+		compiler.SetFallback(1, fallback);
+
+		const auto start = chrono::steady_clock::now();
+		CHECK(compiler.Resolve(1) == fallback);
+		CHECK(!compiler.Resolve(2));
+		CHECK(!compiler.IsReady(1));
+		CHECK(MillisecondsSince(start) < 50);
+
+		const PipelineHandle pipeline = compiler.Wait(1);
+		CHECK(pipeline && KeyOf(pipeline) == 1);
+		CHECK(compiler.IsReady(1));
+		CHECK(compiler.Resolve(1) == pipeline);
+		compiler.WaitIdle();
+		CHECK(compiler.IsReady(2) && KeyOf(compiler.Resolve(2)) == 2);
+
+		const AsyncCompiler::Stats stats = compiler.GetStats();
+		CHECK(stats.requested == 2 && stats.compiled == 2 && stats.failed == 0);
+		CHECK(stats.fallbackResolves == 1 && stats.missingResolves == 1);
+		CHECK(stats.blockingMilliseconds > 0 && stats.maxCompileMilliseconds >= 100);
+	}
+
+	// Each key is compiled once however often, and from however many threads, it is asked for;
+	// different keys compile side by side.
+	void TestOnce(Threading::ThreadPool& pool)
+	{
+		SlowFactory factory(chrono::milliseconds(20));
+		AsyncCompiler compiler;
+		compiler.Initialize(&pool, &factory);
+		vector<thread> threads;
+		for (uint32_t t = 0; t < 4; t++)
+		{
+			threads.emplace_back([&compiler]()
+			{
+				for (uint64_t key = 100; key < 116; key++)
+				{
+					compiler.Request(key);
+					compiler.Resolve(key);
+				}
+			});
+		}
+		for (thread& t : threads)
+		{
+			t.join();
+		}
+		compiler.WaitIdle();
+		CHECK(factory.calls == 16);
+		for (uint64_t key = 100; key < 116; key++)
+		{
+			CHECK(compiler.IsReady(key) && KeyOf(compiler.Resolve(key)) == key);
+		}
+		CHECK(compiler.GetStats().requested == 16 && compiler.GetStats().compiled == 16);
+		CHECK(pool.GetThreadCount() < 2 || factory.maxConcurrent > 1);
+	}
+
+	// A pipeline that fails, by returning null or by throwing, is finished like any other: waiting
+	// for it returns, it counts as failed, and Resolve keeps answering with the fallback.
+	void TestFailure(Threading::ThreadPool& pool)
+	{
+		SlowFactory factory(chrono::milliseconds(10));
+		const PipelineHandle fallback = make_shared<uint64_t>(0);
+		{
+			AsyncCompiler compiler;
+			compiler.Initialize(&pool, &factory);
+			compiler.SetFallback(ThrowingKey, fallback);
+			CHECK(!compiler.Wait(FailingKey));
+			CHECK(!compiler.Wait(ThrowingKey));
+			CHECK(compiler.IsReady(FailingKey) && compiler.IsReady(ThrowingKey));
+			CHECK(compiler.Resolve(ThrowingKey) == fallback);
+			CHECK(!compiler.Resolve(FailingKey));
+
+			compiler.Request(ThrowingKey + 1);
+			compiler.Request(ThrowingKey);
+			compiler.WaitIdle();
+			const AsyncCompiler::Stats stats = compiler.GetStats();
+			CHECK(stats.requested == 3 && stats.compiled == 1 && stats.failed == 2);
+			CHECK(factory.calls == 3);
+
+			// A failure does not leave a compile in flight behind: frames after it are not
+			// blamed on compiles.
+			for (uint32_t frame = 0; frame < 20; frame++)
+			{
+				compiler.RecordFrame(16);
+			}
+			CHECK(compiler.RecordFrame(50));
+			CHECK(compiler.GetStats().spikesDuringCompiles == 0);
+
+			// Destroying the compiler with a throwing job still queued returns too.
+			compiler.Request(ThrowingKey + 2);
+			compiler.SetFallback(ThrowingKey + 3, fallback);
+			compiler.Resolve(ThrowingKey + 3);
+		}
+		CHECK(factory.calls == 5);
+	}
+
+	// Spikes are frames at twice the running average, counted against compiles when a pipeline
+	// was compiling or waited for during the frame.
+	void TestSpikes(Threading::ThreadPool& pool)
+	{
+		SlowFactory factory(chrono::milliseconds(30));
+		AsyncCompiler compiler;
+		compiler.Initialize(&pool, &factory);
+		for (uint32_t frame = 0; frame < 20; frame++)
+		{
+			CHECK(!compiler.RecordFrame(16));
+		}
+		CHECK(compiler.RecordFrame(40));
+		compiler.Request(7);
+		CHECK(compiler.RecordFrame(40));
+		compiler.WaitIdle();
+		CHECK(!compiler.RecordFrame(17));
+		CHECK(!compiler.RecordFrame(16));
+		const AsyncCompiler::Stats stats = compiler.GetStats();
+		CHECK(stats.frames == 24 && stats.spikes == 2 && stats.spikesDuringCompiles == 1);
+		CHECK(stats.averageFrameMilliseconds > 15 && stats.averageFrameMilliseconds < 17);
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	TestResolve(pool);
+	TestOnce(pool);
+	TestFailure(pool);
+	TestSpikes(pool);
+	return Testing::Finish("AsyncCompilerTest");
+}
@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "Check.h"
+
+using namespace Query;
+using Culling::Bounds;
+using Culling::BoundingVolumeHierarchy;
+
+namespace
+{
+	bool Contains(const float min[3], const float max[3], const Bounds& bounds)
+	{
+		return min[0] <= bounds.min[0] && min[1] <= bounds.min[1] && min[2] <= bounds.min[2] &&
+			max[0] >= bounds.max[0] && max[1] >= bounds.max[1] && max[2] >= bounds.max[2];
+	}
+
+	// Every object is in exactly one leaf of at most MaxLeafSize, and every child's bounds hold
+	// the bounds of all the objects below it.
+	void CheckStructure(const BoundingVolumeHierarchy& hierarchy, const vector<Bounds>& bounds)
+	{
+		const uint32_t count = static_cast<uint32_t>(bounds.size());
+		if (!CHECK(hierarchy.GetObjectCount() == count))
+		{
+			return;
+		}
+		vector<uint32_t> seen(count, 0);
+		uint32_t uncontained = 0, oversized = 0;
+		function<void(uint32_t, uint32_t, const float*, const float*)> visit = [&](uint32_t child, uint32_t leafCount, const float* min, const float* max)
+		{
+			if (leafCount)
+			{
+				oversized += leafCount > BoundingVolumeHierarchy::MaxLeafSize;
+				for (uint32_t i = child; i < child + leafCount; i++)
+				{
+					const uint32_t object = hierarchy.GetObjects()[i];
+					seen[object]++;
+					uncontained += !Contains(min, max, bounds[object]);
+				}
+				return;
+			}
+			const BoundingVolumeHierarchy::Node& node = hierarchy.GetNodes()[child];
+			for (uint32_t c = 0; c < 2; c++)
+			{
+				if (node.count[c] || node.child[c])
+				{
+					uncontained += min && !Contains(min, max, { { node.childMin[c][0], node.childMin[c][1], node.childMin[c][2] },
+						{ node.childMax[c][0], node.childMax[c][1], node.childMax[c][2] } });
+					visit(node.child[c], node.count[c], node.childMin[c], node.childMax[c]);
+				}
+			}
+		};
+		if (hierarchy.GetNodeCount())
+		{
+			visit(0, 0, nullptr, nullptr);
+		}
+		CHECK(count_if(seen.begin(), seen.end(), [](uint32_t times) { return times != 1; }) == 0);
+		CHECK(uncontained == 0);
+		CHECK(oversized == 0);
+	}
+
+	// Region queries find exactly the objects a linear test finds.
+	uint32_t CountMismatches(const BoundingVolumeHierarchy& hierarchy, const vector<Bounds>& bounds, const vector<Bounds>& regions)
+	{
+		uint32_t mismatches = 0;
+		vector<uint32_t> objects, expected;
+		for (const Bounds& region : regions)
+		{
+			expected.clear();
+			for (uint32_t i = 0; i < bounds.size(); i++)
+			{
+				if (region.Overlaps(bounds[i]))
+				{
+					expected.push_back(i);
+				}
+			}
+			objects.clear();
+			hierarchy.Query(region, bounds.data(), objects);
+			sort(objects.begin(), objects.end());
+			mismatches += objects != expected;
+		}
+		return mismatches;
+	}
+
+	vector<Bounds> GenerateRegions(uint32_t count, uint32_t seed)
+	{
+		Benchmark::Random random(seed);
+		vector<Bounds> regions(count);
+		for (Bounds& region : regions)
+		{
+			const float size = random.Uniform(0.01f, 0.5f);
+			const float x = random.Uniform(-1.5f, 1.5f - size), y = random.Uniform(-1.5f, 1.5f - size);
+			region = { { x, y, 0.0f }, { x + size, y + size, 1.0f } };
+		}
+		return regions;
+	}
+
+	// Drifting occluders of a generated scene: the build, a tree that is only refitted and a
+	// dynamic hierarchy that rebuilds on the pool all answer every query as the linear test does.
+	void TestDrift(Threading::ThreadPool* pool)
+	{
+		Benchmark::SceneDesc desc;
+		desc.occluders = 5000;
+		desc.occludees = 0;
+		desc.sizes = Benchmark::SizeDistribution::PowerLaw;
+		desc.animation = Rendering::Animation::Drift;
+		const Rendering::Scene scene = Benchmark::GenerateScene(desc);
+		Rendering::SceneStore store;
+		Rendering::SceneRenderer::AddDrift(scene.occluders, store);
+		vector<float> offsets(static_cast<size_t>(desc.occluders) * 4);
+		Rendering::SceneStore::Output output;
+		output.destination = reinterpret_cast<uint8_t*>(offsets.data());
+		output.stride = 4 * sizeof(float);
+		vector<Bounds> bounds;
+		Benchmark::GetBounds(scene, store, bounds);
+		const vector<Bounds> regions = GenerateRegions(200, 2);
+
+		BoundingVolumeHierarchy refitted;
+		refitted.Build(bounds.data(), desc.occluders);
+		CheckStructure(refitted, bounds);
+		CHECK(CountMismatches(refitted, bounds, regions) == 0);
+		CHECK(refitted.GetCost() == refitted.GetBuildCost());
+
+		// Rebuilds every few frames, so that some are adopted while the objects keep moving.
+		Culling::DynamicHierarchy dynamic;
+		dynamic.Initialize(pool, 1.05f, 8);
+		dynamic.Update(bounds.data(), desc.occluders);
+		uint32_t refitMismatches = 0, dynamicMismatches = 0;
+		for (uint32_t frame = 0; frame < 40; frame++)
+		{
+			store.Update(output);
+			Benchmark::GetBounds(scene, store, bounds);
+			refitted.Refit(bounds.data());
+			dynamic.Update(bounds.data(), desc.occluders);
+			if (frame % 8 == 7)
+			{
+				CheckStructure(refitted, bounds);
+				CheckStructure(dynamic.Get(), bounds);
+				refitMismatches += CountMismatches(refitted, bounds, regions);
+				dynamicMismatches += CountMismatches(dynamic.Get(), bounds, regions);
+			}
+		}
+		CHECK(refitMismatches == 0);
+		CHECK(dynamicMismatches == 0);
+		CHECK(dynamic.GetRebuildCount() > 0);
+		CHECK(refitted.GetCost() > refitted.GetBuildCost());
+		CHECK(dynamic.Get().GetCost() < refitted.GetCost());
+	}
+
+	// No objects, one, and many with the same bounds, which no split plane can separate.
+	void TestDegenerate()
+	{
+		const vector<Bounds> regions = GenerateRegions(50, 3);
+		BoundingVolumeHierarchy hierarchy;
+		vector<Bounds> bounds;
+		hierarchy.Build(bounds.data(), 0);
+		CHECK(hierarchy.GetObjectCount() == 0);
+		CHECK(CountMismatches(hierarchy, bounds, regions) == 0);
+
+		bounds.push_back({ { -0.1f, -0.1f, 0.5f }, { 0.1f, 0.1f, 0.5f } });
+		hierarchy.Build(bounds.data(), 1);
+		CheckStructure(hierarchy, bounds);
+		CHECK(CountMismatches(hierarchy, bounds, regions) == 0);
+
+		bounds.assign(1000, bounds[0]);
+		hierarchy.Build(bounds.data(), 1000);
+		CheckStructure(hierarchy, bounds);
+		CHECK(CountMismatches(hierarchy, bounds, regions) == 0);
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	TestDrift(&pool);
+	TestDrift(nullptr);
+	TestDegenerate();
+	return Testing::Finish("BoundingVolumeHierarchyTest");
+}
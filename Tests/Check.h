@@ -0,0 +1,33 @@
+#pragma once
+
+namespace Query {
+	namespace Testing
+	{
+		inline uint32_t& FailureCount()
+		{
+			static uint32_t failures = 0;
+			return failures;
+		}
+
+		inline bool Check(bool condition, const char* expression, const char* file, int line)
+		{
+			if (!condition)
+			{
+				fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+				FailureCount()++;
+			}
+			return condition;
+		}
+
+		// What main returns: 0 when every check passed.
+		inline int Finish(const char* test)
+		{
+			printf("%s: %s\n", test, FailureCount() ? "FAILED" : "passed");
+			return FailureCount() ? 1 : 0;
+		}
+	}
+}
+
+// Records a failure and carries on, so that one run reports every broken check. Evaluates to the
+// condition, for the checks that later ones depend on.
+#define CHECK(condition) ::Query::Testing::Check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,396 @@
+#include "pch.h"
+#include "CommandTrace.h"
+#include "HeadlessRunner.h"
+#include "QueryRenderer.h"
+#include "NullBackend.h"
+#include "SoftwareBackend.h"
+#include "Hash.h"
+#include "Check.h"
+
+using namespace Query;
+using namespace Backend;
+using Capture::Trace::Op;
+
+namespace
+{
+	const wstring TracePath = L"CommandTraceTest.trace";
+
+	// Keeps the resources the replayer creates within reach, in creation order.
+	class KeepingDevice : public Null::Device
+	{
+	public:
+		vector<IResource*> resources;
+
+		unique_ptr<IResource> CreateResource(const ResourceDesc& desc, ResourceState initialState) override
+		{
+			unique_ptr<IResource> resource = Null::Device::CreateResource(desc, initialState);
+			resources.push_back(resource.get());
+			return resource;
+		}
+	};
+
+	bool Equal(IResource* a, IResource* b)
+	{
+		const size_t size = static_cast<size_t>(a->GetDesc().size);
+		return size == b->GetDesc().size && memcmp(a->Map(), b->Map(), size) == 0;
+	}
+
+	// Fixes the header's checksum after the contents were changed.
+	void Seal(vector<uint8_t>& contents)
+	{
+		Capture::Trace::Header header;
+		memcpy(&header, contents.data(), sizeof(header));
+		header.checksum = Hash::Compute(contents.data() + sizeof(header), contents.size() - sizeof(header));
+		memcpy(contents.data(), &header, sizeof(header));
+	}
+
+	bool Loads(const vector<uint8_t>& contents, uint32_t pipelineCount = 0)
+	{
+		Null::Device device;
+		vector<Null::Pipeline> pipelines(pipelineCount, Null::Pipeline("Pipeline"));
+		vector<IPipeline*> slots;
+		for (Null::Pipeline& pipeline : pipelines)
+		{
+			slots.push_back(&pipeline);
+		}
+		Capture::TraceReplayer replayer;
+		return replayer.Open(contents.data(), contents.size()) && replayer.Load(&device, slots);
+	}
+
+	// Trace records written by hand, for the damage the writer never produces.
+	class RawTrace
+	{
+	private:
+		vector<uint8_t> m_bytes;
+
+	public:
+		RawTrace()
+		{
+			const Capture::Trace::Header header = { Capture::Trace::Magic, Capture::Trace::Version, 0 };
+			Put(header);
+		}
+
+		template<typename T>
+		RawTrace& Put(T value)
+		{
+			const size_t offset = m_bytes.size();
+			m_bytes.resize(offset + sizeof(T));
+			memcpy(m_bytes.data() + offset, &value, sizeof(T));
+			return *this;
+		}
+		RawTrace& Put(Op op) { return Put(static_cast<uint8_t>(op)); }
+		RawTrace& Append(const vector<uint8_t>& bytes)
+		{
+			m_bytes.insert(m_bytes.end(), bytes.begin(), bytes.end());
+			return *this;
+		}
+
+		RawTrace& Resource(uint32_t id, const ResourceDesc& desc)
+		{
+			Put(Op::DeclareResource).Put(id);
+			Put(static_cast<uint8_t>(desc.kind)).Put(static_cast<uint8_t>(desc.heap)).Put(static_cast<uint8_t>(desc.format));
+			return Put(desc.size).Put(desc.width).Put(desc.height).Put(static_cast<uint32_t>(Rendering::StateCommon));
+		}
+		RawTrace& CommandList(uint32_t id, uint32_t frameCount) { return Put(Op::DeclareCommandList).Put(id).Put(frameCount); }
+		RawTrace& QueryHeap(uint32_t id, uint32_t count)
+		{
+			return Put(Op::DeclareQueryHeap).Put(id).Put(static_cast<uint8_t>(QueryType::Occlusion)).Put(count);
+		}
+		RawTrace& BufferData(uint32_t id, uint64_t offset, uint64_t size, uint64_t stored)
+		{
+			Put(Op::BufferData).Put(id).Put(offset).Put(size);
+			return Append(vector<uint8_t>(static_cast<size_t>(stored), 0xAB));
+		}
+		RawTrace& Submit(uint32_t id, const vector<uint8_t>& recording)
+		{
+			return Put(Op::Submit).Put(id).Put(static_cast<uint64_t>(recording.size())).Append(recording);
+		}
+
+		vector<uint8_t> Finish() const
+		{
+			vector<uint8_t> contents = m_bytes;
+			Seal(contents);
+			return contents;
+		}
+	};
+
+	// A command list recording: Reset of frame 0, the commands, Close.
+	class Recording
+	{
+	private:
+		vector<uint8_t> m_bytes;
+
+	public:
+		Recording() { Put(Op::Reset).Put(0u); }
+
+		template<typename T>
+		Recording& Put(T value)
+		{
+			const size_t offset = m_bytes.size();
+			m_bytes.resize(offset + sizeof(T));
+			memcpy(m_bytes.data() + offset, &value, sizeof(T));
+			return *this;
+		}
+		Recording& Put(Op op) { return Put(static_cast<uint8_t>(op)); }
+
+		vector<uint8_t> Close() const
+		{
+			vector<uint8_t> bytes = m_bytes;
+			bytes.push_back(static_cast<uint8_t>(Op::Close));
+			return bytes;
+		}
+		// Without the Close, cut short by bytes.
+		vector<uint8_t> Cut(size_t bytes) const { return vector<uint8_t>(m_bytes.begin(), m_bytes.end() - bytes); }
+	};
+
+	// The sample's frame loop captured on the null backend and replayed on it gives the same draws
+	// and predication, with the same occlusion period.
+	void TestNullRoundTrip()
+	{
+		const Headless::RunResult captured = Headless::RunCaptured(TracePath, 40, 64, 32);
+		const Headless::RunResult replayed = Headless::Replay(TracePath, false);
+		CHECK(captured.frames == 40);
+		CHECK(replayed.frames == captured.frames + 1);	//with the vertex buffer upload
+		CHECK(replayed.draws == captured.draws && replayed.predicatedDraws == captured.predicatedDraws);
+		CHECK(captured.predicatedDraws > 0);
+	}
+
+	// Captured on the software backend and replayed on a fresh one, with a pool this time, the
+	// frames rasterize the same samples, so the queries predicate the same draws.
+	void TestSoftwareRoundTrip()
+	{
+		const uint32_t frames = 160, width = 160, height = 90;
+		Software::Device device;
+		Software::SwapChain swapChain(Rendering::QueryRenderer::FrameCount, width, height);
+		Software::PipelineDesc queryDesc;
+		queryDesc.colorWrite = false;
+		queryDesc.depthWrite = false;
+		Software::Pipeline scenePipeline("Scene", Software::PipelineDesc());
+		Software::Pipeline queryPipeline("Query", queryDesc);
+
+		Capture::TraceWriter writer;
+		Capture::CaptureDevice captureDevice(&device, &writer);
+		// Headless::Replay's slots.
+		writer.DeclarePipeline(&scenePipeline, 0);
+		writer.DeclarePipeline(&queryPipeline, 1);
+		Rendering::QueryRenderer renderer;
+		renderer.Initialize(&captureDevice, &swapChain, width, height);
+		renderer.SetPipelines(&scenePipeline, &queryPipeline);
+		for (uint32_t i = 0; i < frames; i++)
+		{
+			renderer.Update();
+			renderer.Render();
+		}
+		renderer.WaitForGpu();
+		CHECK(writer.GetSubmitCount() == frames + 1);
+		if (!CHECK(writer.Save(TracePath)))
+		{
+			return;
+		}
+
+		const auto& captured = device.GetSoftwareQueue().GetStats();
+		const Headless::RunResult replayed = Headless::Replay(TracePath, true, 2);
+		CHECK(replayed.frames == frames + 1);
+		CHECK(replayed.draws == captured.draws && replayed.predicatedDraws == captured.predicatedDraws);
+		CHECK(replayed.samplesPassed == captured.samplesPassed);
+		CHECK(captured.predicatedDraws > 0 && captured.samplesPassed > 0);
+	}
+
+	// The header and checksum guard the whole file; a trace cut short with a valid checksum is
+	// caught by the bounds-checked decoding.
+	void TestDamagedFiles()
+	{
+		Headless::RunCaptured(TracePath, 5, 64, 32);
+		vector<uint8_t> contents;
+		if (!CHECK(IO::MappedFile::ReadAll(TracePath, contents) && contents.size() > sizeof(Capture::Trace::Header) + 64))
+		{
+			return;
+		}
+		CHECK(Loads(contents, 2));
+
+		Capture::TraceReplayer replayer;
+		CHECK(!replayer.Open(contents.data(), sizeof(Capture::Trace::Header) - 1));
+		CHECK(!replayer.Load(nullptr, {}));
+		for (size_t offset : { size_t(0), offsetof(Capture::Trace::Header, version), sizeof(Capture::Trace::Header), contents.size() / 2, contents.size() - 1 })
+		{
+			vector<uint8_t> damaged = contents;
+			damaged[offset] ^= 0x10;
+			CHECK(!replayer.Open(damaged.data(), damaged.size()));
+		}
+		vector<uint8_t> version = contents;
+		version[offsetof(Capture::Trace::Header, version)]++;
+		Seal(version);
+		CHECK(!replayer.Open(version.data(), version.size()));
+
+		// The last record is a frame's Submit, longer than what is cut off.
+		uint32_t loaded = 0, opened = 0;
+		for (size_t cut = 1; cut <= 64; cut++)
+		{
+			vector<uint8_t> truncated(contents.begin(), contents.end() - cut);
+			CHECK(!Capture::TraceReplayer().Open(truncated.data(), truncated.size()));
+			Seal(truncated);
+			opened += Capture::TraceReplayer().Open(truncated.data(), truncated.size());
+			loaded += Loads(truncated, 2);
+		}
+		CHECK(opened == 64);
+		CHECK(loaded == 0);
+	}
+
+	// Records the writer never produces: each is rejected by Load instead of being acted on.
+	void TestMalformedRecords()
+	{
+		const ResourceDesc upload = ResourceDesc::Buffer(256, HeapKind::Upload);
+		const ResourceDesc target = ResourceDesc::Buffer(256);
+		const vector<uint8_t> copy = Recording().Put(Op::CopyBuffer).Put(1u).Put(uint64_t(0)).Put(0u).Put(uint64_t(0)).Put(uint64_t(256)).Close();
+
+		// What the damaged traces below start from.
+		auto valid = [&]() -> RawTrace
+		{
+			RawTrace trace;
+			trace.Resource(0, upload).Resource(1, target).CommandList(2, 2).QueryHeap(3, 4).BufferData(0, 0, 256, 256);
+			return trace;
+		};
+		CHECK(Loads(valid().Submit(2, copy).Finish()));
+
+		ResourceDesc oversized = ResourceDesc::Buffer((1ull << 31) + 1);
+		CHECK(!Loads(RawTrace().Resource(0, oversized).Finish()));
+		oversized = ResourceDesc::Texture(ResourceKind::RenderTarget, 16385, 16, Format::R8G8B8A8Unorm);
+		CHECK(!Loads(RawTrace().Resource(0, oversized).Finish()));
+		CHECK(!Loads(RawTrace().QueryHeap(0, (1u << 16) + 1).Finish()));
+		CHECK(!Loads(RawTrace().CommandList(0, 0).Finish()));
+		CHECK(!Loads(RawTrace().CommandList(0, 17).Finish()));
+		CHECK(!Loads(RawTrace().Resource(1, upload).Finish()));	//ids out of order
+		CHECK(!Loads(RawTrace().Put(static_cast<uint8_t>(0xFF)).Finish()));
+		CHECK(!Loads(RawTrace().Put(Op::DeclarePipeline).Put(0u).Put(1u).Finish(), 1));
+		CHECK(!Loads(RawTrace().Resource(0, upload).Put(Op::DeclareResource).Put(1u).Finish()));	//cut short
+
+		CHECK(!Loads(valid().BufferData(1, 0, 16, 16).Finish()));	//not an upload buffer
+		CHECK(!Loads(valid().BufferData(0, 200, 64, 64).Finish()));	//past its end
+		CHECK(!Loads(valid().BufferData(0, 0, 64, 63).Finish()));	//past the end of the trace
+		CHECK(!Loads(valid().Submit(0, copy).Finish()));	//not a command list
+		CHECK(!Loads(valid().Submit(2, copy).Put(Op::Submit).Put(2u).Put(uint64_t(1) << 40).Finish()));
+
+		// Damaged recordings.
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::Draw).Put(4u).Cut(1)).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::Barriers).Put(0xFFFFFFFFu).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::Reset).Put(2u).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::SetVertexBuffer).Put(9u).Put(28u).Put(28u).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::SetVertexBuffer).Put(1u).Put(28u).Put(512u).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::BeginQuery).Put(1u).Put(0u).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::BeginQuery).Put(3u).Put(4u).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::ResolveQuery).Put(3u).Put(2u).Put(3u).Put(1u).Put(uint64_t(0)).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::SetPredication).Put(1u).Put(uint64_t(252)).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::CopyBuffer).Put(1u).Put(uint64_t(1)).Put(0u).Put(uint64_t(0)).Put(uint64_t(256)).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::SetPipeline).Put(0u).Close()).Finish()));
+		CHECK(!Loads(valid().Submit(2, Recording().Put(Op::DeclareResource).Close()).Finish()));
+	}
+
+	// An upload buffer is captured whole the first time a submission reads it; after that only
+	// the ranges read, and only when they changed. Replayed, every copy reads what it did when
+	// captured.
+	void TestUploadDeltas()
+	{
+		const uint64_t uploadSize = 1024, rangeSize = 64;
+		const uint32_t frames = 5;
+		Null::Device device;
+		Capture::TraceWriter writer;
+		Capture::CaptureDevice captureDevice(&device, &writer);
+		unique_ptr<IResource> upload = captureDevice.CreateResource(ResourceDesc::Buffer(uploadSize, HeapKind::Upload), Rendering::StateCommon);
+		unique_ptr<IResource> destination = captureDevice.CreateResource(ResourceDesc::Buffer(rangeSize * frames), Rendering::StateCopyDest);
+		unique_ptr<ICommandList> commandList = captureDevice.CreateCommandList(1);
+		uint8_t* data = static_cast<uint8_t*>(upload->Map());
+		for (uint64_t i = 0; i < uploadSize; i++)
+		{
+			data[i] = static_cast<uint8_t>(i * 7);
+		}
+
+		// Frame by frame: the byte changed before, and the range read.
+		const int64_t changed[frames] = { -1, -1, 500, -1, 3 };
+		const uint64_t read[frames] = { 0, 0, 0, 448, 0 };
+		size_t growth[frames];
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			if (changed[frame] >= 0)
+			{
+				data[changed[frame]] ^= 0xFF;
+			}
+			const size_t before = writer.GetSize();
+			commandList->Reset(0);
+			commandList->CopyBuffer(destination.get(), frame * rangeSize, upload.get(), read[frame], rangeSize);
+			commandList->Close();
+			captureDevice.GetQueue()->Submit(commandList.get());
+			growth[frame] = writer.GetSize() - before;
+		}
+		const size_t bufferData = 1 + sizeof(uint32_t) + 2 * sizeof(uint64_t);
+		CHECK(growth[0] == growth[1] + bufferData + uploadSize);
+		CHECK(growth[2] == growth[1]);	//the change is outside the range read
+		CHECK(growth[3] == growth[1] + bufferData + rangeSize);	//and read here
+		CHECK(growth[4] == growth[1] + bufferData + rangeSize);
+		if (!CHECK(writer.Save(TracePath)))
+		{
+			return;
+		}
+
+		KeepingDevice replayDevice;
+		Capture::TraceReplayer replayer;
+		if (CHECK(replayer.Open(TracePath) && replayer.Load(&replayDevice, {})) && CHECK(replayDevice.resources.size() == 2))
+		{
+			CHECK(replayer.Run().submits == frames);
+			CHECK(Equal(replayDevice.resources[1], destination.get()));
+		}
+	}
+
+	// A resource created at the address of a destroyed one gets a new id, and a command list
+	// that cached the old one records the new one from its next Reset.
+	void TestIdReuse()
+	{
+		const uint64_t size = 128;
+		Null::Device device;
+		Capture::TraceWriter writer;
+		Capture::CaptureDevice captureDevice(&device, &writer);
+		unique_ptr<IResource> destination = captureDevice.CreateResource(ResourceDesc::Buffer(2 * size), Rendering::StateCopyDest);
+		unique_ptr<ICommandList> commandList = captureDevice.CreateCommandList(1);
+		Null::Resource upload(ResourceDesc::Buffer(size, HeapKind::Upload));
+		writer.DeclareResource(&upload, Rendering::StateCommon);
+
+		for (uint32_t frame = 0; frame < 2; frame++)
+		{
+			if (frame)
+			{
+				// The buffer destroyed and another created in its place: here the same object, declared again.
+				const uint32_t generation = writer.GetGeneration(), id = writer.GetId(&upload);
+				writer.DeclareResource(&upload, Rendering::StateCommon);
+				CHECK(writer.GetGeneration() != generation && writer.GetId(&upload) != id);
+			}
+			memset(upload.GetMemory(), frame + 1, size);
+			commandList->Reset(0);
+			commandList->CopyBuffer(destination.get(), frame * size, &upload, 0, size);
+			commandList->Close();
+			captureDevice.GetQueue()->Submit(commandList.get());
+		}
+		if (!CHECK(writer.Save(TracePath)))
+		{
+			return;
+		}
+
+		KeepingDevice replayDevice;
+		Capture::TraceReplayer replayer;
+		if (CHECK(replayer.Open(TracePath) && replayer.Load(&replayDevice, {})) && CHECK(replayDevice.resources.size() == 3))
+		{
+			replayer.Run();
+			CHECK(Equal(replayDevice.resources[0], destination.get()));
+		}
+	}
+}
+
+int main()
+{
+	TestNullRoundTrip();
+	TestSoftwareRoundTrip();
+	TestDamagedFiles();
+	TestMalformedRecords();
+	TestUploadDeltas();
+	TestIdReuse();
+	remove("CommandTraceTest.trace");
+	return Testing::Finish("CommandTraceTest");
+}
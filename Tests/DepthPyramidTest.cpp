@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "DepthPyramid.h"
+#include "Check.h"
+
+using namespace Query;
+using Culling::DepthPyramid;
+
+namespace
+{
+	// Random depths with runs of cleared pixels, pitch floats per row.
+	vector<float> GenerateDepth(uint32_t width, uint32_t height, uint32_t pitch, uint32_t seed)
+	{
+		Benchmark::Random random(seed);
+		vector<float> depth(static_cast<size_t>(pitch) * height, -1.0f);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				depth[static_cast<size_t>(y) * pitch + x] = random.Next() % 8 ? random.Uniform() : 1.0f;
+			}
+		}
+		return depth;
+	}
+
+	// The farthest depth of the pixels of the size x size block at (x, y), cut at the buffer's edges.
+	float BlockMax(const vector<float>& depth, uint32_t width, uint32_t height, uint32_t pitch, uint32_t x, uint32_t y, uint32_t size)
+	{
+		float farthest = 0;
+		for (uint32_t py = y * size; py < (y + 1) * size && py < height; py++)
+		{
+			for (uint32_t px = x * size; px < (x + 1) * size && px < width; px++)
+			{
+				const float value = depth[static_cast<size_t>(py) * pitch + px];
+				farthest = value > farthest ? value : farthest;
+			}
+		}
+		return farthest;
+	}
+
+	bool Equal(float a, float b)
+	{
+		return memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	// Downsample of every small size, odd and even, by each shift: both paths give the max of
+	// every block, bit for bit.
+	void TestDownsample()
+	{
+		uint32_t mismatches = 0;
+		for (uint32_t height = 1; height <= 19; height += 3)
+		{
+			for (uint32_t width = 1; width <= 41; width++)
+			{
+				const uint32_t pitch = width + 3;
+				const vector<float> depth = GenerateDepth(width, height, pitch, width * 64 + height);
+				for (uint32_t shift = 1; shift <= 3; shift++)
+				{
+					const uint32_t texelsX = (width + (1u << shift) - 1) >> shift, texelsY = (height + (1u << shift) - 1) >> shift;
+					vector<float> scalar(static_cast<size_t>(texelsX) * texelsY), simd(scalar.size());
+					DepthPyramid::Downsample(depth.data(), width, height, pitch, shift, scalar.data(), texelsX, false);
+					DepthPyramid::Downsample(depth.data(), width, height, pitch, shift, simd.data(), texelsX, true);
+					for (uint32_t y = 0; y < texelsY; y++)
+					{
+						for (uint32_t x = 0; x < texelsX; x++)
+						{
+							const float expected = BlockMax(depth, width, height, pitch, x, y, 1u << shift);
+							const size_t texel = static_cast<size_t>(y) * texelsX + x;
+							mismatches += !Equal(scalar[texel], expected) || !Equal(simd[texel], expected);
+						}
+					}
+				}
+			}
+		}
+		CHECK(mismatches == 0);
+	}
+
+	// Every level of the scalar, SSE and parallel builds, against the max of the pixels each texel covers.
+	void TestBuild(Threading::ThreadPool& pool, uint32_t width, uint32_t height)
+	{
+		const uint32_t pitch = width + 5;
+		const vector<float> depth = GenerateDepth(width, height, pitch, width + height);
+		DepthPyramid scalar, simd, parallel;
+		scalar.Build(depth.data(), width, height, pitch, nullptr, false);
+		simd.Build(depth.data(), width, height, pitch, nullptr, true);
+		parallel.Build(depth.data(), width, height, pitch, &pool, true);
+		if (!CHECK(scalar.GetLevelCount() && simd.GetLevelCount() == scalar.GetLevelCount() && parallel.GetLevelCount() == scalar.GetLevelCount()))
+		{
+			return;
+		}
+		const DepthPyramid::Level& last = scalar.GetLevel(scalar.GetLevelCount() - 1);
+		CHECK(last.width == 1 && last.height == 1);
+
+		uint32_t mismatches = 0;
+		for (uint32_t level = 0; level < scalar.GetLevelCount(); level++)
+		{
+			const DepthPyramid::Level& info = scalar.GetLevel(level);
+			CHECK(info.width == ((width - 1) >> (level + 1)) + 1 && info.height == ((height - 1) >> (level + 1)) + 1);
+			for (uint32_t y = 0; y < info.height; y++)
+			{
+				for (uint32_t x = 0; x < info.width; x++)
+				{
+					const float expected = BlockMax(depth, width, height, pitch, x, y, 2u << level);
+					const size_t texel = static_cast<size_t>(y) * info.pitch + x;
+					mismatches += !Equal(scalar.GetTexels(level)[texel], expected) || !Equal(simd.GetTexels(level)[texel], expected) ||
+						!Equal(parallel.GetTexels(level)[texel], expected);
+				}
+			}
+		}
+		CHECK(mismatches == 0);
+	}
+
+	// The occludees of a generated scene: the pyramid never rejects one that a pixel under it is
+	// farther than, and rejects most of those that every pixel hides.
+	void TestOcclusion()
+	{
+		Benchmark::SceneDesc desc;
+		desc.occluders = 256;
+		desc.occludees = 5000;
+		desc.sizes = Benchmark::SizeDistribution::PowerLaw;
+		desc.animation = Rendering::Animation::None;
+		const Rendering::Scene scene = Benchmark::GenerateScene(desc);
+		const uint32_t width = 640, height = 360;
+		vector<float> depth;
+		Benchmark::DrawDepth(scene.occluders, width, height, depth);
+		DepthPyramid pyramid;
+		pyramid.Build(depth.data(), width, height, width);
+
+		uint32_t unsafe = 0, rejected = 0, hidden = 0;
+		for (const Rendering::Quad& quad : scene.occludees)
+		{
+			const Culling::Bounds bounds = { { quad.left, quad.bottom, quad.depth }, { quad.right, quad.top, quad.depth } };
+			const bool occluded = pyramid.IsOccluded(bounds);
+			const bool exact = Benchmark::IsHidden(bounds, depth, width, height);
+			unsafe += occluded && !exact;
+			rejected += occluded;
+			hidden += exact;
+		}
+		CHECK(unsafe == 0);
+		CHECK(rejected > hidden / 2);
+
+		// Nothing off the screen is occluded, nor anything in front of every occluder.
+		CHECK(!pyramid.IsOccluded({ { 1.5f, -0.5f, 0.9f }, { 2.0f, 0.5f, 0.9f } }));
+		CHECK(!pyramid.IsOccluded({ { -0.5f, -0.5f, 0.01f }, { 0.5f, 0.5f, 0.01f } }));
+		DepthPyramid empty;
+		CHECK(!empty.IsOccluded({ { -0.5f, -0.5f, 0.9f }, { 0.5f, 0.5f, 0.9f } }));
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	TestDownsample();
+	for (uint32_t size : { 1u, 2u, 3u, 7u, 64u, 129u })
+	{
+		TestBuild(pool, size, size);
+	}
+	TestBuild(pool, 1920, 1080);
+	TestBuild(pool, 1023, 1);
+	TestBuild(pool, 5, 731);
+	TestOcclusion();
+	return Testing::Finish("DepthPyramidTest");
+}
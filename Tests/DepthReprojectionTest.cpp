@@ -0,0 +1,172 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "DepthReprojection.h"
+#include "Check.h"
+
+using namespace Query;
+using Culling::DepthReprojection;
+using Culling::ReprojectionMotion;
+
+namespace
+{
+	const uint32_t Width = 640, Height = 360;
+
+	// Drifting occluders of a generated scene seen by a camera that pans along x: each frame's
+	// depth and the previous frame's, with the motion of every previous pixel's nearest occluder.
+	class Pan
+	{
+	private:
+		Rendering::Scene m_scene;
+		Rendering::SceneStore m_store;
+		vector<float> m_offsets;
+		vector<Rendering::Quad> m_quads;
+		vector<float> m_quadMotions;
+		float m_cameraSpeed;
+
+		void Place(uint32_t frame)
+		{
+			const float camera = m_cameraSpeed * frame;
+			for (size_t i = 0; i < m_quads.size(); i++)
+			{
+				const Rendering::Quad& quad = m_scene.occluders[i];
+				const float x = m_store.GetOffsetX(static_cast<uint32_t>(i)) - camera, y = m_store.GetOffsetY(static_cast<uint32_t>(i));
+				m_quads[i].left = quad.left + x;
+				m_quads[i].right = quad.right + x;
+				m_quads[i].bottom = quad.bottom + y;
+				m_quads[i].top = quad.top + y;
+			}
+		}
+
+	public:
+		vector<float> previous, motions, current;
+
+		Pan(uint32_t occluders, float cameraSpeed, Rendering::Animation animation) : m_cameraSpeed(cameraSpeed)
+		{
+			Benchmark::SceneDesc desc;
+			desc.occluders = occluders;
+			desc.occludees = 2000;
+			desc.sizes = Benchmark::SizeDistribution::PowerLaw;
+			desc.animation = animation;
+			m_scene = Benchmark::GenerateScene(desc);
+			if (animation == Rendering::Animation::Drift)
+			{
+				Rendering::SceneRenderer::AddDrift(m_scene.occluders, m_store);
+			}
+			else
+			{
+				for (const Rendering::Quad& quad : m_scene.occluders)
+				{
+					m_store.Add(quad.left, quad.bottom, quad.right, quad.top, 0, 0);
+				}
+			}
+			m_offsets.resize(static_cast<size_t>(occluders) * 4);
+			m_quads = m_scene.occluders;
+			m_quadMotions.resize(static_cast<size_t>(occluders) * 2);
+		}
+
+		const vector<Rendering::Quad>& GetOccludees() const { return m_scene.occludees; }
+
+		// Draws frame - 1 and frame, moving the occluders in between.
+		void Step(uint32_t frame)
+		{
+			Place(frame - 1);
+			const uint32_t count = static_cast<uint32_t>(m_quads.size());
+			for (uint32_t i = 0; i < count; i++)
+			{
+				m_quadMotions[2 * i] = m_store.GetOffsetX(i);
+				m_quadMotions[2 * i + 1] = m_store.GetOffsetY(i);
+			}
+			Rendering::SceneStore::Output output;
+			output.destination = reinterpret_cast<uint8_t*>(m_offsets.data());
+			output.stride = 4 * sizeof(float);
+			m_store.Update(output);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				m_quadMotions[2 * i] = m_store.GetOffsetX(i) - m_quadMotions[2 * i];
+				m_quadMotions[2 * i + 1] = m_store.GetOffsetY(i) - m_quadMotions[2 * i + 1];
+			}
+			Benchmark::DrawDepth(m_quads, Width, Height, previous, m_quadMotions.data(), &motions);
+			Place(frame);
+			Benchmark::DrawDepth(m_quads, Width, Height, current);
+		}
+	};
+
+	// Every frame of a pan: the SSE and scalar paths agree bit for bit, and a pyramid of the
+	// reprojected depth never rejects an occludee that this frame's depth does not hide. Returns
+	// the holes over all frames.
+	uint64_t TestPan(Rendering::Animation animation, float cameraSpeed)
+	{
+		Pan pan(128, cameraSpeed, animation);
+		DepthReprojection simd, scalar;
+		Culling::DepthPyramid pyramid;
+		vector<float> reprojected(static_cast<size_t>(Width) * Height), reference(reprojected.size());
+		uint32_t mismatches = 0, unsafe = 0, rejected = 0;
+		uint64_t holes = 0;
+		for (uint32_t frame = 1; frame <= 12; frame++)
+		{
+			pan.Step(frame);
+			ReprojectionMotion motion;
+			motion.cameraX = -cameraSpeed;
+			if (animation == Rendering::Animation::Drift)
+			{
+				motion.objects = pan.motions.data();
+				motion.objectPitch = Width;
+			}
+			simd.Reproject(pan.previous.data(), Width, Height, Width, motion, reprojected.data(), Width, true);
+			scalar.Reproject(pan.previous.data(), Width, Height, Width, motion, reference.data(), Width, false);
+			mismatches += memcmp(reprojected.data(), reference.data(), reprojected.size() * sizeof(float)) != 0;
+			mismatches += simd.GetHoleCount() != scalar.GetHoleCount();
+			holes += simd.GetHoleCount();
+
+			pyramid.Build(reprojected.data(), Width, Height, Width);
+			const float camera = cameraSpeed * frame;
+			for (const Rendering::Quad& quad : pan.GetOccludees())
+			{
+				const Culling::Bounds bounds = { { quad.left - camera, quad.bottom, quad.depth }, { quad.right - camera, quad.top, quad.depth } };
+				const bool occluded = pyramid.IsOccluded(bounds);
+				rejected += occluded;
+				unsafe += occluded && !Benchmark::IsHidden(bounds, pan.current, Width, Height);
+			}
+		}
+		CHECK(mismatches == 0);
+		CHECK(unsafe == 0);
+		CHECK(rejected > 0);
+		return holes;
+	}
+
+	// An occluder that moves right by four pixels uncovers a strip on its left: those pixels and
+	// the ring of neighbors that may see the edge are beyond the far plane, and the rest of the
+	// occluder is kept.
+	void TestHoles()
+	{
+		const uint32_t width = 64, height = 32;
+		vector<float> previous(static_cast<size_t>(width) * height, 1.0f), motions(previous.size() * 2, 0.0f);
+		for (uint32_t y = 8; y < 24; y++)
+		{
+			for (uint32_t x = 16; x < 48; x++)
+			{
+				previous[static_cast<size_t>(y) * width + x] = 0.25f;
+				motions[(static_cast<size_t>(y) * width + x) * 2] = 4 * 2.0f / width;
+			}
+		}
+		ReprojectionMotion motion;
+		motion.objects = motions.data();
+		motion.objectPitch = width;
+		DepthReprojection reprojection;
+		vector<float> current(previous.size());
+		reprojection.Reproject(previous.data(), width, height, width, motion, current.data(), width);
+		CHECK(reprojection.GetHoleCount() >= 4 * 16);
+		CHECK(current[16 * width + 17] >= 1.0f && current[16 * width + 19] >= 1.0f);
+		CHECK(current[16 * width + 32] == 0.25f && current[16 * width + 50] == 0.25f);
+		CHECK(current[16 * width + 53] == 1.0f);
+	}
+}
+
+int main()
+{
+	TestPan(Rendering::Animation::None, 0.005f);
+	CHECK(TestPan(Rendering::Animation::Drift, 0.005f) > 0);
+	TestPan(Rendering::Animation::Drift, 0.0f);
+	TestHoles();
+	return Testing::Finish("DepthReprojectionTest");
+}
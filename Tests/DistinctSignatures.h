@@ -0,0 +1,37 @@
+#pragma once
+
+// Distinct version 1.1 root signatures, built at run time with the d3dx12 helpers: 1 to 4 tables of
+// 1 to 3 ranges, root constants and a root CBV, every seed below 100 a different signature.
+namespace Query {
+	namespace Testing
+	{
+		struct DistinctSignature
+		{
+			vector<CD3DX12_DESCRIPTOR_RANGE1> ranges;
+			vector<CD3DX12_ROOT_PARAMETER1> parameters;
+			CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC desc;
+
+			explicit DistinctSignature(UINT seed)
+			{
+				const UINT tables = 1 + seed % 4;
+				const UINT rangesPerTable = 1 + seed % 3;
+				ranges.resize(tables * rangesPerTable);
+				for (UINT i = 0; i < ranges.size(); i++)
+				{
+					ranges[i].Init(static_cast<D3D12_DESCRIPTOR_RANGE_TYPE>(i % 3), 1 + (seed + i) % 8, i, seed / 10,
+						D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
+				}
+				parameters.resize(tables + 2);
+				for (UINT t = 0; t < tables; t++)
+				{
+					parameters[t].InitAsDescriptorTable(rangesPerTable, &ranges[t * rangesPerTable], D3D12_SHADER_VISIBILITY_PIXEL);
+				}
+				parameters[tables].InitAsConstants(4 + seed % 5, 0, 1);
+				parameters[tables + 1].InitAsConstantBufferView(1, 1, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_VERTEX);
+				desc.Init_1_1(UINT(parameters.size()), parameters.data(), 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+			}
+			DistinctSignature(const DistinctSignature&) = delete;
+			DistinctSignature& operator=(const DistinctSignature&) = delete;
+		};
+	}
+}
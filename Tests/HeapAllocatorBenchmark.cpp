@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "HeapAllocator.h"
+#include <random>
+
+using namespace Query;
+using Memory::TlsfAllocator;
+
+namespace
+{
+	struct Result
+	{
+		const char* pattern;
+		uint64_t maxSize;
+		double allocateNanoseconds = 0;
+		double freeNanoseconds = 0;
+		double failed = 0;	//fraction of the requests
+		double used = 0;	//average fraction of the block in use
+	};
+
+	// Objects streaming in and out of one 256MB block at 64KB granularity: sizes up to maxSize, a
+	// quarter at 4MB alignment, and a random object freed whenever more than half the block is in
+	// use. With full set, objects are only freed when a request fails, so the block stays nearly
+	// full, the good-fit search often fails and the allocator falls back to searching block by block.
+	Result Run(const char* pattern, uint64_t maxSize, bool full, uint32_t operations)
+	{
+		const uint64_t capacity = 256ull * 1024 * 1024;
+		mt19937_64 random(1);
+		vector<uint64_t> sizes(operations), alignments(operations);
+		for (uint32_t i = 0; i < operations; i++)
+		{
+			sizes[i] = 64 * 1024 + random() % maxSize;
+			alignments[i] = random() % 4 ? 64 * 1024 : 4 * 1024 * 1024;
+		}
+
+		Result result = { pattern, maxSize };
+		TlsfAllocator allocator(capacity, 64 * 1024);
+		vector<TlsfAllocator::Allocation> live;
+		live.reserve(operations);
+		uint32_t failures = 0, frees = 0;
+		double allocateSeconds = 0, freeSeconds = 0, used = 0;
+		for (uint32_t i = 0; i < operations; i++)
+		{
+			TlsfAllocator::Allocation allocation;
+			auto start = chrono::steady_clock::now();
+			const bool allocated = allocator.Allocate(sizes[i], alignments[i], allocation);
+			allocateSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			if (allocated)
+			{
+				live.push_back(allocation);
+			}
+			else
+			{
+				failures++;
+			}
+
+			const bool release = full ? !allocated : allocator.GetUsedSize() > capacity / 2;
+			if (release && !live.empty())
+			{
+				const size_t index = random() % live.size();
+				start = chrono::steady_clock::now();
+				allocator.Free(live[index]);
+				freeSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+				live[index] = live.back();
+				live.pop_back();
+				frees++;
+			}
+			used += static_cast<double>(allocator.GetUsedSize()) / capacity;
+		}
+		result.allocateNanoseconds = allocateSeconds * 1e9 / operations;
+		result.freeNanoseconds = frees ? freeSeconds * 1e9 / frees : 0;
+		result.failed = static_cast<double>(failures) / operations;
+		result.used = used / operations;
+		return result;
+	}
+}
+
+int main()
+{
+	const Result results[] = {
+		Run("streaming", 1ull << 20, false, 1000000),
+		Run("streaming", 8ull << 20, false, 1000000),
+		Run("full", 1ull << 20, true, 1000000),
+		Run("full", 8ull << 20, true, 1000000) };
+
+	printf("{\n\t\"benchmark\": \"tlsf\",\n\t\"runs\": [");
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& result = results[i];
+		printf("%s\n\t\t{ \"pattern\": \"%s\", \"maxSize\": %llu, \"allocateNs\": %.1f, \"freeNs\": %.1f, \"failed\": %.4f, \"used\": %.4f }",
+			i ? "," : "", result.pattern, static_cast<unsigned long long>(result.maxSize),
+			result.allocateNanoseconds, result.freeNanoseconds, result.failed, result.used);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
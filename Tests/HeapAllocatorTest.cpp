@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "HeapAllocator.h"
+#include "Check.h"
+#include <random>
+
+using namespace Query;
+using Memory::TlsfAllocator;
+
+namespace
+{
+	const uint64_t Granularity = 64 * 1024;	//D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+	const uint64_t TargetAlignment = 4 * 1024 * 1024;	//D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Whether any gap between the live allocations could hold size at alignment, the way
+	// TlsfAllocator rounds both.
+	bool Fits(const vector<TlsfAllocator::Allocation>& live, uint64_t capacity, uint64_t size, uint64_t alignment)
+	{
+		size = AlignUp(size, Granularity);
+		alignment = alignment > Granularity ? alignment : Granularity;
+		vector<TlsfAllocator::Allocation> sorted = live;
+		sort(sorted.begin(), sorted.end(), [](const TlsfAllocator::Allocation& a, const TlsfAllocator::Allocation& b) { return a.offset < b.offset; });
+		uint64_t start = 0;
+		for (size_t i = 0; i <= sorted.size(); i++)
+		{
+			const uint64_t end = i < sorted.size() ? sorted[i].offset : capacity;
+			if (AlignUp(start, alignment) + size <= end)
+			{
+				return true;
+			}
+			if (i < sorted.size())
+			{
+				start = sorted[i].offset + sorted[i].size;
+			}
+		}
+		return false;
+	}
+
+	// A resource larger than a heap block gets a dedicated heap of its own size, which the
+	// allocator has to hand out whole even though its size class is not one a request of that size
+	// is rounded up to.
+	void TestDedicatedBlocks()
+	{
+		for (uint64_t units : { 1ull, 15ull, 16ull, 17ull, 1024ull, 1025ull, 1041ull, 1088ull, 2000ull, 4097ull, 65535ull })
+		{
+			const uint64_t size = units * Granularity;
+			TlsfAllocator allocator(size, Granularity);
+			TlsfAllocator::Allocation allocation;
+			CHECK(allocator.Allocate(size, Granularity, allocation));
+			CHECK(allocation.offset == 0 && allocation.size == size);
+			CHECK(allocator.Validate());
+			allocator.Free(allocation);
+			CHECK(allocator.Validate() && allocator.IsEmpty());
+
+			// Render targets and depth buffers: 4MB placement in a heap rounded up to 4MB.
+			TlsfAllocator target(AlignUp(size, TargetAlignment), Granularity);
+			CHECK(target.Allocate(size, TargetAlignment, allocation));
+			CHECK(allocation.offset == 0);
+			CHECK(target.Validate());
+		}
+	}
+
+	// A freed block is reused by a request of exactly its size while the rest of the range is full.
+	void TestExactFit()
+	{
+		const uint64_t capacity = 256ull * 1024 * 1024;
+		TlsfAllocator allocator(capacity, Granularity);
+		TlsfAllocator::Allocation first, second, rest;
+		CHECK(allocator.Allocate(1025 * Granularity, Granularity, first));
+		CHECK(allocator.Allocate(Granularity, Granularity, second));
+		CHECK(allocator.Allocate(capacity - 1026 * Granularity, Granularity, rest));
+		allocator.Free(first);
+		CHECK(allocator.Allocate(1025 * Granularity, Granularity, first));
+		CHECK(first.offset == 0);
+		CHECK(!allocator.Allocate(Granularity, Granularity, second));
+		CHECK(allocator.Validate());
+	}
+
+	// Random allocations and frees of mixed sizes and alignments. Every allocation must be aligned,
+	// large enough and apart from every other, the allocator must stay consistent, and a request
+	// may only fail when no gap holds it.
+	void TestFuzz()
+	{
+		mt19937_64 random(1);
+		const uint64_t capacity = 256ull * 1024 * 1024;
+		for (uint32_t round = 0; round < 10; round++)
+		{
+			TlsfAllocator allocator(capacity, Granularity);
+			vector<TlsfAllocator::Allocation> live;
+			uint32_t failures = 0;
+			const uint32_t failedChecks = Testing::FailureCount();
+			for (uint32_t i = 0; i < 20000 && Testing::FailureCount() == failedChecks; i++)
+			{
+				if (live.empty() || random() % 3)
+				{
+					const uint64_t size = 1 + random() % (random() % 10 == 0 ? 32ull << 20 : 1ull << 20);
+					const uint64_t alignment = random() % 4 == 0 ? TargetAlignment : random() % 2 ? Granularity : 4096;
+					TlsfAllocator::Allocation allocation;
+					if (allocator.Allocate(size, alignment, allocation))
+					{
+						CHECK(allocation.offset % alignment == 0 && allocation.size >= size);
+						CHECK(allocation.offset + allocation.size <= capacity);
+						for (const TlsfAllocator::Allocation& other : live)
+						{
+							CHECK(allocation.offset + allocation.size <= other.offset || other.offset + other.size <= allocation.offset);
+						}
+						live.push_back(allocation);
+					}
+					else
+					{
+						CHECK(!Fits(live, capacity, size, alignment));
+						failures++;
+					}
+				}
+				else
+				{
+					const size_t index = random() % live.size();
+					allocator.Free(live[index]);
+					live[index] = live.back();
+					live.pop_back();
+				}
+				if (i % 97 == 0)
+				{
+					CHECK(allocator.Validate());
+				}
+			}
+			if (Testing::FailureCount() != failedChecks)
+			{
+				return;
+			}
+			CHECK(failures > 0);	//the range did fill up, so the fallback was exercised
+			for (const TlsfAllocator::Allocation& allocation : live)
+			{
+				allocator.Free(allocation);
+			}
+			CHECK(allocator.Validate() && allocator.IsEmpty() && allocator.GetUsedSize() == 0);
+		}
+	}
+}
+
+int main()
+{
+	TestDedicatedBlocks();
+	TestExactFit();
+	TestFuzz();
+	return Testing::Finish("HeapAllocatorTest");
+}
@@ -0,0 +1,1223 @@
+// Declarations of the part of the Direct3D 12 and Windows headers that d3dx12.h and the sample's
+// pipeline, root signature and upload code use, so that their tests build on Linux. Types, values
+// and layouts follow d3d12.h; interfaces only have the methods d3dx12.h calls, and nothing here
+// talks to a GPU. Tests that call a device or command list implement these interfaces themselves.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+
+//------------------------------------------------------------------------------------------------
+// Windows
+
+typedef int32_t HRESULT;
+typedef int32_t INT;
+typedef uint32_t UINT;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef uint32_t DWORD;
+typedef int BOOL;
+typedef uint8_t BYTE;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint64_t UINT64;
+typedef int64_t INT64;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t ULONG_PTR;
+typedef uintptr_t UINT_PTR;
+typedef void* HANDLE;
+typedef void* LPVOID;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+
+#define TRUE 1
+#define FALSE 0
+
+#define S_OK static_cast<HRESULT>(0)
+#define S_FALSE static_cast<HRESULT>(1)
+#define E_NOTIMPL static_cast<HRESULT>(0x80004001)
+#define E_NOINTERFACE static_cast<HRESULT>(0x80004002)
+#define E_POINTER static_cast<HRESULT>(0x80004003)
+#define E_FAIL static_cast<HRESULT>(0x80004005)
+#define E_OUTOFMEMORY static_cast<HRESULT>(0x8007000E)
+#define E_INVALIDARG static_cast<HRESULT>(0x80070057)
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+typedef GUID IID;
+#define REFIID const IID&
+#define REFGUID const GUID&
+// Interfaces are told apart by type here, never by IID.
+#define __uuidof(x) IID{}
+
+struct RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+#define WINAPI
+#define STDMETHODCALLTYPE
+#define DECLSPEC_SELECTANY __attribute__((weak))
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+
+// Source annotations.
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_range_(low, high)
+#define _In_reads_(size)
+#define _In_reads_opt_(size)
+#define _In_reads_bytes_(size)
+#define _In_reads_bytes_opt_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_opt_(size)
+#define _Out_writes_bytes_(size)
+#define _Out_writes_bytes_opt_(size)
+#define _Inout_
+#define _Inout_opt_
+#define _Inout_updates_(size)
+#define _Outptr_
+#define _Outptr_opt_
+#define _Outptr_opt_result_maybenull_
+#define _COM_Outptr_
+#define _COM_Outptr_opt_
+#define _Use_decl_annotations_
+#define _Must_inspect_result_
+#define _Success_(expression)
+#define _Field_size_(size)
+#define _Field_size_full_(size)
+#define _Field_size_bytes_full_(size)
+#define _Always_(annotation)
+#define _When_(condition, annotation)
+#define _Analysis_assume_(expression)
+#define __analysis_assume(expression)
+
+#define DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE) \
+	inline ENUMTYPE operator|(ENUMTYPE a, ENUMTYPE b) { return static_cast<ENUMTYPE>(static_cast<uint64_t>(a) | static_cast<uint64_t>(b)); } \
+	inline ENUMTYPE& operator|=(ENUMTYPE& a, ENUMTYPE b) { return a = a | b; } \
+	inline ENUMTYPE operator&(ENUMTYPE a, ENUMTYPE b) { return static_cast<ENUMTYPE>(static_cast<uint64_t>(a) & static_cast<uint64_t>(b)); } \
+	inline ENUMTYPE& operator&=(ENUMTYPE& a, ENUMTYPE b) { return a = a & b; } \
+	inline ENUMTYPE operator~(ENUMTYPE a) { return static_cast<ENUMTYPE>(~static_cast<uint64_t>(a)); }
+
+// The process heap is the C heap. Every HeapAlloc is counted, so that tests can check that a path
+// does not allocate.
+namespace D3D12Linux
+{
+	inline std::atomic<uint64_t>& HeapAllocations()
+	{
+		static std::atomic<uint64_t> allocations(0);
+		return allocations;
+	}
+}
+
+inline HANDLE GetProcessHeap()
+{
+	static int heap;
+	return &heap;
+}
+
+inline LPVOID HeapAlloc(HANDLE, DWORD, SIZE_T size)
+{
+	D3D12Linux::HeapAllocations()++;
+	return malloc(size);
+}
+
+inline BOOL HeapFree(HANDLE, DWORD, LPVOID memory)
+{
+	free(memory);
+	return TRUE;
+}
+
+struct IUnknown
+{
+	virtual HRESULT QueryInterface(REFIID riid, void** ppvObject) = 0;
+	virtual ULONG AddRef() = 0;
+	virtual ULONG Release() = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// DXGI
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_TYPELESS = 1,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32A32_UINT = 3,
+	DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_TYPELESS = 5,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R32G32B32_UINT = 7,
+	DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R16G16B16A16_TYPELESS = 9,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R16G16B16A16_UINT = 12,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R16G16B16A16_SINT = 14,
+	DXGI_FORMAT_R32G32_TYPELESS = 15,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R32G32_UINT = 17,
+	DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R11G11B10_FLOAT = 26,
+	DXGI_FORMAT_R8G8B8A8_TYPELESS = 27,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DXGI_FORMAT_R8G8B8A8_UINT = 30,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R32_TYPELESS = 39,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R32_SINT = 43,
+	DXGI_FORMAT_R24G8_TYPELESS = 44,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R16_FLOAT = 54,
+	DXGI_FORMAT_D16_UNORM = 55,
+	DXGI_FORMAT_R16_UNORM = 56,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_R8_UNORM = 61,
+	DXGI_FORMAT_BC1_UNORM = 71,
+	DXGI_FORMAT_BC3_UNORM = 77,
+	DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+	DXGI_FORMAT_BC7_UNORM = 98,
+	DXGI_FORMAT_NV12 = 103
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+//------------------------------------------------------------------------------------------------
+// Direct3D 12 constants
+
+#define D3D12_DEFAULT_DEPTH_BIAS (0)
+#define D3D12_DEFAULT_DEPTH_BIAS_CLAMP (0.0f)
+#define D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS (0.0f)
+#define D3D12_DEFAULT_STENCIL_READ_MASK (0xff)
+#define D3D12_DEFAULT_STENCIL_WRITE_MASK (0xff)
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT (65536)
+#define D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT (4194304)
+#define D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND (0xffffffff)
+#define D3D12_FLOAT32_MAX (3.402823466e+38f)
+#define D3D12_MIN_DEPTH (0.0f)
+#define D3D12_MAX_DEPTH (1.0f)
+#define D3D12_REQ_SUBRESOURCES (30720)
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES (0xffffffff)
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT (8)
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT (256)
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT (512)
+
+//------------------------------------------------------------------------------------------------
+// Interfaces
+
+struct ID3D12RootSignature;
+struct ID3D12PipelineState;
+struct ID3D12Device;
+
+struct ID3D10Blob : IUnknown
+{
+	virtual LPVOID GetBufferPointer() = 0;
+	virtual SIZE_T GetBufferSize() = 0;
+};
+typedef ID3D10Blob ID3DBlob;
+
+struct ID3D12Object : IUnknown
+{
+};
+
+struct ID3D12DeviceChild : ID3D12Object
+{
+	virtual HRESULT GetDevice(REFIID riid, void** ppvDevice) = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// Pipeline state
+
+struct D3D12_SHADER_BYTECODE
+{
+	const void* pShaderBytecode;
+	SIZE_T BytecodeLength;
+};
+
+struct D3D12_SO_DECLARATION_ENTRY
+{
+	UINT Stream;
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	BYTE StartComponent;
+	BYTE ComponentCount;
+	BYTE OutputSlot;
+};
+
+struct D3D12_STREAM_OUTPUT_DESC
+{
+	const D3D12_SO_DECLARATION_ENTRY* pSODeclaration;
+	UINT NumEntries;
+	const UINT* pBufferStrides;
+	UINT NumStrides;
+	UINT RasterizedStream;
+};
+
+enum D3D12_BLEND
+{
+	D3D12_BLEND_ZERO = 1,
+	D3D12_BLEND_ONE = 2,
+	D3D12_BLEND_SRC_COLOR = 3,
+	D3D12_BLEND_INV_SRC_COLOR = 4,
+	D3D12_BLEND_SRC_ALPHA = 5,
+	D3D12_BLEND_INV_SRC_ALPHA = 6,
+	D3D12_BLEND_DEST_ALPHA = 7,
+	D3D12_BLEND_INV_DEST_ALPHA = 8,
+	D3D12_BLEND_DEST_COLOR = 9,
+	D3D12_BLEND_INV_DEST_COLOR = 10,
+	D3D12_BLEND_SRC_ALPHA_SAT = 11,
+	D3D12_BLEND_BLEND_FACTOR = 14,
+	D3D12_BLEND_INV_BLEND_FACTOR = 15,
+	D3D12_BLEND_SRC1_COLOR = 16,
+	D3D12_BLEND_INV_SRC1_COLOR = 17,
+	D3D12_BLEND_SRC1_ALPHA = 18,
+	D3D12_BLEND_INV_SRC1_ALPHA = 19
+};
+
+enum D3D12_BLEND_OP
+{
+	D3D12_BLEND_OP_ADD = 1,
+	D3D12_BLEND_OP_SUBTRACT = 2,
+	D3D12_BLEND_OP_REV_SUBTRACT = 3,
+	D3D12_BLEND_OP_MIN = 4,
+	D3D12_BLEND_OP_MAX = 5
+};
+
+enum D3D12_LOGIC_OP
+{
+	D3D12_LOGIC_OP_CLEAR = 0,
+	D3D12_LOGIC_OP_SET = 1,
+	D3D12_LOGIC_OP_COPY = 2,
+	D3D12_LOGIC_OP_COPY_INVERTED = 3,
+	D3D12_LOGIC_OP_NOOP = 4,
+	D3D12_LOGIC_OP_INVERT = 5,
+	D3D12_LOGIC_OP_AND = 6,
+	D3D12_LOGIC_OP_NAND = 7,
+	D3D12_LOGIC_OP_OR = 8,
+	D3D12_LOGIC_OP_NOR = 9,
+	D3D12_LOGIC_OP_XOR = 10,
+	D3D12_LOGIC_OP_EQUIV = 11,
+	D3D12_LOGIC_OP_AND_REVERSE = 12,
+	D3D12_LOGIC_OP_AND_INVERTED = 13,
+	D3D12_LOGIC_OP_OR_REVERSE = 14,
+	D3D12_LOGIC_OP_OR_INVERTED = 15
+};
+
+enum D3D12_COLOR_WRITE_ENABLE
+{
+	D3D12_COLOR_WRITE_ENABLE_RED = 1,
+	D3D12_COLOR_WRITE_ENABLE_GREEN = 2,
+	D3D12_COLOR_WRITE_ENABLE_BLUE = 4,
+	D3D12_COLOR_WRITE_ENABLE_ALPHA = 8,
+	D3D12_COLOR_WRITE_ENABLE_ALL = 15
+};
+
+struct D3D12_RENDER_TARGET_BLEND_DESC
+{
+	BOOL BlendEnable;
+	BOOL LogicOpEnable;
+	D3D12_BLEND SrcBlend;
+	D3D12_BLEND DestBlend;
+	D3D12_BLEND_OP BlendOp;
+	D3D12_BLEND SrcBlendAlpha;
+	D3D12_BLEND DestBlendAlpha;
+	D3D12_BLEND_OP BlendOpAlpha;
+	D3D12_LOGIC_OP LogicOp;
+	UINT8 RenderTargetWriteMask;
+};
+
+struct D3D12_BLEND_DESC
+{
+	BOOL AlphaToCoverageEnable;
+	BOOL IndependentBlendEnable;
+	D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+enum D3D12_FILL_MODE
+{
+	D3D12_FILL_MODE_WIREFRAME = 2,
+	D3D12_FILL_MODE_SOLID = 3
+};
+
+enum D3D12_CULL_MODE
+{
+	D3D12_CULL_MODE_NONE = 1,
+	D3D12_CULL_MODE_FRONT = 2,
+	D3D12_CULL_MODE_BACK = 3
+};
+
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE
+{
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF = 0,
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON = 1
+};
+
+struct D3D12_RASTERIZER_DESC
+{
+	D3D12_FILL_MODE FillMode;
+	D3D12_CULL_MODE CullMode;
+	BOOL FrontCounterClockwise;
+	INT DepthBias;
+	FLOAT DepthBiasClamp;
+	FLOAT SlopeScaledDepthBias;
+	BOOL DepthClipEnable;
+	BOOL MultisampleEnable;
+	BOOL AntialiasedLineEnable;
+	UINT ForcedSampleCount;
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster;
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+	D3D12_COMPARISON_FUNC_NEVER = 1,
+	D3D12_COMPARISON_FUNC_LESS = 2,
+	D3D12_COMPARISON_FUNC_EQUAL = 3,
+	D3D12_COMPARISON_FUNC_LESS_EQUAL = 4,
+	D3D12_COMPARISON_FUNC_GREATER = 5,
+	D3D12_COMPARISON_FUNC_NOT_EQUAL = 6,
+	D3D12_COMPARISON_FUNC_GREATER_EQUAL = 7,
+	D3D12_COMPARISON_FUNC_ALWAYS = 8
+};
+
+enum D3D12_DEPTH_WRITE_MASK
+{
+	D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D12_DEPTH_WRITE_MASK_ALL = 1
+};
+
+enum D3D12_STENCIL_OP
+{
+	D3D12_STENCIL_OP_KEEP = 1,
+	D3D12_STENCIL_OP_ZERO = 2,
+	D3D12_STENCIL_OP_REPLACE = 3,
+	D3D12_STENCIL_OP_INCR_SAT = 4,
+	D3D12_STENCIL_OP_DECR_SAT = 5,
+	D3D12_STENCIL_OP_INVERT = 6,
+	D3D12_STENCIL_OP_INCR = 7,
+	D3D12_STENCIL_OP_DECR = 8
+};
+
+struct D3D12_DEPTH_STENCILOP_DESC
+{
+	D3D12_STENCIL_OP StencilFailOp;
+	D3D12_STENCIL_OP StencilDepthFailOp;
+	D3D12_STENCIL_OP StencilPassOp;
+	D3D12_COMPARISON_FUNC StencilFunc;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC1
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+	BOOL DepthBoundsTestEnable;
+};
+
+enum D3D12_INPUT_CLASSIFICATION
+{
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1
+};
+
+struct D3D12_INPUT_ELEMENT_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D12_INPUT_LAYOUT_DESC
+{
+	const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs;
+	UINT NumElements;
+};
+
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE
+{
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED = 0,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF = 1,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF = 2
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE
+{
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT = 1,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE = 2,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH = 4
+};
+
+struct D3D12_CACHED_PIPELINE_STATE
+{
+	const void* pCachedBlob;
+	SIZE_T CachedBlobSizeInBytes;
+};
+
+enum D3D12_PIPELINE_STATE_FLAGS
+{
+	D3D12_PIPELINE_STATE_FLAG_NONE = 0,
+	D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG = 0x1
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_PIPELINE_STATE_FLAGS)
+
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature* pRootSignature;
+	D3D12_SHADER_BYTECODE VS;
+	D3D12_SHADER_BYTECODE PS;
+	D3D12_SHADER_BYTECODE DS;
+	D3D12_SHADER_BYTECODE HS;
+	D3D12_SHADER_BYTECODE GS;
+	D3D12_STREAM_OUTPUT_DESC StreamOutput;
+	D3D12_BLEND_DESC BlendState;
+	UINT SampleMask;
+	D3D12_RASTERIZER_DESC RasterizerState;
+	D3D12_DEPTH_STENCIL_DESC DepthStencilState;
+	D3D12_INPUT_LAYOUT_DESC InputLayout;
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue;
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType;
+	UINT NumRenderTargets;
+	DXGI_FORMAT RTVFormats[8];
+	DXGI_FORMAT DSVFormat;
+	DXGI_SAMPLE_DESC SampleDesc;
+	UINT NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+struct D3D12_COMPUTE_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature* pRootSignature;
+	D3D12_SHADER_BYTECODE CS;
+	UINT NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+struct D3D12_RT_FORMAT_ARRAY
+{
+	DXGI_FORMAT RTFormats[8];
+	UINT NumRenderTargets;
+};
+
+struct D3D12_PIPELINE_STATE_STREAM_DESC
+{
+	SIZE_T SizeInBytes;
+	void* pPipelineStateSubobjectStream;
+};
+
+enum D3D12_PIPELINE_STATE_SUBOBJECT_TYPE
+{
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE = 0,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS = 1,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS = 2,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS = 3,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS = 4,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS = 5,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS = 6,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT = 7,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND = 8,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK = 9,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER = 10,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL = 11,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT = 12,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE = 13,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY = 14,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS = 15,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT = 16,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC = 17,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK = 18,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO = 19,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS = 20,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1 = 21,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING = 22,
+	D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID = 23
+};
+
+struct D3D12_VIEW_INSTANCE_LOCATION
+{
+	UINT ViewportArrayIndex;
+	UINT RenderTargetArrayIndex;
+};
+
+enum D3D12_VIEW_INSTANCING_FLAGS
+{
+	D3D12_VIEW_INSTANCING_FLAG_NONE = 0,
+	D3D12_VIEW_INSTANCING_FLAG_ENABLE_VIEW_INSTANCE_MASKING = 0x1
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_VIEW_INSTANCING_FLAGS)
+
+struct D3D12_VIEW_INSTANCING_DESC
+{
+	UINT ViewInstanceCount;
+	const D3D12_VIEW_INSTANCE_LOCATION* pViewInstanceLocations;
+	D3D12_VIEW_INSTANCING_FLAGS Flags;
+};
+
+//------------------------------------------------------------------------------------------------
+// Resources
+
+struct D3D12_VIEWPORT
+{
+	FLOAT TopLeftX;
+	FLOAT TopLeftY;
+	FLOAT Width;
+	FLOAT Height;
+	FLOAT MinDepth;
+	FLOAT MaxDepth;
+};
+
+typedef RECT D3D12_RECT;
+
+struct D3D12_BOX
+{
+	UINT left;
+	UINT top;
+	UINT front;
+	UINT right;
+	UINT bottom;
+	UINT back;
+};
+
+struct D3D12_RANGE
+{
+	SIZE_T Begin;
+	SIZE_T End;
+};
+
+struct D3D12_RANGE_UINT64
+{
+	UINT64 Begin;
+	UINT64 End;
+};
+
+struct D3D12_SUBRESOURCE_RANGE_UINT64
+{
+	UINT Subresource;
+	D3D12_RANGE_UINT64 Range;
+};
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE
+{
+	SIZE_T ptr;
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+	UINT64 ptr;
+};
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+enum D3D12_HEAP_TYPE
+{
+	D3D12_HEAP_TYPE_DEFAULT = 1,
+	D3D12_HEAP_TYPE_UPLOAD = 2,
+	D3D12_HEAP_TYPE_READBACK = 3,
+	D3D12_HEAP_TYPE_CUSTOM = 4
+};
+
+enum D3D12_CPU_PAGE_PROPERTY
+{
+	D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0,
+	D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE = 1,
+	D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE = 2,
+	D3D12_CPU_PAGE_PROPERTY_WRITE_BACK = 3
+};
+
+enum D3D12_MEMORY_POOL
+{
+	D3D12_MEMORY_POOL_UNKNOWN = 0,
+	D3D12_MEMORY_POOL_L0 = 1,
+	D3D12_MEMORY_POOL_L1 = 2
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+	D3D12_HEAP_TYPE Type;
+	D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+	D3D12_MEMORY_POOL MemoryPoolPreference;
+	UINT CreationNodeMask;
+	UINT VisibleNodeMask;
+};
+
+enum D3D12_HEAP_FLAGS
+{
+	D3D12_HEAP_FLAG_NONE = 0,
+	D3D12_HEAP_FLAG_SHARED = 0x1,
+	D3D12_HEAP_FLAG_DENY_BUFFERS = 0x4,
+	D3D12_HEAP_FLAG_ALLOW_DISPLAY = 0x8,
+	D3D12_HEAP_FLAG_SHARED_CROSS_ADAPTER = 0x20,
+	D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES = 0x40,
+	D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES = 0x80,
+	D3D12_HEAP_FLAG_HARDWARE_PROTECTED = 0x100,
+	D3D12_HEAP_FLAG_ALLOW_WRITE_WATCH = 0x200,
+	D3D12_HEAP_FLAG_ALLOW_SHADER_ATOMICS = 0x400,
+	D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES = 0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES = 0x44,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES = 0x84
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_HEAP_FLAGS)
+
+struct D3D12_HEAP_DESC
+{
+	UINT64 SizeInBytes;
+	D3D12_HEAP_PROPERTIES Properties;
+	UINT64 Alignment;
+	D3D12_HEAP_FLAGS Flags;
+};
+
+enum D3D12_RESOURCE_DIMENSION
+{
+	D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D12_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D12_RESOURCE_DIMENSION_TEXTURE2D = 3,
+	D3D12_RESOURCE_DIMENSION_TEXTURE3D = 4
+};
+
+enum D3D12_TEXTURE_LAYOUT
+{
+	D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+	D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1,
+	D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE = 2,
+	D3D12_TEXTURE_LAYOUT_64KB_STANDARD_SWIZZLE = 3
+};
+
+enum D3D12_RESOURCE_FLAGS
+{
+	D3D12_RESOURCE_FLAG_NONE = 0,
+	D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+	D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+	D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4,
+	D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE = 0x8,
+	D3D12_RESOURCE_FLAG_ALLOW_CROSS_ADAPTER = 0x10,
+	D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS = 0x20
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_FLAGS)
+
+struct D3D12_RESOURCE_DESC
+{
+	D3D12_RESOURCE_DIMENSION Dimension;
+	UINT64 Alignment;
+	UINT64 Width;
+	UINT Height;
+	UINT16 DepthOrArraySize;
+	UINT16 MipLevels;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D12_TEXTURE_LAYOUT Layout;
+	D3D12_RESOURCE_FLAGS Flags;
+};
+
+struct D3D12_RESOURCE_ALLOCATION_INFO
+{
+	UINT64 SizeInBytes;
+	UINT64 Alignment;
+};
+
+struct D3D12_DEPTH_STENCIL_VALUE
+{
+	FLOAT Depth;
+	UINT8 Stencil;
+};
+
+struct D3D12_CLEAR_VALUE
+{
+	DXGI_FORMAT Format;
+	union
+	{
+		FLOAT Color[4];
+		D3D12_DEPTH_STENCIL_VALUE DepthStencil;
+	};
+};
+
+enum D3D12_RESOURCE_STATES
+{
+	D3D12_RESOURCE_STATE_COMMON = 0,
+	D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+	D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+	D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+	D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+	D3D12_RESOURCE_STATE_DEPTH_READ = 0x20,
+	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	D3D12_RESOURCE_STATE_STREAM_OUT = 0x100,
+	D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+	D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+	D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+	D3D12_RESOURCE_STATE_RESOLVE_DEST = 0x1000,
+	D3D12_RESOURCE_STATE_RESOLVE_SOURCE = 0x2000,
+	D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3,
+	D3D12_RESOURCE_STATE_PRESENT = 0,
+	D3D12_RESOURCE_STATE_PREDICATION = 0x200
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_STATES)
+
+struct ID3D12Resource : ID3D12DeviceChild
+{
+	virtual HRESULT Map(UINT Subresource, const D3D12_RANGE* pReadRange, void** ppData) = 0;
+	virtual void Unmap(UINT Subresource, const D3D12_RANGE* pWrittenRange) = 0;
+	virtual D3D12_RESOURCE_DESC GetDesc() = 0;
+	virtual D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() = 0;
+};
+
+enum D3D12_RESOURCE_BARRIER_TYPE
+{
+	D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+	D3D12_RESOURCE_BARRIER_TYPE_ALIASING = 1,
+	D3D12_RESOURCE_BARRIER_TYPE_UAV = 2
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS
+{
+	D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+	D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+	D3D12_RESOURCE_BARRIER_FLAG_END_ONLY = 0x2
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_BARRIER_FLAGS)
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+	ID3D12Resource* pResource;
+	UINT Subresource;
+	D3D12_RESOURCE_STATES StateBefore;
+	D3D12_RESOURCE_STATES StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER
+{
+	ID3D12Resource* pResourceBefore;
+	ID3D12Resource* pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER
+{
+	ID3D12Resource* pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER
+{
+	D3D12_RESOURCE_BARRIER_TYPE Type;
+	D3D12_RESOURCE_BARRIER_FLAGS Flags;
+	union
+	{
+		D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+		D3D12_RESOURCE_ALIASING_BARRIER Aliasing;
+		D3D12_RESOURCE_UAV_BARRIER UAV;
+	};
+};
+
+struct D3D12_SUBRESOURCE_FOOTPRINT
+{
+	DXGI_FORMAT Format;
+	UINT Width;
+	UINT Height;
+	UINT Depth;
+	UINT RowPitch;
+};
+
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT
+{
+	UINT64 Offset;
+	D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+};
+
+enum D3D12_TEXTURE_COPY_TYPE
+{
+	D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX = 0,
+	D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT = 1
+};
+
+struct D3D12_TEXTURE_COPY_LOCATION
+{
+	ID3D12Resource* pResource;
+	D3D12_TEXTURE_COPY_TYPE Type;
+	union
+	{
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT PlacedFootprint;
+		UINT SubresourceIndex;
+	};
+};
+
+struct D3D12_SUBRESOURCE_DATA
+{
+	const void* pData;
+	LONG_PTR RowPitch;
+	LONG_PTR SlicePitch;
+};
+
+struct D3D12_MEMCPY_DEST
+{
+	void* pData;
+	SIZE_T RowPitch;
+	SIZE_T SlicePitch;
+};
+
+struct D3D12_TILED_RESOURCE_COORDINATE
+{
+	UINT X;
+	UINT Y;
+	UINT Z;
+	UINT Subresource;
+};
+
+struct D3D12_TILE_REGION_SIZE
+{
+	UINT NumTiles;
+	BOOL UseBox;
+	UINT Width;
+	UINT16 Height;
+	UINT16 Depth;
+};
+
+struct D3D12_SUBRESOURCE_TILING
+{
+	UINT WidthInTiles;
+	UINT16 HeightInTiles;
+	UINT16 DepthInTiles;
+	UINT StartTileIndexInOverallResource;
+};
+
+struct D3D12_TILE_SHAPE
+{
+	UINT WidthInTexels;
+	UINT HeightInTexels;
+	UINT DepthInTexels;
+};
+
+struct D3D12_PACKED_MIP_INFO
+{
+	UINT8 NumStandardMips;
+	UINT8 NumPackedMips;
+	UINT NumTilesForPackedMips;
+	UINT StartTileIndexInOverallResource;
+};
+
+enum D3D12_FEATURE
+{
+	D3D12_FEATURE_D3D12_OPTIONS = 0,
+	D3D12_FEATURE_ARCHITECTURE = 1,
+	D3D12_FEATURE_FEATURE_LEVELS = 2,
+	D3D12_FEATURE_FORMAT_SUPPORT = 3,
+	D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS = 4,
+	D3D12_FEATURE_FORMAT_INFO = 5
+};
+
+struct D3D12_FEATURE_DATA_FORMAT_INFO
+{
+	DXGI_FORMAT Format;
+	UINT8 PlaneCount;
+};
+
+struct ID3D12Device : ID3D12Object
+{
+	virtual HRESULT CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize) = 0;
+	virtual void GetCopyableFootprints(const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource, UINT NumSubresources,
+		UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes,
+		UINT64* pTotalBytes) = 0;
+};
+
+enum D3D12_COMMAND_LIST_TYPE
+{
+	D3D12_COMMAND_LIST_TYPE_DIRECT = 0,
+	D3D12_COMMAND_LIST_TYPE_BUNDLE = 1,
+	D3D12_COMMAND_LIST_TYPE_COMPUTE = 2,
+	D3D12_COMMAND_LIST_TYPE_COPY = 3
+};
+
+struct ID3D12CommandList : ID3D12DeviceChild
+{
+	virtual D3D12_COMMAND_LIST_TYPE GetType() = 0;
+};
+
+struct ID3D12GraphicsCommandList : ID3D12CommandList
+{
+	virtual void CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset,
+		UINT64 NumBytes) = 0;
+	virtual void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ,
+		const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox) = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// Root signatures
+
+enum D3D12_DESCRIPTOR_RANGE_TYPE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE_SRV = 0,
+	D3D12_DESCRIPTOR_RANGE_TYPE_UAV = 1,
+	D3D12_DESCRIPTOR_RANGE_TYPE_CBV = 2,
+	D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER = 3
+};
+
+struct D3D12_DESCRIPTOR_RANGE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+	UINT NumDescriptors;
+	UINT BaseShaderRegister;
+	UINT RegisterSpace;
+	UINT OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE
+{
+	UINT NumDescriptorRanges;
+	const D3D12_DESCRIPTOR_RANGE* pDescriptorRanges;
+};
+
+struct D3D12_ROOT_CONSTANTS
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	UINT Num32BitValues;
+};
+
+struct D3D12_ROOT_DESCRIPTOR
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+};
+
+enum D3D12_SHADER_VISIBILITY
+{
+	D3D12_SHADER_VISIBILITY_ALL = 0,
+	D3D12_SHADER_VISIBILITY_VERTEX = 1,
+	D3D12_SHADER_VISIBILITY_HULL = 2,
+	D3D12_SHADER_VISIBILITY_DOMAIN = 3,
+	D3D12_SHADER_VISIBILITY_GEOMETRY = 4,
+	D3D12_SHADER_VISIBILITY_PIXEL = 5
+};
+
+enum D3D12_ROOT_PARAMETER_TYPE
+{
+	D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE = 0,
+	D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS = 1,
+	D3D12_ROOT_PARAMETER_TYPE_CBV = 2,
+	D3D12_ROOT_PARAMETER_TYPE_SRV = 3,
+	D3D12_ROOT_PARAMETER_TYPE_UAV = 4
+};
+
+struct D3D12_ROOT_PARAMETER
+{
+	D3D12_ROOT_PARAMETER_TYPE ParameterType;
+	union
+	{
+		D3D12_ROOT_DESCRIPTOR_TABLE DescriptorTable;
+		D3D12_ROOT_CONSTANTS Constants;
+		D3D12_ROOT_DESCRIPTOR Descriptor;
+	};
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+enum D3D12_ROOT_SIGNATURE_FLAGS
+{
+	D3D12_ROOT_SIGNATURE_FLAG_NONE = 0,
+	D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT = 0x1,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS = 0x2,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS = 0x4,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS = 0x8,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS = 0x10,
+	D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS = 0x20,
+	D3D12_ROOT_SIGNATURE_FLAG_ALLOW_STREAM_OUTPUT = 0x40,
+	D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE = 0x80
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_ROOT_SIGNATURE_FLAGS)
+
+enum D3D12_STATIC_BORDER_COLOR
+{
+	D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK = 0,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK = 1,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE = 2
+};
+
+enum D3D12_FILTER
+{
+	D3D12_FILTER_MIN_MAG_MIP_POINT = 0,
+	D3D12_FILTER_MIN_MAG_POINT_MIP_LINEAR = 0x1,
+	D3D12_FILTER_MIN_POINT_MAG_LINEAR_MIP_POINT = 0x4,
+	D3D12_FILTER_MIN_POINT_MAG_MIP_LINEAR = 0x5,
+	D3D12_FILTER_MIN_LINEAR_MAG_MIP_POINT = 0x10,
+	D3D12_FILTER_MIN_LINEAR_MAG_POINT_MIP_LINEAR = 0x11,
+	D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT = 0x14,
+	D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+	D3D12_FILTER_ANISOTROPIC = 0x55,
+	D3D12_FILTER_COMPARISON_MIN_MAG_MIP_POINT = 0x80,
+	D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR = 0x95,
+	D3D12_FILTER_COMPARISON_ANISOTROPIC = 0xd5
+};
+
+enum D3D12_TEXTURE_ADDRESS_MODE
+{
+	D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1,
+	D3D12_TEXTURE_ADDRESS_MODE_MIRROR = 2,
+	D3D12_TEXTURE_ADDRESS_MODE_CLAMP = 3,
+	D3D12_TEXTURE_ADDRESS_MODE_BORDER = 4,
+	D3D12_TEXTURE_ADDRESS_MODE_MIRROR_ONCE = 5
+};
+
+struct D3D12_STATIC_SAMPLER_DESC
+{
+	D3D12_FILTER Filter;
+	D3D12_TEXTURE_ADDRESS_MODE AddressU;
+	D3D12_TEXTURE_ADDRESS_MODE AddressV;
+	D3D12_TEXTURE_ADDRESS_MODE AddressW;
+	FLOAT MipLODBias;
+	UINT MaxAnisotropy;
+	D3D12_COMPARISON_FUNC ComparisonFunc;
+	D3D12_STATIC_BORDER_COLOR BorderColor;
+	FLOAT MinLOD;
+	FLOAT MaxLOD;
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_ROOT_SIGNATURE_DESC
+{
+	UINT NumParameters;
+	const D3D12_ROOT_PARAMETER* pParameters;
+	UINT NumStaticSamplers;
+	const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers;
+	D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+enum D3D12_DESCRIPTOR_RANGE_FLAGS
+{
+	D3D12_DESCRIPTOR_RANGE_FLAG_NONE = 0,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE = 0x1,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE = 0x2,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE = 0x4,
+	D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC = 0x8
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_DESCRIPTOR_RANGE_FLAGS)
+
+struct D3D12_DESCRIPTOR_RANGE1
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+	UINT NumDescriptors;
+	UINT BaseShaderRegister;
+	UINT RegisterSpace;
+	D3D12_DESCRIPTOR_RANGE_FLAGS Flags;
+	UINT OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE1
+{
+	UINT NumDescriptorRanges;
+	const D3D12_DESCRIPTOR_RANGE1* pDescriptorRanges;
+};
+
+enum D3D12_ROOT_DESCRIPTOR_FLAGS
+{
+	D3D12_ROOT_DESCRIPTOR_FLAG_NONE = 0,
+	D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE = 0x2,
+	D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE = 0x4,
+	D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC = 0x8
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_ROOT_DESCRIPTOR_FLAGS)
+
+struct D3D12_ROOT_DESCRIPTOR1
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	D3D12_ROOT_DESCRIPTOR_FLAGS Flags;
+};
+
+struct D3D12_ROOT_PARAMETER1
+{
+	D3D12_ROOT_PARAMETER_TYPE ParameterType;
+	union
+	{
+		D3D12_ROOT_DESCRIPTOR_TABLE1 DescriptorTable;
+		D3D12_ROOT_CONSTANTS Constants;
+		D3D12_ROOT_DESCRIPTOR1 Descriptor;
+	};
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_ROOT_SIGNATURE_DESC1
+{
+	UINT NumParameters;
+	const D3D12_ROOT_PARAMETER1* pParameters;
+	UINT NumStaticSamplers;
+	const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers;
+	D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+enum D3D_ROOT_SIGNATURE_VERSION
+{
+	D3D_ROOT_SIGNATURE_VERSION_1 = 0x1,
+	D3D_ROOT_SIGNATURE_VERSION_1_0 = 0x1,
+	D3D_ROOT_SIGNATURE_VERSION_1_1 = 0x2
+};
+
+struct D3D12_VERSIONED_ROOT_SIGNATURE_DESC
+{
+	D3D_ROOT_SIGNATURE_VERSION Version;
+	union
+	{
+		D3D12_ROOT_SIGNATURE_DESC Desc_1_0;
+		D3D12_ROOT_SIGNATURE_DESC1 Desc_1_1;
+	};
+};
+
+struct ID3D12RootSignature : ID3D12DeviceChild
+{
+};
+
+// There is no serializer without Direct3D 12. Tests that reach one provide these.
+HRESULT WINAPI D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* pRootSignature, D3D_ROOT_SIGNATURE_VERSION Version,
+	ID3DBlob** ppBlob, ID3DBlob** ppErrorBlob);
+HRESULT WINAPI D3D12SerializeVersionedRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignature,
+	ID3DBlob** ppBlob, ID3DBlob** ppErrorBlob);
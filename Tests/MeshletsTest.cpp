@@ -0,0 +1,201 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "Meshlets.h"
+#include "Check.h"
+
+using namespace Query;
+using Culling::Meshlet;
+using Culling::MeshletBuilder;
+using Culling::MeshletCuller;
+
+namespace
+{
+	struct Mesh
+	{
+		vector<float> positions;
+		vector<uint32_t> indices;
+	};
+
+	Mesh GenerateBlob(uint32_t seed, uint32_t rings)
+	{
+		Benchmark::Random random(seed);
+		Mesh mesh;
+		Benchmark::GenerateBlob(random, rings, mesh.positions, mesh.indices);
+		return mesh;
+	}
+
+	const float* GetPoint(const Mesh& mesh, const MeshletBuilder& builder, const Meshlet& meshlet, uint32_t vertex)
+	{
+		return mesh.positions.data() + static_cast<size_t>(builder.GetVertices()[meshlet.vertexOffset + vertex]) * 3;
+	}
+
+	// The triangle's unnormalized normal by the right-hand rule, as the builder takes it.
+	void GetNormal(const float* a, const float* b, const float* c, float normal[3])
+	{
+		const float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		normal[0] = u[1] * v[2] - u[2] * v[1];
+		normal[1] = u[2] * v[0] - u[0] * v[2];
+		normal[2] = u[0] * v[1] - u[1] * v[0];
+	}
+
+	// Every triangle of the mesh is in exactly one meshlet with its winding, each meshlet keeps to
+	// the limits, and its sphere holds its vertices.
+	void TestBuild(const Mesh& mesh, const MeshletBuilder& builder, uint32_t maxVertices, uint32_t maxTriangles)
+	{
+		// Triangles as their vertex indices, rotated to start at the smallest, so winding is kept.
+		auto key = [](uint32_t a, uint32_t b, uint32_t c)
+		{
+			const uint32_t first = a < b ? (a < c ? 0 : 2) : (b < c ? 1 : 2);
+			const uint32_t corners[3] = { a, b, c };
+			return array<uint32_t, 3>{ corners[first], corners[(first + 1) % 3], corners[(first + 2) % 3] };
+		};
+		vector<array<uint32_t, 3>> expected, found;
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			expected.push_back(key(mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2]));
+		}
+
+		uint32_t oversized = 0, outOfRange = 0, outside = 0;
+		for (const Meshlet& meshlet : builder.GetMeshlets())
+		{
+			oversized += meshlet.vertexCount > maxVertices || meshlet.triangleCount > maxTriangles || !meshlet.triangleCount;
+			for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+			{
+				const uint8_t* corners = builder.GetTriangles().data() + meshlet.triangleOffset + triangle * 3;
+				outOfRange += corners[0] >= meshlet.vertexCount || corners[1] >= meshlet.vertexCount || corners[2] >= meshlet.vertexCount;
+				const uint32_t* vertices = builder.GetVertices().data() + meshlet.vertexOffset;
+				found.push_back(key(vertices[corners[0]], vertices[corners[1]], vertices[corners[2]]));
+			}
+			for (uint32_t vertex = 0; vertex < meshlet.vertexCount; vertex++)
+			{
+				const float* point = GetPoint(mesh, builder, meshlet, vertex);
+				const float dx = point[0] - meshlet.center[0], dy = point[1] - meshlet.center[1], dz = point[2] - meshlet.center[2];
+				outside += sqrtf(dx * dx + dy * dy + dz * dz) > meshlet.radius * 1.0001f + 1e-6f;
+			}
+		}
+		sort(expected.begin(), expected.end());
+		sort(found.begin(), found.end());
+		CHECK(found == expected);
+		CHECK(oversized == 0);
+		CHECK(outOfRange == 0);
+		CHECK(outside == 0);
+	}
+
+	// Culls every meshlet on its own along direction: none rejected as facing away has a triangle
+	// facing the view, and none rejected as occluded has a vertex in front of depth at any pixel
+	// of their bounds. Returns the meshlets rejected each way.
+	void TestCull(const Mesh& mesh, const MeshletBuilder& builder, const float direction[3], const Culling::DepthPyramid* pyramid,
+		const vector<float>& depth, uint32_t width, uint32_t height, uint32_t& backfacing, uint32_t& occluded)
+	{
+		MeshletCuller culler;
+		MeshletCuller::View view;
+		view.direction[0] = direction[0];
+		view.direction[1] = direction[1];
+		view.direction[2] = direction[2];
+		view.pyramid = pyramid;
+		vector<uint32_t> visible;
+		uint32_t unsafe = 0;
+		for (const Meshlet& meshlet : builder.GetMeshlets())
+		{
+			culler.Cull(&meshlet, 1, view, visible);
+			CHECK(visible.size() + culler.GetBackfacingCount() + culler.GetOccludedCount() == 1);
+			backfacing += culler.GetBackfacingCount();
+			occluded += culler.GetOccludedCount();
+			if (culler.GetBackfacingCount())
+			{
+				for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+				{
+					const uint8_t* corners = builder.GetTriangles().data() + meshlet.triangleOffset + triangle * 3;
+					float normal[3];
+					GetNormal(GetPoint(mesh, builder, meshlet, corners[0]), GetPoint(mesh, builder, meshlet, corners[1]),
+						GetPoint(mesh, builder, meshlet, corners[2]), normal);
+					unsafe += normal[0] * direction[0] + normal[1] * direction[1] + normal[2] * direction[2] < 0;
+				}
+			}
+			if (culler.GetOccludedCount())
+			{
+				Culling::Bounds bounds = Culling::Bounds::Empty();
+				for (uint32_t vertex = 0; vertex < meshlet.vertexCount; vertex++)
+				{
+					const float* point = GetPoint(mesh, builder, meshlet, vertex);
+					bounds.Grow(point, point);
+				}
+				unsafe += !Benchmark::IsHidden(bounds, depth, width, height);
+			}
+		}
+		CHECK(unsafe == 0);
+
+		// All at once, the same meshlets pass.
+		vector<uint32_t> all;
+		culler.Cull(builder.GetMeshlets().data(), static_cast<uint32_t>(builder.GetMeshlets().size()), view, all);
+		CHECK(culler.GetBackfacingCount() + culler.GetOccludedCount() + all.size() == builder.GetMeshlets().size());
+	}
+
+	void TestMeshes(uint32_t maxVertices, uint32_t maxTriangles)
+	{
+		const uint32_t width = 640, height = 360;
+		Benchmark::Random random(3);
+		vector<Rendering::Quad> occluders(6);
+		for (Rendering::Quad& quad : occluders)
+		{
+			quad = Benchmark::PlaceQuad(random, 0.4f, 0.05f, 0.3f);
+		}
+		vector<float> depth;
+		Benchmark::DrawDepth(occluders, width, height, depth);
+		Culling::DepthPyramid pyramid;
+		pyramid.Build(depth.data(), width, height, width);
+
+		const float diagonal = sqrtf(1.0f / 3.0f);
+		const float directions[][3] = { { 0, 0, 1 }, { 0, 0, -1 }, { diagonal, -diagonal, diagonal } };
+		uint32_t backfacing = 0, occluded = 0, unoccluded = 0;
+		for (uint32_t seed = 1; seed <= 6; seed++)
+		{
+			const Mesh mesh = GenerateBlob(seed, 32);
+			MeshletBuilder builder;
+			builder.Build(mesh.positions.data(), 3 * sizeof(float), static_cast<uint32_t>(mesh.positions.size() / 3),
+				mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()), maxVertices, maxTriangles);
+			TestBuild(mesh, builder, maxVertices, maxTriangles);
+			for (const auto& direction : directions)
+			{
+				TestCull(mesh, builder, direction, &pyramid, depth, width, height, backfacing, occluded);
+			}
+			TestCull(mesh, builder, directions[0], nullptr, depth, width, height, backfacing, unoccluded);
+		}
+		CHECK(backfacing > 0);
+		CHECK(occluded > 0);
+		CHECK(unoccluded == 0);
+	}
+
+	// A mesh given with a stride past its positions builds the same meshlets; one without
+	// triangles builds none.
+	void TestStride()
+	{
+		const Mesh mesh = GenerateBlob(9, 16);
+		vector<float> vertices;
+		for (size_t i = 0; i < mesh.positions.size(); i += 3)
+		{
+			vertices.insert(vertices.end(), { mesh.positions[i], mesh.positions[i + 1], mesh.positions[i + 2], 7.0f, 7.0f });
+		}
+		const uint32_t vertexCount = static_cast<uint32_t>(mesh.positions.size() / 3), indexCount = static_cast<uint32_t>(mesh.indices.size());
+		MeshletBuilder packed, strided;
+		packed.Build(mesh.positions.data(), 3 * sizeof(float), vertexCount, mesh.indices.data(), indexCount);
+		strided.Build(vertices.data(), 5 * sizeof(float), vertexCount, mesh.indices.data(), indexCount);
+		CHECK(packed.GetVertices() == strided.GetVertices() && packed.GetTriangles() == strided.GetTriangles());
+		CHECK(packed.GetMeshlets().size() == strided.GetMeshlets().size() &&
+			memcmp(packed.GetMeshlets().data(), strided.GetMeshlets().data(), packed.GetMeshlets().size() * sizeof(Meshlet)) == 0);
+
+		MeshletBuilder empty;
+		empty.Build(mesh.positions.data(), 3 * sizeof(float), vertexCount, nullptr, 0);
+		CHECK(empty.GetMeshlets().empty());
+	}
+}
+
+int main()
+{
+	TestMeshes(MeshletBuilder::DefaultMaxVertices, MeshletBuilder::DefaultMaxTriangles);
+	TestMeshes(128, 252);
+	TestMeshes(16, 16);
+	TestStride();
+	return Testing::Finish("MeshletsTest");
+}
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "NullBackend.h"
+#include "HeadlessRunner.h"
+#include "Check.h"
+
+using namespace Query;
+using namespace Backend;
+
+namespace
+{
+	// A fence completes the moment it is signaled, and never goes back.
+	void TestFences()
+	{
+		Null::Device device;
+		unique_ptr<IFence> fence = device.CreateFence(3);
+		CHECK(fence->GetCompletedValue() == 3);
+		IQueue* queue = device.GetQueue();
+		for (uint64_t value = 4; value < 12; value++)
+		{
+			queue->Signal(fence.get(), value);
+			CHECK(fence->GetCompletedValue() == value);
+			fence->Wait(value);
+		}
+		queue->Signal(fence.get(), 5);
+		CHECK(fence->GetCompletedValue() == 11);
+	}
+
+	// Frames of two counted queries and one binary one, resolved into a buffer that predicates
+	// the next frame's draws. A query counts the vertices drawn inside it, and every period-th
+	// resolved query reads zero.
+	void TestQueries(uint32_t period)
+	{
+		Null::Device device;
+		device.GetNullQueue().SetOcclusionPeriod(period);
+		IQueue* queue = device.GetQueue();
+		unique_ptr<IQueryHeap> counted = device.CreateQueryHeap(QueryType::Occlusion, 2);
+		unique_ptr<IQueryHeap> binary = device.CreateQueryHeap(QueryType::BinaryOcclusion, 1);
+		unique_ptr<IResource> results = device.CreateResource(ResourceDesc::Buffer(3 * sizeof(uint64_t)), Rendering::StatePredication);
+		unique_ptr<IResource> readback = device.CreateResource(ResourceDesc::Buffer(3 * sizeof(uint64_t), HeapKind::Readback), Rendering::StateCopyDest);
+		unique_ptr<IFence> fence = device.CreateFence(0);
+		unique_ptr<ICommandList> commandList = device.CreateCommandList(2);
+
+		uint64_t resolves = 0;
+		bool predicate = true;	//the binary result of the last frame
+		for (uint32_t frame = 0; frame < 12; frame++)
+		{
+			const auto before = device.GetNullQueue().GetStats();
+			commandList->Reset(frame % 2);
+			if (frame)
+			{
+				commandList->SetPredication(results.get(), 2 * sizeof(uint64_t));
+			}
+			commandList->BeginQuery(counted.get(), 0);
+			commandList->Draw(4, 0);
+			commandList->Draw(3, 4);
+			commandList->EndQuery(counted.get(), 0);
+			commandList->SetPredication(nullptr, 0);
+			commandList->BeginQuery(counted.get(), 1);
+			commandList->Draw(frame, 0);
+			commandList->EndQuery(counted.get(), 1);
+			commandList->BeginQuery(binary.get(), 0);
+			commandList->Draw(4, 0);
+			commandList->EndQuery(binary.get(), 0);
+			commandList->ResolveQuery(counted.get(), 0, 2, results.get(), 0);
+			commandList->ResolveQuery(binary.get(), 0, 1, results.get(), 2 * sizeof(uint64_t));
+			commandList->CopyBuffer(readback.get(), 0, results.get(), 0, 3 * sizeof(uint64_t));
+			commandList->Close();
+			queue->Submit(commandList.get());
+			queue->Signal(fence.get(), frame + 1);
+			CHECK(fence->GetCompletedValue() == frame + 1);
+
+			// The first two draws are skipped while last frame's binary query read zero.
+			const auto& after = device.GetNullQueue().GetStats();
+			const uint64_t skipped = predicate ? 0 : 2;
+			CHECK(after.predicatedDraws - before.predicatedDraws == skipped);
+			CHECK(after.draws - before.draws == 4 - skipped);
+			CHECK(after.submits - before.submits == 1);
+			CHECK(after.queryResolves - before.queryResolves == 3);
+
+			const uint64_t* resolved = static_cast<const uint64_t*>(readback->Map());
+			const uint64_t expected[3] = { predicate ? 7u : 0u, frame, 1 };
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				resolves++;
+				const bool occluded = period && resolves % period == 0;
+				CHECK(resolved[i] == (occluded ? 0 : expected[i]));
+			}
+			predicate = resolved[2] != 0;
+			readback->Unmap();
+		}
+	}
+
+	// The sample's frame loop: each frame draws the far quad under the previous frame's query,
+	// the near quad and the query's bounding box, and resolves one query. Resolve k reads zero
+	// when k is a multiple of the period, skipping the far quad of frame k + 1. Every frame but the
+	// first, which has no result to predicate with, records the same commands.
+	void TestFrameLoop()
+	{
+		const uint32_t frames = 31;
+		for (uint32_t period : { 0u, 1u, 3u })
+		{
+			const Headless::RunResult result = Headless::Run(frames, 64, 32, period);
+			const uint64_t predicated = period ? (frames - 1) / period : 0;
+			CHECK(result.frames == frames && result.width == 64 && result.height == 32);
+			CHECK(result.predicatedDraws == predicated);
+			CHECK(result.draws + result.predicatedDraws == 3 * frames);
+			CHECK(result.commands > frames && (result.commands + 1) % frames == 0);
+		}
+
+		const string json = Headless::ToJson({ Headless::Run(10) });
+		CHECK(json.find("\"backend\": \"null\"") != string::npos && json.find("\"frames\": 10") != string::npos);
+	}
+}
+
+int main()
+{
+	TestFences();
+	for (uint32_t period : { 0u, 2u, 5u })
+	{
+		TestQueries(period);
+	}
+	TestFrameLoop();
+	return Testing::Finish("NullBackendTest");
+}
@@ -0,0 +1,258 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "DepthPyramid.h"
+#include "SoftwareBackend.h"
+#include "Check.h"
+
+using namespace Query;
+using Culling::Bounds;
+using Culling::OccluderSelector;
+
+namespace
+{
+	Rendering::Quad ToQuad(const Bounds& bounds)
+	{
+		Rendering::Quad quad = {};
+		quad.left = bounds.min[0];
+		quad.bottom = bounds.min[1];
+		quad.right = bounds.max[0];
+		quad.top = bounds.max[1];
+		quad.depth = bounds.max[2];
+		return quad;
+	}
+
+	bool Contains(const Bounds& outer, const Bounds& inner)
+	{
+		return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] && outer.max[0] >= inner.max[0] && outer.max[1] >= inner.max[1];
+	}
+
+	// The occluders of a generated scene with the triangle counts of real meshes: the selection
+	// fits the budget, each occluder it keeps lies on the screen and within its source, and the
+	// selected occluders never hide an occludee that every occluder does not.
+	void TestSelection(const OccluderSelector::Settings& settings, bool fused)
+	{
+		Benchmark::SceneDesc desc;
+		desc.occluders = 2048;
+		desc.occludees = 4000;
+		desc.sizes = Benchmark::SizeDistribution::PowerLaw;
+		desc.animation = Rendering::Animation::None;
+		const Rendering::Scene scene = Benchmark::GenerateScene(desc);
+		Benchmark::Random random(7);
+		vector<Bounds> bounds(desc.occluders);
+		vector<uint32_t> triangles(desc.occluders);
+		for (uint32_t i = 0; i < desc.occluders; i++)
+		{
+			const Rendering::Quad& quad = scene.occluders[i];
+			bounds[i] = { { quad.left, quad.bottom, quad.depth }, { quad.right, quad.top, quad.depth } };
+			triangles[i] = static_cast<uint32_t>(12.0f * powf(4096.0f / 12.0f, random.Uniform()));
+		}
+
+		OccluderSelector selector;
+		selector.Select(bounds.data(), triangles.data(), desc.occluders, settings);
+		const vector<OccluderSelector::Occluder>& selected = selector.GetSelected();
+		CHECK(!selected.empty() && selected.size() <= settings.maxOccluders);
+		CHECK(selector.GetSelectedTriangles() <= settings.maxTriangles);
+		CHECK((selector.GetFusionCount() > 0) == fused);
+		const Bounds screen = { { -1.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+		uint32_t outside = 0, fusedCount = 0, triangleSum = 0;
+		vector<Rendering::Quad> quads;
+		for (const OccluderSelector::Occluder& occluder : selected)
+		{
+			outside += !Contains(screen, occluder.bounds);
+			if (occluder.source == OccluderSelector::Fused)
+			{
+				fusedCount++;
+				triangleSum += OccluderSelector::QuadTriangles;
+			}
+			else
+			{
+				outside += !Contains(bounds[occluder.source], occluder.bounds) || occluder.bounds.max[2] != bounds[occluder.source].max[2];
+				triangleSum += triangles[occluder.source];
+			}
+			quads.push_back(ToQuad(occluder.bounds));
+		}
+		CHECK(outside == 0);
+		CHECK(triangleSum == selector.GetSelectedTriangles());
+		CHECK(fused || fusedCount == 0);
+
+		const uint32_t width = 480, height = 270;
+		vector<float> all, partial;
+		Benchmark::DrawDepth(scene.occluders, width, height, all);
+		Benchmark::DrawDepth(quads, width, height, partial);
+		uint32_t unsafe = 0, hidden = 0;
+		for (const Rendering::Quad& quad : scene.occludees)
+		{
+			const Bounds occludee = { { quad.left, quad.bottom, quad.depth }, { quad.right, quad.top, quad.depth } };
+			const bool selectedHides = Benchmark::IsHidden(occludee, partial, width, height);
+			unsafe += selectedHides && !Benchmark::IsHidden(occludee, all, width, height);
+			hidden += selectedHides;
+		}
+		CHECK(unsafe == 0);
+		CHECK(hidden > 0);
+	}
+
+	// Two small neighbors at close depths are fused into the rectangle spanning both, at the
+	// farther depth; too far apart in depth, they are kept as they are.
+	void TestFusion()
+	{
+		OccluderSelector::Settings settings;
+		OccluderSelector selector;
+		Bounds pair[] = { { { 0.0f, 0.0f, 0.5f }, { 0.05f, 0.1f, 0.5f } }, { { 0.05f, 0.0f, 0.52f }, { 0.1f, 0.1f, 0.52f } } };
+		selector.Select(pair, nullptr, 2, settings);
+		if (CHECK(selector.GetSelected().size() == 1))
+		{
+			const OccluderSelector::Occluder& occluder = selector.GetSelected()[0];
+			CHECK(occluder.source == OccluderSelector::Fused && occluder.triangles == OccluderSelector::QuadTriangles);
+			CHECK(occluder.bounds.min[0] == 0.0f && occluder.bounds.max[0] == 0.1f && occluder.bounds.min[1] == 0.0f && occluder.bounds.max[1] == 0.1f);
+			CHECK(occluder.bounds.max[2] == 0.52f);
+		}
+		CHECK(selector.GetFusionCount() == 1);
+
+		pair[1].min[2] = pair[1].max[2] = 0.6f;
+		selector.Select(pair, nullptr, 2, settings);
+		CHECK(selector.GetSelected().size() == 2 && selector.GetFusionCount() == 0);
+
+		// Off the screen, or too small once clipped to it.
+		const Bounds dropped[] = { { { 1.5f, 0.0f, 0.5f }, { 1.9f, 0.4f, 0.5f } }, { { 0.99f, 0.0f, 0.5f }, { 1.2f, 0.01f, 0.5f } } };
+		selector.Select(dropped, nullptr, 2, settings);
+		CHECK(selector.GetSelected().empty());
+	}
+
+	struct Frame
+	{
+		vector<uint64_t> visible;
+		vector<float> queryDepth;
+		size_t selected = 0;
+		uint32_t fused = 0;
+	};
+
+	Frame Render(Threading::ThreadPool& pool, const Rendering::Scene& scene, uint32_t width, uint32_t height, uint32_t shift,
+		const OccluderSelector::Settings* settings)
+	{
+		Backend::Software::Device device(&pool);
+		Backend::Software::SwapChain swapChain(Rendering::SceneRenderer::FrameCount, width, height);
+		Backend::Software::PipelineDesc queryDesc;
+		queryDesc.colorWrite = false;
+		queryDesc.depthWrite = false;
+		Backend::Software::Pipeline scenePipeline("Scene", Backend::Software::PipelineDesc());
+		Backend::Software::Pipeline queryPipeline("Query", queryDesc);
+		Rendering::SceneRenderer renderer;
+		renderer.Initialize(&device, &swapChain, width, height, &scene, shift, settings);
+		renderer.SetPipelines(&scenePipeline, &queryPipeline);
+		for (uint32_t i = 0; i < Rendering::SceneRenderer::FrameCount + 1; i++)
+		{
+			renderer.Update();
+			renderer.Render();
+		}
+		renderer.WaitForGpu();
+
+		Frame frame;
+		const uint64_t* visible = static_cast<const uint64_t*>(renderer.GetQueryResult()->Map());
+		frame.visible.assign(visible, visible + scene.occludees.size());
+		frame.selected = renderer.GetSelectedOccluders().size();
+		for (const OccluderSelector::Occluder& occluder : renderer.GetSelectedOccluders())
+		{
+			frame.fused += occluder.source == OccluderSelector::Fused;
+		}
+		if (shift)
+		{
+			auto* depth = static_cast<Backend::Software::Resource*>(renderer.GetQueryDepth());
+			const uint32_t texelsX = width >> shift, texelsY = height >> shift;
+			frame.queryDepth.resize(static_cast<size_t>(texelsX) * texelsY);
+			for (uint32_t y = 0; y < texelsY; y++)
+			{
+				memcpy(&frame.queryDepth[static_cast<size_t>(y) * texelsX], depth->GetDepths() + static_cast<size_t>(y) * depth->GetPitch(),
+					texelsX * sizeof(float));
+			}
+		}
+		return frame;
+	}
+
+	// SceneRenderer with a query shift and a selection: the query depth only holds the selected
+	// occluders, so no texel is nearer than every pixel it stands for in the full resolution depth
+	// of all of them, and no occludee is hidden that the full resolution queries find visible.
+	void TestRenderer(Threading::ThreadPool& pool, Rendering::Animation animation, const OccluderSelector::Settings& settings)
+	{
+		const uint32_t width = 320, height = 192, shift = 1;
+		Benchmark::SceneDesc desc;
+		desc.occluders = 256;
+		desc.occludees = 1024;
+		desc.sizes = Benchmark::SizeDistribution::PowerLaw;
+		desc.animation = animation;
+		const Rendering::Scene scene = Benchmark::GenerateScene(desc);
+
+		// The occluders where the renderer's last Update moved them.
+		vector<Rendering::Quad> occluders = scene.occluders;
+		if (animation == Rendering::Animation::Drift)
+		{
+			Rendering::SceneStore store;
+			Rendering::SceneRenderer::AddDrift(scene.occluders, store);
+			vector<float> offsets(static_cast<size_t>(desc.occluders) * 4);
+			Rendering::SceneStore::Output output;
+			output.destination = reinterpret_cast<uint8_t*>(offsets.data());
+			output.stride = 4 * sizeof(float);
+			for (uint32_t i = 0; i < Rendering::SceneRenderer::FrameCount + 1; i++)
+			{
+				store.Update(output);
+			}
+			for (uint32_t i = 0; i < desc.occluders; i++)
+			{
+				occluders[i].left += store.GetOffsetX(i);
+				occluders[i].right += store.GetOffsetX(i);
+				occluders[i].bottom += store.GetOffsetY(i);
+				occluders[i].top += store.GetOffsetY(i);
+			}
+		}
+		vector<float> depth;
+		Benchmark::DrawDepth(occluders, width, height, depth);
+		const uint32_t texelsX = width >> shift, texelsY = height >> shift;
+		vector<float> farthest(static_cast<size_t>(texelsX) * texelsY);
+		Culling::DepthPyramid::Downsample(depth.data(), width, height, width, shift, farthest.data(), texelsX);
+
+		const Frame full = Render(pool, scene, width, height, 0, nullptr);
+		const Frame frame = Render(pool, scene, width, height, shift, &settings);
+		CHECK(frame.selected > 0 && frame.selected <= settings.maxOccluders && frame.selected < desc.occluders);
+		CHECK(frame.fused > 0);
+		CHECK(full.selected == 0);
+		uint32_t nearer = 0;
+		for (size_t texel = 0; texel < farthest.size(); texel++)
+		{
+			nearer += frame.queryDepth[texel] < farthest[texel] - Benchmark::InterpolationTolerance;
+		}
+		CHECK(nearer == 0);
+
+		uint32_t unsafe = 0, hidden = 0;
+		for (size_t i = 0; i < scene.occludees.size(); i++)
+		{
+			unsafe += frame.visible[i] == 0 && full.visible[i] != 0;
+			hidden += frame.visible[i] == 0;
+		}
+		CHECK(unsafe == 0);
+		CHECK(hidden > 0);
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	OccluderSelector::Settings settings;
+	TestSelection(settings, true);
+	settings.fuseArea = 0;
+	TestSelection(settings, false);
+	settings = OccluderSelector::Settings();
+	settings.maxOccluders = 32;
+	settings.maxTriangles = 8192;
+	TestSelection(settings, true);
+	TestFusion();
+
+	OccluderSelector::Settings budget;
+	budget.maxOccluders = 48;
+	budget.fuseArea = 0.05f;
+	budget.fuseDepthRange = 0.2f;
+	for (Rendering::Animation animation : { Rendering::Animation::None, Rendering::Animation::Drift })
+	{
+		TestRenderer(pool, animation, budget);
+	}
+	return Testing::Finish("OccluderSelectionTest");
+}
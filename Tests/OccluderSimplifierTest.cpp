@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "OccluderSimplifier.h"
+#include "Check.h"
+
+using namespace Query;
+using Culling::Bounds;
+using Culling::OccluderSimplifier;
+
+namespace
+{
+	const uint32_t Width = 480, Height = 270;
+
+	// Two triangles per rectangle, at its depth.
+	vector<float> Triangulate(const vector<Bounds>& rectangles)
+	{
+		vector<float> positions;
+		for (const Bounds& rectangle : rectangles)
+		{
+			const float corners[6][2] = {
+				{ rectangle.min[0], rectangle.min[1] }, { rectangle.max[0], rectangle.min[1] }, { rectangle.min[0], rectangle.max[1] },
+				{ rectangle.max[0], rectangle.min[1] }, { rectangle.max[0], rectangle.max[1] }, { rectangle.min[0], rectangle.max[1] } };
+			for (const auto& corner : corners)
+			{
+				positions.insert(positions.end(), { corner[0], corner[1], rectangle.max[2] });
+			}
+		}
+		return positions;
+	}
+
+	// The inner occluder of a triangle list covers no pixel that the mesh leaves uncovered or
+	// draws nearer, keeps to the settings, and covers at least minCoverage of the mesh's pixels.
+	void CheckInner(const vector<float>& mesh, const vector<Bounds>& rectangles, const OccluderSimplifier::Settings& settings, double minCoverage)
+	{
+		CHECK(rectangles.size() <= settings.maxRectangles);
+		uint32_t flat = 0;
+		for (const Bounds& rectangle : rectangles)
+		{
+			flat += rectangle.min[2] == rectangle.max[2] && rectangle.min[0] < rectangle.max[0] && rectangle.min[1] < rectangle.max[1];
+		}
+		CHECK(flat == rectangles.size());
+
+		vector<float> meshDepth(static_cast<size_t>(Width) * Height, 1.0f), innerDepth(meshDepth.size(), 1.0f);
+		Benchmark::DrawTriangles(mesh.data(), static_cast<uint32_t>(mesh.size() / 9), Width, Height, meshDepth);
+		const vector<float> inner = Triangulate(rectangles);
+		Benchmark::DrawTriangles(inner.data(), static_cast<uint32_t>(inner.size() / 9), Width, Height, innerDepth);
+		uint32_t unsafe = 0, meshPixels = 0, innerPixels = 0;
+		for (size_t pixel = 0; pixel < meshDepth.size(); pixel++)
+		{
+			const bool meshCovered = meshDepth[pixel] < 1.0f, innerCovered = innerDepth[pixel] < 1.0f;
+			unsafe += innerCovered && (!meshCovered || innerDepth[pixel] < meshDepth[pixel] - Benchmark::InterpolationTolerance);
+			meshPixels += meshCovered;
+			innerPixels += innerCovered;
+		}
+		CHECK(unsafe == 0);
+		CHECK(innerPixels >= minCoverage * meshPixels);
+	}
+
+	// Star-shaped discs and rings at several resolutions, as triangle lists.
+	void TestMeshes()
+	{
+		Benchmark::Random random(5);
+		for (uint32_t i = 0; i < 12; i++)
+		{
+			vector<float> mesh;
+			const bool hole = i % 2 == 1;
+			Benchmark::GenerateMesh(random, 256, hole, mesh);
+			for (uint32_t resolution : { 16u, 64u })
+			{
+				OccluderSimplifier::Settings settings;
+				settings.resolution = resolution;
+				OccluderSimplifier simplifier;
+				simplifier.Simplify(mesh.data(), 3 * sizeof(float), nullptr, static_cast<uint32_t>(mesh.size() / 3), settings);
+				CHECK(simplifier.GetTriangleCount() == mesh.size() / 9);
+				CheckInner(mesh, simplifier.GetRectangles(), settings, resolution == 64 ? 0.5 : 0.2);
+			}
+		}
+	}
+
+	// Closed blobs, indexed, with a stride past the positions: their silhouettes are edges whose
+	// two triangles lie on the same side, front and back.
+	void TestBlobs()
+	{
+		Benchmark::Random random(6);
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			vector<float> positions;
+			vector<uint32_t> indices;
+			Benchmark::GenerateBlob(random, 24, positions, indices);
+			vector<float> vertices, mesh;
+			for (size_t vertex = 0; vertex < positions.size(); vertex += 3)
+			{
+				vertices.insert(vertices.end(), { positions[vertex], positions[vertex + 1], positions[vertex + 2], -1.0f });
+			}
+			for (uint32_t index : indices)
+			{
+				mesh.insert(mesh.end(), positions.begin() + index * 3, positions.begin() + index * 3 + 3);
+			}
+			OccluderSimplifier::Settings settings;
+			OccluderSimplifier simplifier;
+			simplifier.Simplify(vertices.data(), 4 * sizeof(float), indices.data(), static_cast<uint32_t>(indices.size()), settings);
+			CHECK(!simplifier.GetRectangles().empty());
+			CheckInner(mesh, simplifier.GetRectangles(), settings, 0.05);
+		}
+	}
+
+	// Each mesh simplified on the pool gives exactly the rectangles the calling thread does.
+	void TestAsync(Threading::ThreadPool& pool)
+	{
+		Benchmark::Random random(7);
+		vector<vector<float>> meshes(8);
+		vector<future<vector<Bounds>>> jobs;
+		OccluderSimplifier::Settings settings;
+		for (uint32_t i = 0; i < meshes.size(); i++)
+		{
+			Benchmark::GenerateMesh(random, 128, i % 2 == 1, meshes[i]);
+			jobs.push_back(OccluderSimplifier::SimplifyAsync(pool, meshes[i], vector<uint32_t>(), settings));
+		}
+		uint32_t mismatches = 0;
+		OccluderSimplifier simplifier;
+		for (uint32_t i = 0; i < meshes.size(); i++)
+		{
+			simplifier.Simplify(meshes[i].data(), 3 * sizeof(float), nullptr, static_cast<uint32_t>(meshes[i].size() / 3), settings);
+			const vector<Bounds>& expected = simplifier.GetRectangles();
+			const vector<Bounds> rectangles = jobs[i].get();
+			mismatches += rectangles.size() != expected.size() ||
+				(!rectangles.empty() && memcmp(rectangles.data(), expected.data(), rectangles.size() * sizeof(Bounds)) != 0);
+		}
+		CHECK(mismatches == 0);
+	}
+
+	// No triangles, a degenerate one, and a lone triangle, whose edges are all boundary edges.
+	void TestDegenerate()
+	{
+		OccluderSimplifier::Settings settings;
+		OccluderSimplifier simplifier;
+		simplifier.Simplify(nullptr, 3 * sizeof(float), nullptr, 0, settings);
+		CHECK(simplifier.GetRectangles().empty() && simplifier.GetTriangleCount() == 0);
+
+		const vector<float> line = { -0.5f, 0.0f, 0.5f, 0.0f, 0.0f, 0.5f, 0.5f, 0.0f, 0.5f };
+		simplifier.Simplify(line.data(), 3 * sizeof(float), nullptr, 3, settings);
+		CHECK(simplifier.GetRectangles().empty() && simplifier.GetTriangleCount() == 0);
+
+		const vector<float> triangle = { -0.5f, -0.5f, 0.25f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.75f };
+		simplifier.Simplify(triangle.data(), 3 * sizeof(float), nullptr, 3, settings);
+		CHECK(simplifier.GetTriangleCount() == 1 && !simplifier.GetRectangles().empty());
+		CheckInner(triangle, simplifier.GetRectangles(), settings, 0.5);
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	TestMeshes();
+	TestBlobs();
+	TestAsync(pool);
+	TestDegenerate();
+	return Testing::Finish("OccluderSimplifierTest");
+}
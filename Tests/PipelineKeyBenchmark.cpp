@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "PipelineKey.h"
+
+using namespace Query;
+using Pipelines::PipelineKey;
+
+namespace
+{
+	struct Result
+	{
+		uint32_t elements;
+		uint32_t bytecodeSize;
+		size_t canonicalSize = 0;
+		double canonicalizeNanoseconds = 0;	//per description, with the two shader hashes
+		double hashNanoseconds = 0;	//of the canonical bytes alone
+	};
+
+	// Keys of a description with a vertex and a pixel shader of one size and an input layout of
+	// the given number of elements, the way the pipeline cache computes them on every lookup.
+	Result Run(uint32_t elements, uint32_t bytecodeSize)
+	{
+		Result result = { elements, bytecodeSize };
+		const vector<uint8_t> vertexShader(bytecodeSize, 1), pixelShader(bytecodeSize, 2);
+		vector<string> semantics(elements);
+		vector<D3D12_INPUT_ELEMENT_DESC> layout(elements);
+		for (uint32_t i = 0; i < elements; i++)
+		{
+			semantics[i] = "TEXCOORD";
+			layout[i] = { semantics[i].c_str(), i, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, i * 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+		}
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+		desc.InputLayout = { layout.data(), elements };
+		desc.VS = { vertexShader.data(), vertexShader.size() };
+		desc.PS = { pixelShader.data(), pixelShader.size() };
+		desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+		desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+		desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+		desc.SampleMask = UINT_MAX;
+		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		desc.NumRenderTargets = 1;
+		desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+		desc.SampleDesc.Count = 1;
+
+		const uint32_t iterations = 4 * 1024 * 1024 / (bytecodeSize + 256);
+		vector<uint8_t> canonical;
+		uint64_t checksum = 0;
+		auto start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			desc.SampleMask = i;
+			PipelineKey::Canonicalize(desc, i, canonical);
+			checksum += canonical.size();
+		}
+		result.canonicalizeNanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+		result.canonicalSize = canonical.size();
+
+		start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			canonical[0] = static_cast<uint8_t>(i);
+			checksum += PipelineKey::Hash(canonical);
+		}
+		result.hashNanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+		if (checksum == 0)
+		{
+			fprintf(stderr, "no keys computed\n");
+		}
+		return result;
+	}
+}
+
+int main()
+{
+	const Result results[] = {
+		Run(2, 1024),
+		Run(8, 1024),
+		Run(16, 1024),
+		Run(2, 16 * 1024),
+		Run(8, 64 * 1024) };
+
+	printf("{\n\t\"benchmark\": \"pipelineKey\",\n\t\"runs\": [");
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"elements\": %u, \"bytecodeSize\": %u, \"canonicalSize\": %zu, \"canonicalizeNs\": %.1f, \"hashNs\": %.1f }",
+			i ? "," : "", r.elements, r.bytecodeSize, r.canonicalSize, r.canonicalizeNanoseconds, r.hashNanoseconds);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "PipelineKey.h"
+#include "Check.h"
+#include <map>
+#include <random>
+
+using namespace Query;
+using Pipelines::PipelineKey;
+
+namespace
+{
+	const uint64_t RootSignatureKey = 0x5EED;
+	const uint8_t VertexShader[] = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	const uint8_t PixelShader[] = { 'D', 'X', 'B', 'C', 5, 6, 7, 8 };
+	const D3D12_INPUT_ELEMENT_DESC InputLayout[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } };
+
+	// The scene pipeline of the sample: one render target, depth, default states.
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC MakeDesc()
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+		desc.InputLayout = { InputLayout, _countof(InputLayout) };
+		desc.VS = { VertexShader, sizeof(VertexShader) };
+		desc.PS = { PixelShader, sizeof(PixelShader) };
+		desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+		desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+		desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+		desc.SampleMask = UINT_MAX;
+		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		desc.NumRenderTargets = 1;
+		desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+		desc.SampleDesc.Count = 1;
+		return desc;
+	}
+
+	vector<uint8_t> Canonical(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey = RootSignatureKey)
+	{
+		vector<uint8_t> canonical;
+		PipelineKey::Canonicalize(desc, rootSignatureKey, canonical);
+		return canonical;
+	}
+
+	bool Equivalent(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& a, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& b)
+	{
+		return Canonical(a) == Canonical(b) && PipelineKey::Compute(a, RootSignatureKey) == PipelineKey::Compute(b, RootSignatureKey);
+	}
+
+	// Keys are stored in pipeline libraries on disk, so they must not depend on the run, the
+	// compiler or the platform. The key of the sample's scene pipeline is pinned here; if the
+	// canonical form changes on purpose, its layout version changes with it.
+	void TestStability()
+	{
+		const D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = MakeDesc();
+		CHECK(Equivalent(desc, desc));
+		CHECK(PipelineKey::Compute(desc, RootSignatureKey) == PipelineKey::Hash(Canonical(desc)));
+		CHECK(PipelineKey::Compute(desc, RootSignatureKey) == 0x9ca8326be6b306b4ull);
+		CHECK(PipelineKey::ToName(0x0123456789abcdefull) == L"0123456789abcdef");
+		CHECK(PipelineKey::ToName(0x2a) == L"000000000000002a");
+		CHECK(PipelineKey::HashBytecode({ nullptr, 0 }) == 0 && PipelineKey::HashBytecode({ VertexShader, 0 }) == 0);
+	}
+
+	// Descriptions that create the same pipeline: other pointers to equal data, other case in
+	// semantic names, and every field the canonical form ignores.
+	void TestEquivalence()
+	{
+		const D3D12_GRAPHICS_PIPELINE_STATE_DESC base = MakeDesc();
+		vector<function<void(D3D12_GRAPHICS_PIPELINE_STATE_DESC&)>> changes;
+
+		static const vector<uint8_t> vertexCopy(VertexShader, VertexShader + sizeof(VertexShader));
+		static const string position = "position", color = "Color";
+		static const D3D12_INPUT_ELEMENT_DESC layoutCopy[] = {
+			{ position.c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 7 },
+			{ color.c_str(), 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } };
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.VS.pShaderBytecode = vertexCopy.data(); });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.InputLayout.pInputElementDescs = layoutCopy; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(16); });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.CachedPSO = { VertexShader, sizeof(VertexShader) }; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RTVFormats[1] = DXGI_FORMAT_R32_FLOAT; d.RTVFormats[7] = DXGI_FORMAT_R8_UNORM; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.RenderTarget[3].BlendEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.IndependentBlendEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_MAX; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_XOR; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.StreamOutput.RasterizedStream = 3; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DepthStencilState.StencilReadMask = 1; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DepthStencilState.BackFace.StencilPassOp = D3D12_STENCIL_OP_INCR; });
+		for (size_t i = 0; i < changes.size(); i++)
+		{
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = base;
+			changes[i](desc);
+			if (!CHECK(Equivalent(desc, base)))
+			{
+				fprintf(stderr, "  equivalence %zu\n", i);
+			}
+		}
+
+		// Disabled depth ignores the function and write mask, though it differs from enabled depth.
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC disabled = base, other = base;
+		disabled.DepthStencilState.DepthEnable = FALSE;
+		other.DepthStencilState.DepthEnable = FALSE;
+		other.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER;
+		other.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+		CHECK(Equivalent(disabled, other));
+	}
+
+	// Every field that creates another pipeline gives another key, and no two of these keys are
+	// equal.
+	void TestDistinction()
+	{
+		const D3D12_GRAPHICS_PIPELINE_STATE_DESC base = MakeDesc();
+		vector<function<void(D3D12_GRAPHICS_PIPELINE_STATE_DESC&)>> changes;
+		static const uint8_t otherShader[] = { 'D', 'X', 'B', 'C', 1, 2, 3, 5 };
+		static const D3D12_INPUT_ELEMENT_DESC instanced[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 } };
+		static const D3D12_INPUT_ELEMENT_DESC stepRate[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 2 } };
+		static const D3D12_INPUT_ELEMENT_DESC renamed[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "COLOUR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } };
+		static const D3D12_INPUT_ELEMENT_DESC reindexed[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } };
+		static const D3D12_SO_DECLARATION_ENTRY streamOutput[] = { { 0, "SV_POSITION", 0, 0, 4, 0 } };
+		static const UINT strides[] = { 16 };
+
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.VS.pShaderBytecode = otherShader; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.VS.BytecodeLength--; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { swap(d.VS, d.PS); });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.PS = {}; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.GS = d.VS; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.HS = d.VS; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DS = d.VS; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.StreamOutput = { streamOutput, 1, strides, 1, 0 }; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.StreamOutput = { streamOutput, 1, strides, 1, 1 }; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.AlphaToCoverageEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.RenderTarget[0].BlendEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d)
+		{
+			d.BlendState.RenderTarget[0].BlendEnable = TRUE;
+			d.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA;
+		});
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.RenderTarget[0].LogicOpEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_RED; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.SampleMask = 1; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.CullMode = D3D12_CULL_MODE_NONE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.FrontCounterClockwise = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.DepthBias = 1; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.DepthBiasClamp = 0.5f; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.SlopeScaledDepthBias = 1.0f; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.DepthClipEnable = FALSE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.MultisampleEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.AntialiasedLineEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.ForcedSampleCount = 4; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DepthStencilState.DepthEnable = FALSE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DepthStencilState.StencilEnable = TRUE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d)
+		{
+			d.DepthStencilState.StencilEnable = TRUE;
+			d.DepthStencilState.FrontFace.StencilFunc = D3D12_COMPARISON_FUNC_EQUAL;
+		});
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.InputLayout.NumElements = 1; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.InputLayout.pInputElementDescs = instanced; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.InputLayout.pInputElementDescs = stepRate; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.InputLayout.pInputElementDescs = renamed; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.InputLayout.pInputElementDescs = reindexed; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.NumRenderTargets = 2; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d)
+		{
+			d.NumRenderTargets = 2;
+			d.RTVFormats[1] = DXGI_FORMAT_R32_FLOAT;
+		});
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d)
+		{
+			d.NumRenderTargets = 2;
+			d.BlendState.IndependentBlendEnable = TRUE;
+		});
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.RTVFormats[0] = DXGI_FORMAT_B8G8R8A8_UNORM; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.SampleDesc.Count = 4; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.SampleDesc.Quality = 1; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.NodeMask = 2; });
+		changes.push_back([](D3D12_GRAPHICS_PIPELINE_STATE_DESC& d) { d.Flags = D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG; });
+
+		map<uint64_t, size_t> keys = { { PipelineKey::Compute(base, RootSignatureKey), changes.size() } };
+		CHECK(PipelineKey::Compute(base, RootSignatureKey + 1) != keys.begin()->first);
+		for (size_t i = 0; i < changes.size(); i++)
+		{
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC changed = base;
+			changes[i](changed);
+			const auto inserted = keys.emplace(PipelineKey::Compute(changed, RootSignatureKey), i);
+			if (!CHECK(inserted.second))
+			{
+				fprintf(stderr, "  change %zu has the key of %zu\n", i, inserted.first->second);
+			}
+		}
+	}
+
+	// Random descriptions over every field the key covers: descriptions whose canonical bytes
+	// differ never share a key, and equal canonical bytes always give the same key.
+	void TestRandom()
+	{
+		mt19937 random(1);
+		static const D3D12_BLEND blends[] = { D3D12_BLEND_ZERO, D3D12_BLEND_ONE, D3D12_BLEND_SRC_ALPHA, D3D12_BLEND_INV_SRC_ALPHA };
+		static const DXGI_FORMAT formats[] = { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_B8G8R8A8_UNORM };
+		vector<uint8_t> shaders(64);
+		for (size_t i = 0; i < shaders.size(); i++)
+		{
+			shaders[i] = static_cast<uint8_t>(i);
+		}
+		map<vector<uint8_t>, uint64_t> canonicalKeys;
+		map<uint64_t, vector<uint8_t>> keyCanonicals;
+		for (uint32_t i = 0; i < 50000; i++)
+		{
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = MakeDesc();
+			desc.VS = { shaders.data(), 1 + random() % shaders.size() };
+			desc.PS = { shaders.data() + random() % 32, 1 + random() % 32 };
+			desc.InputLayout.NumElements = random() % 3;
+			desc.NumRenderTargets = random() % 4;
+			desc.BlendState.IndependentBlendEnable = random() % 2;
+			for (UINT target = 0; target < 8; target++)
+			{
+				D3D12_RENDER_TARGET_BLEND_DESC& blend = desc.BlendState.RenderTarget[target];
+				blend.BlendEnable = random() % 2;
+				blend.SrcBlend = blends[random() % 4];
+				blend.DestBlend = blends[random() % 4];
+				blend.RenderTargetWriteMask = static_cast<UINT8>(random() % 16);
+				desc.RTVFormats[target] = formats[random() % 4];
+			}
+			desc.RasterizerState.CullMode = static_cast<D3D12_CULL_MODE>(1 + random() % 3);
+			desc.RasterizerState.DepthBias = static_cast<INT>(random() % 4);
+			desc.DepthStencilState.DepthEnable = random() % 2;
+			desc.DepthStencilState.DepthFunc = static_cast<D3D12_COMPARISON_FUNC>(1 + random() % 8);
+			desc.DepthStencilState.StencilEnable = random() % 4 == 0;
+			desc.DepthStencilState.StencilWriteMask = static_cast<UINT8>(random() % 2 ? 0xFF : 0x0F);
+			desc.SampleDesc.Count = random() % 2 ? 1 : 4;
+			const uint64_t rootSignatureKey = random() % 4;
+
+			const vector<uint8_t> canonical = Canonical(desc, rootSignatureKey);
+			const uint64_t key = PipelineKey::Compute(desc, rootSignatureKey);
+			CHECK(key == PipelineKey::Hash(canonical));
+			const auto byCanonical = canonicalKeys.emplace(canonical, key);
+			CHECK(byCanonical.first->second == key);
+			const auto byKey = keyCanonicals.emplace(key, canonical);
+			CHECK(byKey.first->second == canonical);
+		}
+		CHECK(canonicalKeys.size() > 10000);	//the descriptions were mostly distinct
+	}
+}
+
+int main()
+{
+	TestStability();
+	TestEquivalence();
+	TestDistinction();
+	TestRandom();
+	return Testing::Finish("PipelineKeyTest");
+}
@@ -0,0 +1,94 @@
+#include "pch.h"
+#include <random>
+#include "PipelineStreams.h"
+
+using namespace Query;
+using namespace Query::Testing;
+
+namespace
+{
+	struct Result
+	{
+		const char* name;
+		double coldNanoseconds;	//per stream, over all of them
+		double hotNanoseconds;	//per stream, over the first 256 again and again
+	};
+
+	// Best of 7 passes over the streams.
+	template<typename Parse>
+	double Time(const vector<D3D12_PIPELINE_STATE_STREAM_DESC>& descs, Parse parse)
+	{
+		double best = 1e30;
+		for (uint32_t pass = 0; pass < 7; pass++)
+		{
+			const auto start = chrono::steady_clock::now();
+			for (const D3D12_PIPELINE_STATE_STREAM_DESC& desc : descs)
+			{
+				parse(desc);
+			}
+			const double nanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / descs.size();
+			best = nanoseconds < best ? nanoseconds : best;
+		}
+		return best;
+	}
+
+	template<typename Parse>
+	Result Run(const char* name, const vector<D3D12_PIPELINE_STATE_STREAM_DESC>& cold, const vector<D3D12_PIPELINE_STATE_STREAM_DESC>& hot,
+		Parse parse)
+	{
+		return { name, Time(cold, parse), Time(hot, parse) };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t count = argc > 1 ? uint32_t(atoi(argv[1])) : 100000;
+	const PipelineStreams streams;
+	vector<vector<uint8_t>> bytes(count);
+	vector<D3D12_PIPELINE_STATE_STREAM_DESC> cold(count), hot(count);
+	size_t totalBytes = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		streams.Build(i, i, bytes[i]);
+		cold[i] = { bytes[i].size(), bytes[i].data() };
+		totalBytes += bytes[i].size();
+	}
+	for (uint32_t i = 0; i < count; i++)
+	{
+		hot[i] = cold[i % 256];
+	}
+
+	volatile UINT64 sink = 0;
+	const Result results[] = {
+		Run("callbacks", cold, hot, [&sink](const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+		{
+			ID3DX12PipelineParserCallbacks callbacks;
+			sink = sink + D3DX12ParsePipelineStream(desc, &callbacks);
+		}),
+		Run("parseHelper", cold, hot, [&sink](const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+		{
+			CD3DX12_PIPELINE_STATE_STREAM_PARSE_HELPER helper;
+			sink = sink + D3DX12ParsePipelineStream(desc, &helper);
+		}),
+		Run("layout", cold, hot, [&sink](const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+		{
+			CD3DX12_PIPELINE_STATE_STREAM_LAYOUT layout;
+			sink = sink + D3DX12ParsePipelineStreamLayout(desc, &layout) + layout.SubobjectMask;
+		}),
+		Run("layoutAndHash", cold, hot, [&sink](const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+		{
+			UINT64 hash = 0;
+			D3DX12HashPipelineStream(desc, &hash);
+			sink = sink + hash;
+		}) };
+
+	printf("{\n\t\"benchmark\": \"pipelineStream\",\n\t\"streams\": %u,\n\t\"averageBytes\": %.0f,\n\t\"runs\": [", count,
+		double(totalBytes) / count);
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"parser\": \"%s\", \"coldNs\": %.1f, \"hotNs\": %.1f }", i ? "," : "", r.name, r.coldNanoseconds, r.hotNanoseconds);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
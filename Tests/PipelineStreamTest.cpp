@@ -0,0 +1,245 @@
+#include "pch.h"
+#include "Check.h"
+#include <random>
+#include <unordered_set>
+#include "PipelineStreams.h"
+
+using namespace Query;
+using namespace Query::Testing;
+
+namespace
+{
+	// What the callback parser reports: the types it called back for, where in the stream the
+	// subobjects passed by reference are, and the value of the others.
+	struct Recorder : ID3DX12PipelineParserCallbacks
+	{
+		UINT64 mask = 0;
+		const void* addresses[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID] = {};
+		UINT64 values[D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID] = {};
+		uint32_t errors = 0;
+
+		void Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, const void* address)
+		{
+			mask |= 1ull << type;
+			addresses[type] = address;
+		}
+
+		void Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, UINT64 value)
+		{
+			mask |= 1ull << type;
+			values[type] = value;
+		}
+
+		void FlagsCb(D3D12_PIPELINE_STATE_FLAGS value) override { Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS, value); }
+		void NodeMaskCb(UINT value) override { Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK, value); }
+		void RootSignatureCb(ID3D12RootSignature* value) override { Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE, reinterpret_cast<uintptr_t>(value)); }
+		void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT, &desc); }
+		void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE value) override { Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE, value); }
+		void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE value) override { Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY, value); }
+		void VSCb(const D3D12_SHADER_BYTECODE& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, &desc); }
+		void GSCb(const D3D12_SHADER_BYTECODE& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS, &desc); }
+		void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT, &desc); }
+		void HSCb(const D3D12_SHADER_BYTECODE& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS, &desc); }
+		void DSCb(const D3D12_SHADER_BYTECODE& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS, &desc); }
+		void PSCb(const D3D12_SHADER_BYTECODE& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, &desc); }
+		void CSCb(const D3D12_SHADER_BYTECODE& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS, &desc); }
+		void BlendStateCb(const D3D12_BLEND_DESC& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND, &desc); }
+		void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL, &desc); }
+		void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1, &desc); }
+		void DSVFormatCb(DXGI_FORMAT value) override { Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT, value); }
+		void RasterizerStateCb(const D3D12_RASTERIZER_DESC& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER, &desc); }
+		void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS, &desc); }
+		void SampleDescCb(const DXGI_SAMPLE_DESC& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC, &desc); }
+		void SampleMaskCb(UINT value) override { Value(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK, value); }
+		void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING, &desc); }
+		void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE& desc) override { Reference(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO, &desc); }
+
+		void ErrorBadInputParameter(UINT) override { errors++; }
+		void ErrorDuplicateSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE) override { errors++; }
+		void ErrorUnknownSubobject(UINT) override { errors++; }
+	};
+
+	UINT64 Number(UINT64 value) { return value; }
+	UINT64 Number(ID3D12RootSignature* value) { return reinterpret_cast<uintptr_t>(value); }
+
+	template<typename Subobject>
+	bool SameReference(const Recorder& recorder, const CD3DX12_PIPELINE_STATE_STREAM_LAYOUT& layout, const void* stream)
+	{
+		return layout.Find<Subobject>(stream) == recorder.addresses[Subobject::SubobjectType];
+	}
+
+	template<typename Subobject>
+	bool SameValue(const Recorder& recorder, const CD3DX12_PIPELINE_STATE_STREAM_LAYOUT& layout, const void* stream)
+	{
+		const auto value = layout.Find<Subobject>(stream);
+		return value ? recorder.values[Subobject::SubobjectType] == Number(*value) : recorder.values[Subobject::SubobjectType] == 0;
+	}
+
+	// The layout holds the subobjects the callback parser calls back for: the same types, at the
+	// addresses it passes by reference, with the values it passes by value.
+	bool SameAsCallbacks(const Recorder& recorder, const CD3DX12_PIPELINE_STATE_STREAM_LAYOUT& layout, const void* stream)
+	{
+		return recorder.mask == layout.SubobjectMask &&
+			SameValue<CD3DX12_PIPELINE_STATE_STREAM_FLAGS>(recorder, layout, stream) &&
+			SameValue<CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK>(recorder, layout, stream) &&
+			SameValue<CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT>(recorder, layout, stream) &&
+			SameValue<CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE>(recorder, layout, stream) &&
+			SameValue<CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_VS>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_GS>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_HS>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_DS>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_PS>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_CS>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1>(recorder, layout, stream) &&
+			SameValue<CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC>(recorder, layout, stream) &&
+			SameValue<CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING>(recorder, layout, stream) &&
+			SameReference<CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO>(recorder, layout, stream);
+	}
+
+	HRESULT ParseLayout(vector<uint8_t>& stream, CD3DX12_PIPELINE_STATE_STREAM_LAYOUT& layout)
+	{
+		return D3DX12ParsePipelineStreamLayout(D3D12_PIPELINE_STATE_STREAM_DESC{ stream.size(), stream.data() }, &layout);
+	}
+
+	HRESULT ParseCallbacks(vector<uint8_t>& stream, Recorder& recorder)
+	{
+		return D3DX12ParsePipelineStream(D3D12_PIPELINE_STATE_STREAM_DESC{ stream.size(), stream.data() }, &recorder);
+	}
+
+	UINT64 Hash(vector<uint8_t>& stream)
+	{
+		UINT64 hash = 0;
+		CHECK(SUCCEEDED(D3DX12HashPipelineStream(D3D12_PIPELINE_STATE_STREAM_DESC{ stream.size(), stream.data() }, &hash)));
+		return hash;
+	}
+
+	// 100k synthetic streams parse to what the callback parser reports, and each, rebuilt in
+	// another order, hashes the same; the 100k hashes are distinct.
+	void TestParity(const PipelineStreams& streams)
+	{
+		const uint32_t count = 100000;
+		vector<uint8_t> stream, reordered;
+		unordered_set<UINT64> hashes;
+		uint32_t mismatches = 0, reorderMismatches = 0;
+		for (uint32_t seed = 0; seed < count; seed++)
+		{
+			streams.Build(seed, seed, stream);
+			Recorder recorder;
+			CD3DX12_PIPELINE_STATE_STREAM_LAYOUT layout;
+			if (FAILED(ParseCallbacks(stream, recorder)) || FAILED(ParseLayout(stream, layout)) || recorder.errors ||
+				!SameAsCallbacks(recorder, layout, stream.data()))
+			{
+				mismatches++;
+				continue;
+			}
+			const UINT64 hash = D3DX12HashPipelineStream(stream.data(), layout);
+			hashes.insert(hash);
+			streams.Build(seed, ~seed, reordered);
+			reorderMismatches += Hash(reordered) != hash;
+		}
+		CHECK(mismatches == 0);
+		CHECK(reorderMismatches == 0);
+		CHECK(hashes.size() == count);
+	}
+
+	// Streams both parsers reject, and the two the layout parser rejects on top: DEPTH_STENCIL1
+	// followed by DEPTH_STENCIL, and a last subobject that runs past SizeInBytes.
+	void TestErrors()
+	{
+		vector<uint8_t> stream;
+		auto put = [&stream](const auto& subobject)
+		{
+			const uint8_t* begin = reinterpret_cast<const uint8_t*>(&subobject);
+			stream.insert(stream.end(), begin, begin + sizeof(subobject));
+		};
+		CD3DX12_PIPELINE_STATE_STREAM_LAYOUT layout;
+		Recorder recorder;
+
+		put(CD3DX12_PIPELINE_STATE_STREAM_VS());
+		put(CD3DX12_PIPELINE_STATE_STREAM_VS());
+		CHECK(FAILED(ParseLayout(stream, layout)) && FAILED(ParseCallbacks(stream, recorder)));
+
+		stream.clear();
+		put(CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL());
+		put(CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1());
+		CHECK(FAILED(ParseLayout(stream, layout)) && FAILED(ParseCallbacks(stream, recorder)));
+
+		stream.clear();
+		put(CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1());
+		put(CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL());
+		CHECK(FAILED(ParseLayout(stream, layout)));
+
+		stream.clear();
+		const UINT unknown[2] = { D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID, 0 };
+		put(unknown);
+		CHECK(FAILED(ParseLayout(stream, layout)) && FAILED(ParseCallbacks(stream, recorder)));
+		CHECK(layout.SubobjectMask == 0);
+
+		stream.clear();
+		put(CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK(1u));
+		put(CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER());
+		CHECK(SUCCEEDED(ParseLayout(stream, layout)));
+		CHECK(FAILED(D3DX12ParsePipelineStreamLayout(D3D12_PIPELINE_STATE_STREAM_DESC{ stream.size() - 4, stream.data() }, &layout)));
+		CHECK(FAILED(D3DX12ParsePipelineStreamLayout(D3D12_PIPELINE_STATE_STREAM_DESC{ 0, stream.data() }, &layout)));
+		CHECK(FAILED(D3DX12ParsePipelineStreamLayout(D3D12_PIPELINE_STATE_STREAM_DESC{ stream.size(), nullptr }, &layout)));
+	}
+
+	// What the hash sees: semantic names in any case, shader copies and subobject order do not
+	// change it; a field, a signed shader's digest or an unsigned shader's bytes do.
+	void TestHash(const PipelineStreams& streams)
+	{
+		vector<uint8_t> a, b;
+		auto put = [](vector<uint8_t>& stream, const auto& subobject)
+		{
+			const uint8_t* begin = reinterpret_cast<const uint8_t*>(&subobject);
+			stream.insert(stream.end(), begin, begin + sizeof(subobject));
+		};
+		const vector<uint8_t>& shader = streams.GetShader(0);
+		vector<uint8_t> copy = shader;
+		const D3D12_INPUT_ELEMENT_DESC upper[] = { { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } };
+		const D3D12_INPUT_ELEMENT_DESC lower[] = { { "position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } };
+		put(a, CD3DX12_PIPELINE_STATE_STREAM_VS(CD3DX12_SHADER_BYTECODE(shader.data(), shader.size())));
+		put(a, CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT(D3D12_INPUT_LAYOUT_DESC{ upper, 1 }));
+		put(a, CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER());
+		put(b, CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER());
+		put(b, CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT(D3D12_INPUT_LAYOUT_DESC{ lower, 1 }));
+		put(b, CD3DX12_PIPELINE_STATE_STREAM_VS(CD3DX12_SHADER_BYTECODE(copy.data(), copy.size())));
+		CHECK(Hash(a) == Hash(b));
+
+		CD3DX12_PIPELINE_STATE_STREAM_LAYOUT layout;
+		ParseLayout(b, layout);
+		CD3DX12_RASTERIZER_DESC& rasterizer = const_cast<CD3DX12_RASTERIZER_DESC&>(*layout.Find<CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER>(b.data()));
+		rasterizer.DepthBias = 1;
+		CHECK(Hash(a) != Hash(b));
+		rasterizer.DepthBias = 0;
+		copy[4] ^= 1;
+		CHECK(Hash(a) != Hash(b));
+		copy[4] ^= 1;
+		copy.back() ^= 1;
+		CHECK(Hash(a) == Hash(b));
+
+		// Unsigned: no digest, so the bytes are hashed.
+		memset(copy.data() + 4, 0, 16);
+		const UINT64 unsignedHash = Hash(b);
+		copy.back() ^= 1;
+		CHECK(Hash(b) != unsignedHash);
+	}
+}
+
+int main()
+{
+	const PipelineStreams streams;
+	TestParity(streams);
+	TestErrors();
+	TestHash(streams);
+	return Testing::Finish("PipelineStreamTest");
+}
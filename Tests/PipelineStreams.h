@@ -0,0 +1,187 @@
+#pragma once
+
+// Graphics pipeline state streams as an engine builds them: a root signature and a vertex shader,
+// a random subset of the other graphics subobjects, packed back to back in random order. Shaders
+// are signed DXBC containers of 1 to 8KB shared by all streams; root signatures are addresses
+// that are never dereferenced.
+namespace Query {
+	namespace Testing
+	{
+		class PipelineStreams
+		{
+		private:
+			vector<vector<uint8_t>> m_shaders;
+			D3D12_INPUT_ELEMENT_DESC m_elements[3];
+			D3D12_SO_DECLARATION_ENTRY m_declaration[2];
+			UINT m_strides[1];
+			D3D12_VIEW_INSTANCE_LOCATION m_locations[4];
+
+			template<typename T>
+			static void Put(vector<uint8_t>& bytes, const T& subobject)
+			{
+				const uint8_t* begin = reinterpret_cast<const uint8_t*>(&subobject);
+				bytes.insert(bytes.end(), begin, begin + sizeof(T));
+			}
+
+		public:
+			PipelineStreams() :
+				m_elements{
+					{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+					{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+					{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 28, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } },
+				m_declaration{
+					{ 0, "SV_POSITION", 0, 0, 4, 0 },
+					{ 0, "TEXCOORD", 0, 0, 2, 0 } },
+				m_strides{ 24 },
+				m_locations{ { 0, 0 }, { 0, 1 }, { 1, 2 }, { 1, 3 } }
+			{
+				mt19937 random(64);
+				for (uint32_t i = 0; i < 64; i++)
+				{
+					vector<uint8_t> shader(1024 * (1 + i % 8));
+					for (uint8_t& byte : shader)
+					{
+						byte = uint8_t(random());
+					}
+					memcpy(shader.data(), "DXBC", 4);
+					m_shaders.push_back(move(shader));
+				}
+			}
+
+			PipelineStreams(const PipelineStreams&) = delete;
+			PipelineStreams& operator=(const PipelineStreams&) = delete;
+
+			const vector<uint8_t>& GetShader(size_t index) const { return m_shaders[index]; }
+
+			// The contents come from seed and the order from orderSeed, so streams of one seed
+			// describe the same pipeline whatever their order.
+			void Build(uint32_t seed, uint32_t orderSeed, vector<uint8_t>& stream) const
+			{
+				mt19937 random(seed);
+				auto shader = [&]()
+				{
+					const vector<uint8_t>& bytes = m_shaders[random() % m_shaders.size()];
+					return CD3DX12_SHADER_BYTECODE(bytes.data(), bytes.size());
+				};
+
+				// One of DEPTH_STENCIL and DEPTH_STENCIL1, as they describe the same state.
+				const bool depthStencil1 = random() % 2 != 0;
+				vector<vector<uint8_t>> subobjects;
+				for (UINT type = 0; type < D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MAX_VALID; type++)
+				{
+					const bool required = type == D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE || type == D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS;
+					if (type == D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS || !(required || random() % 4))
+					{
+						continue;
+					}
+					vector<uint8_t> bytes;
+					switch (type)
+					{
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE:
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE(reinterpret_cast<ID3D12RootSignature*>(uintptr_t(16 + 16 * (random() % 4)))));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_VS(shader())); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_PS(shader())); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_DS(shader())); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_HS(shader())); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_GS(shader())); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT:
+						if (random() % 4)
+						{
+							continue;
+						}
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_STREAM_OUTPUT(D3D12_STREAM_OUTPUT_DESC{ m_declaration, UINT(1 + random() % 2), m_strides, 1, 0 }));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND:
+					{
+						CD3DX12_BLEND_DESC blend(D3D12_DEFAULT);
+						blend.RenderTarget[0].BlendEnable = random() % 2;
+						blend.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA;
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC(blend));
+						break;
+					}
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_MASK(UINT(random()))); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER:
+					{
+						CD3DX12_RASTERIZER_DESC rasterizer(D3D12_DEFAULT);
+						rasterizer.CullMode = static_cast<D3D12_CULL_MODE>(1 + random() % 3);
+						rasterizer.DepthBias = INT(random() % 3);
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER(rasterizer));
+						break;
+					}
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT:
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT(D3D12_INPUT_LAYOUT_DESC{ m_elements, UINT(1 + random() % 3) }));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE:
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_IB_STRIP_CUT_VALUE(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY:
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS:
+					{
+						D3D12_RT_FORMAT_ARRAY formats = {};
+						formats.NumRenderTargets = 1 + random() % 2;
+						formats.RTFormats[0] = formats.RTFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM;
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS(formats));
+						break;
+					}
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT:
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT(DXGI_FORMAT_D32_FLOAT));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC:
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC(DXGI_SAMPLE_DESC{ 1u << (random() % 3), 0 }));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK(UINT(random() % 2))); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO:
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO(D3D12_CACHED_PIPELINE_STATE{ nullptr, 0 }));
+						break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS: Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_FLAGS(D3D12_PIPELINE_STATE_FLAG_NONE)); break;
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL:
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1:
+					{
+						if ((type == D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1) != depthStencil1)
+						{
+							continue;
+						}
+						const D3D12_COMPARISON_FUNC depthFunc = random() % 2 ? D3D12_COMPARISON_FUNC_LESS : D3D12_COMPARISON_FUNC_LESS_EQUAL;
+						if (type == D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1)
+						{
+							CD3DX12_DEPTH_STENCIL_DESC1 depthStencil(D3D12_DEFAULT);
+							depthStencil.DepthFunc = depthFunc;
+							Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL1(depthStencil));
+						}
+						else
+						{
+							CD3DX12_DEPTH_STENCIL_DESC depthStencil(D3D12_DEFAULT);
+							depthStencil.DepthFunc = depthFunc;
+							Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL(depthStencil));
+						}
+						break;
+					}
+					case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING:
+						if (random() % 4)
+						{
+							continue;
+						}
+						Put(bytes, CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING(CD3DX12_VIEW_INSTANCING_DESC(2 + random() % 3, m_locations,
+							D3D12_VIEW_INSTANCING_FLAG_NONE)));
+						break;
+					}
+					subobjects.push_back(move(bytes));
+				}
+
+				mt19937 order(orderSeed);
+				for (size_t i = subobjects.size(); i > 1; i--)
+				{
+					swap(subobjects[i - 1], subobjects[order() % i]);
+				}
+				stream.clear();
+				for (const vector<uint8_t>& subobject : subobjects)
+				{
+					stream.insert(stream.end(), subobject.begin(), subobject.end());
+				}
+			}
+		};
+	}
+}
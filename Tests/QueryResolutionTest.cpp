@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "DepthPyramid.h"
+#include "SoftwareBackend.h"
+#include "Check.h"
+
+using namespace Query;
+
+namespace
+{
+	const uint32_t Width = 320, Height = 192;
+
+	struct Frame
+	{
+		uint32_t shift = 0;
+		vector<uint64_t> visible;	//the resolved query of each occludee
+		vector<float> queryDepth;	//with a query shift, pitch Width >> shift
+	};
+
+	// Renders a static scene on the software backend until the queries of the first frame are
+	// resolved, and reads back what they tested and found.
+	Frame Render(Threading::ThreadPool& pool, const Rendering::Scene& scene, uint32_t width, uint32_t height, uint32_t shift)
+	{
+		Backend::Software::Device device(&pool);
+		Backend::Software::SwapChain swapChain(Rendering::SceneRenderer::FrameCount, width, height);
+		Backend::Software::PipelineDesc queryDesc;
+		queryDesc.colorWrite = false;
+		queryDesc.depthWrite = false;
+		Backend::Software::Pipeline scenePipeline("Scene", Backend::Software::PipelineDesc());
+		Backend::Software::Pipeline queryPipeline("Query", queryDesc);
+		Rendering::SceneRenderer renderer;
+		renderer.Initialize(&device, &swapChain, width, height, &scene, shift);
+		renderer.SetPipelines(&scenePipeline, &queryPipeline);
+		for (uint32_t i = 0; i < Rendering::SceneRenderer::FrameCount + 1; i++)
+		{
+			renderer.Update();
+			renderer.Render();
+		}
+		renderer.WaitForGpu();
+
+		Frame frame;
+		frame.shift = renderer.GetQueryShift();
+		const uint64_t* visible = static_cast<const uint64_t*>(renderer.GetQueryResult()->Map());
+		frame.visible.assign(visible, visible + scene.occludees.size());
+		if (frame.shift)
+		{
+			auto* depth = static_cast<Backend::Software::Resource*>(renderer.GetQueryDepth());
+			const uint32_t texelsX = width >> frame.shift, texelsY = height >> frame.shift;
+			frame.queryDepth.resize(static_cast<size_t>(texelsX) * texelsY);
+			for (uint32_t y = 0; y < texelsY; y++)
+			{
+				memcpy(&frame.queryDepth[static_cast<size_t>(y) * texelsX], depth->GetDepths() + static_cast<size_t>(y) * depth->GetPitch(),
+					texelsX * sizeof(float));
+			}
+		}
+		return frame;
+	}
+
+	// Each query shift of a generated scene: no texel of the query depth is nearer than every pixel
+	// it stands for, so no occludee is hidden that the full resolution queries find visible, and
+	// the smaller depth still hides some.
+	void TestShifts(Threading::ThreadPool& pool)
+	{
+		Benchmark::SceneDesc desc;
+		desc.occluders = 64;
+		desc.occludees = 512;
+		desc.sizes = Benchmark::SizeDistribution::PowerLaw;
+		desc.animation = Rendering::Animation::None;
+		const Rendering::Scene scene = Benchmark::GenerateScene(desc);
+		vector<float> depth;
+		Benchmark::DrawDepth(scene.occluders, Width, Height, depth);
+
+		const Frame full = Render(pool, scene, Width, Height, 0);
+		uint32_t fullHidden = 0;
+		for (uint64_t visible : full.visible)
+		{
+			fullHidden += visible == 0;
+		}
+		CHECK(fullHidden > 0);
+
+		for (uint32_t shift = 1; shift <= 2; shift++)
+		{
+			const Frame frame = Render(pool, scene, Width, Height, shift);
+			if (!CHECK(frame.shift == shift))
+			{
+				continue;
+			}
+			const uint32_t texelsX = Width >> shift, texelsY = Height >> shift;
+			vector<float> farthest(static_cast<size_t>(texelsX) * texelsY);
+			Culling::DepthPyramid::Downsample(depth.data(), Width, Height, Width, shift, farthest.data(), texelsX);
+			uint32_t nearer = 0;
+			for (size_t texel = 0; texel < farthest.size(); texel++)
+			{
+				nearer += frame.queryDepth[texel] < farthest[texel] - Benchmark::InterpolationTolerance;
+			}
+			CHECK(nearer == 0);
+
+			uint32_t unsafe = 0, hidden = 0;
+			for (size_t i = 0; i < scene.occludees.size(); i++)
+			{
+				unsafe += frame.visible[i] == 0 && full.visible[i] != 0;
+				hidden += frame.visible[i] == 0;
+			}
+			CHECK(unsafe == 0);
+			CHECK(hidden > 0);
+		}
+	}
+
+	// A shift that does not divide the size is lowered until it does.
+	void TestLowered(Threading::ThreadPool& pool)
+	{
+		Benchmark::SceneDesc desc;
+		desc.occluders = 4;
+		desc.occludees = 4;
+		const Rendering::Scene scene = Benchmark::GenerateScene(desc);
+		CHECK(Render(pool, scene, 100, 60, 3).shift == 2);
+		CHECK(Render(pool, scene, 98, 64, 2).shift == 1);
+		CHECK(Render(pool, scene, 99, 64, 2).shift == 0);
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	TestShifts(pool);
+	TestLowered(pool);
+	return Testing::Finish("QueryResolutionTest");
+}
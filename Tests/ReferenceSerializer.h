@@ -0,0 +1,257 @@
+#pragma once
+
+// A root signature serializer for the tests, written the plain way: it appends the RTS0 part field
+// by field from the D3D12 structures and checksums the container with the MD5 of RFC 1321, padded
+// the way DXBC containers are. It takes no static samplers, like RootSignatureLayout.
+namespace Query {
+	namespace Testing
+	{
+		class VectorBlob final : public ID3DBlob
+		{
+		private:
+			vector<uint8_t> m_bytes;
+			atomic<ULONG> m_references;
+
+		public:
+			explicit VectorBlob(vector<uint8_t> bytes) : m_bytes(move(bytes)), m_references(1) {}
+
+			HRESULT QueryInterface(REFIID, void**) override { return E_NOINTERFACE; }
+			ULONG AddRef() override { return ++m_references; }
+			ULONG Release() override
+			{
+				const ULONG references = --m_references;
+				if (references == 0)
+				{
+					delete this;
+				}
+				return references;
+			}
+			LPVOID GetBufferPointer() override { return m_bytes.data(); }
+			SIZE_T GetBufferSize() override { return m_bytes.size(); }
+		};
+
+		class Md5
+		{
+		private:
+			uint32_t m_state[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+			static uint32_t Rotate(uint32_t value, int count) { return value << count | value >> (32 - count); }
+
+		public:
+			void Transform(const uint8_t* block)
+			{
+				static const int shifts[4][4] = { { 7, 12, 17, 22 }, { 5, 9, 14, 20 }, { 4, 11, 16, 23 }, { 6, 10, 15, 21 } };
+				uint32_t words[16];
+				for (int i = 0; i < 16; i++)
+				{
+					words[i] = uint32_t(block[i * 4]) | uint32_t(block[i * 4 + 1]) << 8 | uint32_t(block[i * 4 + 2]) << 16 | uint32_t(block[i * 4 + 3]) << 24;
+				}
+				uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+				for (int i = 0; i < 64; i++)
+				{
+					const int round = i / 16;
+					const uint32_t f = round == 0 ? (b & c) | (~b & d) : round == 1 ? (b & d) | (c & ~d) : round == 2 ? b ^ c ^ d : c ^ (b | ~d);
+					const int word = round == 0 ? i : round == 1 ? (5 * i + 1) % 16 : round == 2 ? (3 * i + 5) % 16 : 7 * i % 16;
+					const uint32_t sine = uint32_t(fabs(sin(double(i + 1))) * 4294967296.0);
+					const uint32_t next = b + Rotate(a + f + sine + words[word], shifts[round][i % 4]);
+					a = d;
+					d = c;
+					c = b;
+					b = next;
+				}
+				m_state[0] += a;
+				m_state[1] += b;
+				m_state[2] += c;
+				m_state[3] += d;
+			}
+
+			const uint32_t* GetState() const { return m_state; }
+
+			// The plain MD5 digest, as a hex string.
+			static string Digest(const string& message)
+			{
+				vector<uint8_t> padded(message.begin(), message.end());
+				padded.push_back(0x80);
+				while (padded.size() % 64 != 56)
+				{
+					padded.push_back(0);
+				}
+				const uint64_t bits = uint64_t(message.size()) * 8;
+				for (int i = 0; i < 8; i++)
+				{
+					padded.push_back(uint8_t(bits >> (8 * i)));
+				}
+				Md5 md5;
+				for (size_t offset = 0; offset < padded.size(); offset += 64)
+				{
+					md5.Transform(&padded[offset]);
+				}
+				char digest[33];
+				for (int i = 0; i < 16; i++)
+				{
+					snprintf(digest + 2 * i, 3, "%02x", (md5.m_state[i / 4] >> (8 * (i % 4))) & 0xff);
+				}
+				return digest;
+			}
+		};
+
+		inline void Append(vector<uint8_t>& bytes, uint32_t value)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				bytes.push_back(uint8_t(value >> (8 * i)));
+			}
+		}
+
+		inline void Overwrite(vector<uint8_t>& bytes, size_t offset, uint32_t value)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				bytes[offset + i] = uint8_t(value >> (8 * i));
+			}
+		}
+
+		// MD5 of the container past the checksum field, with the bit count in the first word of the
+		// last block and (bits >> 2) | 1 in its last word, instead of the trailing 64-bit length.
+		inline void WriteContainerChecksum(vector<uint8_t>& container)
+		{
+			const uint8_t* data = container.data() + 20;
+			const size_t size = container.size() - 20;
+			const uint32_t bits = uint32_t(size * 8);
+			const size_t full = size / 64 * 64;
+			const size_t leftover = size - full;
+			Md5 md5;
+			for (size_t offset = 0; offset < full; offset += 64)
+			{
+				md5.Transform(data + offset);
+			}
+			uint8_t block[64] = {};
+			if (leftover < 56)
+			{
+				memcpy(block, &bits, 4);
+				memcpy(block + 4, data + full, leftover);
+				block[4 + leftover] = 0x80;
+			}
+			else
+			{
+				memcpy(block, data + full, leftover);
+				block[leftover] = 0x80;
+				md5.Transform(block);
+				memset(block, 0, sizeof(block));
+				memcpy(block, &bits, 4);
+			}
+			const uint32_t last = (bits >> 2) | 1;
+			memcpy(block + 60, &last, 4);
+			md5.Transform(block);
+			for (int i = 0; i < 4; i++)
+			{
+				Overwrite(container, 4 + 4 * i, md5.GetState()[i]);
+			}
+		}
+
+		inline UINT RangeFlags(const D3D12_DESCRIPTOR_RANGE&) { return 0; }
+		inline UINT RangeFlags(const D3D12_DESCRIPTOR_RANGE1& range) { return range.Flags; }
+		inline UINT DescriptorFlags(const D3D12_ROOT_DESCRIPTOR&) { return 0; }
+		inline UINT DescriptorFlags(const D3D12_ROOT_DESCRIPTOR1& descriptor) { return descriptor.Flags; }
+
+		// Parameters and ranges of either version; flags are written for version 1.1 only.
+		template<typename Parameter>
+		vector<uint8_t> SerializeReference(const Parameter* parameters, UINT parameterCount, UINT flags, UINT version)
+		{
+			const bool version_1_1 = version == D3D_ROOT_SIGNATURE_VERSION_1_1;
+			vector<uint8_t> part;
+			Append(part, version);
+			Append(part, parameterCount);
+			Append(part, 24);
+			Append(part, 0);	//static samplers
+			Append(part, 0);	//their offset, which is the part size without them
+			Append(part, flags);
+			for (UINT i = 0; i < parameterCount; i++)
+			{
+				Append(part, parameters[i].ParameterType);
+				Append(part, parameters[i].ShaderVisibility);
+				Append(part, 0);
+			}
+			for (UINT i = 0; i < parameterCount; i++)
+			{
+				const Parameter& parameter = parameters[i];
+				Overwrite(part, 24 + 12 * i + 8, uint32_t(part.size()));
+				switch (parameter.ParameterType)
+				{
+				case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+					Append(part, parameter.DescriptorTable.NumDescriptorRanges);
+					Append(part, uint32_t(part.size() + 4));
+					for (UINT r = 0; r < parameter.DescriptorTable.NumDescriptorRanges; r++)
+					{
+						const auto& range = parameter.DescriptorTable.pDescriptorRanges[r];
+						Append(part, range.RangeType);
+						Append(part, range.NumDescriptors);
+						Append(part, range.BaseShaderRegister);
+						Append(part, range.RegisterSpace);
+						if (version_1_1)
+						{
+							Append(part, RangeFlags(range));
+						}
+						Append(part, range.OffsetInDescriptorsFromTableStart);
+					}
+					break;
+				case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+					Append(part, parameter.Constants.ShaderRegister);
+					Append(part, parameter.Constants.RegisterSpace);
+					Append(part, parameter.Constants.Num32BitValues);
+					break;
+				default:
+					Append(part, parameter.Descriptor.ShaderRegister);
+					Append(part, parameter.Descriptor.RegisterSpace);
+					if (version_1_1)
+					{
+						Append(part, DescriptorFlags(parameter.Descriptor));
+					}
+					break;
+				}
+			}
+			Overwrite(part, 16, uint32_t(part.size()));
+
+			vector<uint8_t> container;
+			Append(container, 0x43425844);	//"DXBC"
+			for (int i = 0; i < 4; i++)
+			{
+				Append(container, 0);
+			}
+			Append(container, 1);
+			Append(container, uint32_t(32 + 4 + 8 + part.size()));
+			Append(container, 1);
+			Append(container, 36);
+			Append(container, 0x30535452);	//"RTS0"
+			Append(container, uint32_t(part.size()));
+			container.insert(container.end(), part.begin(), part.end());
+			WriteContainerChecksum(container);
+			return container;
+		}
+
+		inline HRESULT SerializeReference(const D3D12_ROOT_SIGNATURE_DESC& desc, ID3DBlob** ppBlob)
+		{
+			if (desc.NumStaticSamplers)
+			{
+				return E_NOTIMPL;
+			}
+			*ppBlob = new VectorBlob(SerializeReference(desc.pParameters, desc.NumParameters, desc.Flags, D3D_ROOT_SIGNATURE_VERSION_1_0));
+			return S_OK;
+		}
+
+		inline HRESULT SerializeReference(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc, ID3DBlob** ppBlob)
+		{
+			if (desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_0)
+			{
+				return SerializeReference(desc.Desc_1_0, ppBlob);
+			}
+			if (desc.Desc_1_1.NumStaticSamplers)
+			{
+				return E_NOTIMPL;
+			}
+			*ppBlob = new VectorBlob(SerializeReference(desc.Desc_1_1.pParameters, desc.Desc_1_1.NumParameters, desc.Desc_1_1.Flags,
+				D3D_ROOT_SIGNATURE_VERSION_1_1));
+			return S_OK;
+		}
+	}
+}
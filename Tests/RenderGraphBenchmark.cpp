@@ -0,0 +1,77 @@
+#include "pch.h"
+#include "RenderGraph.h"
+#include <random>
+
+using namespace Query;
+using Rendering::RenderGraph;
+using Rendering::QueueType;
+
+namespace
+{
+	struct Result
+	{
+		uint32_t passes;
+		bool async;
+		double compileMicroseconds = 0;
+		uint32_t steps = 0;	//passes left after culling
+		uint32_t barriers = 0;
+	};
+
+	// Passes that each read two and write one of passes / 5 transient targets, every fifth on the
+	// compute queue and every fiftieth and the last also writing the back buffer.
+	Result Run(uint32_t passes, bool async, uint32_t iterations)
+	{
+		mt19937 random(1);
+		RenderGraph graph;
+		vector<uint32_t> targets;
+		for (uint32_t i = 0; i < passes / 5; i++)
+		{
+			targets.push_back(graph.CreateTransient("Target", Rendering::StateRenderTarget));
+		}
+		const uint32_t backBuffer = graph.ImportResource("BackBuffer", Rendering::StatePresent, Rendering::StatePresent);
+		for (uint32_t i = 0; i < passes; i++)
+		{
+			const uint32_t pass = graph.AddPass("Pass", i % 5 == 0 ? QueueType::Compute : QueueType::Graphics, nullptr);
+			graph.Read(pass, targets[random() % targets.size()], Rendering::StateShaderResource);
+			graph.Read(pass, targets[random() % targets.size()], Rendering::StateShaderResource);
+			graph.Write(pass, targets[random() % targets.size()], i % 5 == 0 ? Rendering::StateUnorderedAccess : Rendering::StateRenderTarget);
+			if (i % 50 == 49 || i == passes - 1)
+			{
+				graph.Write(pass, backBuffer, Rendering::StateRenderTarget);
+			}
+		}
+
+		RenderGraph::CompileOptions options;
+		options.asyncCompute = async;
+		Result result = { passes, async };
+		const auto start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			graph.Compile(options);
+		}
+		result.compileMicroseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+		result.steps = static_cast<uint32_t>(graph.GetSteps().size());
+		result.barriers = graph.GetBarrierCount();
+		return result;
+	}
+}
+
+int main()
+{
+	const Result results[] = {
+		Run(10, false, 100000),
+		Run(100, false, 10000),
+		Run(1000, false, 1000),
+		Run(1000, true, 1000),
+		Run(10000, true, 100) };
+
+	printf("{\n\t\"benchmark\": \"renderGraph\",\n\t\"runs\": [");
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& result = results[i];
+		printf("%s\n\t\t{ \"passes\": %u, \"asyncCompute\": %s, \"compileUs\": %.2f, \"steps\": %u, \"barriers\": %u }",
+			i ? "," : "", result.passes, result.async ? "true" : "false", result.compileMicroseconds, result.steps, result.barriers);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
@@ -0,0 +1,372 @@
+#include "pch.h"
+#include "RenderGraph.h"
+#include "Check.h"
+#include <random>
+
+using namespace Query;
+using Rendering::RenderGraph;
+using Rendering::QueueType;
+using Rendering::ResourceState;
+
+namespace
+{
+	const uint32_t QueueCount = static_cast<uint32_t>(QueueType::Count);
+
+	struct Access
+	{
+		uint32_t pass;
+		uint32_t resource;
+		ResourceState state;
+		bool write;
+	};
+
+	struct Declared
+	{
+		ResourceState initialState, finalState;
+		bool tracked;	//false for virtual resources, which have no state
+	};
+
+	// Replays Execute the way the GPU would run it and checks it against the declared accesses: every
+	// barrier starts from the state the resource is in, every pass finds its resources in the states
+	// it declared, a pass only runs on another queue's results after waiting for them, and the frame
+	// ends with every resource in its final state.
+	class Replay : public RenderGraph::IRecorder
+	{
+		const RenderGraph& m_graph;
+		const vector<Declared>& m_resources;
+		const vector<Access>& m_accesses;
+		vector<ResourceState> m_states;
+		uint32_t m_completed[QueueCount] = {};	//steps run on each queue
+		uint32_t m_waited[QueueCount][QueueCount] = {};	//signal values each queue has waited for, per queue
+		vector<uint32_t> m_lastWriter;	//step, or Invalid
+		vector<array<uint32_t, QueueCount>> m_lastReaders;
+		vector<uint32_t> m_ordinals;	//per step, its position on its queue
+
+	public:
+		vector<uint32_t> executed;	//passes, in order
+
+		Replay(const RenderGraph& graph, const vector<Declared>& resources, const vector<Access>& accesses) :
+			m_graph(graph), m_resources(resources), m_accesses(accesses), m_lastWriter(resources.size(), RenderGraph::Invalid),
+			m_lastReaders(resources.size())
+		{
+			for (const Declared& resource : resources)
+			{
+				m_states.push_back(resource.initialState);
+			}
+			for (auto& readers : m_lastReaders)
+			{
+				readers.fill(RenderGraph::Invalid);
+			}
+		}
+
+		void Wait(QueueType queue, const RenderGraph::QueueWait& wait) override
+		{
+			CHECK(wait.queue != queue);
+			CHECK(wait.value <= m_completed[static_cast<uint32_t>(wait.queue)]);	//the signal happened earlier in the replay
+			uint32_t& waited = m_waited[static_cast<uint32_t>(queue)][static_cast<uint32_t>(wait.queue)];
+			waited = wait.value > waited ? wait.value : waited;
+		}
+
+		void Barriers(QueueType, const RenderGraph::Barrier* barriers, uint32_t count) override
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (!CHECK(barriers[i].resource < m_resources.size() && m_resources[barriers[i].resource].tracked))
+				{
+					continue;
+				}
+				CHECK(barriers[i].before == m_states[barriers[i].resource]);
+				CHECK(barriers[i].before != barriers[i].after);
+				m_states[barriers[i].resource] = barriers[i].after;
+			}
+		}
+
+		void BeginPass(uint32_t, QueueType, const char*) override
+		{
+		}
+
+		// The pass's barriers come after BeginPass, so its accesses are checked here.
+		void EndPass(uint32_t step, QueueType queue) override
+		{
+			const uint32_t pass = m_graph.GetSteps()[step].pass;
+			const uint32_t q = static_cast<uint32_t>(queue);
+			CHECK(!m_graph.IsCulled(pass));
+			CHECK(executed.empty() || executed.back() < pass);
+			m_ordinals.push_back(m_completed[q]);
+			auto visible = [&](uint32_t producer)
+			{
+				if (producer == RenderGraph::Invalid)
+				{
+					return true;
+				}
+				const uint32_t producerQueue = static_cast<uint32_t>(m_graph.GetSteps()[producer].queue);
+				return producerQueue == q || m_ordinals[producer] < m_waited[q][producerQueue];
+			};
+			for (const Access& access : m_accesses)
+			{
+				if (access.pass != pass)
+				{
+					continue;
+				}
+				if (m_resources[access.resource].tracked)
+				{
+					CHECK((m_states[access.resource] & access.state) == access.state);
+				}
+				CHECK(visible(m_lastWriter[access.resource]));
+				if (access.write)
+				{
+					for (uint32_t reader : m_lastReaders[access.resource])
+					{
+						CHECK(visible(reader));
+					}
+				}
+			}
+			for (const Access& access : m_accesses)
+			{
+				if (access.pass == pass && access.write)
+				{
+					m_lastWriter[access.resource] = step;
+					m_lastReaders[access.resource].fill(RenderGraph::Invalid);
+				}
+				else if (access.pass == pass)
+				{
+					m_lastReaders[access.resource][q] = step;
+				}
+			}
+			executed.push_back(pass);
+			m_completed[q]++;
+		}
+
+		void Signal(QueueType queue, uint32_t value) override
+		{
+			CHECK(value == m_completed[static_cast<uint32_t>(queue)]);
+		}
+
+		// Once Execute has returned.
+		void Finish()
+		{
+			for (size_t i = 0; i < m_resources.size(); i++)
+			{
+				CHECK(!m_resources[i].tracked || m_states[i] == m_resources[i].finalState);
+			}
+			for (uint32_t q = 1; q < QueueCount; q++)
+			{
+				CHECK(m_waited[0][q] == m_completed[q]);	//the frame ends after every queue's work
+			}
+		}
+	};
+
+	// The sample's frame: clear, scene with the predicated far quad, occlusion query and resolve,
+	// plus a debug pass nothing reads, which is culled.
+	void TestFrame()
+	{
+		RenderGraph graph;
+		vector<Declared> resources;
+		vector<Access> accesses;
+		auto import = [&](const char* name, ResourceState initialState, ResourceState finalState, bool exported)
+		{
+			resources.push_back({ initialState, finalState, true });
+			return graph.ImportResource(name, initialState, finalState, exported);
+		};
+		auto access = [&](uint32_t pass, uint32_t resource, ResourceState state, bool write)
+		{
+			accesses.push_back({ pass, resource, state, write });
+			if (write)
+			{
+				graph.Write(pass, resource, state);
+			}
+			else
+			{
+				graph.Read(pass, resource, state);
+			}
+		};
+
+		const uint32_t backBuffer = import("BackBuffer", Rendering::StatePresent, Rendering::StatePresent, true);
+		const uint32_t vertices = import("Vertices", Rendering::StateVertexAndConstantBuffer, Rendering::StateVertexAndConstantBuffer, false);
+		const uint32_t queryResult = import("QueryResult", Rendering::StatePredication, Rendering::StatePredication, true);
+		resources.push_back({ Rendering::StateDepthWrite, Rendering::StateDepthWrite, true });
+		const uint32_t depth = graph.CreateTransient("Depth", Rendering::StateDepthWrite);
+		resources.push_back({ Rendering::StateCommon, Rendering::StateCommon, false });
+		const uint32_t queries = graph.CreateVirtual("Queries");
+
+		const uint32_t clear = graph.AddPass("Clear", QueueType::Graphics, nullptr);
+		access(clear, backBuffer, Rendering::StateRenderTarget, true);
+		access(clear, depth, Rendering::StateDepthWrite, true);
+		const uint32_t scene = graph.AddPass("Scene", QueueType::Graphics, nullptr);
+		access(scene, queryResult, Rendering::StatePredication, false);
+		access(scene, vertices, Rendering::StateVertexAndConstantBuffer, false);
+		access(scene, backBuffer, Rendering::StateRenderTarget, true);
+		access(scene, depth, Rendering::StateDepthWrite, true);
+		const uint32_t debug = graph.AddPass("Debug", QueueType::Graphics, nullptr);
+		access(debug, depth, Rendering::StateShaderResource, false);
+		const uint32_t query = graph.AddPass("OcclusionQuery", QueueType::Graphics, nullptr);
+		access(query, vertices, Rendering::StateVertexAndConstantBuffer, false);
+		access(query, depth, Rendering::StateDepthWrite, true);
+		access(query, queries, Rendering::StateCommon, true);
+		const uint32_t resolve = graph.AddPass("ResolveQuery", QueueType::Graphics, nullptr);
+		access(resolve, queries, Rendering::StateCommon, false);
+		access(resolve, queryResult, Rendering::StateCopyDest, true);
+		graph.Compile();
+
+		CHECK(graph.IsCulled(debug));
+		CHECK(!graph.IsCulled(clear) && !graph.IsCulled(scene) && !graph.IsCulled(query) && !graph.IsCulled(resolve));
+		CHECK(graph.GetSteps().size() == 4);
+		Replay replay(graph, resources, accesses);
+		graph.Execute(replay);
+		replay.Finish();
+		CHECK(replay.executed == vector<uint32_t>({ clear, scene, query, resolve }));
+
+		// Present to render target before the clear, predication to copy destination before the
+		// resolve, and both back at the end: nothing else changes state.
+		CHECK(graph.GetBarrierCount() == 4);
+		const RenderGraph::Step& first = graph.GetSteps()[0];
+		CHECK(first.barrierCount == 1 && graph.GetBarriers(first)[0].resource == backBuffer);
+		const RenderGraph::Step& last = graph.GetSteps()[3];
+		CHECK(last.barrierCount == 1 && graph.GetBarriers(last)[0].resource == queryResult);
+
+		uint32_t firstStep, lastStep;
+		CHECK(graph.GetLifetime(depth, firstStep, lastStep) && firstStep == 0 && lastStep == 2);
+
+		// The debug pass survives once it has a side effect.
+		graph.SetSideEffects(debug);
+		graph.Compile();
+		CHECK(!graph.IsCulled(debug) && graph.GetSteps().size() == 5);
+	}
+
+	// Random graphs on three queues: the replay finds every state and dependency in order, the culled
+	// passes are exactly those nothing needs, and compiling again gives the same steps and barriers.
+	void TestRandom()
+	{
+		mt19937 random(1);
+		const ResourceState reads[] = { Rendering::StateShaderResource, Rendering::StateDepthRead, Rendering::StateCopySource,
+			Rendering::StateVertexAndConstantBuffer };
+		const ResourceState writes[] = { Rendering::StateRenderTarget, Rendering::StateUnorderedAccess, Rendering::StateDepthWrite,
+			Rendering::StateCopyDest };
+		for (uint32_t round = 0; round < 300; round++)
+		{
+			RenderGraph graph;
+			vector<Declared> resources;
+			vector<bool> exported;
+			const uint32_t resourceCount = 1 + random() % 24;
+			for (uint32_t i = 0; i < resourceCount; i++)
+			{
+				const uint32_t kind = random() % 4;
+				const ResourceState initialState = random() % 2 ? reads[random() % 4] : writes[random() % 4];
+				if (kind == 0)
+				{
+					exported.push_back(random() % 4 == 0);
+					graph.CreateVirtual("Virtual", exported.back());
+					resources.push_back({ Rendering::StateCommon, Rendering::StateCommon, false });
+				}
+				else if (kind == 1)
+				{
+					exported.push_back(false);
+					graph.CreateTransient("Transient", initialState);
+					resources.push_back({ initialState, initialState, true });
+				}
+				else
+				{
+					const ResourceState finalState = random() % 2 ? reads[random() % 4] : writes[random() % 4];
+					exported.push_back(random() % 2 == 0);
+					graph.ImportResource("Imported", initialState, finalState, exported.back());
+					resources.push_back({ initialState, finalState, true });
+				}
+			}
+
+			vector<Access> accesses;
+			vector<bool> sideEffects;
+			const uint32_t passCount = 1 + random() % 40;
+			for (uint32_t pass = 0; pass < passCount; pass++)
+			{
+				graph.AddPass("Pass", static_cast<QueueType>(random() % 3), nullptr);
+				sideEffects.push_back(random() % 10 == 0);
+				if (sideEffects.back())
+				{
+					graph.SetSideEffects(pass);
+				}
+				// Distinct resources per pass, each read or written.
+				vector<uint32_t> touched;
+				for (uint32_t i = random() % 4; i < 4; i++)
+				{
+					const uint32_t resource = random() % resourceCount;
+					if (find(touched.begin(), touched.end(), resource) != touched.end())
+					{
+						continue;
+					}
+					touched.push_back(resource);
+					const bool write = random() % 2 == 0;
+					const ResourceState state = resources[resource].tracked ? (write ? writes : reads)[random() % 4] : Rendering::StateCommon;
+					accesses.push_back({ pass, resource, state, write });
+					if (write)
+					{
+						graph.Write(pass, resource, state);
+					}
+					else
+					{
+						graph.Read(pass, resource, state);
+					}
+				}
+			}
+
+			RenderGraph::CompileOptions options;
+			options.asyncCompute = random() % 2 == 0;
+			options.asyncCopy = random() % 2 == 0;
+			graph.Compile(options);
+
+			// A pass is kept exactly when it has side effects or writes something exported or read by
+			// a later kept pass.
+			for (uint32_t pass = 0; pass < passCount; pass++)
+			{
+				bool needed = sideEffects[pass];
+				for (const Access& access : accesses)
+				{
+					if (access.pass != pass || !access.write)
+					{
+						continue;
+					}
+					needed = needed || exported[access.resource] || any_of(accesses.begin(), accesses.end(), [&](const Access& other)
+					{
+						return other.resource == access.resource && !other.write && other.pass > pass && !graph.IsCulled(other.pass);
+					});
+				}
+				CHECK(graph.IsCulled(pass) == !needed);
+			}
+			for (const RenderGraph::Step& step : graph.GetSteps())
+			{
+				CHECK(options.asyncCompute || step.queue != QueueType::Compute);
+				CHECK(options.asyncCopy || step.queue != QueueType::Copy);
+			}
+
+			Replay replay(graph, resources, accesses);
+			graph.Execute(replay);
+			replay.Finish();
+			uint32_t kept = 0;
+			for (uint32_t pass = 0; pass < passCount; pass++)
+			{
+				kept += graph.IsCulled(pass) ? 0 : 1;
+			}
+			CHECK(replay.executed.size() == kept);
+
+			const vector<RenderGraph::Step> steps = graph.GetSteps();
+			const uint32_t barrierCount = graph.GetBarrierCount();
+			graph.Compile(options);
+			CHECK(graph.GetBarrierCount() == barrierCount);
+			if (CHECK(graph.GetSteps().size() == steps.size()))
+			{
+				for (size_t i = 0; i < steps.size(); i++)
+				{
+					const RenderGraph::Step& step = graph.GetSteps()[i];
+					CHECK(step.pass == steps[i].pass && step.queue == steps[i].queue && step.barrierCount == steps[i].barrierCount &&
+						step.waitCount == steps[i].waitCount && step.signalValue == steps[i].signalValue);
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	TestFrame();
+	TestRandom();
+	return Testing::Finish("RenderGraphTest");
+}
@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "ReferenceSerializer.h"
+#include "DistinctSignatures.h"
+
+using namespace Query;
+using namespace Query::Testing;
+
+namespace
+{
+	atomic<uint64_t> s_serializations(0);
+}
+
+HRESULT WINAPI D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* pRootSignature, D3D_ROOT_SIGNATURE_VERSION,
+	ID3DBlob** ppBlob, ID3DBlob**)
+{
+	s_serializations++;
+	return SerializeReference(*pRootSignature, ppBlob);
+}
+
+HRESULT WINAPI D3D12SerializeVersionedRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignature, ID3DBlob** ppBlob,
+	ID3DBlob**)
+{
+	s_serializations++;
+	return SerializeReference(*pRootSignature, ppBlob);
+}
+
+namespace
+{
+	struct Result
+	{
+		const char* name;
+		double microseconds;	//per call
+		uint64_t heapAllocations;	//HeapAlloc calls of the 1.1 to 1.0 conversion, all rounds
+		uint64_t serializations;
+		size_t entries;
+	};
+
+	// 100 distinct 1.1 signatures, downgraded to 1.0 in every one of the rounds, as a device
+	// without 1.1 support would on every pipeline creation.
+	Result Run(const char* name, const vector<unique_ptr<DistinctSignature>>& signatures, uint32_t rounds, CD3DX12_ROOT_SIGNATURE_CACHE* cache)
+	{
+		s_serializations = 0;
+		const uint64_t before = D3D12Linux::HeapAllocations();
+		const auto start = chrono::steady_clock::now();
+		for (uint32_t round = 0; round < rounds; round++)
+		{
+			for (const unique_ptr<DistinctSignature>& signature : signatures)
+			{
+				ID3DBlob* blob = nullptr;
+				ID3DBlob* error = nullptr;
+				if (cache)
+				{
+					D3DX12SerializeVersionedRootSignature(&signature->desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &blob, &error, cache);
+				}
+				else
+				{
+					D3DX12SerializeVersionedRootSignature(&signature->desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &blob, &error);
+				}
+				blob->Release();
+			}
+		}
+		const double microseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / (double(rounds) * signatures.size());
+		return { name, microseconds, D3D12Linux::HeapAllocations() - before, s_serializations, cache ? cache->GetSize() : 0 };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t rounds = argc > 1 ? uint32_t(atoi(argv[1])) : 2000;
+	vector<unique_ptr<DistinctSignature>> signatures;
+	for (UINT seed = 0; seed < 100; seed++)
+	{
+		signatures.push_back(unique_ptr<DistinctSignature>(new DistinctSignature(seed)));
+	}
+
+	CD3DX12_ROOT_SIGNATURE_CACHE cache;
+	const Result results[] = {
+		Run("uncached", signatures, rounds, nullptr),
+		Run("cached", signatures, rounds, &cache) };
+
+	printf("{\n\t\"benchmark\": \"rootSignatureCache\",\n\t\"signatures\": %zu,\n\t\"rounds\": %u,\n\t\"runs\": [", signatures.size(), rounds);
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"mode\": \"%s\", \"usPerCall\": %.3f, \"heapAllocations\": %llu, \"serializations\": %llu, \"entries\": %zu }",
+			i ? "," : "", r.name, r.microseconds, static_cast<unsigned long long>(r.heapAllocations),
+			static_cast<unsigned long long>(r.serializations), r.entries);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "ReferenceSerializer.h"
+#include "DistinctSignatures.h"
+#include "Check.h"
+
+using namespace Query;
+using namespace Query::Testing;
+
+namespace
+{
+	atomic<uint32_t> s_serializations(0);
+	atomic<bool> s_failing(false);
+}
+
+HRESULT WINAPI D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* pRootSignature, D3D_ROOT_SIGNATURE_VERSION,
+	ID3DBlob** ppBlob, ID3DBlob**)
+{
+	s_serializations++;
+	return s_failing ? E_INVALIDARG : SerializeReference(*pRootSignature, ppBlob);
+}
+
+HRESULT WINAPI D3D12SerializeVersionedRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignature, ID3DBlob** ppBlob,
+	ID3DBlob**)
+{
+	s_serializations++;
+	return s_failing ? E_INVALIDARG : SerializeReference(*pRootSignature, ppBlob);
+}
+
+namespace
+{
+	vector<uint8_t> Bytes(ID3DBlob* blob)
+	{
+		const uint8_t* begin = static_cast<const uint8_t*>(blob->GetBufferPointer());
+		return vector<uint8_t>(begin, begin + blob->GetBufferSize());
+	}
+
+	// Each of 100 signatures, downgraded to 1.0 and kept at 1.1, serializes once; every later call
+	// returns the same blob, with the bytes of an uncached serialization.
+	void TestParity()
+	{
+		vector<unique_ptr<DistinctSignature>> signatures;
+		for (UINT seed = 0; seed < 100; seed++)
+		{
+			signatures.push_back(unique_ptr<DistinctSignature>(new DistinctSignature(seed)));
+		}
+
+		CD3DX12_ROOT_SIGNATURE_CACHE cache;
+		for (D3D_ROOT_SIGNATURE_VERSION version : { D3D_ROOT_SIGNATURE_VERSION_1_0, D3D_ROOT_SIGNATURE_VERSION_1_1 })
+		{
+			vector<vector<uint8_t>> expected;
+			for (const unique_ptr<DistinctSignature>& signature : signatures)
+			{
+				ID3DBlob* blob = nullptr;
+				CHECK(SUCCEEDED(D3DX12SerializeVersionedRootSignature(&signature->desc, version, &blob, nullptr)));
+				expected.push_back(Bytes(blob));
+				blob->Release();
+			}
+
+			s_serializations = 0;
+			bool same = true;
+			for (uint32_t round = 0; round < 3; round++)
+			{
+				for (size_t i = 0; i < signatures.size(); i++)
+				{
+					ID3DBlob* blob = nullptr;
+					ID3DBlob* error = nullptr;
+					same = same && SUCCEEDED(D3DX12SerializeVersionedRootSignature(&signatures[i]->desc, version, &blob, &error, &cache)) &&
+						error == nullptr && Bytes(blob) == expected[i];
+					blob->Release();
+				}
+			}
+			CHECK(same);
+			CHECK(s_serializations == 100);
+		}
+		CHECK(cache.GetSize() == 200);
+		for (size_t i = 1; i < signatures.size(); i++)
+		{
+			CHECK(signatures[i]->desc.Desc_1_1.pParameters != signatures[i - 1]->desc.Desc_1_1.pParameters);
+		}
+	}
+
+	// Entries are found by content: a rebuilt copy shares the blob of the original, one changed
+	// range flag or target version does not.
+	void TestContent()
+	{
+		CD3DX12_ROOT_SIGNATURE_CACHE cache;
+		DistinctSignature original(7), copy(7);
+		ID3DBlob* first = nullptr;
+		ID3DBlob* second = nullptr;
+		cache.Serialize(&original.desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &first, nullptr);
+		cache.Serialize(&copy.desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &second, nullptr);
+		CHECK(first == second && cache.GetSize() == 1);
+		second->Release();
+
+		copy.ranges[0].Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE;
+		cache.Serialize(&copy.desc, D3D_ROOT_SIGNATURE_VERSION_1_1, &second, nullptr);
+		CHECK(first != second && cache.GetSize() == 2);
+		second->Release();
+		cache.Serialize(&copy.desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &second, nullptr);
+		CHECK(first != second && cache.GetSize() == 3);
+		// 1.0 drops the range flags, so the two 1.0 blobs are equal but cached apart.
+		CHECK(Bytes(first) == Bytes(second));
+		second->Release();
+		first->Release();
+	}
+
+	// A failed serialization is returned and not cached: the next call serializes again.
+	void TestFailure()
+	{
+		CD3DX12_ROOT_SIGNATURE_CACHE cache;
+		DistinctSignature signature(3);
+		ID3DBlob* blob = nullptr;
+		s_serializations = 0;
+		s_failing = true;
+		CHECK(FAILED(cache.Serialize(&signature.desc, D3D_ROOT_SIGNATURE_VERSION_1_1, &blob, nullptr)));
+		CHECK(cache.GetSize() == 0);
+		s_failing = false;
+		CHECK(SUCCEEDED(cache.Serialize(&signature.desc, D3D_ROOT_SIGNATURE_VERSION_1_1, &blob, nullptr)));
+		CHECK(cache.GetSize() == 1 && s_serializations == 2);
+		blob->Release();
+	}
+
+	// Threads asking for the same signatures end with one entry each and the right bytes.
+	void TestThreads()
+	{
+		CD3DX12_ROOT_SIGNATURE_CACHE cache;
+		vector<unique_ptr<DistinctSignature>> signatures;
+		vector<vector<uint8_t>> expected;
+		for (UINT seed = 0; seed < 16; seed++)
+		{
+			signatures.push_back(unique_ptr<DistinctSignature>(new DistinctSignature(seed)));
+			ID3DBlob* blob = nullptr;
+			D3DX12SerializeVersionedRootSignature(&signatures.back()->desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &blob, nullptr);
+			expected.push_back(Bytes(blob));
+			blob->Release();
+		}
+		atomic<uint32_t> wrong(0);
+		vector<thread> threads;
+		for (uint32_t t = 0; t < 4; t++)
+		{
+			threads.emplace_back([&, t]()
+			{
+				for (uint32_t i = 0; i < 1000; i++)
+				{
+					const size_t index = (i * 7 + t) % signatures.size();
+					ID3DBlob* blob = nullptr;
+					if (FAILED(cache.Serialize(&signatures[index]->desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &blob, nullptr)) || Bytes(blob) != expected[index])
+					{
+						wrong++;
+					}
+					if (blob)
+					{
+						blob->Release();
+					}
+				}
+			});
+		}
+		for (thread& worker : threads)
+		{
+			worker.join();
+		}
+		CHECK(wrong == 0);
+		CHECK(cache.GetSize() == signatures.size());
+	}
+}
+
+int main()
+{
+	TestParity();
+	TestContent();
+	TestFailure();
+	TestThreads();
+	return Testing::Finish("RootSignatureCacheTest");
+}
@@ -0,0 +1,195 @@
+#include "pch.h"
+#include "RootSignatureLayout.h"
+#include "ReferenceSerializer.h"
+#include "Check.h"
+#include <random>
+
+using namespace Query;
+using namespace Query::Testing;
+namespace Layout = Pipelines::RootSignatureLayout;
+using Layout::Version;
+
+HRESULT WINAPI D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* pRootSignature, D3D_ROOT_SIGNATURE_VERSION,
+	ID3DBlob** ppBlob, ID3DBlob**)
+{
+	return SerializeReference(*pRootSignature, ppBlob);
+}
+
+HRESULT WINAPI D3D12SerializeVersionedRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignature, ID3DBlob** ppBlob,
+	ID3DBlob**)
+{
+	return SerializeReference(*pRootSignature, ppBlob);
+}
+
+namespace
+{
+	// The scene signature of D3D12Query.cpp.
+	constexpr Layout::Desc<1, 0> Scene =
+	{
+		Layout::AllowInputAssemblerInputLayout |
+		Layout::DenyHullShaderRootAccess |
+		Layout::DenyDomainShaderRootAccess |
+		Layout::DenyGeometryShaderRootAccess |
+		Layout::DenyPixelShaderRootAccess,
+		{ Layout::Cbv(0, 0, Layout::DataStatic, Layout::Visibility::Vertex) },
+		{}
+	};
+
+	// A signature with every kind of parameter.
+	constexpr Layout::Desc<4, 2> Sample =
+	{
+		Layout::AllowInputAssemblerInputLayout,
+		{
+			Layout::Table(0, 2, Layout::Visibility::Pixel),
+			Layout::Constants(4, 1),
+			Layout::Cbv(0, 0, Layout::DataStatic, Layout::Visibility::Vertex),
+			Layout::Uav(2, 1)
+		},
+		{
+			Layout::DescriptorRange(Layout::RangeType::Srv, 8, 0, 0, Layout::DataStaticWhileSetAtExecute),
+			Layout::DescriptorRange(Layout::RangeType::Cbv, 1, 1, 0, Layout::DataNone, 8)
+		}
+	};
+
+	// What CreateRootSignature falls back to: the layout through the d3dx12 helpers, converted to
+	// 1.0 by d3dx12 when asked for, and serialized.
+	template<typename D>
+	vector<uint8_t> SerializeAtRuntime(const D& layout, Version version)
+	{
+		const Layout::D3D12Desc<D> desc(layout);
+		ID3DBlob* blob = nullptr;
+		ID3DBlob* error = nullptr;
+		vector<uint8_t> bytes;
+		if (SUCCEEDED(D3DX12SerializeVersionedRootSignature(&desc.desc, static_cast<D3D_ROOT_SIGNATURE_VERSION>(version), &blob, &error)))
+		{
+			const uint8_t* begin = static_cast<const uint8_t*>(blob->GetBufferPointer());
+			bytes.assign(begin, begin + blob->GetBufferSize());
+			blob->Release();
+		}
+		return bytes;
+	}
+
+	template<uint32_t Size>
+	bool Same(const Layout::Blob<Size>& blob, const vector<uint8_t>& bytes)
+	{
+		return bytes.size() == Size && memcmp(blob.bytes, bytes.data(), Size) == 0;
+	}
+
+	// The MD5 rounds of the layout and of the reference against RFC 1321's test suite.
+	void TestMd5()
+	{
+		CHECK(Md5::Digest("") == "d41d8cd98f00b204e9800998ecf8427e");
+		CHECK(Md5::Digest("abc") == "900150983cd24fb0d6963f7d28e17f72");
+		CHECK(Md5::Digest("message digest") == "f96b697d7cb7938d525a2f31aaf161d0");
+		CHECK(Md5::Digest("12345678901234567890123456789012345678901234567890123456789012345678901234567890") ==
+			"57edf4a22be3c955ac49da2e2107b67a");
+
+		// "abc" padded into one block.
+		uint32_t block[16] = { 0x80636261 };
+		block[14] = 24;
+		const Layout::Md5State state = Layout::Md5Block(Layout::Md5State{ 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 }, block);
+		CHECK(state.a == 0x98500190 && state.b == 0xb04fd23c && state.c == 0x7d3f96d6 && state.d == 0x727fe128);
+	}
+
+	// The compile-time blobs are the runtime serializations, byte for byte, checksum included.
+	void TestKnownSignatures()
+	{
+		constexpr auto scene_1_1 = Layout::Serialize<Layout::SerializedSize(Scene, Version::V1_1)>(Scene, Version::V1_1);
+		constexpr auto scene_1_0 = Layout::Serialize<Layout::SerializedSize(Scene, Version::V1_0)>(Scene, Version::V1_0);
+		constexpr auto sample_1_1 = Layout::Serialize<Layout::SerializedSize(Sample, Version::V1_1)>(Sample, Version::V1_1);
+		constexpr auto sample_1_0 = Layout::Serialize<Layout::SerializedSize(Sample, Version::V1_0)>(Sample, Version::V1_0);
+		CHECK(Same(scene_1_1, SerializeAtRuntime(Scene, Version::V1_1)));
+		CHECK(Same(scene_1_0, SerializeAtRuntime(Scene, Version::V1_0)));
+		CHECK(Same(sample_1_1, SerializeAtRuntime(Sample, Version::V1_1)));
+		CHECK(Same(sample_1_0, SerializeAtRuntime(Sample, Version::V1_0)));
+	}
+
+	// Serialize takes the blob size as a template argument; this finds the instance for a size known
+	// only at run time, from First up in steps of 4 until Last.
+	template<uint32_t First, uint32_t Last>
+	struct SerializeSized
+	{
+		template<typename D>
+		static vector<uint8_t> Run(const D& layout, Version version)
+		{
+			if (Layout::SerializedSize(layout, version) != First)
+			{
+				return SerializeSized<First + 4, Last>::Run(layout, version);
+			}
+			const auto blob = Layout::Serialize<First>(layout, version);
+			return vector<uint8_t>(blob.bytes, blob.bytes + First);
+		}
+	};
+
+	template<uint32_t Last>
+	struct SerializeSized<Last, Last>
+	{
+		template<typename D>
+		static vector<uint8_t> Run(const D&, Version)
+		{
+			return vector<uint8_t>();
+		}
+	};
+
+	// Random layouts of 8 parameters and 8 ranges, so that the containers end at every offset in
+	// the checksum's last block.
+	void TestRandom()
+	{
+		mt19937 random(1);
+		for (uint32_t round = 0; round < 2000; round++)
+		{
+			Layout::Desc<8, 8> layout = {};
+			layout.flags = random() & 0x7F;
+			for (Layout::Range& range : layout.ranges)
+			{
+				range = Layout::DescriptorRange(static_cast<Layout::RangeType>(random() % 4), 1 + random() % 16, random() % 32,
+					random() % 4, random() % 2 ? Layout::DataStatic : Layout::DescriptorsVolatile,
+					random() % 2 ? Layout::AppendRange : random() % 64);
+			}
+			uint32_t nextRange = 0;
+			for (Layout::Parameter& parameter : layout.parameters)
+			{
+				const auto visibility = static_cast<Layout::Visibility>(random() % 6);
+				switch (random() % 5)
+				{
+				case 0:
+				{
+					const uint32_t count = 1 + random() % 3;
+					const uint32_t first = nextRange + count <= 8 ? nextRange : 0;
+					parameter = Layout::Table(first, count, visibility);
+					nextRange = first + count;
+					break;
+				}
+				case 1:
+					parameter = Layout::Constants(1 + random() % 16, random() % 16, random() % 4, visibility);
+					break;
+				case 2:
+					parameter = Layout::Cbv(random() % 16, random() % 4, random() % 2 ? Layout::DataStatic : Layout::DataVolatile, visibility);
+					break;
+				case 3:
+					parameter = Layout::Srv(random() % 16, random() % 4, Layout::DataNone, visibility);
+					break;
+				default:
+					parameter = Layout::Uav(random() % 16, random() % 4, Layout::DataStaticWhileSetAtExecute, visibility);
+					break;
+				}
+			}
+			if (!CHECK(Layout::IsValid(layout)))
+			{
+				continue;
+			}
+			const Version version = random() % 2 ? Version::V1_1 : Version::V1_0;
+			// 8 root descriptors of 1.0 to 8 tables of 3 ranges of 1.1.
+			const vector<uint8_t> blob = SerializeSized<44 + 24 + 8 * (12 + 8), 44 + 24 + 8 * (12 + 8 + 3 * 24) + 4>::Run(layout, version);
+			CHECK(!blob.empty() && blob == SerializeAtRuntime(layout, version));
+		}
+	}
+}
+
+int main()
+{
+	TestMd5();
+	TestKnownSignatures();
+	TestRandom();
+	return Testing::Finish("RootSignatureLayoutTest");
+}
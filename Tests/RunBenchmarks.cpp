@@ -0,0 +1,17 @@
+#include "pch.h"
+#include "BenchmarkSuite.h"
+
+using namespace Query;
+
+// What the sample's --benchmark flag runs, for machines without Direct3D 12: every benchmark's JSON
+// file is written to the working directory and printed as it is done.
+int main()
+{
+	Benchmark::RunAll([](const wstring& file, const string& json)
+	{
+		fprintf(stderr, "%s written\n", string(file.begin(), file.end()).c_str());
+		printf("%s", json.c_str());
+		fflush(stdout);
+	});
+	return 0;
+}
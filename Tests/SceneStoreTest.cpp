@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "SceneStore.h"
+#include "Check.h"
+#include <random>
+
+using namespace Query;
+using Rendering::SceneStore;
+
+namespace
+{
+	const float WrapBounds = 1.5f;
+
+	// One object as SceneStore::Update moves it, one float operation at a time.
+	struct Object
+	{
+		float left, bottom, right, top;
+		float velocityX, velocityY;
+		float x = 0, y = 0;
+
+		static float Wrap(float offset)
+		{
+			return offset > WrapBounds ? -WrapBounds : (offset < -WrapBounds ? WrapBounds : offset);
+		}
+
+		void Move()
+		{
+			x = Wrap(x + velocityX);
+			y = Wrap(y + velocityY);
+		}
+
+		bool IsVisible() const
+		{
+			return left + x < 1.0f && right + x > -1.0f && bottom + y < 1.0f && top + y > -1.0f;
+		}
+	};
+
+	// Objects of every size up to the screen, some of them still, some fast enough to wrap within a
+	// few frames.
+	vector<Object> Generate(uint32_t count, uint32_t seed)
+	{
+		mt19937 random(seed);
+		uniform_real_distribution<float> position(-1.5f, 1.5f), size(0.0f, 0.5f), velocity(-0.1f, 0.1f);
+		vector<Object> objects(count);
+		for (Object& object : objects)
+		{
+			object.left = position(random);
+			object.bottom = position(random);
+			object.right = object.left + size(random);
+			object.top = object.bottom + size(random);
+			object.velocityX = random() % 8 ? velocity(random) : 0.0f;
+			object.velocityY = random() % 8 ? velocity(random) : 0.0f;
+		}
+		return objects;
+	}
+
+	void Add(const vector<Object>& objects, SceneStore& store)
+	{
+		store.Reset(WrapBounds);
+		store.Reserve(static_cast<uint32_t>(objects.size()));
+		for (const Object& object : objects)
+		{
+			store.Add(object.left, object.bottom, object.right, object.top, object.velocityX, object.velocityY);
+		}
+	}
+
+	bool Equal(float a, float b)
+	{
+		return memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	// The SSE kernel against the scalar model, with a count that leaves a tail of scalar objects:
+	// the offsets it keeps and writes, every object's visibility bit, and the bytes past each
+	// offset in a constant buffer slot, which it must not touch.
+	void TestKernel(size_t stride)
+	{
+		const uint32_t count = 1027;
+		vector<Object> objects = Generate(count, 1);
+		SceneStore store;
+		Add(objects, store);
+		vector<float> memory(count * stride / sizeof(float), -7.0f);
+		SceneStore::Output output;
+		output.destination = reinterpret_cast<uint8_t*>(memory.data());
+		output.stride = stride;
+
+		uint32_t offsetMismatches = 0, outputMismatches = 0, visibilityMismatches = 0, padding = 0;
+		for (uint32_t frame = 0; frame < 64; frame++)
+		{
+			store.Update(output);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				Object& object = objects[i];
+				object.Move();
+				const float* written = memory.data() + i * stride / sizeof(float);
+				offsetMismatches += !Equal(store.GetOffsetX(i), object.x) || !Equal(store.GetOffsetY(i), object.y);
+				outputMismatches += !Equal(written[0], object.x) || !Equal(written[1], object.y) || written[2] != 0 || written[3] != 0;
+				visibilityMismatches += store.IsVisible(i) != object.IsVisible();
+				for (size_t word = 4; word < stride / sizeof(float); word++)
+				{
+					padding += written[word] != -7.0f;
+				}
+			}
+		}
+		CHECK(offsetMismatches == 0);
+		CHECK(outputMismatches == 0);
+		CHECK(visibilityMismatches == 0);
+		CHECK(padding == 0);
+
+		uint32_t visible = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			visible += objects[i].IsVisible();
+		}
+		CHECK(store.CountVisible() == visible && visible > 0 && visible < count);
+	}
+
+	// Blocks on the pool move the same objects to the same offsets as one thread does.
+	void TestParallel(Threading::ThreadPool& pool)
+	{
+		const uint32_t count = 3 * SceneStore::BlockSize + 5;
+		const vector<Object> objects = Generate(count, 2);
+		SceneStore serial, parallel;
+		Add(objects, serial);
+		Add(objects, parallel);
+		vector<float> serialMemory(count * 4), parallelMemory(count * 4);
+		SceneStore::Output serialOutput, parallelOutput;
+		serialOutput.destination = reinterpret_cast<uint8_t*>(serialMemory.data());
+		serialOutput.stride = 16;
+		parallelOutput.destination = reinterpret_cast<uint8_t*>(parallelMemory.data());
+		parallelOutput.stride = 16;
+
+		for (uint32_t frame = 0; frame < 16; frame++)
+		{
+			serial.Update(serialOutput);
+			parallel.Update(parallelOutput, pool);
+		}
+		uint32_t mismatches = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			mismatches += !Equal(serial.GetOffsetX(i), parallel.GetOffsetX(i)) || !Equal(serial.GetOffsetY(i), parallel.GetOffsetY(i)) ||
+				serial.IsVisible(i) != parallel.IsVisible(i);
+		}
+		CHECK(mismatches == 0);
+		CHECK(memcmp(serialMemory.data(), parallelMemory.data(), serialMemory.size() * sizeof(float)) == 0);
+		CHECK(serial.CountVisible() == parallel.CountVisible());
+	}
+
+	// With a schedule, hidden objects fall asleep, yet every object that is not occluded has the
+	// visibility bit it would have if every object moved every frame, and after CatchUp every
+	// object has exactly the offset it would have. Then every object that is reported visible again
+	// wakes in the next Update.
+	void TestSchedule(Threading::ThreadPool* pool, float occluded)
+	{
+		const uint32_t count = 2 * SceneStore::BlockSize + 77;
+		vector<Object> objects = Generate(count, 3);
+		SceneStore store;
+		Add(objects, store);
+		SceneStore::Schedule schedule;
+		schedule.hiddenFrames = 4;
+		schedule.refreshInterval = 8;
+		store.SetSchedule(schedule);
+		const uint32_t occludedPercent = static_cast<uint32_t>(occluded * 100 + 0.5f);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			store.SetOccluded(i, i % 100 < occludedPercent);
+		}
+		vector<float> memory(count * 64 / sizeof(float));
+		SceneStore::Output output;
+		output.destination = reinterpret_cast<uint8_t*>(memory.data());
+		output.stride = 64;
+		auto update = [&]()
+		{
+			if (pool)
+			{
+				store.Update(output, *pool);
+			}
+			else
+			{
+				store.Update(output);
+			}
+			for (Object& object : objects)
+			{
+				object.Move();
+			}
+		};
+
+		uint32_t visibilityMismatches = 0, offsetMismatches = 0, maxSleeping = 0;
+		for (uint32_t frame = 1; frame <= 60; frame++)
+		{
+			update();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				visibilityMismatches += i % 100 >= occludedPercent && store.IsVisible(i) != objects[i].IsVisible();
+			}
+			const uint32_t sleeping = store.CountSleeping();
+			maxSleeping = sleeping > maxSleeping ? sleeping : maxSleeping;
+			if (frame % 13 == 0)
+			{
+				store.CatchUp();
+				for (uint32_t i = 0; i < count; i++)
+				{
+					offsetMismatches += !Equal(store.GetOffsetX(i), objects[i].x) || !Equal(store.GetOffsetY(i), objects[i].y);
+				}
+				CHECK(store.CountSleeping() == sleeping);
+			}
+		}
+		CHECK(visibilityMismatches == 0);
+		CHECK(offsetMismatches == 0);
+		CHECK(maxSleeping > count / 10);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			store.SetOccluded(i, false);
+		}
+		update();
+		uint32_t missed = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			missed += store.IsVisible(i) != objects[i].IsVisible();
+		}
+		CHECK(missed == 0);
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	TestKernel(16);
+	TestKernel(256);
+	TestParallel(pool);
+	TestSchedule(nullptr, 0.0f);
+	TestSchedule(nullptr, 0.9f);
+	TestSchedule(&pool, 0.9f);
+	return Testing::Finish("SceneStoreTest");
+}
@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "ShaderArchive.h"
+
+using namespace Query;
+using Shaders::ShaderArchive;
+
+namespace
+{
+	const wstring ArchivePath = L"ShaderArchiveBenchmark.cache";
+
+	struct Result
+	{
+		uint32_t shaders;
+		uint32_t sourceSize;
+		uint32_t bytecodeSize;
+		double describeMicroseconds = 0;	//per shader: hashing its source and identity
+		double openMicroseconds = 0;
+		double coldLookupNanoseconds = 0;	//first lookup of each shader after opening, touching the mapping
+		double warmLookupNanoseconds = 0;
+		double saveMilliseconds = 0;	//merging one new shader into the archive and serializing it
+		uint64_t fileSize = 0;
+	};
+
+	// An archive of shaders of one source size and bytecode size, each with its own entry point.
+	Result Run(uint32_t shaders, uint32_t sourceSize, uint32_t bytecodeSize)
+	{
+		Result result = { shaders, sourceSize, bytecodeSize };
+		vector<string> entryPoints(shaders);
+		string source(sourceSize, 'x');
+		const string bytecode(bytecodeSize, 'b');
+		vector<ShaderArchive::Identity> identities(shaders);
+		auto start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < shaders; i++)
+		{
+			entryPoints[i] = "Main" + to_string(i);
+			ShaderArchive::Describe(L"Shaders.hlsl", source.data(), source.size(), nullptr, entryPoints[i].c_str(), "ps_5_0", 0, identities[i]);
+		}
+		result.describeMicroseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / shaders;
+
+		vector<ShaderArchive::Blob> blobs;
+		for (const ShaderArchive::Identity& identity : identities)
+		{
+			blobs.push_back({ identity.key, identity.bytes.data(), static_cast<uint32_t>(identity.bytes.size()), identity.nameSize,
+				bytecode.data(), bytecode.size() });
+		}
+		vector<uint8_t> contents;
+		ShaderArchive::Serialize(blobs, 1, contents);
+		IO::MappedFile::WriteAtomically(ArchivePath, contents.data(), contents.size());
+		result.fileSize = contents.size();
+
+		ShaderArchive archive;
+		start = chrono::steady_clock::now();
+		archive.Open(ArchivePath, 1);
+		result.openMicroseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+		uint64_t checksum = 0;
+		for (uint32_t pass = 0; pass < 2; pass++)
+		{
+			start = chrono::steady_clock::now();
+			for (const ShaderArchive::Identity& identity : identities)
+			{
+				const void* data;
+				size_t size;
+				if (archive.Find(identity, data, size))
+				{
+					checksum += static_cast<const uint8_t*>(data)[size - 1];
+				}
+			}
+			(pass ? result.warmLookupNanoseconds : result.coldLookupNanoseconds) =
+				chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / shaders;
+		}
+		if (checksum != 2ull * 'b' * shaders)
+		{
+			fprintf(stderr, "lookups failed\n");
+		}
+
+		source[0] = 'y';
+		ShaderArchive::Identity edited;
+		ShaderArchive::Describe(L"Shaders.hlsl", source.data(), source.size(), nullptr, entryPoints[0].c_str(), "ps_5_0", 0, edited);
+		start = chrono::steady_clock::now();
+		blobs = { { edited.key, edited.bytes.data(), static_cast<uint32_t>(edited.bytes.size()), edited.nameSize, bytecode.data(), bytecode.size() } };
+		archive.MergeInto(blobs);
+		ShaderArchive::Serialize(blobs, 1, contents);
+		result.saveMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		archive.Close();
+		remove("ShaderArchiveBenchmark.cache");
+		return result;
+	}
+}
+
+int main()
+{
+	const Result results[] = {
+		Run(16, 16 * 1024, 4 * 1024),
+		Run(1000, 16 * 1024, 4 * 1024),
+		Run(10000, 4 * 1024, 2 * 1024),
+		Run(1000, 256 * 1024, 32 * 1024) };
+
+	printf("{\n\t\"benchmark\": \"shaderArchive\",\n\t\"runs\": [");
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"shaders\": %u, \"sourceSize\": %u, \"bytecodeSize\": %u, \"fileSize\": %llu, \"describeUs\": %.2f, \"openUs\": %.1f, "
+			"\"coldLookupNs\": %.1f, \"warmLookupNs\": %.1f, \"saveMs\": %.3f }",
+			i ? "," : "", r.shaders, r.sourceSize, r.bytecodeSize, static_cast<unsigned long long>(r.fileSize), r.describeMicroseconds,
+			r.openMicroseconds, r.coldLookupNanoseconds, r.warmLookupNanoseconds, r.saveMilliseconds);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
@@ -0,0 +1,251 @@
+#include "pch.h"
+#include "ShaderArchive.h"
+#include "Check.h"
+
+using namespace Query;
+using Shaders::ShaderArchive;
+using Shaders::ShaderDefine;
+
+namespace
+{
+	const wstring ArchivePath = L"ShaderArchiveTest.cache";
+	const uint64_t Salt = 47;
+
+	struct Shader
+	{
+		wstring path;
+		string source;
+		const ShaderDefine* defines;
+		const char* entryPoint;
+		const char* target;
+		uint32_t flags;
+	};
+
+	ShaderArchive::Identity Describe(const Shader& shader)
+	{
+		ShaderArchive::Identity identity;
+		ShaderArchive::Describe(shader.path, shader.source.data(), shader.source.size(), shader.defines,
+			shader.entryPoint, shader.target, shader.flags, identity);
+		return identity;
+	}
+
+	ShaderArchive::Blob MakeBlob(const ShaderArchive::Identity& identity, const string& bytecode)
+	{
+		return { identity.key, identity.bytes.data(), static_cast<uint32_t>(identity.bytes.size()), identity.nameSize,
+			bytecode.data(), bytecode.size() };
+	}
+
+	bool Write(const vector<uint8_t>& contents)
+	{
+		return IO::MappedFile::WriteAtomically(ArchivePath, contents.data(), contents.size());
+	}
+
+	bool Found(const ShaderArchive& archive, const ShaderArchive::Identity& identity, const string& bytecode)
+	{
+		const void* data;
+		size_t size;
+		return archive.Find(identity, data, size) && size == bytecode.size() && memcmp(data, bytecode.data(), size) == 0;
+	}
+
+	// Everything that changes the bytecode changes the identity; only the source leaves the name as
+	// it is, and null and empty strings differ.
+	void TestIdentity()
+	{
+		const ShaderDefine defines[] = { { "OCCLUSION", "1" }, { nullptr, nullptr } };
+		const ShaderDefine otherValue[] = { { "OCCLUSION", "2" }, { nullptr, nullptr } };
+		const ShaderDefine emptyValue[] = { { "OCCLUSION", "" }, { nullptr, nullptr } };
+		const ShaderDefine nullValue[] = { { "OCCLUSION", nullptr }, { nullptr, nullptr } };
+		const ShaderDefine split[] = { { "OCCLUSION1", "" }, { nullptr, nullptr } };
+		const Shader base = { L"Shaders.hlsl", "float4 VSMain() : SV_POSITION { return 0; }", defines, "VSMain", "vs_5_0", 0 };
+		const ShaderArchive::Identity identity = Describe(base);
+		CHECK(Describe(base).bytes == identity.bytes && Describe(base).key == identity.key);
+
+		vector<Shader> variants(9, base);
+		variants[0].path = L"Other.hlsl";
+		variants[1].defines = otherValue;
+		variants[2].defines = emptyValue;
+		variants[3].defines = nullValue;
+		variants[4].defines = split;
+		variants[5].defines = nullptr;
+		variants[6].entryPoint = "PSMain";
+		variants[7].target = "vs_5_1";
+		variants[8].flags = 1;
+		vector<ShaderArchive::Identity> identities;
+		for (const Shader& variant : variants)
+		{
+			identities.push_back(Describe(variant));
+			CHECK(identities.back().bytes != identity.bytes && identities.back().key != identity.key);
+		}
+		CHECK(identities[2].bytes != identities[3].bytes);
+
+		Shader edited = base;
+		edited.source += ' ';
+		const ShaderArchive::Identity newer = Describe(edited);
+		CHECK(newer.key != identity.key && newer.nameSize == identity.nameSize);
+		CHECK(equal(newer.bytes.begin(), newer.bytes.begin() + newer.nameSize, identity.bytes.begin()));
+		CHECK(!equal(newer.bytes.begin() + newer.nameSize, newer.bytes.end(), identity.bytes.begin() + identity.nameSize));
+	}
+
+	// A thousand shaders written, opened and looked up; then blobs whose keys collide, as a 64-bit
+	// key alone would confuse.
+	void TestLookup()
+	{
+		vector<Shader> shaders;
+		vector<string> entryPoints, bytecodes;
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			entryPoints.push_back("Main" + to_string(i));
+		}
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			shaders.push_back({ L"Shaders.hlsl", string(100 + i, static_cast<char>('a' + i % 26)), nullptr, entryPoints[i].c_str(), "vs_5_0", 0 });
+			bytecodes.push_back(string(16 + i % 64, static_cast<char>(i)));
+		}
+		vector<ShaderArchive::Identity> identities;
+		vector<ShaderArchive::Blob> blobs;
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			identities.push_back(Describe(shaders[i]));
+		}
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			blobs.push_back(MakeBlob(identities[i], bytecodes[i]));
+		}
+		blobs.push_back(MakeBlob(identities[0], "duplicate"));	//the first of an identity is kept
+
+		vector<uint8_t> contents;
+		ShaderArchive::Serialize(blobs, Salt, contents);
+		vector<uint8_t> again;
+		ShaderArchive::Serialize(blobs, Salt, again);
+		CHECK(contents == again);
+		CHECK(Write(contents));
+
+		ShaderArchive archive;
+		if (!CHECK(archive.Open(ArchivePath, Salt)))
+		{
+			return;
+		}
+		CHECK(archive.GetEntryCount() == 1000);
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			CHECK(Found(archive, identities[i], bytecodes[i]));
+			CHECK(reinterpret_cast<uintptr_t>(archive.GetData(archive.GetEntries()[i])) % ShaderArchive::BlobAlignment == 0);
+		}
+		Shader missing = shaders[0];
+		missing.flags = 1;
+		const void* data;
+		size_t size;
+		CHECK(!archive.Find(Describe(missing), data, size));
+
+		// Three identities under one key: the two stored are told apart, the third is a miss.
+		ShaderArchive::Identity colliding[3] = { identities[1], identities[2], identities[3] };
+		for (ShaderArchive::Identity& identity : colliding)
+		{
+			identity.key = identities[0].key;
+		}
+		blobs.clear();
+		blobs.push_back(MakeBlob(identities[0], bytecodes[0]));
+		blobs.push_back(MakeBlob(colliding[1], bytecodes[2]));
+		blobs.push_back(MakeBlob(colliding[0], bytecodes[1]));
+		ShaderArchive::Serialize(blobs, Salt, contents);
+		archive.Close();
+		CHECK(Write(contents));
+		if (CHECK(archive.Open(ArchivePath, Salt)))
+		{
+			CHECK(Found(archive, identities[0], bytecodes[0]));
+			CHECK(Found(archive, colliding[0], bytecodes[1]));
+			CHECK(Found(archive, colliding[1], bytecodes[2]));
+			CHECK(!archive.Find(colliding[2], data, size));
+		}
+		archive.Close();
+	}
+
+	// Saving a newer version of a shader drops the archived one, and the others stay.
+	void TestMerge()
+	{
+		const Shader vertex = { L"Shaders.hlsl", "vertex", nullptr, "VSMain", "vs_5_0", 0 };
+		const Shader pixel = { L"Shaders.hlsl", "pixel", nullptr, "PSMain", "ps_5_0", 0 };
+		Shader edited = vertex;
+		edited.source = "vertex, edited";
+		const ShaderArchive::Identity identities[3] = { Describe(vertex), Describe(pixel), Describe(edited) };
+		const string bytecodes[3] = { "vertex bytecode", "pixel bytecode", "edited bytecode" };
+
+		vector<ShaderArchive::Blob> blobs = { MakeBlob(identities[0], bytecodes[0]), MakeBlob(identities[1], bytecodes[1]) };
+		vector<uint8_t> contents;
+		ShaderArchive::Serialize(blobs, Salt, contents);
+		CHECK(Write(contents));
+		ShaderArchive archive;
+		if (!CHECK(archive.Open(ArchivePath, Salt)))
+		{
+			return;
+		}
+		blobs = { MakeBlob(identities[2], bytecodes[2]) };
+		archive.MergeInto(blobs);
+		CHECK(blobs.size() == 2);
+		ShaderArchive::Serialize(blobs, Salt, contents);
+		archive.Close();
+		CHECK(Write(contents));
+		if (CHECK(archive.Open(ArchivePath, Salt)))
+		{
+			CHECK(archive.GetEntryCount() == 2);
+			CHECK(!Found(archive, identities[0], bytecodes[0]));
+			CHECK(Found(archive, identities[1], bytecodes[1]));
+			CHECK(Found(archive, identities[2], bytecodes[2]));
+		}
+
+		// Merging with nothing new keeps everything, and the file does not grow.
+		blobs.clear();
+		archive.MergeInto(blobs);
+		vector<uint8_t> merged;
+		ShaderArchive::Serialize(blobs, Salt, merged);
+		CHECK(merged == contents);
+		archive.Close();
+	}
+
+	// Archives of another compiler or version, and damaged ones, do not open.
+	void TestRejection()
+	{
+		const Shader shader = { L"Shaders.hlsl", "source", nullptr, "VSMain", "vs_5_0", 0 };
+		const ShaderArchive::Identity identity = Describe(shader);
+		const string bytecode = "bytecode";
+		vector<uint8_t> contents;
+		ShaderArchive::Serialize({ MakeBlob(identity, bytecode) }, Salt, contents);
+
+		ShaderArchive archive;
+		CHECK(Write(contents));
+		CHECK(archive.Open(ArchivePath, Salt));
+		archive.Close();
+		CHECK(!archive.Open(ArchivePath, Salt + 1));
+		CHECK(archive.GetEntryCount() == 0);
+
+		auto rejects = [&](vector<uint8_t> damaged)
+		{
+			CHECK(Write(damaged));
+			const bool opened = archive.Open(ArchivePath, Salt);
+			archive.Close();
+			return !opened;
+		};
+		vector<uint8_t> damaged = contents;
+		reinterpret_cast<ShaderArchive::Header*>(damaged.data())->version = 1;
+		CHECK(rejects(damaged));
+		CHECK(rejects(vector<uint8_t>(contents.begin(), contents.begin() + sizeof(ShaderArchive::Header) + 8)));
+		CHECK(rejects(vector<uint8_t>(contents.begin(), contents.end() - 1)));
+		damaged = contents;
+		reinterpret_cast<ShaderArchive::Entry*>(damaged.data() + sizeof(ShaderArchive::Header))->identitySize = 1 << 20;
+		CHECK(rejects(damaged));
+		damaged = contents;
+		reinterpret_cast<ShaderArchive::Entry*>(damaged.data() + sizeof(ShaderArchive::Header))->nameSize = identity.nameSize + 1000;
+		CHECK(rejects(damaged));
+		CHECK(!rejects(contents));
+	}
+}
+
+int main()
+{
+	TestIdentity();
+	TestLookup();
+	TestMerge();
+	TestRejection();
+	remove("ShaderArchiveTest.cache");
+	return Testing::Finish("ShaderArchiveTest");
+}
@@ -0,0 +1,417 @@
+#include "pch.h"
+#include "SoftwareBackend.h"
+#include "HeadlessRunner.h"
+#include "QueryRenderer.h"
+#include "SceneGenerator.h"
+#include "Hash.h"
+#include "Check.h"
+
+using namespace Query;
+using namespace Backend;
+using Rendering::Vertex;
+
+namespace
+{
+	const uint32_t Width = 128, Height = 96;
+
+	uint32_t Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+	{
+		return r | g << 8 | b << 16 | a << 24;
+	}
+
+	// The sample's PSOs, and the scene PSO without blending or without back face culling.
+	struct Pipelines
+	{
+		Software::Pipeline scene, query, opaque, twoSided;
+
+		static Software::PipelineDesc Query()
+		{
+			Software::PipelineDesc desc;
+			desc.colorWrite = false;
+			desc.depthWrite = false;
+			return desc;
+		}
+		static Software::PipelineDesc Opaque()
+		{
+			Software::PipelineDesc desc;
+			desc.blendEnable = false;
+			return desc;
+		}
+		static Software::PipelineDesc TwoSided()
+		{
+			Software::PipelineDesc desc;
+			desc.cullBack = false;
+			return desc;
+		}
+
+		Pipelines() : scene("Scene", Software::PipelineDesc()), query("Query", Query()), opaque("Opaque", Opaque()), twoSided("TwoSided", TwoSided()) {}
+	};
+
+	// A color and a depth target with a vertex buffer, on a software device. Each frame is one
+	// command list submission; vertices are written as they are added and read at submission.
+	class Canvas
+	{
+	private:
+		static const uint32_t MaxVertices = 1 << 14;
+
+		uint32_t m_width, m_height;
+		uint32_t m_vertexCount = 0;
+		unique_ptr<IResource> m_vertices;
+		unique_ptr<IQueryHeap> m_counted, m_binary;
+		unique_ptr<IResource> m_results;
+
+	public:
+		Software::Device device;
+		unique_ptr<IResource> color, depth;
+		unique_ptr<ICommandList> commandList;
+
+		explicit Canvas(Threading::ThreadPool* pool = nullptr, uint32_t width = Width, uint32_t height = Height) :
+			m_width(width), m_height(height), device(pool)
+		{
+			color = device.CreateResource(ResourceDesc::Texture(ResourceKind::RenderTarget, width, height, Format::R8G8B8A8Unorm), Rendering::StateRenderTarget);
+			depth = device.CreateResource(ResourceDesc::Texture(ResourceKind::DepthStencil, width, height, Format::D32Float), Rendering::StateDepthWrite);
+			m_vertices = device.CreateResource(ResourceDesc::Buffer(MaxVertices * sizeof(Vertex), HeapKind::Upload), Rendering::StateCommon);
+			m_counted = device.CreateQueryHeap(QueryType::Occlusion, 64);
+			m_binary = device.CreateQueryHeap(QueryType::BinaryOcclusion, 64);
+			m_results = device.CreateResource(ResourceDesc::Buffer(128 * sizeof(uint64_t)), Rendering::StatePredication);
+			commandList = device.CreateCommandList(1);
+		}
+
+		// Adds a strip vertex at pixel coordinates, y down.
+		uint32_t AddVertex(float x, float y, float z, const float rgba[4])
+		{
+			Vertex& vertex = static_cast<Vertex*>(m_vertices->Map())[m_vertexCount];
+			vertex.position[0] = 2.0f * x / m_width - 1.0f;
+			vertex.position[1] = 1.0f - 2.0f * y / m_height;
+			vertex.position[2] = z;
+			memcpy(vertex.color, rgba, sizeof(vertex.color));
+			return m_vertexCount++;
+		}
+
+		// The rectangle [left, right] x [top, bottom] in pixels as a four vertex strip, clockwise on
+		// screen unless reversed. Returns its first vertex.
+		uint32_t AddRectangle(float left, float top, float right, float bottom, float z, const float rgba[4], bool reversed = false)
+		{
+			const uint32_t first = AddVertex(left, top, z, rgba);
+			AddVertex(reversed ? left : right, reversed ? bottom : top, z, rgba);
+			AddVertex(reversed ? right : left, reversed ? top : bottom, z, rgba);
+			AddVertex(right, bottom, z, rgba);
+			return first;
+		}
+
+		void Begin()
+		{
+			commandList->Reset(0);
+			commandList->SetViewport(m_width, m_height);
+			commandList->SetRenderTargets(color.get(), depth.get());
+			commandList->SetVertexBuffer(m_vertices.get(), sizeof(Vertex), MaxVertices * sizeof(Vertex));
+		}
+
+		void Clear(const float rgba[4], float value)
+		{
+			commandList->ClearRenderTarget(color.get(), rgba);
+			commandList->ClearDepth(depth.get(), value);
+		}
+
+		// Draws inside query index of the counted or the binary heap; Resolve gives the result. Like
+		// on D3D12, only one occlusion query may be active at a time.
+		void DrawQueried(IPipeline* pipeline, uint32_t vertexCount, uint32_t firstVertex, uint32_t index, QueryType type = QueryType::Occlusion)
+		{
+			IQueryHeap* heap = type == QueryType::Occlusion ? m_counted.get() : m_binary.get();
+			commandList->SetPipeline(pipeline);
+			commandList->BeginQuery(heap, index);
+			commandList->Draw(vertexCount, firstVertex);
+			commandList->EndQuery(heap, index);
+		}
+
+		// Resolves the counted queries [0, count) to results [0, count) and the binary ones after them.
+		void Resolve(uint32_t count)
+		{
+			commandList->ResolveQuery(m_counted.get(), 0, count, m_results.get(), 0);
+			commandList->ResolveQuery(m_binary.get(), 0, count, m_results.get(), 64 * sizeof(uint64_t));
+		}
+
+		void Submit()
+		{
+			commandList->Close();
+			device.GetQueue()->Submit(commandList.get());
+		}
+
+		IResource* GetResults() { return m_results.get(); }
+		uint64_t Counted(uint32_t index) { return static_cast<const uint64_t*>(m_results->Map())[index]; }
+		uint64_t Binary(uint32_t index) { return static_cast<const uint64_t*>(m_results->Map())[64 + index]; }
+
+		uint32_t Texel(uint32_t x, uint32_t y)
+		{
+			auto target = static_cast<Software::Resource*>(color.get());
+			return target->GetTexels()[static_cast<size_t>(y) * target->GetPitch() + x];
+		}
+
+		float Depth(uint32_t x, uint32_t y)
+		{
+			auto target = static_cast<Software::Resource*>(depth.get());
+			return target->GetDepths()[static_cast<size_t>(y) * target->GetPitch() + x];
+		}
+
+		// The visible texels of both targets, without the padding to the pitch.
+		uint64_t HashTargets()
+		{
+			Hash::Hasher hasher;
+			for (uint32_t y = 0; y < m_height; y++)
+			{
+				for (uint32_t x = 0; x < m_width; x++)
+				{
+					hasher.AddValue(Texel(x, y));
+					hasher.AddValue(Depth(x, y));
+				}
+			}
+			return hasher.Get();
+		}
+	};
+
+	const float Black[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const float White[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	// Edges through pixel centers: a pixel on an edge belongs to the triangle whose edge is a top
+	// or a left one, so rectangles sharing an edge and the two triangles of each cover every pixel
+	// once. The query PSO neither writes depth nor color, so overlaps would be counted twice.
+	void TestFillRule(Pipelines& pipelines)
+	{
+		Canvas canvas;
+		const uint32_t left = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.5f, White);
+		const uint32_t right = canvas.AddRectangle(20.5f, 10.5f, 30.5f, 20.5f, 0.5f, White);
+		const uint32_t below = canvas.AddRectangle(10.5f, 20.5f, 20.5f, 30.5f, 0.5f, White);
+		const uint32_t between = canvas.AddRectangle(10.25f, 40.25f, 20.75f, 50.75f, 0.5f, White);
+		// Across the tile boundary at 64, both ways.
+		const uint32_t across = canvas.AddRectangle(60.5f, 60.5f, 70.5f, 70.5f, 0.5f, White);
+		canvas.Begin();
+		canvas.Clear(Black, 1.0f);
+		canvas.DrawQueried(&pipelines.query, 4, left, 0);
+		canvas.DrawQueried(&pipelines.query, 4, right, 1);
+		canvas.DrawQueried(&pipelines.query, 4, below, 2);
+		canvas.DrawQueried(&pipelines.query, 4, between, 3);
+		canvas.DrawQueried(&pipelines.query, 4, across, 4);
+		canvas.DrawQueried(&pipelines.opaque, 4, left, 5);
+		canvas.DrawQueried(&pipelines.opaque, 4, right, 6);
+		canvas.Resolve(7);
+		canvas.Submit();
+		CHECK(canvas.Counted(0) == 100 && canvas.Counted(1) == 100 && canvas.Counted(2) == 100);
+		CHECK(canvas.Counted(3) == 121);
+		CHECK(canvas.Counted(4) == 100);
+		CHECK(canvas.Counted(5) == 100 && canvas.Counted(6) == 100);
+
+		// Columns 10 to 29 of rows 10 to 19, nothing around them.
+		uint32_t wrong = 0;
+		for (uint32_t y = 8; y < 23; y++)
+		{
+			for (uint32_t x = 8; x < 33; x++)
+			{
+				const bool inside = x >= 10 && x < 30 && y >= 10 && y < 20;
+				wrong += canvas.Texel(x, y) != (inside ? Pack(255, 255, 255, 255) : 0);
+			}
+		}
+		CHECK(wrong == 0);
+	}
+
+	// Counterclockwise triangles are culled by the sample's PSOs and drawn without culling.
+	void TestBackFaces(Pipelines& pipelines)
+	{
+		Canvas canvas;
+		const uint32_t reversed = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.5f, White, true);
+		canvas.Begin();
+		canvas.Clear(Black, 1.0f);
+		canvas.DrawQueried(&pipelines.query, 4, reversed, 0);
+		canvas.DrawQueried(&pipelines.query, 4, reversed, 0, QueryType::BinaryOcclusion);
+		canvas.DrawQueried(&pipelines.twoSided, 4, reversed, 1);
+		canvas.Resolve(2);
+		canvas.Submit();
+		CHECK(canvas.Counted(0) == 0 && canvas.Binary(0) == 0);
+		CHECK(canvas.Counted(1) == 100);
+		CHECK(canvas.device.GetSoftwareQueue().GetStats().culledTriangles == 4);
+	}
+
+	// D32 LESS: equal depths fail, depths outside [0, 1] are clipped, and only the passing
+	// samples are written and counted.
+	void TestDepth(Pipelines& pipelines)
+	{
+		Canvas canvas;
+		const uint32_t occluder = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.5f, White);
+		const uint32_t equal = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.5f, White);
+		const uint32_t nearer = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.4999f, White);
+		const uint32_t farther = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.6f, White);
+		const uint32_t overlapping = canvas.AddRectangle(15.5f, 10.5f, 25.5f, 20.5f, 0.6f, White);
+		const uint32_t beyond = canvas.AddRectangle(30.5f, 10.5f, 40.5f, 20.5f, 1.5f, White);
+		const uint32_t behind = canvas.AddRectangle(30.5f, 10.5f, 40.5f, 20.5f, -0.1f, White);
+		canvas.Begin();
+		canvas.Clear(Black, 1.0f);
+		canvas.DrawQueried(&pipelines.scene, 4, occluder, 0);
+		for (QueryType type : { QueryType::Occlusion, QueryType::BinaryOcclusion })
+		{
+			canvas.DrawQueried(&pipelines.query, 4, equal, 1, type);
+			canvas.DrawQueried(&pipelines.query, 4, nearer, 2, type);
+			canvas.DrawQueried(&pipelines.query, 4, farther, 3, type);
+			canvas.DrawQueried(&pipelines.query, 4, overlapping, 4, type);
+		}
+		canvas.DrawQueried(&pipelines.scene, 4, beyond, 5);
+		canvas.DrawQueried(&pipelines.scene, 4, behind, 6);
+		canvas.Resolve(7);
+		canvas.Submit();
+		CHECK(canvas.Counted(0) == 100);
+		CHECK(canvas.Counted(1) == 0 && canvas.Binary(1) == 0);
+		CHECK(canvas.Counted(2) == 100 && canvas.Binary(2) == 1);
+		CHECK(canvas.Counted(3) == 0 && canvas.Binary(3) == 0);
+		CHECK(canvas.Counted(4) == 50 && canvas.Binary(4) == 1);
+		CHECK(canvas.Counted(5) == 0 && canvas.Counted(6) == 0);
+
+		// The query PSO wrote nothing: the occluder's depth, and the clear around it.
+		CHECK(fabsf(canvas.Depth(10, 10) - 0.5f) <= Benchmark::InterpolationTolerance);
+		CHECK(fabsf(canvas.Depth(19, 19) - 0.5f) <= Benchmark::InterpolationTolerance);
+		CHECK(canvas.Depth(20, 15) == 1.0f && canvas.Depth(24, 15) == 1.0f && canvas.Depth(35, 15) == 1.0f);
+	}
+
+	// SRC_ALPHA/INV_SRC_ALPHA color with ONE/ZERO alpha, without blending, and without color
+	// writes, over a blue clear. A clear recorded between draws lands between them.
+	void TestBlending(Pipelines& pipelines)
+	{
+		Canvas canvas;
+		const float red[4] = { 1.0f, 0.0f, 0.0f, 0.6f };
+		const float blue[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+		const uint32_t blended = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.5f, red);
+		const uint32_t opaque = canvas.AddRectangle(30.5f, 10.5f, 40.5f, 20.5f, 0.5f, red);
+		const uint32_t hidden = canvas.AddRectangle(50.5f, 10.5f, 60.5f, 20.5f, 0.5f, red);
+		const uint32_t cleared = canvas.AddRectangle(70.5f, 10.5f, 80.5f, 20.5f, 0.5f, White);
+		canvas.Begin();
+		canvas.Clear(blue, 1.0f);
+		canvas.DrawQueried(&pipelines.opaque, 4, cleared, 0);
+		canvas.Clear(blue, 1.0f);
+		canvas.DrawQueried(&pipelines.scene, 4, blended, 0);
+		canvas.DrawQueried(&pipelines.opaque, 4, opaque, 1);
+		canvas.DrawQueried(&pipelines.query, 4, hidden, 2);
+		canvas.Resolve(3);
+		canvas.Submit();
+		CHECK(canvas.Counted(0) == 100 && canvas.Counted(1) == 100 && canvas.Counted(2) == 100);
+		const uint32_t background = Pack(0, 0, 255, 255);
+		CHECK(canvas.Texel(15, 15) == Pack(153, 0, 102, 153));
+		CHECK(canvas.Texel(35, 15) == Pack(255, 0, 0, 153));
+		CHECK(canvas.Texel(55, 15) == background);
+		CHECK(canvas.Texel(75, 15) == background && canvas.Depth(75, 15) == 1.0f);
+		CHECK(canvas.Texel(25, 15) == background);
+	}
+
+	// Draws are skipped while the predicate reads zero, as resolved earlier in the same
+	// submission, and a skipped draw neither writes nor counts into its query.
+	void TestPredication(Pipelines& pipelines)
+	{
+		Canvas canvas;
+		const uint32_t occluder = canvas.AddRectangle(10.5f, 10.5f, 20.5f, 20.5f, 0.5f, White);
+		const uint32_t behind = canvas.AddRectangle(12.5f, 12.5f, 18.5f, 18.5f, 0.6f, White);
+		const uint32_t visible = canvas.AddRectangle(30.5f, 10.5f, 40.5f, 20.5f, 0.6f, White);
+		const uint32_t drawn = canvas.AddRectangle(50.5f, 10.5f, 60.5f, 20.5f, 0.5f, White);
+		canvas.Begin();
+		canvas.Clear(Black, 1.0f);
+		canvas.DrawQueried(&pipelines.scene, 4, occluder, 0);
+		canvas.DrawQueried(&pipelines.query, 4, behind, 1, QueryType::BinaryOcclusion);
+		canvas.DrawQueried(&pipelines.query, 4, visible, 2, QueryType::BinaryOcclusion);
+		canvas.Resolve(3);
+		// Binary results are at 64 + index.
+		canvas.commandList->SetPredication(canvas.GetResults(), (64 + 1) * sizeof(uint64_t));
+		canvas.DrawQueried(&pipelines.opaque, 4, drawn, 3);
+		canvas.commandList->SetPredication(canvas.GetResults(), (64 + 2) * sizeof(uint64_t));
+		canvas.DrawQueried(&pipelines.opaque, 4, drawn, 4);
+		canvas.commandList->SetPredication(nullptr, 0);
+		canvas.Resolve(5);
+		canvas.Submit();
+
+		CHECK(canvas.Binary(1) == 0 && canvas.Binary(2) == 1);
+		CHECK(canvas.Counted(3) == 0 && canvas.Counted(4) == 100);
+		CHECK(canvas.Texel(55, 15) == Pack(255, 255, 255, 255));
+		const auto& stats = canvas.device.GetSoftwareQueue().GetStats();
+		CHECK(stats.predicatedDraws == 1 && stats.draws == 4);
+	}
+
+	// Overlapping blended triangles of random sizes, colors and depths over many tiles: the
+	// targets and every query come out bit for bit the same on the submitting thread alone and
+	// with pools of one and four tile workers.
+	void TestThreadCounts(Pipelines& pipelines)
+	{
+		const uint32_t width = 500, height = 300, draws = 48;
+		struct Result
+		{
+			uint64_t hash;
+			vector<uint64_t> counted;
+			uint64_t samplesPassed;
+		};
+		auto render = [&](Threading::ThreadPool* pool)
+		{
+			Canvas canvas(pool, width, height);
+			Benchmark::Random random(11);
+			vector<uint32_t> firsts;
+			for (uint32_t draw = 0; draw < draws; draw++)
+			{
+				firsts.push_back(~0u);
+				for (uint32_t vertex = 0; vertex < 5; vertex++)
+				{
+					const float rgba[4] = { random.Uniform(), random.Uniform(), random.Uniform(), random.Uniform() };
+					const uint32_t index = canvas.AddVertex(random.Uniform(-50.0f, width + 50.0f), random.Uniform(-50.0f, height + 50.0f),
+						random.Uniform(), rgba);
+					firsts.back() = firsts.back() < index ? firsts.back() : index;
+				}
+			}
+			const float clear[4] = { 0.1f, 0.2f, 0.3f, 1.0f };
+			canvas.Begin();
+			canvas.Clear(clear, 1.0f);
+			for (uint32_t draw = 0; draw < draws; draw++)
+			{
+				canvas.DrawQueried(draw % 3 ? &pipelines.twoSided : &pipelines.scene, 5, firsts[draw], draw);
+			}
+			canvas.Resolve(draws);
+			canvas.Submit();
+
+			Result result;
+			result.hash = canvas.HashTargets();
+			for (uint32_t draw = 0; draw < draws; draw++)
+			{
+				result.counted.push_back(canvas.Counted(draw));
+			}
+			result.samplesPassed = canvas.device.GetSoftwareQueue().GetStats().samplesPassed;
+			return result;
+		};
+
+		const Result alone = render(nullptr);
+		CHECK(alone.samplesPassed > 0);
+		for (uint32_t threadCount : { 1u, 4u })
+		{
+			Threading::ThreadPool pool;
+			pool.Initialize(threadCount);
+			const Result result = render(&pool);
+			CHECK(result.hash == alone.hash);
+			CHECK(result.counted == alone.counted);
+			CHECK(result.samplesPassed == alone.samplesPassed);
+		}
+	}
+
+	// The sample's frame loop: the near quad slides across the far one, so its query passes in
+	// some frames and not in others, and the far quad is skipped in the frames after it failed.
+	void TestFrameLoop()
+	{
+		const uint32_t frames = 240;
+		const Headless::RunResult result = Headless::RunSoftware(frames, 160, 90, 2);
+		CHECK(result.frames == frames && result.width == 160 && result.height == 90);
+		CHECK(result.draws + result.predicatedDraws == 3 * frames);
+		CHECK(result.predicatedDraws > 0 && result.predicatedDraws < frames);
+		CHECK(result.samplesPassed > 0);
+	}
+}
+
+int main()
+{
+	Pipelines pipelines;
+	TestFillRule(pipelines);
+	TestBackFaces(pipelines);
+	TestDepth(pipelines);
+	TestBlending(pipelines);
+	TestPredication(pipelines);
+	TestThreadCounts(pipelines);
+	TestFrameLoop();
+	return Testing::Finish("SoftwareBackendTest");
+}
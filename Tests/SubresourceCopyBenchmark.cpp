@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "ThreadPool.h"
+#include "SubresourceCopyReference.h"
+
+using namespace Query;
+using Testing::RowByRow;
+
+namespace
+{
+	// Microseconds of the best of three trials, after a warm-up copy. Small copies are repeated
+	// until each trial moves 256MB.
+	template <typename T>
+	double Time(const T& copy, size_t bytes)
+	{
+		copy();
+		size_t repeats = bytes < (64u << 20) ? (256u << 20) / bytes : 3;
+		repeats = repeats < 3 ? 3 : repeats > 100000 ? 100000 : repeats;
+		double best = 1e30;
+		for (int trial = 0; trial < 3; trial++)
+		{
+			const auto start = chrono::steady_clock::now();
+			for (size_t i = 0; i < repeats; i++)
+			{
+				copy();
+			}
+			const double microseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / repeats;
+			best = microseconds < best ? microseconds : best;
+		}
+		return best;
+	}
+
+	struct Result
+	{
+		const char* shape;
+		size_t rowBytes;
+		size_t bytes;
+		double rowByRow;	//GB/s
+		double serial;
+		double parallel;
+	};
+}
+
+// Upload copies of 4KB to 1GB: a buffer, one row; a packed texture of 4KB rows; and textures of 960
+// and 1000 RGBA8 texels a row, packed in the source and pitched to 4KB in the upload heap, the way
+// GetCopyableFootprints lays them out. The largest size can be lowered with the first argument.
+int main(int argc, char** argv)
+{
+	const size_t largest = argc > 1 ? size_t(strtoull(argv[1], nullptr, 10)) : size_t(1) << 30;
+	Threading::ThreadPool pool;
+	pool.Initialize();
+	auto parallelFor = [&pool](UINT count, const function<void(uint32_t)>& body) { pool.ParallelFor(count, body); };
+
+	vector<Result> results;
+	for (size_t bytes = 4096; bytes <= largest; bytes *= 4)
+	{
+		vector<uint8_t> source(bytes, 1), destination(bytes, 0);
+		const UINT pitchedRows = UINT(bytes / 4096);
+		struct Shape
+		{
+			const char* name;
+			SIZE_T rowSize;
+			UINT rows;
+			LONG_PTR sourcePitch;
+			SIZE_T destinationPitch;
+		};
+		const Shape shapes[] = {
+			{ "buffer", bytes, 1, LONG_PTR(bytes), bytes },
+			{ "packedTexture", 4096, pitchedRows, 4096, 4096 },
+			{ "pitchedTexture", 3840, pitchedRows, 3840, 4096 },
+			{ "pitchedTexture", 4000, pitchedRows, 4000, 4096 } };
+		for (const Shape& shape : shapes)
+		{
+			const D3D12_SUBRESOURCE_DATA src = { source.data(), shape.sourcePitch, shape.sourcePitch * LONG_PTR(shape.rows) };
+			const D3D12_MEMCPY_DEST dest = { destination.data(), shape.destinationPitch, shape.destinationPitch * shape.rows };
+			const size_t copied = shape.rowSize * shape.rows;
+			auto rate = [copied](double microseconds) { return copied / microseconds / 1e3; };
+			Result result = { shape.name, shape.rowSize, bytes, 0, 0, 0 };
+			result.rowByRow = rate(Time([&]() { RowByRow(&dest, &src, shape.rowSize, shape.rows, 1); }, copied));
+			result.serial = rate(Time([&]() { MemcpySubresource(&dest, &src, shape.rowSize, shape.rows, 1); }, copied));
+			result.parallel = rate(Time([&]() { MemcpySubresource(&dest, &src, shape.rowSize, shape.rows, 1, parallelFor); }, copied));
+			results.push_back(result);
+		}
+	}
+
+	printf("{\n\t\"benchmark\": \"subresourceCopy\",\n\t\"threads\": %u,\n\t\"runs\": [", pool.GetThreadCount());
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"shape\": \"%s\", \"rowBytes\": %zu, \"bytes\": %zu, \"rowByRowGBs\": %.2f, \"serialGBs\": %.2f, \"parallelGBs\": %.2f }",
+			i ? "," : "", r.shape, r.rowBytes, r.bytes, r.rowByRow, r.serial, r.parallel);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
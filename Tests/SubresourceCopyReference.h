@@ -0,0 +1,21 @@
+#pragma once
+
+// The loop MemcpySubresource had before it learned blocks and streaming stores, which the copy
+// tests check against and the benchmark compares with.
+namespace Query {
+	namespace Testing
+	{
+		inline void RowByRow(const D3D12_MEMCPY_DEST* pDest, const D3D12_SUBRESOURCE_DATA* pSrc, SIZE_T rowSize, UINT rows, UINT slices)
+		{
+			for (UINT z = 0; z < slices; z++)
+			{
+				BYTE* destSlice = reinterpret_cast<BYTE*>(pDest->pData) + pDest->SlicePitch * z;
+				const BYTE* srcSlice = reinterpret_cast<const BYTE*>(pSrc->pData) + pSrc->SlicePitch * z;
+				for (UINT y = 0; y < rows; y++)
+				{
+					memcpy(destSlice + pDest->RowPitch * y, srcSlice + pSrc->RowPitch * y, rowSize);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#include "pch.h"
+#include "ThreadPool.h"
+#include "SubresourceCopyReference.h"
+#include "Check.h"
+#include <random>
+
+using namespace Query;
+using Testing::RowByRow;
+
+namespace
+{
+	// Random shapes, packed and pitched, with sources stored bottom-up, unaligned, and copied whole
+	// or in three ranges, streamed and not: every copy matches the row-by-row loop, padding included.
+	void TestRandom()
+	{
+		mt19937 random(1);
+		for (uint32_t round = 0; round < 3000; round++)
+		{
+			const SIZE_T rowSize = 1 + random() % 5000;
+			const UINT rows = 1 + random() % 64;
+			const UINT slices = 1 + random() % 4;
+			const bool packed = random() % 2 == 0;
+			const SIZE_T destPitch = packed ? rowSize : rowSize + random() % 300;
+			const SIZE_T srcPitch = packed ? rowSize : rowSize + random() % 300;
+			const bool bottomUp = random() % 4 == 0;
+
+			vector<uint8_t> source(srcPitch * rows * slices + 64);
+			for (uint8_t& byte : source)
+			{
+				byte = uint8_t(random());
+			}
+			vector<uint8_t> expected(destPitch * rows * slices + 64, 0), whole(expected), ranged(expected);
+			D3D12_SUBRESOURCE_DATA src = { source.data() + 1, LONG_PTR(srcPitch), LONG_PTR(srcPitch * rows) };
+			if (bottomUp)
+			{
+				src.pData = source.data() + 1 + srcPitch * (rows * slices - 1);
+				src.RowPitch = -src.RowPitch;
+				src.SlicePitch = -src.SlicePitch;
+			}
+			const D3D12_MEMCPY_DEST expectedDest = { expected.data() + 3, destPitch, destPitch * rows };
+			const D3D12_MEMCPY_DEST wholeDest = { whole.data() + 3, destPitch, destPitch * rows };
+			const D3D12_MEMCPY_DEST rangedDest = { ranged.data() + 3, destPitch, destPitch * rows };
+			RowByRow(&expectedDest, &src, rowSize, rows, slices);
+			MemcpySubresource(&wholeDest, &src, rowSize, rows, slices);
+
+			const UINT64 total = UINT64(rows) * slices;
+			const UINT64 first = random() % total;
+			const UINT64 count = random() % (total - first + 1);
+			const bool streaming = random() % 2 == 0;
+			MemcpySubresourceRows(&rangedDest, &src, rowSize, rows, 0, first, streaming);
+			MemcpySubresourceRows(&rangedDest, &src, rowSize, rows, first, count, !streaming);
+			MemcpySubresourceRows(&rangedDest, &src, rowSize, rows, first + count, total - first - count, streaming);
+			D3DX12StreamingFence();
+
+			CHECK(whole == expected);
+			CHECK(ranged == expected);
+		}
+	}
+
+	// Copies past the parallel threshold, split into chunks on the pool: a pitched texture, a packed
+	// one and a buffer.
+	void TestParallel(Threading::ThreadPool& pool)
+	{
+		auto parallelFor = [&pool](UINT count, const function<void(uint32_t)>& body) { pool.ParallelFor(count, body); };
+		const SIZE_T rowSize = 16384 * 4;
+		const UINT rows = 640;
+		vector<uint8_t> source(rowSize * rows);
+		for (size_t i = 0; i < source.size(); i++)
+		{
+			source[i] = uint8_t(i * 31);
+		}
+		const D3D12_SUBRESOURCE_DATA src = { source.data(), LONG_PTR(rowSize), LONG_PTR(rowSize * rows) };
+		for (SIZE_T destPitch : { rowSize + 256, rowSize })
+		{
+			vector<uint8_t> expected(destPitch * rows, 0), actual(expected);
+			const D3D12_MEMCPY_DEST expectedDest = { expected.data(), destPitch, destPitch * rows };
+			const D3D12_MEMCPY_DEST actualDest = { actual.data(), destPitch, destPitch * rows };
+			RowByRow(&expectedDest, &src, rowSize, rows, 1);
+			MemcpySubresource(&actualDest, &src, rowSize, rows, 1, parallelFor);
+			CHECK(actual == expected);
+		}
+
+		vector<uint8_t> buffer(source.size(), 0);
+		const D3D12_MEMCPY_DEST bufferDest = { buffer.data(), source.size(), source.size() };
+		const D3D12_SUBRESOURCE_DATA bufferSrc = { source.data(), LONG_PTR(source.size()), LONG_PTR(source.size()) };
+		MemcpySubresource(&bufferDest, &bufferSrc, source.size(), 1, 1, parallelFor);
+		CHECK(buffer == source);
+	}
+}
+
+int main()
+{
+	Threading::ThreadPool pool;
+	pool.Initialize(4);
+	TestRandom();
+	TestParallel(pool);
+	return Testing::Finish("SubresourceCopyTest");
+}
@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "TaskGraph.h"
+
+using namespace Query;
+using Threading::TaskGraph;
+using Threading::ThreadPool;
+
+namespace
+{
+	struct Result
+	{
+		uint32_t tasks;
+		uint32_t taskMicroseconds;
+		double wallMilliseconds = 0;
+		double serialMilliseconds = 0;	//the sum of the task times, what running them in order costs
+		double criticalPathMilliseconds = 0;
+	};
+
+	// Startup-like graphs of four independent chains; each task depends on the one four before it.
+	// With empty tasks the wall time is the graph's own overhead.
+	Result Run(ThreadPool& pool, uint32_t tasks, uint32_t taskMicroseconds)
+	{
+		Result result = { tasks, taskMicroseconds };
+		TaskGraph graph;
+		for (uint32_t i = 0; i < tasks; i++)
+		{
+			graph.AddTask("stub", [taskMicroseconds]()
+			{
+				if (taskMicroseconds)
+				{
+					this_thread::sleep_for(chrono::microseconds(taskMicroseconds));
+				}
+			});
+			if (i >= 4)
+			{
+				graph.DependsOn(i, i - 4);
+			}
+		}
+		graph.Run(pool);
+		result.wallMilliseconds = graph.GetWallMilliseconds();
+		result.serialMilliseconds = graph.GetTaskMilliseconds();
+		result.criticalPathMilliseconds = graph.GetCriticalPathMilliseconds();
+		return result;
+	}
+}
+
+int main()
+{
+	ThreadPool pool;
+	pool.Initialize(4);
+	const Result results[] = {
+		Run(pool, 4, 1000),
+		Run(pool, 16, 1000),
+		Run(pool, 64, 1000),
+		Run(pool, 16, 10000),
+		Run(pool, 64, 0),
+		Run(pool, 1024, 0) };
+
+	printf("{\n\t\"benchmark\": \"taskGraph\",\n\t\"workers\": %u,\n\t\"runs\": [", pool.GetThreadCount());
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"tasks\": %u, \"taskUs\": %u, \"wallMs\": %.3f, \"serialMs\": %.3f, \"criticalPathMs\": %.3f }",
+			i ? "," : "", r.tasks, r.taskMicroseconds, r.wallMilliseconds, r.serialMilliseconds, r.criticalPathMilliseconds);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "TaskGraph.h"
+#include "Check.h"
+#include <random>
+
+using namespace Query;
+using Threading::TaskGraph;
+using Threading::ThreadPool;
+
+namespace
+{
+	void Sleep(uint32_t milliseconds)
+	{
+		this_thread::sleep_for(chrono::milliseconds(milliseconds));
+	}
+
+	// The startup graph of the sample, with sleeps for the work: shader compilation is the long
+	// chain, and the swap chain has to be created on the calling thread.
+	void TestStartup(ThreadPool& pool)
+	{
+		TaskGraph graph;
+		const thread::id caller = this_thread::get_id();
+		atomic<bool> swapChainOnCaller(false);
+		const uint32_t device = graph.AddTask("Device", []() { Sleep(10); });
+		const uint32_t shaders = graph.AddTask("Shaders", []() { Sleep(30); });
+		const uint32_t swapChain = graph.AddTask("SwapChain", [&]() { swapChainOnCaller = this_thread::get_id() == caller; Sleep(5); },
+			TaskGraph::Affinity::Caller);
+		const uint32_t rootSignature = graph.AddTask("RootSignature", []() { Sleep(2); });
+		const uint32_t pipelines = graph.AddTask("Pipelines", []() { Sleep(10); });
+		graph.DependsOn(swapChain, device);
+		graph.DependsOn(rootSignature, device);
+		graph.DependsOn(pipelines, rootSignature);
+		graph.DependsOn(pipelines, shaders);
+		if (!CHECK(graph.Run(pool)))
+		{
+			return;
+		}
+		CHECK(swapChainOnCaller);
+		CHECK(graph.GetTiming(swapChain).thread == 0);
+		CHECK(graph.GetCriticalPath() == vector<uint32_t>({ shaders, pipelines }));
+		CHECK(graph.GetTiming(shaders).critical && graph.GetTiming(pipelines).critical && !graph.GetTiming(device).critical);
+		CHECK(graph.GetCriticalPathMilliseconds() >= 40 && graph.GetCriticalPathMilliseconds() <= graph.GetWallMilliseconds());
+		CHECK(graph.GetTaskMilliseconds() >= 57);
+		CHECK(graph.GetTiming(pipelines).start >= graph.GetTiming(shaders).start + graph.GetTiming(shaders).duration);
+
+		const string report = graph.Report();
+		CHECK(report.find("5 tasks") == 0);
+		CHECK(report.find("* Shaders") != string::npos && report.find("  Device") != string::npos);
+	}
+
+	// Random graphs: every task runs once, after all of its dependencies have finished, and Caller
+	// tasks run on the calling thread.
+	void TestRandom(ThreadPool& pool)
+	{
+		mt19937 random(1);
+		for (uint32_t round = 0; round < 200; round++)
+		{
+			const uint32_t count = 1 + random() % 48;
+			TaskGraph graph;
+			vector<atomic<uint32_t>> runs(count);
+			vector<atomic<bool>> finished(count);
+			vector<vector<uint32_t>> dependencies(count);
+			atomic<uint32_t> misordered(0), offCaller(0);
+			const thread::id caller = this_thread::get_id();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				runs[i] = 0;
+				finished[i] = false;
+				// Dependencies only point backwards, so the graph has no cycle.
+				for (uint32_t j = 0; j < i; j++)
+				{
+					if (random() % 8 == 0)
+					{
+						dependencies[i].push_back(j);
+					}
+				}
+				const bool onCaller = random() % 4 == 0;
+				graph.AddTask("task", [&, i, onCaller]()
+				{
+					for (uint32_t dependency : dependencies[i])
+					{
+						misordered += finished[dependency] ? 0 : 1;
+					}
+					offCaller += onCaller && this_thread::get_id() != caller ? 1 : 0;
+					runs[i]++;
+					finished[i] = true;
+				}, onCaller ? TaskGraph::Affinity::Caller : TaskGraph::Affinity::Any);
+			}
+			for (uint32_t i = 0; i < count; i++)
+			{
+				for (uint32_t dependency : dependencies[i])
+				{
+					graph.DependsOn(i, dependency);
+				}
+			}
+			if (!CHECK(graph.Run(pool)))
+			{
+				continue;
+			}
+			CHECK(misordered == 0 && offCaller == 0);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				CHECK(runs[i] == 1);
+			}
+			CHECK(!graph.GetCriticalPath().empty());
+			for (size_t i = 1; i < graph.GetCriticalPath().size(); i++)
+			{
+				const vector<uint32_t>& previous = dependencies[graph.GetCriticalPath()[i]];
+				CHECK(find(previous.begin(), previous.end(), graph.GetCriticalPath()[i - 1]) != previous.end());
+			}
+		}
+	}
+
+	// A cycle fails the run before any task starts; an empty graph runs at once.
+	void TestCycle(ThreadPool& pool)
+	{
+		TaskGraph graph;
+		atomic<uint32_t> runs(0);
+		const uint32_t first = graph.AddTask("first", [&]() { runs++; });
+		const uint32_t second = graph.AddTask("second", [&]() { runs++; });
+		const uint32_t third = graph.AddTask("third", [&]() { runs++; });
+		graph.DependsOn(second, first);
+		graph.DependsOn(third, second);
+		graph.DependsOn(second, third);
+		CHECK(!graph.Run(pool));
+		CHECK(runs == 0);
+
+		TaskGraph empty;
+		CHECK(empty.Run(pool) && empty.GetCriticalPath().empty() && empty.GetTaskMilliseconds() == 0);
+	}
+}
+
+int main()
+{
+	ThreadPool pool;
+	pool.Initialize(4);
+	TestStartup(pool);
+	TestRandom(pool);
+	TestCycle(pool);
+	return Testing::Finish("TaskGraphTest");
+}
@@ -0,0 +1,60 @@
+#include "pch.h"
+#include "TransientAliaser.h"
+#include <random>
+
+using namespace Query;
+using Memory::TransientAliaser;
+
+namespace
+{
+	struct Result
+	{
+		uint32_t resources;
+		uint32_t passes;
+		double compileMicroseconds = 0;
+		double saved = 0;	//fraction of the unaliased size aliasing saves
+	};
+
+	// Render targets of 256KB to 32MB alive over a few passes each, spread over the frame.
+	Result Run(uint32_t resources, uint32_t passes, uint32_t iterations)
+	{
+		mt19937 random(1);
+		TransientAliaser aliaser;
+		for (uint32_t i = 0; i < resources; i++)
+		{
+			const uint32_t firstPass = random() % passes;
+			const uint32_t length = random() % 8;
+			aliaser.Add({ (256ull << 10) << (random() % 8), random() % 4 ? 64 * 1024ull : 4 * 1024 * 1024ull,
+				firstPass, firstPass + length < passes ? firstPass + length : passes - 1 });
+		}
+
+		Result result = { resources, passes };
+		const auto start = chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			aliaser.Compile();
+		}
+		result.compileMicroseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+		result.saved = 1 - static_cast<double>(aliaser.GetHeapSize()) / aliaser.GetUnaliasedSize();
+		return result;
+	}
+}
+
+int main()
+{
+	const Result results[] = {
+		Run(16, 16, 10000),
+		Run(64, 64, 1000),
+		Run(256, 256, 100),
+		Run(1024, 1000, 10) };
+
+	printf("{\n\t\"benchmark\": \"aliasing\",\n\t\"runs\": [");
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& result = results[i];
+		printf("%s\n\t\t{ \"resources\": %u, \"passes\": %u, \"compileUs\": %.2f, \"saved\": %.4f }",
+			i ? "," : "", result.resources, result.passes, result.compileMicroseconds, result.saved);
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
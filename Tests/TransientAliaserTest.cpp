@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "TransientAliaser.h"
+#include "Check.h"
+#include <random>
+
+using namespace Query;
+using Memory::TransientAliaser;
+
+namespace
+{
+	bool Overlaps(const TransientAliaser& aliaser, uint32_t a, uint32_t b)
+	{
+		const uint64_t beginA = aliaser.GetPlacement(a).offset, beginB = aliaser.GetPlacement(b).offset;
+		return beginA < beginB + aliaser.GetResource(b).size && beginB < beginA + aliaser.GetResource(a).size;
+	}
+
+	bool LifetimesOverlap(const TransientAliaser::Resource& a, const TransientAliaser::Resource& b)
+	{
+		return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+	}
+
+	// Everything a layout has to hold: resources alive together never share memory, offsets are
+	// aligned and inside the heap, a resource is aliased exactly when its memory is shared, and every
+	// aliased resource has one barrier, at its first pass, naming the previous owner when there is
+	// only one.
+	void CheckLayout(const TransientAliaser& aliaser)
+	{
+		const uint32_t count = aliaser.GetResourceCount();
+		vector<uint32_t> barriers(count, 0);
+		for (const TransientAliaser::AliasingBarrier& barrier : aliaser.GetBarriers())
+		{
+			if (!CHECK(barrier.after < count))
+			{
+				continue;
+			}
+			barriers[barrier.after]++;
+			CHECK(barrier.pass == aliaser.GetResource(barrier.after).firstPass);
+			CHECK(barrier.before == TransientAliaser::None || Overlaps(aliaser, barrier.before, barrier.after));
+		}
+		for (size_t i = 1; i < aliaser.GetBarriers().size(); i++)
+		{
+			CHECK(aliaser.GetBarriers()[i - 1].pass <= aliaser.GetBarriers()[i].pass);
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const TransientAliaser::Resource& resource = aliaser.GetResource(i);
+			const TransientAliaser::Placement& placement = aliaser.GetPlacement(i);
+			CHECK(placement.offset % resource.alignment == 0);
+			CHECK(placement.offset + resource.size <= aliaser.GetHeapSize());
+			CHECK(aliaser.GetHeapAlignment() % resource.alignment == 0);
+			bool shared = false;
+			for (uint32_t j = 0; j < count; j++)
+			{
+				if (j != i && Overlaps(aliaser, i, j))
+				{
+					CHECK(!LifetimesOverlap(resource, aliaser.GetResource(j)));
+					shared = true;
+				}
+			}
+			CHECK(placement.aliased == shared);
+			CHECK(barriers[i] == (shared ? 1u : 0u));
+		}
+		CHECK(aliaser.GetHeapSize() <= aliaser.GetUnaliasedSize());
+	}
+
+	// The passes of the sample with an occluder depth and a downsampled query depth: the two depth
+	// targets are never alive together, so they share memory, and the color target spans the frame.
+	void TestFrame()
+	{
+		const uint64_t alignment = 64 * 1024;
+		TransientAliaser aliaser;
+		const uint32_t color = aliaser.Add({ 8u << 20, alignment, 0, 4 });
+		const uint32_t occluderDepth = aliaser.Add({ 8u << 20, alignment, 0, 1 });
+		const uint32_t queryDepth = aliaser.Add({ 512u << 10, alignment, 2, 3 });
+		aliaser.Compile();
+		CheckLayout(aliaser);
+		CHECK(aliaser.GetHeapSize() == (16u << 20));
+		CHECK(Overlaps(aliaser, occluderDepth, queryDepth));
+		CHECK(!aliaser.GetPlacement(color).aliased);
+		CHECK(aliaser.GetBarriers().size() == 2);
+		CHECK(aliaser.GetBarriers()[0].pass == 0 && aliaser.GetBarriers()[0].before == queryDepth && aliaser.GetBarriers()[0].after == occluderDepth);
+		CHECK(aliaser.GetBarriers()[1].pass == 2 && aliaser.GetBarriers()[1].before == occluderDepth && aliaser.GetBarriers()[1].after == queryDepth);
+
+		// Declared the other way round, a pass range is fixed up rather than rejected.
+		aliaser.Clear();
+		aliaser.Add({ 1024, 0, 3, 1 });
+		CHECK(aliaser.GetResource(0).alignment == 1 && aliaser.GetResource(0).firstPass == 3 && aliaser.GetResource(0).lastPass == 3);
+	}
+
+	// Random declarations: every layout is valid, and compiling the same declarations again, in
+	// another aliaser, gives the same offsets and barriers.
+	void TestRandom()
+	{
+		mt19937 random(1);
+		for (uint32_t round = 0; round < 200; round++)
+		{
+			TransientAliaser aliaser, again;
+			const uint32_t count = 1 + random() % 64;
+			const uint32_t passes = 1 + random() % 32;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const uint32_t firstPass = random() % passes;
+				const TransientAliaser::Resource resource = {
+					(1 + random() % 256) * 4096ull,
+					random() % 4 ? 64 * 1024ull : 4 * 1024 * 1024ull,
+					firstPass,
+					static_cast<uint32_t>(firstPass + random() % (passes - firstPass)) };
+				aliaser.Add(resource);
+				again.Add(resource);
+			}
+			aliaser.Compile();
+			again.Compile();
+			CheckLayout(aliaser);
+
+			CHECK(aliaser.GetHeapSize() == again.GetHeapSize());
+			for (uint32_t i = 0; i < count; i++)
+			{
+				CHECK(aliaser.GetPlacement(i).offset == again.GetPlacement(i).offset);
+			}
+			if (CHECK(aliaser.GetBarriers().size() == again.GetBarriers().size()))
+			{
+				for (size_t i = 0; i < aliaser.GetBarriers().size(); i++)
+				{
+					const TransientAliaser::AliasingBarrier& a = aliaser.GetBarriers()[i];
+					const TransientAliaser::AliasingBarrier& b = again.GetBarriers()[i];
+					CHECK(a.pass == b.pass && a.before == b.before && a.after == b.after);
+				}
+			}
+
+			// Compiling twice in a row changes nothing either.
+			const uint64_t heapSize = aliaser.GetHeapSize();
+			aliaser.Compile();
+			CHECK(aliaser.GetHeapSize() == heapSize);
+		}
+	}
+}
+
+int main()
+{
+	TestFrame();
+	TestRandom();
+	return Testing::Finish("TransientAliaserTest");
+}
@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "FrameArena.h"
+#include "UploadMocks.h"
+
+using namespace Query;
+using Memory::FrameArena;
+using namespace Query::Testing;
+
+namespace
+{
+	struct Result
+	{
+		UINT size;
+		UINT16 mips;
+		UINT16 slices;
+		double heapMicroseconds = 0;	//per upload
+		double arenaMicroseconds = 0;
+		uint64_t heapAllocations = 0;	//HeapAlloc calls of one trial
+	};
+
+	// Uploads every subresource of a texture array, 64 times a frame for 16 frames, through the
+	// heap overload and through the arena overload with a FrameArena reset every frame. The
+	// sources are the size of the largest mip, shared by all of them.
+	Result Run(UINT size, UINT16 mips, UINT16 slices)
+	{
+		Result result = { size, mips, slices };
+		MockDevice device;
+		const D3D12_RESOURCE_DESC desc = TextureDesc(size, mips, slices);
+		const UINT count = UINT(mips) * slices;
+		UINT64 requiredSize = 0;
+		device.GetCopyableFootprints(&desc, 0, count, 0, nullptr, nullptr, nullptr, &requiredSize);
+		MockResource texture(&device, desc);
+		MockResource intermediate(&device, BufferDesc(requiredSize));
+		MockCommandList commandList;
+		vector<uint8_t> texels(size_t(size) * size * 4, 1);
+		vector<D3D12_SUBRESOURCE_DATA> data(count);
+		for (UINT i = 0; i < count; i++)
+		{
+			const LONG_PTR width = size >> (i % mips) ? size >> (i % mips) : 1;
+			data[i] = { texels.data(), width * 4, width * width * 4 };
+		}
+
+		// Best of three trials each, alternating, so neither overload gets a warmer cache.
+		const uint32_t frames = 16, uploads = 64;
+		FrameArena arena;
+		CD3DX12_SCRATCH_ARENA<FrameArena> scratch(arena);
+		result.heapMicroseconds = result.arenaMicroseconds = 1e30;
+		for (uint32_t trial = 0; trial < 3; trial++)
+		{
+			const uint64_t before = D3D12Linux::HeapAllocations();
+			auto start = chrono::steady_clock::now();
+			for (uint32_t i = 0; i < frames * uploads; i++)
+			{
+				UpdateSubresources(&commandList, &texture, &intermediate, 0, 0, count, data.data());
+			}
+			double microseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / (frames * uploads);
+			result.heapMicroseconds = microseconds < result.heapMicroseconds ? microseconds : result.heapMicroseconds;
+			result.heapAllocations = D3D12Linux::HeapAllocations() - before;
+
+			start = chrono::steady_clock::now();
+			for (uint32_t frame = 0; frame < frames; frame++)
+			{
+				for (uint32_t i = 0; i < uploads; i++)
+				{
+					UpdateSubresources(&commandList, &texture, &intermediate, 0, 0, count, data.data(), &scratch);
+				}
+				arena.Reset();
+			}
+			microseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / (frames * uploads);
+			result.arenaMicroseconds = microseconds < result.arenaMicroseconds ? microseconds : result.arenaMicroseconds;
+		}
+		return result;
+	}
+}
+
+int main()
+{
+	const Result results[] = {
+		Run(4, 3, 1),
+		Run(16, 5, 64),
+		Run(16, 5, 512),
+		Run(64, 7, 64),
+		Run(256, 9, 16) };
+
+	printf("{\n\t\"benchmark\": \"updateSubresources\",\n\t\"runs\": [");
+	for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+	{
+		const Result& r = results[i];
+		printf("%s\n\t\t{ \"size\": %u, \"mips\": %u, \"slices\": %u, \"heapUs\": %.3f, \"arenaUs\": %.3f, \"heapAllocations\": %llu }",
+			i ? "," : "", r.size, r.mips, r.slices, r.heapMicroseconds, r.arenaMicroseconds,
+			static_cast<unsigned long long>(r.heapAllocations));
+	}
+	printf("\n\t]\n}\n");
+	return 0;
+}
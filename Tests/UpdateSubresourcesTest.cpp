@@ -0,0 +1,216 @@
+#include "pch.h"
+#include "FrameArena.h"
+#include "ThreadPool.h"
+#include "UploadMocks.h"
+#include "Check.h"
+#include <new>
+
+using namespace Query;
+using Memory::FrameArena;
+using namespace Query::Testing;
+
+// Every operator new of the process is counted, next to the HeapAlloc calls the shim counts.
+namespace
+{
+	atomic<uint64_t> s_news(0);
+
+	uint64_t Allocations()
+	{
+		return s_news + D3D12Linux::HeapAllocations();
+	}
+}
+
+void* operator new(size_t size)
+{
+	s_news++;
+	void* memory = malloc(size ? size : 1);
+	if (!memory)
+	{
+		throw bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+namespace
+{
+	// A 2048x2048 RGBA8 texture with 12 mips, every mip read from the same texels.
+	struct Upload
+	{
+		static const UINT Mips = 12;
+
+		MockDevice device;
+		MockResource texture;
+		MockResource intermediate;
+		MockCommandList commandList;
+		vector<uint8_t> texels;
+		D3D12_SUBRESOURCE_DATA data[Mips];
+		UINT64 requiredSize = 0;
+
+		Upload() :
+			texture(&device, TextureDesc(2048, Mips, 1)),
+			intermediate(&device, BufferDesc(RequiredSize(device))),
+			texels(2048 * 2048 * 4)
+		{
+			for (size_t i = 0; i < texels.size(); i++)
+			{
+				texels[i] = uint8_t(i * 7);
+			}
+			for (UINT mip = 0; mip < Mips; mip++)
+			{
+				const LONG_PTR width = 2048 >> mip;
+				data[mip] = { texels.data(), width * 4, width * width * 4 };
+			}
+			requiredSize = RequiredSize(device);
+		}
+
+		static UINT64 RequiredSize(MockDevice& device)
+		{
+			const D3D12_RESOURCE_DESC desc = TextureDesc(2048, Mips, 1);
+			UINT64 size = 0;
+			device.GetCopyableFootprints(&desc, 0, Mips, 0, nullptr, nullptr, nullptr, &size);
+			return size;
+		}
+	};
+
+	// The heap overload allocates on every call; the arena overload writes the same bytes and,
+	// once the first of 100 frames of 8 uploads has grown the arena, allocates nothing.
+	void TestArenaOverload()
+	{
+		Upload upload;
+		vector<uint8_t>& memory = upload.intermediate.GetMemory();
+		uint64_t before = Allocations();
+		CHECK(UpdateSubresources(&upload.commandList, &upload.texture, &upload.intermediate, 0, 0, Upload::Mips, upload.data) == upload.requiredSize);
+		CHECK(Allocations() - before == 1);
+		const vector<uint8_t> expected = memory;
+
+		// 8 uploads take 4KB and a bit of scratch, so the first frame grows the arena to two blocks.
+		FrameArena arena(4096);
+		CD3DX12_SCRATCH_ARENA<FrameArena> scratch(arena);
+		uint64_t allocations = 0;
+		size_t blocks = 0;
+		bool same = true;
+		upload.commandList.copies = 0;
+		for (uint32_t frame = 0; frame < 100; frame++)
+		{
+			before = Allocations();
+			for (uint32_t slice = 0; slice < 8; slice++)
+			{
+				fill(memory.begin(), memory.end(), uint8_t(0));
+				const UINT64 written = UpdateSubresources(&upload.commandList, &upload.texture, &upload.intermediate, 0, 0, Upload::Mips,
+					upload.data, &scratch);
+				same = same && written == upload.requiredSize && memory == expected;
+			}
+			if (frame == 0)
+			{
+				blocks = arena.GetBlockCount();
+				CHECK(blocks == 2);
+			}
+			else
+			{
+				allocations += Allocations() - before;
+			}
+			arena.Reset();
+		}
+		CHECK(allocations == 0);
+		CHECK(same);
+		CHECK(upload.commandList.copies == 100 * 8 * Upload::Mips);
+		CHECK(arena.GetBlockCount() == blocks);
+
+		// With a ParallelFor as well, serial or on the pool.
+		fill(memory.begin(), memory.end(), uint8_t(0));
+		before = Allocations();
+		UpdateSubresources(&upload.commandList, &upload.texture, &upload.intermediate, 0, 0, Upload::Mips, upload.data, &scratch,
+			CD3DX12_SERIAL_FOR());
+		CHECK(Allocations() == before);
+		CHECK(memory == expected);
+		arena.Reset();
+
+		Threading::ThreadPool pool;
+		pool.Initialize(4);
+		fill(memory.begin(), memory.end(), uint8_t(0));
+		UpdateSubresources(&upload.commandList, &upload.texture, &upload.intermediate, 0, 0, Upload::Mips, upload.data, &scratch,
+			[&pool](UINT count, const function<void(uint32_t)>& body) { pool.ParallelFor(count, body); });
+		CHECK(memory == expected);
+		arena.Reset();
+	}
+
+	// An arena that is out of memory fails the upload before anything is mapped or recorded.
+	void TestArenaExhausted()
+	{
+		struct EmptyArena
+		{
+			void* Allocate(size_t, size_t) { return nullptr; }
+		};
+		Upload upload;
+		EmptyArena empty;
+		CD3DX12_SCRATCH_ARENA<EmptyArena> scratch(empty);
+		CHECK(UpdateSubresources(&upload.commandList, &upload.texture, &upload.intermediate, 0, 0, Upload::Mips, upload.data, &scratch) == 0);
+		CHECK(upload.commandList.copies == 0);
+	}
+
+	// Allocations are aligned and do not overlap; a repeating frame reuses the blocks of the first,
+	// and a request larger than the block size gets a block of its own.
+	void TestFrameArena()
+	{
+		FrameArena arena(256);
+		bool aligned = true;
+		size_t blocks = 0;
+		for (uint32_t frame = 0; frame < 3; frame++)
+		{
+			const uint64_t before = Allocations();
+			vector<pair<uint8_t*, size_t>> allocations;
+			allocations.reserve(64);
+			size_t used = 0;
+			for (size_t size = 1; size < 2000; size += 37)
+			{
+				const size_t alignment = size_t(1) << (size % 7);
+				uint8_t* memory = static_cast<uint8_t*>(arena.Allocate(size, alignment));
+				aligned = aligned && reinterpret_cast<uintptr_t>(memory) % alignment == 0;
+				memset(memory, int(size), size);
+				allocations.push_back(make_pair(memory, size));
+				used += size;
+			}
+			for (const pair<uint8_t*, size_t>& allocation : allocations)
+			{
+				CHECK(allocation.first[0] == uint8_t(allocation.second) && allocation.first[allocation.second - 1] == uint8_t(allocation.second));
+			}
+			CHECK(arena.GetUsedSize() == used);
+			if (frame == 0)
+			{
+				blocks = arena.GetBlockCount();
+			}
+			else
+			{
+				CHECK(Allocations() - before == 1);	//the vector of allocations
+				CHECK(arena.GetBlockCount() == blocks);
+			}
+			arena.Reset();
+			CHECK(arena.GetUsedSize() == 0);
+		}
+		CHECK(aligned);
+
+		FrameArena small(64);
+		small.Allocate(1000, 16);
+		CHECK(small.GetBlockCount() == 1 && small.GetCapacity() >= 1000);
+		small.Allocate(64, 8);
+		CHECK(small.GetBlockCount() == 2);
+	}
+}
+
+int main()
+{
+	TestArenaOverload();
+	TestArenaExhausted();
+	TestFrameArena();
+	return Testing::Finish("UpdateSubresourcesTest");
+}
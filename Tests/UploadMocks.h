@@ -0,0 +1,119 @@
+#pragma once
+
+// Just enough of a device, a resource and a command list for d3dx12.h's UpdateSubresources: the
+// device lays out RGBA8 textures the way GetCopyableFootprints does, the resources map to memory
+// they own, and the command list counts copies. Nothing is reference counted.
+namespace Query {
+	namespace Testing
+	{
+		class MockDevice : public ID3D12Device
+		{
+		public:
+			HRESULT QueryInterface(REFIID, void**) override { return E_NOINTERFACE; }
+			ULONG AddRef() override { return 1; }
+			ULONG Release() override { return 1; }
+			HRESULT CheckFeatureSupport(D3D12_FEATURE, void*, UINT) override { return E_NOTIMPL; }
+
+			// Subresource i is mip i % MipLevels of slice i / MipLevels; buffers have one row.
+			void GetCopyableFootprints(const D3D12_RESOURCE_DESC* pDesc, UINT first, UINT count, UINT64 baseOffset,
+				D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizes, UINT64* pTotalBytes) override
+			{
+				const bool buffer = pDesc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER;
+				const UINT mipLevels = pDesc->MipLevels ? pDesc->MipLevels : 1;
+				UINT64 offset = baseOffset;
+				for (UINT i = 0; i < count; i++)
+				{
+					const UINT mip = (first + i) % mipLevels;
+					const UINT width = buffer ? UINT(pDesc->Width) : UINT(pDesc->Width) >> mip ? UINT(pDesc->Width) >> mip : 1;
+					const UINT height = buffer ? 1 : pDesc->Height >> mip ? pDesc->Height >> mip : 1;
+					const UINT64 rowSize = buffer ? width : UINT64(width) * 4;
+					const UINT pitch = UINT((rowSize + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~UINT64(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1));
+					offset = (offset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~UINT64(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+					if (pLayouts)
+					{
+						pLayouts[i].Offset = offset;
+						pLayouts[i].Footprint = { buffer ? DXGI_FORMAT_UNKNOWN : DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, pitch };
+					}
+					if (pNumRows)
+					{
+						pNumRows[i] = height;
+					}
+					if (pRowSizes)
+					{
+						pRowSizes[i] = rowSize;
+					}
+					offset += UINT64(pitch) * height;
+				}
+				if (pTotalBytes)
+				{
+					*pTotalBytes = offset - baseOffset;
+				}
+			}
+		};
+
+		class MockResource : public ID3D12Resource
+		{
+		private:
+			MockDevice* m_device;
+			D3D12_RESOURCE_DESC m_desc;
+			vector<uint8_t> m_memory;
+
+		public:
+			MockResource(MockDevice* device, const D3D12_RESOURCE_DESC& desc) :
+				m_device(device), m_desc(desc), m_memory(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? size_t(desc.Width) : 0) {}
+
+			HRESULT QueryInterface(REFIID, void**) override { return E_NOINTERFACE; }
+			ULONG AddRef() override { return 1; }
+			ULONG Release() override { return 1; }
+			HRESULT GetDevice(REFIID, void** ppDevice) override { *ppDevice = m_device; return S_OK; }
+			HRESULT Map(UINT, const D3D12_RANGE*, void** ppData) override { *ppData = m_memory.data(); return S_OK; }
+			void Unmap(UINT, const D3D12_RANGE*) override {}
+			D3D12_RESOURCE_DESC GetDesc() override { return m_desc; }
+			D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() override { return 0; }
+
+			vector<uint8_t>& GetMemory() { return m_memory; }
+		};
+
+		class MockCommandList : public ID3D12GraphicsCommandList
+		{
+		public:
+			uint32_t copies = 0;
+
+			HRESULT QueryInterface(REFIID, void**) override { return E_NOINTERFACE; }
+			ULONG AddRef() override { return 1; }
+			ULONG Release() override { return 1; }
+			HRESULT GetDevice(REFIID, void**) override { return E_NOTIMPL; }
+			D3D12_COMMAND_LIST_TYPE GetType() override { return D3D12_COMMAND_LIST_TYPE_DIRECT; }
+			void CopyBufferRegion(ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT64) override { copies++; }
+			void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION*, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION*, const D3D12_BOX*) override
+			{
+				copies++;
+			}
+		};
+
+		inline D3D12_RESOURCE_DESC TextureDesc(UINT size, UINT16 mipLevels, UINT16 slices)
+		{
+			D3D12_RESOURCE_DESC desc = {};
+			desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+			desc.Width = size;
+			desc.Height = size;
+			desc.DepthOrArraySize = slices;
+			desc.MipLevels = mipLevels;
+			desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			desc.SampleDesc.Count = 1;
+			return desc;
+		}
+
+		inline D3D12_RESOURCE_DESC BufferDesc(UINT64 size)
+		{
+			D3D12_RESOURCE_DESC desc = {};
+			desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+			desc.Width = size;
+			desc.Height = 1;
+			desc.DepthOrArraySize = 1;
+			desc.MipLevels = 1;
+			desc.SampleDesc.Count = 1;
+			return desc;
+		}
+	}
+}